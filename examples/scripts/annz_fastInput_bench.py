@@ -0,0 +1,87 @@
+from scripts.helperFuncs import *
+import struct, array
+
+# command line arguments and basic settings
+# --------------------------------------------------------------------------------------------------
+init()
+
+# just in case... (may comment this out)
+if not glob.annz["doGenInputTrees"]:
+  log.info(red(" - "+time.strftime("%d/%m/%y %H:%M:%S")+" - This scripts is only designed for genInputTrees...")) ; sys.exit(0)
+
+# ==================================================================================================
+# Benchmark of the input formats -
+# --------------------------------------------------------------------------------------------------
+#   - the example training/testing catalogues are converted into larger ascii, NumPy (.npy) and
+#     ANNZ binary (.bin) files, and the input trees are generated from each of these in turn.
+#     the conversion rate (objects/sec) of each input file is also given in the log of ANNZ.
+#   - run the following:
+#     python annz_fastInput_bench.py --singleRegression --genInputTrees
+# --------------------------------------------------------------------------------------------------
+log.info(whtOnBlck(" - "+time.strftime("%d/%m/%y %H:%M:%S")+" - starting ANNZ"))
+
+# nRepeat - the number of times the input catalogues are replicated in the benchmark files
+nRepeat     = 20
+inDirName   = "examples/data/photoZ/train/"
+inFileNames = ["boss_dr10_0.csv","boss_dr10_1.csv"]
+inAsciiVars = "F:MAG_U;F:MAGERR_U;F:MAG_G;F:MAGERR_G;F:MAG_R;F:MAGERR_R;F:MAG_I;F:MAGERR_I;F:MAG_Z;F:MAGERR_Z;D:Z"
+colTypes    = [ ("f4" if varNow.startswith("F:") else "f8") for varNow in inAsciiVars.split(";") ]
+
+benchDirName = "./output/test_fastInput_bench/benchInput/"
+resetDir(benchDirName,False)
+
+# --------------------------------------------------------------------------------------------------
+# write the benchmark input files
+# --------------------------------------------------------------------------------------------------
+def writeNpy(fileName,rows):
+  # a single array of type float64 - see numpy.lib.format
+  header  = "{'descr': '<f8', 'fortran_order': False, 'shape': (%d, %d), }" % (len(rows),len(colTypes))
+  header += " " * ((64 - (10 + len(header) + 1) % 64) % 64) + "\n"
+  with open(fileName,"wb") as outFile:
+    outFile.write(b"\x93NUMPY\x01\x00" + struct.pack("<H",len(header)) + header.encode("latin1"))
+    outFile.write(array.array("d",[ valNow for rowNow in rows for valNow in rowNow ]).tobytes())
+
+def writeBin(fileName,rows):
+  # the ANNZ columnar binary format - see InputFileReader in include/CatFormat.hpp
+  with open(fileName,"wb") as outFile:
+    outFile.write(b"ANNZBIN1" + struct.pack("<IQ",len(colTypes),len(rows)) + "".join(colTypes).encode("latin1"))
+    for nColNow in range(len(colTypes)):
+      colData = array.array(("f" if colTypes[nColNow] == "f4" else "d"),[ rowNow[nColNow] for rowNow in rows ])
+      outFile.write(colData.tobytes())
+
+for inFileName in inFileNames:
+  lines = [ lineNow for lineNow in open(inDirName+inFileName) if lineNow.strip() != "" and not lineNow.startswith("#") ]
+  lines = lines * nRepeat
+  rows  = [ [ float(valNow) for valNow in lineNow.replace(","," ").split() ] for lineNow in lines ]
+
+  baseName = benchDirName+inFileName.replace(".csv","")
+  with open(baseName+".csv","w") as outFile: outFile.writelines(lines)
+  writeNpy(baseName+".npy",rows)
+  writeBin(baseName+".bin",rows)
+
+  log.info(green(" - wrote "+str(len(rows))+" objects to ")+red(baseName+".[csv,npy,bin]"))
+
+# --------------------------------------------------------------------------------------------------
+# generate the input trees for each input format, and time each one
+# --------------------------------------------------------------------------------------------------
+benchModes = [ ("ascii_lineByLine",".csv",False), ("ascii_fastInput",".csv",True),
+               ("npy",".npy",True),               ("bin",".bin",True)                ]
+benchTimes = []
+
+for (modeName,fileExt,fastInput) in benchModes:
+  glob.annz["outDirName"]     = "test_fastInput_bench_"+modeName
+  glob.annz["inDirName"]      = benchDirName
+  glob.annz["inAsciiVars"]    = inAsciiVars
+  glob.annz["splitTypeTrain"] = inFileNames[0].replace(".csv",fileExt)
+  glob.annz["splitTypeTest"]  = inFileNames[1].replace(".csv",fileExt)
+  glob.annz["fastInput"]      = fastInput
+  glob.annz["doPlots"]        = False
+
+  startTime = time.time()
+  runANNZ()
+  benchTimes.append(time.time() - startTime)
+
+for nModeNow in range(len(benchModes)):
+  log.info(blue(" - "+benchModes[nModeNow][0]+": ")+yellow("%.2f sec" % benchTimes[nModeNow]))
+
+log.info(whtOnBlck(" - "+time.strftime("%d/%m/%y %H:%M:%S")+" - finished running ANNZ !"))
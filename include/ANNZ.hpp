@@ -20,7 +20,166 @@
 #define ANNZ_h
 
 #include "BaseClass.hpp"
+#include "ThreadPool.hpp"
 class RegEval;
+class RegEvalThread;
+
+// ===========================================================================================================
+/**
+ * @brief  - Native evaluation of trained MLP (ANN) and BDT methods, parsed from the TMVA XML weight files
+ *         into flat arrays - dense weight matrices for the layers of an MLP, and node tables (struct-of-arrays)
+ *         for the trees of a BDT. The input-variable transformations (Normalize, PCA and Decorrelation)
+ *         are applied as in TMVA.
+ * 
+ * @details - Objects are evaluated in blocks of nBlockRows, where the inner loops run over the objects of a
+ *          block, so that they may be vectorised by the compiler. A NativeMLM is not modified after load(),
+ *          and may therefore be shared between threads, where each thread uses its own Buffer.
+ */
+// ===========================================================================================================
+class NativeMLM {
+// ===========================================================================================================
+  public:
+    NativeMLM();
+    ~NativeMLM();
+
+    enum  NativeType  { NON, MLP, BDT };
+    enum  TransType   { NORM, PCA, DECORR };
+    enum  ActType     { LINEAR, SIGMOID, TANH, RADIAL };
+    enum  BoostType   { AVG, GRAD, ADAR2 };
+    enum              { nBlockRows = 32 };
+
+    // scratch memory for evaluation, which may not be shared between threads
+    class Buffer {
+      public:
+        vector <Float_t>                 inptV, trnsV, pcaV;
+        vector <double>                  nodeV;
+        vector < pair<double,double> >   sortV;
+    };
+
+    bool   load(TString xmlFileName, TString & failMsg);
+    void   evaluate(int nRows, const Float_t * inptBuf, double * outV, Buffer & buf) const;
+
+    inline NativeType getType()      const { return type;                };
+    inline bool       isRegression() const { return isReg;               };
+    inline int        getNumVars()   const { return nVars;               };
+    inline double     getVarMin(int nVarNow) const { return varMinV[nVarNow]; };
+    inline double     getVarMax(int nVarNow) const { return varMaxV[nVarNow]; };
+
+  private:
+    NativeType                  type;
+    bool                        isReg, isYesNoLeaf;
+    int                         nVars;
+    vector <double>             varMinV, varMaxV;
+
+    // transformations of the input variables (applied in order), where transVarV holds the indices of the
+    // variables selected by each transformation. transParV holds the offset and scale for each variable (NORM),
+    // the means followed by the row-major eigenvector matrix (PCA), or the row-major decorrelation matrix (DECORR)
+    vector <TransType>          transTypeV;
+    vector < vector<int> >      transVarV;
+    vector < vector<Float_t> >  transNormV;
+    vector < vector<double> >   transParV;
+    // offset and scale of normalisation of the regression target, for the inverse transformation (applied in reverse order)
+    vector < pair<Float_t,Float_t> > trgNormV;
+
+    // MLP - layer sizes (not including bias neurons) and weights, stored per layer as [nOut][nIn+1] (bias last)
+    ActType                     actHidden, actOutput;
+    int                         maxLayerSize;
+    vector <int>                layerSizeV;
+    vector < vector<double> >   layerWgtV;
+
+    // BDT - node tables of all trees (leaves have nodeLeftV < 0), with the root node of each tree in treeRootV
+    BoostType                   boostType;
+    vector <int>                nodeVarV, nodeLeftV, nodeRightV, treeRootV;
+    vector <Float_t>            nodeCutV;
+    vector <char>               nodeCutTypeV;
+    vector <double>             nodeValV, treeWgtV;
+
+    bool   loadXML(TXMLEngine & xml, XMLNodePointer_t rootNode, TString & failMsg);
+    bool   loadTrans(TXMLEngine & xml, XMLNodePointer_t trfNode, vector <TString> & varLabelV,
+                     vector <TString> & trgLabelV, TString & failMsg);
+    bool   loadMLP(TXMLEngine & xml, XMLNodePointer_t wgtNode, map <TString,TString> & optM, TString & failMsg);
+    bool   loadBDT(TXMLEngine & xml, XMLNodePointer_t wgtNode, map <TString,TString> & optM, TString & failMsg);
+    int    addTreeNode(TXMLEngine & xml, XMLNodePointer_t xmlNode, bool useResponse, TString & failMsg);
+
+    void   transformBlock(int nRows, const Float_t * inptBuf, Buffer & buf) const;
+    void   evalBlockMLP(int nRows, double * outV, Buffer & buf) const;
+    void   evalBlockBDT(int nRows, double * outV, Buffer & buf) const;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - Columnar cache of the input trees which are used for training (the "_train" and "_valid" trees
+ *         from genInputTrees). Each branch of an input chain is stored once in a flat column file, which
+ *         is memory-mapped, and is reused by all later trainings with the same input files.
+ * 
+ * @details - getTree() creates an in-memory tree, which only holds the branches used by a given set of
+ *          expressions, and only the objects which pass a given cut. The tree is filled directly from the
+ *          mapped columns, so that the input files are not read again, and no cut trees are written to disk.
+ *          The cache is not used if any of the expressions depends on a branch which is not a number.
+ */
+// ===========================================================================================================
+class TrainCache : public BaseClass {
+// ===========================================================================================================
+  public:
+    TrainCache(TString aName = "TrainCache", Utils * aUtils = NULL, OptMaps * aMaps = NULL, OutMngr * anOutMngr = NULL);
+    ~TrainCache();
+
+    TTree * getTree(TChain * aChain, vector <TString> & exprV, TCut cut);
+
+  private:
+    // a column of the cache, with the leaf type (e.g., "F" for Float_t) and the mapped data
+    class Column {
+      public:
+        TString      name, type, fileName;
+        int          nBytes;
+        bool         isCached;
+        void         * mapPtr;
+        size_t       mapSize;
+        const char   * data;
+    };
+
+    bool       getColumns(TChain * aChain, vector <TString> & exprV, vector <Column> & colV);
+    FormExpr * getCutExpr(TString cutStr, vector <Column> & colV);
+    void       writeColumns(TChain * aChain, vector <Column> & colV);
+    bool       mapColumn(Column & col, Long64_t nRows);
+    void       unmapColumns(vector <Column> & colV);
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - The data and the walkers of the random walk alg which derives the PDF weights (see
+ *         ANNZ::getRndMethodBestPDF()).
+ * 
+ * @details - The integral-metric of each object for each accepted MLM is stored column-wise in intgrZmat (one
+ *          column per MLM), so that getMetric() may accumulate the weighted sum of a block of objects in a
+ *          loop which is vectorised by the compiler. A PdfOptim is not modified by getMetric(), and may therefore
+ *          be shared between threads, where each thread runs its own Walker.
+ */
+// ===========================================================================================================
+class PdfOptim {
+// ===========================================================================================================
+  public:
+    class Walker {
+      public:
+        Walker() : rnd(NULL), nLoops(0), nEvals(0), nNoUpdate(0), nSameWeights(0), nIndexNow(0), isDone(false),
+                   varIntgrBest(std::numeric_limits<double>::max()), varIntgrPrev(varIntgrBest) {};
+        ~Walker() { DELNULL(rnd); };
+
+        TRandom           * rnd;
+        int               nLoops, nEvals, nNoUpdate, nSameWeights, nIndexNow;
+        bool              isDone;
+        double            varIntgrBest, varIntgrPrev;
+        vector < double > weightsNow, weightsPrev, weightsBest;
+    };
+
+    int               nObj, nPDFbins, nOptimLoops, maxOptimTries, nSameWeightsMax, nNoUpdateMax, nRnds0;
+    double            avgIntgrZ, fracWeightUpdate;
+    vector < double > excRange, trgV, wgtV;
+    vector < int >    colMLMv, binV;
+    vector < float >  intgrZmat;
+
+    double  getMetric(vector < double > & weightsIn, TProfile * hisIntgrZ = NULL);
+};
 
 // ===========================================================================================================
 /**
@@ -55,16 +214,22 @@ class ANNZ : public BaseClass {
 
     void    evalRegErrSetup();
     void    evalRegErrCleanup();
+
+    RegEvalThread * evalRegThreadSetup(int nThreadNow, int nThreads, int nLoopTypeNow, TString outTreeName, Long64_t nEntriesLoop);
+    void            evalRegThreadLoop(RegEvalThread * thr, int nLoopTypeNow);
     
     void    evalRegWrapperSetup();
-    TString evalRegWrapperLoop();
+    TString evalRegWrapperLoop(RegEvalThread * thr, bool getStr = true);
     void    evalRegWrapperCleanup();
 
+    RegEvalThread * evalWrapperThreadSetup(int nThreadNow, Utils * utilsNow);
+    void            evalWrapperBatch(RegEvalThread * thr, int nObjs, std::function<void(int)> setObjVars, double * outVals);
+
     void    evalClsSetup();
     void    evalClsLoop();
     
     void    evalClsWrapperSetup();
-    TString evalClsWrapperLoop();
+    TString evalClsWrapperLoop(RegEvalThread * thr, bool getStr = true);
     void    evalClsWrapperCleanup();
   
     vector < pair<TString,Float_t> > readerInptV;
@@ -78,18 +243,18 @@ class ANNZ : public BaseClass {
     void     Init();
     void     setTags();
     TString  getBaseTagName(TString MLMname = DefOpts::NullC);
-    TString  getTagName(int nMLMnow = -1);
-    TString  getTagError(int nMLMnow = -1, TString errType = "");
-    TString  getTagWeight(int nMLMnow = -1);
-    TString  getTagBias(int nMLMnow = -1);
-    TString  getTagClsVal(int nMLMnow = -1);
-    TString  getTagIndex(int nMLMnow = -1);
-    TString  getTagInVarErr(int nMLMnow = -1, int nInErrNow = -1);
-    TString  getTagPdfBinName(int nPdfNow = -1, int nBinNow = -1);
-    TString  getTagPdfAvgName(int nPdfNow = -1, TString type = "");
-    TString  getTagBestMLMname(TString MLMname = "");
+    const TString & getTagName(int nMLMnow = -1);
+    const TString & getTagError(int nMLMnow = -1, const TString & errType = "");
+    const TString & getTagWeight(int nMLMnow = -1);
+    const TString & getTagBias(int nMLMnow = -1);
+    const TString & getTagClsVal(int nMLMnow = -1);
+    const TString & getTagIndex(int nMLMnow = -1);
+    const TString & getTagInVarErr(int nMLMnow = -1, int nInErrNow = -1);
+    const TString & getTagPdfBinName(int nPdfNow = -1, int nBinNow = -1);
+    const TString & getTagPdfAvgName(int nPdfNow = -1, const TString & type = "");
+    const TString & getTagBestMLMname(const TString & MLMname = "");
     int      getTagNow(TString MLMname);
-    TString  getErrKNNname(int nMLMnow = -1);
+    const TString & getErrKNNname(int nMLMnow = -1);
     int      getErrKNNtagNow(TString errKNNname);
     TString  getKeyWord(TString MLMname, TString sequence, TString key);
     TString  getRegularStrForm(TString strIn = "", VarMaps * var = NULL, TChain * aChain = NULL);
@@ -100,6 +265,7 @@ class ANNZ : public BaseClass {
     void     selectUserMLMlist(vector <TString> & optimMLMv, map <TString,bool> & mlmSkipNow);
     void     setInfoBinsZ();
     int      getBinZ(double valZ, vector <double> & binEdgesV, bool forceCheck = false);
+    int      getBinZ(double valZ, BinLookup & binLookup, bool forceCheck = false);
     void     binClsStrToV(TString clsBins);
     TString  deriveBinClsBins(map < TString,TChain* > & chainM, map < TString,TCut > & cutM);
     void     createCutTrainTrees(map < TString,TChain* > & chainM, map < TString,TCut > & cutM, OptMaps * optMap);
@@ -122,7 +288,24 @@ class ANNZ : public BaseClass {
     void              doFactoryTrain(TMVA::Factory * factory);
     void              clearReaders(Log::LOGtypes logLevel = Log::DEBUG_1);
     void              loadReaders(map <TString,bool> & mlmSkipNow, bool needMcPRB = true);
-    double            getReader(VarMaps * var = NULL, ANNZ_readType readType = ANNZ_readType::NUN, bool forceUpdate = false, int nMLMnow = -1);
+    void              cloneReaders(RegEvalThread * thr);
+    double            getReader(VarMaps * var = NULL, ANNZ_readType readType = ANNZ_readType::NUN, bool forceUpdate = false, int nMLMnow = -1,
+                                RegEvalThread * thr = NULL);
+    double            getReaderOutput(ANNZ_readType readType, int nMLMnow, RegEvalThread * thr = NULL, const double * nativeValP = NULL);
+    double            getWrapperReader(VarMaps * var, ANNZ_readType readType, bool forceUpdate, int nMLMnow, RegEvalThread * thr);
+    void              setWrapperSeed(VarMaps * var, RegEvalThread * thr);
+    void              getReaderBatch(VarMaps * var, ANNZ_readType readType, int nMLMnow, int nRows,
+                                     vector <Float_t> & inptBufV, vector <double> & outV, RegEvalThread * thr = NULL);
+    void              loadNativeMLMs(map <TString,bool> & mlmSkipNow);
+    void              clearNativeMLMs();
+    inline NativeMLM * getNativeMLM(int nMLMnow, ANNZ_readType readType) {
+      NativeMLM * nativeNow = (nMLMnow >= 0 && nMLMnow < (int)nativeMLMv.size()) ? nativeMLMv[nMLMnow] : NULL;
+      if(!nativeNow)                      return NULL;
+      if(nativeNow->isRegression())       return ((readType == ANNZ_readType::REG) ? nativeNow : NULL);
+      if(readType == ANNZ_readType::CLS)  return nativeNow;
+      if(readType == ANNZ_readType::PRB && glob->GetOptB("doBinnedCls")) return nativeNow;
+      return NULL;
+    };
     void              setupTypesTMVA();
     TMVA::Types::EMVA getTypeMLMbyName(TString typeName);
     bool              verifyXML(TString outXmlFileName = "");
@@ -131,15 +314,24 @@ class ANNZ : public BaseClass {
     // ANNZ_err.cpp :
     // -----------------------------------------------------------------------------------------------------------
     void     createTreeErrKNN(int nMLMnow);
+    void     createTreeErrKNN(vector <int> & nMLMv);
     void     setupKdTreeKNN(TChain * aChainKnn, TFile *& knnErrOutFile, TMVA::Factory *& knnErrFactory,
                             TMVA::Configurable *& knnErrDataLdr, TMVA::kNN::ModulekNN *& knnErrModule,
                             vector <int> & trgIndexV, int nMLMnow, TCut cutsAll, TString wgtAll);
     void     cleanupKdTreeKNN(TFile *& knnErrOutFile, TMVA::Factory *& knnErrFactory,
-                              TMVA::Configurable *& knnErrDataLdr, bool verb = false);
+                              TMVA::Configurable *& knnErrDataLdr, TMVA::kNN::ModulekNN *& knnErrModule, bool verb = false);
+    void     buildKdTreeKNN(TMVA::kNN::ModulekNN * knnErrModule, int nMLMnow);
+    void     benchKdTreeKNN(TMVA::kNN::ModulekNN * knnErrModule, KdTreeKNN * kdTree, int nFind, int nMLMnow);
+    ULong64_t getKnnErrIndexKey(TChain * aChainKnn, int nMLMnow, vector <TString> & trgNameV, TCut cutsAll, TString wgtAll);
+    bool     loadKnnErrIndex(TString indexFileName, ULong64_t indexKey, int nMLMnow, vector <TString> & trgNameV,
+                             TMVA::kNN::ModulekNN *& knnErrModule, vector <int> & trgIndexV);
+    void     writeKnnErrIndex(TString indexFileName, ULong64_t indexKey, int nMLMnow, vector <TString> & trgNameV,
+                              TMVA::MethodKNN * knnErrMethod);
     void     getRegClsErrKNN(VarMaps * var, TMVA::kNN::ModulekNN * knnErrModule, vector <int> & trgIndexV,
-                             vector <int> & nMLMv, bool isREG, vector < vector <double> > & zErrV);
+                             vector <int> & nMLMv, bool isREG, vector < vector <double> > & zErrV, RegEvalThread * thr = NULL);
 
-    double   getRegClsErrINP(VarMaps * var, bool isREG, int nMLMnow, UInt_t * seedP = NULL, vector <double> * zErrV = NULL);
+    double   getRegClsErrINP(VarMaps * var, bool isREG, int nMLMnow, UInt_t * seedP = NULL, vector <double> * zErrV = NULL,
+                             RegEvalThread * thr = NULL);
     
     // -----------------------------------------------------------------------------------------------------------
     // ANNZ_onlyKnnErr.cpp :
@@ -152,11 +344,18 @@ class ANNZ : public BaseClass {
     // -----------------------------------------------------------------------------------------------------------
     void     makeTreeRegClsAllMLM();
     void     makeTreeRegClsOneMLM(int nMLMnow = -1);
+    void     makeTreeRegClsFusedMLM();
+    void     makeTreeRegClsFusedLoop(RegEvalThread * thr, vector <int> & nMLMv, vector <bool> & isErrINPv,
+                                     map < TMVA::kNN::ModulekNN*,vector<int> > & getErrKNN, vector <int> & trgIndexV,
+                                     TString treeNamePostfix);
+    double   getSeparationPostTrain(TChain * aChainOut, int nMLMnow);
+    void     savePostTrainConfig(int nMLMnow, double separation = -1);
     double   getSeparation(TH1 * hisSig, TH1 * hisBck);
     void     deriveHisClsPrb(int nMLMnow = -1);
     TChain   * mergeTreeFriends(TChain * aChain = NULL, TChain * aChainFriend = NULL, vector<TString> * chainFriendFileNameV = NULL,
                                 vector <TString> * acceptV = NULL, vector <TString> * rejectV = NULL,
                                 TCut aCut = "", vector< pair<TString,TString> > * addFormV = NULL);
+    bool     mergeTreeFriendsFused(TChain * aChain = NULL, vector <TString> * acceptV = NULL, vector <TString> * rejectV = NULL);
     void     verifyIndicesMLM(TChain * aChain = NULL);
     
     // -----------------------------------------------------------------------------------------------------------
@@ -182,6 +381,7 @@ class ANNZ : public BaseClass {
                                  vector < vector<double> > & bestWeightsV, vector <TH2*> & hisPdfBiasCorV);
 
     vector < double > clipWeightsPDF(vector < double > & weightsIn, Log::LOGtypes logLevel = Log::INFO);
+    void     rndWalkPdfWeights(PdfOptim * optim, PdfOptim::Walker * walker, int nLoopsMax, bool canLog);
 
     // -----------------------------------------------------------------------------------------------------------
     // ANNZ_loopRegCls.cpp :
@@ -198,6 +398,7 @@ class ANNZ : public BaseClass {
     vector < Float_t >                    readerBiasInptV;
     vector < Double_t >                   zClos_binE, zClos_binC, zPlot_binE, zPlot_binC, zPDF_binE,
                                           zPDF_binC, zBinCls_binE, zBinCls_binC, zTrgPlot_binE, zTrgPlot_binC;
+    BinLookup                             zClos_binL, zPlot_binL, zPDF_binL, zTrgPlot_binL;
     vector < TString >                    mlmTagName, mlmTagWeight, mlmTagBias, mlmTagClsVal, mlmTagIndex,
                                           mlmTagErrKNN, inputVariableV;
 
@@ -211,10 +412,20 @@ class ANNZ : public BaseClass {
     vector < map <TString,TString> >      mlmTagErr, pdfAvgNames;
 
     vector < TMVA::Reader* >              regReaders, biasReaders;
+    vector < NativeMLM* >                 nativeMLMv;
+    NativeMLM::Buffer                     nativeBuf;
     vector < TMVA::Types::EAnalysisType > anlysTypes;
     vector < TMVA::Types::EMVA >          typeMLM, allANNZtypes;
     map    < TMVA::Types::EMVA,TString >  typeToNameMLM;
     map    < TString,TMVA::Types::EMVA >  nameToTypeMLM;
+
+    // the flat kd-trees which are searched instead of the modules for KNN error estimation (see setupKdTreeKNN())
+    map    < TMVA::kNN::ModulekNN*,KdTreeKNN* > knnErrKdTreeM;
+
+    // scratch objects for getRegClsErrINP(), reused between calls (evaluation threads hold their own copies)
+    TRandom                               * rndErrINP;
+    vector < Float_t >                    errINPinptV;
+    vector < double >                     errINPoutV, errINPvarErrV;
 };
 #endif  // #define ANNZ_h
 
@@ -260,4 +471,73 @@ class RegEval : public BaseClass {
     vector <TMVA::Configurable *>                knnErrDataLdr;
     vector <TMVA::kNN::ModulekNN *>              knnErrModule;
     map    < TMVA::kNN::ModulekNN*,vector<int> > getErrKNN;
+
+    // outputs of the wrapper interface, with a fixed order which is set upon setup (the values
+    // are held by each evaluation thread of the wrapper, see RegEvalThread::wrapperOutV)
+    vector <TString>                       wrapperOutNameV;
+    vector <int>                           wrapperMlmOutIndexV;
+    vector < vector<int> >                 wrapperPdfOutIndexV;
+
+    inline int  addWrapperOut(TString outName) {
+      wrapperOutNameV.push_back(outName); return ((int)wrapperOutNameV.size() - 1);
+    };
+    TString getWrapperOutStr(RegEvalThread * thr);
+};
+
+
+// ===========================================================================================================
+/**
+ * @brief  - containers for one thread of the evaluation loop (see ANNZ::evalRegLoop()). Each thread
+ *         processes the range of entries [entryMin,entryMax) of its own chain, using its own vars,
+ *         TMVA::Reader objects, random number generator and pdf histograms.
+ */
+// ===========================================================================================================
+class RegEvalThread : public BaseClass {
+// ===========================================================================================================
+  public:  
+    RegEvalThread(TString aName = "RegEvalThread", Utils * aUtils = NULL, OptMaps * aMaps = NULL, OutMngr * anOutMngr = NULL);
+    ~RegEvalThread();
+
+    bool      isOwner, hasReaders;
+    int       nHasNoErr, nHasZeroErr;
+    Long64_t  entryMin, entryMax;
+    UInt_t    seedINP;
+    TRandom   * rnd;
+    TChain    * loopChain;
+    VarMaps   * var_0, * var_1;
+    TTree     * treeOut;
+
+    vector <TH1*>                      hisPDF_w;
+    vector < vector<double> >          mlmAvg_val, mlmAvg_err, mlmAvg_wgt, pdfWgtValV, pdfWgtNumV, regErrV;
+    vector < pair<TString,TString> >   varTypeNameV_com, varTypeNameV_all;
+
+    vector < TMVA::Reader* >           regReaders, biasReaders;
+    vector < pair<TString,Float_t> >   readerInptV;
+    vector < Float_t >                 readerBiasInptV;
+
+    TRandom                            * rndErrINP;
+    vector < Float_t >                 errINPinptV;
+    vector < double >                  errINPoutV, errINPvarErrV;
+
+    NativeMLM::Buffer                  nativeBuf;
+
+    // outputs of the wrapper interface for the current object, ordered as RegEval::wrapperOutNameV
+    vector <double>                    wrapperOutV;
+    vector <bool>                      hasWrapperOutV;
+
+    inline void resetWrapperOut(int nOuts) {
+      wrapperOutV   .assign(nOuts,static_cast<double>(DefOpts::DefF));
+      hasWrapperOutV.assign(nOuts,false);
+    };
+    inline void setWrapperOut(int outIndex, double outVal) {
+      if(outIndex < 0) return;
+      wrapperOutV[outIndex] = outVal; hasWrapperOutV[outIndex] = true;
+    };
+
+    // outputs of the MLMs for the objects of a batch of the wrapper (see ANNZ::evalWrapperBatch()), indexed
+    // as [readType][nMLM][nObj], the input buffers of each MLM, and the index of the current object in the
+    // batch (-1 if a single object is evaluated)
+    int                                    nBatchObj;
+    vector < vector < vector<double> > >   batchMlmValV;
+    vector < vector<Float_t> >             batchInptV;
 };
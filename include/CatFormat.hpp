@@ -20,6 +20,133 @@
 #define CatFormat_h
 
 #include "BaseClass.hpp"
+#include "ThreadPool.hpp"
+
+// ===========================================================================================================
+/**
+ * @brief   - Sequential reader of input catalogues, which are memory-mapped instead of being read line by line.
+ * 
+ * @details - Three formats are supported, selected by the extension of the file name:
+ *            - ascii files (any extension other than the ones below), which are split into tokens in place, using
+ *            the same conventions as CatFormat::inputLineToVars() (columns separated by spaces, commas or tabs,
+ *            where empty lines and lines starting with "#" are skipped).
+ *            - ".npy" files, holding a one or two dimensional numerical NumPy array (in C or Fortran order),
+ *            where each row of the array corresponds to one object.
+ *            - ".bin" files, with a simple columnar format: the 8 character magic string "ANNZBIN1", followed
+ *            by the number of columns (uint32) and the number of rows (uint64), followed by a two character
+ *            type code for each column (one of: "f4","f8","i1","i2","i4","i8","u1","u2","u4","u8","b1"), followed
+ *            by the data of each column, as a contiguous little-endian array.
+ *          - A row is accessed after each call to nextRow(); for ascii inputs, the tokens of the row are given
+ *          by getToken(), and for binary inputs, the values of the columns by getValF(), getValI() and getValU().
+ *          No memory is allocated per row.
+ */
+// ===========================================================================================================
+class InputFileReader {
+// ===========================================================================================================
+  public:
+    InputFileReader();
+    ~InputFileReader();
+
+    enum FileType { NON, ASCII, NPY, BIN };
+    enum DataType { kF4, kF8, kI1, kI2, kI4, kI8, kU1, kU2, kU4, kU8, kB1 };
+
+    static FileType getFileType(const TString & fileName);
+
+    bool     open(TString fileName, TString & failMsg);
+    void     close();
+    bool     nextRow();
+
+    // restriction to a range of the input (byte offsets for ascii inputs, and row indices for binary inputs)
+    void     getRangeBounds(int nRanges, vector <Long64_t> & boundV) const;
+    void     setRange(Long64_t rangeBegin, Long64_t rangeEnd);
+    Long64_t countRows() const;
+
+    inline FileType getFileType()  const { return fileType;           };
+    inline bool     isBinary()     const { return (fileType == NPY || fileType == BIN); };
+    inline Long64_t getNrows()     const { return nRows;              };
+    inline int      getNcols()     const { return nCols;              };
+    inline DataType getDataType(int nColNow) const { return colTypeV[nColNow]; };
+    inline Long64_t getRowIndex()  const { return nRowNow;            };
+    inline Long64_t getNbytes()    const { return (Long64_t)mapSize;  };
+
+    // the current row of ascii inputs
+    inline void getToken(int nColNow, const char * & tokBegin, int & tokLen) const {
+      tokBegin = tokBeginV[nColNow]; tokLen = tokLenV[nColNow]; return;
+    };
+    TString getLine() const;
+
+    // the current row of binary inputs
+    double    getValF(int nColNow) const;
+    Long64_t  getValI(int nColNow) const;
+    ULong64_t getValU(int nColNow) const;
+
+  private:
+    FileType               fileType;
+    int                    fileDesc, nCols;
+    Long64_t               nRows, nRowNow, nRowEnd;
+    size_t                 mapSize;
+    const char             * mapBegin, * mapEnd, * readPos, * readEnd, * rowBegin, * rowEnd, * dataBegin;
+
+    // binary inputs - the type, the size in bytes and the offset of each column, and the stride between rows
+    // (for row-major storage) - for column-major storage, the stride is the size of the column type
+    bool                   isColMajor;
+    Long64_t               rowStride;
+    vector <DataType>      colTypeV;
+    vector <int>           colSizeV;
+    vector <Long64_t>      colOffsetV;
+
+    // ascii inputs - the tokens of the current row
+    vector <const char *>  tokBeginV;
+    vector <int>           tokLenV;
+
+    bool   parseHeaderNPY(TString & failMsg);
+    bool   parseHeaderBIN(TString & failMsg);
+    bool   setDataType(TString typeCode, DataType & dataType, int & dataSize);
+    const char * getValPtr(int nColNow) const;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - A range of rows of an input file (see InputFileReader::getRangeBounds()), which is converted by
+ *         CatFormat::inputToSplitTreeChunks() independently of all other chunks. The counters at the
+ *         beginning of the chunk (nLineBegin, nTrainBegin, nTestBegin) are derived before the conversion,
+ *         so that the indices of objects do not depend on the number of threads.
+ */
+// ===========================================================================================================
+class InputChunk {
+// ===========================================================================================================
+  public:
+    InputChunk() {
+      nChunk     = nInFile     = inFileType = 0;          sigBckInp = -1;
+      rangeBegin = rangeEnd    = nRows      = nRowsUse  = 0;
+      nLineBegin = nTrainBegin = nTestBegin = nTrain    = nTest = 0;
+    };
+
+    int       nChunk, nInFile, inFileType, sigBckInp;
+    Long64_t  rangeBegin, rangeEnd, nRows, nRowsUse;
+    Long64_t  nLineBegin, nTrainBegin, nTestBegin, nTrain, nTest;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - containers for one thread of CatFormat::inputToSplitTreeChunks(). Each thread fills its own
+ *         output trees, using its own vars, random number generator and output manager.
+ */
+// ===========================================================================================================
+class InputSplitThread : public BaseClass {
+// ===========================================================================================================
+  public:  
+    InputSplitThread(TString aName = "InputSplitThread", Utils * aUtils = NULL, OptMaps * aMaps = NULL, OutMngr * anOutMngr = NULL);
+    ~InputSplitThread();
+
+    Long64_t                      nObj;
+    TRandom                       * rnd;
+    VarMaps                       * var;
+    vector <TTree*>               treeOut;
+    vector <TString>              inVarNames, inVarTypes;
+    vector <VarMaps::VarHandle>   inVarHdls;
+    map <TString,int>             intMap;
+};
 
 // ===========================================================================================================
 /**
@@ -40,8 +167,19 @@ class CatFormat : public BaseClass {
     void inputToSplitTree_wgtKNN(TString inAsciiFiles, TString inAsciiVars, TString inAsciiFiles_wgtKNN, TString inAsciiVars_wgtKNN);
     void inputToFullTree_wgtKNN(TString inAsciiFiles, TString inAsciiVars, TString treeNamePostfix);
     void parseInputVars(VarMaps * var, TString inAsciiVars, vector <TString> & inVarNames, vector <TString> & inVarTypes);
-    bool inputLineToVars(TString line, VarMaps * var, vector <TString> & inVarNames, vector <TString> & inVarTypes);
+    bool inputLineToVars(TString line, VarMaps * var, vector <TString> & inVarNames, vector <TString> & inVarTypes,
+                         vector <VarMaps::VarHandle> * inVarHdls = NULL);
+    bool inputRowToVars(InputFileReader * inReader, VarMaps * var, vector <TString> & inVarNames, vector <TString> & inVarTypes,
+                        vector <VarMaps::VarHandle> & inVarHdls);
+    int  getNinputLines(TString inFileName, bool checkNonEmpty);
+    int  getNinputLines(vector <TString> & inFileNameV, bool checkNonEmpty, vector <int> * nLineV = NULL);
     void setSplitVars(VarMaps * var, TRandom * rnd, map <TString,int> & intMap);
+    int  getSplitIndex(int nLine, TRandom * rnd, map <TString,int> & intMap);
+    bool getInputSigBck(TString inFileName, vector <TString> & inpFiles_sigV, vector <TString> & inpFiles_bckV, int & sigBckInp);
+    void inputToSplitTreeChunks(vector <TString> & inFileNameV, vector <int> & inFileTypeV, vector <TString> & inpFiles_sigV,
+                                vector <TString> & inpFiles_bckV, TString inAsciiVars, vector <TString> & treeNames,
+                                map <TString,int> & intMap, int nThreads);
+    void inputChunkToSplitTree(InputSplitThread * thr, InputChunk & chunk, TString inFileName);
     void addWgtKNNtoTree(TChain * aChainInp = NULL, TChain * aChainRef = NULL, TChain * aChainEvl = NULL, TString outTreeName = "");
 };
 #endif  // #ifndef CatFormat_h
@@ -22,6 +22,7 @@
 #include "commonInclude.hpp"
 #include "OptMaps.hpp"
 #include "Utils.hpp"
+#include "ThreadPool.hpp"
 
 class TCanvas;
 class TMultiGraph;
@@ -48,6 +49,8 @@ class OutMngr {
     void     SetMyStyle();
     void     WriteOutObjects(bool writePdfScripts = false, bool dontWriteHis = false);
     void     ResetObjects();
+    void     BeginTreeLoop(bool isFinal = false, bool mayMergeFilesIn = true);
+    void     EndTreeLoop();
     void     optClear();
 
     void     SetHisStyle(TH1 * his);
@@ -75,6 +78,8 @@ class OutMngr {
     Utils      * utils;
 
     int        OutputRootFileIndex, OutputTreeFileIndex;
+    TString    treeFileTag;
+    TreeFormat treeFormat;
     TFile      * OutputRootFile;
     TDirectory * BaseDir;
 
@@ -102,6 +107,26 @@ class OutMngr {
 
   private:
     TString	 outputRootFileName, outDirName, outPlotDirName, outFileName;
+
+    // writing of trees within BeginTreeLoop()/EndTreeLoop() - the original tree of each name, the second (cloned)
+    // buffer, the buffers which have already been written (and may be filled again), the trees which are held
+    // back for the target file size, and the statistics of the written files
+    bool                          isTreeLoop, mayMergeFiles;
+    ThreadPool                    * treeWriter;
+    std::mutex                    treeBufMutex;
+    std::condition_variable       treeBufCond;
+    map < TString , TTree * >     treeOrigM, treeCloneM;
+    map < TString , bool >        treeFreeM;
+    std::set < TString >          heldTreeS;
+    Long64_t                      writeBytes, writeDiskBytes;
+    double                        writeSec;
+    vector < pair<TString,TString> > writeFileV;
+
+    bool     holdTree(TString treeName);
+    void     writeTree(TString treeName);
+    void     writeTreeAsync(TString treeName, TString fileName);
+    void     writeTreeFile(TTree * tree, TString fileName, int compress);
+    void     printWriteStats();
 };
 
 #endif
@@ -0,0 +1,149 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include "commonInclude.hpp"
+
+// ===========================================================================================================
+/**
+ * @brief  - A fixed-size pool of worker threads, executing tasks from a shared queue. Tasks are added
+ *         with push(), and wait() blocks until all of the tasks which have been pushed so far are done.
+ *         The pool does not handle any of the thread-safety of the tasks themselves - it is up to the
+ *         caller to make sure that each task only modifies its own objects. An exception which is thrown
+ *         by a task is caught by the worker, and the first one is rethrown by the next call to wait().
+ */
+// ===========================================================================================================
+class ThreadPool {
+// ===============
+  public:
+    ThreadPool(int aNumThreads = 1) {
+      nActive = 0; isDone = false;
+
+      aNumThreads = max(aNumThreads,1);
+      for(int nThreadNow=0; nThreadNow<aNumThreads; nThreadNow++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop,this));
+      }
+      return;
+    };
+    ~ThreadPool() {
+      {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        isDone = true;
+      }
+      taskCond.notify_all();
+
+      for(int nThreadNow=0; nThreadNow<(int)workers.size(); nThreadNow++) workers[nThreadNow].join();
+      workers.clear();
+      return;
+    };
+
+  private:
+    vector <std::thread>                workers;
+    std::deque < std::function<void()> > tasks;
+    std::mutex                          queueMutex;
+    std::condition_variable             taskCond, doneCond;
+    int                                 nActive;
+    bool                                isDone;
+    std::exception_ptr                  taskError;
+
+    // -----------------------------------------------------------------------------------------------------------
+    // each worker takes the next task from the queue, until the pool is destroyed
+    // -----------------------------------------------------------------------------------------------------------
+    void workerLoop() {
+      while(true) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(queueMutex);
+          taskCond.wait(lock,[this]{ return (isDone || !tasks.empty()); });
+          if(isDone && tasks.empty()) return;
+
+          task = tasks.front(); tasks.pop_front(); nActive++;
+        }
+
+        // an exception may not escape the thread (std::terminate() would be called without any message), so
+        // the first one is kept, to be rethrown by wait() in the thread of the caller
+        std::exception_ptr error;
+        try { task(); }
+        catch(...) { error = std::current_exception(); }
+
+        {
+          std::unique_lock<std::mutex> lock(queueMutex);
+          if(error && !taskError) taskError = error;
+          nActive--;
+          if(nActive == 0 && tasks.empty()) doneCond.notify_all();
+        }
+      }
+      return;
+    };
+
+  public:
+    inline int  getNumWorkers() { return (int)workers.size(); };
+
+    inline void push(std::function<void()> task) {
+      {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        tasks.push_back(task);
+      }
+      taskCond.notify_one();
+      return;
+    };
+
+    inline void wait() {
+      std::exception_ptr error;
+      {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        doneCond.wait(lock,[this]{ return (nActive == 0 && tasks.empty()); });
+        std::swap(error,taskError);
+      }
+      if(error) std::rethrow_exception(error);
+      return;
+    };
+
+    // -----------------------------------------------------------------------------------------------------------
+    // ROOT only supports concurrent access to independent trees/readers from v6.8 onwards (after
+    // ROOT::EnableThreadSafety() is called). returns false for older versions, where only a single
+    // thread may use ROOT at any given time
+    // -----------------------------------------------------------------------------------------------------------
+    static bool enableThreadSafety() {
+    #if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+      ROOT::EnableThreadSafety();
+      return true;
+    #else
+      return false;
+    #endif
+    };
+
+    // -----------------------------------------------------------------------------------------------------------
+    // translate the user option for the number of threads (nThreads) into the number of workers to
+    // use: a non-positive value means all available cores. versions of ROOT which do not support
+    // multi-threading are restricted to a single thread
+    // -----------------------------------------------------------------------------------------------------------
+    static int getNumThreads(int nThreadsIn) {
+      int nThreads = nThreadsIn;
+      if(nThreads <= 0) nThreads = static_cast<int>(std::thread::hardware_concurrency());
+      nThreads = max(nThreads,1);
+
+      if(nThreads > 1 && !enableThreadSafety()) nThreads = 1;
+
+      return nThreads;
+    };
+};
+
+#endif
@@ -29,6 +29,187 @@ namespace fitFuncs {
   extern Double_t fitFuncByHisContent(Double_t * x, Double_t * par);
 }
 
+// ===========================================================================================================
+/**
+ * @brief  - A mergeable streaming quantile sketch (t-digest style), for weighted data.
+ * 
+ * @details - Filled values are buffered, and are periodically compressed into a sorted list of centroids
+ *          (mean value and weight). Adjacent centroids are merged as long as the weight of the merged centroid
+ *          is no larger than 4*W*q*(1-q)/compression, where W is the total weight and q is the quantile of the
+ *          edge of the centroid. The error on the rank of a quantile q is therefore bounded by about
+ *          2*q*(1-q)/compression (at most 0.5/compression at the median, and smaller in the tails), and the number
+ *          of centroids grows only as compression*log(W). Before the first compression (after bufSize values, or
+ *          on a merge), the sketch is exact.
+ *          - Two sketches may be combined with Merge(), so that the data may be split between threads (or jobs),
+ *          each filling its own sketch. The result of merging sketches in a fixed order is deterministic.
+ *          - The weighted mean and RMS are computed exactly from running sums.
+ */
+// ===========================================================================================================
+class QuantSketch {
+// ================
+  public:
+    QuantSketch(double aCompression = 200, int aBufSize = -1);
+    ~QuantSketch() { Reset(); };
+
+    void    Reset();
+    void    Fill(double val, double wgt = 1);
+    void    Merge(QuantSketch & sketchIn);
+    int     GetQuantiles(int nQuant, double * quantiles, double * probQuant);
+    double  GetRankErrorBound(double probQuant = 0.5);
+    void    GetCentroids(vector < pair<double,double> > & cntrV);
+
+    inline double  GetEntries()   { return nEntries;                                                             };
+    inline double  GetSumW()      { return sumW;                                                                 };
+    inline double  GetMean()      { return (sumW > 0) ? sumWX/sumW : 0;                                          };
+    inline double  GetRMS()       { return (sumW > 0) ? sqrt(max(sumWX2/sumW - pow(GetMean(),2), 0.)) : 0;       };
+    inline double  GetNeff()      { return (sumW2 > 0) ? sumW*sumW/sumW2 : 0;                                    };
+    inline double  GetMeanError() { return (GetNeff() > 0) ? GetRMS()/sqrt(GetNeff()) : 0;                       };
+    inline double  GetRMSError()  { return (GetNeff() > 0) ? GetRMS()/sqrt(2*GetNeff()) : 0;                     };
+    inline size_t  GetNcentroids() { compress(); return cntrV.size();                                             };
+
+  private:
+    void    compress();
+
+    double  compression, nEntries, sumW, sumW2, sumWX, sumWX2;
+    int     bufSize;
+    vector < pair<double,double> > cntrV, bufV;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - A flat kd-tree for k-nearest-neighbour searches, used instead of searching the (pointer-linked)
+ *         binary tree of a TMVA::kNN::ModulekNN.
+ *
+ * @details - The points are stored in a struct-of-arrays layout (the coordinates of all points in a given dimension
+ *          are contiguous), and are reordered such that each leaf of the tree is a contiguous range of points. The
+ *          nodes of the (median-split, balanced) tree are kept in a single array, each with its bounding box. The
+ *          distances to all points of a leaf are computed together, one dimension at a time, in a loop which is
+ *          vectorized by the compiler.
+ *          - The distance is the squared Euclidean distance, accumulated in single precision over the dimensions in
+ *          order, as in TMVA::kNN::Event::GetDist(), so that the neighbours and distances are the same as those of
+ *          TMVA::kNN::ModulekNN::Find(). Ties at the distance of the last neighbour are resolved by the index of
+ *          the points (the order of the tree of the module, for Build(module)).
+ *          - Find() writes the results into buffers provided by the caller, and does not change the tree, so
+ *          that several threads may search the same tree concurrently.
+ *          - Optionally, the search may be approximate (see SetMaxChecks() and TuneMaxChecks()): the leaves are then
+ *          searched in order of their distance from the point (best-bin-first), and the search ends after the
+ *          distances to a given number of points have been computed.
+ */
+// ===========================================================================================================
+class KdTreeKNN {
+// ==============
+  public:
+    KdTreeKNN(int aLeafSize = 32);
+    ~KdTreeKNN() { Clear(); };
+
+    void    Clear();
+    void    Build(int aNdim, int aNpoints, const Float_t * points);
+    void    Build(TMVA::kNN::ModulekNN * module);
+    int     Find(const Float_t * pnt, int nFind, int * indexOut, Float_t * distOut,
+                 vector < pair<Float_t,int> > * searchQueue = NULL) const;
+    double  TuneMaxChecks(int nFind, double recallTarget, int nQuery = 1000, double * speedUp = NULL);
+
+    inline void                     SetMaxChecks(int aMaxChecks)  { maxChecks = max(aMaxChecks,0); };
+    inline int                      GetMaxChecks()          const { return maxChecks;              };
+    inline int                      GetNdim()               const { return nDim;                   };
+    inline int                      GetNpoints()            const { return nPnts;                  };
+    inline const TMVA::kNN::Event & GetEvent(int nPntNow)   const { return *(evtV[nPntNow]);       };
+
+  private:
+    int     buildNode(int nBegin, int nEnd, vector <int> & orderV, const Float_t * points);
+    int     findApprox(const Float_t * pnt, int nFind, int * indexOut, Float_t * distOut,
+                       vector < pair<Float_t,int> > & queueV) const;
+    void    searchLeaf(const Float_t * pnt, int nodeIndex, int nFind, int * indexOut, Float_t * distOut, int & nFound) const;
+    Float_t getBoxDist(const Float_t * pnt, int nodeIndex) const;
+
+    struct Node { int begin, end, left, right; };
+
+    int     nDim, nPnts, leafSize, maxChecks;
+    vector <Node>                     nodeV;
+    vector <Float_t>                  boxV, crdV;
+    vector <int>                      pntIndexV;
+    vector <const TMVA::kNN::Event *> evtV;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - Bin lookup for a fixed (ascending) set of bin edges, used instead of a linear scan of the edges or
+ *         of TH1::FindBin().
+ *
+ * @details - If the bins have equal width (up to rounding of the edges), the bin is guessed arithmetically, and
+ *          then corrected (by at most one step) by comparing with the actual edges. Otherwise, the bin is
+ *          found by a binary search without branches in the loop (the number of iterations depends only on the
+ *          number of bins). In both cases, the result is the same as that of a search over the edges.
+ *          - GetBin() follows the convention of ANNZ::getBinZ(): bin i covers (edge[i],edge[i+1]], the first bin
+ *          also includes edge[0], and -1 is returned for values outside the range.
+ *          - GetHisBin() follows the convention of TH1 (with histogram bins starting at 1): bin i+1 covers
+ *          [edge[i],edge[i+1]), 0 is the underflow and nBins+1 is the overflow bin.
+ */
+// ===========================================================================================================
+class BinLookup {
+// ==============
+  public:
+    BinLookup() { Clear(); };
+    BinLookup(const vector <double> & binEdgesV) { Set(binEdgesV); };
+    ~BinLookup() { Clear(); };
+
+    void    Clear();
+    void    Set(const vector <double> & binEdgesV);
+    int     GetBin(double val) const;
+    int     GetHisBin(double val) const;
+    void    GetBins(int nVals, const double * vals, int * binsOut, bool hisBins = false) const;
+
+    inline bool                     IsSet()             const { return (nBins > 0);  };
+    inline bool                     IsUniform()         const { return isUniform;    };
+    inline int                      GetNbins()          const { return nBins;        };
+    inline const vector <double> &  GetEdges()          const { return edgesV;       };
+
+    static int  FindBin(double val, int aNbins, const double * edges);
+
+  private:
+    int     nBins;
+    bool    isUniform;
+    double  lowEdge, highEdge, invWidth;
+    vector <double>  edgesV;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - The format of the output trees: the compression of the output files, the size of the baskets of
+ *         the branches, and the target size of the output files.
+ *
+ * @details - The compression is given as "ALGO:LEVEL", where ALGO is one of ZLIB, LZMA, LZ4 or ZSTD (e.g., "LZ4:4"
+ *          for fast compression, or "LZMA:8" for small files). An empty string keeps the default of ROOT.
+ *          - The basket of each branch (of a basic type) is sized to hold the number of entries in one output
+ *          batch (nObjectsToWrite), between the default size of ROOT and maxBasketKB. The basket sizes are not
+ *          changed if maxBasketKB is not positive.
+ *          - If fileMB is positive, OutMngr may write successive output batches of a tree to the same file, until
+ *          the (uncompressed) size of the tree reaches fileMB (see OutMngr::BeginTreeLoop()).
+ */
+// ===========================================================================================================
+class TreeFormat {
+// ===============
+  public:
+    TreeFormat() { Clear(); };
+    ~TreeFormat() { Clear(); };
+
+    void    Clear();
+    void    Set(TString compressOpt, int maxBasketKB = 0, int fileMB = 0, int nEntriesFlushIn = 0);
+    void    SetCompress(TString compressOpt);
+    void    SetBaskets(TTree * tree) const;
+
+    inline int       GetCompress()  const { return compress;  };
+    inline Long64_t  GetFileBytes() const { return fileBytes; };
+
+    static int       ParseCompress(TString compressOpt);
+    static Long64_t  GetEntryBytes(TBranch * branch);
+    static Long64_t  GetTreeBytes(TTree * tree);
+
+  private:
+    int       compress, maxBasketBytes, nEntriesFlush;
+    Long64_t  fileBytes;
+};
+
 // ===========================================================================================================
 class Utils {
 // ==========
@@ -63,6 +244,29 @@ class Utils {
     inline TString  doubleToStr(double            input, TString format = "%.10g") { return TString::Format(format,input); };
 
     inline TString  getRndStr(TString format = "%.20f") { return doubleToStr(rnd->Rndm(),format); };
+
+    // derive a seed for a given object index (e.g., a tree entry) from a global seed (splitmix64 hash), so that
+    // random numbers do not depend on the order in which objects are processed. A zero global seed keeps
+    // the (non-reproducible) convention of TRandom::SetSeed(0), and a derived seed is never zero
+    inline UInt_t   getSeedForIndex(UInt_t seed, ULong64_t index) {
+      if(seed == 0) return 0;
+      ULong64_t z = (static_cast<ULong64_t>(seed) << 32) + index + 0x9E3779B97F4A7C15ULL;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      z =  z ^ (z >> 31);
+      UInt_t seedOut = static_cast<UInt_t>(z ^ (z >> 32));
+      return ((seedOut == 0) ? 1 : seedOut);
+    };
+
+    // a 64 bit hash of a string (FNV-1a), which does not change between runs or between machines
+    inline ULong64_t getStrHash(TString input) {
+      ULong64_t hash = 0xCBF29CE484222325ULL;
+      for(int nCharNow=0; nCharNow<input.Length(); nCharNow++) {
+        hash ^= static_cast<unsigned char>(input[nCharNow]);
+        hash *= 0x100000001B3ULL;
+      }
+      return hash;
+    };
     
     inline TString  getTmpDirName() { return tmpDirName; };
 
@@ -80,12 +284,15 @@ class Utils {
     inline TString  getFilePath(TString fileName) { return (TString)fileName(0,fileName.Last('/'))+"/"; };
 
     vector<TTree*>  getTreeFriends(TTree * tree);
+    TChain *        cloneChain(TChain * chain, bool addFriends = true);
 
     void            getSetActiveTreeBranches(TTree * tree, vector < pair<TString,bool> > & branchNameStatusV,
                                              TString getSet = "", bool verbose = false);
     void            getTreeBranchNames(TTree * tree, vector <TString> & branchNameV);
+    TString         getChainFileStamp(TChain * chain);
 
     void            flushHisBufferBinsZ(TH1 * his = NULL, int nBinsZ = 0);
+    void            fillHisBin(TH1 * his, int nBin, double wgt = 1);
 
     void     his2d_to_his1dV(OptMaps * optMap, TH1 * his2, vector <TH1*> & hisV);
     void     doPolyFit(TNamed * his, map < TString , double > * fitParMap, TString theFunc);
@@ -133,11 +340,17 @@ class Utils {
     int     getQuantileV(vector <double> & fracV, vector <double> & quantV, vector <double> & dataArrV);
     int     getQuantileV(vector <double> & fracV, vector <double> & quantV, double * dataArr);
     int     getQuantileV(vector <double> & fracV, vector <double> & quantV, TH1 * dataHis); 
+    int     getQuantileV(vector <double> & fracV, vector <double> & quantV, QuantSketch * dataSketch);
+    int     getQuantileNth(vector <double> & fracV, vector <double> & quantV, vector <double> & dataV);
+    int     getQuantileWgt(vector <double> & fracV, vector <double> & quantV, vector < pair<double,double> > & dataV);
    
-    int     getInterQuantileStats(double * dataArr, TH1 * dataHis);
+    int     getInterQuantileStats(double * dataArr, TH1 * dataHis, QuantSketch * dataSketch = NULL);
     int     getInterQuantileStats(vector <double> & dataArrV);
     int     getInterQuantileStats(double * dataArr);
     int     getInterQuantileStats(TH1 * dataHis); 
+    int     getInterQuantileStats(QuantSketch * dataSketch);
+
+    double  getRndFromHis(TH1 * his, TRandom * rndIn);
 
     void    setColors();
     TString getdateDateTimeStr(time_t rawtime = 0);
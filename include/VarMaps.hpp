@@ -24,6 +24,99 @@
 #include "Utils.hpp"
 #include "CntrMap.hpp"
 
+// ===========================================================================================================
+/**
+ * @brief   - A compiled arithmetic expression (used for cuts, weights and reader inputs).
+ *
+ * @details - An expression is parsed once by Compile() into a bytecode (in reverse-polish order), where
+ *          variables are bound by BindVar() directly to the memory of their values. The supported syntax is
+ *          numerical constants, variables, parentheses, the operators [+,-,*,/], comparisons [<,<=,>,>=,==,!=],
+ *          logical operators [&&,||,!], and the functions [abs,fabs,sqrt,exp,log,log10,sin,cos,tan,pow,min,max]
+ *          (also with the TMath:: names, e.g., TMath::Abs). All operations are done in double precision, as in
+ *          TTreeFormula. Compile() returns false for any other expression (e.g., with string variables, arrays
+ *          or special TTreeFormula variables), in which case a TTreeFormula should be used instead.
+ *          - A variable may be bound to a single value (Eval() evaluates the expression for the current values),
+ *          or to an array of values with a given stride in bytes (EvalBatch() then evaluates the expression for
+ *          consecutive entries, in blocks over which each operation is vectorised).
+ *          - The type of a variable is given by the character of the corresponding leaf type of a branch
+ *          (F,D,I,S,L,i,s,l,O for Float_t, Double_t, Int_t, Short_t, Long64_t, UInt_t, UShort_t, ULong64_t, Bool_t).
+ */
+// ===========================================================================================================
+class FormExpr {
+// =============
+  public:
+    FormExpr() : maxDepth(0) {};
+    ~FormExpr() {};
+
+    bool            Compile(TString expr);
+    void            BindVar(int nVar, char type, const void * ptr, Long64_t stride = 0);
+    Double_t        Eval();
+    void            EvalBatch(Long64_t nEntries, Double_t * outV);
+
+    inline int      GetNvars()              { return (int)varNameV.size(); };
+    inline TString  GetVarName(int nVar)    { return varNameV[nVar];       };
+    inline TString  GetExpr()               { return exprIn;               };
+
+    static bool     isTypeSupported(char type);
+
+  private:
+    enum OpCode { kConst, kVar, kNeg, kNot, kAdd, kSub, kMul, kDiv, kLT, kLE, kGT, kGE, kEQ, kNE, kAnd, kOr,
+                  kAbs, kSqrt, kExp, kLog, kLog10, kSin, kCos, kTan, kPow, kMin, kMax };
+
+    // a parser for a single expression, which fills the bytecode of a FormExpr
+    class Parser {
+      public:
+        Parser(FormExpr * aFormExpr, TString aExpr) : formExpr(aFormExpr), expr(aExpr), pos(0), depth(0), isGood(true) {};
+        bool parse();
+
+      private:
+        FormExpr  * formExpr;
+        TString   expr;
+        int       pos, depth;
+        bool      isGood;
+
+        void      parseOr();
+        void      parseAnd();
+        void      parseEquality();
+        void      parseRelation();
+        void      parseSum();
+        void      parseProduct();
+        void      parseUnary();
+        void      parsePrimary();
+        bool      parseNumber();
+        bool      parseName(TString & nameOut);
+        bool      accept(const char * token);
+        void      addOp(OpCode op, int nPop, Double_t val = 0, int nVar = -1);
+    };
+
+    TString           exprIn;
+    vector <int>      opV, opVarV;
+    vector <Double_t> opValV;
+    int               maxDepth;
+
+    vector <TString>      varNameV;
+    vector <char>         varTypeV;
+    vector <const char *> varPtrV;
+    vector <Long64_t>     varStrideV;
+    vector <Double_t>     stackV, blockV, varBlockV;
+
+    inline Double_t getVal(int nVar, Long64_t nEntry) {
+      const char * ptr = varPtrV[nVar] + nEntry * varStrideV[nVar];
+      switch(varTypeV[nVar]) {
+        case 'F': return static_cast<Double_t>(*reinterpret_cast<const Float_t  *>(ptr));
+        case 'D': return                       *reinterpret_cast<const Double_t *>(ptr);
+        case 'I': return static_cast<Double_t>(*reinterpret_cast<const Int_t    *>(ptr));
+        case 'S': return static_cast<Double_t>(*reinterpret_cast<const Short_t  *>(ptr));
+        case 'L': return static_cast<Double_t>(*reinterpret_cast<const Long64_t *>(ptr));
+        case 'i': return static_cast<Double_t>(*reinterpret_cast<const UInt_t   *>(ptr));
+        case 's': return static_cast<Double_t>(*reinterpret_cast<const UShort_t *>(ptr));
+        case 'l': return static_cast<Double_t>(*reinterpret_cast<const ULong64_t*>(ptr));
+        case 'O': return static_cast<Double_t>(*reinterpret_cast<const Bool_t   *>(ptr));
+      }
+      return 0;
+    };
+};
+
 // ===========================================================================================================
 class VarMaps {
 // ============
@@ -45,7 +138,23 @@ class VarMaps {
     Map <TString,TString>     varFM;
 
     Map <TString,TString>       treeCutsM;
-    Map <TString,TTreeFormula*> treeCutsFormM, varFormM;
+
+    // a formula (or cut) is evaluated by a compiled FormExpr, or by a TTreeFormula if the
+    // expression is not supported by FormExpr (or if useCompiledForms is false)
+    class TreeForm {
+      public:
+        TreeForm() : form(NULL), expr(NULL) {};
+        TTreeFormula * form;
+        FormExpr     * expr;
+
+        inline bool     isValid() { return (dynamic_cast<TTreeFormula*>(form) || expr); }
+        inline Double_t Eval()    { return expr ? expr->Eval() : form->EvalInstance(); }
+        inline void     clear()   { DELNULL(form); DELNULL(expr); }
+    };
+    Map <TString,TreeForm> treeCutsFormM, varFormM;
+
+    // the formulae of the reader inputs, cached for each input vector of updateReaderFormulae()
+    Map < vector < pair<TString,Float_t> > *, pair < vector<TString>,vector<TreeForm*> > > readerFormM;
 
     Map <TString,bool> hasB, hasC, hasS, hasI, hasL, hasUS, hasUI, hasUL, hasF, hasD, hasFM;
 
@@ -64,6 +173,21 @@ class VarMaps {
     TString readerFormNameKey, failedCutType;
     void    setTreeForms(bool isFirstEntry);
 
+    // selection of the branches of treeRead which are actually read (see selectTreeBranches()). a connected branch
+    // which is deactivated is re-activated (and read for the current entry) once the variable is first used
+    bool                 isBranchSel;
+    Long64_t             nBytesRead;
+    Map <TString,TTree*> treeOfBranchM, inactiveBranchM;
+    Map <TString,bool>   handleVarM;
+    void                 activateBranch(TString aName);
+    void                 activateAllBranches();
+    void                 printReadStats();
+    inline void          touchBranch(TString aName) {
+      if(isBranchSel && inactiveBranchM.find(aName) != inactiveBranchM.end()) activateBranch(aName);
+      return;
+    };
+    FormExpr * compileFormExpr(TString exprIn);
+
   public: 
     // -----------------------------------------------------------------------------------------------------------
     inline TString  getName() { return name; };
@@ -110,7 +234,11 @@ class VarMaps {
     void            connectTreeBranchesForm(TTree * tree = NULL, vector < pair<TString,Float_t> > * readerInptV = NULL,
                                             vector <TString> * excludedBranchNames = NULL);
     void            resetTreeBrancheAddresses(TTree * tree = NULL);
+    void            connectTreeBranchesList(TTree * tree, vector <TString> & branchNameV);
+    void            selectTreeBranches();
     bool            getTreeEntry(int nEntry, bool getEntryIndex = false);
+    // force an update of the reader inputs, if the variables were set directly, instead of by getTreeEntry()
+    inline void     setReaderUpdate() { needReaderUpdate = true; };
 
     bool            excludeThisBranch(TString branchName = "", vector <TString> * excludedBranchNames = NULL);
     bool            treeHasBranch(TTree * tree = NULL, TString branchName = "");
@@ -160,10 +288,10 @@ class VarMaps {
 
     // get the value of a variable
     // -----------------------------------------------------------------------------------------------------------
-    inline Bool_t    GetVarB(TString aName) { return GetVarB_(aName); }
-    inline TString   GetVarC(TString aName) { return GetVarC_(aName); }
+    inline Bool_t    GetVarB(TString aName) { touchBranch(aName); return GetVarB_(aName); }
+    inline TString   GetVarC(TString aName) { touchBranch(aName); return GetVarC_(aName); }
     inline Long64_t  GetVarI(TString aName) {
-      Long64_t val (0);
+      Long64_t val (0); touchBranch(aName);
       if     (HasVarI_(aName)) val = static_cast<Long64_t> (GetVarI_(aName));
       else if(HasVarS_(aName)) val = static_cast<Long64_t> (GetVarS_(aName));
       else if(HasVarL_(aName)) val = GetVarL_(aName);
@@ -171,7 +299,7 @@ class VarMaps {
       return val;
     };
     inline ULong64_t GetVarU(TString aName) {
-      ULong64_t val(0);
+      ULong64_t val(0); touchBranch(aName);
       if     (HasVarUI_(aName)) val = static_cast<ULong64_t>(GetVarUI_(aName));
       else if(HasVarUS_(aName)) val = static_cast<ULong64_t>(GetVarUS_(aName));
       else if(HasVarUL_(aName)) val = GetVarUL_(aName);
@@ -179,7 +307,7 @@ class VarMaps {
       return val;
     };
     inline Double_t  GetVarF(TString aName) {
-      Double_t val (0);
+      Double_t val (0); touchBranch(aName);
       if     (HasVarF_ (aName)) val = static_cast<Double_t> (GetVarF_ (aName));
       else if(HasVarD_ (aName)) val = GetVarD_ (aName);
       else                      AsrtVar(false,aName+" (GetVarF)");
@@ -187,6 +315,99 @@ class VarMaps {
     };
     Double_t  GetForm(TString aName);
 
+    // handles for direct access to variables in per-object loops - a handle is resolved once by name with
+    // GetVarHandle(), and then points to the same (stable) storage which is used for tree branch addresses.
+    // handles become invalid if the variable is deleted (DelVar*(), rmVarPattern(), clearVar() etc.)
+    // -----------------------------------------------------------------------------------------------------------
+    class VarHandle {
+      public:
+        enum HandleType { kNON, kB, kC, kS, kI, kL, kUS, kUI, kUL, kF, kD, kFM };
+
+        VarHandle() : type(kNON), ptr(NULL) {};
+        inline bool       isValid() const { return (ptr != NULL); }
+        inline HandleType getType() const { return type;          }
+
+      private:
+        friend class VarMaps;
+        HandleType type;
+        void       * ptr;
+    };
+
+    VarHandle GetVarHandle(TString aName);
+    void      GetVarHandles(vector <TString> & nameV, vector <VarHandle> & handleV);
+
+    inline Double_t GetVarF(const VarHandle & hdl) {
+      if     (hdl.type == VarHandle::kF) return static_cast<Double_t>(*static_cast<Float_t*>(hdl.ptr));
+      else if(hdl.type == VarHandle::kD) return *static_cast<Double_t*>(hdl.ptr);
+      AsrtVar(false,"(GetVarF) from handle"); return 0;
+    };
+    inline void SetVarF(const VarHandle & hdl, Double_t input) {
+      if     (hdl.type == VarHandle::kF) *static_cast<Float_t *>(hdl.ptr) = input;
+      else if(hdl.type == VarHandle::kD) *static_cast<Double_t*>(hdl.ptr) = input;
+      else                               AsrtVar(false,"(SetVarF) from handle");
+      return;
+    };
+    inline Long64_t GetVarI(const VarHandle & hdl) {
+      if     (hdl.type == VarHandle::kI) return static_cast<Long64_t>(*static_cast<Int_t*>  (hdl.ptr));
+      else if(hdl.type == VarHandle::kS) return static_cast<Long64_t>(*static_cast<Short_t*>(hdl.ptr));
+      else if(hdl.type == VarHandle::kL) return *static_cast<Long64_t*>(hdl.ptr);
+      AsrtVar(false,"(GetVarI) from handle"); return 0;
+    };
+    inline void SetVarI(const VarHandle & hdl, Long64_t input) {
+      if     (hdl.type == VarHandle::kI) *static_cast<Int_t   *>(hdl.ptr) = input;
+      else if(hdl.type == VarHandle::kS) *static_cast<Short_t *>(hdl.ptr) = input;
+      else if(hdl.type == VarHandle::kL) *static_cast<Long64_t*>(hdl.ptr) = input;
+      else                               AsrtVar(false,"(SetVarI) from handle");
+      return;
+    };
+    inline ULong64_t GetVarU(const VarHandle & hdl) {
+      if     (hdl.type == VarHandle::kUI) return static_cast<ULong64_t>(*static_cast<UInt_t*>  (hdl.ptr));
+      else if(hdl.type == VarHandle::kUS) return static_cast<ULong64_t>(*static_cast<UShort_t*>(hdl.ptr));
+      else if(hdl.type == VarHandle::kUL) return *static_cast<ULong64_t*>(hdl.ptr);
+      AsrtVar(false,"(GetVarU) from handle"); return 0;
+    };
+    inline void SetVarU(const VarHandle & hdl, ULong64_t input) {
+      if     (hdl.type == VarHandle::kUI) *static_cast<UInt_t   *>(hdl.ptr) = input;
+      else if(hdl.type == VarHandle::kUS) *static_cast<UShort_t *>(hdl.ptr) = input;
+      else if(hdl.type == VarHandle::kUL) *static_cast<ULong64_t*>(hdl.ptr) = input;
+      else                                AsrtVar(false,"(SetVarU) from handle");
+      return;
+    };
+    inline Bool_t GetVarB(const VarHandle & hdl) {
+      AsrtVar((hdl.type == VarHandle::kB),"(GetVarB) from handle"); return *static_cast<Bool_t*>(hdl.ptr);
+    };
+    inline void SetVarB(const VarHandle & hdl, Bool_t input) {
+      AsrtVar((hdl.type == VarHandle::kB),"(SetVarB) from handle"); *static_cast<Bool_t*>(hdl.ptr) = input; return;
+    };
+    inline TString GetVarC(const VarHandle & hdl) {
+      AsrtVar((hdl.type == VarHandle::kC),"(GetVarC) from handle"); return (*static_cast<TObjString**>(hdl.ptr))->String();
+    };
+    inline void SetVarC(const VarHandle & hdl, TString input) {
+      AsrtVar((hdl.type == VarHandle::kC),"(SetVarC) from handle"); (*static_cast<TObjString**>(hdl.ptr))->SetString(input); return;
+    };
+    // overloaded methods with TString inputs
+    void SetVarI(const VarHandle & hdl, TString input);
+    void SetVarU(const VarHandle & hdl, TString input);
+    void SetVarF(const VarHandle & hdl, TString input);
+    // the handle of a formula points to the slot of its TreeForm, which is (re)set by setTreeForms()
+    inline Double_t GetForm(const VarHandle & hdl) {
+      TreeForm * treeForm = (hdl.type == VarHandle::kFM) ? static_cast<TreeForm*>(hdl.ptr) : NULL;
+      AsrtVar((treeForm && treeForm->isValid()),"(GetForm) from handle - has not setup varFormM");
+      return treeForm->Eval();
+    };
+    // get the value of either a numerical variable or a formula
+    inline Double_t GetVal(const VarHandle & hdl) {
+      switch(hdl.type) {
+        case VarHandle::kF:  case VarHandle::kD:                       return GetVarF(hdl);
+        case VarHandle::kI:  case VarHandle::kS:  case VarHandle::kL:  return static_cast<Double_t>(GetVarI(hdl));
+        case VarHandle::kUI: case VarHandle::kUS: case VarHandle::kUL: return static_cast<Double_t>(GetVarU(hdl));
+        case VarHandle::kB:                                            return static_cast<Double_t>(GetVarB(hdl));
+        case VarHandle::kFM:                                           return GetForm(hdl);
+        default:                                                       AsrtVar(false,"(GetVal) from handle");
+      }
+      return 0;
+    };
+
     // check if a variable is already defined
     // -----------------------------------------------------------------------------------------------------------
     inline bool HasVarB(TString aName) { return HasVarB_ (aName);                                         }
@@ -25,7 +25,14 @@ class Utils;
 class OptMaps;
 class Manager;
 class ANNZ;
+class RegEvalThread;
 
+// ===========================================================================================================
+/**
+ * @brief  - the trained MLMs of a given set of user-options, and the resources needed for their evaluation
+ *         (readers, native evaluators, kd-trees and histograms), which are loaded once, and are then shared
+ *         by all of the evaluation slots (see WrapperSlot)
+ */
 // ===========================================================================================================
 class Wrapper {
 // ============
@@ -35,8 +42,8 @@ class Wrapper {
     
     TString name;
     void    Init(int argc, char ** argv);
-    char *  Eval(char * evalId, char * nObjsVars, char ** varNames, char ** varVals);
-    void    Release(char * evalId);
+    int     GetNumOut();
+    char *  GetOutNames();
 
     Utils    * utils;
     OptMaps  * glob;
@@ -44,18 +51,80 @@ class Wrapper {
     Manager  * aManager;
     ANNZ     * aANNZ;
 
+    TString  outNames;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - an evaluation slot of a Wrapper, which holds the input and output buffers of a single evaluation
+ *         call - the input tree, the vars connected to it, and the containers of a RegEvalThread. slots only
+ *         get their own copies of TMVA::Reader objects for MLMs which can not be evaluated natively
+ */
+// ===========================================================================================================
+class WrapperSlot {
+// ================
+  public:
+    WrapperSlot(Wrapper * aWrapper, int nSlotIn);
+    ~WrapperSlot();
+
+    TString name;
+    int     nSlot;
+    void    Init();
+    char *  Eval(char * evalId, char * nObjsVars, char ** varNames, char ** varVals);
+    int     EvalBatch(int nObjs, int nVars, char ** varNames, double * varVals, double * outVals);
+    void    Release(char * evalId);
+
+    Wrapper                * model;
+    Utils                  * utils;
+    RegEvalThread          * thr;
     TTree                  * loopTree;
     map <TString,TString*> registry;
+
+  private:
+    std::mutex             registryMutex;
+};
+
+// ===========================================================================================================
+/**
+ * @brief  - a Wrapper with a set of evaluation slots, which allows concurrent evaluation calls. each call
+ *         acquires a free slot, and releases it when done
+ */
+// ===========================================================================================================
+class WrapperPool {
+// ================
+  public:
+    WrapperPool(std::string nameIn);
+    ~WrapperPool();
+
+    TString       name;
+    void          Init(int argc, char ** argv);
+    WrapperSlot * Acquire();
+    void          Release(WrapperSlot * aSlot);
+    void          Release(char * evalId);
+
+    Wrapper               * model;
+    vector <WrapperSlot*> slotV;
+
+  private:
+    vector <WrapperSlot*>   freeSlotV;
+    std::mutex              poolMutex;
+    std::condition_variable poolCond;
 };
 
 // ===========================================================================================================
 /**
- * @brief  - shared registry for Wrapper instances, which is used for bookkeeping for python calls
+ * @brief  - shared registry for Wrapper instances, which is used for bookkeeping for python calls. access to
+ *         the registry is protected by registryMutex. the setup and cleanup of instances are serialized by
+ *         initMutex. if ROOT does not support multi-threading, all evaluation calls are serialized by evalMutex
  */
 // ===========================================================================================================
 class WrapperRegistry {
   public:
-    static map <TString, Wrapper*> wrapper;
+    static map <TString, WrapperPool*> wrapper;
+    static std::mutex                  registryMutex, initMutex, evalMutex;
+    static bool                        isThreadSafe;
+
+    static WrapperPool * getPool(TString name);
 };
 
 #endif
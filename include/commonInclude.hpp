@@ -40,6 +40,13 @@
 #include <assert.h>
 #include <map>
 #include <set>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
 
 #include <TROOT.h>
 #include <TSystem.h>
@@ -47,7 +54,10 @@
 #include <TStyle.h>
 #include <TFile.h>
 #include <TChain.h>
+#include <TChainElement.h>
+#include <TFriendElement.h>
 #include <TTreeFormula.h>
+#include <TLeaf.h>
 #include <TMath.h>
 #include <TRandom3.h>
 #include <TObjString.h>
@@ -66,6 +76,7 @@
 #include <TLine.h>
 #include <TKey.h>
 #include <TXMLEngine.h>
+#include <TStopwatch.h>
 
 #include "TMVA/Tools.h"
 #include "TMVA/Config.h"
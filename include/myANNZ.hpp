@@ -37,6 +37,7 @@ class Manager {
     void    GenerateInputTrees();
     void    doOnlyKnnErr();
     void    doInTrainFlag();
+    void    trainWorkers();
 
     Utils         * utils;
     OptMaps       * glob;
@@ -20,17 +20,22 @@ import os, time
 from time import sleep
 import json
 import ctypes
+import itertools
 from ctypes import cdll
-from threading import BoundedSemaphore
+from threading import Lock
 
 # --------------------------------------------------------------------------------------------------
-# wrapper class to directly call C++ functions of ANNZ, using the Wrapper.so shared library
+# wrapper class to directly call C++ functions of ANNZ, using the Wrapper.so shared library.
+# the C++ side is thread-safe, so that evaluation calls may be made concurrently from multiple
+# threads, for the same instance or for different instances. the number of concurrent calls
+# for a given instance is set by the nThreads option (each thread holds its own copy of the MLMs)
 # --------------------------------------------------------------------------------------------------
 class ANNZ():
-  lib      = None
-  c_charP  = ctypes.POINTER(ctypes.c_char)
-  c_charPP = ctypes.POINTER(c_charP)
-  lock     = BoundedSemaphore(1)
+  lib       = None
+  c_charP   = ctypes.POINTER(ctypes.c_char)
+  c_charPP  = ctypes.POINTER(c_charP)
+  libLock   = Lock()
+  evalCount = itertools.count()
 
   # --------------------------------------------------------------------------------------------------
   # constructor
@@ -52,7 +57,7 @@ class ANNZ():
     # --------------------------------------------------------------------------------------------------
     # make sure we have the correct env to load the library
     # --------------------------------------------------------------------------------------------------
-    with ANNZ.lock:
+    with ANNZ.libLock:
       self.setEnv()
 
       if ANNZ.lib is None:
@@ -70,6 +75,13 @@ class ANNZ():
           ANNZ.lib.wrapperEval.argtypes    = [ ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, self.c_charPP, self.c_charPP ]
           ANNZ.lib.wrapperEval.restype     =   ctypes.c_char_p
           ANNZ.lib.wrapperRelease.argtypes = [ ctypes.c_char_p, ctypes.c_char_p ]
+          ANNZ.lib.wrapperEvalBatch.argtypes   = [ ctypes.c_char_p, ctypes.c_int, ctypes.c_int, self.c_charPP,
+                                                   ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double) ]
+          ANNZ.lib.wrapperEvalBatch.restype    =   ctypes.c_int
+          ANNZ.lib.wrapperGetNumOut.argtypes   = [ ctypes.c_char_p ]
+          ANNZ.lib.wrapperGetNumOut.restype    =   ctypes.c_int
+          ANNZ.lib.wrapperGetOutNames.argtypes = [ ctypes.c_char_p ]
+          ANNZ.lib.wrapperGetOutNames.restype  =   ctypes.c_char_p
 
           if self.log:
             self.log.info("\033[31m"+" - loaded: "+"\033[32m"+loadLib+"\033[0m")
@@ -115,16 +127,19 @@ class ANNZ():
     # --------------------------------------------------------------------------------------------------
     # initialize the C++ Wrapper
     # --------------------------------------------------------------------------------------------------
-    with ANNZ.lock:
-      try:
-        gotNew = ANNZ.lib.wrapperNew(self.nameC, argc, argv)
-        if not gotNew:
-          raise
-      except:
-        raise Exception(
-          " - could not initialize a new instance of ANNZ ..." \
-          +" is name = \""+self.name+"\" already used ?"
-        )
+    try:
+      gotNew = ANNZ.lib.wrapperNew(self.nameC, argc, argv)
+      if not gotNew:
+        raise
+
+      # the names of the outputs of evalBatch(), with a fixed order
+      self.nOuts    = ANNZ.lib.wrapperGetNumOut(self.nameC)
+      self.outNames = ANNZ.lib.wrapperGetOutNames(self.nameC).decode('utf-8').split(';')
+    except:
+      raise Exception(
+        " - could not initialize a new instance of ANNZ ..." \
+        +" is name = \""+self.name+"\" already used ?"
+      )
 
     return
   
@@ -132,8 +147,7 @@ class ANNZ():
   # cleanup (called upon delete, or explicitly by user)
   # --------------------------------------------------------------------------------------------------
   def cleanup(self):
-    with ANNZ.lock:
-      ANNZ.lib.wrapperDel(self.nameC)
+    ANNZ.lib.wrapperDel(self.nameC)
     return
 
   def __del__(self):
@@ -178,23 +192,68 @@ class ANNZ():
     try:
       # each call to wrapperEval registers a unique evalId. this is later used to release
       # the dynamic memory allocated to the TString output variable which is passed to python
-      # note that ROOT is not thread safe, so only call C++ once at a time...
       # --------------------------------------------------------------------------------------------------
-      with ANNZ.lock:
-        evalId   = ctypes.c_char_p(('Wrapper_'+str(int(time.time()*1e6))).encode('utf-8'))
-        evalStr  = ANNZ.lib.wrapperEval(self.nameC, evalId, nVarsC, self.varNames, varVals)
-        evalDict = json.loads(evalStr)
-        
-        # release dynamic memory allocated to the TString output variable, produced by a given
-        # call to wrapperEval (only after translating the output to a python dict with json !!!)
-        # --------------------------------------------------------------------------------------------------
-        ANNZ.lib.wrapperRelease(self.nameC, evalId)
+      evalId   = ctypes.c_char_p(('Wrapper_'+str(next(ANNZ.evalCount))).encode('utf-8'))
+      evalStr  = ANNZ.lib.wrapperEval(self.nameC, evalId, nVarsC, self.varNames, varVals)
+      evalDict = json.loads(evalStr)
+      
+      # release dynamic memory allocated to the TString output variable, produced by a given
+      # call to wrapperEval (only after translating the output to a python dict with json !!!)
+      # --------------------------------------------------------------------------------------------------
+      ANNZ.lib.wrapperRelease(self.nameC, evalId)
     
     except:
       raise Exception(" - Could not evaluate for: "+str(evalEvtIn))
 
     return evalDict[0] if isDictIn else evalDict
 
+  # --------------------------------------------------------------------------------------------------
+  # evaluate a batch of objects with numerical inputs. the input is a 2D array (list of rows, or a
+  # numpy array) with one row per object and one column per variable, in the order of self.inVars.
+  # the output has one row per object and one column per output, in the order of self.outNames.
+  # outputs which are not defined for a given object are set to the maximal float value
+  # --------------------------------------------------------------------------------------------------
+  def evalBatch(self, varValsIn):
+    isNumpy = hasattr(varValsIn, 'shape')
+    if isNumpy:
+      import numpy as np
+      varValsIn = np.ascontiguousarray(varValsIn, dtype=np.float64)
+      if varValsIn.ndim == 1:
+        varValsIn = varValsIn.reshape(1, -1)
+      nObjs = varValsIn.shape[0]
+      nVars = varValsIn.shape[1]
+    else:
+      nObjs = len(varValsIn)
+      nVars = len(varValsIn[0]) if nObjs > 0 else 0
+
+    if nObjs == 0:
+      raise Exception(" - trying to call evaluation with no input objects ...")
+    if nVars != self.nVars:
+      raise Exception(" - expected "+str(self.nVars)+" input variables ("+str(self.inVars)+"), but got "+str(nVars)+" ...")
+
+    # book the input and output arrays
+    # --------------------------------------------------------------------------------------------------
+    if isNumpy:
+      outVals  = np.empty((nObjs, self.nOuts), dtype=np.float64)
+      varValsC = varValsIn.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+      outValsC = outVals.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+    else:
+      varValsC = (ctypes.c_double * (nObjs * nVars))(*[ float(x) for row in varValsIn for x in row ])
+      outValsC = (ctypes.c_double * (nObjs * self.nOuts))()
+
+    # --------------------------------------------------------------------------------------------------
+    # perform the evaluation
+    # --------------------------------------------------------------------------------------------------
+    try:
+      ANNZ.lib.wrapperEvalBatch(self.nameC, nObjs, nVars, self.varNames, varValsC, outValsC)
+    except:
+      raise Exception(" - Could not evaluate batch of "+str(nObjs)+" objects ...")
+
+    if isNumpy:
+      return outVals
+
+    return [ list(outValsC[nObjNow * self.nOuts : (nObjNow + 1) * self.nOuts]) for nObjNow in range(nObjs) ]
+
   # --------------------------------------------------------------------------------------------------
   # initialization of the C++ ANNZ
   # --------------------------------------------------------------------------------------------------
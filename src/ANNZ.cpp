@@ -21,6 +21,8 @@
 #include "ANNZ_err.cpp"
 #include "ANNZ_onlyKnnErr.cpp"
 #include "ANNZ_TMVA.cpp"
+#include "ANNZ_native.cpp"
+#include "ANNZ_trainCache.cpp"
 #include "ANNZ_train.cpp"
 #include "ANNZ_loopRegCls.cpp"
 #include "ANNZ_loopCls.cpp"
@@ -32,6 +34,8 @@
 ANNZ::ANNZ(TString aName, Utils * aUtils, OptMaps * aMaps, OutMngr * anOutMngr)
      :BaseClass(   aName,         aUtils,           aMaps,       anOutMngr) {
 // ===========================================================================================================
+  rndErrINP = NULL;
+
   Init();
   return;
 }
@@ -50,6 +54,7 @@ ANNZ::~ANNZ() {
   typeMLM.clear();      allANNZtypes.clear();     typeToNameMLM.clear();  nameToTypeMLM.clear();
   bestMLMname.clear();  anlysTypes.clear();       readerInptV.clear();    readerBiasInptV.clear();
   mlmBaseTag.clear();   hasBiasCorMLMinp.clear(); zTrgPlot_binE.clear();  zTrgPlot_binC.clear();
+  zClos_binL.Clear();   zPlot_binL.Clear();       zPDF_binL.Clear();      zTrgPlot_binL.Clear();
 
   for(int nMLMnow=0; nMLMnow<(int)inVarsScaleFunc.size(); nMLMnow++) {
     for(int nVarNow=0; nVarNow<(int)inVarsScaleFunc[nMLMnow].size(); nVarNow++) DELNULL(inVarsScaleFunc[nMLMnow][nVarNow]);
@@ -60,6 +65,12 @@ ANNZ::~ANNZ() {
   for(int nHisNow=0; nHisNow<(int)biasReaders.size(); nHisNow++) DELNULL(biasReaders[nHisNow]);
   for(int nHisNow=0; nHisNow<(int)hisClsPrbV .size(); nHisNow++) DELNULL(hisClsPrbV [nHisNow]);
   regReaders.clear(); biasReaders.clear(); hisClsPrbV.clear();
+  clearNativeMLMs();
+
+  DELNULL(rndErrINP); errINPinptV.clear(); errINPoutV.clear(); errINPvarErrV.clear();
+
+  for(map < TMVA::kNN::ModulekNN*,KdTreeKNN* >::iterator Itr=knnErrKdTreeM.begin(); Itr!=knnErrKdTreeM.end(); ++Itr) DELNULL(Itr->second);
+  knnErrKdTreeM.clear();
 
   evalRegErrCleanup();
   DELNULL(aRegEval);
@@ -96,6 +107,7 @@ RegEval::~RegEval() {
   pdfWeightV.clear(); addMLMv      .clear(); allMLMv   .clear();
   mlmSkip.clear();    mlmSkipDivded.clear(); mlmSkipPdf.clear();
   pdfWgtValV.clear(); pdfWgtNumV   .clear(); regErrV   .clear();
+  wrapperOutNameV.clear(); wrapperMlmOutIndexV.clear(); wrapperPdfOutIndexV.clear();
 
   for(int nPDFnow=0; nPDFnow<(int)hisBiasCorV.size(); nPDFnow++) {
     for(int nPDFbinNow=0; nPDFbinNow<(int)hisBiasCorV[nPDFnow].size(); nPDFbinNow++) {
@@ -129,6 +141,78 @@ RegEval::~RegEval() {
   return;
 }
 // ===========================================================================================================
+/**
+ * @brief    - format the outputs of the wrapper interface for the last evaluated object as a json string.
+ * 
+ * @details  - only outputs which have been set for the current object are included, using
+ *           the fixed order of wrapperOutNameV.
+ *
+ * @param thr  - The evaluation thread of the wrapper, which holds the outputs.
+ */
+// ===========================================================================================================
+TString RegEval::getWrapperOutStr(RegEvalThread * thr) {
+// =====================================================
+  TString output("");
+  for(int nOutNow=0; nOutNow<(int)wrapperOutNameV.size(); nOutNow++) {
+    if(!thr->hasWrapperOutV[nOutNow]) continue;
+
+    if(output != "") output += ",";
+    output += (TString)"\""+wrapperOutNameV[nOutNow]+"\":"+utils->floatToStr(thr->wrapperOutV[nOutNow]);
+  }
+  return ((TString)"{"+output+"}");
+}
+// ===========================================================================================================
+
+
+// ===========================================================================================================
+RegEvalThread::RegEvalThread(TString aName, Utils * aUtils, OptMaps * aMaps, OutMngr * anOutMngr)
+              :BaseClass(      aName,         aUtils,           aMaps,       anOutMngr) {
+// ===========================================================================================================
+  isOwner   = hasReaders  = false;
+  nHasNoErr = nHasZeroErr = 0;
+  entryMin  = entryMax    = 0;
+  seedINP   = 0;
+  nBatchObj = -1;
+  rnd       = NULL; loopChain = NULL; var_0 = NULL; var_1 = NULL; treeOut = NULL; rndErrINP = NULL;
+
+  return;
+}
+
+// ===========================================================================================================
+RegEvalThread::~RegEvalThread() {
+// ==============================
+  aLOG(Log::DEBUG_1) <<coutBlue<<" - starting RegEvalThread::~RegEvalThread() ... "<<coutDef<<endl;
 
+  DELNULL(var_0); DELNULL(var_1); varTypeNameV_com.clear(); varTypeNameV_all.clear();
 
+  if(treeOut) { outputs->TreeMap.erase(treeOut->GetName()); DELNULL(treeOut); }
 
+  for(int nPDFnow=0; nPDFnow<(int)hisPDF_w.size(); nPDFnow++) DELNULL(hisPDF_w[nPDFnow]);
+  hisPDF_w  .clear(); mlmAvg_val.clear(); mlmAvg_err.clear(); mlmAvg_wgt.clear();
+  pdfWgtValV.clear(); pdfWgtNumV.clear(); regErrV   .clear();
+
+  if(hasReaders) {
+    for(int nMLMnow=0; nMLMnow<(int)regReaders .size(); nMLMnow++) DELNULL(regReaders [nMLMnow]);
+    for(int nMLMnow=0; nMLMnow<(int)biasReaders.size(); nMLMnow++) DELNULL(biasReaders[nMLMnow]);
+  }
+  regReaders.clear(); biasReaders.clear(); readerInptV.clear(); readerBiasInptV.clear();
+
+  DELNULL(rnd); DELNULL(rndErrINP); errINPinptV.clear(); errINPoutV.clear(); errINPvarErrV.clear();
+
+  wrapperOutV.clear(); hasWrapperOutV.clear(); batchMlmValV.clear(); batchInptV.clear();
+
+  // the chain, utils and output manager are only deleted if they are not shared with the main thread
+  if(isOwner) {
+    vector <TTree*> friendV = utils->getTreeFriends(loopChain);
+    for(int nTreeNow=0; nTreeNow<(int)friendV.size(); nTreeNow++) { loopChain->RemoveFriend(friendV[nTreeNow]); }
+    for(int nTreeNow=0; nTreeNow<(int)friendV.size(); nTreeNow++) { DELNULL(friendV[nTreeNow]);                 }
+    friendV.clear();
+
+    DELNULL(loopChain);
+    DELNULL(outputs);
+    DELNULL(utils);
+  }
+
+  return;
+}
+// ===========================================================================================================
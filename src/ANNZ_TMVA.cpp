@@ -123,6 +123,8 @@ void ANNZ::clearReaders(Log::LOGtypes logLevel) {
 
   for(int nMLMnow=0; nMLMnow<(int)hisClsPrbV.size(); nMLMnow++) DELNULL(hisClsPrbV[nMLMnow]);
 
+  clearNativeMLMs();
+
   regReaders.clear();  biasReaders.clear();      hisClsPrbV.clear();
   readerInptV.clear(); readerInptIndexV.clear(); anlysTypes.clear(); readerBiasInptV.clear();
 
@@ -301,6 +303,79 @@ void ANNZ::loadReaders(map <TString,bool> & mlmSkipNow, bool needMcPRB) {
     }
   }
 
+  // native evaluators, to be used instead of the readers where possible
+  loadNativeMLMs(mlmSkipNow);
+
+  return;
+}
+
+
+// ===========================================================================================================
+/**
+ * @brief        - Create a copy of the currently loaded TMVA::Reader objects (see loadReaders()) for a given
+ *               thread, which are connected to the input-variables of that thread.
+ *
+ * @details      - The readers are booked from the same xml files as the originals, and use the same
+ *               indexing of input-variables (readerInptIndexV). This must be called from the main thread,
+ *               after loadReaders(), since booking TMVA::Reader objects is not thread-safe. MLMs which are
+ *               only evaluated by a native evaluator (see loadNativeMLMs()) are not cloned, as the native
+ *               evaluators are shared between all threads.
+ *
+ * @param thr    - The thread for which to create the readers.
+ */
+// ===========================================================================================================
+void ANNZ::cloneReaders(RegEvalThread * thr) {
+// ===========================================================================================================
+  aLOG(Log::DEBUG) <<coutWhiteOnBlack<<coutYellow<<" - starting ANNZ::cloneReaders("<<thr->name<<") ... "<<coutDef<<endl;
+
+  int     nMLMs    = glob->GetOptI("nMLMs");
+  bool    isBinCls = glob->GetOptB("doBinnedCls");
+  TString verb     = "!Color";  if(inLOG(Log::DEBUG_2)) verb += ":!Silent"; else verb += ":Silent";
+
+  thr->readerInptV     = readerInptV;
+  thr->readerBiasInptV = readerBiasInptV;
+  thr->regReaders .resize(nMLMs,NULL);
+  thr->biasReaders.resize(nMLMs,NULL);
+  thr->hasReaders      = true;
+
+  for(int nMLMnow=0; nMLMnow<(int)regReaders.size(); nMLMnow++) {
+    for(int nReaderType=0; nReaderType<2; nReaderType++) {
+      TMVA::Reader * origReader = (nReaderType == 0) ? regReaders[nMLMnow] : biasReaders[nMLMnow];
+      if(!dynamic_cast<TMVA::Reader*>(origReader)) continue;
+
+      // the native evaluator of a regression MLM (or of binned classification) replaces all uses of the
+      // reader, while the probability of a classification MLM is still derived by the reader
+      if(nReaderType == 0) {
+        NativeMLM * nativeNow = (nMLMnow < (int)nativeMLMv.size()) ? nativeMLMv[nMLMnow] : NULL;
+        if(nativeNow && (nativeNow->isRegression() || isBinCls)) continue;
+      }
+
+      TString MLMname     = getTagName(nMLMnow);
+      TString mlmBiasName = (TString)((nReaderType == 0) ? MLMname : getTagBias(nMLMnow));
+
+      TMVA::Reader * aRegReader = new TMVA::Reader(verb);
+
+      for(int nReaderInputNow=0; nReaderInputNow<(int)readerInptIndexV[nMLMnow].size(); nReaderInputNow++) {
+        int readerInptIndex = readerInptIndexV[nMLMnow][nReaderInputNow];
+        aRegReader->AddVariable(thr->readerInptV[readerInptIndex].first,&(thr->readerInptV[readerInptIndex].second));
+      }
+
+      // the last variable of the reader (the order matters!) is for the original regression target
+      if(nReaderType == 1 && hasBiasCorMLMinp[nMLMnow]) {
+        aRegReader->AddVariable(MLMname,&(thr->readerBiasInptV[nMLMnow]));
+      }
+
+      TString outXmlFileName = getKeyWord(mlmBiasName,"trainXML","outXmlFileName");
+      cout << coutPurple; aRegReader->BookMVA(mlmBiasName,outXmlFileName); cout << coutDef;
+
+      VERIFY(LOCATION,(TString)"Could not clone Reader("+mlmBiasName+") from "+outXmlFileName+" ... Something is horribly wrong ?!?"
+                              ,(dynamic_cast<TMVA::MethodBase*>(aRegReader->FindMVA(mlmBiasName))));
+
+      if(nReaderType == 0) thr->regReaders [nMLMnow] = aRegReader;
+      else                 thr->biasReaders[nMLMnow] = aRegReader;
+    }
+  }
+
   return;
 }
 
@@ -309,29 +384,77 @@ void ANNZ::loadReaders(map <TString,bool> & mlmSkipNow, bool needMcPRB) {
 /**
  * @brief               - Get the output of the TMVA::Reader object.
  *                    
+ * @details             - If a native evaluator has been loaded for the MLM (see loadNativeMLMs()), it is used
+ *                      instead of the TMVA::Reader object.
+ *
  * @param var           - A VarMaps object which may update the values of the input-variables which are
  *                      linked to the TMVA::Reader object.
  * @param readType      - The type of MLM used (regression, or one of two classification estimators).
  * @param forceUpdate   - A flag, indicating if the content of the input-variables to the TMVA::Reader object
  *                      should be updated from the current content of var.
  * @param nMLMnow       - The index of the current MLM.
+ * @param thr           - An optional evaluation thread - if the thread has its own readers (see cloneReaders()),
+ *                      these are used instead of the readers of the main thread.
  */
 // ===========================================================================================================
-double ANNZ::getReader(VarMaps * var, ANNZ_readType readType, bool forceUpdate, int nMLMnow) {
+double ANNZ::getReader(VarMaps * var, ANNZ_readType readType, bool forceUpdate, int nMLMnow, RegEvalThread * thr) {
 // ===========================================================================================================
+  vector < pair<TString,Float_t> > & readerInptNow = (thr && thr->hasReaders) ? thr->readerInptV : readerInptV;
+
   VERIFY(LOCATION,(TString)"Memory leak ?! ",(dynamic_cast<VarMaps*>(var)));
-  VERIFY(LOCATION,(TString)"Memory leak for regReaders[nMLMnow = "+utils->intToStr(nMLMnow)+"] ?! ",(dynamic_cast<TMVA::Reader*>(regReaders[nMLMnow])));
-  VERIFY(LOCATION,(TString)"unknown readType (\""+utils->intToStr((int)readType)+"\") ...",(nMLMnow < glob->GetOptI("nMLMs")));
 
-  var->updateReaderFormulae(readerInptV,forceUpdate);
+  var->updateReaderFormulae(readerInptNow,forceUpdate);
 
-  TString MLMname  = getTagName(nMLMnow);
-  bool    isBinCls = glob->GetOptB("doBinnedCls");
-  bool    isMC     = (anlysTypes[nMLMnow] == TMVA::Types::kMulticlass);
-  double  readVal  = 0;
+  NativeMLM * nativeNow = getNativeMLM(nMLMnow,readType);
+  if(!nativeNow) return getReaderOutput(readType,nMLMnow,thr);
+
+  NativeMLM::Buffer & bufNow = thr ? thr->nativeBuf : nativeBuf;
+  int                 nInVar = (int)readerInptIndexV[nMLMnow].size();
+
+  bufNow.inptV.resize(nInVar);
+  for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) bufNow.inptV[nInVarNow] = readerInptNow[readerInptIndexV[nMLMnow][nInVarNow]].second;
+
+  double nativeVal(0);
+  nativeNow->evaluate(1,bufNow.inptV.data(),&nativeVal,bufNow);
+
+  return getReaderOutput(readType,nMLMnow,thr,&nativeVal);
+}
+
+// ===========================================================================================================
+/**
+ * @brief               - Get the output of the TMVA::Reader object for the current values of the input-variables
+ *                      which are linked to it.
+ *                    
+ * @param readType      - The type of MLM used (regression, or one of two classification estimators).
+ * @param nMLMnow       - The index of the current MLM.
+ * @param thr           - An optional evaluation thread (see getReader()).
+ * @param nativeValP    - An optional pointer to the output of the native evaluator of the MLM (see loadNativeMLMs()),
+ *                      which is then used instead of that of the TMVA::Reader object.
+ */
+// ===========================================================================================================
+double ANNZ::getReaderOutput(ANNZ_readType readType, int nMLMnow, RegEvalThread * thr, const double * nativeValP) {
+// ===========================================================================================================
+  bool thrReaders = (thr && thr->hasReaders);
+
+  vector < TMVA::Reader* >         & regReadersNow      = thrReaders ? thr->regReaders      : regReaders;
+  vector < TMVA::Reader* >         & biasReadersNow     = thrReaders ? thr->biasReaders     : biasReaders;
+  vector < Float_t >               & readerBiasInptNow  = thrReaders ? thr->readerBiasInptV : readerBiasInptV;
+
+  VERIFY(LOCATION,(TString)"MLM index (nMLMnow = "+utils->intToStr(nMLMnow)+") is out of range for the readers (of size "
+                           +utils->intToStr((int)regReadersNow.size())+") ...",(nMLMnow >= 0 && nMLMnow < (int)regReadersNow.size()));
+  VERIFY(LOCATION,(TString)"Memory leak for regReaders[nMLMnow = "+utils->intToStr(nMLMnow)+"] ?! ",
+                           (nativeValP || dynamic_cast<TMVA::Reader*>(regReadersNow[nMLMnow])));
+
+  const TString & MLMname  = getTagName(nMLMnow);
+  bool            isBinCls = glob->GetOptB("doBinnedCls");
+  bool            isMC     = (anlysTypes[nMLMnow] == TMVA::Types::kMulticlass);
+  double          readVal  = 0;
 
   if(isMC || isBinCls) {
-    double clsVal = isMC ? (regReaders[nMLMnow]->EvaluateMulticlass(MLMname))[0] : regReaders[nMLMnow]->EvaluateMVA(MLMname);
+    double clsVal(0);
+    if     (nativeValP) clsVal = *nativeValP;
+    else if(isMC)       clsVal = (regReadersNow[nMLMnow]->EvaluateMulticlass(MLMname))[0];
+    else                clsVal = regReadersNow[nMLMnow]->EvaluateMVA(MLMname);
 
     if     (readType == ANNZ_readType::PRB) {
       VERIFY(LOCATION,(TString)"Memory leak for hisClsPrbV[nMLMnow = "+utils->intToStr(nMLMnow)+"] ?! ",(dynamic_cast<TH1*>(hisClsPrbV[nMLMnow])));
@@ -342,25 +465,74 @@ double ANNZ::getReader(VarMaps * var, ANNZ_readType readType, bool forceUpdate,
   }
   else {
     if(readType == ANNZ_readType::REG) {
-      readVal = (regReaders[nMLMnow]->EvaluateRegression(MLMname))[0];
+      readVal = nativeValP ? *nativeValP : (regReadersNow[nMLMnow]->EvaluateRegression(MLMname))[0];
 
-      if(dynamic_cast<TMVA::Reader*>(biasReaders[nMLMnow])) {
+      if(dynamic_cast<TMVA::Reader*>(biasReadersNow[nMLMnow])) {
         // first update the value of the regression target in the variable which is connected to the
         // reader (this is not updated as part of the nominal loop, since this variable is not in the input tree)
-        readerBiasInptV[nMLMnow] = readVal;
+        readerBiasInptNow[nMLMnow] = readVal;
 
         // now evaluate the bias-correction MLM and update the output variable
-        readVal -= (biasReaders[nMLMnow]->EvaluateRegression(getTagBias(nMLMnow)))[0];
+        readVal -= (biasReadersNow[nMLMnow]->EvaluateRegression(getTagBias(nMLMnow)))[0];
       }
     }
-    else if(readType == ANNZ_readType::PRB) readVal = max(min(regReaders[nMLMnow]->GetProba(MLMname),1.),0.);
-    else if(readType == ANNZ_readType::CLS) readVal = regReaders[nMLMnow]->EvaluateMVA(MLMname);
+    else if(readType == ANNZ_readType::PRB) readVal = max(min(regReadersNow[nMLMnow]->GetProba(MLMname),1.),0.);
+    else if(readType == ANNZ_readType::CLS) readVal = nativeValP ? *nativeValP : regReadersNow[nMLMnow]->EvaluateMVA(MLMname);
     else VERIFY(LOCATION,(TString)"un-supported readType (\""+utils->intToStr((int)readType)+"\") ...",false);
   }
 
   return (utils->isNanInf(readVal) ? DefOpts::DefF : readVal);
 }
 
+// ===========================================================================================================
+/**
+ * @brief               - Evaluate an MLM for a batch of input-variable vectors.
+ *
+ * @details             - The input vectors are stored contiguously (row-major) in inptBufV, with the variables of
+ *                      each row ordered as inNamesVar[nMLMnow]. Each row is copied into the variables which are
+ *                      linked to the reader, which is then evaluated without updating from the formulae of var.
+ *                      The reader variables are left with the values of the last row - use getReader() with
+ *                      forceUpdate=true in order to reset them. As TMVA::Reader only evaluates a single object at
+ *                      a time, this is the common entry point for evaluation of multiple input vectors. If a native
+ *                      evaluator has been loaded for the MLM (see loadNativeMLMs()), all rows are evaluated together.
+ *
+ * @param var           - A VarMaps object which is linked to the TMVA::Reader object.
+ * @param readType      - The type of MLM used (regression, or one of two classification estimators).
+ * @param nMLMnow       - The index of the current MLM.
+ * @param nRows         - The number of input vectors in inptBufV.
+ * @param inptBufV      - The input vectors, of size (nRows * number of input variables of the MLM).
+ * @param outV          - The output of the MLM for each input vector (resized to nRows).
+ * @param thr           - An optional evaluation thread, whose readers are used (see getReader()).
+ */
+// ===========================================================================================================
+void ANNZ::getReaderBatch(VarMaps * var, ANNZ_readType readType, int nMLMnow, int nRows,
+                          vector <Float_t> & inptBufV, vector <double> & outV, RegEvalThread * thr) {
+// ===========================================================================================================
+  vector < pair<TString,Float_t> > & readerInptNow = (thr && thr->hasReaders) ? thr->readerInptV : readerInptV;
+  vector < int >                   & inptIndexV    = readerInptIndexV[nMLMnow];
+
+  int nInVar = (int)inptIndexV.size();
+  VERIFY(LOCATION,(TString)"Wrong size of input buffer for getReaderBatch() ... Something is horribly wrong ?!?"
+                 ,((int)inptBufV.size() >= nRows * nInVar));
+
+  outV.resize(nRows);
+
+  // evaluate all rows at once with the native evaluator of the MLM, if available (see loadNativeMLMs())
+  NativeMLM * nativeNow = getNativeMLM(nMLMnow,readType);
+  if(nativeNow) nativeNow->evaluate(nRows,inptBufV.data(),outV.data(),(thr ? thr->nativeBuf : nativeBuf));
+
+  for(int nRowNow=0; nRowNow<nRows; nRowNow++) {
+    const Float_t * rowNow = inptBufV.data() + nRowNow * nInVar;
+
+    for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) readerInptNow[inptIndexV[nInVarNow]].second = rowNow[nInVarNow];
+
+    if(nativeNow) outV[nRowNow] = getReaderOutput(readType,nMLMnow,thr,&(outV[nRowNow]));
+    else          outV[nRowNow] = getReader(var,readType,false,nMLMnow,thr);
+  }
+
+  return;
+}
+
 // ===========================================================================================================
 /**
  * @brief  - Setup maps which convert between TMVA::Types and simple string-tags.
@@ -227,6 +227,8 @@ void  ANNZ::evalClsLoop() {
   var_1->createTreeBranches(treeOut); 
   var_1->setDefaultVals();
 
+  outputs->BeginTreeLoop(true);
+
   // -----------------------------------------------------------------------------------------------------------
   // loop on the tree
   // -----------------------------------------------------------------------------------------------------------
@@ -240,6 +242,7 @@ void  ANNZ::evalClsLoop() {
 
     if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
       var_0->printCntr(inTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
+      var_1->setTreeWrite(outputs->TreeMap[outTreeName]);
       mayWriteObjects = false;
     }
     if(breakLoop) break;
@@ -288,6 +291,8 @@ void  ANNZ::evalClsLoop() {
   }
   if(!breakLoop) { var_0->printCntr(inTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
 
+  outputs->EndTreeLoop(); var_1->setTreeWrite(treeOut);
+
   DELNULL(var_0); DELNULL(var_1); varTypeNameV.clear();
   DELNULL(treeOut); outputs->TreeMap.erase(outTreeName);
 
@@ -363,6 +368,24 @@ void ANNZ::evalClsWrapperSetup() {
     aRegEval->varWrapper->NewForm(MLMname_w,wgtStr);
     // cout <<" ++ NewForm() ++ MLMname_w,wgtStr: "<<MLMname_w<<CT<<wgtStr<<endl;
   }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // the list of outputs, with a fixed order, which is shared by the string and the numerical (batch)
+  // interfaces of the wrapper. for each MLM: [probability, classification, weight, (error)]
+  // -----------------------------------------------------------------------------------------------------------
+  aRegEval->wrapperOutNameV.clear();
+  aRegEval->wrapperMlmOutIndexV.assign(nMLMs,-1);
+
+  for(int nMLMsInNow=0; nMLMsInNow<(int)aRegEval->mlmInV.size(); nMLMsInNow++) {
+    TString MLMname = aRegEval->mlmInV[nMLMsInNow];  if(aRegEval->mlmSkip[MLMname]) continue;
+    int     nMLMnow = getTagNow(MLMname);
+
+    aRegEval->wrapperMlmOutIndexV[nMLMnow] = aRegEval->addWrapperOut(MLMname);
+    aRegEval->addWrapperOut(getTagClsVal(nMLMnow));
+    aRegEval->addWrapperOut(getTagWeight(nMLMnow));
+    if(aRegEval->hasErrs) aRegEval->addWrapperOut(getTagError(nMLMnow));
+  }
+  aRegEval->resetWrapperOut();
   
   return;
 }
@@ -370,15 +393,19 @@ void ANNZ::evalClsWrapperSetup() {
 // ===========================================================================================================
 /**
  * @brief    - single event estimation of evaluate regression - wrapper interface.
+ * 
+ * @details  - the results are stored in thr->wrapperOutV. if getStr is set, these are
+ *           also returned, formatted as a json string (see evalRegWrapperLoop()).
+ * 
+ * @param thr     - The evaluation thread of the wrapper.
+ * @param getStr  - whether to format the output as a string.
  */
 // ===========================================================================================================
-TString ANNZ::evalClsWrapperLoop() {
+TString ANNZ::evalClsWrapperLoop(RegEvalThread * thr, bool getStr) {
 // ===========================================================================================================
   aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::evalClsWrapperLoop() ... "<<coutDef<<endl;
 
-  TString output("");
-
-  VarMaps * var   = aRegEval->varWrapper;
+  VarMaps * var   = thr->var_0;
   int     nMLMs   = glob->GetOptI("nMLMs");
   UInt_t  seed    = glob->GetOptI("initSeedRnd"); if(seed > 0) seed += 14320;
   int     nMLMsIn = (int)aRegEval->mlmInV.size();
@@ -386,11 +413,15 @@ TString ANNZ::evalClsWrapperLoop() {
   // -----------------------------------------------------------------------------------------------------------
   // calculation of errors (if needed)
   // -----------------------------------------------------------------------------------------------------------
-  aRegEval->regErrV.resize(nMLMs,vector<double>(3,0));
+  thr->regErrV.resize(nMLMs,vector<double>(3,0));
+  thr->resetWrapperOut((int)aRegEval->wrapperOutNameV.size());
+
+  // reseed the random number generators, based on the inputs of the current object
+  setWrapperSeed(var,thr);
 
   if(aRegEval->hasErrKNN) {
     for(map < TMVA::kNN::ModulekNN*,vector<int> >::iterator Itr=aRegEval->getErrKNN.begin(); Itr!=aRegEval->getErrKNN.end(); ++Itr) {
-      getRegClsErrKNN(var,Itr->first,aRegEval->trgIndexV,Itr->second,false,aRegEval->regErrV);
+      getRegClsErrKNN(var,Itr->first,aRegEval->trgIndexV,Itr->second,false,thr->regErrV,thr);
     }
   }
   if(aRegEval->hasErrs) {
@@ -398,7 +429,7 @@ TString ANNZ::evalClsWrapperLoop() {
       TString MLMname = getTagName(nMLMnow);
       if(!aRegEval->isErrINPv[nMLMnow] || aRegEval->mlmSkip[MLMname]) continue;
 
-      getRegClsErrINP(var,true,nMLMnow,&(aRegEval->seed),&(aRegEval->regErrV[nMLMnow]));
+      getRegClsErrINP(var,true,nMLMnow,&(thr->seedINP),&(thr->regErrV[nMLMnow]),thr);
     }
   }
 
@@ -407,13 +438,12 @@ TString ANNZ::evalClsWrapperLoop() {
   // -----------------------------------------------------------------------------------------------------------
   for(int nMLMsInNow=0; nMLMsInNow<nMLMsIn; nMLMsInNow++) {
     TString MLMname   = aRegEval->mlmInV[nMLMsInNow];  if(aRegEval->mlmSkip[MLMname]) continue;
-    int     nMLMnow   = getTagNow(MLMname);    TString MLMname_e = getTagError(nMLMnow);
-    TString MLMname_w = getTagWeight(nMLMnow); TString MLMname_v = getTagClsVal(nMLMnow);
+    int     nMLMnow   = getTagNow(MLMname);    TString MLMname_w = getTagWeight(nMLMnow);
 
-    double  clsPrb = getReader(var,ANNZ_readType::PRB,false,nMLMnow);
-    double  clsVal = getReader(var,ANNZ_readType::CLS,true,nMLMnow);
+    double  clsPrb = getWrapperReader(var,ANNZ_readType::PRB,false,nMLMnow,thr);
+    double  clsVal = getWrapperReader(var,ANNZ_readType::CLS,true,nMLMnow,thr);
     double  clsWgt = var->GetForm(MLMname_w);
-    double  clsErr = aRegEval->regErrV[nMLMnow][1]; 
+    double  clsErr = thr->regErrV[nMLMnow][1]; 
 
     // sanity check that weights are properly defined
     if(clsWgt < 0) {
@@ -421,19 +451,21 @@ TString ANNZ::evalClsWrapperLoop() {
       VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false);
     }
 
-    output += (TString)"\""+MLMname   +"\":"+utils->floatToStr(clsPrb) +",";
-    output += (TString)"\""+MLMname_v +"\":"+utils->floatToStr(clsVal) +",";
-    output += (TString)"\""+MLMname_w +"\":"+utils->floatToStr(clsWgt) +",";
+    int outIndex = aRegEval->wrapperMlmOutIndexV[nMLMnow];
+
+    thr->setWrapperOut(outIndex  ,clsPrb);
+    thr->setWrapperOut(outIndex+1,clsVal);
+    thr->setWrapperOut(outIndex+2,clsWgt);
     
     if(aRegEval->hasErrs) {
-      output += (TString)"\""+MLMname_e +"\":"+utils->floatToStr(clsErr) +",";
+      thr->setWrapperOut(outIndex+3,clsErr);
     }
     // cout <<" x1x "<<clsPrb<<CT<<clsVal<<CT<<clsWgt<<endl;
   }
 
-  output = (TString)"{"+output+"}";
+  if(!getStr) return "";
 
-  return output;
+  return aRegEval->getWrapperOutStr(thr);
 }
 
 // ===========================================================================================================
@@ -16,6 +16,12 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // ===========================================================================================================
 
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
 // ===========================================================================================================
 /**
  * @brief          - Create trees from the _train dataset which contain the input for
@@ -26,16 +32,35 @@
 // ===========================================================================================================
 void ANNZ::createTreeErrKNN(int nMLMnow) {
 // ===========================================================================================================
+  vector <int> nMLMv(1,nMLMnow);
+  createTreeErrKNN(nMLMv);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Create a combined tree from the _train dataset which contains the input for
+ *                 the KNN error estimator of several MLMs, using a single loop over the dataset.
+ *              
+ * @param nMLMv    - The indices of the MLMs (the first one is used to define the signal/background cuts
+ *                 for classification).
+ */
+// ===========================================================================================================
+void ANNZ::createTreeErrKNN(vector <int> & nMLMv) {
+// ===========================================================================================================
+  int nMLMsIn = (int)nMLMv.size();
+  VERIFY(LOCATION,(TString)"Trying to use createTreeErrKNN() with no MLMs ... Something is horribly wrong !!!",(nMLMsIn > 0));
+
   aLOG(Log::DEBUG) <<coutWhiteOnBlack<<coutGreen<<" - starting ANNZ::createTreeErrKNN() - "
-                   <<"will create errKNN trees for "<<coutPurple<<getTagName(nMLMnow)<<coutGreen<<" ... "<<coutDef<<endl;
+                   <<"will create errKNN trees for "<<coutPurple<<getTagName(nMLMv[0])<<coutGreen
+                   <<((nMLMsIn > 1) ? (TString)" (+"+utils->intToStr(nMLMsIn-1)+" MLMs)" : (TString)"")<<" ... "<<coutDef<<endl;
 
   TString zTrgName       = glob->GetOptC("zTrg");
   TString indexName      = glob->GetOptC("indexName");
   TString sigBckTypeName = glob->GetOptC("sigBckTypeName");
   bool    isCls          = glob->GetOptB("doClassification") || glob->GetOptB("doBinnedCls");
-  TString MLMname        = getTagName(nMLMnow);
-  TString errKNNname     = getErrKNNname(nMLMnow);
-  TString MLMname_i      = getTagIndex(nMLMnow);
+  TString MLMname        = getTagName(nMLMv[0]);
  
   VarMaps * var_0 = new VarMaps(glob,utils,"treeErrKNN_0");
   VarMaps * var_1 = new VarMaps(glob,utils,"treeErrKNN_1");
@@ -63,7 +88,12 @@ void ANNZ::createTreeErrKNN(int nMLMnow) {
     var_0->setTreeCuts("_bck",bckCuts);
   }
 
-  var_1->NewVarF(MLMname); var_1->NewVarF(errKNNname); var_1->NewVarI(MLMname_i);
+  // the value, the error and the index of each MLM, and the (common) target or signal/background type
+  vector < vector<VarMaps::VarHandle> > hdl_1(nMLMsIn,vector<VarMaps::VarHandle>(3));
+  for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
+    int nMLMnow = nMLMv[nMLMinNow];
+    var_1->NewVarF(getTagName(nMLMnow)); var_1->NewVarF(getErrKNNname(nMLMnow)); var_1->NewVarI(getTagIndex(nMLMnow));
+  }
   if(isCls) var_1->NewVarI(sigBckTypeName); else var_1->NewVarF(zTrgName);
   
   TString outTreeName = getKeyWord("","treeErrKNN","treeErrKNNname");
@@ -72,8 +102,15 @@ void ANNZ::createTreeErrKNN(int nMLMnow) {
 
   var_1->createTreeBranches(outTree); 
   var_1->setDefaultVals();
+
+  for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
+    int nMLMnow = nMLMv[nMLMinNow];
+    hdl_1[nMLMinNow][0] = var_1->GetVarHandle(getTagName(nMLMnow));
+    hdl_1[nMLMinNow][1] = var_1->GetVarHandle(getErrKNNname(nMLMnow));
+    hdl_1[nMLMinNow][2] = var_1->GetVarHandle(getTagIndex(nMLMnow));
+  }
   
-  vector <bool> errFakeShift(2,true);
+  vector < vector<bool> > errFakeShift(nMLMsIn,vector<bool>(2,true));
 
   // -----------------------------------------------------------------------------------------------------------
   // 
@@ -90,45 +127,53 @@ void ANNZ::createTreeErrKNN(int nMLMnow) {
     }
     if(breakLoop) break;
 
-    var_1->SetVarI(MLMname_i,var_0->GetVarI(indexName));
-
-    // compute the KNN error for this object
+    // expect for background that clsPrb=0, and for signal that clsPrb=1
+    int sigBckType(-1);
     if(isCls) {
-      double clsPrb = getReader(var_0,ANNZ_readType::PRB,true,nMLMnow);
-
-      // expect for background that clsPrb=0, and for signal that clsPrb=1
-      int    sigBckType(-1);
-      double errKNN(-1);
-      if     (!var_0->hasFailedTreeCuts("_bck")) { sigBckType = 0; errKNN =   clsPrb; }
-      else if(!var_0->hasFailedTreeCuts("_sig")) { sigBckType = 1; errKNN = 1-clsPrb; }
-
-      // TMVA forces a check that a target variable is not constant. In order to avoid this,
-      // change the value of one signal and one background object by some insignificant amount
-      if(errFakeShift[sigBckType]) {
-        errFakeShift[sigBckType] = false;
-        errKNN += (sigBckType == 0 ? 1 : -1) * 0.000001;
-      }
+      if     (!var_0->hasFailedTreeCuts("_bck")) sigBckType = 0;
+      else if(!var_0->hasFailedTreeCuts("_sig")) sigBckType = 1;
 
-      var_1->SetVarF(MLMname,        clsPrb);
-      var_1->SetVarF(errKNNname,     errKNN);
-      var_1->SetVarI(sigBckTypeName, sigBckType);
+      var_1->SetVarI(sigBckTypeName,sigBckType);
     }
-    else {
-      double zTrg   = var_0->GetVarF(zTrgName);
-      double regVal = getReader(var_0,ANNZ_readType::REG,true,nMLMnow);
-      
-      // the error of each object wrt its own true value
-      // see: http://arxiv.org/abs/0810.2991 - Estimating the Redshift Distribution of Photometric Galaxy... - Sect. 4.2
-      double errKNN = regVal - zTrg;
-
-      if(errFakeShift[0]) {
-        errFakeShift[0]  = false;
-        errKNN      *= 1.000001;
+    else var_1->SetVarF(zTrgName,var_0->GetVarF(zTrgName));
+
+    // compute the KNN error for this object for each MLM (the reader variables are only updated once per object)
+    for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
+      int  nMLMnow     = nMLMv[nMLMinNow];
+      bool forceUpdate = (nMLMinNow == 0);
+
+      var_1->SetVarI(hdl_1[nMLMinNow][2],var_0->GetVarI(indexName));
+
+      if(isCls) {
+        double clsPrb = getReader(var_0,ANNZ_readType::PRB,forceUpdate,nMLMnow);
+        double errKNN = (sigBckType == 0) ? clsPrb : ((sigBckType == 1) ? 1-clsPrb : -1);
+
+        // TMVA forces a check that a target variable is not constant. In order to avoid this,
+        // change the value of one signal and one background object by some insignificant amount
+        if(sigBckType >= 0 && errFakeShift[nMLMinNow][sigBckType]) {
+          errFakeShift[nMLMinNow][sigBckType] = false;
+          errKNN += (sigBckType == 0 ? 1 : -1) * 0.000001;
+        }
+
+        var_1->SetVarF(hdl_1[nMLMinNow][0],clsPrb);
+        var_1->SetVarF(hdl_1[nMLMinNow][1],errKNN);
+      }
+      else {
+        double zTrg   = var_0->GetVarF(zTrgName);
+        double regVal = getReader(var_0,ANNZ_readType::REG,forceUpdate,nMLMnow);
+        
+        // the error of each object wrt its own true value
+        // see: http://arxiv.org/abs/0810.2991 - Estimating the Redshift Distribution of Photometric Galaxy... - Sect. 4.2
+        double errKNN = regVal - zTrg;
+
+        if(errFakeShift[nMLMinNow][0]) {
+          errFakeShift[nMLMinNow][0] = false;
+          errKNN *= 1.000001;
+        }
+        
+        var_1->SetVarF(hdl_1[nMLMinNow][0],regVal);
+        var_1->SetVarF(hdl_1[nMLMinNow][1],errKNN);
       }
-      
-      var_1->SetVarF(MLMname,   regVal);
-      var_1->SetVarF(errKNNname,errKNN);
-      var_1->SetVarF(zTrgName,  zTrg);
     }
 
     var_1->fillTree();
@@ -140,7 +185,7 @@ void ANNZ::createTreeErrKNN(int nMLMnow) {
   DELNULL(var_0);  DELNULL(var_1);
   DELNULL(aChain); DELNULL(outTree); outputs->TreeMap.erase(outTreeName);
   
-  errFakeShift.clear();
+  errFakeShift.clear(); hdl_1.clear();
 
   aLOG(Log::DEBUG) <<coutGreen<<" - finished ANNZ::createTreeErrKNN()"<<coutDef<<endl;
 
@@ -158,8 +203,9 @@ void ANNZ::createTreeErrKNN(int nMLMnow) {
  * @param knnErrOutFile  - A TFile which is created as part of the setup of the TMVA::Factory (needs to be deleted suring cleanup).
  * @param knnErrFactory  - A pointer to the TMVA::Factory which is created here.
  * @param knnErrDataLdr  - A pointer to the TMVA::DataLoader, needed for ROOT versions > 6.8.
- * @param knnErrModule   - A pointer to the TMVA::kNN::ModulekNN which is created by the TMVA::Factory, and is later
- *                       used to get the near-neighbours in getRegClsErrKNN().
+ * @param knnErrModule   - A pointer to the TMVA::kNN::ModulekNN which is created by the TMVA::Factory. A flat
+ *                       kd-tree is built from its events (see buildKdTreeKNN()), and is later used to get the
+ *                       near-neighbours in getRegClsErrKNN().
  * @param trgIndexV      - container to keep track of how MLM indices are arranged in the KNN target list
  * @param nMLMnow        - The index of the primary MLM.
  * @param cutsAll        - Cuts used on the dataset, which should match the cuts on the primary MLM.
@@ -185,6 +231,7 @@ void ANNZ::setupKdTreeKNN(
   TString indexName       = glob->GetOptC("indexName");
   int     minObjTrainTest = glob->GetOptI("minObjTrainTest");
   double  sampleFrac      = glob->GetOptF("sampleFrac_errKNN");
+  TString knnErrIndexDir  = glob->GetOptC("knnErrIndexDir");
 
   TString verbLvlF        = (TString)(debug ? ":V:!Silent" : ":!V:Silent");
   TString verbLvlM        = (TString)(debug ? ":V:H"       : ":!V:!H");
@@ -198,6 +245,34 @@ void ANNZ::setupKdTreeKNN(
 
   // bool  isReg = (glob->GetOptB("doRegression") && !glob->GetOptB("doBinnedCls"));
   // if(!isReg) { analysType = (TString)":AnalysisType=Classification"; trainValidStr = ""; }
+
+  // the targets for all available MLMs
+  vector <TString> trgNameV, branchNameV;
+  utils->getTreeBranchNames(aChainKnn,branchNameV);
+  for(int nBranchNameNow=0; nBranchNameNow<(int)branchNameV.size(); nBranchNameNow++) {
+    if(branchNameV[nBranchNameNow].Contains(baseTag_errKNN)) trgNameV.push_back(branchNameV[nBranchNameNow]);
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // if an index directory is set, load the kd-tree from an index file which was stored by a previous job
+  // with the same inputs (see getKnnErrIndexKey()), and skip the setup of the factory
+  // -----------------------------------------------------------------------------------------------------------
+  TString   indexFileName("");
+  ULong64_t indexKey(0);
+
+  if(knnErrIndexDir != "") {
+    if(!knnErrIndexDir.EndsWith("/")) knnErrIndexDir += "/";
+
+    indexKey      = getKnnErrIndexKey(aChainKnn,nMLMnow,trgNameV,cutsAll,wgtAll);
+    indexFileName = (TString)knnErrIndexDir+"knnErrIndex_"+TString::Format("%016llx",indexKey)+".bin";
+
+    if(loadKnnErrIndex(indexFileName,indexKey,nMLMnow,trgNameV,knnErrModule,trgIndexV)) {
+      knnErrOutFile = NULL; knnErrFactory = NULL; knnErrDataLdr = NULL;
+
+      buildKdTreeKNN(knnErrModule,nMLMnow);
+      return;
+    }
+  }
   
   (TMVA::gConfig().GetIONames()).fWeightFileDir = getKeyWord(MLMname,"knnErrXML","outFileDirKnnErr");
 
@@ -290,18 +365,11 @@ void ANNZ::setupKdTreeKNN(
   // add targets for all available MLMs
   trgIndexV.resize(nMLMs,-1);
 
-  int              nTrgIn(0);
-  vector <TString> branchNameV;
-  utils->getTreeBranchNames(aChainKnn,branchNameV);
-  for(int nBranchNameNow=0; nBranchNameNow<(int)branchNameV.size(); nBranchNameNow++) {
-    TString branchName = branchNameV[nBranchNameNow];  if(!branchName.Contains(baseTag_errKNN)) continue;
-
-    ((def_dataLoader*)knnErrDataLdr)->AddTarget(branchName,branchName);
-    
-    int indexErrKNN = getErrKNNtagNow(branchName);
-    trgIndexV[indexErrKNN] = nTrgIn;
+  for(int nTrgNow=0; nTrgNow<(int)trgNameV.size(); nTrgNow++) {
+    ((def_dataLoader*)knnErrDataLdr)->AddTarget(trgNameV[nTrgNow],trgNameV[nTrgNow]);
     
-    nTrgIn++;
+    int indexErrKNN = getErrKNNtagNow(trgNameV[nTrgNow]);
+    trgIndexV[indexErrKNN] = nTrgNow;
   }
 
   // -----------------------------------------------------------------------------------------------------------
@@ -391,6 +459,13 @@ void ANNZ::setupKdTreeKNN(
   // sanity check - if this is not true, the distance calculations will be off
   VERIFY(LOCATION,(TString)"Somehow the fScaleFrac for the kd-tree is not zero ... Something is horribly wrong ?!?!?",(knnErrMethod->fScaleFrac < EPS));
 
+  // store the kd-tree for later jobs
+  if(indexFileName != "" && !glob->GetOptB("isReadOnlySys")) {
+    writeKnnErrIndex(indexFileName,indexKey,nMLMnow,trgNameV,knnErrMethod);
+  }
+
+  buildKdTreeKNN(knnErrModule,nMLMnow);
+
   outputs->BaseDir->cd();
 
   return;
@@ -403,15 +478,29 @@ void ANNZ::setupKdTreeKNN(
  * @param knnErrOutFile  - A TFile which was created as part of the setup of the TMVA::Factory in setupKdTreeKNN().
  * @param knnErrFactory  - A pointer to the TMVA::Factory which was created in setupKdTreeKNN().
  * @param knnErrDataLdr  - A pointer to the TMVA::DataLoader, needed for ROOT versions > 6.8.
+ * @param knnErrModule   - A pointer to the TMVA::kNN::ModulekNN, which is only deleted here if it was
+ *                       loaded from an index file (otherwise it is owned by the TMVA::Factory). The flat kd-tree
+ *                       of the module is also deleted.
  * @param verb           - Flag for activating debugging output.
  */
 // ===========================================================================================================
 void ANNZ::cleanupKdTreeKNN(
   TFile *& knnErrOutFile, TMVA::Factory *& knnErrFactory,
-  TMVA::Configurable *& knnErrDataLdr, bool verb
+  TMVA::Configurable *& knnErrDataLdr, TMVA::kNN::ModulekNN *& knnErrModule, bool verb
 ) {
 // ===========================================================================================================
   TString message("");
+
+  // the flat kd-tree refers to the events of the module, and so must be deleted first
+  map < TMVA::kNN::ModulekNN*,KdTreeKNN* >::iterator kdTreeItr = knnErrKdTreeM.find(knnErrModule);
+  if(kdTreeItr != knnErrKdTreeM.end()) {
+    DELNULL_(LOCATION,kdTreeItr->second,"knnErrKdTree",verb);
+    knnErrKdTreeM.erase(kdTreeItr);
+  }
+
+  // a kd-tree which was loaded from an index file is not owned by a factory (see loadKnnErrIndex())
+  if(knnErrFactory) knnErrModule = NULL;
+  else              DELNULL_(LOCATION,knnErrModule,"knnErrModule",verb);
   
   message = "knnErrFactory"; if(knnErrFactory) message += (TString)": "+knnErrFactory->GetName();
   DELNULL_(LOCATION,knnErrFactory,message,verb);
@@ -436,6 +525,460 @@ void ANNZ::cleanupKdTreeKNN(
   return;
 }
 
+// ===========================================================================================================
+/**
+ * @brief                - Build the flat kd-tree (KdTreeKNN) of a TMVA::kNN::ModulekNN for KNN error estimation.
+ * 
+ * @details              - The near-neighbours of getRegClsErrKNN() are found using the flat kd-tree, which is
+ *                       stored in knnErrKdTreeM (keyed by the module), and which holds pointers to the events
+ *                       of the module. Unlike the module, the kd-tree may be searched concurrently by several
+ *                       evaluation threads. If approxRecallKNN is smaller than one, the search is approximate,
+ *                       with the recall measured on a held-out sample (see KdTreeKNN::TuneMaxChecks()). If
+ *                       benchKdTreeKNN is set, the search is also benchmarked (see benchKdTreeKNN()).
+ * 
+ * @param knnErrModule   - A pointer to the (filled) TMVA::kNN::ModulekNN.
+ * @param nMLMnow        - The index of the primary MLM.
+ */
+// ===========================================================================================================
+void ANNZ::buildKdTreeKNN(TMVA::kNN::ModulekNN * knnErrModule, int nMLMnow) {
+// ==========================================================================
+  VERIFY(LOCATION,(TString)"Trying to build a kd-tree without a TMVA::kNN::ModulekNN ... Something is horribly wrong ?!?!?",(knnErrModule));
+
+  // sanity check - the events of the module must not be rescaled for the distances of the kd-tree to be correct
+  VERIFY(LOCATION,(TString)"Somehow the kd-tree rescales variables ... Something is horribly wrong ?!?!?",(knnErrModule->fVarScale.empty()));
+
+  KdTreeKNN *& kdTree = knnErrKdTreeM[knnErrModule];
+  DELNULL(kdTree);
+
+  TStopwatch buildTimer;
+
+  kdTree = new KdTreeKNN();
+  kdTree->Build(knnErrModule);
+
+  buildTimer.Stop();
+  aLOG(Log::DEBUG_1) <<coutGreen<<" - "<<coutBlue<<getTagName(nMLMnow)<<coutGreen<<" - built flat kd-tree ("<<coutYellow
+                     <<kdTree->GetNpoints()<<coutGreen<<" objects, "<<coutYellow<<kdTree->GetNdim()<<coutGreen<<" dimensions) in "
+                     <<coutYellow<<TString::Format("%3.3g",buildTimer.RealTime())<<coutGreen<<" sec ..."<<coutDef<<endl;
+
+  double recallTarget = glob->GetOptF("approxRecallKNN");
+  if(recallTarget < 1) {
+    double speedUp(1);
+    double recall = kdTree->TuneMaxChecks(glob->GetOptI("nErrKNN")+2,recallTarget,1000,&speedUp);
+
+    aLOG(Log::INFO) <<coutGreen<<" - "<<coutBlue<<getTagName(nMLMnow)<<coutGreen<<" - approximate kd-tree search: recall = "<<coutYellow
+                    <<TString::Format("%.4f",recall)<<coutGreen<<" (target "<<coutYellow<<recallTarget<<coutGreen<<"), checked objects = "
+                    <<coutYellow<<kdTree->GetMaxChecks()<<coutGreen<<" (0 -> exact search), speed-up = "<<coutYellow
+                    <<TString::Format("%.3g",speedUp)<<coutDef<<endl;
+  }
+
+  if(glob->GetOptB("benchKdTreeKNN")) benchKdTreeKNN(knnErrModule,kdTree,glob->GetOptI("nErrKNN")+2,nMLMnow);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief                - Benchmark the search for near-neighbours in a flat kd-tree against the search in the
+ *                       TMVA::kNN::ModulekNN from which it was built.
+ * 
+ * @details              - Up to 10^4 events of the module, spread evenly over the kd-tree, are used as the points
+ *                       for the search, shifted by a small offset (so that the point itself is not found at
+ *                       zero distance). For each point, nFind near-neighbours are found using both the module and
+ *                       the kd-tree. The rate of searches (per second, for a single thread) for each method, and
+ *                       the number of points for which the two sets of near-neighbours are identical, are written
+ *                       to the log. The two sets may differ if several neighbours are at the same distance as the
+ *                       last neighbour, or if the search in the kd-tree is approximate (see approxRecallKNN).
+ * 
+ * @param knnErrModule   - A pointer to the TMVA::kNN::ModulekNN.
+ * @param kdTree         - A pointer to the flat kd-tree of the module.
+ * @param nFind          - The number of near-neighbours to search for.
+ * @param nMLMnow        - The index of the primary MLM (for the log).
+ */
+// ===========================================================================================================
+void ANNZ::benchKdTreeKNN(TMVA::kNN::ModulekNN * knnErrModule, KdTreeKNN * kdTree, int nFind, int nMLMnow) {
+// =========================================================================================================
+  int nPnts  = kdTree->GetNpoints();
+  int nDim   = kdTree->GetNdim();
+  int nQuery = min(nPnts,10000);
+  if(nQuery == 0 || nFind < 1) return;
+
+  vector <TMVA::kNN::VarVec> queryV(nQuery);
+  for(int nQueryNow=0; nQueryNow<nQuery; nQueryNow++) {
+    queryV[nQueryNow] = kdTree->GetEvent(static_cast<int>((Long64_t)nQueryNow * nPnts / nQuery)).GetVars();
+    for(int nDimNow=0; nDimNow<nDim; nDimNow++) queryV[nQueryNow][nDimNow] += 1e-3 * (nDimNow + 1);
+  }
+
+  vector < vector <const TMVA::kNN::Event *> > knnEvtV(nQuery);
+  vector <int>                                  indexV(nFind);
+  vector <Float_t>                              distV (nFind);
+
+  // the search with the module
+  TStopwatch benchTimer;
+  for(int nQueryNow=0; nQueryNow<nQuery; nQueryNow++) {
+    knnErrModule->Find(TMVA::kNN::Event(queryV[nQueryNow],1,0),nFind);
+
+    const TMVA::kNN::List & listKNN = knnErrModule->GetkNNList();
+    for(TMVA::kNN::List::const_iterator itrKNN=listKNN.begin(); itrKNN!=listKNN.end(); ++itrKNN) {
+      knnEvtV[nQueryNow].push_back(&(itrKNN->first->GetEvent()));
+    }
+    std::sort(knnEvtV[nQueryNow].begin(),knnEvtV[nQueryNow].end());
+  }
+  benchTimer.Stop();
+  double timeModule = benchTimer.RealTime();
+
+  // the search with the flat kd-tree
+  benchTimer.Start(true);
+  for(int nQueryNow=0; nQueryNow<nQuery; nQueryNow++) kdTree->Find(&(queryV[nQueryNow][0]),nFind,&(indexV[0]),&(distV[0]));
+  benchTimer.Stop();
+  double timeKdTree = benchTimer.RealTime();
+
+  // compare the sets of near-neighbours
+  int nSame(0);
+  vector <const TMVA::kNN::Event *> evtNowV;
+  for(int nQueryNow=0; nQueryNow<nQuery; nQueryNow++) {
+    int nFound = kdTree->Find(&(queryV[nQueryNow][0]),nFind,&(indexV[0]),&(distV[0]));
+
+    evtNowV.clear();
+    for(int nKnnNow=0; nKnnNow<nFound; nKnnNow++) evtNowV.push_back(&(kdTree->GetEvent(indexV[nKnnNow])));
+    std::sort(evtNowV.begin(),evtNowV.end());
+
+    if(evtNowV == knnEvtV[nQueryNow]) nSame++;
+  }
+
+  aLOG(Log::INFO) <<coutGreen<<" - "<<coutBlue<<getTagName(nMLMnow)<<coutGreen<<" - kd-tree benchmark ("<<coutYellow<<nPnts
+                  <<coutGreen<<" objects, "<<coutYellow<<nDim<<coutGreen<<" dimensions, "<<coutYellow<<nFind<<coutGreen
+                  <<" near-neighbours, "<<coutYellow<<nQuery<<coutGreen<<" searches): TMVA module - "<<coutYellow
+                  <<TString::Format("%.4g",nQuery/max(timeModule,EPS))<<coutGreen<<" searches/sec, flat kd-tree - "<<coutYellow
+                  <<TString::Format("%.4g",nQuery/max(timeKdTree,EPS))<<coutGreen<<" searches/sec, identical neighbours for "
+                  <<coutYellow<<nSame<<"/"<<nQuery<<coutGreen<<" searches"<<coutDef<<endl;
+
+  queryV.clear(); knnEvtV.clear(); indexV.clear(); distV.clear(); evtNowV.clear();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief             - Derive the key of the index file of a kd-tree for KNN error estimation (see setupKdTreeKNN()).
+ * 
+ * @details           - The key is a hash of all of the inputs which determine the content of the kd-tree: the
+ *                    input variables and the targets, the cuts and weights, the options for rescaling and for
+ *                    sub-sampling, and the name, size and modification time of each of the files of the
+ *                    reference chain and of its friends. An index file which was created with different inputs
+ *                    (e.g., after retraining, or after the reference files have been regenerated) therefore
+ *                    has a different key, and is not used.
+ * 
+ * @param aChainKnn   - A chain linked to the training dataset.
+ * @param nMLMnow     - The index of the primary MLM.
+ * @param trgNameV    - The names of the targets of the kd-tree.
+ * @param cutsAll     - Cuts used on the dataset.
+ * @param wgtAll      - Weights for the entire dataset.
+ * 
+ * @return            - The key.
+ */
+// ===========================================================================================================
+ULong64_t ANNZ::getKnnErrIndexKey(TChain * aChainKnn, int nMLMnow, vector <TString> & trgNameV, TCut cutsAll, TString wgtAll) {
+// ===========================================================================================================================
+  TString keyStr("");
+
+  keyStr += (TString)"[__VAR__]";
+  for(int nVarNow=0; nVarNow<(int)inNamesVar[nMLMnow].size(); nVarNow++) keyStr += (TString)inNamesVar[nMLMnow][nVarNow]+";";
+  keyStr += (TString)"[__TRG__]";
+  for(int nTrgNow=0; nTrgNow<(int)trgNameV.size(); nTrgNow++)            keyStr += (TString)trgNameV[nTrgNow]+";";
+
+  keyStr += (TString)"[__CUT__]"+(TString)cutsAll+"[__WGT__]"+wgtAll;
+  keyStr += (TString)"[__OPT__]"+utils->boolToStr(glob->GetOptB("doWidthRescale_errKNN"))
+                     +";"+utils->doubleToStr(glob->GetOptF("sampleFrac_errKNN"))+";"+glob->GetOptC("indexName");
+
+  // the files of the chain and of all of its friends
+  vector <TTree*> treeV = utils->getTreeFriends(aChainKnn);
+  treeV.insert(treeV.begin(),aChainKnn);
+
+  for(int nTreeNow=0; nTreeNow<(int)treeV.size(); nTreeNow++) {
+    TChain * chainNow = dynamic_cast<TChain*>(treeV[nTreeNow]);
+    if(chainNow) keyStr += utils->getChainFileStamp(chainNow);
+  }
+  treeV.clear();
+
+  aLOG(Log::DEBUG_2) <<coutBlue<<" - kd-tree index key for "<<coutYellow<<getTagName(nMLMnow)<<coutBlue<<" from: "<<coutGreen<<keyStr<<coutDef<<endl;
+
+  return utils->getStrHash(keyStr);
+}
+
+// ===========================================================================================================
+/**
+ * @brief                - Load a kd-tree for KNN error estimation from an index file, which was written by
+ *                       writeKnnErrIndex().
+ * 
+ * @details              - The file is memory-mapped, and the stored events (the possibly rescaled input variables,
+ *                       the targets and the weights) are added to a new TMVA::kNN::ModulekNN, which is then filled
+ *                       using the same settings as TMVA::MethodKNN. The rescaling functions of the input variables
+ *                       (inVarsScaleFunc) are also restored. The file is not used if its key or its variables and
+ *                       targets do not match the current setup.
+ * 
+ * @param indexFileName  - The name of the index file.
+ * @param indexKey       - The expected key of the index file (see getKnnErrIndexKey()).
+ * @param nMLMnow        - The index of the primary MLM.
+ * @param trgNameV       - The expected names of the targets of the kd-tree.
+ * @param knnErrModule   - A pointer to the TMVA::kNN::ModulekNN which is created here (owned by the caller).
+ * @param trgIndexV      - container to keep track of how MLM indices are arranged in the KNN target list
+ * 
+ * @return               - true if the kd-tree was loaded.
+ */
+// ===========================================================================================================
+bool ANNZ::loadKnnErrIndex(
+  TString indexFileName, ULong64_t indexKey, int nMLMnow, vector <TString> & trgNameV,
+  TMVA::kNN::ModulekNN *& knnErrModule, vector <int> & trgIndexV
+) {
+// ===========================================================================================================
+  int      nMLMs          = glob->GetOptI("nMLMs");
+  bool     doWidthRescale = glob->GetOptB((TString)"doWidthRescale_errKNN");
+  TString  MLMname        = getTagName(nMLMnow);
+  int      nInVar         = (int)inNamesVar[nMLMnow].size();
+  int      nTrg           = (int)trgNameV.size();
+
+  if(gSystem->AccessPathName(indexFileName)) return false;
+
+  TStopwatch loadTimer;
+
+  int fileDesc = ::open(indexFileName.Data(),O_RDONLY);
+  if(fileDesc < 0) return false;
+
+  struct stat fileStat;
+  size_t      mapSize(0);
+  const char  * mapBegin(NULL);
+
+  if(fstat(fileDesc,&fileStat) == 0 && fileStat.st_size > 0) {
+    mapSize = static_cast<size_t>(fileStat.st_size);
+
+    void * mapPtr = mmap(NULL,mapSize,PROT_READ,MAP_PRIVATE,fileDesc,0);
+    if(mapPtr != MAP_FAILED) { mapBegin = static_cast<const char*>(mapPtr); madvise(mapPtr,mapSize,MADV_SEQUENTIAL); }
+  }
+  ::close(fileDesc);
+
+  if(!mapBegin) return false;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // the header - see writeKnnErrIndex()
+  // -----------------------------------------------------------------------------------------------------------
+  const size_t headLen(40);
+  const char   * pos(mapBegin), * mapEnd(mapBegin + mapSize);
+  TString      failMsg("");
+  UInt_t       version(0), nInVarIn(0), nTrgIn(0), strLen(0);
+  ULong64_t    keyIn(0), nEvtsIn(0);
+
+  vector < pair<TString,TString> > scaleFuncV;
+
+  if(mapSize < headLen || memcmp(pos,"ANNZKNN1",8) != 0) failMsg = "unknown file format";
+  else {
+    memcpy(&version ,pos+8 ,4); memcpy(&nInVarIn,pos+12,4); memcpy(&nTrgIn,pos+16,4);
+    memcpy(&keyIn   ,pos+24,8); memcpy(&nEvtsIn ,pos+32,8);
+    pos += headLen;
+
+    if     (version  != 1)            failMsg = "unsupported version";
+    else if(keyIn    != indexKey)                      failMsg = "mismatched key";
+    else if((int)nInVarIn != nInVar || (int)nTrgIn != nTrg) failMsg = "mismatched number of variables or targets";
+  }
+
+  // the names and formulae of the rescaling functions of the input variables, and the names of the targets
+  for(int nStrNow=0; nStrNow<2*nInVar+nTrg && failMsg == ""; nStrNow++) {
+    if(pos + 4 > mapEnd) { failMsg = "truncated file"; break; }
+    memcpy(&strLen,pos,4); pos += 4;
+    if(pos + strLen > mapEnd) { failMsg = "truncated file"; break; }
+
+    TString strNow(pos,strLen); pos += strLen;
+
+    if     (nStrNow < 2*nInVar) {
+      if(nStrNow % 2 == 0) scaleFuncV.push_back(pair<TString,TString>(strNow,""));
+      else                 scaleFuncV.back().second = strNow;
+    }
+    else if(strNow != trgNameV[nStrNow-2*nInVar]) failMsg = "mismatched targets";
+  }
+
+  // the data arrays
+  size_t  dataOffset = (((pos - mapBegin) + 7) / 8) * 8;
+  size_t  nEvts      = static_cast<size_t>(nEvtsIn);
+  size_t  dataSize   = nEvts * (sizeof(Double_t) + (nInVar + nTrg) * sizeof(Float_t) + sizeof(Short_t));
+
+  if(failMsg == "" && (dataOffset + dataSize != mapSize || nEvts == 0)) failMsg = "inconsistent data size";
+
+  if(failMsg != "") {
+    aLOG(Log::INFO) <<coutRed<<" - "<<coutYellow<<MLMname<<coutRed<<" - will not use kd-tree index "<<coutBlue
+                    <<indexFileName<<coutRed<<" ("<<failMsg<<") ..."<<coutDef<<endl;
+
+    munmap(const_cast<char*>(mapBegin),mapSize); scaleFuncV.clear();
+    return false;
+  }
+
+  const Double_t * wgtArr  = reinterpret_cast<const Double_t*>(mapBegin + dataOffset);
+  const Float_t  * varArr  = reinterpret_cast<const Float_t *>(wgtArr + nEvts);
+  const Float_t  * trgArr  = varArr + nEvts * nInVar;
+  const Short_t  * typeArr = reinterpret_cast<const Short_t *>(trgArr + nEvts * nTrg);
+
+  // -----------------------------------------------------------------------------------------------------------
+  // the rescaling functions and the indices of the targets
+  // -----------------------------------------------------------------------------------------------------------
+  if(doWidthRescale) {
+    inVarsScaleFunc[nMLMnow].resize(nInVar,NULL);
+    for(int nVarNow=0; nVarNow<nInVar; nVarNow++) {
+      inVarsScaleFunc[nMLMnow][nVarNow] = new TF1(scaleFuncV[nVarNow].first,scaleFuncV[nVarNow].second);
+    }
+  }
+
+  trgIndexV.resize(nMLMs,-1);
+  for(int nTrgNow=0; nTrgNow<nTrg; nTrgNow++) trgIndexV[getErrKNNtagNow(trgNameV[nTrgNow])] = nTrgNow;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // create the kd-tree, with the default settings of TMVA::MethodKNN (BalanceDepth=6, with no trimming and
+  // no metric scaling, as ScaleFrac=0 in setupKdTreeKNN())
+  // -----------------------------------------------------------------------------------------------------------
+  knnErrModule = new TMVA::kNN::ModulekNN();
+
+  TMVA::kNN::VarVec vvec(nInVar,0), tvec(nTrg,0);
+  for(size_t nEvtNow=0; nEvtNow<nEvts; nEvtNow++) {
+    for(int nVarNow=0; nVarNow<nInVar; nVarNow++) vvec[nVarNow] = varArr[nEvtNow * nInVar + nVarNow];
+    for(int nTrgNow=0; nTrgNow<nTrg;   nTrgNow++) tvec[nTrgNow] = trgArr[nEvtNow * nTrg   + nTrgNow];
+
+    TMVA::kNN::Event evtNow(vvec,wgtArr[nEvtNow],typeArr[nEvtNow]);
+    evtNow.SetTargets(tvec);
+
+    knnErrModule->Add(evtNow);
+  }
+  knnErrModule->Fill(6,0,"");
+
+  munmap(const_cast<char*>(mapBegin),mapSize); scaleFuncV.clear();
+
+  loadTimer.Stop();
+  aLOG(Log::INFO) <<coutGreen<<" - "<<coutYellow<<MLMname<<coutGreen<<" - loaded kd-tree ("<<coutYellow<<nEvts<<coutGreen
+                  <<" objects) from index "<<coutBlue<<indexFileName<<coutGreen<<" in "<<coutYellow
+                  <<TString::Format("%3.3g",loadTimer.RealTime())<<coutGreen<<" sec ..."<<coutDef<<endl;
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief                - Write the events of a kd-tree for KNN error estimation to an index file, which may be
+ *                       loaded by later jobs using loadKnnErrIndex().
+ * 
+ * @details              - The format of the file is (all numbers are little-endian):
+ *                         - a header with the 8 character magic string "ANNZKNN1", the version (uint32, currently 1), the
+ *                         number of input variables and of targets (uint32 each, followed by 4 bytes of padding),
+ *                         the key (uint64) and the number of events (uint64).
+ *                         - the name and the formula of the rescaling function of each input variable, followed by
+ *                         the name of each target, as strings of (uint32) length, followed by padding to 8 bytes.
+ *                         - the weights of all events (float64), the input variables of all events (float32,
+ *                         row-major), the targets of all events (float32, row-major) and the type of each
+ *                         event (int16).
+ *                       The file is first written under a temporary name, and then renamed, so that concurrent
+ *                       jobs never read a partially written index.
+ * 
+ * @param indexFileName  - The name of the index file.
+ * @param indexKey       - The key of the index file (see getKnnErrIndexKey()).
+ * @param nMLMnow        - The index of the primary MLM.
+ * @param trgNameV       - The names of the targets of the kd-tree.
+ * @param knnErrMethod   - The trained TMVA::MethodKNN, which holds the events of the kd-tree.
+ */
+// ===========================================================================================================
+void ANNZ::writeKnnErrIndex(
+  TString indexFileName, ULong64_t indexKey, int nMLMnow, vector <TString> & trgNameV, TMVA::MethodKNN * knnErrMethod
+) {
+// ===========================================================================================================
+  bool     doWidthRescale = glob->GetOptB((TString)"doWidthRescale_errKNN");
+  TString  MLMname        = getTagName(nMLMnow);
+  UInt_t   nInVar         = (UInt_t)inNamesVar[nMLMnow].size();
+  UInt_t   nTrg           = (UInt_t)trgNameV.size();
+  ULong64_t nEvts         = (ULong64_t)knnErrMethod->fEvent.size();
+
+  UShort_t testEndian(1);
+  if(*reinterpret_cast<char*>(&testEndian) != 1 || nEvts == 0) return;
+
+  for(ULong64_t nEvtNow=0; nEvtNow<nEvts; nEvtNow++) {
+    const TMVA::kNN::Event & evtNow = knnErrMethod->fEvent[nEvtNow];
+    if(evtNow.GetNVar() != nInVar || evtNow.GetNTgt() != nTrg) {
+      aLOG(Log::WARNING) <<coutRed<<" - "<<coutYellow<<MLMname<<coutRed<<" - mismatched number of variables or targets in"
+                         <<" kd-tree ... will not write index "<<coutBlue<<indexFileName<<coutDef<<endl;
+      return;
+    }
+  }
+
+  gSystem->mkdir(gSystem->DirName(indexFileName),true);
+
+  TString       tmpFileName = (TString)indexFileName+TString::Format(".tmp%d",gSystem->GetPid());
+  std::ofstream outFile(tmpFileName.Data(),std::ios::out | std::ios::binary);
+  if(!outFile.good()) {
+    aLOG(Log::WARNING) <<coutRed<<" - could not write kd-tree index "<<coutBlue<<tmpFileName<<coutDef<<endl;
+    return;
+  }
+
+  // the header
+  const size_t headLen(40);
+  char         header[headLen];
+  UInt_t       version(1);
+  memset(header,0,headLen);
+
+  memcpy(header,"ANNZKNN1",8);
+  memcpy(header+8 ,&version ,4); memcpy(header+12,&nInVar,4); memcpy(header+16,&nTrg,4);
+  memcpy(header+24,&indexKey,8); memcpy(header+32,&nEvts ,8);
+
+  outFile.write(header,headLen);
+  size_t nBytes(headLen);
+
+  // the rescaling functions of the input variables and the names of the targets
+  vector <TString> strV;
+  for(UInt_t nVarNow=0; nVarNow<nInVar; nVarNow++) {
+    TF1 * scaleFunc = (doWidthRescale && nVarNow < inVarsScaleFunc[nMLMnow].size()) ? inVarsScaleFunc[nMLMnow][nVarNow] : NULL;
+
+    strV.push_back(scaleFunc ? (TString)scaleFunc->GetName()  : (TString)"");
+    strV.push_back(scaleFunc ? (TString)scaleFunc->GetTitle() : (TString)"");
+  }
+  for(UInt_t nTrgNow=0; nTrgNow<nTrg; nTrgNow++) strV.push_back(trgNameV[nTrgNow]);
+
+  for(int nStrNow=0; nStrNow<(int)strV.size(); nStrNow++) {
+    UInt_t strLen = (UInt_t)strV[nStrNow].Length();
+    outFile.write(reinterpret_cast<const char*>(&strLen),4); outFile.write(strV[nStrNow].Data(),strLen);
+    nBytes += 4 + strLen;
+  }
+  strV.clear();
+
+  char padding[8] = {0,0,0,0,0,0,0,0};
+  outFile.write(padding,(8 - nBytes % 8) % 8);
+
+  // the data arrays
+  vector <Double_t> wgtV (nEvts);
+  vector <Float_t>  varV (nEvts * nInVar), trgV(nEvts * nTrg);
+  vector <Short_t>  typeV(nEvts);
+
+  for(ULong64_t nEvtNow=0; nEvtNow<nEvts; nEvtNow++) {
+    const TMVA::kNN::Event & evtNow = knnErrMethod->fEvent[nEvtNow];
+
+    wgtV [nEvtNow] = evtNow.GetWeight();
+    typeV[nEvtNow] = evtNow.GetType();
+    for(UInt_t nVarNow=0; nVarNow<nInVar; nVarNow++) varV[nEvtNow * nInVar + nVarNow] = evtNow.GetVar(nVarNow);
+    for(UInt_t nTrgNow=0; nTrgNow<nTrg;   nTrgNow++) trgV[nEvtNow * nTrg   + nTrgNow] = evtNow.GetTgt(nTrgNow);
+  }
+
+  outFile.write(reinterpret_cast<const char*>(wgtV .data()),wgtV .size() * sizeof(Double_t));
+  outFile.write(reinterpret_cast<const char*>(varV .data()),varV .size() * sizeof(Float_t));
+  outFile.write(reinterpret_cast<const char*>(trgV .data()),trgV .size() * sizeof(Float_t));
+  outFile.write(reinterpret_cast<const char*>(typeV.data()),typeV.size() * sizeof(Short_t));
+
+  bool writeOk = outFile.good();
+  outFile.close();
+
+  wgtV.clear(); varV.clear(); trgV.clear(); typeV.clear();
+
+  if(writeOk && rename(tmpFileName.Data(),indexFileName.Data()) == 0) {
+    aLOG(Log::INFO) <<coutGreen<<" - "<<coutYellow<<MLMname<<coutGreen<<" - wrote kd-tree index "<<coutBlue<<indexFileName<<coutDef<<endl;
+  }
+  else {
+    aLOG(Log::WARNING) <<coutRed<<" - could not write kd-tree index "<<coutBlue<<indexFileName<<coutDef<<endl;
+    gSystem->Unlink(tmpFileName);
+  }
+
+  return;
+}
+
 
 
 // ===========================================================================================================
@@ -454,17 +997,19 @@ void ANNZ::cleanupKdTreeKNN(
  *                  
  * @param var           - A VarMaps object which may update the values of the input-variables which are
  *                      linked to the TMVA::Reader object.
- * @param knnErrModule  - A pointer to the TMVA::kNN::ModulekNN which is created by the TMVA::Factory, and is
- *                      used to get the near-neighbours in.
+ * @param knnErrModule  - A pointer to the TMVA::kNN::ModulekNN which is created by the TMVA::Factory. The
+ *                      near-neighbours are found using the flat kd-tree of the module (see buildKdTreeKNN()).
  * @param trgIndexV     - vector of indices of the position of a given MLM-index in the target-list of the KNN factory.
  * @param nMLMv         - vector of MLM indices for which the errors are computed.
  * @param isREG         - flag to indicate if the error is for a regression target or for classification.
  * @param zErrV         - vector to hold negative/average/positive error estimates for each MLM.
+ * @param thr           - An optional evaluation thread, whose input-variables and utils are used. The
+ *                      kd-tree is shared between threads, which may search it concurrently.
  */
 // ===========================================================================================================
 void ANNZ::getRegClsErrKNN(
   VarMaps * var, TMVA::kNN::ModulekNN * knnErrModule, vector <int> & trgIndexV,
-  vector <int> & nMLMv, bool isREG, vector < vector <double> > & zErrV
+  vector <int> & nMLMv, bool isREG, vector < vector <double> > & zErrV, RegEvalThread * thr
 ) {
 // ===========================================================================================================
   aLOG(Log::DEBUG_3) <<coutWhiteOnBlack<<coutBlue<<" - starting ANNZ::getRegClsErrKNN() ... "<<coutDef<<endl;
@@ -476,39 +1021,44 @@ void ANNZ::getRegClsErrKNN(
   int  nMLM_0         = nMLMv[0];
   int  nInVar         = (int)inNamesVar[nMLM_0].size();
 
+  Utils                            * utilsNow      = thr ? thr->utils : utils;
+  vector < pair<TString,Float_t> > & readerInptNow = (thr && thr->hasReaders) ? thr->readerInptV : readerInptV;
+
   // sanith check of the initialization of trgIndexV
   VERIFY(LOCATION,(TString)" - trgIndexV is not initialized in ANNZ::getRegClsErrKNN() !!!",((int)trgIndexV.size() == nMLMs));
 
+  map < TMVA::kNN::ModulekNN*,KdTreeKNN* >::iterator kdTreeItr = knnErrKdTreeM.find(knnErrModule);
+  VERIFY(LOCATION,(TString)" - kd-tree is not initialized in ANNZ::getRegClsErrKNN() !!!",(kdTreeItr != knnErrKdTreeM.end()));
+
+  KdTreeKNN * kdTree = kdTreeItr->second;
+
   for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
     VERIFY(LOCATION,(TString)" - trgIndexV is not initialized in ANNZ::getRegClsErrKNN() !!!",(trgIndexV[nMLMv[nMLMinNow]] >= 0));
   }
 
-  vector <TH1 *> his1V(nMLMsIn);
-  for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
-    TString hisName  = TString::Format("hisErrKNN_%d",nMLMinNow);
-    his1V[nMLMinNow] = new TH1F(hisName,hisName,1e3,1,-1);
-    his1V[nMLMinNow]->SetDefaultBufferSize(nErrKNN+2);
-  }
+  // the (target, weight) pairs of the near-neighbours for each MLM, from which exact weighted quantiles are derived
+  vector < vector < pair<double,double> > > knnTrgV(nMLMsIn);
+  for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) knnTrgV[nMLMinNow].reserve(nErrKNN+2);
 
   // update the variables connected to the reader
-  var->updateReaderFormulae(readerInptV,true);
+  var->updateReaderFormulae(readerInptNow,true);
 
   // get the content of readerInptV into a VarVec
   TMVA::kNN::VarVec vvec(nInVar,0);
   for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) {
     int    readerInptIndex = readerInptIndexV[nMLM_0][nInVarNow];
-    double readerInptVal   = readerInptV[readerInptIndex].second;
+    double readerInptVal   = readerInptNow[readerInptIndex].second;
 
     VERIFY(LOCATION,(TString)"There's a mixup with input variables and the reader... Something is horribly wrong... ?!?"
-                             ,(inNamesVar[nMLM_0][nInVarNow] == readerInptV[readerInptIndex].first));
+                             ,(inNamesVar[nMLM_0][nInVarNow] == readerInptNow[readerInptIndex].first));
     if(doWidthRescale) {
       bool hasScaleFunf(false);
       if((int)inVarsScaleFunc[nMLM_0].size() > nInVarNow) hasScaleFunf = dynamic_cast<TF1*>(inVarsScaleFunc[nMLM_0][nInVarNow]);
-      VERIFY(LOCATION,(TString)"Has not defined a scaling function for \""+readerInptV[readerInptIndex].first
+      VERIFY(LOCATION,(TString)"Has not defined a scaling function for \""+readerInptNow[readerInptIndex].first
                                +"\"... Something is horribly wrong... ?!?",hasScaleFunf);
 
       vvec[nInVarNow] = inVarsScaleFunc[nMLM_0][nInVarNow]->Eval(readerInptVal);
-      // cout<<nMLM_0<<CT<<readerInptV[readerInptIndex].first<<CT<<readerInptVal<<CT<<inVarsScaleFunc[nMLM_0][nInVarNow]->GetName()<<CT<<vvec[nInVarNow]<<endl;
+      // cout<<nMLM_0<<CT<<readerInptNow[readerInptIndex].first<<CT<<readerInptVal<<CT<<inVarsScaleFunc[nMLM_0][nInVarNow]->GetName()<<CT<<vvec[nInVarNow]<<endl;
     }
     else {
       vvec[nInVarNow] = readerInptVal;
@@ -516,39 +1066,38 @@ void ANNZ::getRegClsErrKNN(
   }
   // for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) cout <<" ---- "<<nMLMinNow<<CT<<nMLMv[nMLMinNow]<<endl;
 
-  const TMVA::kNN::Event evt_orig(vvec,1,0);
-  knnErrModule->Find(evt_orig,nErrKNN+2);
- 
-  const TMVA::kNN::List & listKNN = knnErrModule->GetkNNList();
+  // find the near-neighbours in the kd-tree
+  vector <int>     knnIndexV(nErrKNN+2);
+  vector <Float_t> knnDistV (nErrKNN+2);
+
+  int nFoundKNN = kdTree->Find(&(vvec[0]),nErrKNN+2,&(knnIndexV[0]),&(knnDistV[0]));
 
-  for(TMVA::kNN::List::const_iterator itrKNN=listKNN.begin(); itrKNN!=listKNN.end(); ++itrKNN) {
-    if(itrKNN->second < EPS) continue; // the distance to this neighbour must be positive
+  for(int nKnnNow=0; nKnnNow<nFoundKNN; nKnnNow++) {
+    if(knnDistV[nKnnNow] < EPS) continue; // the distance to this neighbour must be positive
 
-    const TMVA::kNN::Event & evt_knn = itrKNN->first->GetEvent();
+    const TMVA::kNN::Event & evt_knn = kdTree->GetEvent(knnIndexV[nKnnNow]);
     double                 knnWgt    = evt_knn.GetWeight();
 
     for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
       int nMLMnow = nMLMv[nMLMinNow];
       int nTrgKNN = trgIndexV[nMLMnow];
 
-      his1V[nMLMinNow]->Fill(evt_knn.GetTgt(nTrgKNN),knnWgt);
+      knnTrgV[nMLMinNow].push_back(pair<double,double>(evt_knn.GetTgt(nTrgKNN),knnWgt));
       // cout <<evt_knn.GetNTgt()<<CT<<nMLMnow<<CT<<nTrgKNN<<"  -> "<<evt_knn.GetTgt(nTrgKNN)<<endl;
     }
   }
   
-  // derive the errors from the histograms
+  // derive the errors from the near-neighbour targets
   vector <double> fracV(3), quantV(3,-1);
   fracV[0] = 0.16; fracV[1] = 0.5; fracV[2] = 0.84;
 
   for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
     int nMLMnow = nMLMv[nMLMinNow];
 
-    his1V[nMLMinNow]->BufferEmpty();
-
     double zErr(-1), zErrP(-1), zErrN(-1);
 
-    utils->param->clearAll();
-    if(utils->getQuantileV(fracV,quantV,his1V[nMLMinNow])) {
+    utilsNow->param->clearAll();
+    if(utilsNow->getQuantileWgt(fracV,quantV,knnTrgV[nMLMinNow])) {
       if(isREG) { zErr = (quantV[2] - quantV[0])/2.; zErrP = (quantV[2] - quantV[1]); zErrN = (quantV[1] - quantV[0]); }
       else      { zErr = quantV[1];                  zErrP = 0;                       zErrN = 0;                       }
     }
@@ -556,18 +1105,16 @@ void ANNZ::getRegClsErrKNN(
       aLOG(Log::DEBUG_2) <<coutRed<< " - got undefined err calculation for inputs:"<<coutDef<<endl;
       for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) {
         int readerInptIndex = readerInptIndexV[nMLM_0][nInVarNow];
-        aLOG(Log::DEBUG_2) <<coutRed<<"   - "<<coutYellow<< readerInptV[readerInptIndex].first<<coutGreen
-                           <<CT<<readerInptV[readerInptIndex].second<<coutDef<<endl;
+        aLOG(Log::DEBUG_2) <<coutRed<<"   - "<<coutYellow<< readerInptNow[readerInptIndex].first<<coutGreen
+                           <<CT<<readerInptNow[readerInptIndex].second<<coutDef<<endl;
       }
     }
 
     zErrV[nMLMnow].resize(3);
     zErrV[nMLMnow][0] = zErrN; zErrV[nMLMnow][1] = zErr; zErrV[nMLMnow][2] = zErrP;
-
-    DELNULL(his1V[nMLMinNow]);
   }
 
-  fracV.clear(); quantV.clear(); his1V.clear();
+  fracV.clear(); quantV.clear(); knnTrgV.clear(); knnIndexV.clear(); knnDistV.clear();
 
   return;
 }
@@ -583,7 +1130,8 @@ void ANNZ::getRegClsErrKNN(
  *                  uncertainty on the MLM is computed by generating random shifts to each input-parameter
  *                  based on the respective error. The value of the MLM estimator is then computed using the
  *                  shifted inputs. The distribution of the smeared MLM estimations is used to derive the final
- *                  uncertainty.
+ *                  uncertainty. All smeared input vectors are generated into a single buffer and evaluated as
+ *                  a batch (see getReaderBatch()), and the quantiles of the results are derived by partial sorting.
  *         
  * @param var       - A VarMaps object which may update the values of the input-variables which are
  *                  linked to the TMVA::Reader object.
@@ -592,12 +1140,13 @@ void ANNZ::getRegClsErrKNN(
  * @param seedP     - A seed for random number generation, which should be dfferent every time the
  *                  function is called.
  * @param zErrV      - optional vector to hold negative/average/positive error estimates.
+ * @param thr       - An optional evaluation thread, whose readers and utils are used.
  *                  
  * @return          - The value of the KNN error (returns -1 in case of failure).
  */
 // ===========================================================================================================
 double ANNZ::getRegClsErrINP(
-  VarMaps * var, bool isREG, int nMLMnow, UInt_t * seedP, vector <double> * zErrV
+  VarMaps * var, bool isREG, int nMLMnow, UInt_t * seedP, vector <double> * zErrV, RegEvalThread * thr
 ) {
 // ===========================================================================================================
   VERIFY(LOCATION,(TString)"Memory leak ?! ",(dynamic_cast<VarMaps*>(var)));
@@ -607,13 +1156,24 @@ double ANNZ::getRegClsErrINP(
   UInt_t seed(0);
   if(seedP) { seed = *seedP; (*seedP) += 1; }
 
-  TRandom * rnd       = new TRandom(seed);
-  TString MLMname     = getTagName(nMLMnow);
   int     nInVar      = (int)inNamesVar[nMLMnow].size();
   int     nErrINP     = glob->GetOptI("nErrINP");
   int     nErrINPHalf = static_cast<int>(floor(0.01 + nErrINP/2.));
 
-  vector <double> inVarErrV(nInVar);
+  Utils                            * utilsNow      = thr ? thr->utils : utils;
+  vector < pair<TString,Float_t> > & readerInptNow = (thr && thr->hasReaders) ? thr->readerInptV : readerInptV;
+
+  // the random number generator and the scratch buffers are reused between calls. the generator is
+  // reseeded for each call, which is equivalent to creating a new TRandom with the same seed
+  TRandom          *& rndNow    = thr ? thr->rndErrINP     : rndErrINP;
+  vector <Float_t>  & inptBufV  = thr ? thr->errINPinptV   : errINPinptV;
+  vector <double>   & outBufV   = thr ? thr->errINPoutV    : errINPoutV;
+  vector <double>   & inVarErrV = thr ? thr->errINPvarErrV : errINPvarErrV;
+
+  if(!rndNow) rndNow = new TRandom(seed);
+  else        rndNow->SetSeed(seed);
+
+  inVarErrV.resize(nInVar);
   for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) {
     inVarErrV[nInVarNow] = var->GetForm(getTagInVarErr(nMLMnow,nInVarNow));
 
@@ -629,34 +1189,32 @@ double ANNZ::getRegClsErrINP(
   // after it was caalled once with forceUpdate=true since the previousvar0>getTreeEntry()
   ANNZ_readType readType = isREG ? ANNZ_readType::REG : ANNZ_readType::PRB;
 
-  double  regClsOrig(getReader(var,readType,true,nMLMnow)), regClsSmear(0);
-  vector < pair<TString,Float_t> > readerInptVorig = readerInptV;
-
-  TH1 * his1 = new TH1F("hisErrINP","hisErrINP",1e3,1,-1);
-  his1->SetDefaultBufferSize(glob->GetOptI("nErrINP") + 10);
+  double  regClsOrig(getReader(var,readType,true,nMLMnow,thr)), regClsSmear(0);
 
+  // generate all of the smeared input vectors up front (row-major, one row per smearing), with the same
+  // order of random numbers as for sequential smearing and evaluation
+  inptBufV.resize(nErrINP * nInVar);
   for(int nSmearRndNow=0; nSmearRndNow<nErrINP; nSmearRndNow++) {
+    Float_t * rowNow = inptBufV.data() + nSmearRndNow * nInVar;
+
     // go over all input variables and smear each according to the corresponding error
     for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) {
       int    readerInptIndex = readerInptIndexV[nMLMnow][nInVarNow];
-      double sfNow           = fabs(rnd->Gaus(0,inVarErrV[nInVarNow])); if(nSmearRndNow < nErrINPHalf) sfNow *= -1;
+      double sfNow           = fabs(rndNow->Gaus(0,inVarErrV[nInVarNow])); if(nSmearRndNow < nErrINPHalf) sfNow *= -1;
 
-      readerInptV[readerInptIndex].second = readerInptVorig[readerInptIndex].second + sfNow;
+      rowNow[nInVarNow] = readerInptNow[readerInptIndex].second + sfNow;
     }
-    // evaluate the MLM without updating the reader variables from the formulae of var
-    regClsSmear = getReader(var,readType,false,nMLMnow);
-
-    his1->Fill(regClsSmear);
   }
 
-  his1->BufferEmpty();
+  // evaluate the MLM for all smeared inputs, without updating the reader variables from the formulae of var
+  getReaderBatch(var,readType,nMLMnow,nErrINP,inptBufV,outBufV,thr);
 
   double          zErr(-1), zErrP(-1),zErrN(-1);
   vector <double> fracV(3), quantV(3,-1);
   fracV[0] = 0.16; fracV[1] = 0.5; fracV[2] = 0.84;
 
-  utils->param->clearAll();
-  if(utils->getQuantileV(fracV,quantV,his1)) {
+  // exact sample quantiles from a partial sort of the smeared results
+  if(utilsNow->getQuantileNth(fracV,quantV,outBufV)) {
     zErr = (quantV[2] - quantV[0])/2.; zErrP = (quantV[2] - quantV[1]); zErrN = (quantV[1] - quantV[0]);
   }
   if(zErrV) {
@@ -667,12 +1225,10 @@ double ANNZ::getRegClsErrINP(
 
   // force a reset of the variables which are connected to the reader to the correct values and check that we get the
   // original evaluation result back
-  regClsSmear = getReader(var,readType,true,nMLMnow);
+  regClsSmear = getReader(var,readType,true,nMLMnow,thr);
   VERIFY(LOCATION,(TString)"Somehow the error calculation messed up the MLM reader ... Something is horribly wrong ?!?!?"
                  ,(fabs(regClsOrig-regClsSmear) < 1e-10));
 
-  DELNULL(his1); inVarErrV.clear(); readerInptVorig.clear();
-
   if(inLOG(Log::DEBUG_3)) {
     TString debugStr("");
     if(zErrV) debugStr = (TString) getTagError(nMLMnow,"N")+" = "+utils->floatToStr(zErrN)+", "
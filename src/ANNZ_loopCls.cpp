@@ -58,6 +58,7 @@ void ANNZ::optimCls() {
   // connect the variables to the tree (and add formulae for all the input parameters of the readers)
   VarMaps * var = new VarMaps(glob,utils,"loopRegClsVar");
   var->connectTreeBranches(aChain);
+  var->selectTreeBranches();
 
   // if(separateTestValid) var->setTreeCuts("_train",getTrainTestCuts("_valid",0,0,0,var)); // deprecated
 
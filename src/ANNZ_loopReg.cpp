@@ -319,7 +319,6 @@ void  ANNZ::fillColosureV(
   aLOG(Log::INFO) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::fillColosureV() ... "<<coutDef<<endl;
 
   TString hisName(""), drawExprs(""), wgtCut(""), zAxisTitle("");
-  bool    breakLoop(false);
 
   int     nMLMs             = glob->GetOptI("nMLMs");
   int     maxNobj           = glob->GetOptI("maxNobj");
@@ -364,13 +363,22 @@ void  ANNZ::fillColosureV(
     bool gotQuants = utils->getQuantileV(fracV,quantV,hisQuantTMP);
     VERIFY(LOCATION,(TString)"Could not derive quantiles from "+aChain->GetName(),gotQuants);
 
-    zClos_binC.resize(nBinsZ,0); zClos_binE.resize(nBinsZ+1,0);
-    for(int nBinNow=1; nBinNow<nBinsZ+1; nBinNow++) {
-      zClos_binE[nBinNow] = quantV[nBinNow-1];
+    // the bin edges must be strictly ascending (see BinLookup::Set()), so that quantiles which coincide (e.g., for
+    // discrete values of zTrg) or which are outside of [minValZ,maxValZ] are merged with the previous edge
+    zClos_binE.clear();
+    zClos_binE.push_back(minValZ);
+    for(int nQuantNow=0; nQuantNow<nBinsZ-1; nQuantNow++) {
+      if(quantV[nQuantNow] > zClos_binE.back() + EPS && quantV[nQuantNow] < maxValZ - EPS) zClos_binE.push_back(quantV[nQuantNow]);
     }
-    zClos_binE[0]      = minValZ;
-    zClos_binE[nBinsZ] = maxValZ;
-    
+    zClos_binE.push_back(maxValZ);
+
+    if((int)zClos_binE.size() < nBinsZ+1) {
+      aLOG(Log::INFO) <<coutRed<<" - merged closure bins with identical quantiles - using "<<coutPurple<<(int)zClos_binE.size()-1
+                      <<coutRed<<" instead of "<<coutPurple<<nBinsZ<<coutRed<<" bins ..."<<coutDef<<endl;
+    }
+    nBinsZ = (int)zClos_binE.size() - 1;
+
+    zClos_binC.resize(nBinsZ,0);
     for(int nBinNow=0; nBinNow<nBinsZ; nBinNow++) {
       zClos_binC[nBinNow] = zClos_binE[nBinNow] + 0.5 * (zClos_binE[nBinNow+1] - zClos_binE[nBinNow]);
     }
@@ -384,67 +392,139 @@ void  ANNZ::fillColosureV(
                        <<" closure bins by quantiles: "<<coutYellow<<"["<<quantBins<<"]"<<coutDef<<endl;
     }
 
+    // setInfoBinsZ() only sets the lookup for closure bins of fixed width (zClosBinWidth), so it is set here
+    zClos_binL.Set(zClos_binE);
+
     DELNULL(hisQuantTMP);
     fracV.clear(); quantV.clear();
   }
 
 
   // -----------------------------------------------------------------------------------------------------------
-  // 
+  // fill a quantile sketch of the bias for each MLM in each bin. The entries are split between threads, each of
+  // which fills its own sketches, and the sketches of all threads are then merged in a fixed order
   // -----------------------------------------------------------------------------------------------------------
-  vector < double >        sumWeightsBin(nBinsZ,0);
-  vector < vector <TH1*> > closH(nMLMs);
+  double   sketchCompression = glob->GetOptF("quantSketchCompression");
+  int      nThreads          = ThreadPool::getNumThreads(glob->GetOptI("nThreads"));
+  Long64_t nEntriesChain     = aChain->GetEntries();
+  if(maxNobj > 0) nEntriesChain = min(nEntriesChain,(Long64_t)maxNobj);
 
-  int closHisN(glob->GetOptI("closHisN")), hisBufSize(glob->GetOptI("hisBufSize"));
-  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-    TString MLMname = getTagName(nMLMnow); if(mlmSkip[MLMname]) continue;
+  int nThreadsNow = static_cast<int>(max(min((Long64_t)nThreads,nEntriesChain),(Long64_t)1));
 
-    closH[nMLMnow].resize(nBinsZ);
-    for(int nBinNow=0; nBinNow<nBinsZ; nBinNow++) {
-      hisName = TString::Format("TMPclosureHis_%d_"+MLMname,nBinNow);
-      closH[nMLMnow][nBinNow] = new TH1F(hisName,hisName,closHisN,1,-1);
-      closH[nMLMnow][nBinNow]->SetDefaultBufferSize(hisBufSize);
+  vector < vector<double> >                sumWeightsBinV(nThreadsNow,vector<double>(nBinsZ,0));
+  vector < vector < vector<QuantSketch> > > closSV(nThreadsNow);
+  for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+    closSV[nThreadNow].resize(nMLMs);
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+      TString MLMname = getTagName(nMLMnow); if(mlmSkip[MLMname]) continue;
+      closSV[nThreadNow][nMLMnow].resize(nBinsZ,QuantSketch(sketchCompression));
     }
   }
 
-  VarMaps * var = new VarMaps(glob,utils,"treeRegVar");
-  var->connectTreeBranches(aChain);
+  // the loop over the entries [entryMin,entryMax) of a given chain, for a given thread
+  auto fillClosureSketches = [&](int nThreadNow, TChain * loopChain, Utils * utilsNow, Long64_t entryMin, Long64_t entryMax) {
+    vector < double >               & sumWeightsBin = sumWeightsBinV[nThreadNow];
+    vector < vector <QuantSketch> > & closS         = closSV        [nThreadNow];
 
-  // -----------------------------------------------------------------------------------------------------------
-  // loop on the tree
-  // -----------------------------------------------------------------------------------------------------------
-  var->clearCntr(); breakLoop = false;
-  for(Long64_t loopEntry=0; true; loopEntry++) {
-    if(!var->getTreeEntry(loopEntry)) breakLoop = true;
+    VarMaps * var = new VarMaps(glob,utilsNow,(TString)"treeRegVar_"+utilsNow->intToStr(nThreadNow));
+    var->connectTreeBranches(loopChain);
+    var->selectTreeBranches();
 
-    if((var->GetCntr("nObj")+1 % nObjectsToWrite == 0) || breakLoop) var->printCntr(aChainName,Log::DEBUG);
-    if(breakLoop) break;
-    
-    double zTrg = var->GetVarF(zTrgName);
+    // resolve the variables used in the loop once, to avoid name lookups for each object
+    VarMaps::VarHandle         zTrgHdl = var->GetVarHandle(zTrgName);
+    vector <VarMaps::VarHandle> regValHdlV(nMLMs), regWgtHdlV(nMLMs);
     for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-      TString MLMname   = getTagName(nMLMnow);           if(mlmSkip[MLMname]) continue;
-      TString MLMname_w = getTagWeight(nMLMnow);
+      if(closS[nMLMnow].size() == 0) continue;
 
-      double weightNow = var->GetVarF(MLMname_w);        if(weightNow < EPS)  continue;
-      double regValNow = var->GetVarF(MLMname);
-      int    zRegBinN  = getBinZ(regValNow,zClos_binE);  if(zRegBinN < 0)     continue;
+      regValHdlV[nMLMnow] = var->GetVarHandle(getTagName(nMLMnow));
+      regWgtHdlV[nMLMnow] = var->GetVarHandle(getTagWeight(nMLMnow));
+    }
 
-      double sclBias(regValNow-zTrg);
-      if(optimWithSclBias) {
-        double denom = 1 + zTrg;
-        if(fabs(denom) < EPS) sclBias  = DefOpts::DefF;
-        else                  sclBias /= denom;
+    bool breakLoop(false);
+    var->clearCntr();
+    for(Long64_t loopEntry=entryMin; true; loopEntry++) {
+      if(loopEntry >= entryMax || !var->getTreeEntry(loopEntry)) breakLoop = true;
+
+      if((var->GetCntr("nObj")+1 % nObjectsToWrite == 0) || breakLoop) var->printCntr(aChainName,Log::DEBUG);
+      if(breakLoop) break;
+      
+      double zTrg = var->GetVarF(zTrgHdl);
+      for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+        if(!regValHdlV[nMLMnow].isValid()) continue;
+
+        double weightNow = var->GetVarF(regWgtHdlV[nMLMnow]); if(weightNow < EPS)  continue;
+        double regValNow = var->GetVarF(regValHdlV[nMLMnow]);
+        int    zRegBinN  = getBinZ(regValNow,zClos_binL);  if(zRegBinN < 0)     continue;
+
+        double sclBias(regValNow-zTrg);
+        if(optimWithSclBias) {
+          double denom = 1 + zTrg;
+          if(fabs(denom) < EPS) sclBias  = DefOpts::DefF;
+          else                  sclBias /= denom;
+        }
+
+        sumWeightsBin[zRegBinN] += weightNow;
+        closS[nMLMnow][zRegBinN].Fill(sclBias,weightNow);
+
+        if(nMLMnow == 0) var->IncCntr("nObj with [weight > 0]");
       }
 
-      sumWeightsBin[zRegBinN] += weightNow;
-      closH[nMLMnow][zRegBinN]->Fill(sclBias,weightNow);
+      var->IncCntr("nObj");
+    }
 
-      if(nMLMnow == 0) var->IncCntr("nObj with [weight > 0]");
+    DELNULL(var);
+  };
+
+  // -----------------------------------------------------------------------------------------------------------
+  // loop on the tree
+  // -----------------------------------------------------------------------------------------------------------
+  if(nThreadsNow == 1) {
+    fillClosureSketches(0,aChain,utils,0,nEntriesChain);
+  }
+  else {
+    aLOG(Log::INFO) <<coutBlue<<" - will loop over "<<coutYellow<<nEntriesChain<<coutBlue<<" objects using "
+                    <<coutYellow<<nThreadsNow<<coutBlue<<" threads ..."<<coutDef<<endl;
+
+    vector <TChain*> loopChainV(nThreadsNow,NULL);
+    vector <Utils*>  utilsV    (nThreadsNow,NULL);
+
+    ThreadPool * threadPool = new ThreadPool(nThreadsNow);
+    for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+      utilsV    [nThreadNow] = (nThreadNow == 0) ? utils  : new Utils(glob);
+      loopChainV[nThreadNow] = (nThreadNow == 0) ? aChain : utils->cloneChain(aChain);
+
+      Long64_t nEntriesThread = nEntriesChain / nThreadsNow;
+      Long64_t nEntriesExtra  = nEntriesChain % nThreadsNow;
+      Long64_t entryMin       = nThreadNow * nEntriesThread + min((Long64_t)nThreadNow,nEntriesExtra);
+      Long64_t entryMax       = entryMin + nEntriesThread + ((nThreadNow < nEntriesExtra) ? 1 : 0);
+
+      TChain * loopChain = loopChainV[nThreadNow];
+      Utils  * utilsNow  = utilsV    [nThreadNow];
+      threadPool->push([&fillClosureSketches,nThreadNow,loopChain,utilsNow,entryMin,entryMax]() {
+        fillClosureSketches(nThreadNow,loopChain,utilsNow,entryMin,entryMax);
+      });
     }
+    threadPool->wait();
+    DELNULL(threadPool);
 
-    var->IncCntr("nObj"); if(var->GetCntr("nObj") == maxNobj) breakLoop = true;
+    for(int nThreadNow=1; nThreadNow<nThreadsNow; nThreadNow++) {
+      DELNULL(loopChainV[nThreadNow]); DELNULL(utilsV[nThreadNow]);
+    }
+  }
+
+  // merge the sketches and weights of all threads into those of the first one
+  vector < double >               & sumWeightsBin = sumWeightsBinV[0];
+  vector < vector <QuantSketch> > & closS         = closSV        [0];
+  for(int nThreadNow=1; nThreadNow<nThreadsNow; nThreadNow++) {
+    for(int nBinNow=0; nBinNow<nBinsZ; nBinNow++) sumWeightsBin[nBinNow] += sumWeightsBinV[nThreadNow][nBinNow];
+
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+      for(int nBinNow=0; nBinNow<(int)closS[nMLMnow].size(); nBinNow++) {
+        closS[nMLMnow][nBinNow].Merge(closSV[nThreadNow][nMLMnow][nBinNow]);
+      }
+    }
+    closSV[nThreadNow].clear();
   }
-  if(!breakLoop) { var->printCntr(aChainName,Log::DEBUG); }
 
   // ----------------------------------------------------------------------------------------------------------- 
   // calculate average metrics over MLMs for each of the Z-bins (0 <= nBinNow < nBinsZ) and over all bins of
@@ -469,7 +549,7 @@ void  ANNZ::fillColosureV(
       utils->param->clearAll();
       utils->param->NewOptB("doFracLargerSigma" , true);
       utils->param->NewOptB("getMAD"            , optimWithMAD);
-      int hasQnt = utils->getInterQuantileStats(closH[nMLMnow][nBinNow]);
+      int hasQnt = utils->getInterQuantileStats(&(closS[nMLMnow][nBinNow]));
 
       // if the calculation disnt go through (no entries) then the currect metrics are all negative
       if(hasQnt) {
@@ -486,8 +566,6 @@ void  ANNZ::fillColosureV(
         mean_fracSig68_2 += sumWeightsBin[nBinNow] * quant_fracSig68_2;  
         mean_fracSig68_3 += sumWeightsBin[nBinNow] * quant_fracSig68_3;
 
-        // cout << closH[nMLMnow][nBinNow]->GetName()<<CT<< optimWithMAD <<CT<<quantScatterName <<CT
-        //      <<utils->param->GetOptF(quantScatterName) <<CT<<utils->param->GetOptF("quant_sigma_68")<<endl;
       }
       // store the metrics in each Zbin
       zRegQnt_nANNZ    [nBinNow].push_back(nMLMnow);
@@ -513,13 +591,7 @@ void  ANNZ::fillColosureV(
   aLOG(Log::INFO) <<coutCyan<<" ------------------------------------------------------------------------------------------------- "<<coutDef<<endl;
 
   // cleanup
-  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-    TString MLMname = getTagName(nMLMnow); if(mlmSkip[MLMname]) continue;
-   
-    for(int nBinNow=0; nBinNow<nBinsZ; nBinNow++) DELNULL(closH[nMLMnow][nBinNow]);
-  }
-  closH.clear(); sumWeightsBin.clear();
-  DELNULL(var);
+  closSV.clear(); sumWeightsBinV.clear();
 
   return;
 }
@@ -1272,6 +1344,58 @@ void  ANNZ::getRndMethodBestPDF(
   var_1 = new VarMaps(glob,utils,(TString)"vars_"+intgrZtreeName);
   var_1->connectTreeBranches(intgrZchain);
 
+  // -----------------------------------------------------------------------------------------------------------
+  // store the integral-metric of the accepted MLMs in a matrix with one column per MLM (see PdfOptim)
+  // -----------------------------------------------------------------------------------------------------------
+  PdfOptim * optim = new PdfOptim();
+
+  optim->nPDFbins         = nPDFbins;
+  optim->nOptimLoops      = nOptimLoops;
+  optim->maxOptimTries    = maxOptimTries;
+  optim->nSameWeightsMax  = nSameWeightsMax;
+  optim->nNoUpdateMax     = nNoUpdateMax;
+  optim->fracWeightUpdate = fracWeightUpdate;
+  optim->avgIntgrZ        = 0.5;
+  optim->excRange         = excRange;
+
+  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+    TString MLMname = getTagName(nMLMnow);
+    if(!mlmSkipPdf[MLMname]) optim->colMLMv.push_back(nMLMnow);
+  }
+  int nWgtsIn = (int)optim->colMLMv.size();
+  if     (nWgtsIn < 10) optim->nRnds0 = 1;
+  else if(nWgtsIn < 20) optim->nRnds0 = 5;
+  else if(nWgtsIn < 40) optim->nRnds0 = 10;
+  else                  optim->nRnds0 = floor(nWgtsIn * 0.2);
+
+  vector < float > intgrZrowV;
+  for(Long64_t loopEntry=0; true; loopEntry++) {
+    if(!var_1->getTreeEntry(loopEntry)) break;
+
+    double zTrg       = var_1->GetVarF(zTrgName);
+    int    nPdfBinNow = getBinZ(zTrg, zPDF_binL);  if(nPdfBinNow < 0) continue;
+
+    optim->trgV.push_back(zTrg);
+    optim->wgtV.push_back(var_1->GetVarF("eventWeight"));
+    optim->binV.push_back(nPdfBinNow);
+
+    for(int nColNow=0; nColNow<nWgtsIn; nColNow++) {
+      intgrZrowV.push_back(var_1->GetVarF(getTagName(optim->colMLMv[nColNow])));
+    }
+  }
+  optim->nObj = (int)optim->binV.size();
+
+  optim->intgrZmat.resize(intgrZrowV.size());
+  for(int nObjNow=0; nObjNow<optim->nObj; nObjNow++) {
+    for(int nColNow=0; nColNow<nWgtsIn; nColNow++) {
+      optim->intgrZmat[nColNow * optim->nObj + nObjNow] = intgrZrowV[nObjNow * nWgtsIn + nColNow];
+    }
+  }
+  intgrZrowV.clear();
+
+  aLOG(Log::DEBUG) <<coutGreen<<" - stored the integral-metric of "<<coutYellow<<optim->nObj<<coutGreen
+                   <<" objects for "<<coutYellow<<nWgtsIn<<coutGreen<<" MLMs ..."<<coutDef<<endl;
+
   TFile    * rootSaveFile(NULL);
   TProfile * hisIntgrZmlm(NULL);
   if(saveProfileHis) {
@@ -1285,176 +1409,113 @@ void  ANNZ::getRndMethodBestPDF(
     rootSaveFile = new TFile(rootFileName,"RECREATE");
   }
 
-  if(seed > 0) { seed++; } rnd = new TRandom3(seed);
-
   // -----------------------------------------------------------------------------------------------------------
-  // perform the random walk alg
+  // perform the random walk alg, using nWalkers independent walkers. The walkers run in parallel for
+  // nLoopsExchange steps at a time, after which the best solution of all walkers is shared between them. The
+  // seed of each walker only depends on its index, so that the result does not depend on the number of threads
   // -----------------------------------------------------------------------------------------------------------
-  double            avgIntgrZ(0.5);
-  int               nNoUpdate(0), nSameWeights(0);
-  double            varIntgrBest(std::numeric_limits<double>::max()), varIntgrPrev(varIntgrBest);
-  vector < double > weightsNow(weightV), weightsPrev(weightV),
-                    weightsClipped, weightsBest, intgrZ_valV, intgrZmlm_nEvtV;
+  int nThreads       = ThreadPool::getNumThreads(glob->GetOptI("nThreads"));
+  int nWalkers       = glob->GetOptI("nOptimWalkersPDF"); if(nWalkers <= 0) nWalkers = nThreads;
+  int nThreadsNow    = min(nThreads,nWalkers);
+  int nLoopsExchange = 50;
 
-  vector < int > updateIndexV;
-  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-    TString MLMname = getTagName(nMLMnow);
-    if(!mlmSkipPdf[MLMname]) updateIndexV.push_back(nMLMnow);
-  }
-  vector < int >::iterator indexItr = updateIndexV.begin();
-  int nWgtsIn = updateIndexV.size();
-  int nRnds0(0);
-  if     (nWgtsIn < 10) nRnds0 = 1;
-  else if(nWgtsIn < 20) nRnds0 = 5;
-  else if(nWgtsIn < 40) nRnds0 = 10;
-  else                  nRnds0 = floor(nWgtsIn * 0.2);
-
-  for(int nLoopNow=0; nLoopNow<nOptimLoops; nLoopNow++) {
-    bool canPrint(false);
-    if     (nLoopNow < 10)                        canPrint = true;
-    else if(nLoopNow < 100  && nLoopNow%10  == 0) canPrint = true;
-    else if(nLoopNow < 500  && nLoopNow%20  == 0) canPrint = true;
-    else if(nLoopNow < 1000 && nLoopNow%50  == 0) canPrint = true;
-    else if(                   nLoopNow%100 == 0) canPrint = true;
+  if(seed > 0) { seed++; }
 
-    intgrZ_valV.resize(nPDFbins,0); intgrZmlm_nEvtV.resize(nPDFbins,0);
+  vector < PdfOptim::Walker* > walkerV(nWalkers,NULL);
+  for(int nWalkerNow=0; nWalkerNow<nWalkers; nWalkerNow++) {
+    PdfOptim::Walker * walker = new PdfOptim::Walker();
 
-    if(canPrint && saveProfileHis) hisIntgrZmlm->Reset();
+    // the first walker follows the same sequence of random numbers as a single-walker optimization
+    walker->rnd         = new TRandom3((nWalkerNow == 0) ? seed : utils->getSeedForIndex(seed,nWalkerNow));
+    walker->weightsNow  = weightV;
+    walker->weightsPrev = weightV;
 
-    // -----------------------------------------------------------------------------------------------------------
-    // clip any weights smaller than minPdfWeight, so long as at least minAcptMLMsForPDFs MLMs remain
-    // -----------------------------------------------------------------------------------------------------------
-    weightsClipped = clipWeightsPDF(weightsNow, Log::DEBUG_2);
+    walkerV[nWalkerNow] = walker;
+  }
 
-    // -----------------------------------------------------------------------------------------------------------
-    // calculate the optimization metric for this set of PDF weights from the entire dataset
-    // -----------------------------------------------------------------------------------------------------------
-    for(Long64_t loopEntry=0; true; loopEntry++) {
-      if(!var_1->getTreeEntry(loopEntry)) break;
+  aLOG(Log::INFO) <<coutGreen<<" - starting the PDF optimization with "<<coutYellow<<nWalkers<<coutGreen<<" walkers and "
+                  <<coutYellow<<nThreadsNow<<coutGreen<<" threads ..."<<coutDef<<endl;
 
-      double zTrg        = var_1->GetVarF(zTrgName);
-      double eventWeight = var_1->GetVarF("eventWeight");
-      int    nPdfBinNow  = getBinZ(zTrg, zPDF_binE);  if(nPdfBinNow < 0) continue;
+  TStopwatch        optimTimer;
+  int               nEvalsBest(0);
+  double            varIntgrBest(std::numeric_limits<double>::max()), timeBest(0);
+  vector < double > weightsBest(weightV);
 
-      double intgrZ(0);
-      for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-        TString MLMname = getTagName(nMLMnow); if(mlmSkipPdf[MLMname]) continue;
-        
-        double intgrZmlm = var_1->GetVarF(MLMname);
-        intgrZ += intgrZmlm * weightsClipped[nMLMnow];
+  for(int nExchangeNow=0; true; nExchangeNow++) {
+    if(nThreadsNow == 1) {
+      for(int nWalkerNow=0; nWalkerNow<nWalkers; nWalkerNow++) {
+        rndWalkPdfWeights(optim,walkerV[nWalkerNow],nLoopsExchange,(nWalkers == 1));
       }
-
-      if(intgrZ >= excRange[0] && intgrZ <= excRange[1]) {
-        if(canPrint && saveProfileHis) hisIntgrZmlm->Fill(zTrg,intgrZ,eventWeight);
-
-        intgrZ_valV    [nPdfBinNow] += intgrZ * eventWeight;
-        intgrZmlm_nEvtV[nPdfBinNow] += eventWeight;
+    }
+    else {
+      ThreadPool * threadPool = new ThreadPool(nThreadsNow);
+      for(int nWalkerNow=0; nWalkerNow<nWalkers; nWalkerNow++) {
+        PdfOptim::Walker * walker = walkerV[nWalkerNow];
+        threadPool->push([this,optim,walker,nLoopsExchange]() {
+          rndWalkPdfWeights(optim,walker,nLoopsExchange,false);
+        });
       }
+      threadPool->wait();
+      DELNULL(threadPool);
     }
 
-    // -----------------------------------------------------------------------------------------------------------
-    // derive the final metric as the RMS around avgIntgrZ
-    // -----------------------------------------------------------------------------------------------------------
-    double varIntgrNow(0), nBinsIn(0);
-    for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-      if(intgrZmlm_nEvtV[nPdfBinNow] < EPS) continue;
+    // find the best solution of all walkers (the lowest index is chosen for equal metrics)
+    int  nWalkerBest(-1), nEvals(0);
+    bool isDone(true);
+    for(int nWalkerNow=0; nWalkerNow<nWalkers; nWalkerNow++) {
+      PdfOptim::Walker * walker = walkerV[nWalkerNow];
 
-      double intgrZ = intgrZ_valV[nPdfBinNow]/intgrZmlm_nEvtV[nPdfBinNow];
-      varIntgrNow += pow((intgrZ - avgIntgrZ), 2);
+      nEvals += walker->nEvals;
+      if(!walker->isDone) isDone = false;
 
-      nBinsIn++;
+      if(walker->varIntgrBest < varIntgrBest) { varIntgrBest = walker->varIntgrBest; nWalkerBest = nWalkerNow; }
     }
-    varIntgrNow = (varIntgrNow > EPS) ? sqrt(varIntgrNow/nBinsIn) : 0;
-    
-    // check if the current solution is better then the previous one (or the best so far)
-    bool isBest   = varIntgrNow < varIntgrBest;
-    bool isBetter = varIntgrNow < varIntgrPrev;
-    
-    bool canPrintNew(false);
-    if(isBest) {
-      if(varIntgrBest < EPS) canPrintNew = true;
-      else                   canPrintNew = ((varIntgrBest - varIntgrNow)/varIntgrBest > 0.01);
+
+    double timeNow = optimTimer.RealTime(); optimTimer.Continue();
+    if(nWalkerBest >= 0) {
+      weightsBest = walkerV[nWalkerBest]->weightsBest;
+      nEvalsBest  = nEvals;
+      timeBest    = timeNow;
     }
-    
-    // -----------------------------------------------------------------------------------------------------------
-    // output for the user to validate that things are going well
-    // -----------------------------------------------------------------------------------------------------------
-    if(canPrint || canPrintNew) {
-      weightMsg = "";
-      for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) { 
-        TString MLMname = getTagName(nMLMnow); if(mlmSkipPdf[MLMname]) continue;
-        weightMsg += coutBlue+MLMname+":"+coutPurple+utils->floatToStr(weightsClipped[nMLMnow],"%1.3f")+" ";
-      }
 
-      TString msgHead = (TString)(isBest ? " - NEW:  " : " - nTry: ");
-      TString msgCol  = (TString)(isBest ? coutGreen : coutYellow);
-      aLOG(Log::INFO) <<msgCol<<msgHead<<coutPurple<<nLoopNow
-                      <<msgCol<<" - min-param best/prev/now: "<<coutBlue<< utils->floatToStr(varIntgrBest,"%1.5e")
-                      <<msgCol<<" / "<<coutRed<< utils->floatToStr(varIntgrPrev,"%1.5e")
-                      <<msgCol<<" / "<<coutBlue<< utils->floatToStr(varIntgrNow,"%1.5e")
-                      <<msgCol<<(TString)(inLOG(Log::DEBUG_2)?" , PDF: ":"")
-                      <<(TString)(inLOG(Log::DEBUG_2)?weightMsg:"")<<coutDef<<endl;
+    // share the best solution, such that each walker returns to it when it does not improve for a while
+    if(nWalkers > 1) {
+      for(int nWalkerNow=0; nWalkerNow<nWalkers; nWalkerNow++) {
+        PdfOptim::Walker * walker = walkerV[nWalkerNow];
+        if(walker->isDone || walker->varIntgrBest <= varIntgrBest) continue;
 
-      if(canPrint && saveProfileHis) {      
-        hisIntgrZmlm->SetTitle((TString)(TString)"RMS[C("+zTrgTitle+")] = "+utils->floatToStr(varIntgrNow,"%1.5e"));
-        hisIntgrZmlm->Write((TString)hisIntgrZmlm->GetName()+"_"+utils->intToStr(nLoopNow));
+        walker->varIntgrBest = varIntgrBest;
+        walker->weightsBest  = weightsBest;
       }
-    }
 
-    // -----------------------------------------------------------------------------------------------------------
-    // update the best weights if needed
-    // -----------------------------------------------------------------------------------------------------------
-    if(isBest) {
-      varIntgrBest = varIntgrNow;
-      weightsBest  = weightsNow;
-      nSameWeights = 0;
+      aLOG(Log::DEBUG) <<coutYellow<<" - exchange "<<coutPurple<<nExchangeNow<<coutYellow<<" - time: "<<coutBlue
+                       <<utils->floatToStr(timeNow,"%1.2f")<<coutYellow<<" sec , evaluations: "<<coutBlue<<nEvals
+                       <<coutYellow<<" , min-param best: "<<coutGreen<<utils->floatToStr(varIntgrBest,"%1.5e")<<coutDef<<endl;
     }
-    else nSameWeights++;
-    
-    // -----------------------------------------------------------------------------------------------------------
-    // go back to the best solution if there has been no improvement for a while
-    // finish if there has been no improvement for a long time
-    // -----------------------------------------------------------------------------------------------------------
-    if(nSameWeights % nSameWeightsMax == 0) weightsPrev = weightsBest;
-    if(nSameWeights >= maxOptimTries) break;
 
-    // -----------------------------------------------------------------------------------------------------------
-    // continue with this set of weights if the result is better, or if forceUpdate
-    // -----------------------------------------------------------------------------------------------------------
-    bool forceUpdate = (nNoUpdate >= nNoUpdateMax) || (rnd->Rndm() < fracWeightUpdate);
-    if(isBetter || forceUpdate) {
-      nNoUpdate    = 0;
-      weightsPrev  = weightsNow;
-      varIntgrPrev = varIntgrNow;
-    }
-    else {
-      nNoUpdate++;
-      weightsNow = weightsPrev;
+    if(isDone) {
+      double evalRate = (timeNow > EPS) ? nEvals/timeNow : 0;
+      aLOG(Log::INFO) <<coutGreen<<" - PDF optimization took "<<coutYellow<<utils->floatToStr(timeNow,"%1.2f")<<coutGreen
+                      <<" sec for "<<coutYellow<<nEvals<<coutGreen<<" evaluations ("<<coutYellow
+                      <<utils->floatToStr(evalRate,"%1.1f")<<coutGreen<<"/sec); the final solution was found after "
+                      <<coutYellow<<utils->floatToStr(timeBest,"%1.2f")<<coutGreen<<" sec ("<<coutYellow<<nEvalsBest
+                      <<coutGreen<<" evaluations) ..."<<coutDef<<endl;
+      break;
     }
+  }
 
-    // -----------------------------------------------------------------------------------------------------------
-    // change one or more of the weights for the next iteration
-    // -----------------------------------------------------------------------------------------------------------
-    int nRnds(nRnds0);
-    if(rnd->Rndm() < 0.5) {
-      nRnds = max(nWgtsIn, nRnds + int(ceil(0.2 * rnd->Rndm() * nWgtsIn)));
-    }
-    for(int nRndNow=0; nRndNow<nRnds; nRndNow++) {
-      while(true) {
-        weightsNow[*indexItr] += 0.05 * (2*rnd->Rndm() - 1);
-        if(weightsNow[*indexItr] >= 0) break;
-      }
-      
-      indexItr++;
-      if(indexItr == updateIndexV.end()) { indexItr = updateIndexV.begin(); }
-    }
+  if(saveProfileHis) {
+    vector < double > weightsClipped = clipWeightsPDF(weightsBest, Log::DEBUG_2);
+    double            varIntgrNow    = optim->getMetric(weightsClipped,hisIntgrZmlm);
 
-    // normalize the new weights
-    double sumWeights(0);
-    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) { sumWeights += weightsNow[nMLMnow]; }
-    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) { weightsNow[nMLMnow] /= sumWeights; }
+    hisIntgrZmlm->SetTitle((TString)(TString)"RMS[C("+zTrgTitle+")] = "+utils->floatToStr(varIntgrNow,"%1.5e"));
+    hisIntgrZmlm->Write((TString)hisIntgrZmlm->GetName()+"_"+utils->intToStr(nEvalsBest));
   }
 
+  for(int nWalkerNow=0; nWalkerNow<nWalkers; nWalkerNow++) DELNULL(walkerV[nWalkerNow]);
+  walkerV.clear();
+  DELNULL(optim);
+
 
   // -----------------------------------------------------------------------------------------------------------
   // clip any weights smaller than minPdfWeight, so long as at least minAcptMLMsForPDFs MLMs remain
@@ -1487,7 +1548,6 @@ void  ANNZ::getRndMethodBestPDF(
 
   // cleanup
   DELNULL(var_1); DELNULL(intgrZchain);
-  DELNULL(rnd);
 
   // -----------------------------------------------------------------------------------------------------------
   // loop over the original input trees to calculate the bias correction for the final pdf
@@ -1507,7 +1567,8 @@ void  ANNZ::getRndMethodBestPDF(
       var_0->IncCntr("nObj"); if(var_0->GetCntr("nObj") == maxNobj) breakLoop = true;
 
       // get the target value and smear the reg-value of the best MLM
-      double zTrg = var_0->GetVarF(zTrgName);
+      double zTrg       = var_0->GetVarF(zTrgName);
+      int    nBinTrgHis = zPDF_binL.GetHisBin(zTrg); // histogram bin of the target (the bin search of TH2F::Fill() is not used)
 
       // loop over all MLMs
       for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
@@ -1528,7 +1589,7 @@ void  ANNZ::getRndMethodBestPDF(
           double zReg       = regNow + sfNow;
           double weightFull = weightsBest[nMLMnow] * weightNow;
 
-          hisPdfTryBiasCorV->Fill(zReg,zTrg,weightFull);
+          utils->fillHisBin(hisPdfTryBiasCorV,hisPdfTryBiasCorV->GetBin(zPDF_binL.GetHisBin(zReg),nBinTrgHis),weightFull);
         }
       }
     }
@@ -1558,10 +1619,8 @@ void  ANNZ::getRndMethodBestPDF(
   }
 
   sigm68V.clear();    biasV.clear();       sigmToBiasV.clear();
-  weightV.clear();    mlmSkipPdf.clear();  updateIndexV.clear();
-  weightsNow.clear(); weightsPrev.clear(); weightsBest.clear();
-  excRange.clear();   intgrZ_valV.clear(); intgrZmlm_nEvtV.clear();
-  tmpWeightV.clear(); weightsClipped.clear();
+  weightV.clear();    mlmSkipPdf.clear();  weightsBest.clear();
+  excRange.clear();   tmpWeightV.clear();
 
   // -----------------------------------------------------------------------------------------------------------
   // call the old-style pdf function if needed
@@ -1689,6 +1748,208 @@ vector < double >  ANNZ::clipWeightsPDF(vector < double > & weightsIn, Log::LOGt
 }
 
 
+// ===========================================================================================================
+/**
+ * @brief             - Perform up to nLoopsMax steps of the random walk alg for the PDF weights, for one walker.
+ * 
+ * @details           - The state of the walker is kept between calls, so that consecutive calls continue
+ *                    the same random walk. The walker is done after optim->nOptimLoops steps, or after
+ *                    optim->maxOptimTries consecutive steps without improvement.
+ *                           
+ * @param optim       - The data for the optimization, which is not modified.
+ * @param walker      - The walker, holding the current/previous/best weights and a random number generator.
+ * @param nLoopsMax   - The maximal number of steps to perform in this call.
+ * @param canLog      - Whether to print the progress of the walker (should only be set for a single walker).
+ */
+// ===========================================================================================================
+void ANNZ::rndWalkPdfWeights(PdfOptim * optim, PdfOptim::Walker * walker, int nLoopsMax, bool canLog) {
+// ===========================================================================================================
+  int               nMLMs   = glob->GetOptI("nMLMs");
+  int               nWgtsIn = (int)optim->colMLMv.size();
+  vector < double > & weightsNow(walker->weightsNow);
+
+  for(int nStepNow=0; nStepNow<nLoopsMax; nStepNow++) {
+    if(walker->isDone) break;
+
+    int  nLoopNow = walker->nLoops;
+    bool canPrint(false);
+    if(canLog) {
+      if     (nLoopNow < 10)                        canPrint = true;
+      else if(nLoopNow < 100  && nLoopNow%10  == 0) canPrint = true;
+      else if(nLoopNow < 500  && nLoopNow%20  == 0) canPrint = true;
+      else if(nLoopNow < 1000 && nLoopNow%50  == 0) canPrint = true;
+      else if(                   nLoopNow%100 == 0) canPrint = true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // clip any weights smaller than minPdfWeight, so long as at least minAcptMLMsForPDFs MLMs remain, and
+    // calculate the optimization metric for this set of PDF weights from the entire dataset
+    // -----------------------------------------------------------------------------------------------------------
+    vector < double > weightsClipped = clipWeightsPDF(weightsNow, (canLog ? Log::DEBUG_2 : Log::DEBUG_3));
+    double            varIntgrNow    = optim->getMetric(weightsClipped);
+
+    walker->nEvals++;
+
+    // check if the current solution is better then the previous one (or the best so far)
+    bool isBest   = varIntgrNow < walker->varIntgrBest;
+    bool isBetter = varIntgrNow < walker->varIntgrPrev;
+    
+    bool canPrintNew(false);
+    if(isBest && canLog) {
+      if(walker->varIntgrBest < EPS) canPrintNew = true;
+      else                           canPrintNew = ((walker->varIntgrBest - varIntgrNow)/walker->varIntgrBest > 0.01);
+    }
+    
+    // -----------------------------------------------------------------------------------------------------------
+    // output for the user to validate that things are going well
+    // -----------------------------------------------------------------------------------------------------------
+    if(canPrint || canPrintNew) {
+      TString weightMsg("");
+      for(int nColNow=0; nColNow<nWgtsIn; nColNow++) {
+        int nMLMnow = optim->colMLMv[nColNow];
+        weightMsg += coutBlue+getTagName(nMLMnow)+":"+coutPurple+utils->floatToStr(weightsClipped[nMLMnow],"%1.3f")+" ";
+      }
+
+      TString msgHead = (TString)(isBest ? " - NEW:  " : " - nTry: ");
+      TString msgCol  = (TString)(isBest ? coutGreen : coutYellow);
+      aLOG(Log::INFO) <<msgCol<<msgHead<<coutPurple<<nLoopNow
+                      <<msgCol<<" - min-param best/prev/now: "<<coutBlue<< utils->floatToStr(walker->varIntgrBest,"%1.5e")
+                      <<msgCol<<" / "<<coutRed<< utils->floatToStr(walker->varIntgrPrev,"%1.5e")
+                      <<msgCol<<" / "<<coutBlue<< utils->floatToStr(varIntgrNow,"%1.5e")
+                      <<msgCol<<(TString)(inLOG(Log::DEBUG_2)?" , PDF: ":"")
+                      <<(TString)(inLOG(Log::DEBUG_2)?weightMsg:"")<<coutDef<<endl;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // update the best weights if needed
+    // -----------------------------------------------------------------------------------------------------------
+    if(isBest) {
+      walker->varIntgrBest = varIntgrNow;
+      walker->weightsBest  = weightsNow;
+      walker->nSameWeights = 0;
+    }
+    else walker->nSameWeights++;
+    
+    walker->nLoops++;
+
+    // -----------------------------------------------------------------------------------------------------------
+    // go back to the best solution if there has been no improvement for a while
+    // finish if there has been no improvement for a long time
+    // -----------------------------------------------------------------------------------------------------------
+    if(walker->nSameWeights % optim->nSameWeightsMax == 0) walker->weightsPrev = walker->weightsBest;
+    if(walker->nSameWeights >= optim->maxOptimTries || walker->nLoops >= optim->nOptimLoops) {
+      walker->isDone = true;
+      break;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // continue with this set of weights if the result is better, or if forceUpdate
+    // -----------------------------------------------------------------------------------------------------------
+    bool forceUpdate = (walker->nNoUpdate >= optim->nNoUpdateMax) || (walker->rnd->Rndm() < optim->fracWeightUpdate);
+    if(isBetter || forceUpdate) {
+      walker->nNoUpdate    = 0;
+      walker->weightsPrev  = weightsNow;
+      walker->varIntgrPrev = varIntgrNow;
+    }
+    else {
+      walker->nNoUpdate++;
+      weightsNow = walker->weightsPrev;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // change one or more of the weights for the next iteration
+    // -----------------------------------------------------------------------------------------------------------
+    int nRnds(optim->nRnds0);
+    if(walker->rnd->Rndm() < 0.5) {
+      nRnds = max(nWgtsIn, nRnds + int(ceil(0.2 * walker->rnd->Rndm() * nWgtsIn)));
+    }
+    for(int nRndNow=0; nRndNow<nRnds; nRndNow++) {
+      int nMLMnow = optim->colMLMv[walker->nIndexNow];
+      while(true) {
+        weightsNow[nMLMnow] += 0.05 * (2*walker->rnd->Rndm() - 1);
+        if(weightsNow[nMLMnow] >= 0) break;
+      }
+      
+      walker->nIndexNow++;
+      if(walker->nIndexNow == nWgtsIn) walker->nIndexNow = 0;
+    }
+
+    // normalize the new weights
+    double sumWeights(0);
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) { sumWeights += weightsNow[nMLMnow]; }
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) { weightsNow[nMLMnow] /= sumWeights; }
+  }
+
+  return;
+}
+
+
+// ===========================================================================================================
+/**
+ * @brief             - Calculate the optimization metric of the random walk alg for a given set of PDF weights.
+ * 
+ * @details           - The weighted sum of the integral-metric of the MLMs is accumulated for blocks of
+ *                    nBlockObj objects, where the inner loop runs over the objects of a block, so that it may be
+ *                    vectorised. The metric is the RMS around avgIntgrZ of the average (weighted sum) in each PDF bin.
+ *                           
+ * @param weightsIn   - The PDF weights (one for each MLM, including MLMs which are not in colMLMv).
+ * @param hisIntgrZ   - Optional profile histogram, which is filled with the weighted sum as a function of the target.
+ */
+// ===========================================================================================================
+double PdfOptim::getMetric(vector < double > & weightsIn, TProfile * hisIntgrZ) {
+// ===========================================================================================================
+  const int nBlockObj(256);
+  int       nCols = (int)colMLMv.size();
+  double    intgrZblock[nBlockObj];
+
+  vector < double > intgrZ_valV(nPDFbins,0), intgrZmlm_nEvtV(nPDFbins,0);
+
+  for(int nObjBlock=0; nObjBlock<nObj; nObjBlock+=nBlockObj) {
+    int nBlockNow = min(nBlockObj, nObj - nObjBlock);
+
+    for(int nObjNow=0; nObjNow<nBlockNow; nObjNow++) intgrZblock[nObjNow] = 0;
+
+    // the columns are summed in the same order for each object, so that the result is the same as for a
+    // loop over the MLMs of each object
+    for(int nColNow=0; nColNow<nCols; nColNow++) {
+      double        weightNow = weightsIn[colMLMv[nColNow]];
+      const float * colNow    = &(intgrZmat[(size_t)nColNow * nObj + nObjBlock]);
+
+      for(int nObjNow=0; nObjNow<nBlockNow; nObjNow++) intgrZblock[nObjNow] += colNow[nObjNow] * weightNow;
+    }
+
+    for(int nObjNow=0; nObjNow<nBlockNow; nObjNow++) {
+      double intgrZ = intgrZblock[nObjNow];
+      if(intgrZ < excRange[0] || intgrZ > excRange[1]) continue;
+
+      int    nPdfBinNow  = binV[nObjBlock + nObjNow];
+      double eventWeight = wgtV[nObjBlock + nObjNow];
+
+      if(hisIntgrZ) hisIntgrZ->Fill(trgV[nObjBlock + nObjNow],intgrZ,eventWeight);
+
+      intgrZ_valV    [nPdfBinNow] += intgrZ * eventWeight;
+      intgrZmlm_nEvtV[nPdfBinNow] += eventWeight;
+    }
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // derive the final metric as the RMS around avgIntgrZ
+  // -----------------------------------------------------------------------------------------------------------
+  double varIntgrNow(0), nBinsIn(0);
+  for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+    if(intgrZmlm_nEvtV[nPdfBinNow] < EPS) continue;
+
+    double intgrZ = intgrZ_valV[nPdfBinNow]/intgrZmlm_nEvtV[nPdfBinNow];
+    varIntgrNow += pow((intgrZ - avgIntgrZ), 2);
+
+    nBinsIn++;
+  }
+  varIntgrNow = (varIntgrNow > EPS) ? sqrt(varIntgrNow/nBinsIn) : 0;
+
+  return varIntgrNow;
+}
+
+
 // ===========================================================================================================
 /**
  * @brief                    - Generate PDF weighting schemes for randomized regression.
@@ -2164,11 +2425,12 @@ void  ANNZ::getOldStyleRndMethodBestPDF(
     var->IncCntr("nObj"); if(var->GetCntr("nObj") == maxNobj) breakLoop = true;
 
     // get the target value and smear the reg-value of the best MLM
-    double  zTrg     = var->GetVarF(zTrgName);
-    double  zBest    = var->GetVarF(MLMnameBest);
-    double  zBestErr = var->GetVarF(MLMnameBest_e);  if(zBestErr < EPS) continue;
-    double  zBestSF  = rnd->Gaus(0,zBestErr);
-    double  zBestNow = zBest + zBestSF;
+    double  zTrg       = var->GetVarF(zTrgName);
+    int     nBinTrgHis = zPDF_binL.GetHisBin(zTrg); // histogram bin of the target (the bin search of TH2F::Fill() is not used)
+    double  zBest      = var->GetVarF(MLMnameBest);
+    double  zBestErr   = var->GetVarF(MLMnameBest_e);  if(zBestErr < EPS) continue;
+    double  zBestSF    = rnd->Gaus(0,zBestErr);
+    double  zBestNow   = zBest + zBestSF;
 
     // loop over all PDFs
     for(int nPDFnow=0; nPDFnow<nTryPDFs; nPDFnow++) {
@@ -2203,7 +2465,9 @@ void  ANNZ::getOldStyleRndMethodBestPDF(
           zPdfAvg += weightFull * zReg;
           zPdfWgt += weightFull;
 
-          if(doBiasCorPDF) hisPdfTryBiasCorV[nPDFnow]->Fill(zReg,zTrg,weightFull);
+          if(doBiasCorPDF) {
+            utils->fillHisBin(hisPdfTryBiasCorV[nPDFnow],hisPdfTryBiasCorV[nPDFnow]->GetBin(zPDF_binL.GetHisBin(zReg),nBinTrgHis),weightFull);
+          }
         }
       }
       if(zPdfWgt < EPS) break; // no need to go on with all PDFs - this object must has zero weights
@@ -2847,7 +3111,8 @@ void  ANNZ::getBinClsBiasCorPDF(TChain * aChain, vector <TH2*>  & hisPdfBiasCorV
     if((var->GetCntr("nObj")+1 % nObjectsToWrite == 0) || breakLoop) var->printCntr(aChainName,Log::DEBUG);
     if(breakLoop) break;
 
-    double zTrg = var->GetVarF(zTrgName);
+    double zTrg       = var->GetVarF(zTrgName);
+    int    nBinTrgHis = zPDF_binL.GetHisBin(zTrg); // histogram bin of the target (the bin search of TH2F::Fill() is not used)
 
     for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
       // go over all pdf bins
@@ -2864,7 +3129,8 @@ void  ANNZ::getBinClsBiasCorPDF(TChain * aChain, vector <TH2*>  & hisPdfBiasCorV
           double  clsWgt    = var->GetVarF(MLMname_w);
           double  totWgt    = binVal * binWgt * clsWgt;
 
-          hisPdfBiasCorV[nPDFnow]->Fill(zPDF_binC[nPdfBinNow],zTrg,totWgt);
+          // the histogram bin of zPDF_binC[nPdfBinNow] is (nPdfBinNow+1)
+          utils->fillHisBin(hisPdfBiasCorV[nPDFnow],hisPdfBiasCorV[nPDFnow]->GetBin(nPdfBinNow+1,nBinTrgHis),totWgt);
 
           // generate random smearing factors for one of the PDFs
           // -----------------------------------------------------------------------------------------------------------
@@ -2877,7 +3143,7 @@ void  ANNZ::getBinClsBiasCorPDF(TChain * aChain, vector <TH2*>  & hisPdfBiasCorV
                 double binSmr    = max(min((binVal + sfNow),1.),0.);
                 double totWgtSmr = binSmr * binWgt * clsWgt;
 
-                hisPdfBiasCorV[nPDFnow]->Fill(zPDF_binC[nPdfBinNow],zTrg,totWgtSmr);
+                utils->fillHisBin(hisPdfBiasCorV[nPDFnow],hisPdfBiasCorV[nPDFnow]->GetBin(nPdfBinNow+1,nBinTrgHis),totWgtSmr);
               }
             }
           }
@@ -2949,6 +3215,7 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
   bool    doKnnErrPlots       = glob->GetOptB("doKnnErrPlots");
   int     closHisN            = glob->GetOptI("closHisN");
   int     hisBufSize          = glob->GetOptI("hisBufSize");
+  double  sketchCompression   = glob->GetOptF("quantSketchCompression");
 
   bool    plotWithSclBias     = glob->GetOptB("plotWithScaledBias");
   TString biasTitle           = plotWithSclBias ? (TString)"#delta/(1+"+glob->GetOptC("zTrgTitle")+")" : (TString)"#delta";
@@ -3400,7 +3667,8 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
   vector < TString >                      typeTitleV;
   map < TString,vector <TH1*> >           his_regTrgZ;
   map < TString,TH2* >                    his_corRegTrgZ;
-  map < TString,vector < vector<TH1*> > > his_clos, his_relErr, his_errTrg, his_errReg, his_errRegNP;
+  map < TString,vector < vector<TH1*> > >        his_relErr, his_errTrg, his_errReg, his_errRegNP;
+  map < TString,vector < vector<QuantSketch> > > sketch_clos;
 
   for(int nTypeMLMnow=0; nTypeMLMnow<2; nTypeMLMnow++) {
     int nTypeIn = (nTypeMLMnow == 0) ? nMLMsIn : nPDFsIn;
@@ -3411,7 +3679,7 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
       TString hisTitle     = typeName; hisTitle.ReplaceAll("_"," ");
       typeTitleV.push_back(hisTitle);
 
-      his_clos   [typeName].resize(nTypeBins,vector<TH1*>(nBinsZ+1,NULL));
+      sketch_clos[typeName].resize(nTypeBins,vector<QuantSketch>(nBinsZ+1,QuantSketch(sketchCompression)));
       his_relErr [typeName].resize(nTypeBins,vector<TH1*>(nBinsZ+1,NULL));
       his_regTrgZ[typeName].resize(2,NULL);
       
@@ -3434,7 +3702,7 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
             TString hisNameTag("");
             TH1     * his1(NULL);
 
-            if     (nHisType == 0                 ) hisNameTag = "closHis_";   
+            if     (nHisType == 0                 ) continue; // the closure is accumulated in sketch_clos
             else if(nHisType == 1                 ) hisNameTag = "relErrHis_"; 
             else if(nHisType == 2 && doKnnErrPlots) hisNameTag = "errTrgHis_"; 
             else if(nHisType == 3 && doKnnErrPlots) hisNameTag = "errRegHis_"; 
@@ -3450,8 +3718,7 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
             his1->SetDefaultBufferSize(hisBufSize);
             his1->SetTitle(hisTitle);
 
-            if     (nHisType == 0) his_clos    [typeName][nTypeBinNow][nBinZnow] = his1;
-            else if(nHisType == 1) his_relErr  [typeName][nTypeBinNow][nBinZnow] = his1;
+            if     (nHisType == 1) his_relErr  [typeName][nTypeBinNow][nBinZnow] = his1;
             else if(nHisType == 2) his_errTrg  [typeName][nTypeBinNow][nBinZnow] = his1;
             else if(nHisType == 3) his_errReg  [typeName][nTypeBinNow][nBinZnow] = his1;
             else if(nHisType == 4) his_errRegNP[typeName][nTypeBinNow][nBinZnow] = his1;
@@ -3509,8 +3776,8 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
       for(int nTypeBinNow=0; nTypeBinNow<nTypeBins; nTypeBinNow++) {
         // (nTypeBinNow == 1): bins of the regression value, (nTypeBinNow == 0): bins of the target value
         int nBinZnow(0);
-        if     (nTypeBinNow == 0) nBinZnow = getBinZ(zTrg                                     ,zPlot_binE);
-        else if(nTypeBinNow == 1) nBinZnow = getBinZ(zRegV                                    ,zPlot_binE);
+        if     (nTypeBinNow == 0) nBinZnow = getBinZ(zTrg                                     ,zPlot_binL);
+        else if(nTypeBinNow == 1) nBinZnow = getBinZ(zRegV                                    ,zPlot_binL);
         else                      nBinZnow = getBinZ(var->GetForm(plotVarForms[nTypeBinNow-2]),varPlot_binE[nTypeBinNow-2]);
         if(nBinZnow < 0) continue;
 
@@ -3521,8 +3788,8 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
           else                  sclBias /= denom;
         }
 
-        his_clos[typeName][nTypeBinNow][nBinZnow]->Fill(sclBias , zRegW);
-        his_clos[typeName][nTypeBinNow][nBinsZ]  ->Fill(sclBias , zRegW);
+        sketch_clos[typeName][nTypeBinNow][nBinZnow].Fill(sclBias , zRegW);
+        sketch_clos[typeName][nTypeBinNow][nBinsZ]  .Fill(sclBias , zRegW);
 
         if(zRegE > 0) {
           his_relErr[typeName][nTypeBinNow][nBinZnow]->Fill((zRegV-zTrg)/zRegE , zRegW);
@@ -3572,8 +3839,8 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
         for(int nTypeBinNow=0; nTypeBinNow<nTypeBins; nTypeBinNow++) {
           // (nTypeBinNow == 0): bins of the regression value, (nTypeBinNow == 1): bins of the target value
           int nBinZnow(0);
-          if     (nTypeBinNow == 0) nBinZnow = getBinZ(zTrg                                     ,zPlot_binE);
-          else if(nTypeBinNow == 1) nBinZnow = getBinZ(pdfBinCtr                                ,zPlot_binE);
+          if     (nTypeBinNow == 0) nBinZnow = getBinZ(zTrg                                     ,zPlot_binL);
+          else if(nTypeBinNow == 1) nBinZnow = getBinZ(pdfBinCtr                                ,zPlot_binL);
           else                      nBinZnow = getBinZ(var->GetForm(plotVarForms[nTypeBinNow-2]),varPlot_binE[nTypeBinNow-2]);
           if(nBinZnow < 0) continue;
 
@@ -3584,8 +3851,8 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
             else                  sclBias /= denom;
           }
 
-          his_clos[typeName][nTypeBinNow][nBinZnow]->Fill(sclBias , pdfBinValW);
-          his_clos[typeName][nTypeBinNow][nBinsZ]  ->Fill(sclBias , pdfBinValW);
+          sketch_clos[typeName][nTypeBinNow][nBinZnow].Fill(sclBias , pdfBinValW);
+          sketch_clos[typeName][nTypeBinNow][nBinsZ]  .Fill(sclBias , pdfBinValW);
 
           if(pdfErr > 0) {
             his_relErr[typeName][nTypeBinNow][nBinZnow]->Fill((pdfBinCtr-zTrg)/pdfErr , pdfBinValW);
@@ -3718,15 +3985,22 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
 
           TString hisNameNow(""), hisTitleNow("");
           for(int nBinZnow=0; nBinZnow<nBinsZ; nBinZnow++) {
-            TH1 * his1(NULL);
-            if     (nPlotType == 0) his1 = his_clos  [typeName][nTypeBinNow][nBinZnow];
-            else if(nPlotType == 1) his1 = his_relErr[typeName][nTypeBinNow][nBinZnow];
-
-            if(hisNameNow == "") { hisNameNow = his1->GetName();  hisTitleNow = his1->GetTitle(); }
+            TH1         * his1(NULL);
+            QuantSketch * sketch1(NULL);
+            if     (nPlotType == 0) sketch1 = &(sketch_clos[typeName][nTypeBinNow][nBinZnow]);
+            else if(nPlotType == 1) his1    = his_relErr[typeName][nTypeBinNow][nBinZnow];
+
+            if(hisNameNow == "") {
+              if(sketch1) {
+                hisNameNow  = (TString)"closHis_"+typeName+TString::Format("_typeBinZ%d_nBinZ%d",nTypeBinNow,nBinZnow);
+                hisTitleNow = typeName; hisTitleNow.ReplaceAll("_"," ");
+              }
+              else { hisNameNow = his1->GetName(); hisTitleNow = his1->GetTitle(); }
+            }
 
             utils->param->clearAll();
             utils->param->NewOptB("doFracLargerSigma" , true);
-            if(!utils->getInterQuantileStats(his1)) continue;
+            if(!utils->getInterQuantileStats(NULL,his1,sketch1)) continue;
 
             for(int nMetricNow=0; nMetricNow<nMetricsNow; nMetricNow++) {
               double yVal = utils->param->GetOptF((TString)"quant_"+metricNameV[nMetricNow]);
@@ -3738,13 +4012,14 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
 
           // just once, do the inclusive metric - contribution from all bins
           if(nTypeBinNow == 0) {
-            TH1 * hisSum(NULL);
-            if     (nPlotType == 0) hisSum = his_clos  [typeName][nTypeBinNow][nBinsZ];
-            else if(nPlotType == 1) hisSum = his_relErr[typeName][nTypeBinNow][nBinsZ];
+            TH1         * hisSum(NULL);
+            QuantSketch * sketchSum(NULL);
+            if     (nPlotType == 0) sketchSum = &(sketch_clos[typeName][nTypeBinNow][nBinsZ]);
+            else if(nPlotType == 1) hisSum    = his_relErr[typeName][nTypeBinNow][nBinsZ];
 
             utils->param->clearAll();
             utils->param->NewOptB("doFracLargerSigma" , true);
-            if(utils->getInterQuantileStats(hisSum)) {
+            if(utils->getInterQuantileStats(NULL,hisSum,sketchSum)) {
               if(nPlotType == 0) {
                 for(int nMetricNow=0; nMetricNow<nMetricsNow; nMetricNow++) {
                   double yVal = utils->param->GetOptF((TString)"quant_"+metricNameV[nMetricNow]);
@@ -4148,9 +4423,8 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
   for(map<TString,TH2*> ::iterator itr = his_corRegTrgZ.begin(); itr!=his_corRegTrgZ.end(); ++itr) {
     TString typeName = itr->first;
 
-    for(int nTypeBinNow=0; nTypeBinNow<(int)his_clos[typeName].size(); nTypeBinNow++) {
-      for(int nBinZnow=0; nBinZnow<(int)his_clos[typeName][nTypeBinNow].size(); nBinZnow++) {
-        DELNULL(his_clos  [typeName][nTypeBinNow][nBinZnow]);
+    for(int nTypeBinNow=0; nTypeBinNow<(int)his_relErr[typeName].size(); nTypeBinNow++) {
+      for(int nBinZnow=0; nBinZnow<(int)his_relErr[typeName][nTypeBinNow].size(); nBinZnow++) {
         DELNULL(his_relErr[typeName][nTypeBinNow][nBinZnow]);
         if(doKnnErrPlots) {
           DELNULL(his_errTrg  [typeName][nTypeBinNow][nBinZnow]);
@@ -4177,7 +4451,7 @@ void  ANNZ::doMetricPlots(TChain * aChain, vector <TString> * addPlotVarV, TStri
   plotVars.clear(); plotVarForms.clear(); varPlot_binE.clear(); varPlot_binC.clear();
   typeTitleV.clear(); metricNameV.clear(); metricTitleV.clear();
   graphAvg_Xv.clear(); graphAvg_Xe.clear(); graphAvg_Yv.clear(); graphAvg_Ye.clear(); hisToDelV.clear();
-  mltGrphAvgV.clear(); his_regTrgZ.clear(); his_corRegTrgZ.clear(); his_clos.clear();
+  mltGrphAvgV.clear(); his_regTrgZ.clear(); his_corRegTrgZ.clear(); sketch_clos.clear();
   his_relErr.clear(); his_errTrg.clear(); his_errReg.clear(); his_errRegNP.clear();
 
   return;
@@ -123,6 +123,8 @@ void ANNZ::Optim() {
  *           recreated with error estimates (these are not computed by default during training).
  *           - Once all postTrain trees for individual MLMs are up to date, they are all merged into a
  *           single tree, which is used for optimization.
+ *           - If fusedPostTrain is set, the combined tree is instead created directly for all MLMs at once,
+ *           using makeTreeRegClsFusedMLM(), and no merging is needed.
  */
 // ===========================================================================================================
 void  ANNZ::makeTreeRegClsAllMLM() {
@@ -142,6 +144,15 @@ void  ANNZ::makeTreeRegClsAllMLM() {
   // bool    separateTestValid = glob->GetOptB("separateTestValid"); // deprecated
   int     maxTreesMerge     = glob->GetOptI("maxTreesMerge");
   bool    needBinClsErr     = glob->GetOptB("needBinClsErr");
+  bool    fusedPostTrain    = glob->GetOptB("fusedPostTrain");
+  bool    hasFusedTrees     = false;
+
+  // the fused mode writes a single signal/background type for all MLMs, which is not defined for binned classification
+  if(fusedPostTrain && glob->GetOptB("doBinnedCls")) {
+    fusedPostTrain = false;
+    aLOG(Log::WARNING) <<coutWhiteOnRed<<" - fusedPostTrain is not supported for binned classification -"
+                       <<" will create the postTrain trees separately for each MLM ..."<<coutDef<<endl;
+  }
 
   // -----------------------------------------------------------------------------------------------------------
   // get the number of entries in the input trees to compare to the generated result-trees
@@ -170,6 +181,9 @@ void  ANNZ::makeTreeRegClsAllMLM() {
       MLMname             = getTagName(nMLMnow);  if(mlmSkip[MLMname]) continue;
       postTrainDirNameMLM = getKeyWord(MLMname,"postTrain","postTrainDirName");
 
+      // in the fused mode, the results of all MLMs are stored in the combined result-trees
+      TString resultDirName = fusedPostTrain ? postTrainDirName : postTrainDirNameMLM;
+
       if(nCheckNow > 0) {
         aLOG(Log::INFO) <<coutRed<<MLMname<<coutYellow<<" - There was need to regenerate the result-trees. "
                         <<"Will validate that all is good now ..."<<coutDef<<endl;
@@ -184,12 +198,15 @@ void  ANNZ::makeTreeRegClsAllMLM() {
 
         treeNamePostfix = (TString)( (nTrainValidNow == 0) ? "_train" : "_valid" );
         inTreeName      = (TString)glob->GetOptC("treeName")+treeNamePostfix;
-        inFileName      = (TString)postTrainDirNameMLM+inTreeName+"*.root";
+        inFileName      = (TString)resultDirName+inTreeName+"*.root";
 
         aChain          = new TChain(inTreeName,inTreeName); aChain->SetDirectory(0);
         nFilesFound     = aChain->Add(inFileName);
         nEntriesChain   = aChain->GetEntries();
 
+        // in the fused mode, the MLM must have a branch in the combined result-trees
+        if(fusedPostTrain && nFilesFound > 0 && !aChain->GetBranch(MLMname)) foundGoodTrees = false;
+
         // if required to generate errors for binned classification, check if the corresponding branch already
         // exists in the chain (it is not created during training...)
         // -----------------------------------------------------------------------------------------------------------
@@ -266,7 +283,13 @@ void  ANNZ::makeTreeRegClsAllMLM() {
       // generate the trees if needed
       // -----------------------------------------------------------------------------------------------------------
       if(!foundGoodTrees) {
-        makeTreeRegClsOneMLM(nMLMnow);
+        // in the fused mode, the result-trees of all MLMs are regenerated together, which should only be needed once
+        if(fusedPostTrain) {
+          VERIFY(LOCATION,(TString)"Could not generate fused reg/cls trees succesfully... Something is horribly wrong !!!",!hasFusedTrees);
+
+          makeTreeRegClsFusedMLM(); hasFusedTrees = true;
+        }
+        else makeTreeRegClsOneMLM(nMLMnow);
        
         VERIFY(LOCATION,(TString)"Could not generate reg/cls trees succesfully... Something is horribly wrong !!!",(nCheckNow == 0));
       }
@@ -351,6 +374,9 @@ void  ANNZ::makeTreeRegClsAllMLM() {
     if(needToMergeTrees) {
       VERIFY(LOCATION,(TString)"Could not generate reg/cls trees succesfully... Something is horribly wrong !!!",(nCheckNow == 0));
 
+      // in the fused mode there is nothing to merge, as the combined trees are created directly
+      if(fusedPostTrain) { makeTreeRegClsFusedMLM(); continue; }
+
       outputs->InitializeDir(glob->GetOptC("postTrainDirNameFull"),glob->GetOptC("baseName"));
       saveFileName = getKeyWord("","postTrain","configSaveFileName");  //saveFileName = (TString)glob->GetOptC("postTrainDirNameFull")+"saveTime.txt";
 
@@ -521,7 +547,6 @@ void  ANNZ::makeTreeRegClsOneMLM(int nMLMnow) {
   if(isErrINP) aLOG(Log::INFO)<<coutYellow<<" - Will gen. input-parameter errors ..."<<coutDef<<endl;
 
   TString postTrainDirName  = getKeyWord(MLMname,"postTrain","postTrainDirName");
-  TString saveFileName      = getKeyWord(MLMname,"postTrain","configSaveFileName");
 
   // set the output directory to the postTrainDirName dir
   outputs->InitializeDir(postTrainDirName,glob->GetOptC("baseName"));
@@ -642,6 +667,17 @@ void  ANNZ::makeTreeRegClsOneMLM(int nMLMnow) {
     var_1->createTreeBranches(treeOut); 
     var_1->setDefaultVals();
 
+    outputs->BeginTreeLoop();
+
+    // resolve the variables used in the loop once, to avoid name lookups for each object
+    // -----------------------------------------------------------------------------------------------------------
+    VarMaps::VarHandle hdl_0_w = var_0->GetVarHandle(MLMname_w), hdl_0_i = var_0->GetVarHandle(indexName);
+    VarMaps::VarHandle hdl_1   = var_1->GetVarHandle(MLMname),   hdl_1_w = var_1->GetVarHandle(MLMname_w);
+    VarMaps::VarHandle hdl_1_i = var_1->GetVarHandle(MLMname_i), hdl_1_v, hdl_1_t, hdl_1_eN, hdl_1_e, hdl_1_eP;
+    if(isCls)                   { hdl_1_v  = var_1->GetVarHandle(MLMname_v);  hdl_1_t = var_1->GetVarHandle(sigBckTypeName); }
+    if(!isCls || needBinClsErr) { hdl_1_eN = var_1->GetVarHandle(MLMname_eN); hdl_1_e = var_1->GetVarHandle(MLMname_e);
+                                  hdl_1_eP = var_1->GetVarHandle(MLMname_eP);                                                }
+
     // -----------------------------------------------------------------------------------------------------------
     // loop on the tree
     // -----------------------------------------------------------------------------------------------------------
@@ -657,6 +693,7 @@ void  ANNZ::makeTreeRegClsOneMLM(int nMLMnow) {
       if((var_0->GetCntr("nObj") % nObjectsToPrint == 0 && var_0->GetCntr("nObj") > 0) || breakLoop) { var_0->printCntr(inTreeName); }
       if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
         outputs->WriteOutObjects(false,true); outputs->ResetObjects(); mayWriteObjects = false;
+        var_1->setTreeWrite(outputs->TreeMap[inTreeName]);
       }
       if(breakLoop) break;
 
@@ -678,40 +715,40 @@ void  ANNZ::makeTreeRegClsOneMLM(int nMLMnow) {
         if(var_0->GetCntr(sigBckName) > 0 && var_0->GetCntr(sigBckName) == maxNobj) skipObj = true;
         // if(maxNobj > 0) var_0->IncCntr(sigBckName+"_loop");
 
-        var_1->SetVarI(sigBckTypeName,sigBckType);
+        var_1->SetVarI(hdl_1_t,sigBckType);
       }
       if(skipObj) continue; // only relevant for classification
       
-      var_1->SetVarI(MLMname_i,var_0->GetVarI(indexName));
+      var_1->SetVarI(hdl_1_i,var_0->GetVarI(hdl_0_i));
       // var_1->SetVarI(testValidType,var_0->GetVarI(testValidType)); // deprecated
 
       // fill the output tree
       if(isCls) {
         double  clsVal = getReader(var_0,ANNZ_readType::CLS,true,nMLMnow);
         double  clsPrb = getReader(var_0,ANNZ_readType::PRB,false,nMLMnow);
-        double  clsWgt = var_0->GetForm(MLMname_w) * (passCuts?1:0);
+        double  clsWgt = var_0->GetForm(hdl_0_w) * (passCuts?1:0);
 
         // sanity check that weights are properly defined
         if(clsWgt < 0) { var_0->printVars(); VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false); }
 
-        var_1->SetVarF(MLMname_v,clsVal); var_1->SetVarF(MLMname,clsPrb); var_1->SetVarF(MLMname_w,clsWgt);
+        var_1->SetVarF(hdl_1_v,clsVal); var_1->SetVarF(hdl_1,clsPrb); var_1->SetVarF(hdl_1_w,clsWgt);
       }
       else {
         double  regVal  = getReader(var_0,ANNZ_readType::REG,true,nMLMnow);
-        double  regWgt  = var_0->GetForm(MLMname_w) * (passCuts?1:0);
+        double  regWgt  = var_0->GetForm(hdl_0_w) * (passCuts?1:0);
 
         // sanity check that weights are properly defined
         if(regWgt < 0) { var_0->printVars(); VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false); }
 
-        var_1->SetVarF(MLMname,regVal); var_1->SetVarF(MLMname_w,regWgt);
+        var_1->SetVarF(hdl_1,regVal); var_1->SetVarF(hdl_1_w,regWgt);
       }
 
       if(!isCls || needBinClsErr) {
         if     (isErrKNNnow) getRegClsErrKNN(var_0,knnErrModule,trgIndexV,nMLMv,!isCls,regErrV);
         else if(isErrINPnow) getRegClsErrINP(var_0,!isCls,nMLMnow,&seed,&(regErrV[nMLMnow]));
 
-        var_1->SetVarF(MLMname_eN,regErrV[nMLMnow][0]); var_1->SetVarF(MLMname_e,regErrV[nMLMnow][1]);
-        var_1->SetVarF(MLMname_eP,regErrV[nMLMnow][2]);
+        var_1->SetVarF(hdl_1_eN,regErrV[nMLMnow][0]); var_1->SetVarF(hdl_1_e,regErrV[nMLMnow][1]);
+        var_1->SetVarF(hdl_1_eP,regErrV[nMLMnow][2]);
       }
 
       var_1->fillTree();
@@ -728,6 +765,9 @@ void  ANNZ::makeTreeRegClsOneMLM(int nMLMnow) {
     }
     if(!breakLoop) { var_0->printCntr(inTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
 
+    // write the remaining output (and restore the original output tree) before reading the output files
+    outputs->EndTreeLoop(); var_1->setTreeWrite(treeOut);
+
     regErrV.clear();
 
     // -----------------------------------------------------------------------------------------------------------
@@ -737,85 +777,611 @@ void  ANNZ::makeTreeRegClsOneMLM(int nMLMnow) {
       // create the chain from the output which has just been created
       TString outFileName = (TString)postTrainDirName+inTreeName+"*.root";
 
-      aLOG(Log::INFO) <<coutBlue<<" - Will compute separation parameter for "<<coutGreen<<inTreeName<<coutBlue
-                      <<" from "<<coutYellow<<outFileName<<coutDef<<endl;
-
-      // prepare the chain and input variables. Set cuts to match the TMVAs
       TChain * aChainOut = new TChain(inTreeName,inTreeName); aChainOut->SetDirectory(0); aChainOut->Add(outFileName); 
       aLOG(Log::DEBUG) <<coutRed<<" - added chain "<<coutGreen<<inTreeName<<"("<<aChainOut->GetEntries()<<")"<<" from "<<coutBlue<<outFileName<<coutDef<<endl;
 
-      TCanvas * tmpCnvs = new TCanvas("tmpCnvs","tmpCnvs");
-      TH1     * his1_sig(NULL), * his1_bck(NULL), * his_all(NULL);
-      for(int nSigBckNow=0; nSigBckNow<2; nSigBckNow++) {
-        TString sigBckName = (TString)((nSigBckNow == 0) ? "_sig" : "_bck");
-        TString sigBckCut  = (TString)((nSigBckNow == 0) ? "== 1" : "== 0");
+      double separationNow = getSeparationPostTrain(aChainOut,nMLMnow);
+      if(separationNow >= 0) separation = separationNow;
 
-        // get common limits for the entire sample (net necessarily between zero and one if [useBinClsPrior==true])
-        if(nSigBckNow == 0) {
-          TString hisName    = (TString)"sepHis"+"_all";
-          TString drawExprs  = (TString)MLMname+">>"+hisName;
-          
-          TString cutExprs   = (TString)"("+MLMname_w+" > 0)";
-          // TString trainCut   = (TString)var_0->getTreeCuts("_train");   // deprecated
-          // if(trainCut != "") cutExprs += (TString)" && ("+trainCut+")"; // deprecated
-          
-          // int     nEvtPass   = aChainOut->Draw(drawExprs,cutExprs);
-          int nEvtPass = utils->drawTree(aChainOut,drawExprs,cutExprs);
-          if(nEvtPass > 0) { his_all = (TH1F*)gDirectory->Get(hisName); his_all->BufferEmpty(); }
+      DELNULL(aChainOut);
+    }
+
+    //cleanup
+    DELNULL(var_0); DELNULL(var_1); DELNULL(aChain);
+
+    if(isErrKNN) {
+      DELNULL(varKNN); cleanupKdTreeKNN(knnErrOutFile,knnErrFactory,knnErrDataLdr,knnErrModule);
+
+      aChainKnn[0]->RemoveFriend(aChainKnn[1]); DELNULL(aChainKnn[0]); DELNULL(aChainKnn[1]);
+
+      utils->safeRM(getKeyWord(MLMname,"knnErrXML","outFileDirKnnErr"), inLOG(Log::DEBUG));
+      utils->safeRM(getKeyWord(MLMname,"knnErrXML","outFileNameKnnErr"),inLOG(Log::DEBUG));
+    }
+    aChainKnn.clear(); trgIndexV.clear();
+  }
+
+  // re-set the output directory to the correct path
+  outputs->SetOutDirName(glob->GetOptC("outDirNameFull"));
+
+  // log the creation time of the trees, and the user-defined cuts and weights
+  savePostTrainConfig(nMLMnow,separation);
+
+  clearReaders();
+
+  aLOG(Log::INFO) <<coutWhiteOnBlack<<coutGreen<<" - ending makeTreeRegClsOneMLM() ... "<<coutDef<<endl;
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief    - Create combined "postTrain" trees for all accepted MLMs, in a single pass over each of
+ *           the _train and _valid chains.
+ *
+ * @details  - This is the fused alternative (see the fusedPostTrain option) to calling makeTreeRegClsOneMLM()
+ *           for each MLM and then merging the results with mergeTreeFriends(). The readers of all MLMs are
+ *           loaded at once, and each object is evaluated by all MLMs (including the KNN or input-parameter
+ *           errors) before moving on to the next one. The entries of each chain are split between up to nThreads
+ *           threads, where the output files of each thread are tagged by the index of the thread, so that the
+ *           combined chain keeps the original order of the entries.
+ *           - The trees are written directly to postTrainDirNameFull, including a single errKNN tree for all MLMs.
+ *           A kd-tree is therefore only created once for each combination of input-variables, cuts and weights.
+ *           The postTrain directories of the individual MLMs only hold the configuration files (see
+ *           savePostTrainConfig()) and the cls->prb histograms of multiclass MLMs.
+ */
+// ===========================================================================================================
+void  ANNZ::makeTreeRegClsFusedMLM() {
+// ===========================================================================================================
+  aLOG(Log::INFO) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::makeTreeRegClsFusedMLM() ... "<<coutDef<<endl;
+
+  TString indexName        = glob->GetOptC("indexName");
+  TString sigBckTypeName   = glob->GetOptC("sigBckTypeName");
+  UInt_t  seed             = glob->GetOptI("initSeedRnd"); if(seed > 0) seed += 58606;
+  bool    isCls            = glob->GetOptB("doClassification") || glob->GetOptB("doBinnedCls");
+  bool    needBinClsErr    = glob->GetOptB("needBinClsErr");
+  int     nMLMs            = glob->GetOptI("nMLMs");
+  int     nThreads         = ThreadPool::getNumThreads(glob->GetOptI("nThreads"));
+  TString postTrainDirName = glob->GetOptC("postTrainDirNameFull");
+  bool    needErr          = !isCls || needBinClsErr;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // the accepted MLMs, and the type of error estimator of each one
+  // -----------------------------------------------------------------------------------------------------------
+  vector <int>  nMLMv;
+  vector <bool> isErrKNNv(nMLMs,false), isErrINPv(nMLMs,false);
+  TString       allMLMs("");
+
+  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+    TString MLMname = getTagName(nMLMnow); if(mlmSkip[MLMname]) continue;
+
+    // this check is safe, since (inNamesErr[nMLMnow].size() > 0) was confirmed in setNominalParams()
+    VERIFY(LOCATION,(TString)"inNamesErr["+utils->intToStr(nMLMnow)+"] not initialized... something is horribly wrong ?!?",(inNamesErr[nMLMnow].size() > 0));
+
+    isErrINPv[nMLMnow] = needErr && (inNamesErr[nMLMnow][0] != "");
+    isErrKNNv[nMLMnow] = needErr && !isErrINPv[nMLMnow];
+
+    nMLMv.push_back(nMLMnow); allMLMs += coutGreen+MLMname+coutPurple+",";
+
+    // the postTrain directory of the MLM only holds configuration files in the fused mode
+    utils->resetDirectory(getKeyWord(MLMname,"postTrain","postTrainDirName"));
+  }
+  VERIFY(LOCATION,(TString)"Found no accepted MLMs for the postTrain trees ... Something is horribly wrong ?!?",((int)nMLMv.size() > 0));
+
+  aLOG(Log::INFO) <<coutBlue<<" - will create combined postTrain trees in "<<coutYellow<<postTrainDirName
+                  <<coutBlue<<" for: "<<allMLMs<<coutDef<<endl;
+
+  outputs->InitializeDir(postTrainDirName,glob->GetOptC("baseName"));
+
+  // load the readers of all accepted MLMs, and for multiClass, create the probability histograms by hand
+  map <TString,bool> mlmSkipNow = mlmSkip;
+  loadReaders(mlmSkipNow,false);
+  mlmSkipNow.clear();
+
+  for(int nMLMinNow=0; nMLMinNow<(int)nMLMv.size(); nMLMinNow++) {
+    if(anlysTypes[nMLMv[nMLMinNow]] == TMVA::Types::kMulticlass) deriveHisClsPrb(nMLMv[nMLMinNow]);
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // create a combined tree from the _train dataset which contains the input for the KNN error estimator
+  // -----------------------------------------------------------------------------------------------------------
+  createTreeErrKNN(nMLMv);
+
+  vector <double> separationV(nMLMs,-1);
+  for(int nTrainValidNow=0; nTrainValidNow<2; nTrainValidNow++) {
+    TString treeNamePostfix = (TString)( (nTrainValidNow == 0) ? "_train" : "_valid" );
+
+    // -----------------------------------------------------------------------------------------------------------
+    // setup the kd-trees for the KNN errors - MLMs with the same input-variables, cuts and weights share a kd-tree
+    // -----------------------------------------------------------------------------------------------------------
+    VarMaps                                     * varKNN(NULL);
+    vector <TChain *>                           aChainKnn(2,NULL);
+    vector <int>                                trgIndexV;
+    vector <TFile*>                             knnErrOutFile(nMLMs,NULL);
+    vector <TMVA::Factory*>                     knnErrFactory(nMLMs,NULL);
+    vector <TMVA::Configurable*>                knnErrDataLdr(nMLMs,NULL);
+    vector <TMVA::kNN::ModulekNN*>              knnErrModule (nMLMs,NULL);
+    map <TString,int>                           allInputCombos;
+    map < TMVA::kNN::ModulekNN*,vector<int> >   getErrKNN;
+
+    if(find(isErrKNNv.begin(),isErrKNNv.end(),true) != isErrKNNv.end()) {
+      TString inTreeNameKnn = getKeyWord("","treeErrKNN","treeErrKNNname");
+      TString inFileNameKnn = postTrainDirName+inTreeNameKnn+"*.root";
+
+      aChainKnn[0] = new TChain(inTreeNameKnn,inTreeNameKnn); aChainKnn[0]->SetDirectory(0); aChainKnn[0]->Add(inFileNameKnn);
+
+      TString inTreeKnnFrnd = (TString)glob->GetOptC("treeName")+"_train";
+      TString inFileKnnFrnd = (TString)glob->GetOptC("inputTreeDirName")+inTreeKnnFrnd+"*.root";
+      aChainKnn[1] = new TChain(inTreeKnnFrnd,inTreeKnnFrnd); aChainKnn[1]->SetDirectory(0); aChainKnn[1]->Add(inFileKnnFrnd);
+
+      aChainKnn[0]->AddFriend(aChainKnn[1],utils->nextTreeFriendName(aChainKnn[0]));
+
+      aLOG(Log::DEBUG) <<coutRed<<" - Created KnnErr chain  "<<coutGreen<<inTreeNameKnn
+                       <<"("<<aChainKnn[0]->GetEntries()<<")"<<" from "<<coutBlue<<inFileNameKnn<<coutDef<<endl;
+
+      varKNN = new VarMaps(glob,utils,"varKNN");
+      varKNN->connectTreeBranches(aChainKnn[0]);  // connect the tree so as to allocate memory for cut variables
+
+      for(int nMLMinNow=0; nMLMinNow<(int)nMLMv.size(); nMLMinNow++) {
+        int     nMLMnow = nMLMv[nMLMinNow]; if(!isErrKNNv[nMLMnow]) continue;
+        TString MLMname = getTagName(nMLMnow);
+
+        setMethodCuts(varKNN,nMLMnow,false);
+
+        TCut    cutsNow = varKNN->getTreeCuts("_comn") + varKNN->getTreeCuts(MLMname+treeNamePostfix);
+        TString wgtReg  = getRegularStrForm(userWgtsM[MLMname+treeNamePostfix],varKNN);
+
+        TString inputComboNow = (TString)"[__ANNZ_VAR__]"+inputVariableV[nMLMnow]+"[__ANNZ_WGT__]"+wgtReg+"[__ANNZ_CUT__]"+(TString)cutsNow;
+        inputComboNow.ReplaceAll(" ","").ReplaceAll("[__"," [__").ReplaceAll("__]","__] ");
+
+        // if this is a new combination of variables/weights/cuts, create a new kd-tree
+        if(allInputCombos.find(inputComboNow) == allInputCombos.end()) {
+          allInputCombos[inputComboNow] = nMLMnow;
+
+          setupKdTreeKNN( aChainKnn[0],knnErrOutFile[nMLMnow],knnErrFactory[nMLMnow],knnErrDataLdr[nMLMnow],
+                          knnErrModule[nMLMnow],trgIndexV,nMLMnow,cutsNow,wgtReg );
         }
-        if(!his_all) continue;
+        else {
+          int nMLMprev = allInputCombos[inputComboNow];
 
-        int    nBins = 100;
-        double binL  = his_all->GetXaxis()->GetBinLowEdge(his_all->GetXaxis()->GetFirst());
-        double binH  = his_all->GetXaxis()->GetBinUpEdge (his_all->GetXaxis()->GetLast() );
+          knnErrModule[nMLMnow] = knnErrModule[nMLMprev];
 
-        TString hisName    = (TString)"sepHis"+sigBckName;
-        TH1     * his1_sb  = new TH1F(hisName,hisName,nBins,binL,binH); 
-        TString drawExprs  = (TString)MLMname+">>+"+hisName;
+          aLOG(Log::DEBUG_1) <<coutPurple<<" - For "<<coutYellow<<MLMname<<coutPurple<<" found existing combination of "
+                             <<"variables/cuts for kd-tree from "<<coutGreen<<getTagName(nMLMprev)<<coutDef<<endl;
+        }
 
-        TString cutExprs   = (TString)"("+MLMname_w+" > 0) && ("+sigBckTypeName+sigBckCut+")";
-        // TString trainCut   = (TString)var_0->getTreeCuts("_train");   // deprecated
-        // if(trainCut != "") cutExprs += (TString)" && ("+trainCut+")"; // deprecated
+        getErrKNN[knnErrModule[nMLMnow]].push_back(nMLMnow);
+      }
 
-        // int     nEvtPass   = aChainOut->Draw(drawExprs,cutExprs);
-        int nEvtPass = utils->drawTree(aChainOut,drawExprs,cutExprs);
+      aLOG(Log::INFO) <<coutBlue<<" - Using "<<coutYellow<<allInputCombos.size()<<coutBlue<<" kd-trees for the KNN errors of "
+                      <<coutYellow<<getErrKNN.size()<<coutBlue<<" groups of MLMs ..."<<coutDef<<endl;
+    }
 
-        if(nEvtPass > 0) {
-          his1_sb->SetDirectory(0); his1_sb->BufferEmpty(); // allowed only after the chain fills the histogram
-          if(nSigBckNow == 0) his1_sig = his1_sb;
-          else                his1_bck = his1_sb;
+    // -----------------------------------------------------------------------------------------------------------
+    // create the chain for the loop, and split the entries between the threads
+    // -----------------------------------------------------------------------------------------------------------
+    TString inTreeName = (TString)glob->GetOptC("treeName")+treeNamePostfix;
+    TString inFileName = (TString)glob->GetOptC("inputTreeDirName")+inTreeName+"*.root";
+
+    TChain * aChain = new TChain(inTreeName,inTreeName); aChain->SetDirectory(0); aChain->Add(inFileName); 
+    Long64_t nEntriesChain = aChain->GetEntries();
+    aLOG(Log::INFO) <<coutRed<<" - added chain "<<coutGreen<<inTreeName<<"("<<nEntriesChain<<")"<<" from "<<coutBlue<<inFileName<<coutDef<<endl;
+
+    int nThreadsNow = static_cast<int>(max(min((Long64_t)nThreads,nEntriesChain),(Long64_t)1));
+
+    vector <RegEvalThread*> threadV(nThreadsNow,NULL);
+    for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+      bool isMainThread = (nThreadNow == 0);
+
+      // utils and output manager - each thread writes its own output files, tagged by the index of the thread
+      Utils   * utilsNow   = utils;
+      OutMngr * outputsNow = outputs;
+
+      if(!isMainThread) {
+        utilsNow   = new Utils(glob);
+        outputsNow = new OutMngr((TString)"outputs_"+utils->intToStr(nThreadNow),utilsNow,glob);
+
+        outputsNow->SetOutDirName(outputs->GetOutDirName());
+        outputsNow->OutputRootFileIndex = outputsNow->OutputTreeFileIndex = -1;
+      }
+      outputsNow->treeFileTag = (TString)((nThreadsNow > 1) ? TString::Format("_t%03d",nThreadNow) : "");
+
+      RegEvalThread * thr = new RegEvalThread((TString)"postTrainThread_"+utils->intToStr(nThreadNow),utilsNow,glob,outputsNow);
+
+      thr->isOwner   = !isMainThread;
+      thr->loopChain = isMainThread ? aChain : utilsNow->cloneChain(aChain);
+      thr->seedINP   = seed;
+      thr->regErrV.resize(nMLMs,vector<double>(3,0));
+
+      Long64_t nEntriesThread = nEntriesChain / nThreadsNow;
+      Long64_t nEntriesExtra  = nEntriesChain % nThreadsNow;
+
+      thr->entryMin = nThreadNow * nEntriesThread + min((Long64_t)nThreadNow,nEntriesExtra);
+      thr->entryMax = thr->entryMin + nEntriesThread + ((nThreadNow < nEntriesExtra) ? 1 : 0);
+
+      if(!isMainThread) cloneReaders(thr);
+
+      // create the vars to read/write trees - MLM, MLM-eror, MLM-weight and MLM-index variables for each MLM
+      // -----------------------------------------------------------------------------------------------------------
+      VarMaps * var_0 = new VarMaps(glob,utilsNow,"treeRegClsVar_0");
+      VarMaps * var_1 = new VarMaps(glob,utilsNow,"treeRegClsVar_1");
+
+      if(isCls) var_1->NewVarI(sigBckTypeName);
+
+      for(int nMLMinNow=0; nMLMinNow<(int)nMLMv.size(); nMLMinNow++) {
+        int     nMLMnow   = nMLMv[nMLMinNow];
+        TString MLMname   = getTagName(nMLMnow);
+        TString MLMname_w = getTagWeight(nMLMnow);
+
+        TString wgtStr = getRegularStrForm(userWgtsM[MLMname+treeNamePostfix],var_0);
+        var_0->NewForm(MLMname_w,wgtStr);
+
+        if(isErrINPv[nMLMnow]) {
+          for(int nInErrNow=0; nInErrNow<(int)inNamesErr[nMLMnow].size(); nInErrNow++) {
+            var_0->NewForm(getTagInVarErr(nMLMnow,nInErrNow),inNamesErr[nMLMnow][nInErrNow]);
+          }
         }
-        else DELNULL(his1_sb);
+
+        var_1->NewVarF(MLMname); var_1->NewVarF(MLMname_w); var_1->NewVarI(getTagIndex(nMLMnow));
+        if(isCls)   { var_1->NewVarF(getTagClsVal(nMLMnow)); }
+        if(needErr) { var_1->NewVarF(getTagError(nMLMnow,"N")); var_1->NewVarF(getTagError(nMLMnow,"")); var_1->NewVarF(getTagError(nMLMnow,"P")); }
       }
-      DELNULL(tmpCnvs); DELNULL(his_all);
 
-      if(his1_sig && his1_bck) {
-        separation = getSeparation(his1_sig,his1_bck);
+      var_0->connectTreeBranchesForm(thr->loopChain,(thr->hasReaders ? &(thr->readerInptV) : &readerInptV));
+
+      for(int nMLMinNow=0; nMLMinNow<(int)nMLMv.size(); nMLMinNow++) setMethodCuts(var_0,nMLMv[nMLMinNow],false);
+
+      TTree * treeOut = new TTree(inTreeName,inTreeName); treeOut->SetDirectory(0);
+      outputsNow->TreeMap[inTreeName] = treeOut;
+
+      var_1->createTreeBranches(treeOut); 
+      var_1->setDefaultVals();
+
+      // start the batch-writing of the output trees (here, as the setup of the threads is serial)
+      outputsNow->BeginTreeLoop();
+
+      thr->var_0 = var_0; thr->var_1 = var_1; thr->treeOut = treeOut;
 
-        aLOG(Log::INFO)<<coutYellow<<" - Got separation parameter: "<<coutGreen<<separation<<coutDef<<endl;
+      threadV[nThreadNow] = thr;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // loop on the tree
+    // -----------------------------------------------------------------------------------------------------------
+    if(nThreadsNow == 1) {
+      makeTreeRegClsFusedLoop(threadV[0],nMLMv,isErrINPv,getErrKNN,trgIndexV,treeNamePostfix);
+    }
+    else {
+      aLOG(Log::INFO) <<coutBlue<<" - will evaluate "<<coutYellow<<nEntriesChain<<coutBlue<<" objects using "
+                      <<coutYellow<<nThreadsNow<<coutBlue<<" threads ..."<<coutDef<<endl;
+
+      // histograms which are created within the threads should not be registered in the current directory
+      bool addDirectoryStatus = TH1::AddDirectoryStatus();
+      TH1::AddDirectory(false);
+
+      ThreadPool * threadPool = new ThreadPool(nThreadsNow);
+      for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+        RegEvalThread * thr = threadV[nThreadNow];
+        threadPool->push([this,thr,&nMLMv,&isErrINPv,&getErrKNN,&trgIndexV,treeNamePostfix]() {
+          makeTreeRegClsFusedLoop(thr,nMLMv,isErrINPv,getErrKNN,trgIndexV,treeNamePostfix);
+        });
       }
+      threadPool->wait();
+      DELNULL(threadPool);
 
-      DELNULL(aChainOut); DELNULL(his1_sig); DELNULL(his1_bck);
+      TH1::AddDirectory(addDirectoryStatus);
     }
 
-    //cleanup
-    DELNULL(var_0); DELNULL(var_1); DELNULL(aChain);
+    for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) DELNULL(threadV[nThreadNow]);
+    threadV.clear();
+    outputs->treeFileTag = "";
 
-    if(isErrKNN) {
-      DELNULL(varKNN); cleanupKdTreeKNN(knnErrOutFile,knnErrFactory,knnErrDataLdr);
+    // -----------------------------------------------------------------------------------------------------------
+    // for classification, get the separation parameter of each MLM from the combined output
+    // -----------------------------------------------------------------------------------------------------------
+    if(isCls) {
+      TString outFileName = (TString)postTrainDirName+inTreeName+"*.root";
 
-      aChainKnn[0]->RemoveFriend(aChainKnn[1]); DELNULL(aChainKnn[0]); DELNULL(aChainKnn[1]);
+      TChain * aChainOut = new TChain(inTreeName,inTreeName); aChainOut->SetDirectory(0); aChainOut->Add(outFileName); 
+      aLOG(Log::DEBUG) <<coutRed<<" - added chain "<<coutGreen<<inTreeName<<"("<<aChainOut->GetEntries()<<")"<<" from "<<coutBlue<<outFileName<<coutDef<<endl;
+
+      for(int nMLMinNow=0; nMLMinNow<(int)nMLMv.size(); nMLMinNow++) {
+        double separationNow = getSeparationPostTrain(aChainOut,nMLMv[nMLMinNow]);
+        if(separationNow >= 0) separationV[nMLMv[nMLMinNow]] = separationNow;
+      }
+
+      DELNULL(aChainOut);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // cleanup
+    // -----------------------------------------------------------------------------------------------------------
+    DELNULL(aChain);
+
+    for(map <TString,int>::iterator Itr=allInputCombos.begin(); Itr!=allInputCombos.end(); ++Itr) {
+      int nMLMnow = Itr->second; TString MLMname = getTagName(nMLMnow);
+
+      cleanupKdTreeKNN(knnErrOutFile[nMLMnow],knnErrFactory[nMLMnow],knnErrDataLdr[nMLMnow],knnErrModule[nMLMnow]);
 
       utils->safeRM(getKeyWord(MLMname,"knnErrXML","outFileDirKnnErr"), inLOG(Log::DEBUG));
       utils->safeRM(getKeyWord(MLMname,"knnErrXML","outFileNameKnnErr"),inLOG(Log::DEBUG));
     }
-    aChainKnn.clear(); trgIndexV.clear();
+    DELNULL(varKNN);
+
+    if(aChainKnn[0]) { aChainKnn[0]->RemoveFriend(aChainKnn[1]); DELNULL(aChainKnn[0]); DELNULL(aChainKnn[1]); }
+
+    aChainKnn.clear(); trgIndexV.clear(); knnErrOutFile.clear(); knnErrFactory.clear(); knnErrDataLdr.clear();
+    knnErrModule.clear(); allInputCombos.clear(); getErrKNN.clear();
   }
 
   // re-set the output directory to the correct path
   outputs->SetOutDirName(glob->GetOptC("outDirNameFull"));
 
-  // 
+  // -----------------------------------------------------------------------------------------------------------
+  // log the creation time of the trees for each MLM, and then for the combined trees (which must come last, so
+  // that the combined trees are not considered to be older than those of any MLM by makeTreeRegClsAllMLM())
+  // -----------------------------------------------------------------------------------------------------------
+  for(int nMLMinNow=0; nMLMinNow<(int)nMLMv.size(); nMLMinNow++) {
+    savePostTrainConfig(nMLMv[nMLMinNow],separationV[nMLMv[nMLMinNow]]);
+  }
+
+  TString saveFileName = getKeyWord("","postTrain","configSaveFileName");
+  aLOG(Log::INFO)<<coutYellow<<" - Saving file "<<coutGreen<<saveFileName<<coutYellow<<" to log the creation time of the trees ..."<<coutDef<<endl;
+
+  vector <TString> optNames;
+  OptMaps * optMap = new OptMaps("localOptMap");
+  utils->optToFromFile(&optNames,optMap,saveFileName,"WRITE");
+
+  DELNULL(optMap); nMLMv.clear(); separationV.clear();
+
+  clearReaders();
+
+  aLOG(Log::INFO) <<coutWhiteOnBlack<<coutGreen<<" - ending makeTreeRegClsFusedMLM() ... "<<coutDef<<endl;
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief                  - The loop over the range of entries of one thread of makeTreeRegClsFusedMLM(), which
+ *                         evaluates all MLMs for each object, and fills the combined output tree of the thread.
+ *
+ * @details                - The seed of the input-parameter errors is derived from the index of the entry in the
+ *                         chain, so that the results do not depend on the number of threads.
+ *
+ * @param thr              - The thread object (see makeTreeRegClsFusedMLM()).
+ * @param nMLMv            - The indices of the accepted MLMs.
+ * @param isErrINPv        - Flags for the MLMs which use input-parameter errors.
+ * @param getErrKNN        - The MLMs which are associated with each kd-tree, for the KNN errors.
+ * @param trgIndexV        - The arrangement of MLM indices in the KNN target list.
+ * @param treeNamePostfix  - The postfix of the current chain ("_train" or "_valid").
+ */
+// ===========================================================================================================
+void ANNZ::makeTreeRegClsFusedLoop(
+  RegEvalThread * thr, vector <int> & nMLMv, vector <bool> & isErrINPv,
+  map < TMVA::kNN::ModulekNN*,vector<int> > & getErrKNN, vector <int> & trgIndexV, TString treeNamePostfix
+) {
+// ===========================================================================================================
+  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::makeTreeRegClsFusedLoop("<<thr->name<<") ... "<<coutDef<<endl;
+
+  TString indexName      = glob->GetOptC("indexName");
+  TString sigBckTypeName = glob->GetOptC("sigBckTypeName");
+  UInt_t  seed           = thr->seedINP;
+  bool    isCls          = glob->GetOptB("doClassification") || glob->GetOptB("doBinnedCls");
+  bool    needErr        = !isCls || glob->GetOptB("needBinClsErr");
+  int     nMLMsIn        = (int)nMLMv.size();
+
+  VarMaps * var_0        = thr->var_0;
+  VarMaps * var_1        = thr->var_1;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // resolve the variables used in the loop once, to avoid name lookups for each object. for each MLM, the
+  // handles are ordered as [val,wgt,idx,cls,errN,err,errP]
+  // -----------------------------------------------------------------------------------------------------------
+  enum { hdlVal, hdlWgt, hdlIdx, hdlCls, hdlErrN, hdlErr, hdlErrP, nHdls };
+  vector < vector <VarMaps::VarHandle> > hdl_1(nMLMsIn,vector<VarMaps::VarHandle>(nHdls));
+  vector <VarMaps::VarHandle>            hdl_0_w(nMLMsIn);
+  vector <TString>                       baseCutsNameV(nMLMsIn);
+  vector <bool>                          passCutsV(nMLMsIn,false);
+
+  VarMaps::VarHandle hdl_0_i = var_0->GetVarHandle(indexName), hdl_1_t;
+  if(isCls) hdl_1_t = var_1->GetVarHandle(sigBckTypeName);
+
+  for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
+    int     nMLMnow = nMLMv[nMLMinNow];
+    TString MLMname = getTagName(nMLMnow);
+
+    baseCutsNameV[nMLMinNow] = (TString)"_comn"+";"+MLMname+treeNamePostfix;
+    hdl_0_w      [nMLMinNow] = var_0->GetVarHandle(getTagWeight(nMLMnow));
+
+    vector <VarMaps::VarHandle> & hdlV = hdl_1[nMLMinNow];
+    hdlV[hdlVal] = var_1->GetVarHandle(MLMname);
+    hdlV[hdlWgt] = var_1->GetVarHandle(getTagWeight(nMLMnow));
+    hdlV[hdlIdx] = var_1->GetVarHandle(getTagIndex(nMLMnow));
+    if(isCls)   { hdlV[hdlCls]  = var_1->GetVarHandle(getTagClsVal(nMLMnow)); }
+    if(needErr) { hdlV[hdlErrN] = var_1->GetVarHandle(getTagError(nMLMnow,"N")); hdlV[hdlErr] = var_1->GetVarHandle(getTagError(nMLMnow,""));
+                  hdlV[hdlErrP] = var_1->GetVarHandle(getTagError(nMLMnow,"P"));                                                         }
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // loop on the tree
+  // -----------------------------------------------------------------------------------------------------------
+  bool    breakLoop(false), mayWriteObjects(false);
+  int     nObjectsToWrite(glob->GetOptI("nObjectsToWrite")), nObjectsToPrint(glob->GetOptI("nObjectsToPrint"));
+  TString aChainName(thr->loopChain->GetName());
+  var_0->clearCntr();
+  for(Long64_t loopEntry=thr->entryMin; true; loopEntry++) {
+    if(loopEntry >= thr->entryMax || !var_0->getTreeEntry(loopEntry)) breakLoop = true;
+
+    if((var_0->GetCntr("nObj") % nObjectsToPrint == 0 && var_0->GetCntr("nObj") > 0)) { var_0->printCntr(aChainName,Log::DEBUG); }
+    if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
+      var_0->printCntr(aChainName); thr->outputs->WriteOutObjects(false,true); thr->outputs->ResetObjects();
+      var_1->setTreeWrite(thr->outputs->TreeMap[thr->treeOut->GetName()]);
+      mayWriteObjects = false;
+    }
+    if(breakLoop) break;
+
+    // reseed the input-parameter errors, based on the index of the current object in the chain
+    if(seed > 0) thr->seedINP = thr->utils->getSeedForIndex(seed,loopEntry);
+
+    var_0->IncCntr("nObj");
+
+    // check if passed cuts ("_comn" , and (MLMname+treeNamePostfix)) for each MLM
+    for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
+      passCutsV[nMLMinNow] = !var_0->hasFailedTreeCuts(baseCutsNameV[nMLMinNow]);
+    }
+
+    if(isCls) {
+      int sigBckType(-1);
+      if     (!var_0->hasFailedTreeCuts("_bck")) { sigBckType = 0; var_0->IncCntr("nObj_bck"); }
+      else if(!var_0->hasFailedTreeCuts("_sig")) { sigBckType = 1; var_0->IncCntr("nObj_sig"); }
+
+      var_1->SetVarI(hdl_1_t,sigBckType);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // calculate the KNN errors for each kd-tree, if the object passed the cuts of any of the associated MLMs
+    // -----------------------------------------------------------------------------------------------------------
+    for(map < TMVA::kNN::ModulekNN*,vector<int> >::iterator Itr=getErrKNN.begin(); Itr!=getErrKNN.end(); ++Itr) {
+      bool passCutsKNN(false);
+      for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
+        if(passCutsV[nMLMinNow] && find(Itr->second.begin(),Itr->second.end(),nMLMv[nMLMinNow]) != Itr->second.end()) {
+          passCutsKNN = true; break;
+        }
+      }
+      if(passCutsKNN) getRegClsErrKNN(var_0,Itr->first,trgIndexV,Itr->second,!isCls,thr->regErrV,thr);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // evaluate all MLMs and fill the output tree
+    // -----------------------------------------------------------------------------------------------------------
+    for(int nMLMinNow=0; nMLMinNow<nMLMsIn; nMLMinNow++) {
+      int                           nMLMnow = nMLMv[nMLMinNow];
+      bool                          passCuts = passCutsV[nMLMinNow];
+      vector <VarMaps::VarHandle> & hdlV     = hdl_1[nMLMinNow];
+
+      // the reader variables are only updated from the formulae once per object
+      bool    forceUpdate = (nMLMinNow == 0);
+      double  mlmWgt      = var_0->GetForm(hdl_0_w[nMLMinNow]) * (passCuts?1:0);
+
+      // sanity check that weights are properly defined
+      if(mlmWgt < 0) { var_0->printVars(); VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false); }
+
+      if(isCls) {
+        double clsVal = getReader(var_0,ANNZ_readType::CLS,forceUpdate,nMLMnow,thr);
+        double clsPrb = getReader(var_0,ANNZ_readType::PRB,false,      nMLMnow,thr);
+
+        var_1->SetVarF(hdlV[hdlCls],clsVal); var_1->SetVarF(hdlV[hdlVal],clsPrb);
+      }
+      else {
+        double regVal = getReader(var_0,ANNZ_readType::REG,forceUpdate,nMLMnow,thr);
+
+        var_1->SetVarF(hdlV[hdlVal],regVal);
+      }
+      var_1->SetVarF(hdlV[hdlWgt],mlmWgt);
+      var_1->SetVarI(hdlV[hdlIdx],var_0->GetVarI(hdl_0_i));
+
+      if(needErr) {
+        if(isErrINPv[nMLMnow] && passCuts) getRegClsErrINP(var_0,!isCls,nMLMnow,&(thr->seedINP),&(thr->regErrV[nMLMnow]),thr);
+
+        var_1->SetVarF(hdlV[hdlErrN],thr->regErrV[nMLMnow][0]); var_1->SetVarF(hdlV[hdlErr],thr->regErrV[nMLMnow][1]);
+        var_1->SetVarF(hdlV[hdlErrP],thr->regErrV[nMLMnow][2]);
+      }
+    }
+
+    var_1->fillTree();
+
+    mayWriteObjects = true;
+  }
+
+  // write the remaining output, and restore the original output tree (see OutMngr::BeginTreeLoop())
+  thr->outputs->EndTreeLoop(); var_1->setTreeWrite(thr->treeOut);
+
+  hdl_1.clear(); hdl_0_w.clear(); baseCutsNameV.clear(); passCutsV.clear();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief            - Compute the separation parameter of a classification MLM from a "postTrain" chain.
+ *
+ * @param aChainOut  - A chain of postTrain trees, which contains the MLM, its weight and the signal/background type.
+ * @param nMLMnow    - The index of the MLM.
+ *
+ * @return           - The separation parameter, or -1 if it could not be computed.
+ */
+// ===========================================================================================================
+double ANNZ::getSeparationPostTrain(TChain * aChainOut, int nMLMnow) {
+// ===========================================================================================================
+  TString MLMname        = getTagName(nMLMnow);
+  TString MLMname_w      = getTagWeight(nMLMnow);
+  TString sigBckTypeName = glob->GetOptC("sigBckTypeName");
+  double  separation(-1);
+
+  aLOG(Log::INFO) <<coutBlue<<" - Will compute separation parameter for "<<coutGreen<<MLMname<<coutBlue
+                  <<" from "<<coutYellow<<aChainOut->GetName()<<coutDef<<endl;
+
+  TCanvas * tmpCnvs = new TCanvas("tmpCnvs","tmpCnvs");
+  TH1     * his1_sig(NULL), * his1_bck(NULL), * his_all(NULL);
+  for(int nSigBckNow=0; nSigBckNow<2; nSigBckNow++) {
+    TString sigBckName = (TString)((nSigBckNow == 0) ? "_sig" : "_bck");
+    TString sigBckCut  = (TString)((nSigBckNow == 0) ? "== 1" : "== 0");
+
+    // get common limits for the entire sample (net necessarily between zero and one if [useBinClsPrior==true])
+    if(nSigBckNow == 0) {
+      TString hisName    = (TString)"sepHis"+"_all";
+      TString drawExprs  = (TString)MLMname+">>"+hisName;
+      TString cutExprs   = (TString)"("+MLMname_w+" > 0)";
+      
+      int nEvtPass = utils->drawTree(aChainOut,drawExprs,cutExprs);
+      if(nEvtPass > 0) { his_all = (TH1F*)gDirectory->Get(hisName); his_all->BufferEmpty(); }
+    }
+    if(!his_all) continue;
+
+    int    nBins = 100;
+    double binL  = his_all->GetXaxis()->GetBinLowEdge(his_all->GetXaxis()->GetFirst());
+    double binH  = his_all->GetXaxis()->GetBinUpEdge (his_all->GetXaxis()->GetLast() );
+
+    TString hisName    = (TString)"sepHis"+sigBckName;
+    TH1     * his1_sb  = new TH1F(hisName,hisName,nBins,binL,binH); 
+    TString drawExprs  = (TString)MLMname+">>+"+hisName;
+    TString cutExprs   = (TString)"("+MLMname_w+" > 0) && ("+sigBckTypeName+sigBckCut+")";
+
+    int nEvtPass = utils->drawTree(aChainOut,drawExprs,cutExprs);
+
+    if(nEvtPass > 0) {
+      his1_sb->SetDirectory(0); his1_sb->BufferEmpty(); // allowed only after the chain fills the histogram
+      if(nSigBckNow == 0) his1_sig = his1_sb;
+      else                his1_bck = his1_sb;
+    }
+    else DELNULL(his1_sb);
+  }
+  DELNULL(tmpCnvs); DELNULL(his_all);
+
+  if(his1_sig && his1_bck) {
+    separation = getSeparation(his1_sig,his1_bck);
+
+    aLOG(Log::INFO)<<coutYellow<<" - Got separation parameter: "<<coutGreen<<separation<<coutDef<<endl;
+  }
+
+  DELNULL(his1_sig); DELNULL(his1_bck);
+
+  return separation;
+}
+
+// ===========================================================================================================
+/**
+ * @brief             - Save the configuration file of the "postTrain" trees of an MLM, which logs the creation
+ *                    time of the trees, the user-defined cuts and weights for _train, _valid, and the
+ *                    separation parameter (for classification).
+ *
+ * @param nMLMnow     - The index of the MLM.
+ * @param separation  - The separation parameter.
+ */
+// ===========================================================================================================
+void ANNZ::savePostTrainConfig(int nMLMnow, double separation) {
+// ===========================================================================================================
+  TString MLMname      = getTagName(nMLMnow);
+  TString saveFileName = getKeyWord(MLMname,"postTrain","configSaveFileName");
+
   aLOG(Log::INFO)<<coutYellow<<" - Saving file "<<coutGreen<<saveFileName<<coutYellow<<" to log the creation time of the trees, and"
                  <<" the user-defined cuts and weights for _train, _valid ..."<<coutDef<<endl;
 
@@ -838,13 +1404,11 @@ void  ANNZ::makeTreeRegClsOneMLM(int nMLMnow) {
   //cleanup
   optNames.clear(); DELNULL(optMap);
 
-  clearReaders();
-
-  aLOG(Log::INFO) <<coutWhiteOnBlack<<coutGreen<<" - ending makeTreeRegClsOneMLM() ... "<<coutDef<<endl;
   return;
 }
 
 
+
 // ===========================================================================================================
 /**
  * @brief                 - Compute the separation parameter between two distributions.
@@ -960,6 +1524,7 @@ void ANNZ::deriveHisClsPrb(int nMLMnow) {
   var_0->NewForm(MLMname_w,wgtStr);
 
   var_0->connectTreeBranchesForm(aChain,&readerInptV);
+  var_0->selectTreeBranches();
 
   // setup cuts for the vars we loop on for sig/bck determination
   setMethodCuts(var_0,nMLMnow);
@@ -1177,84 +1742,97 @@ TChain * ANNZ::mergeTreeFriends(
     }
   }
 
-  VarMaps * var_0 = new VarMaps(glob,utils,(TString)"inputTreeVars_0_"+inTreeName);
-  VarMaps * var_1 = new VarMaps(glob,utils,(TString)"inputTreeVars_1_"+inTreeName);
+  // merge by reading only the accepted branches of each chain, if no cuts or added formulae are requested
+  // -----------------------------------------------------------------------------------------------------------
+  bool hasAddForm = (dynamic_cast<vector< pair<TString,TString> >*>(addFormV) && (int)addFormV->size() > 0);
+  bool isFused    = (glob->GetOptB("fusedMergeFriends") && aCut == "" && !hasAddForm);
+  if(isFused) isFused = mergeTreeFriendsFused(aChain,acceptV,rejectV);
 
-  TTree * mergedTree = new TTree(inTreeName,inTreeName); mergedTree->SetDirectory(0);
-  outputs->TreeMap[inTreeName] = mergedTree;
+  if(!isFused) {
+    VarMaps * var_0 = new VarMaps(glob,utils,(TString)"inputTreeVars_0_"+inTreeName);
+    VarMaps * var_1 = new VarMaps(glob,utils,(TString)"inputTreeVars_1_"+inTreeName);
 
-  // if defined, setup formula from var_0 (will be unpdated every time a new tree entry is loaded)
-  // and then setup a new variable for var_1, the output VarMaps
-  // -----------------------------------------------------------------------------------------------------------
-  int nForms(0);
-  vector < vector<TString> > formNameV;
-  if(dynamic_cast<vector< pair<TString,TString> >*>(addFormV)) {
-    nForms = (int)addFormV->size();
-    formNameV.resize(nForms,vector<TString>(2,""));
+    TTree * mergedTree = new TTree(inTreeName,inTreeName); mergedTree->SetDirectory(0);
+    outputs->TreeMap[inTreeName] = mergedTree;
 
-    for(int nFormNow=0; nFormNow<nForms; nFormNow++) {
-      formNameV[nFormNow][0] = (TString)addFormV->at(nFormNow).first;
-      formNameV[nFormNow][1] = (TString)formNameV[nFormNow][0]+"_FRM"; 
+    // if defined, setup formula from var_0 (will be unpdated every time a new tree entry is loaded)
+    // and then setup a new variable for var_1, the output VarMaps
+    // -----------------------------------------------------------------------------------------------------------
+    int nForms(0);
+    vector < vector<TString> > formNameV;
+    if(dynamic_cast<vector< pair<TString,TString> >*>(addFormV)) {
+      nForms = (int)addFormV->size();
+      formNameV.resize(nForms,vector<TString>(2,""));
+
+      for(int nFormNow=0; nFormNow<nForms; nFormNow++) {
+        formNameV[nFormNow][0] = (TString)addFormV->at(nFormNow).first;
+        formNameV[nFormNow][1] = (TString)formNameV[nFormNow][0]+"_FRM"; 
 
-      VERIFY(LOCATION,(TString)"Found non-regularized variable name ["+formNameV[nFormNow][0]+"] ... something is "
-                              +"horribly wrong ?!?",(formNameV[nFormNow][0] == utils->regularizeName(formNameV[nFormNow][0])));
+        VERIFY(LOCATION,(TString)"Found non-regularized variable name ["+formNameV[nFormNow][0]+"] ... something is "
+                                +"horribly wrong ?!?",(formNameV[nFormNow][0] == utils->regularizeName(formNameV[nFormNow][0])));
 
-      var_0->NewForm(formNameV[nFormNow][1] , addFormV->at(nFormNow).second);
-      var_1->NewVarF(formNameV[nFormNow][0]);
+        var_0->NewForm(formNameV[nFormNow][1] , addFormV->at(nFormNow).second);
+        var_1->NewVarF(formNameV[nFormNow][0]);
 
-      aLOG(Log::DEBUG) <<coutYellow<<" - will add new variable \""<<coutGreen<<formNameV[nFormNow][0]<<coutYellow
-                       <<"\" from expression ("<<coutGreen<<addFormV->at(nFormNow).second<<coutYellow<<") ..."<<coutDef<<endl;
+        aLOG(Log::DEBUG) <<coutYellow<<" - will add new variable \""<<coutGreen<<formNameV[nFormNow][0]<<coutYellow
+                         <<"\" from expression ("<<coutGreen<<addFormV->at(nFormNow).second<<coutYellow<<") ..."<<coutDef<<endl;
+      }
     }
-  }
 
-  var_0->connectTreeBranches(aChain);
+    var_0->connectTreeBranches(aChain);
+    var_0->selectTreeBranches();
 
-  vector < pair<TString,TString> > varTypeNameV;
+    vector < pair<TString,TString> > varTypeNameV;
   
-  var_1->varStruct(var_0,acceptV,rejectV,&varTypeNameV);
-  var_1->createTreeBranches(mergedTree); 
-  var_1->setDefaultVals();
+    var_1->varStruct(var_0,acceptV,rejectV,&varTypeNameV);
+    var_1->createTreeBranches(mergedTree); 
+    var_1->setDefaultVals();
 
-  bool hasCut = (aCut != "");
-  if(hasCut) {
-    var_0->setTreeCuts("aCut",aCut);
-    aLOG(Log::DEBUG) <<coutYellow<<" - will use cuts: "<<coutGreen<<aCut<<coutYellow<<" ..."<<coutDef<<endl;
-   }
+    outputs->BeginTreeLoop();
 
-  bool  breakLoop(false), mayWriteObjects(false);
-  int   nObjectsToWrite(glob->GetOptI("nObjectsToWrite"));
-  var_0->clearCntr();
-  for(Long64_t loopEntry=0; true; loopEntry++) {
-    if(!var_0->getTreeEntry(loopEntry)) breakLoop = true;
+    bool hasCut = (aCut != "");
+    if(hasCut) {
+      var_0->setTreeCuts("aCut",aCut);
+      aLOG(Log::DEBUG) <<coutYellow<<" - will use cuts: "<<coutGreen<<aCut<<coutYellow<<" ..."<<coutDef<<endl;
+     }
 
-    if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
-      var_0->printCntr(inTreeName,Log::DEBUG); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
-      mayWriteObjects = false;
-    }
-    if(breakLoop) break;
+    bool  breakLoop(false), mayWriteObjects(false);
+    int   nObjectsToWrite(glob->GetOptI("nObjectsToWrite"));
+    var_0->clearCntr();
+    for(Long64_t loopEntry=0; true; loopEntry++) {
+      if(!var_0->getTreeEntry(loopEntry)) breakLoop = true;
+
+      if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
+        var_0->printCntr(inTreeName,Log::DEBUG); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
+        var_1->setTreeWrite(outputs->TreeMap[inTreeName]);
+        mayWriteObjects = false;
+      }
+      if(breakLoop) break;
 
-    if(hasCut) { if(var_0->hasFailedTreeCuts("aCut")) continue; }
+      if(hasCut) { if(var_0->hasFailedTreeCuts("aCut")) continue; }
+
+      var_1->copyVarData(var_0,&varTypeNameV);
+
+      // if defined, set the added variables from the list formulae (after the copy from var_0!)
+      for(int nFormNow=0; nFormNow<nForms; nFormNow++) {
+        var_1->SetVarF(formNameV[nFormNow][0] , var_0->GetForm(formNameV[nFormNow][1]));
+      }
 
-    var_1->copyVarData(var_0,&varTypeNameV);
+      var_1->fillTree();
 
-    // if defined, set the added variables from the list formulae (after the copy from var_0!)
-    for(int nFormNow=0; nFormNow<nForms; nFormNow++) {
-      var_1->SetVarF(formNameV[nFormNow][0] , var_0->GetForm(formNameV[nFormNow][1]));
+      var_0->IncCntr("nObj"); mayWriteObjects = true;
     }
+    if(!breakLoop) { var_0->printCntr(inTreeName,Log::DEBUG); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
 
-    var_1->fillTree();
+    outputs->EndTreeLoop(); var_1->setTreeWrite(mergedTree);
 
-    var_0->IncCntr("nObj"); mayWriteObjects = true;
-  }
-  if(!breakLoop) { var_0->printCntr(inTreeName,Log::DEBUG); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
+    DELNULL(var_0); DELNULL(var_1); varTypeNameV.clear(); formNameV.clear();
 
-  DELNULL(var_0); DELNULL(var_1); varTypeNameV.clear();
+    DELNULL(mergedTree); outputs->TreeMap.erase(inTreeName);
+  }
 
   for(int nFriendNow=0; nFriendNow<(int)aChainFriendV.size(); nFriendNow++) DELNULL(aChainFriendV[nFriendNow]);
   aChainFriendV.clear();
-  formNameV.clear();
-
-  DELNULL(mergedTree); outputs->TreeMap.erase(inTreeName);
 
   aLOG(Log::DEBUG) <<coutRed<<" - Created new chain (using added friend trees)  "<<coutGreen<<inTreeName
                    <<coutRed<<"  from  "<<coutBlue<<inFileName<<coutDef<<endl;
@@ -1263,6 +1841,214 @@ TChain * ANNZ::mergeTreeFriends(
   return aChainOut;
 }
 
+// ===========================================================================================================
+/**
+ * @brief          - Merge a chain with its friends (set up by mergeTreeFriends()), for the case of no cuts or added formulae.
+ *
+ * @details        - Instead of loading each entry of the primary chain and of all of its friends, and then copying the
+ *                 accepted variables to the output variables, each branch of the output tree is read directly (into
+ *                 the variables which are written to the output) from the first chain in which it is found. All other
+ *                 branches are deactivated, and the active branches of each chain are added to a read-cache, which
+ *                 is filled in blocks over the range of entries of the current output file. The output files (with
+ *                 nObjectsToWrite objects each, and with the same names as for the serial loop) are written in parallel
+ *                 by up to nThreads threads, where each thread uses its own copies of the chains.
+ *
+ * @param aChain   - The primary chain, including its friends.
+ * @param acceptV  - If [acceptV != NULL], it will act as a list of variables which will be added to the merged tree.
+ * @param rejectV  - If [rejectV != NULL], it will act as a list of variables which will be excluded from the merged tree.
+ *
+ * @return         - False if not all of the friends of aChain are chains (in which case nothing is done), true otherwise.
+ */
+// ===========================================================================================================
+bool ANNZ::mergeTreeFriendsFused(TChain * aChain, vector <TString> * acceptV, vector <TString> * rejectV) {
+// =======================================================================================================
+  // the primary chain and its friends - the branches of each chain are read independently
+  // -----------------------------------------------------------------------------------------------------------
+  vector <TChain*> srcChainV(1,aChain);
+  vector <TTree*>  friendV = utils->getTreeFriends(aChain);
+  for(int nFriendNow=0; nFriendNow<(int)friendV.size(); nFriendNow++) {
+    TChain * chainFriend = dynamic_cast<TChain*>(friendV[nFriendNow]);
+    if(!chainFriend) return false;
+
+    srcChainV.push_back(chainFriend);
+  }
+  friendV.clear();
+
+  TString  inTreeName      = (TString)aChain->GetName();
+  Long64_t nEntriesChain   = aChain->GetEntries();
+  int      nObjectsToWrite = glob->GetOptI("nObjectsToWrite");
+  int      nThreads        = ThreadPool::getNumThreads(glob->GetOptI("nThreads"));
+  Long64_t cacheBytes      = (Long64_t)glob->GetOptI("treeCacheMB") * 1024 * 1024;
+
+  for(int nSrcNow=1; nSrcNow<(int)srcChainV.size(); nSrcNow++) {
+    VERIFY(LOCATION,(TString)"Main and friend chains have different numbers of entries ... Something is horribly wrong !!!"
+                   ,(srcChainV[nSrcNow]->GetEntries() == nEntriesChain));
+  }
+
+  // derive the output variables as in the serial loop of mergeTreeFriends(), and assign each variable to the
+  // first chain in which it is found (following the registration of branches in VarMaps::connectTreeBranches())
+  // -----------------------------------------------------------------------------------------------------------
+  VarMaps * var_0 = new VarMaps(glob,utils,(TString)"inputTreeVars_0_"+inTreeName);
+  VarMaps * var_1 = new VarMaps(glob,utils,(TString)"inputTreeVars_1_"+inTreeName);
+
+  vector < pair<TString,TString> > varTypeNameV;
+
+  var_0->connectTreeBranches(aChain);
+  var_1->varStruct(var_0,acceptV,rejectV,&varTypeNameV);
+  DELNULL(var_0);
+
+  map <TString,int> srcOfBranchM;
+  for(int nVarNow=0; nVarNow<(int)varTypeNameV.size(); nVarNow++) srcOfBranchM[varTypeNameV[nVarNow].second] = -1;
+
+  vector <int>               srcInV;
+  vector < vector<TString> > srcBranchV(srcChainV.size());
+  for(int nSrcNow=0; nSrcNow<(int)srcChainV.size(); nSrcNow++) {
+    TObjArray * brnchList = srcChainV[nSrcNow]->GetListOfBranches();
+    if(!dynamic_cast<TObjArray*>(brnchList)) continue;
+
+    for(int nBrnchNow=0; nBrnchNow<=brnchList->GetLast(); nBrnchNow++) {
+      TString brnchName = ((TBranch*)(brnchList->At(nBrnchNow)))->GetName();
+
+      map <TString,int>::iterator itr = srcOfBranchM.find(brnchName);
+      if(itr == srcOfBranchM.end() || itr->second >= 0)    continue;
+      if(!srcChainV[nSrcNow]->GetBranchStatus(brnchName)) continue;
+
+      itr->second = nSrcNow; srcBranchV[nSrcNow].push_back(brnchName);
+    }
+    // chains which do not provide any of the output variables are not read at all
+    if(srcBranchV[nSrcNow].size() > 0) srcInV.push_back(nSrcNow);
+  }
+
+  for(map <TString,int>::iterator itr=srcOfBranchM.begin(); itr!=srcOfBranchM.end(); ++itr) {
+    VERIFY(LOCATION,(TString)"Could not find the source chain of variable \""+itr->first+"\" ... Something is horribly wrong !!!"
+                   ,(itr->second >= 0));
+  }
+
+  int      nSrcIn          = (int)srcInV.size();
+  int      nSegs           = static_cast<int>((nEntriesChain + nObjectsToWrite - 1) / nObjectsToWrite);
+  int      nThreadsNow     = max(min(nThreads,nSegs),1);
+  int      outFileIndex0   = outputs->OutputTreeFileIndex;
+  Long64_t cacheBytesChain = (cacheBytes > 0 && nSrcIn > 0) ? max(cacheBytes / nSrcIn,(Long64_t)(1024 * 1024)) : 0;
+
+  aLOG(Log::INFO) <<coutBlue<<" - will merge "<<coutYellow<<varTypeNameV.size()<<coutBlue<<" branches from "<<coutYellow<<nSrcIn
+                  <<coutBlue<<" (out of "<<coutYellow<<srcChainV.size()<<coutBlue<<") chains into "<<coutYellow<<nSegs
+                  <<coutBlue<<" files using "<<coutYellow<<nThreadsNow<<coutBlue<<" threads ..."<<coutDef<<endl;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // setup the containers of each thread - each thread has its own vars, copies of the input chains,
+  // output tree and output manager. the vars are shared between the input and the output trees
+  // -----------------------------------------------------------------------------------------------------------
+  vector <Utils*>            utilsV  (nThreadsNow,NULL);
+  vector <OutMngr*>          outputsV(nThreadsNow,NULL);
+  vector <VarMaps*>          varV    (nThreadsNow,NULL);
+  vector <TTree*>            treeOutV(nThreadsNow,NULL);
+  vector < vector<TChain*> > chainV  (nThreadsNow,vector<TChain*>(nSrcIn,NULL));
+
+  for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+    utilsV  [nThreadNow] = new Utils(glob);
+    outputsV[nThreadNow] = new OutMngr((TString)"outputs_"+utils->intToStr(nThreadNow),utilsV[nThreadNow],glob);
+
+    outputsV[nThreadNow]->SetOutDirName(outputs->GetOutDirName());
+    outputsV[nThreadNow]->treeFileTag = outputs->treeFileTag;
+
+    varV[nThreadNow] = new VarMaps(glob,utilsV[nThreadNow],(TString)"mergeTreeVars_"+utils->intToStr(nThreadNow));
+    varV[nThreadNow]->varStruct(var_1);
+
+    treeOutV[nThreadNow] = new TTree(inTreeName,inTreeName); treeOutV[nThreadNow]->SetDirectory(0);
+    outputsV[nThreadNow]->TreeMap[inTreeName] = treeOutV[nThreadNow];
+
+    varV[nThreadNow]->createTreeBranches(treeOutV[nThreadNow]);
+    varV[nThreadNow]->setDefaultVals();
+
+    outputsV[nThreadNow]->BeginTreeLoop(false,false);
+
+    for(int nSrcInNow=0; nSrcInNow<nSrcIn; nSrcInNow++) {
+      int      nSrcNow  = srcInV[nSrcInNow];
+      TChain * chainNow = utils->cloneChain(srcChainV[nSrcNow],false);
+
+      varV[nThreadNow]->connectTreeBranchesList(chainNow,srcBranchV[nSrcNow]);
+
+      if(cacheBytesChain > 0) {
+        chainNow->SetCacheSize(cacheBytesChain);
+        chainNow->LoadTree(0);
+        for(int nBrnchNow=0; nBrnchNow<(int)srcBranchV[nSrcNow].size(); nBrnchNow++) {
+          chainNow->AddBranchToCache(srcBranchV[nSrcNow][nBrnchNow],true);
+        }
+        chainNow->StopCacheLearningPhase();
+      }
+
+      chainV[nThreadNow][nSrcInNow] = chainNow;
+    }
+  }
+  DELNULL(var_1);
+
+  // -----------------------------------------------------------------------------------------------------------
+  // each thread takes the next available output file, reads its range of entries from each of the
+  // input chains, and writes the output file with the same index as in the serial loop
+  // -----------------------------------------------------------------------------------------------------------
+  std::atomic<int> nSegNext(0);
+
+  auto mergeSegs = [&](int nThreadNow) {
+    OutMngr * outputsNow = outputsV[nThreadNow];
+    TTree   * treeOut    = treeOutV[nThreadNow];
+
+    for(int nSegNow=nSegNext++; nSegNow<nSegs; nSegNow=nSegNext++) {
+      Long64_t entryMin = (Long64_t)nSegNow * nObjectsToWrite;
+      Long64_t entryMax = min(entryMin + nObjectsToWrite,nEntriesChain);
+
+      for(int nSrcInNow=0; nSrcInNow<nSrcIn; nSrcInNow++) {
+        if(cacheBytesChain > 0) chainV[nThreadNow][nSrcInNow]->SetCacheEntryRange(entryMin,entryMax);
+      }
+
+      for(Long64_t loopEntry=entryMin; loopEntry<entryMax; loopEntry++) {
+        for(int nSrcInNow=0; nSrcInNow<nSrcIn; nSrcInNow++) {
+          VERIFY(LOCATION,(TString)"Could not read entry "+TString::Format("%lld",loopEntry)+" of chain "+inTreeName+" ..."
+                         ,(chainV[nThreadNow][nSrcInNow]->GetEntry(loopEntry) > 0));
+        }
+        treeOut->Fill();
+      }
+
+      outputsNow->OutputTreeFileIndex = outFileIndex0 + nSegNow;
+      outputsNow->WriteOutObjects(false,true); outputsNow->ResetObjects();
+
+      // with asyncTreeWrite, the next segment is filled in the second buffer of the output manager
+      treeOut = outputsNow->TreeMap[inTreeName];
+    }
+  };
+
+  if(nThreadsNow == 1) {
+    mergeSegs(0);
+  }
+  else {
+    ThreadPool * threadPool = new ThreadPool(nThreadsNow);
+    for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+      threadPool->push([&mergeSegs,nThreadNow]() { mergeSegs(nThreadNow); });
+    }
+    threadPool->wait();
+    DELNULL(threadPool);
+  }
+
+  // the main output manager continues with the index of the next output file
+  outputs->OutputTreeFileIndex = outFileIndex0 + nSegs;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // cleanup
+  // -----------------------------------------------------------------------------------------------------------
+  for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+    outputsV[nThreadNow]->EndTreeLoop();
+
+    for(int nSrcInNow=0; nSrcInNow<nSrcIn; nSrcInNow++) DELNULL(chainV[nThreadNow][nSrcInNow]);
+
+    DELNULL(varV[nThreadNow]);
+    outputsV[nThreadNow]->TreeMap.erase(inTreeName); DELNULL(treeOutV[nThreadNow]);
+    DELNULL(outputsV[nThreadNow]); DELNULL(utilsV[nThreadNow]);
+  }
+  utilsV.clear(); outputsV.clear(); varV.clear(); treeOutV.clear(); chainV.clear();
+  srcChainV.clear(); srcInV.clear(); srcBranchV.clear(); srcOfBranchM.clear(); varTypeNameV.clear();
+
+  return true;
+}
+
 // ===========================================================================================================
 /**
  * @brief         - Extract the names of all "index" variables from a chain (e.g., those given by getTagIndex()),
@@ -0,0 +1,866 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+// ===========================================================================================================
+// helper functions for parsing the TMVA XML weight files, and for the activation functions of the MLP
+// ===========================================================================================================
+namespace nativeFuncs {
+  // parse an attribute of an XML node (using the same conversion as TMVA::Tools::ReadAttr())
+  template <class T> bool getAttr(TXMLEngine & xml, XMLNodePointer_t node, const char * attName, T & val) {
+    const char * attVal = xml.GetAttr(node,attName);
+    if(!attVal) return false;
+
+    std::stringstream ss(attVal); ss >> val;
+    return true;
+  }
+  bool getAttr(TXMLEngine & xml, XMLNodePointer_t node, const char * attName, TString & val) {
+    const char * attVal = xml.GetAttr(node,attName);
+    if(!attVal) return false;
+
+    val = attVal;
+    return true;
+  }
+
+  // get the first child of a node with a given name
+  XMLNodePointer_t getChild(TXMLEngine & xml, XMLNodePointer_t node, TString childName) {
+    if(!node) return NULL;
+    for(XMLNodePointer_t childNode = xml.GetChild(node); childNode; childNode = xml.GetNext(childNode)) {
+      if(childName == (TString)xml.GetNodeName(childNode)) return childNode;
+    }
+    return NULL;
+  }
+
+  // get the content of a node as a list of numbers
+  void getContentV(TXMLEngine & xml, XMLNodePointer_t node, vector <double> & valV) {
+    valV.clear();
+    const char * content = xml.GetNodeContent(node);
+    if(!content) return;
+
+    std::stringstream ss(content); double val(0);
+    while(ss >> val) valV.push_back(val);
+    return;
+  }
+
+  // hyperbolic tangent, using the same rational approximation as TMVA::TActivationTanh
+  inline double fastTanh(double arg) {
+    if(arg >  4.97) return  1;
+    if(arg < -4.97) return -1;
+    float arg2 = arg * arg;
+    float a    = arg * (135135.0f + arg2 * (17325.0f + arg2 * (378.0f + arg2)));
+    float b    = 135135.0f + arg2 * (62370.0f + arg2 * (3150.0f + arg2 * 28.0f));
+    return a/b;
+  }
+
+  // apply an activation function to an array of neuron inputs (separate loops, so that each may be vectorised)
+  inline void activate(NativeMLM::ActType actType, double * valV, int nVals) {
+    if     (actType == NativeMLM::SIGMOID) { for(int n=0; n<nVals; n++) valV[n] = 1. / (1. + exp(-valV[n]));     }
+    else if(actType == NativeMLM::TANH)    { for(int n=0; n<nVals; n++) valV[n] = fastTanh(valV[n]);               }
+    else if(actType == NativeMLM::RADIAL)  { for(int n=0; n<nVals; n++) valV[n] = exp(-valV[n] * valV[n] * 0.5);   }
+    return;
+  }
+}
+
+
+// ===========================================================================================================
+NativeMLM::NativeMLM() {
+// =====================
+  type      = NON;       isReg     = false;  isYesNoLeaf  = true; nVars = 0;
+  actHidden = SIGMOID;   actOutput = LINEAR; maxLayerSize = 0;    boostType = AVG;
+  return;
+}
+
+// ===========================================================================================================
+NativeMLM::~NativeMLM() {
+// ======================
+  varMinV   .clear(); varMaxV   .clear(); transTypeV  .clear(); transVarV   .clear(); transNormV.clear();
+  transParV .clear(); trgNormV  .clear(); layerSizeV  .clear(); layerWgtV   .clear(); nodeVarV  .clear();
+  nodeLeftV .clear(); nodeRightV.clear(); treeRootV   .clear(); nodeCutV    .clear(); nodeCutTypeV.clear();
+  nodeValV  .clear(); treeWgtV  .clear();
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief             - Load a trained MLM from a TMVA XML weight file.
+ *
+ * @param xmlFileName - The name of the XML weight file.
+ * @param failMsg     - Holds a description of the reason for failure, if the method (or one of its
+ *                    settings) is not supported.
+ *
+ * @return            - Flag indicating if the MLM was loaded successfully.
+ */
+// ===========================================================================================================
+bool NativeMLM::load(TString xmlFileName, TString & failMsg) {
+// ===========================================================================================================
+  failMsg = "";
+
+  TXMLEngine      xml;
+  XMLDocPointer_t doc = xml.ParseFile(xmlFileName,TMVA::gTools().xmlenginebuffersize());
+  if(!doc) { failMsg = (TString)"could not parse "+xmlFileName; return false; }
+
+  bool isGood = loadXML(xml,xml.DocGetRootElement(doc),failMsg);
+
+  xml.FreeDoc(doc);
+  return isGood;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Parse the general settings, the input-variable transformations and the weights of an MLM
+ *                 from the root node of a TMVA XML weight file.
+ *
+ * @param xml      - The XML engine.
+ * @param rootNode - The root node of the parsed weight file.
+ * @param failMsg  - Holds a description of the reason for failure.
+ *
+ * @return         - Flag indicating if the MLM was loaded successfully.
+ */
+// ===========================================================================================================
+bool NativeMLM::loadXML(TXMLEngine & xml, XMLNodePointer_t rootNode, TString & failMsg) {
+// ===========================================================================================================
+  using namespace nativeFuncs;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // method type (e.g., "MLP::ANNZ_0") and analysis type
+  // -----------------------------------------------------------------------------------------------------------
+  TString methodName("");
+  if(!rootNode || !getAttr(xml,rootNode,"Method",methodName)) { failMsg = "no method definition found"; return false; }
+
+  TString methodType = methodName(0,methodName.First(':'));
+  if     (methodType == "MLP") type = MLP;
+  else if(methodType == "BDT") type = BDT;
+  else { failMsg = (TString)"method type \""+methodType+"\" is not supported"; return false; }
+
+  TString anlysType("");
+  XMLNodePointer_t infoNode = getChild(xml,rootNode,"GeneralInfo");
+  for(XMLNodePointer_t node = (infoNode ? xml.GetChild(infoNode) : NULL); node; node = xml.GetNext(node)) {
+    TString infoName(""); getAttr(xml,node,"name",infoName);
+    if(infoName == "AnalysisType") getAttr(xml,node,"value",anlysType);
+  }
+  if     (anlysType == "Regression")     isReg = true;
+  else if(anlysType == "Classification") isReg = false;
+  else { failMsg = (TString)"analysis type \""+anlysType+"\" is not supported"; return false; }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // the options of the method
+  // -----------------------------------------------------------------------------------------------------------
+  map <TString,TString> optM;
+  XMLNodePointer_t optsNode = getChild(xml,rootNode,"Options");
+  for(XMLNodePointer_t node = (optsNode ? xml.GetChild(optsNode) : NULL); node; node = xml.GetNext(node)) {
+    TString optName(""); getAttr(xml,node,"name",optName);
+    const char * content = xml.GetNodeContent(node);
+    optM[optName] = (TString)(content ? content : "");
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // input variables and the regression target
+  // -----------------------------------------------------------------------------------------------------------
+  vector <TString> varLabelV, trgLabelV;
+
+  XMLNodePointer_t varsNode = getChild(xml,rootNode,"Variables");
+  for(XMLNodePointer_t node = (varsNode ? xml.GetChild(varsNode) : NULL); node; node = xml.GetNext(node)) {
+    TString label(""); double minVal(0), maxVal(0);
+    getAttr(xml,node,"Label",label); getAttr(xml,node,"Min",minVal); getAttr(xml,node,"Max",maxVal);
+
+    varLabelV.push_back(label); varMinV.push_back(minVal); varMaxV.push_back(maxVal);
+  }
+  nVars = (int)varLabelV.size();
+  if(nVars == 0) { failMsg = "no input variables found"; return false; }
+
+  XMLNodePointer_t trgsNode = getChild(xml,rootNode,"Targets");
+  for(XMLNodePointer_t node = (trgsNode ? xml.GetChild(trgsNode) : NULL); node; node = xml.GetNext(node)) {
+    TString label(""); getAttr(xml,node,"Label",label); trgLabelV.push_back(label);
+  }
+  if(isReg && (int)trgLabelV.size() != 1) { failMsg = "only a single regression target is supported"; return false; }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // variable transformations
+  // -----------------------------------------------------------------------------------------------------------
+  XMLNodePointer_t trfsNode = getChild(xml,rootNode,"Transformations");
+  for(XMLNodePointer_t trfNode = (trfsNode ? xml.GetChild(trfsNode) : NULL); trfNode; trfNode = xml.GetNext(trfNode)) {
+    if(!loadTrans(xml,trfNode,varLabelV,trgLabelV,failMsg)) return false;
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // the weights
+  // -----------------------------------------------------------------------------------------------------------
+  XMLNodePointer_t wgtNode = getChild(xml,rootNode,"Weights");
+  if(!wgtNode) { failMsg = "no weights found"; return false; }
+
+  if(type == MLP) return loadMLP(xml,wgtNode,optM,failMsg);
+  else            return loadBDT(xml,wgtNode,optM,failMsg);
+}
+
+// ===========================================================================================================
+/**
+ * @brief           - Parse a single input-variable transformation (Normalize, PCA or Decorrelation). For all
+ *                  transformations, the parameters of the last class (all classes combined) are used, as
+ *                  is done by TMVA::Reader.
+ *
+ * @param xml       - The XML engine.
+ * @param trfNode   - The node of the transformation.
+ * @param varLabelV - The labels of the input variables.
+ * @param trgLabelV - The labels of the regression targets.
+ * @param failMsg   - Holds a description of the reason for failure.
+ *
+ * @return          - Flag indicating if the transformation was loaded successfully.
+ */
+// ===========================================================================================================
+bool NativeMLM::loadTrans(TXMLEngine & xml, XMLNodePointer_t trfNode, vector <TString> & varLabelV,
+                          vector <TString> & trgLabelV, TString & failMsg) {
+// ===========================================================================================================
+  using namespace nativeFuncs;
+
+  TString trfName(""); getAttr(xml,trfNode,"Name",trfName);
+
+  TransType transType(NORM);
+  if     (trfName == "Normalize")     transType = NORM;
+  else if(trfName == "PCA")           transType = PCA;
+  else if(trfName == "Decorrelation") transType = DECORR;
+  else { failMsg = (TString)"variable transformation \""+trfName+"\" is not supported"; return false; }
+
+  // the selected inputs of the transformation, as indices of the input variables (or of the target)
+  XMLNodePointer_t inptNode = getChild(xml,getChild(xml,trfNode,"Selection"),"Input");
+  if(!inptNode) { failMsg = (TString)"no input selection found for \""+trfName+"\" (old TMVA format ?)"; return false; }
+
+  vector <int> varIndexV;
+  int          trgPos(-1), nSel(0);
+  for(XMLNodePointer_t node = xml.GetChild(inptNode); node; node = xml.GetNext(node), nSel++) {
+    TString inptType(""), label("");
+    getAttr(xml,node,"Type",inptType); getAttr(xml,node,"Label",label);
+
+    int index = -1;
+    if(inptType == "Variable") {
+      for(int nVarNow=0; nVarNow<nVars; nVarNow++) { if(varLabelV[nVarNow] == label) { index = nVarNow; break; } }
+      if(index >= 0) { varIndexV.push_back(index); continue; }
+    }
+    else if(inptType == "Target" && isReg && trgLabelV[0] == label) { trgPos = nSel; continue; }
+
+    failMsg = (TString)"unsupported input (\""+inptType+"\" , \""+label+"\") for \""+trfName+"\""; return false;
+  }
+  int nSelVar = (int)varIndexV.size();
+
+  if(transType != NORM && trgPos >= 0) { failMsg = (TString)"transformation of the target with \""+trfName+"\" is not supported"; return false; }
+
+  vector <Float_t> normV;
+  vector <double>  parV;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // Normalize - the ranges of the selected inputs, where [Index] is the position in the selection
+  // -----------------------------------------------------------------------------------------------------------
+  if(transType == NORM) {
+    vector <Float_t> minV(nSel,0), maxV(nSel,0);
+    int              clsIndexMax(-1);
+
+    for(XMLNodePointer_t clsNode = xml.GetChild(trfNode); clsNode; clsNode = xml.GetNext(clsNode)) {
+      if((TString)xml.GetNodeName(clsNode) != "Class") continue;
+
+      int clsIndex(0); getAttr(xml,clsNode,"ClassIndex",clsIndex);
+      if(clsIndex < clsIndexMax) continue;
+      clsIndexMax = clsIndex;
+
+      XMLNodePointer_t rangesNode = getChild(xml,clsNode,"Ranges");
+      for(XMLNodePointer_t node = (rangesNode ? xml.GetChild(rangesNode) : NULL); node; node = xml.GetNext(node)) {
+        int index(-1); getAttr(xml,node,"Index",index);
+        if(index < 0 || index >= nSel) { failMsg = "inconsistent ranges for \"Normalize\""; return false; }
+
+        getAttr(xml,node,"Min",minV[index]); getAttr(xml,node,"Max",maxV[index]);
+      }
+    }
+    if(clsIndexMax < 0) { failMsg = "no ranges found for \"Normalize\""; return false; }
+
+    // the offset and scale are derived as in TMVA::VariableNormalizeTransform (with single precision)
+    for(int nSelNow=0; nSelNow<nSel; nSelNow++) {
+      Float_t offset = minV[nSelNow];
+      Float_t scale  = 1.0/(maxV[nSelNow] - minV[nSelNow]);
+
+      if(nSelNow == trgPos) { trgNormV.push_back(pair<Float_t,Float_t>(offset,scale)); continue; }
+
+      normV.push_back(offset); normV.push_back(scale);
+    }
+  }
+  // -----------------------------------------------------------------------------------------------------------
+  // PCA - the means and the eigenvectors, where [x'_i = sum_j (x_j - mean_j) * eigen_ji]
+  // -----------------------------------------------------------------------------------------------------------
+  else if(transType == PCA) {
+    vector <double> meanV, eigenV, valV;
+    int             clsIndexMean(-1), clsIndexEigen(-1);
+
+    for(XMLNodePointer_t node = xml.GetChild(trfNode); node; node = xml.GetNext(node)) {
+      TString nodeName = xml.GetNodeName(node);
+      int     clsIndex(0); getAttr(xml,node,"ClassIndex",clsIndex);
+
+      if     (nodeName == "Statistics"   && clsIndex >= clsIndexMean ) { getContentV(xml,node,meanV ); clsIndexMean  = clsIndex; }
+      else if(nodeName == "Eigenvectors" && clsIndex >= clsIndexEigen) { getContentV(xml,node,eigenV); clsIndexEigen = clsIndex; }
+    }
+    if((int)meanV.size() != nSelVar || (int)eigenV.size() != nSelVar*nSelVar) {
+      failMsg = "inconsistent parameters for \"PCA\""; return false;
+    }
+
+    parV = meanV; parV.insert(parV.end(),eigenV.begin(),eigenV.end());
+  }
+  // -----------------------------------------------------------------------------------------------------------
+  // Decorrelation - the decorrelation matrix, where [x'_i = sum_j matrix_ij * x_j]
+  // -----------------------------------------------------------------------------------------------------------
+  else if(transType == DECORR) {
+    for(XMLNodePointer_t node = xml.GetChild(trfNode); node; node = xml.GetNext(node)) {
+      if((TString)xml.GetNodeName(node) == "Matrix") getContentV(xml,node,parV);
+    }
+    if((int)parV.size() != nSelVar*nSelVar) { failMsg = "inconsistent parameters for \"Decorrelation\""; return false; }
+  }
+
+  transTypeV.push_back(transType); transVarV.push_back(varIndexV);
+  transNormV.push_back(normV);     transParV.push_back(parV);
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Parse the layout and the synapse weights of an MLP. In the XML file, each neuron holds the
+ *                weights of its links to the (non-bias) neurons of the following layer, and the last neuron
+ *                of each layer (except for the output layer) is a bias neuron.
+ *
+ * @param xml     - The XML engine.
+ * @param wgtNode - The node of the weights.
+ * @param optM    - The options of the method.
+ * @param failMsg - Holds a description of the reason for failure.
+ *
+ * @return        - Flag indicating if the MLP was loaded successfully.
+ */
+// ===========================================================================================================
+bool NativeMLM::loadMLP(TXMLEngine & xml, XMLNodePointer_t wgtNode, map <TString,TString> & optM, TString & failMsg) {
+// ===========================================================================================================
+  using namespace nativeFuncs;
+
+  TString neuronType  = (optM.find("NeuronType")      != optM.end()) ? optM["NeuronType"]      : "sigmoid";
+  TString neuronInput = (optM.find("NeuronInputType") != optM.end()) ? optM["NeuronInputType"] : "sum";
+  neuronType.ReplaceAll(" ",""); neuronInput.ReplaceAll(" ","");
+
+  if(neuronInput != "sum") { failMsg = (TString)"NeuronInputType \""+neuronInput+"\" is not supported"; return false; }
+
+  if     (neuronType == "sigmoid") actHidden = SIGMOID;
+  else if(neuronType == "tanh")    actHidden = TANH;
+  else if(neuronType == "linear")  actHidden = LINEAR;
+  else if(neuronType == "radial")  actHidden = RADIAL;
+  else { failMsg = (TString)"NeuronType \""+neuronType+"\" is not supported"; return false; }
+
+  // the output neuron is linear for regression (MSE estimator) and a sigmoid for classification (CE estimator)
+  actOutput = isReg ? LINEAR : SIGMOID;
+
+  // the weights of all neurons, per layer
+  vector < vector < vector<double> > > neuronWgtV;
+
+  XMLNodePointer_t layoutNode = getChild(xml,wgtNode,"Layout");
+  for(XMLNodePointer_t layerNode = (layoutNode ? xml.GetChild(layoutNode) : NULL); layerNode; layerNode = xml.GetNext(layerNode)) {
+    if((TString)xml.GetNodeName(layerNode) != "Layer") continue;
+
+    neuronWgtV.push_back(vector < vector<double> >());
+    for(XMLNodePointer_t node = xml.GetChild(layerNode); node; node = xml.GetNext(node)) {
+      vector <double> wgtV; getContentV(xml,node,wgtV);
+      neuronWgtV.back().push_back(wgtV);
+    }
+  }
+
+  int nLayers = (int)neuronWgtV.size();
+  if(nLayers < 2) { failMsg = "found less than two layers"; return false; }
+
+  layerSizeV.resize(nLayers,0); maxLayerSize = 0;
+  for(int nLayerNow=0; nLayerNow<nLayers; nLayerNow++) {
+    layerSizeV[nLayerNow] = (int)neuronWgtV[nLayerNow].size() - ((nLayerNow < nLayers-1) ? 1 : 0);
+    maxLayerSize          = max(maxLayerSize,layerSizeV[nLayerNow]);
+  }
+  if(layerSizeV[0]         != nVars) { failMsg = "inconsistent size of the input layer";  return false; }
+  if(layerSizeV[nLayers-1] != 1)     { failMsg = "only a single output neuron is supported"; return false; }
+
+  // store the weights as [nOut][nIn+1], so that the weights of each neuron with respect to the previous layer are contiguous
+  layerWgtV.resize(nLayers-1);
+  for(int nLayerNow=0; nLayerNow<nLayers-1; nLayerNow++) {
+    int nIn  = layerSizeV[nLayerNow];
+    int nOut = layerSizeV[nLayerNow+1];
+
+    layerWgtV[nLayerNow].resize(nOut*(nIn+1),0);
+    for(int nInNow=0; nInNow<nIn+1; nInNow++) {
+      vector <double> & wgtV = neuronWgtV[nLayerNow][nInNow];
+      if((int)wgtV.size() != nOut) { failMsg = "inconsistent number of synapses"; return false; }
+
+      for(int nOutNow=0; nOutNow<nOut; nOutNow++) layerWgtV[nLayerNow][nOutNow*(nIn+1) + nInNow] = wgtV[nOutNow];
+    }
+  }
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Parse the trees of a BDT into flat node tables.
+ *
+ * @param xml     - The XML engine.
+ * @param wgtNode - The node of the weights.
+ * @param optM    - The options of the method.
+ * @param failMsg - Holds a description of the reason for failure.
+ *
+ * @return        - Flag indicating if the BDT was loaded successfully.
+ */
+// ===========================================================================================================
+bool NativeMLM::loadBDT(TXMLEngine & xml, XMLNodePointer_t wgtNode, map <TString,TString> & optM, TString & failMsg) {
+// ===========================================================================================================
+  using namespace nativeFuncs;
+
+  TString boostName  = (optM.find("BoostType")    != optM.end()) ? optM["BoostType"]    : "AdaBoost";
+  TString yesNoLeaf  = (optM.find("UseYesNoLeaf") != optM.end()) ? optM["UseYesNoLeaf"] : "True";
+  boostName.ReplaceAll(" ",""); yesNoLeaf.ReplaceAll(" ","");
+
+  if     (boostName == "Grad")                                boostType = GRAD;
+  else if(boostName == "AdaBoostR2" && isReg)                 boostType = ADAR2;
+  else if(boostName == "AdaBoost"   || boostName == "Bagging") boostType = AVG;
+  else { failMsg = (TString)"BoostType \""+boostName+"\" is not supported"; return false; }
+
+  isYesNoLeaf = !(yesNoLeaf == "False" || yesNoLeaf == "F" || yesNoLeaf == "0");
+
+  // the trees return the response of the leaf for regression and for gradient boosting, and
+  // otherwise either the node-type (+-1) or the purity of the leaf
+  bool useResponse = (isReg || boostType == GRAD);
+
+  for(XMLNodePointer_t treeNode = xml.GetChild(wgtNode); treeNode; treeNode = xml.GetNext(treeNode)) {
+    if((TString)xml.GetNodeName(treeNode) != "BinaryTree") continue;
+
+    double boostWgt(0); getAttr(xml,treeNode,"boostWeight",boostWgt);
+
+    XMLNodePointer_t rootNode = getChild(xml,treeNode,"Node");
+    int              rootIndex = rootNode ? addTreeNode(xml,rootNode,useResponse,failMsg) : -1;
+    if(rootIndex < 0) { if(failMsg == "") failMsg = "found an empty tree"; return false; }
+
+    treeRootV.push_back(rootIndex); treeWgtV.push_back(boostWgt);
+  }
+  if(treeRootV.size() == 0) { failMsg = "no trees found"; return false; }
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief             - Recursively add a node of a decision tree (and all of its daughters) to the node tables.
+ *
+ * @param xml         - The XML engine.
+ * @param xmlNode     - The node of the tree in the XML file.
+ * @param useResponse - Flag indicating if the value of a leaf is its response, or its node-type/purity.
+ * @param failMsg     - Holds a description of the reason for failure.
+ *
+ * @return            - The index of the node in the node tables (or -1 in case of failure).
+ */
+// ===========================================================================================================
+int NativeMLM::addTreeNode(TXMLEngine & xml, XMLNodePointer_t xmlNode, bool useResponse, TString & failMsg) {
+// ===========================================================================================================
+  using namespace nativeFuncs;
+
+  if(xml.HasAttr(xmlNode,"fC0")) { failMsg = "Fisher cuts are not supported"; return -1; }
+
+  int     nodeType(0), varIndex(-1), cutType(1);
+  Float_t cutVal(0), response(0), purity(0);
+
+  getAttr(xml,xmlNode,"nType",nodeType); getAttr(xml,xmlNode,"IVar",varIndex); getAttr(xml,xmlNode,"Cut",cutVal);
+  getAttr(xml,xmlNode,"cType",cutType);  getAttr(xml,xmlNode,"res",response);  getAttr(xml,xmlNode,"purity",purity);
+
+  double leafVal = useResponse ? response : (isYesNoLeaf ? static_cast<double>(nodeType) : purity);
+
+  int nodeIndex = (int)nodeVarV.size();
+  nodeVarV.push_back(max(varIndex,0)); nodeCutV.push_back(cutVal); nodeCutTypeV.push_back((cutType != 0) ? 1 : 0);
+  nodeValV.push_back(leafVal);         nodeLeftV.push_back(-1);    nodeRightV.push_back(-1);
+
+  // intermediate nodes (nodeType == 0) must have two daughters
+  if(nodeType == 0) {
+    if(varIndex < 0 || varIndex >= nVars) { failMsg = "inconsistent variable index in tree"; return -1; }
+
+    int leftIndex(-1), rightIndex(-1);
+    for(XMLNodePointer_t node = xml.GetChild(xmlNode); node; node = xml.GetNext(node)) {
+      if((TString)xml.GetNodeName(node) != "Node") continue;
+
+      TString pos(""); getAttr(xml,node,"pos",pos);
+      if     (pos == "l") leftIndex  = addTreeNode(xml,node,useResponse,failMsg);
+      else if(pos == "r") rightIndex = addTreeNode(xml,node,useResponse,failMsg);
+      if(failMsg != "") return -1;
+    }
+    if(leftIndex < 0 || rightIndex < 0) { failMsg = "inconsistent tree structure"; return -1; }
+
+    nodeLeftV[nodeIndex] = leftIndex; nodeRightV[nodeIndex] = rightIndex;
+  }
+
+  return nodeIndex;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Evaluate the MLM for a batch of objects.
+ *
+ * @param nRows   - The number of objects.
+ * @param inptBuf - The input variables of the objects (row-major, [nRows][nVars]).
+ * @param outV    - The output of the MLM for each object (the regression target, or the classifier response).
+ * @param buf     - Scratch memory for the evaluation.
+ */
+// ===========================================================================================================
+void NativeMLM::evaluate(int nRows, const Float_t * inptBuf, double * outV, Buffer & buf) const {
+// ===========================================================================================================
+  for(int nRowMin=0; nRowMin<nRows; nRowMin += nBlockRows) {
+    int      nRowsNow = min(nRows - nRowMin, static_cast<int>(nBlockRows));
+    double * outNow   = outV + nRowMin;
+
+    transformBlock(nRowsNow,inptBuf + nRowMin*nVars,buf);
+
+    if(type == MLP) evalBlockMLP(nRowsNow,outNow,buf);
+    else            evalBlockBDT(nRowsNow,outNow,buf);
+
+    // the regression target is stored with single precision, and transformed back in reverse order of the transformations
+    if(isReg) {
+      for(int nRowNow=0; nRowNow<nRowsNow; nRowNow++) {
+        Float_t trgVal = outNow[nRowNow];
+        for(int nTrgNormNow=(int)trgNormV.size()-1; nTrgNormNow>=0; nTrgNormNow--) {
+          trgVal = (trgVal + 1.0)/(trgNormV[nTrgNormNow].second * 2.0) + trgNormV[nTrgNormNow].first;
+        }
+        outNow[nRowNow] = trgVal;
+      }
+    }
+  }
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Copy a block of objects into the scratch buffer, transposed into [nVars][nBlockRows],
+ *                and apply the input-variable transformations.
+ *
+ * @param nRows   - The number of objects in the block.
+ * @param inptBuf - The input variables of the objects (row-major, [nRows][nVars]).
+ * @param buf     - Scratch memory for the evaluation.
+ */
+// ===========================================================================================================
+void NativeMLM::transformBlock(int nRows, const Float_t * inptBuf, Buffer & buf) const {
+// ===========================================================================================================
+  const int nB = nBlockRows;
+
+  buf.trnsV.resize(nVars*nB);
+  Float_t * trns = buf.trnsV.data();
+
+  for(int nRowNow=0; nRowNow<nRows; nRowNow++) {
+    for(int nVarNow=0; nVarNow<nVars; nVarNow++) trns[nVarNow*nB + nRowNow] = inptBuf[nRowNow*nVars + nVarNow];
+  }
+
+  for(int nTransNow=0; nTransNow<(int)transTypeV.size(); nTransNow++) {
+    const vector <int> & varIndexV = transVarV[nTransNow];
+    int                  nSel      = (int)varIndexV.size();
+
+    if(transTypeV[nTransNow] == NORM) {
+      const Float_t * normV = transNormV[nTransNow].data();
+
+      for(int nSelNow=0; nSelNow<nSel; nSelNow++) {
+        Float_t   offset = normV[2*nSelNow], scale = normV[2*nSelNow + 1];
+        Float_t * valV   = trns + varIndexV[nSelNow]*nB;
+
+        for(int nRowNow=0; nRowNow<nRows; nRowNow++) valV[nRowNow] = (valV[nRowNow] - offset)*scale * 2 - 1;
+      }
+    }
+    else {
+      // PCA and decorrelation are both linear transformations, where PCA also subtracts the means
+      bool           isPCA  = (transTypeV[nTransNow] == PCA);
+      const double * parV   = transParV[nTransNow].data();
+      const double * matrix = isPCA ? (parV + nSel) : parV;
+
+      buf.pcaV .resize(nSel*nB);
+      buf.nodeV.resize(nB);
+      Float_t * outV = buf.pcaV.data();
+      double  * sumV = buf.nodeV.data();
+
+      for(int nOutNow=0; nOutNow<nSel; nOutNow++) {
+        for(int nRowNow=0; nRowNow<nRows; nRowNow++) sumV[nRowNow] = 0;
+
+        for(int nSelNow=0; nSelNow<nSel; nSelNow++) {
+          const Float_t * valV  = trns + varIndexV[nSelNow]*nB;
+          double          mean  = isPCA ? parV[nSelNow] : 0;
+          double          coef  = isPCA ? matrix[nSelNow*nSel + nOutNow] : matrix[nOutNow*nSel + nSelNow];
+
+          for(int nRowNow=0; nRowNow<nRows; nRowNow++) sumV[nRowNow] += (static_cast<double>(valV[nRowNow]) - mean) * coef;
+        }
+        for(int nRowNow=0; nRowNow<nRows; nRowNow++) outV[nOutNow*nB + nRowNow] = sumV[nRowNow];
+      }
+
+      for(int nSelNow=0; nSelNow<nSel; nSelNow++) {
+        std::copy(outV + nSelNow*nB, outV + nSelNow*nB + nRows, trns + varIndexV[nSelNow]*nB);
+      }
+    }
+  }
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Evaluate an MLP for a block of (transformed) objects. The activations of each layer
+ *                are stored as [nNeurons][nBlockRows], and the sum over the inputs of each neuron is
+ *                performed in the same order as in TMVA (bias last).
+ *
+ * @param nRows   - The number of objects in the block.
+ * @param outV    - The output of the MLP for each object.
+ * @param buf     - Scratch memory for the evaluation.
+ */
+// ===========================================================================================================
+void NativeMLM::evalBlockMLP(int nRows, double * outV, Buffer & buf) const {
+// ===========================================================================================================
+  const int nB      = nBlockRows;
+  int       nLayers = (int)layerSizeV.size();
+
+  buf.nodeV.resize(2*maxLayerSize*nB);
+  double        * inAct = buf.nodeV.data();
+  double        * outAct = inAct + maxLayerSize*nB;
+  const Float_t * trns  = buf.trnsV.data();
+
+  // input layer (identity activation)
+  for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
+    for(int nRowNow=0; nRowNow<nRows; nRowNow++) inAct[nVarNow*nB + nRowNow] = trns[nVarNow*nB + nRowNow];
+  }
+
+  for(int nLayerNow=0; nLayerNow<nLayers-1; nLayerNow++) {
+    int            nIn     = layerSizeV[nLayerNow];
+    int            nOut    = layerSizeV[nLayerNow+1];
+    ActType        actType = (nLayerNow == nLayers-2) ? actOutput : actHidden;
+    const double * wgtV    = layerWgtV[nLayerNow].data();
+
+    for(int nOutNow=0; nOutNow<nOut; nOutNow++) {
+      const double * wgtNow = wgtV + nOutNow*(nIn+1);
+      double       * sumV   = outAct + nOutNow*nB;
+
+      for(int nRowNow=0; nRowNow<nRows; nRowNow++) sumV[nRowNow] = 0;
+
+      for(int nInNow=0; nInNow<nIn; nInNow++) {
+        double         wgt  = wgtNow[nInNow];
+        const double * actV = inAct + nInNow*nB;
+
+        for(int nRowNow=0; nRowNow<nRows; nRowNow++) sumV[nRowNow] += wgt * actV[nRowNow];
+      }
+      // the bias neuron, with an activation of one
+      for(int nRowNow=0; nRowNow<nRows; nRowNow++) sumV[nRowNow] += wgtNow[nIn];
+
+      nativeFuncs::activate(actType,sumV,nRows);
+    }
+
+    std::swap(inAct,outAct);
+  }
+
+  for(int nRowNow=0; nRowNow<nRows; nRowNow++) outV[nRowNow] = inAct[nRowNow];
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Evaluate a BDT for a block of (transformed) objects. Each tree is traversed for all objects
+ *                of the block before moving on to the next tree, so that the nodes of the current tree
+ *                remain in the cache.
+ *
+ * @param nRows   - The number of objects in the block.
+ * @param outV    - The output of the BDT for each object.
+ * @param buf     - Scratch memory for the evaluation.
+ */
+// ===========================================================================================================
+void NativeMLM::evalBlockBDT(int nRows, double * outV, Buffer & buf) const {
+// ===========================================================================================================
+  const int nB     = nBlockRows;
+  int       nTrees = (int)treeRootV.size();
+  bool      isAdaR2 = (boostType == ADAR2);
+
+  // for AdaBoostR2, the response of each tree is kept, as [nTrees][nBlockRows]
+  buf.nodeV.resize((isAdaR2 ? nTrees : 1)*nB);
+  double        * sumV     = buf.nodeV.data();
+  const Float_t * trns     = buf.trnsV.data();
+  const int     * varV     = nodeVarV.data();
+  const int     * leftV    = nodeLeftV.data();
+  const int     * rightV   = nodeRightV.data();
+  const Float_t * cutV     = nodeCutV.data();
+  const char    * cutTypeV = nodeCutTypeV.data();
+  const double  * valV     = nodeValV.data();
+
+  for(int nRowNow=0; nRowNow<nRows; nRowNow++) sumV[nRowNow] = 0;
+
+  double wgtSum(0);
+  for(int nTreeNow=0; nTreeNow<nTrees; nTreeNow++) {
+    int    rootIndex = treeRootV[nTreeNow];
+    double treeWgt   = (boostType == AVG) ? treeWgtV[nTreeNow] : 1;
+    double * respV   = isAdaR2 ? (sumV + nTreeNow*nB) : sumV;
+    wgtSum          += treeWgtV[nTreeNow];
+
+    for(int nRowNow=0; nRowNow<nRows; nRowNow++) {
+      int nodeIndex = rootIndex;
+      while(leftV[nodeIndex] >= 0) {
+        bool goesRight = (trns[varV[nodeIndex]*nB + nRowNow] >= cutV[nodeIndex]);
+        if(!cutTypeV[nodeIndex]) goesRight = !goesRight;
+
+        nodeIndex = goesRight ? rightV[nodeIndex] : leftV[nodeIndex];
+      }
+
+      if(isAdaR2) respV[nRowNow]  = valV[nodeIndex];
+      else        respV[nRowNow] += treeWgt * valV[nodeIndex];
+    }
+  }
+
+  if(boostType == GRAD) {
+    for(int nRowNow=0; nRowNow<nRows; nRowNow++) {
+      outV[nRowNow] = isReg ? (sumV[nRowNow] + treeWgtV[0]) : (2.0/(1.0 + exp(-2.0*sumV[nRowNow])) - 1.0);
+    }
+  }
+  else if(boostType == AVG) {
+    bool hasWgt = (wgtSum > std::numeric_limits<double>::epsilon());
+    for(int nRowNow=0; nRowNow<nRows; nRowNow++) outV[nRowNow] = hasWgt ? (sumV[nRowNow] / wgtSum) : 0;
+  }
+  else {
+    // AdaBoostR2 - the average of the responses around the weighted median, as in TMVA::MethodBDT
+    int nTreesSixth = nTrees/6;
+    buf.sortV.resize(nTrees);
+
+    for(int nRowNow=0; nRowNow<nRows; nRowNow++) {
+      for(int nTreeNow=0; nTreeNow<nTrees; nTreeNow++) {
+        buf.sortV[nTreeNow] = pair<double,double>(sumV[nTreeNow*nB + nRowNow],treeWgtV[nTreeNow]);
+      }
+      std::stable_sort(buf.sortV.begin(),buf.sortV.end(),
+                       [](const pair<double,double> & a, const pair<double,double> & b){ return (a.first < b.first); });
+
+      int    nMedian(0);
+      double wgtSumNow(0);
+      while(wgtSumNow <= wgtSum/2. && nMedian < nTrees) { wgtSumNow += buf.sortV[nMedian].second; nMedian++; }
+
+      int    nTreeMin = max(0,      nMedian - nTreesSixth - 1);
+      int    nTreeMax = min(nTrees, nMedian + nTreesSixth);
+      double respSum(0);
+      for(int nTreeNow=nTreeMin; nTreeNow<nTreeMax; nTreeNow++) respSum += buf.sortV[nTreeNow].first;
+
+      outV[nRowNow] = (nTreeMax > nTreeMin) ? respSum/static_cast<double>(nTreeMax - nTreeMin) : 0;
+    }
+  }
+
+  return;
+}
+
+
+// ===========================================================================================================
+/**
+ * @brief             - Load native evaluators (see NativeMLM) for the MLMs with types given by the nativeMLMs
+ *                    option, after the TMVA::Reader objects have been loaded.
+ *
+ * @details           - Each native evaluator is compared with the corresponding TMVA::Reader for nNativeMLMcheck
+ *                    random inputs, uniformly distributed within the range of the training sample. If the
+ *                    outputs differ by more than the relative tolerance nativeMLMtol, or if any of the settings
+ *                    of the MLM are not supported, the TMVA::Reader is used instead. Native evaluation is not
+ *                    used for multiclass MLMs, for bias-correction MLMs or for classification probabilities
+ *                    which are derived by TMVA (non-binned classification with ANNZ_readType::PRB).
+ *
+ * @param mlmSkipNow  - Map of MLMs which are not used.
+ */
+// ===========================================================================================================
+void ANNZ::loadNativeMLMs(map <TString,bool> & mlmSkipNow) {
+// ===========================================================================================================
+  clearNativeMLMs();
+
+  TString nativeTypes = glob->GetOptC("nativeMLMs");
+  if(nativeTypes.ReplaceAll(" ","") == "") return;
+
+  aLOG(Log::INFO) <<coutWhiteOnBlack<<coutYellow<<" - starting ANNZ::loadNativeMLMs() ... "<<coutDef<<endl;
+
+  int              nMLMs       = glob->GetOptI("nMLMs");
+  int              nCheck      = max(glob->GetOptI("nNativeMLMcheck"),1);
+  double           tolerance   = glob->GetOptF("nativeMLMtol");
+  UInt_t           seed        = glob->GetOptI("initSeedRnd"); if(seed > 0) seed += 61319;
+  vector <TString> nativeTypeV = utils->splitStringByChar(nativeTypes,';');
+
+  nativeMLMv.resize(nMLMs,NULL);
+
+  // the values of the reader variables are modified by the comparison below, and are restored at the end
+  vector < pair<TString,Float_t> > readerInptVorig = readerInptV;
+
+  TRandom * rnd = new TRandom3(seed);
+
+  int nNative(0);
+  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+    TString MLMname = getTagName(nMLMnow); if(mlmSkipNow[MLMname]) continue;
+    if(!dynamic_cast<TMVA::Reader*>(regReaders[nMLMnow]))      continue;
+    if(anlysTypes[nMLMnow] == TMVA::Types::kMulticlass)       continue;
+
+    TString typeName = typeToNameMLM[typeMLM[nMLMnow]];
+    if(std::find(nativeTypeV.begin(),nativeTypeV.end(),typeName) == nativeTypeV.end()) continue;
+
+    NativeMLM * nativeNow = new NativeMLM();
+    TString     failMsg("");
+    int         nInVar    = (int)inNamesVar[nMLMnow].size();
+    bool        isReg     = (anlysTypes[nMLMnow] == TMVA::Types::kRegression);
+    bool        isGood    = nativeNow->load(getKeyWord(MLMname,"trainXML","outXmlFileName"),failMsg);
+
+    if(isGood && nativeNow->getNumVars() != nInVar) { isGood = false; failMsg = "inconsistent number of input variables"; }
+    if(isGood && nativeNow->isRegression() != isReg) { isGood = false; failMsg = "inconsistent analysis type";             }
+
+    // compare the native evaluation with that of the reader
+    if(isGood) {
+      vector <Float_t> inptBufV(nCheck*nInVar);
+      vector <double>  outV(nCheck);
+
+      for(int nCheckNow=0; nCheckNow<nCheck; nCheckNow++) {
+        for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) {
+          double minVal = nativeNow->getVarMin(nInVarNow), maxVal = nativeNow->getVarMax(nInVarNow);
+          inptBufV[nCheckNow*nInVar + nInVarNow] = minVal + rnd->Rndm() * (maxVal - minVal);
+        }
+      }
+      nativeNow->evaluate(nCheck,inptBufV.data(),outV.data(),nativeBuf);
+
+      for(int nCheckNow=0; nCheckNow<nCheck; nCheckNow++) {
+        for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) {
+          readerInptV[readerInptIndexV[nMLMnow][nInVarNow]].second = inptBufV[nCheckNow*nInVar + nInVarNow];
+        }
+        double readerVal = isReg ? (regReaders[nMLMnow]->EvaluateRegression(MLMname))[0] : regReaders[nMLMnow]->EvaluateMVA(MLMname);
+
+        if(fabs(readerVal - outV[nCheckNow]) > tolerance * max(1.,fabs(readerVal))) {
+          isGood  = false;
+          failMsg = (TString)"native output ("+utils->doubleToStr(outV[nCheckNow])+") differs from that of TMVA::Reader ("
+                            +utils->doubleToStr(readerVal)+")";
+          break;
+        }
+      }
+    }
+
+    if(isGood) {
+      nativeMLMv[nMLMnow] = nativeNow; nNative++;
+      aLOG(Log::DEBUG) <<coutYellow<<" - Using native evaluation for "<<typeName<<" Reader("<<coutRed<<MLMname<<coutYellow<<") ..."<<coutDef<<endl;
+    }
+    else {
+      aLOG(Log::WARNING) <<coutRed<<" - Using TMVA::Reader for "<<coutYellow<<MLMname<<coutRed<<" - native evaluation is not possible: "
+                         <<coutYellow<<failMsg<<coutDef<<endl;
+      DELNULL(nativeNow);
+    }
+  }
+
+  for(int nVarNow=0; nVarNow<(int)readerInptV.size(); nVarNow++) readerInptV[nVarNow].second = readerInptVorig[nVarNow].second;
+
+  aLOG(Log::INFO) <<coutYellow<<" - Using native evaluation for "<<coutGreen<<nNative<<coutYellow<<" MLMs ..."<<coutDef<<endl;
+
+  DELNULL(rnd); readerInptVorig.clear(); nativeTypeV.clear();
+  return;
+}
+
+// ===========================================================================================================
+void ANNZ::clearNativeMLMs() {
+// ===========================================================================================================
+  for(int nMLMnow=0; nMLMnow<(int)nativeMLMv.size(); nMLMnow++) DELNULL(nativeMLMv[nMLMnow]);
+  nativeMLMv.clear();
+  return;
+}
@@ -373,7 +373,7 @@ void ANNZ::onlyKnnErr_eval() {
   // cleanup
   addVarV.clear(); varTypeNameV.clear(); nMLMv.clear(); regErrV.clear();
 
-  DELNULL(aChain); DELNULL(varKNN); cleanupKdTreeKNN(knnErrOutFile,knnErrFactory,knnErrDataLdr);
+  DELNULL(aChain); DELNULL(varKNN); cleanupKdTreeKNN(knnErrOutFile,knnErrFactory,knnErrDataLdr,knnErrModule);
 
   aChainKnn[0]->RemoveFriend(aChainKnn[1]); DELNULL(aChainKnn[0]); DELNULL(aChainKnn[1]);
 
@@ -211,6 +211,8 @@ void ANNZ::evalRegSetup() {
         }
         else {
           his1->Scale(1/intgr);
+          // compute the cumulative integral once, so that the histogram may be sampled concurrently (see Utils::getRndFromHis())
+          his1->ComputeIntegral();
           aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1] = his1;
         }
         // // may draw the 1d projections for debugging...
@@ -364,31 +366,22 @@ void ANNZ::evalRegLoop() {
   aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::evalRegLoop() ... "<<coutDef<<endl;
 
   TString outDirNameFull   = glob->GetOptC("outDirNameFull");
-  TString addOutputVars    = glob->GetOptC("addOutputVars");
-  TString userWgtPlots     = glob->GetOptC("userWeights_metricPlots");
   int     maxNobj          = glob->GetOptI("maxNobj");
-  TString indexName        = glob->GetOptC("indexName");
   TString treeName         = glob->GetOptC("treeName");
   int     nMLMs            = glob->GetOptI("nMLMs");
   int     nDivLoops        = glob->GetOptI("nDivEvalLoops");
-  TString zTrg             = glob->GetOptC("zTrg");
   int     nPDFs            = glob->GetOptI("nPDFs");
   int     nPDFbins         = glob->GetOptI("nPDFbins");
+  int     nThreads         = ThreadPool::getNumThreads(glob->GetOptI("nThreads"));
   bool    doStoreToAscii   = glob->GetOptB("doStoreToAscii");
-  int     nSmearsRnd       = glob->GetOptI("nSmearsRnd");
-  double  nSmearUnf        = glob->GetOptI("nSmearUnf"); // and cast to double, since we divide by this later
   TString _typeANNZ        = glob->GetOptC("_typeANNZ");
   TString baseTag_v        = glob->GetOptC("baseTag_v");
   TString baseTag_e        = glob->GetOptC("baseTag_e");
   TString baseTag_w        = glob->GetOptC("baseTag_w");
-  bool    defErrBySigma68  = glob->GetOptB("defErrBySigma68");
   bool    isBinCls         = glob->GetOptB("doBinnedCls");
   bool    writePosNegErrs  = glob->GetOptB("writePosNegErrs");
-  bool    doBiasCorPDF     = glob->GetOptB("doBiasCorPDF");
   bool    doStorePdfBins   = glob->GetOptB("doStorePdfBins");
   
-  UInt_t  seed             = aRegEval->seed;
-  TRandom * rnd            = aRegEval->rnd;
   TString regBestNameVal   = getTagBestMLMname(baseTag_v);
   TString regBestNameErr   = getTagBestMLMname(baseTag_e);
   TString regBestNameErrN  = getTagBestMLMname(baseTag_e+"N");
@@ -544,581 +537,869 @@ void ANNZ::evalRegLoop() {
       }
 
       // -----------------------------------------------------------------------------------------------------------
-      // create the vars to read/write trees
+      // split the entries of the chain between the threads, and setup the vars, readers and histograms of
+      // each thread. the first thread uses the chain and the readers of the main thread, while the others use copies
       // -----------------------------------------------------------------------------------------------------------
-      VarMaps * var_0 = new VarMaps(glob,utils,"treeRegClsVar_0");
-      VarMaps * var_1 = new VarMaps(glob,utils,"treeRegClsVar_1");
+      Long64_t nEntriesLoop = aRegEval->loopChain->GetEntries();
+      if(maxNobj > 0) nEntriesLoop = min(nEntriesLoop,(Long64_t)maxNobj);
 
-      // indexing varible
-      var_1->NewVarI(indexName);
+      int nThreadsNow = static_cast<int>(max(min((Long64_t)nThreads,nEntriesLoop),(Long64_t)1));
 
-      // MLMs (requested by user or needed for pdf computation)
+      // make sure that all MLMs have an entry in the acceptance maps, so that these are only read within the threads
       for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-        TString MLMname    = getTagName(nMLMnow);      if(aRegEval->mlmSkipDivded[MLMname]) continue;
-        TString MLMname_e  = getTagError(nMLMnow,"");  TString MLMname_w  = getTagWeight(nMLMnow);
-        TString MLMname_eN = getTagError(nMLMnow,"N"); TString MLMname_eP = getTagError(nMLMnow,"P");
-
-        // create MLM, MLM-eror and MLM-weight variables for the output vars
-        var_1->NewVarF(MLMname); var_1->NewVarF(MLMname_w);
-        if(aRegEval->hasErrs) { var_1->NewVarF(MLMname_e); var_1->NewVarF(MLMname_eN); var_1->NewVarF(MLMname_eP); }
-
-        if(nLoopTypeNow == 0) {
-          // create MLM-weight formulae for the input variables
-          TString wgtStr = getRegularStrForm(userWgtsM[MLMname+"_valid"],var_0);
-          var_0->NewForm(MLMname_w,wgtStr);
+        TString MLMname = getTagName(nMLMnow);
+        aRegEval->mlmSkipDivded[MLMname]; aRegEval->mlmSkipPdf[MLMname];
+      }
 
-          // formulae for input-variable errors, to be used by getRegClsErrINP()
-          if(aRegEval->isErrINPv[nMLMnow]) {
-            int nInErrs = (int)inNamesErr[nMLMnow].size();
-            for(int nInErrNow=0; nInErrNow<nInErrs; nInErrNow++) {
-              TString inVarErr = getTagInVarErr(nMLMnow,nInErrNow);
+      vector <RegEvalThread*> regEvalThreadV(nThreadsNow,NULL);
+      for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+        regEvalThreadV[nThreadNow] = evalRegThreadSetup(nThreadNow,nThreadsNow,nLoopTypeNow,outTreeNameV[nLoopTypeNow][nDivLoopNow],nEntriesLoop);
+      }
 
-              var_0->NewForm(inVarErr,inNamesErr[nMLMnow][nInErrNow]);
-            }
-          }
-        }
+      // -----------------------------------------------------------------------------------------------------------
+      // loop on the tree - each thread writes its own output files, tagged by the index of the thread, so
+      // that the combined chain of all the output files keeps the original order of the entries
+      // -----------------------------------------------------------------------------------------------------------
+      if(nThreadsNow == 1) {
+        evalRegThreadLoop(regEvalThreadV[0],nLoopTypeNow);
       }
+      else {
+        aLOG(Log::INFO) <<coutBlue<<" - will evaluate "<<coutYellow<<nEntriesLoop<<coutBlue<<" objects using "
+                        <<coutYellow<<nThreadsNow<<coutBlue<<" threads ..."<<coutDef<<endl;
+
+        // histograms which are created within the threads should not be registered in the current directory
+        bool addDirectoryStatus = TH1::AddDirectoryStatus();
+        TH1::AddDirectory(false);
 
-      if(nLoopTypeNow == 1) {
-        // best MLM solution - add the correct tag
-        if(!isBinCls) {
-          var_1->NewVarF(regBestNameVal); var_1->NewVarF(regBestNameWgt);
-          var_1->NewVarF(regBestNameErr); var_1->NewVarF(regBestNameErrN); var_1->NewVarF(regBestNameErrP);
+        ThreadPool * threadPool = new ThreadPool(nThreadsNow);
+        for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+          RegEvalThread * regEvalThread = regEvalThreadV[nThreadNow];
+          threadPool->push([this,regEvalThread,nLoopTypeNow]() { evalRegThreadLoop(regEvalThread,nLoopTypeNow); });
         }
+        threadPool->wait();
+        DELNULL(threadPool);
 
-        // pdf branches (pdf bins and pdf average)
-        for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-          // pdf value in each pdf-bin
-          if(doStorePdfBins) {
-            for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-              TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
-              var_1->NewVarF(pdfBinName);
-            }
-          }
+        TH1::AddDirectory(addDirectoryStatus);
+      }
 
-          // average unweighted and weighted pdf values and corresponding errors
-          for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
-            if(isBinCls && nPdfTypeNow == 0) continue;
+      int nHasNoErr(0), nHasZeroErr(0);
+      for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+        nHasNoErr   += regEvalThreadV[nThreadNow]->nHasNoErr;
+        nHasZeroErr += regEvalThreadV[nThreadNow]->nHasZeroErr;
+      }
+    
+      if(nHasZeroErr > 0 || nHasNoErr > 0) {
+        aLOG(Log::WARNING) <<coutWhiteOnRed<<" - Found "<<nHasZeroErr<<" error estimates equal to 0 and "<<nHasNoErr
+                           <<" undefined errors... Please check that this makes sense !"<<coutDef<<endl;
+      }
 
-            TString pdfAvgName    = getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]);
-            TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
-            TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
+      //cleanup
+      for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) DELNULL(regEvalThreadV[nThreadNow]);
+      regEvalThreadV.clear();
+      outputs->treeFileTag = "";
 
-            var_1->NewVarF(pdfAvgName);
-            if(nPdfTypeNow < 2) { var_1->NewVarF(pdfAvgErrName); var_1->NewVarF(pdfAvgWgtName); }
-          }
-        }
+      if(nLoopTypeNow == 0) {
+        evalRegErrCleanup();
+        clearReaders();
       }
+    } // ENDOF for(int nDivLoopNow=0; nDivLoopNow<nDivLoops; nDivLoopNow++) {}
+  } // ENDOF for(int nLoopTypeNow=0; nLoopTypeNow<2; nLoopTypeNow++) {}
+  // -----------------------------------------------------------------------------------------------------------  
 
-      // connect the input vars to the tree before looping
-      // -----------------------------------------------------------------------------------------------------------
-      if(nLoopTypeNow == 0) var_0->connectTreeBranchesForm(aRegEval->loopChain,&readerInptV);
-      else                  var_0->connectTreeBranches(aRegEval->loopChain);
 
-      // make sure the target variable is included and check that all elements of aRegEval->addVarV exist in the input tree
-      // -----------------------------------------------------------------------------------------------------------
-      if(var_0->HasVar(zTrg) && find(aRegEval->addVarV.begin(),aRegEval->addVarV.end(),zTrg) == aRegEval->addVarV.end()) {
-        aRegEval->addVarV.insert(aRegEval->addVarV.begin(),zTrg);
-      }
 
-      // check if any user-requested weight variables for plotting (used in doMetricPlots()) are needed, but not already included
-      if(userWgtPlots != "" && userWgtPlots != "1") {
-        vector <TString> inBranchNameV;
-        utils->getTreeBranchNames(aRegEval->loopChain,inBranchNameV);
+  // -----------------------------------------------------------------------------------------------------------
+  // write the combined output to an ascii file
+  // -----------------------------------------------------------------------------------------------------------
+  if(doStoreToAscii) {
+    TChain  * aChainReg = new TChain(outTreeNameV[1][0],outTreeNameV[1][0]);
+    aChainReg->SetDirectory(0); aChainReg->Add(outFileNameV[1][0]); 
+    
+    int nEntriesChain   = aChainReg->GetEntries();
+    aLOG(Log::DEBUG) <<coutRed<<" - added chain "<<coutGreen<<outTreeNameV[1][0]<<"("<<nEntriesChain
+                     <<")"<<" from "<<coutBlue<<outFileNameV[1][0]<<coutDef<<endl;
 
-        for(int nVarNow=0; nVarNow<(int)inBranchNameV.size(); nVarNow++) {
-          TString varNameNow = inBranchNameV[nVarNow];
+    VarMaps * var_2 = new VarMaps(glob,utils,"treeRegClsVar_2");
 
-          if( userWgtPlots.Contains(varNameNow) 
-              && (find(aRegEval->addVarV.begin(),aRegEval->addVarV.end(),varNameNow) == aRegEval->addVarV.end()) )
-          {
-            aRegEval->addVarV.push_back(varNameNow);
-          }
+    // include MLMs requested by the user
+    if(!isBinCls) {
+      for(int nAddMLMnow=0; nAddMLMnow<(int)aRegEval->addMLMv.size(); nAddMLMnow++) {
+        int     nMLMnow    = aRegEval->addMLMv[nAddMLMnow];      TString MLMname    = getTagName(nMLMnow);
+        TString MLMname_e  = getTagError(nMLMnow);     TString MLMname_w  = getTagWeight(nMLMnow);
+        TString MLMname_eN = getTagError(nMLMnow,"N"); TString MLMname_eP = getTagError(nMLMnow,"P");
+
+        // create MLM, MLM-eror and MLM-weight variables for the output vars
+        aRegEval->addVarV.push_back(MLMname); aRegEval->addVarV.push_back(MLMname_w);
+        if(aRegEval->hasErrs) {
+          aRegEval->addVarV.push_back(MLMname_e);
+          if(writePosNegErrs) { aRegEval->addVarV.push_back(MLMname_eN); aRegEval->addVarV.push_back(MLMname_eP); }
         }
-        inBranchNameV.clear();
       }
 
-      for(int nVarsInNow=0; nVarsInNow<(int)aRegEval->addVarV.size(); nVarsInNow++) {
-        TString addVarName = aRegEval->addVarV[nVarsInNow];
-        VERIFY(LOCATION,(TString)"from addOutputVars - trying to use undefined "
-                                +"variable (\""+addVarName+"\") ...",var_0->HasVar(addVarName));
+      // the best MLM solution
+      aRegEval->addVarV.push_back(regBestNameVal); aRegEval->addVarV.push_back(regBestNameWgt);
+      if(aRegEval->hasErrs) {
+        aRegEval->addVarV.push_back(regBestNameErr); if(writePosNegErrs) { aRegEval->addVarV.push_back(regBestNameErrN); aRegEval->addVarV.push_back(regBestNameErrP); }
+      }
+    }
+
+    for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+      // average unweighted and weighted pdf values and corresponding errors
+      for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
+        if(isBinCls && nPdfTypeNow == 0) continue;
+
+        TString pdfAvgName    = getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]);
+        TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
+        TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
+
+        aRegEval->addVarV.push_back(pdfAvgName);
+        if(nPdfTypeNow < 2) { aRegEval->addVarV.push_back(pdfAvgErrName); aRegEval->addVarV.push_back(pdfAvgWgtName); }
       }
 
-      // possible additional variables added to the output (do once after connectTreeBranchesForm
-      // of the input tree), create the output tree, and connects it to the vars
-      // -----------------------------------------------------------------------------------------------------------
-      var_1->varStruct(var_0,&aRegEval->addVarV);
-      
-      // best MLM solution - replaced the original variables and with the correct tag - no need to
-      // store this solution, unless needed by the pdf
-      if(!isBinCls && nLoopTypeNow == 1) {
-        TString MLMname = getTagName(aRegEval->bestANNZindex);
-        if(aRegEval->mlmSkipPdf[MLMname]) {
-          TString MLMname_e  = getTagError(aRegEval->bestANNZindex,"");  TString MLMname_w  = getTagWeight(aRegEval->bestANNZindex);
-          TString MLMname_eN = getTagError(aRegEval->bestANNZindex,"N"); TString MLMname_eP = getTagError(aRegEval->bestANNZindex,"P");
-
-          var_1->DelVarF(MLMname); var_1->DelVarF(MLMname_w);
-          if(aRegEval->hasErrs) { var_1->DelVarF(MLMname_e); var_1->DelVarF(MLMname_eN); var_1->DelVarF(MLMname_eP); } 
+      // pdf value in each pdf-bin
+      if(doStorePdfBins) {
+        for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+          TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
+          aRegEval->addVarV.push_back(pdfBinName);
         }
       }
+    }
+    var_2->connectTreeBranches(aChainReg);
 
-      TTree * treeOut = new TTree(outTreeNameV[nLoopTypeNow][nDivLoopNow],outTreeNameV[nLoopTypeNow][nDivLoopNow]);
-      treeOut->SetDirectory(0); outputs->TreeMap[outTreeNameV[nLoopTypeNow][nDivLoopNow]] = treeOut;
+    var_2->storeTreeToAscii("ANNZ"+_typeANNZ,outDirNameFull,0,glob->GetOptI("nObjectsToWrite"),"",&aRegEval->addVarV,NULL);
 
-      var_1->createTreeBranches(treeOut); 
+    DELNULL(var_2); DELNULL(aChainReg);
+  }
 
-      vector < pair<TString,TString> > varTypeNameV_com, varTypeNameV_all;
-      // get the full list of variables common to both var_0 and var_1
-      var_1->varStruct(var_0,NULL,NULL,&varTypeNameV_com,false);
-      // get the full list of variables and variable-types in var_1
-      // var_1->GetAllVarNameTypes(varTypeNameV_all);
+  // -----------------------------------------------------------------------------------------------------------
+  // if needed, store the list of selected MLMs for use outside this function
+  // -----------------------------------------------------------------------------------------------------------
+  if(aRegEval->selctVarV) {
+    aRegEval->selctVarV->clear();
+    for(int nVarsInNow=0; nVarsInNow<(int)aRegEval->addVarV.size(); nVarsInNow++) {
+      aRegEval->selctVarV->push_back(aRegEval->addVarV[nVarsInNow]);
+    }
+  }
 
-      // -----------------------------------------------------------------------------------------------------------
-      // loop on the tree
-      // -----------------------------------------------------------------------------------------------------------
-      bool breakLoop(false), mayWriteObjects(false);
-      int  nObjectsToWrite(glob->GetOptI("nObjectsToWrite")), nObjectsToPrint(glob->GetOptI("nObjectsToPrint"));
-      int  nHasNoErr(0), nHasZeroErr(0);
-      TString aChainName(aRegEval->loopChain->GetName());
-      var_0->clearCntr();
-      for(Long64_t loopEntry=0; true; loopEntry++) {
-        if(!var_0->getTreeEntry(loopEntry)) breakLoop = true;
-
-        if((var_0->GetCntr("nObj") % nObjectsToPrint == 0 && var_0->GetCntr("nObj") > 0)) { var_0->printCntr(aChainName,Log::DEBUG); }
-        if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
-          var_0->printCntr(aChainName); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
-          mayWriteObjects = false;
-        }
-        if(breakLoop) break;
-        
-        // set to default before anything else
-        var_1->setDefaultVals(&varTypeNameV_all);
-        // copy current content of all common variables (index + content of aRegEval->addVarV)
-        var_1->copyVarData(var_0,&varTypeNameV_com);
-
-        if(nLoopTypeNow == 1) {
-          for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-            aRegEval->hisPDF_w  [nPDFnow]->Reset();
-            aRegEval->mlmAvg_val[nPDFnow].resize(nMLMs,0);
-            aRegEval->mlmAvg_err[nPDFnow].resize(nMLMs,0);
-            aRegEval->mlmAvg_wgt[nPDFnow].resize(nMLMs,0);
-
-            aRegEval->pdfWgtValV[nPDFnow][0] = aRegEval->pdfWgtValV[nPDFnow][1] = 0;
-            aRegEval->pdfWgtNumV[nPDFnow][0] = aRegEval->pdfWgtNumV[nPDFnow][1] = 0;
-          }
+  // -----------------------------------------------------------------------------------------------------------
+  // cleanup
+  // -----------------------------------------------------------------------------------------------------------
+  if(!glob->GetOptB("keepEvalTrees") && !aRegEval->hasMlmChain) {
+    for(int nDivLoopNow=0; nDivLoopNow<nDivLoops; nDivLoopNow++) {
+      utils->safeRM(outFileNameV[0][nDivLoopNow],inLOG(Log::DEBUG));
+    }
+  }
+  
+  outTreeNameV.clear(); outFileNameV.clear(); 
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief               - Setup the containers of one thread of the evaluation loop of evalRegLoop().
+ *
+ * @details             - The first thread uses the chain, utils, output-manager and readers of the main thread,
+ *                      while additional threads get their own copies of these. The entries of the chain are split
+ *                      into contiguous ranges, so that the output files of the different threads (which are tagged
+ *                      by the index of the thread) may be chained together in the original order of entries.
+ *
+ * @param nThreadNow    - The index of the thread.
+ * @param nThreads      - The total number of threads.
+ * @param nLoopTypeNow  - The current iteration of evalRegLoop() (0 for the MLM trees, 1 for the final pdf trees).
+ * @param outTreeName   - The name of the output tree.
+ * @param nEntriesLoop  - The total number of entries to process.
+ *
+ * @return              - The new thread object (owned by the caller).
+ */
+// ===========================================================================================================
+RegEvalThread * ANNZ::evalRegThreadSetup(int nThreadNow, int nThreads, int nLoopTypeNow, TString outTreeName, Long64_t nEntriesLoop) {
+// ===========================================================================================================
+  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::evalRegThreadSetup("<<nThreadNow<<") ... "<<coutDef<<endl;
+
+  TString userWgtPlots     = glob->GetOptC("userWeights_metricPlots");
+  TString indexName        = glob->GetOptC("indexName");
+  int     nMLMs            = glob->GetOptI("nMLMs");
+  TString zTrg             = glob->GetOptC("zTrg");
+  int     nPDFs            = glob->GetOptI("nPDFs");
+  int     nPDFbins         = glob->GetOptI("nPDFbins");
+  TString baseTag_v        = glob->GetOptC("baseTag_v");
+  TString baseTag_e        = glob->GetOptC("baseTag_e");
+  TString baseTag_w        = glob->GetOptC("baseTag_w");
+  bool    isBinCls         = glob->GetOptB("doBinnedCls");
+  bool    doStorePdfBins   = glob->GetOptB("doStorePdfBins");
+  bool    isMainThread     = (nThreadNow == 0);
+
+  TString regBestNameVal   = getTagBestMLMname(baseTag_v);
+  TString regBestNameErr   = getTagBestMLMname(baseTag_e);
+  TString regBestNameErrN  = getTagBestMLMname(baseTag_e+"N");
+  TString regBestNameErrP  = getTagBestMLMname(baseTag_e+"P");
+  TString regBestNameWgt   = getTagBestMLMname(baseTag_w);
+
+  // -----------------------------------------------------------------------------------------------------------
+  // utils and output manager - each thread writes its own output files, tagged by the index of the thread
+  // -----------------------------------------------------------------------------------------------------------
+  Utils   * utilsNow   = utils;
+  OutMngr * outputsNow = outputs;
+
+  if(!isMainThread) {
+    utilsNow   = new Utils(glob);
+    outputsNow = new OutMngr((TString)"outputs_"+utils->intToStr(nThreadNow),utilsNow,glob);
+
+    outputsNow->SetOutDirName(outputs->GetOutDirName());
+    outputsNow->OutputRootFileIndex = outputsNow->OutputTreeFileIndex = -1;
+  }
+  outputsNow->treeFileTag = (TString)((nThreads > 1) ? TString::Format("_t%03d",nThreadNow) : "");
+
+  RegEvalThread * thr = new RegEvalThread((TString)"regEvalThread_"+utils->intToStr(nThreadNow),utilsNow,glob,outputsNow);
+
+  thr->isOwner   = !isMainThread;
+  thr->loopChain = isMainThread ? aRegEval->loopChain : utilsNow->cloneChain(aRegEval->loopChain);
+
+  // the range of entries of this thread
+  // -----------------------------------------------------------------------------------------------------------
+  Long64_t nEntriesThread = nEntriesLoop / nThreads;
+  Long64_t nEntriesExtra  = nEntriesLoop % nThreads;
+
+  thr->entryMin = nThreadNow * nEntriesThread + min((Long64_t)nThreadNow,nEntriesExtra);
+  thr->entryMax = thr->entryMin + nEntriesThread + ((nThreadNow < nEntriesExtra) ? 1 : 0);
+
+  aLOG(Log::DEBUG) <<coutPurple<<" - "<<thr->name<<" will process entries ["<<coutGreen<<thr->entryMin<<coutPurple
+                   <<","<<coutGreen<<thr->entryMax<<coutPurple<<") of "<<coutBlue<<thr->loopChain->GetName()<<coutDef<<endl;
+
+  // random number generator (reseeded for each object in evalRegThreadLoop()), pdf histograms and
+  // intermediate containers for each object
+  // -----------------------------------------------------------------------------------------------------------
+  thr->seedINP = aRegEval->seed;
+  thr->rnd     = new TRandom(aRegEval->seed);
+
+  thr->hisPDF_w.resize(nPDFs,NULL);
+  for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+    TString hisName = (TString)aRegEval->hisPDF_w[nPDFnow]->GetName()+"_"+thr->name;
+
+    thr->hisPDF_w[nPDFnow] = (TH1*)aRegEval->hisPDF_w[nPDFnow]->Clone(hisName);
+    thr->hisPDF_w[nPDFnow]->SetDirectory(0);
+  }
+
+  thr->mlmAvg_val.resize(nPDFs,vector<double>(nMLMs,0));
+  thr->mlmAvg_err.resize(nPDFs,vector<double>(nMLMs,0));
+  thr->mlmAvg_wgt.resize(nPDFs,vector<double>(nMLMs,0));
+  thr->pdfWgtValV.resize(nPDFs,vector<double>(2,0));
+  thr->pdfWgtNumV.resize(nPDFs,vector<double>(2,0));
+  thr->regErrV   .resize(nMLMs,vector<double>(3,0));
+
+  // -----------------------------------------------------------------------------------------------------------
+  // readers for the MLMs which were loaded by loadReaders()
+  // -----------------------------------------------------------------------------------------------------------
+  if(nLoopTypeNow == 0 && !isMainThread) cloneReaders(thr);
+
+  // -----------------------------------------------------------------------------------------------------------
+  // create the vars to read/write trees
+  // -----------------------------------------------------------------------------------------------------------
+  VarMaps * var_0 = new VarMaps(glob,utilsNow,"treeRegClsVar_0");
+  VarMaps * var_1 = new VarMaps(glob,utilsNow,"treeRegClsVar_1");
+
+  // indexing varible
+  var_1->NewVarI(indexName);
+
+  // MLMs (requested by user or needed for pdf computation)
+  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+    TString MLMname    = getTagName(nMLMnow);      if(aRegEval->mlmSkipDivded[MLMname]) continue;
+    TString MLMname_e  = getTagError(nMLMnow,"");  TString MLMname_w  = getTagWeight(nMLMnow);
+    TString MLMname_eN = getTagError(nMLMnow,"N"); TString MLMname_eP = getTagError(nMLMnow,"P");
+
+    // create MLM, MLM-eror and MLM-weight variables for the output vars
+    var_1->NewVarF(MLMname); var_1->NewVarF(MLMname_w);
+    if(aRegEval->hasErrs) { var_1->NewVarF(MLMname_e); var_1->NewVarF(MLMname_eN); var_1->NewVarF(MLMname_eP); }
+
+    if(nLoopTypeNow == 0) {
+      // create MLM-weight formulae for the input variables
+      TString wgtStr = getRegularStrForm(userWgtsM[MLMname+"_valid"],var_0);
+      var_0->NewForm(MLMname_w,wgtStr);
+
+      // formulae for input-variable errors, to be used by getRegClsErrINP()
+      if(aRegEval->isErrINPv[nMLMnow]) {
+        int nInErrs = (int)inNamesErr[nMLMnow].size();
+        for(int nInErrNow=0; nInErrNow<nInErrs; nInErrNow++) {
+          TString inVarErr = getTagInVarErr(nMLMnow,nInErrNow);
+
+          var_0->NewForm(inVarErr,inNamesErr[nMLMnow][nInErrNow]);
         }
+      }
+    }
+  }
 
-        // -----------------------------------------------------------------------------------------------------------
-        // calculate the KNN errors if needed, for each variation of aRegEval->knnErrModule
-        // -----------------------------------------------------------------------------------------------------------
-        if(aRegEval->hasErrKNN && nLoopTypeNow == 0) {
-          for(map < TMVA::kNN::ModulekNN*,vector<int> >::iterator Itr=aRegEval->getErrKNN.begin(); Itr!=aRegEval->getErrKNN.end(); ++Itr) {
-            getRegClsErrKNN(var_0,Itr->first,aRegEval->trgIndexV,Itr->second,!isBinCls,aRegEval->regErrV);
-          }
+  if(nLoopTypeNow == 1) {
+    // best MLM solution - add the correct tag
+    if(!isBinCls) {
+      var_1->NewVarF(regBestNameVal); var_1->NewVarF(regBestNameWgt);
+      var_1->NewVarF(regBestNameErr); var_1->NewVarF(regBestNameErrN); var_1->NewVarF(regBestNameErrP);
+    }
+
+    // pdf branches (pdf bins and pdf average)
+    for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+      // pdf value in each pdf-bin
+      if(doStorePdfBins) {
+        for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+          TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
+          var_1->NewVarF(pdfBinName);
         }
+      }
 
-        // -----------------------------------------------------------------------------------------------------------
-        // binned classification
-        // -----------------------------------------------------------------------------------------------------------
-        if(isBinCls) {
-          // -----------------------------------------------------------------------------------------------------------
-          // just generate MLM trees
-          // -----------------------------------------------------------------------------------------------------------
-          if(nLoopTypeNow == 0) {
-            for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-              TString MLMname   = getTagName(nMLMnow);  if(aRegEval->mlmSkipDivded[MLMname]) continue;
-              TString MLMname_e = getTagError(nMLMnow); TString MLMname_w = getTagWeight(nMLMnow);
+      // average unweighted and weighted pdf values and corresponding errors
+      for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
+        if(isBinCls && nPdfTypeNow == 0) continue;
 
-              double clsPrb     = getReader(var_0,ANNZ_readType::PRB,true,nMLMnow);
-              double clsWgt     = var_0->GetForm(MLMname_w);
+        TString pdfAvgName    = getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]);
+        TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
+        TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
 
-              // sanity check that weights are properly defined
-              if(clsWgt < 0) { var_0->printVars(); VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false); }
+        var_1->NewVarF(pdfAvgName);
+        if(nPdfTypeNow < 2) { var_1->NewVarF(pdfAvgErrName); var_1->NewVarF(pdfAvgWgtName); }
+      }
+    }
+  }
 
-              var_1->SetVarF(MLMname,clsPrb); var_1->SetVarF(MLMname_w,clsWgt);
+  // connect the input vars to the tree before looping
+  // -----------------------------------------------------------------------------------------------------------
+  if(nLoopTypeNow == 0) var_0->connectTreeBranchesForm(thr->loopChain,(thr->hasReaders ? &(thr->readerInptV) : &readerInptV));
+  else                  var_0->connectTreeBranches(thr->loopChain);
 
-              if(aRegEval->hasErrs) {
-                double  clsErr  = -1; 
-                if     (aRegEval->isErrKNNv[nMLMnow]) clsErr = aRegEval->regErrV[nMLMnow][1];
-                else if(aRegEval->isErrINPv[nMLMnow]) clsErr = getRegClsErrINP(var_0,false,nMLMnow,&seed);
-                
-                var_1->SetVarF(MLMname_e,clsErr);
-              }
-            }
-          }
-          // -----------------------------------------------------------------------------------------------------------
-          // full solution, pdf etc.
-          // -----------------------------------------------------------------------------------------------------------
-          else {
-            // go over all pdfs
-            for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-              // go over all pdf bins
-              for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-                // in each pdf-bin, use the overlapping cls-bins
-                for(int nClsBinNow=0; nClsBinNow<aRegEval->nClsBinsIn[nPdfBinNow]; nClsBinNow++) {
-                  int    clsIndex   = aRegEval->pdfBinWgt[nPdfBinNow][nClsBinNow].first;
-                  double binWgt     = aRegEval->pdfBinWgt[nPdfBinNow][nClsBinNow].second;
-
-                  TString MLMname   = getTagName(clsIndex);
-                  TString MLMname_e = getTagError(clsIndex); TString MLMname_w = getTagWeight(clsIndex);
-
-                  double  binVal    = max(min(var_0->GetVarF(MLMname),1.),0.);
-                  double  clsWgt    = var_0->GetVarF(MLMname_w);
-                  double  totWgt    = binVal * binWgt * clsWgt;
-
-                  aRegEval->hisPDF_w[nPDFnow]->Fill(zPDF_binC[nPdfBinNow],totWgt);
-                 
-                  aRegEval->pdfWgtValV[nPDFnow][1] += totWgt;
-                  aRegEval->pdfWgtNumV[nPDFnow][1] += binVal * binWgt;
-
-                  // generate random smearing factors for one of the PDFs
-                  // -----------------------------------------------------------------------------------------------------------
-                  if(nPDFnow == 1) {
-                    double clsErr = var_0->GetVarF(MLMname_e);
-
-                    if(clsErr > EPS) {
-                      for(int nSmearRndNow=0; nSmearRndNow<nSmearsRnd; nSmearRndNow++) {
-                        double sfNow     = fabs(rnd->Gaus(0,clsErr));        if(nSmearRndNow%2 == 0) sfNow *= -1;
-                        double binSmr    = max(min((binVal + sfNow),1.),0.);
-                        double totWgtSmr = binSmr * binWgt * clsWgt;
-
-                        aRegEval->hisPDF_w[nPDFnow]->Fill(zPDF_binC[nPdfBinNow],totWgtSmr);
-                        
-                        aRegEval->pdfWgtValV[nPDFnow][1] += totWgtSmr;
-                        aRegEval->pdfWgtNumV[nPDFnow][1] += binSmr * binWgt;
-                      }
-                    }
-                  }
-                }
-              }
-            }
-          }
-        }
-        // -----------------------------------------------------------------------------------------------------------
-        // randomized regression
-        // -----------------------------------------------------------------------------------------------------------
-        else {
-          for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-            TString MLMname    = getTagName(nMLMnow);      if(aRegEval->mlmSkipDivded[MLMname]) continue;
-            TString MLMname_e  = getTagError(nMLMnow,"");  TString MLMname_w  = getTagWeight(nMLMnow);
-            TString MLMname_eN = getTagError(nMLMnow,"N"); TString MLMname_eP = getTagError(nMLMnow,"P");
-
-            double regVal(0), regErr(0), regErrN(0), regErrP(0), regWgt(0);
-            if(nLoopTypeNow == 0) {
-              regVal = getReader(var_0,ANNZ_readType::REG,true,nMLMnow);
-              regWgt = var_0->GetForm(MLMname_w);
-
-              // sanity check that weights are properly defined
-              if(regWgt < 0) {
-                var_0->printVars();
-                VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false);
-              }
+  var_0->selectTreeBranches();
 
-              if(aRegEval->isErrINPv[nMLMnow]) getRegClsErrINP(var_0,true,nMLMnow,&seed,&(aRegEval->regErrV[nMLMnow]));
+  // make sure the target variable is included and check that all elements of aRegEval->addVarV exist in the input tree
+  // -----------------------------------------------------------------------------------------------------------
+  if(var_0->HasVar(zTrg) && find(aRegEval->addVarV.begin(),aRegEval->addVarV.end(),zTrg) == aRegEval->addVarV.end()) {
+    aRegEval->addVarV.insert(aRegEval->addVarV.begin(),zTrg);
+  }
 
-              regErrN = aRegEval->regErrV[nMLMnow][0];
-              regErr  = aRegEval->regErrV[nMLMnow][1];
-              regErrP = aRegEval->regErrV[nMLMnow][2];
-            }
-            else {
-              regVal  = var_0->GetVarF(MLMname);    regWgt = var_0->GetVarF(MLMname_w);
-              regErrN = var_0->GetVarF(MLMname_eN); regErr = var_0->GetVarF(MLMname_e); regErrP = var_0->GetVarF(MLMname_eP);
-            }
+  // check if any user-requested weight variables for plotting (used in doMetricPlots()) are needed, but not already included
+  if(userWgtPlots != "" && userWgtPlots != "1") {
+    vector <TString> inBranchNameV;
+    utilsNow->getTreeBranchNames(thr->loopChain,inBranchNameV);
 
-            bool hasNoErrNow = ((regErrN < 0) || (regErr < 0) || (regErrP < 0));
+    for(int nVarNow=0; nVarNow<(int)inBranchNameV.size(); nVarNow++) {
+      TString varNameNow = inBranchNameV[nVarNow];
 
-            // in the (hopefully unlikely) event that the error calculation failed for a valid object
-            if(hasNoErrNow && (regWgt > EPS)) {
-              nHasNoErr++;
-              if(inLOG(Log::DEBUG_2)) {
-                aLOG(Log::DEBUG_2)<<coutYellow<<" - Got an undefined error calculation for:"<<coutDef<<endl;
-                var_0->printVars();
-              }
-            }
+      if( userWgtPlots.Contains(varNameNow) 
+          && (find(aRegEval->addVarV.begin(),aRegEval->addVarV.end(),varNameNow) == aRegEval->addVarV.end()) )
+      {
+        aRegEval->addVarV.push_back(varNameNow);
+      }
+    }
+    inBranchNameV.clear();
+  }
 
-            // objects with undefined errors can not be used...
-            if(hasNoErrNow) regWgt = 0;
+  for(int nVarsInNow=0; nVarsInNow<(int)aRegEval->addVarV.size(); nVarsInNow++) {
+    TString addVarName = aRegEval->addVarV[nVarsInNow];
+    VERIFY(LOCATION,(TString)"from addOutputVars - trying to use undefined "
+                            +"variable (\""+addVarName+"\") ...",var_0->HasVar(addVarName));
+  }
 
-            // the "best" MLM solution
-            if(nLoopTypeNow == 1 && nMLMnow == aRegEval->bestANNZindex) {
-              var_1->SetVarF(regBestNameVal, regVal);  var_1->SetVarF(regBestNameWgt,regWgt);
-              var_1->SetVarF(regBestNameErrN,regErrN); var_1->SetVarF(regBestNameErr,regErr); var_1->SetVarF(regBestNameErrP,regErrP); 
-            }
-            else {
-              var_1->SetVarF(MLMname,regVal);     var_1->SetVarF(MLMname_w,regWgt);
-              var_1->SetVarF(MLMname_eN,regErrN); var_1->SetVarF(MLMname_e,regErr); var_1->SetVarF(MLMname_eP,regErrP); 
-            }
+  // possible additional variables added to the output (do once after connectTreeBranchesForm
+  // of the input tree), create the output tree, and connects it to the vars
+  // -----------------------------------------------------------------------------------------------------------
+  var_1->varStruct(var_0,&aRegEval->addVarV);
+  
+  // best MLM solution - replaced the original variables and with the correct tag - no need to
+  // store this solution, unless needed by the pdf
+  if(!isBinCls && nLoopTypeNow == 1) {
+    TString MLMname = getTagName(aRegEval->bestANNZindex);
+    if(aRegEval->mlmSkipPdf[MLMname]) {
+      TString MLMname_e  = getTagError(aRegEval->bestANNZindex,"");  TString MLMname_w  = getTagWeight(aRegEval->bestANNZindex);
+      TString MLMname_eN = getTagError(aRegEval->bestANNZindex,"N"); TString MLMname_eP = getTagError(aRegEval->bestANNZindex,"P");
+
+      var_1->DelVarF(MLMname); var_1->DelVarF(MLMname_w);
+      if(aRegEval->hasErrs) { var_1->DelVarF(MLMname_e); var_1->DelVarF(MLMname_eN); var_1->DelVarF(MLMname_eP); } 
+    }
+  }
 
-            if(nLoopTypeNow == 0) continue;      // in the 0-iteration, we only compute the MLM quantites and store a tree
-            if(regWgt < EPS)      continue;      // if the weight is zero, no sense in continuing the loop
-            if(regErr < EPS)      nHasZeroErr++; // to prompt a warning message later on
+  TTree * treeOut = new TTree(outTreeName,outTreeName);
+  treeOut->SetDirectory(0); outputsNow->TreeMap[outTreeName] = treeOut;
 
-            if(aRegEval->mlmSkipPdf[MLMname]) continue; // some MLMs may be requested by the user, but not needed for the pdfs
+  var_1->createTreeBranches(treeOut); 
 
-            for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-              double pdfWgt = aRegEval->pdfWeightV[nPDFnow][nMLMnow] * regWgt;  if(pdfWgt < EPS) continue;
+  // start the batch-writing of the output trees (here, as the setup of the threads is serial)
+  outputsNow->BeginTreeLoop(nLoopTypeNow == 1);
 
-              aRegEval->pdfWgtValV[nPDFnow][0] += regWgt;
-              aRegEval->pdfWgtNumV[nPDFnow][0] += 1;
-              aRegEval->pdfWgtValV[nPDFnow][1] += pdfWgt;
-              aRegEval->pdfWgtNumV[nPDFnow][1] += aRegEval->pdfWeightV[nPDFnow][nMLMnow];
+  // get the full list of variables common to both var_0 and var_1
+  var_1->varStruct(var_0,NULL,NULL,&(thr->varTypeNameV_com),false);
+  // get the full list of variables and variable-types in var_1
+  // var_1->GetAllVarNameTypes(thr->varTypeNameV_all);
 
-              // input original value into the pdf before smearing
-              aRegEval->hisPDF_w[nPDFnow]->Fill(regVal,pdfWgt);
+  thr->var_0 = var_0; thr->var_1 = var_1; thr->treeOut = treeOut;
 
-              aRegEval->mlmAvg_val[nPDFnow][nMLMnow] = regVal;
-              aRegEval->mlmAvg_err[nPDFnow][nMLMnow] = regErr;
-              aRegEval->mlmAvg_wgt[nPDFnow][nMLMnow] = regWgt;
+  return thr;
+}
 
-              // generate random smearing factors for this MLM
-              for(int nSmearRndNow=0; nSmearRndNow<nSmearsRnd; nSmearRndNow++) {
-                int     signNow(-1);
-                double  errNow(regErrN);
-                if(nSmearRndNow%2 == 0) { errNow = regErrP; signNow = 1; }
 
-                double sfNow  = signNow * fabs(rnd->Gaus(0,errNow));
-                double regSmr = regVal + sfNow;
-                aRegEval->hisPDF_w[nPDFnow]->Fill(regSmr,pdfWgt);
-              }
-            }
-          }
+// ===========================================================================================================
+/**
+ * @brief               - The loop over the range of entries of one thread of evalRegLoop(), which fills the
+ *                      output tree of the thread.
+ *
+ * @details             - The random number generators are reseeded for each object, using the global seed
+ *                      (initSeedRnd) and the index of the entry in the chain. The results therefore do not depend
+ *                      on the number of threads, nor on the order in which the threads are executed.
+ *
+ * @param thr           - The thread object (see evalRegThreadSetup()).
+ * @param nLoopTypeNow  - The current iteration of evalRegLoop() (0 for the MLM trees, 1 for the final pdf trees).
+ */
+// ===========================================================================================================
+void ANNZ::evalRegThreadLoop(RegEvalThread * thr, int nLoopTypeNow) {
+// ===========================================================================================================
+  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::evalRegThreadLoop("<<thr->name<<") ... "<<coutDef<<endl;
+
+  int     nMLMs            = glob->GetOptI("nMLMs");
+  int     nPDFs            = glob->GetOptI("nPDFs");
+  int     nPDFbins         = glob->GetOptI("nPDFbins");
+  int     nSmearsRnd       = glob->GetOptI("nSmearsRnd");
+  double  nSmearUnf        = glob->GetOptI("nSmearUnf"); // and cast to double, since we divide by this later
+  TString baseTag_v        = glob->GetOptC("baseTag_v");
+  TString baseTag_e        = glob->GetOptC("baseTag_e");
+  TString baseTag_w        = glob->GetOptC("baseTag_w");
+  bool    defErrBySigma68  = glob->GetOptB("defErrBySigma68");
+  bool    isBinCls         = glob->GetOptB("doBinnedCls");
+  bool    doBiasCorPDF     = glob->GetOptB("doBiasCorPDF");
+  bool    doStorePdfBins   = glob->GetOptB("doStorePdfBins");
+
+  UInt_t  seed             = aRegEval->seed;
+  TRandom * rnd            = thr->rnd;
+  VarMaps * var_0          = thr->var_0;
+  VarMaps * var_1          = thr->var_1;
+  TString regBestNameVal   = getTagBestMLMname(baseTag_v);
+  TString regBestNameErr   = getTagBestMLMname(baseTag_e);
+  TString regBestNameErrN  = getTagBestMLMname(baseTag_e+"N");
+  TString regBestNameErrP  = getTagBestMLMname(baseTag_e+"P");
+  TString regBestNameWgt   = getTagBestMLMname(baseTag_w);
+
+  // -----------------------------------------------------------------------------------------------------------
+  // resolve the variables used in the loop once, to avoid name lookups for each object. for each MLM, the
+  // handles are ordered as [val,wgt,errN,err,errP]. for the input variables (var_0) in the 0-iteration, only
+  // the weight formula is used
+  // -----------------------------------------------------------------------------------------------------------
+  enum { hdlVal, hdlWgt, hdlErrN, hdlErr, hdlErrP, nHdls };
+  vector < vector <VarMaps::VarHandle> > hdl_0(nMLMs,vector<VarMaps::VarHandle>(nHdls)), hdl_1(nMLMs,vector<VarMaps::VarHandle>(nHdls));
+  vector <VarMaps::VarHandle>            hdl_best(nHdls);
+  vector <bool>                          skipPdfV(nMLMs,false);
+
+  if(isBinCls) {
+    vector <bool> isClsInPdf(nMLMs,false);
+    if(nLoopTypeNow == 1) {
+      for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+        for(int nClsBinNow=0; nClsBinNow<aRegEval->nClsBinsIn[nPdfBinNow]; nClsBinNow++) {
+          isClsInPdf[aRegEval->pdfBinWgt[nPdfBinNow][nClsBinNow].first] = true;
         }
+      }
+    }
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+      TString MLMname = getTagName(nMLMnow);
+      if(nLoopTypeNow == 0) {
+        if(aRegEval->mlmSkipDivded[MLMname]) continue;
 
-        // -----------------------------------------------------------------------------------------------------------
-        // fill the pdf tree branches
-        // -----------------------------------------------------------------------------------------------------------
-        if(nLoopTypeNow == 1) {
-          for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-            double intgrPDF_w = aRegEval->hisPDF_w[nPDFnow]->Integral();
+        hdl_0[nMLMnow][hdlWgt] = var_0->GetVarHandle(getTagWeight(nMLMnow));
+        hdl_1[nMLMnow][hdlVal] = var_1->GetVarHandle(MLMname);
+        hdl_1[nMLMnow][hdlWgt] = var_1->GetVarHandle(getTagWeight(nMLMnow));
+        if(aRegEval->hasErrs) hdl_1[nMLMnow][hdlErr] = var_1->GetVarHandle(getTagError(nMLMnow));
+      }
+      else if(isClsInPdf[nMLMnow]) {
+        hdl_0[nMLMnow][hdlVal] = var_0->GetVarHandle(MLMname);
+        hdl_0[nMLMnow][hdlWgt] = var_0->GetVarHandle(getTagWeight(nMLMnow));
+        if(nPDFs > 1) hdl_0[nMLMnow][hdlErr] = var_0->GetVarHandle(getTagError(nMLMnow));
+      }
+    }
+  }
+  else {
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+      TString MLMname = getTagName(nMLMnow); if(aRegEval->mlmSkipDivded[MLMname]) continue;
 
-            if(intgrPDF_w > EPS) {
-              // rescale the weighted probability distribution
-              aRegEval->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
+      skipPdfV[nMLMnow] = aRegEval->mlmSkipPdf[MLMname];
 
-              // apply the bias-correction to the pdf
-              // -----------------------------------------------------------------------------------------------------------
-              if(doBiasCorPDF) {
-                TString clnName        = (TString)aRegEval->hisPDF_w[nPDFnow]->GetName()+"_TMP";
-                TH1     * hisPDF_w_TMP = (TH1*)aRegEval->hisPDF_w[nPDFnow]->Clone(clnName);
+      vector <TString> nameV(nHdls);
+      nameV[hdlVal]  = MLMname;                  nameV[hdlWgt] = getTagWeight(nMLMnow);
+      nameV[hdlErrN] = getTagError(nMLMnow,"N"); nameV[hdlErr] = getTagError(nMLMnow,""); nameV[hdlErrP] = getTagError(nMLMnow,"P");
 
-                for(int nBinXnow=1; nBinXnow<nPDFbins+1; nBinXnow++) {
-                  double val = hisPDF_w_TMP->GetBinContent(nBinXnow);
+      if(nLoopTypeNow == 0) hdl_0[nMLMnow][hdlWgt] = var_0->GetVarHandle(nameV[hdlWgt]);
+      else                  var_0->GetVarHandles(nameV,hdl_0[nMLMnow]);
 
-                  if(val < aRegEval->minWeight)                                     continue;
-                  if(!aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1])                   continue;
-                  if( aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1]->Integral() < EPS) continue;
+      if(nLoopTypeNow == 0 || nMLMnow != aRegEval->bestANNZindex) var_1->GetVarHandles(nameV,hdl_1[nMLMnow]);
+    }
+    if(nLoopTypeNow == 1 && aRegEval->bestANNZindex >= 0) {
+      vector <TString> nameV(nHdls);
+      nameV[hdlVal]  = regBestNameVal;  nameV[hdlWgt] = regBestNameWgt;
+      nameV[hdlErrN] = regBestNameErrN; nameV[hdlErr] = regBestNameErr; nameV[hdlErrP] = regBestNameErrP;
 
-                  val /= nSmearUnf;
-                  for(int nSmearUnfNow=0; nSmearUnfNow<nSmearUnf; nSmearUnfNow++) {
-                    double rndVal = aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1]->GetRandom();
-                    aRegEval->hisPDF_w[nPDFnow]->Fill(rndVal,val);
-                  }
-                }
+      var_1->GetVarHandles(nameV,hdl_best);
+    }
+  }
 
-                intgrPDF_w = aRegEval->hisPDF_w[nPDFnow]->Integral();
-                if(intgrPDF_w > EPS) aRegEval->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
-                
-                DELNULL(hisPDF_w_TMP);
-              }
-            }
+  // the pdf outputs, for each pdf-bin, and for each pdf-type as [val,wgt,err] (with the same ordering as for the MLMs)
+  vector < vector <VarMaps::VarHandle> >            hdl_pdfBin(nPDFs);
+  vector < vector < vector <VarMaps::VarHandle> > > hdl_pdfAvg(nPDFs);
+  if(nLoopTypeNow == 1) {
+    for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+      if(doStorePdfBins) {
+        hdl_pdfBin[nPDFnow].resize(nPDFbins);
+        for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+          hdl_pdfBin[nPDFnow][nPdfBinNow] = var_1->GetVarHandle(getTagPdfBinName(nPDFnow,nPdfBinNow));
+        }
+      }
 
-            // if the objects was skipped (zero weight), the average value will have the
-            // default (std::numeric_limits<float>::max()), but to avoid very big meaningless output, set the pdf-bins to zero
-            // -----------------------------------------------------------------------------------------------------------
-            if(intgrPDF_w < EPS) {
-              if(doStorePdfBins) {
-                for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-                  TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
+      hdl_pdfAvg[nPDFnow].resize(aRegEval->nPdfTypes,vector<VarMaps::VarHandle>(nHdls));
+      for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
+        if(isBinCls && nPdfTypeNow == 0) continue;
 
-                  var_1->SetVarF(pdfBinName,0);
-                }
-              }
-              for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
-                if((isBinCls && nPdfTypeNow == 0) || nPdfTypeNow == 2) continue;
+        vector <VarMaps::VarHandle> & hdlV = hdl_pdfAvg[nPDFnow][nPdfTypeNow];
+        hdlV[hdlVal] = var_1->GetVarHandle(getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]));
+        if(nPdfTypeNow < 2) {
+          hdlV[hdlErr] = var_1->GetVarHandle(getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]));
+          hdlV[hdlWgt] = var_1->GetVarHandle(getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]));
+        }
+      }
+    }
+  }
 
-                TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
-                TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
+  // -----------------------------------------------------------------------------------------------------------
+  // loop on the tree
+  // -----------------------------------------------------------------------------------------------------------
+  bool breakLoop(false), mayWriteObjects(false);
+  int  nObjectsToWrite(glob->GetOptI("nObjectsToWrite")), nObjectsToPrint(glob->GetOptI("nObjectsToPrint"));
+  TString aChainName(thr->loopChain->GetName());
+  var_0->clearCntr();
+  for(Long64_t loopEntry=thr->entryMin; true; loopEntry++) {
+    if(loopEntry >= thr->entryMax || !var_0->getTreeEntry(loopEntry)) breakLoop = true;
+
+    if((var_0->GetCntr("nObj") % nObjectsToPrint == 0 && var_0->GetCntr("nObj") > 0)) { var_0->printCntr(aChainName,Log::DEBUG); }
+    if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
+      var_0->printCntr(aChainName); thr->outputs->WriteOutObjects(false,true); thr->outputs->ResetObjects();
+      var_1->setTreeWrite(thr->outputs->TreeMap[thr->treeOut->GetName()]);
+      mayWriteObjects = false;
+    }
+    if(breakLoop) break;
 
-                var_1->SetVarF(pdfAvgErrName,-1); var_1->SetVarF(pdfAvgWgtName,0);
-              }
-              continue;
-            }
+    // reseed the random number generators, based on the index of the current object in the chain
+    if(seed > 0) {
+      if(nLoopTypeNow == 0) thr->seedINP = thr->utils->getSeedForIndex(seed,loopEntry);
+      else                  rnd->SetSeed(thr->utils->getSeedForIndex(seed,loopEntry));
+    }
+    
+    // set to default before anything else
+    var_1->setDefaultVals(&(thr->varTypeNameV_all));
+    // copy current content of all common variables (index + content of aRegEval->addVarV)
+    var_1->copyVarData(var_0,&(thr->varTypeNameV_com));
 
-            // the value of the pdf in the different bins
-            // -----------------------------------------------------------------------------------------------------------
-            if(doStorePdfBins) {
-              for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-                TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
-                double  pdfValNow  = aRegEval->hisPDF_w[nPDFnow]->GetBinContent(nPdfBinNow+1);
+    if(nLoopTypeNow == 1) {
+      for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+        // reset the per-object averages, so that the results do not depend on the previous object
+        // which was processed by the same thread
+        thr->hisPDF_w  [nPDFnow]->Reset();
+        thr->mlmAvg_val[nPDFnow].assign(nMLMs,0);
+        thr->mlmAvg_err[nPDFnow].assign(nMLMs,0);
+        thr->mlmAvg_wgt[nPDFnow].assign(nMLMs,0);
+
+        thr->pdfWgtValV[nPDFnow][0] = thr->pdfWgtValV[nPDFnow][1] = 0;
+        thr->pdfWgtNumV[nPDFnow][0] = thr->pdfWgtNumV[nPDFnow][1] = 0;
+      }
+    }
 
-                var_1->SetVarF(pdfBinName,pdfValNow);
-              }
-            }
+    // -----------------------------------------------------------------------------------------------------------
+    // calculate the KNN errors if needed, for each variation of aRegEval->knnErrModule
+    // -----------------------------------------------------------------------------------------------------------
+    if(aRegEval->hasErrKNN && nLoopTypeNow == 0) {
+      for(map < TMVA::kNN::ModulekNN*,vector<int> >::iterator Itr=aRegEval->getErrKNN.begin(); Itr!=aRegEval->getErrKNN.end(); ++Itr) {
+        getRegClsErrKNN(var_0,Itr->first,aRegEval->trgIndexV,Itr->second,!isBinCls,thr->regErrV,thr);
+      }
+    }
 
-            // the average value and the width of the pdf distribution
-            for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
-              if(isBinCls && nPdfTypeNow == 0) continue;
+    // -----------------------------------------------------------------------------------------------------------
+    // binned classification
+    // -----------------------------------------------------------------------------------------------------------
+    if(isBinCls) {
+      // -----------------------------------------------------------------------------------------------------------
+      // just generate MLM trees
+      // -----------------------------------------------------------------------------------------------------------
+      if(nLoopTypeNow == 0) {
+        for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+          if(!hdl_1[nMLMnow][hdlVal].isValid()) continue;
 
-              TString pdfAvgName    = getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]);
-              TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
-              TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
+          double clsPrb     = getReader(var_0,ANNZ_readType::PRB,true,nMLMnow,thr);
+          double clsWgt     = var_0->GetForm(hdl_0[nMLMnow][hdlWgt]);
 
-              if(nPdfTypeNow == 0) {
-                double avg_val(0), avg_err(0), sum_wgt(0);
-                for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-                  double regWgt = aRegEval->mlmAvg_wgt[nPDFnow][nMLMnow];  if(regWgt < EPS) continue;
-                  double regVal = aRegEval->mlmAvg_val[nPDFnow][nMLMnow];
-                  double regErr = aRegEval->mlmAvg_err[nPDFnow][nMLMnow];
+          // sanity check that weights are properly defined
+          if(clsWgt < 0) { var_0->printVars(); VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false); }
 
-                  sum_wgt += regWgt; avg_val += regWgt*regVal; avg_err += regWgt*regErr;
-                }
-                if(sum_wgt > EPS) {
-                  var_1->SetVarF(pdfAvgName,   avg_val/sum_wgt);
-                  var_1->SetVarF(pdfAvgErrName,avg_err/sum_wgt);
-                }
-              }
-              else if(nPdfTypeNow == 1) {
-                utils->param->clearAll();
-                utils->param->NewOptF("meanWithoutOutliers",5);
-                if(utils->getInterQuantileStats(aRegEval->hisPDF_w[nPDFnow])) {
-                  double  regAvgPdfVal  = utils->param->GetOptF("quant_mean_Nsig68");
-                  double  regAvgPdfErr  = defErrBySigma68 ? utils->param->GetOptF("quant_sigma_68") : utils->param->GetOptF("quant_sigma");
-
-                  var_1->SetVarF(pdfAvgName,   regAvgPdfVal);
-                  var_1->SetVarF(pdfAvgErrName,regAvgPdfErr);
-                  // if(var_0->GetCntr("nObj") < 14) cout << "xx "<<nPDFnow<<CT<<pdfAvgName<<CT<<regAvgPdfVal<<endl;
+          var_1->SetVarF(hdl_1[nMLMnow][hdlVal],clsPrb); var_1->SetVarF(hdl_1[nMLMnow][hdlWgt],clsWgt);
+
+          if(aRegEval->hasErrs) {
+            double  clsErr  = -1; 
+            if     (aRegEval->isErrKNNv[nMLMnow]) clsErr = thr->regErrV[nMLMnow][1];
+            else if(aRegEval->isErrINPv[nMLMnow]) clsErr = getRegClsErrINP(var_0,false,nMLMnow,&(thr->seedINP),NULL,thr);
+            
+            var_1->SetVarF(hdl_1[nMLMnow][hdlErr],clsErr);
+          }
+        }
+      }
+      // -----------------------------------------------------------------------------------------------------------
+      // full solution, pdf etc.
+      // -----------------------------------------------------------------------------------------------------------
+      else {
+        // go over all pdfs
+        for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+          // go over all pdf bins
+          for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+            // in each pdf-bin, use the overlapping cls-bins
+            for(int nClsBinNow=0; nClsBinNow<aRegEval->nClsBinsIn[nPdfBinNow]; nClsBinNow++) {
+              int    clsIndex   = aRegEval->pdfBinWgt[nPdfBinNow][nClsBinNow].first;
+              double binWgt     = aRegEval->pdfBinWgt[nPdfBinNow][nClsBinNow].second;
+
+              double  binVal    = max(min(var_0->GetVarF(hdl_0[clsIndex][hdlVal]),1.),0.);
+              double  clsWgt    = var_0->GetVarF(hdl_0[clsIndex][hdlWgt]);
+              double  totWgt    = binVal * binWgt * clsWgt;
+
+              thr->utils->fillHisBin(thr->hisPDF_w[nPDFnow],nPdfBinNow+1,totWgt);
+             
+              thr->pdfWgtValV[nPDFnow][1] += totWgt;
+              thr->pdfWgtNumV[nPDFnow][1] += binVal * binWgt;
+
+              // generate random smearing factors for one of the PDFs
+              // -----------------------------------------------------------------------------------------------------------
+              if(nPDFnow == 1) {
+                double clsErr = var_0->GetVarF(hdl_0[clsIndex][hdlErr]);
+
+                if(clsErr > EPS) {
+                  for(int nSmearRndNow=0; nSmearRndNow<nSmearsRnd; nSmearRndNow++) {
+                    double sfNow     = fabs(rnd->Gaus(0,clsErr));        if(nSmearRndNow%2 == 0) sfNow *= -1;
+                    double binSmr    = max(min((binVal + sfNow),1.),0.);
+                    double totWgtSmr = binSmr * binWgt * clsWgt;
+
+                    thr->utils->fillHisBin(thr->hisPDF_w[nPDFnow],nPdfBinNow+1,totWgtSmr);
+                    
+                    thr->pdfWgtValV[nPDFnow][1] += totWgtSmr;
+                    thr->pdfWgtNumV[nPDFnow][1] += binSmr * binWgt;
+                  }
                 }
               }
-              else if(nPdfTypeNow == 2) {
-                int maxBin = aRegEval->hisPDF_w[nPDFnow]->GetMaximumBin() - 1; // histogram bins start at 1, not at 0
+            }
+          }
+        }
+      }
+    }
+    // -----------------------------------------------------------------------------------------------------------
+    // randomized regression
+    // -----------------------------------------------------------------------------------------------------------
+    else {
+      for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+        if(!hdl_0[nMLMnow][hdlWgt].isValid()) continue;
 
-                var_1->SetVarF(pdfAvgName,zPDF_binC[maxBin]);
-              }
+        double regVal(0), regErr(0), regErrN(0), regErrP(0), regWgt(0);
+        if(nLoopTypeNow == 0) {
+          regVal = getReader(var_0,ANNZ_readType::REG,true,nMLMnow,thr);
+          regWgt = var_0->GetForm(hdl_0[nMLMnow][hdlWgt]);
 
-              if(nPdfTypeNow < 2) {
-                VERIFY(LOCATION,(TString)"If intgrPDF_w>0 then there is no way that pdfWgtNumV==0 ... "
-                                        +"something is horribly wrong ?!?!",(aRegEval->pdfWgtNumV[nPDFnow][nPdfTypeNow] > 0));
+          // sanity check that weights are properly defined
+          if(regWgt < 0) {
+            var_0->printVars();
+            VERIFY(LOCATION,(TString)"Weights can only be >= 0 ... Something is horribly wrong ?!?",false);
+          }
 
-                aRegEval->pdfWgtValV[nPDFnow][nPdfTypeNow] /= aRegEval->pdfWgtNumV[nPDFnow][nPdfTypeNow];
-                
-                var_1->SetVarF(pdfAvgWgtName,aRegEval->pdfWgtValV[nPDFnow][nPdfTypeNow]);
-              }
-            }
+          if(aRegEval->isErrINPv[nMLMnow]) getRegClsErrINP(var_0,true,nMLMnow,&(thr->seedINP),&(thr->regErrV[nMLMnow]),thr);
+
+          regErrN = thr->regErrV[nMLMnow][0];
+          regErr  = thr->regErrV[nMLMnow][1];
+          regErrP = thr->regErrV[nMLMnow][2];
+        }
+        else {
+          vector <VarMaps::VarHandle> & hdlV = hdl_0[nMLMnow];
+          regVal  = var_0->GetVarF(hdlV[hdlVal]);  regWgt = var_0->GetVarF(hdlV[hdlWgt]);
+          regErrN = var_0->GetVarF(hdlV[hdlErrN]); regErr = var_0->GetVarF(hdlV[hdlErr]); regErrP = var_0->GetVarF(hdlV[hdlErrP]);
+        }
+
+        bool hasNoErrNow = ((regErrN < 0) || (regErr < 0) || (regErrP < 0));
+
+        // in the (hopefully unlikely) event that the error calculation failed for a valid object
+        if(hasNoErrNow && (regWgt > EPS)) {
+          thr->nHasNoErr++;
+          if(inLOG(Log::DEBUG_2)) {
+            aLOG(Log::DEBUG_2)<<coutYellow<<" - Got an undefined error calculation for:"<<coutDef<<endl;
+            var_0->printVars();
           }
         }
 
-        var_1->fillTree();
+        // objects with undefined errors can not be used...
+        if(hasNoErrNow) regWgt = 0;
 
-        mayWriteObjects = true; var_0->IncCntr("nObj"); if(var_0->GetCntr("nObj") == maxNobj) breakLoop = true;
-      }
-      if(!breakLoop) { var_0->printCntr(aChainName); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
-    
-      if(nHasZeroErr > 0 || nHasNoErr > 0) {
-        aLOG(Log::WARNING) <<coutWhiteOnRed<<" - Found "<<nHasZeroErr<<" error estimates equal to 0 and "<<nHasNoErr
-                           <<" undefined errors... Please check that this makes sense !"<<coutDef<<endl;
-      }
+        // the "best" MLM solution
+        vector <VarMaps::VarHandle> & hdlOutV = (nLoopTypeNow == 1 && nMLMnow == aRegEval->bestANNZindex) ? hdl_best : hdl_1[nMLMnow];
 
-      //cleanup
-      if(nLoopTypeNow == 0) {
-        evalRegErrCleanup();
-        clearReaders();
+        var_1->SetVarF(hdlOutV[hdlVal], regVal);  var_1->SetVarF(hdlOutV[hdlWgt],regWgt);
+        var_1->SetVarF(hdlOutV[hdlErrN],regErrN); var_1->SetVarF(hdlOutV[hdlErr],regErr); var_1->SetVarF(hdlOutV[hdlErrP],regErrP);
+
+        if(nLoopTypeNow == 0) continue;      // in the 0-iteration, we only compute the MLM quantites and store a tree
+        if(regWgt < EPS)      continue;      // if the weight is zero, no sense in continuing the loop
+        if(regErr < EPS)      thr->nHasZeroErr++; // to prompt a warning message later on
+
+        if(skipPdfV[nMLMnow]) continue; // some MLMs may be requested by the user, but not needed for the pdfs
+
+        for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+          double pdfWgt = aRegEval->pdfWeightV[nPDFnow][nMLMnow] * regWgt;  if(pdfWgt < EPS) continue;
+
+          thr->pdfWgtValV[nPDFnow][0] += regWgt;
+          thr->pdfWgtNumV[nPDFnow][0] += 1;
+          thr->pdfWgtValV[nPDFnow][1] += pdfWgt;
+          thr->pdfWgtNumV[nPDFnow][1] += aRegEval->pdfWeightV[nPDFnow][nMLMnow];
+
+          // input original value into the pdf before smearing
+          thr->utils->fillHisBin(thr->hisPDF_w[nPDFnow],zPDF_binL.GetHisBin(regVal),pdfWgt);
+
+          thr->mlmAvg_val[nPDFnow][nMLMnow] = regVal;
+          thr->mlmAvg_err[nPDFnow][nMLMnow] = regErr;
+          thr->mlmAvg_wgt[nPDFnow][nMLMnow] = regWgt;
+
+          // generate random smearing factors for this MLM
+          for(int nSmearRndNow=0; nSmearRndNow<nSmearsRnd; nSmearRndNow++) {
+            int     signNow(-1);
+            double  errNow(regErrN);
+            if(nSmearRndNow%2 == 0) { errNow = regErrP; signNow = 1; }
+
+            double sfNow  = signNow * fabs(rnd->Gaus(0,errNow));
+            double regSmr = regVal + sfNow;
+            thr->utils->fillHisBin(thr->hisPDF_w[nPDFnow],zPDF_binL.GetHisBin(regSmr),pdfWgt);
+          }
+        }
       }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // fill the pdf tree branches
+    // -----------------------------------------------------------------------------------------------------------
+    if(nLoopTypeNow == 1) {
+      for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+        double intgrPDF_w = thr->hisPDF_w[nPDFnow]->Integral();
 
-      DELNULL(var_0); DELNULL(var_1); varTypeNameV_com.clear(); varTypeNameV_all.clear();
-      DELNULL(treeOut); outputs->TreeMap.erase(outTreeNameV[nLoopTypeNow][nDivLoopNow]);
-    } // ENDOF for(int nDivLoopNow=0; nDivLoopNow<nDivLoops; nDivLoopNow++) {}
-  } // ENDOF for(int nLoopTypeNow=0; nLoopTypeNow<2; nLoopTypeNow++) {}
-  // -----------------------------------------------------------------------------------------------------------  
+        if(intgrPDF_w > EPS) {
+          // rescale the weighted probability distribution
+          thr->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
 
+          // apply the bias-correction to the pdf
+          // -----------------------------------------------------------------------------------------------------------
+          if(doBiasCorPDF) {
+            // store the content of the pdf before it is modified by the bias-correction
+            vector <double> pdfBinContentV(nPDFbins+1,0);
+            for(int nBinXnow=1; nBinXnow<nPDFbins+1; nBinXnow++) pdfBinContentV[nBinXnow] = thr->hisPDF_w[nPDFnow]->GetBinContent(nBinXnow);
+
+            for(int nBinXnow=1; nBinXnow<nPDFbins+1; nBinXnow++) {
+              double val = pdfBinContentV[nBinXnow];
+
+              if(val < aRegEval->minWeight)                                     continue;
+              if(!aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1])                   continue;
+              if( aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1]->Integral() < EPS) continue;
+
+              val /= nSmearUnf;
+              for(int nSmearUnfNow=0; nSmearUnfNow<nSmearUnf; nSmearUnfNow++) {
+                double rndVal = thr->utils->getRndFromHis(aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1],rnd);
+                thr->utils->fillHisBin(thr->hisPDF_w[nPDFnow],zPDF_binL.GetHisBin(rndVal),val);
+              }
+            }
 
+            intgrPDF_w = thr->hisPDF_w[nPDFnow]->Integral();
+            if(intgrPDF_w > EPS) thr->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
+            
+            pdfBinContentV.clear();
+          }
+        }
 
-  // -----------------------------------------------------------------------------------------------------------
-  // write the combined output to an ascii file
-  // -----------------------------------------------------------------------------------------------------------
-  if(doStoreToAscii) {
-    TChain  * aChainReg = new TChain(outTreeNameV[1][0],outTreeNameV[1][0]);
-    aChainReg->SetDirectory(0); aChainReg->Add(outFileNameV[1][0]); 
-    
-    int nEntriesChain   = aChainReg->GetEntries();
-    aLOG(Log::DEBUG) <<coutRed<<" - added chain "<<coutGreen<<outTreeNameV[1][0]<<"("<<nEntriesChain
-                     <<")"<<" from "<<coutBlue<<outFileNameV[1][0]<<coutDef<<endl;
+        // if the objects was skipped (zero weight), the average value will have the
+        // default (std::numeric_limits<float>::max()), but to avoid very big meaningless output, set the pdf-bins to zero
+        // -----------------------------------------------------------------------------------------------------------
+        if(intgrPDF_w < EPS) {
+          if(doStorePdfBins) {
+            for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+              var_1->SetVarF(hdl_pdfBin[nPDFnow][nPdfBinNow],0);
+            }
+          }
+          for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
+            if((isBinCls && nPdfTypeNow == 0) || nPdfTypeNow == 2) continue;
 
-    VarMaps * var_2 = new VarMaps(glob,utils,"treeRegClsVar_2");
+            var_1->SetVarF(hdl_pdfAvg[nPDFnow][nPdfTypeNow][hdlErr],-1); var_1->SetVarF(hdl_pdfAvg[nPDFnow][nPdfTypeNow][hdlWgt],0);
+          }
+          continue;
+        }
 
-    // include MLMs requested by the user
-    if(!isBinCls) {
-      for(int nAddMLMnow=0; nAddMLMnow<(int)aRegEval->addMLMv.size(); nAddMLMnow++) {
-        int     nMLMnow    = aRegEval->addMLMv[nAddMLMnow];      TString MLMname    = getTagName(nMLMnow);
-        TString MLMname_e  = getTagError(nMLMnow);     TString MLMname_w  = getTagWeight(nMLMnow);
-        TString MLMname_eN = getTagError(nMLMnow,"N"); TString MLMname_eP = getTagError(nMLMnow,"P");
+        // the value of the pdf in the different bins
+        // -----------------------------------------------------------------------------------------------------------
+        if(doStorePdfBins) {
+          for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+            double pdfValNow = thr->hisPDF_w[nPDFnow]->GetBinContent(nPdfBinNow+1);
 
-        // create MLM, MLM-eror and MLM-weight variables for the output vars
-        aRegEval->addVarV.push_back(MLMname); aRegEval->addVarV.push_back(MLMname_w);
-        if(aRegEval->hasErrs) {
-          aRegEval->addVarV.push_back(MLMname_e);
-          if(writePosNegErrs) { aRegEval->addVarV.push_back(MLMname_eN); aRegEval->addVarV.push_back(MLMname_eP); }
+            var_1->SetVarF(hdl_pdfBin[nPDFnow][nPdfBinNow],pdfValNow);
+          }
         }
-      }
 
-      // the best MLM solution
-      aRegEval->addVarV.push_back(regBestNameVal); aRegEval->addVarV.push_back(regBestNameWgt);
-      if(aRegEval->hasErrs) {
-        aRegEval->addVarV.push_back(regBestNameErr); if(writePosNegErrs) { aRegEval->addVarV.push_back(regBestNameErrN); aRegEval->addVarV.push_back(regBestNameErrP); }
-      }
-    }
+        // the average value and the width of the pdf distribution
+        for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
+          if(isBinCls && nPdfTypeNow == 0) continue;
 
-    for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-      // average unweighted and weighted pdf values and corresponding errors
-      for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
-        if(isBinCls && nPdfTypeNow == 0) continue;
+          VarMaps::VarHandle & pdfAvgHdl    = hdl_pdfAvg[nPDFnow][nPdfTypeNow][hdlVal];
+          VarMaps::VarHandle & pdfAvgErrHdl = hdl_pdfAvg[nPDFnow][nPdfTypeNow][hdlErr];
+          VarMaps::VarHandle & pdfAvgWgtHdl = hdl_pdfAvg[nPDFnow][nPdfTypeNow][hdlWgt];
 
-        TString pdfAvgName    = getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]);
-        TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
-        TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
+          if(nPdfTypeNow == 0) {
+            double avg_val(0), avg_err(0), sum_wgt(0);
+            for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+              double regWgt = thr->mlmAvg_wgt[nPDFnow][nMLMnow];  if(regWgt < EPS) continue;
+              double regVal = thr->mlmAvg_val[nPDFnow][nMLMnow];
+              double regErr = thr->mlmAvg_err[nPDFnow][nMLMnow];
 
-        aRegEval->addVarV.push_back(pdfAvgName);
-        if(nPdfTypeNow < 2) { aRegEval->addVarV.push_back(pdfAvgErrName); aRegEval->addVarV.push_back(pdfAvgWgtName); }
-      }
+              sum_wgt += regWgt; avg_val += regWgt*regVal; avg_err += regWgt*regErr;
+            }
+            if(sum_wgt > EPS) {
+              var_1->SetVarF(pdfAvgHdl,   avg_val/sum_wgt);
+              var_1->SetVarF(pdfAvgErrHdl,avg_err/sum_wgt);
+            }
+          }
+          else if(nPdfTypeNow == 1) {
+            thr->utils->param->clearAll();
+            thr->utils->param->NewOptF("meanWithoutOutliers",5);
+            if(thr->utils->getInterQuantileStats(thr->hisPDF_w[nPDFnow])) {
+              double  regAvgPdfVal  = thr->utils->param->GetOptF("quant_mean_Nsig68");
+              double  regAvgPdfErr  = defErrBySigma68 ? thr->utils->param->GetOptF("quant_sigma_68") : thr->utils->param->GetOptF("quant_sigma");
+
+              var_1->SetVarF(pdfAvgHdl,   regAvgPdfVal);
+              var_1->SetVarF(pdfAvgErrHdl,regAvgPdfErr);
+            }
+          }
+          else if(nPdfTypeNow == 2) {
+            int maxBin = thr->hisPDF_w[nPDFnow]->GetMaximumBin() - 1; // histogram bins start at 1, not at 0
 
-      // pdf value in each pdf-bin
-      if(doStorePdfBins) {
-        for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-          TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
-          aRegEval->addVarV.push_back(pdfBinName);
+            var_1->SetVarF(pdfAvgHdl,zPDF_binC[maxBin]);
+          }
+
+          if(nPdfTypeNow < 2) {
+            VERIFY(LOCATION,(TString)"If intgrPDF_w>0 then there is no way that pdfWgtNumV==0 ... "
+                                    +"something is horribly wrong ?!?!",(thr->pdfWgtNumV[nPDFnow][nPdfTypeNow] > 0));
+
+            thr->pdfWgtValV[nPDFnow][nPdfTypeNow] /= thr->pdfWgtNumV[nPDFnow][nPdfTypeNow];
+            
+            var_1->SetVarF(pdfAvgWgtHdl,thr->pdfWgtValV[nPDFnow][nPdfTypeNow]);
+          }
         }
       }
     }
-    var_2->connectTreeBranches(aChainReg);
-
-    var_2->storeTreeToAscii("ANNZ"+_typeANNZ,outDirNameFull,0,glob->GetOptI("nObjectsToWrite"),"",&aRegEval->addVarV,NULL);
 
-    DELNULL(var_2); DELNULL(aChainReg);
-  }
+    var_1->fillTree();
 
-  // -----------------------------------------------------------------------------------------------------------
-  // if needed, store the list of selected MLMs for use outside this function
-  // -----------------------------------------------------------------------------------------------------------
-  if(aRegEval->selctVarV) {
-    aRegEval->selctVarV->clear();
-    for(int nVarsInNow=0; nVarsInNow<(int)aRegEval->addVarV.size(); nVarsInNow++) {
-      aRegEval->selctVarV->push_back(aRegEval->addVarV[nVarsInNow]);
-    }
+    mayWriteObjects = true; var_0->IncCntr("nObj");
   }
+  if(!breakLoop) { var_0->printCntr(aChainName); thr->outputs->WriteOutObjects(false,true); thr->outputs->ResetObjects(); }
 
-  // -----------------------------------------------------------------------------------------------------------
-  // cleanup
-  // -----------------------------------------------------------------------------------------------------------
-  if(!glob->GetOptB("keepEvalTrees") && !aRegEval->hasMlmChain) {
-    for(int nDivLoopNow=0; nDivLoopNow<nDivLoops; nDivLoopNow++) {
-      utils->safeRM(outFileNameV[0][nDivLoopNow],inLOG(Log::DEBUG));
-    }
-  }
-  
-  outTreeNameV.clear(); outFileNameV.clear(); 
+  // write the remaining output, and restore the original output tree (see OutMngr::BeginTreeLoop())
+  thr->outputs->EndTreeLoop(); var_1->setTreeWrite(thr->treeOut);
+    
 
   return;
 }
 
+
 // ===========================================================================================================
 /**
  * @brief    - setup for the knn error estimation.
@@ -1254,7 +1535,8 @@ void ANNZ::evalRegErrCleanup() {
   for(map <TString,int>::iterator Itr=aRegEval->allInputCombos.begin(); Itr!=aRegEval->allInputCombos.end(); ++Itr) {
     int nMLMnow = Itr->second; TString MLMname = getTagName(nMLMnow);
 
-    cleanupKdTreeKNN(aRegEval->knnErrOutFile[nMLMnow],aRegEval->knnErrFactory[nMLMnow],aRegEval->knnErrDataLdr[nMLMnow]);
+    cleanupKdTreeKNN(aRegEval->knnErrOutFile[nMLMnow],aRegEval->knnErrFactory[nMLMnow],
+                     aRegEval->knnErrDataLdr[nMLMnow],aRegEval->knnErrModule[nMLMnow]);
 
     utils->safeRM(getKeyWord(MLMname,"knnErrXML","outFileDirKnnErr"), inLOG(Log::DEBUG_1));
     utils->safeRM(getKeyWord(MLMname,"knnErrXML","outFileNameKnnErr"),inLOG(Log::DEBUG_1));
@@ -1299,7 +1581,14 @@ void ANNZ::evalRegWrapperSetup() {
   evalRegErrSetup();
 
   // weight formulae setup
-  int nMLMs = glob->GetOptI("nMLMs");
+  int     nMLMs            = glob->GetOptI("nMLMs");
+  int     nPDFs            = glob->GetOptI("nPDFs");
+  int     nPDFbins         = glob->GetOptI("nPDFbins");
+  TString baseTag_v        = glob->GetOptC("baseTag_v");
+  TString baseTag_e        = glob->GetOptC("baseTag_e");
+  TString baseTag_w        = glob->GetOptC("baseTag_w");
+  bool    isBinCls         = glob->GetOptB("doBinnedCls");
+  bool    doStorePdfBins   = glob->GetOptB("doStorePdfBins");
 
   for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
     TString MLMname    = getTagName(nMLMnow);      if(aRegEval->mlmSkip[MLMname]) continue;
@@ -1311,56 +1600,114 @@ void ANNZ::evalRegWrapperSetup() {
     aRegEval->varWrapper->NewForm(MLMname_w,wgtStr);
     // cout <<" ++ NewForm() ++ MLMname_w,wgtStr: "<<MLMname_w<<CT<<wgtStr<<endl;
   }
-  
+
+  // -----------------------------------------------------------------------------------------------------------
+  // the list of outputs, with a fixed order, which is shared by the string and the numerical (batch)
+  // interfaces of the wrapper. for each MLM: [value, weight, error(N), error, error(P)], followed by the
+  // "best" MLM. for each PDF: [pdf bins], followed by [value, error, weight] for each type of average
+  // (indexed in wrapperPdfOutIndexV as nPDFbins + 3*nPdfTypeNow + {0,1,2})
+  // -----------------------------------------------------------------------------------------------------------
+  aRegEval->wrapperOutNameV.clear();
+  aRegEval->wrapperMlmOutIndexV.assign(nMLMs,-1);
+  aRegEval->wrapperPdfOutIndexV.assign(nPDFs,vector<int>(nPDFbins + 3*aRegEval->nPdfTypes,-1));
+
+  if(!isBinCls) {
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+      TString MLMname = getTagName(nMLMnow);  if(aRegEval->mlmSkip[MLMname]) continue;
+
+      aRegEval->wrapperMlmOutIndexV[nMLMnow] = aRegEval->addWrapperOut(MLMname);
+      aRegEval->addWrapperOut(getTagWeight(nMLMnow));
+      aRegEval->addWrapperOut(getTagError(nMLMnow,"N"));
+      aRegEval->addWrapperOut(getTagError(nMLMnow,""));
+      aRegEval->addWrapperOut(getTagError(nMLMnow,"P"));
+
+      if(nMLMnow == aRegEval->bestANNZindex) {
+        aRegEval->addWrapperOut(getTagBestMLMname(baseTag_v));
+        aRegEval->addWrapperOut(getTagBestMLMname(baseTag_w));
+        aRegEval->addWrapperOut(getTagBestMLMname(baseTag_e+"N"));
+        aRegEval->addWrapperOut(getTagBestMLMname(baseTag_e));
+        aRegEval->addWrapperOut(getTagBestMLMname(baseTag_e+"P"));
+      }
+    }
+  }
+
+  for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+    vector <int> & pdfOutIndexV = aRegEval->wrapperPdfOutIndexV[nPDFnow];
+
+    if(doStorePdfBins) {
+      for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
+        pdfOutIndexV[nPdfBinNow] = aRegEval->addWrapperOut(getTagPdfBinName(nPDFnow,nPdfBinNow));
+      }
+    }
+    for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
+      if(isBinCls && nPdfTypeNow == 0) continue;
+
+      int outIndex = nPDFbins + 3*nPdfTypeNow;
+      pdfOutIndexV[outIndex] = aRegEval->addWrapperOut(getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]));
+      
+      if(nPdfTypeNow < 2) {
+        pdfOutIndexV[outIndex+1] = aRegEval->addWrapperOut(getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]));
+        pdfOutIndexV[outIndex+2] = aRegEval->addWrapperOut(getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]));
+      }
+    }
+  }
+  aRegEval->resetWrapperOut();
+
   return;
 }
 
 // ===========================================================================================================
 /**
  * @brief    - single event estimation of evaluate regression - wrapper interface.
+ * 
+ * @details  - the results are stored in thr->wrapperOutV. if getStr is set, these are
+ *           also returned, formatted as a json string. all of the per-object containers are held by
+ *           the evaluation thread of the wrapper, while the readers and kd-trees are shared (see
+ *           evalWrapperThreadSetup()), so that different threads may evaluate objects concurrently.
+ * 
+ * @param thr     - The evaluation thread of the wrapper.
+ * @param getStr  - whether to format the output as a string.
  */
 // ===========================================================================================================
-TString ANNZ::evalRegWrapperLoop() {
+TString ANNZ::evalRegWrapperLoop(RegEvalThread * thr, bool getStr) {
 // ===========================================================================================================
   aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::evalRegWrapperLoop() ... "<<coutDef<<endl;
   // aRegEval->varWrapper->printVars();
 
-  TString output("");
-
-  VarMaps * var            = aRegEval->varWrapper;
+  VarMaps * var            = thr->var_0;
+  Utils   * utilsNow       = thr->utils;
   int     nMLMs            = glob->GetOptI("nMLMs");
   int     nPDFs            = glob->GetOptI("nPDFs");
   int     nPDFbins         = glob->GetOptI("nPDFbins");
-  TString baseTag_v        = glob->GetOptC("baseTag_v");
-  TString baseTag_e        = glob->GetOptC("baseTag_e");
-  TString baseTag_w        = glob->GetOptC("baseTag_w");
   bool    defErrBySigma68  = glob->GetOptB("defErrBySigma68");
   bool    isBinCls         = glob->GetOptB("doBinnedCls");
   bool    doBiasCorPDF     = glob->GetOptB("doBiasCorPDF");
   bool    doStorePdfBins   = glob->GetOptB("doStorePdfBins");
   int     nSmearsRnd       = glob->GetOptI("nSmearsRnd");
   double  nSmearUnf        = glob->GetOptI("nSmearUnf"); // and cast to double, since we divide by this later
-  TString regBestNameVal   = getTagBestMLMname(baseTag_v);
-  TString regBestNameErr   = getTagBestMLMname(baseTag_e);
-  TString regBestNameErrN  = getTagBestMLMname(baseTag_e+"N");
-  TString regBestNameErrP  = getTagBestMLMname(baseTag_e+"P");
-  TString regBestNameWgt   = getTagBestMLMname(baseTag_w);
-  TRandom * rnd            = aRegEval->rnd;
+  TRandom * rnd            = thr->rnd;
 
   vector < double > binClsVal(nMLMs,0), binClsErr(nMLMs,0), binClsWgt(nMLMs,0);
   
-  aRegEval->pdfWgtValV.resize(nPDFs,vector<double>(2,0));
-  aRegEval->pdfWgtNumV.resize(nPDFs,vector<double>(2,0));
-  aRegEval->regErrV   .resize(nMLMs,vector<double>(3,0));
+  thr->pdfWgtValV.resize(nPDFs,vector<double>(2,0));
+  thr->pdfWgtNumV.resize(nPDFs,vector<double>(2,0));
+  thr->regErrV   .resize(nMLMs,vector<double>(3,0));
 
-  for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-    aRegEval->hisPDF_w  [nPDFnow]->Reset();
-    aRegEval->mlmAvg_val[nPDFnow].resize(nMLMs,0);
-    aRegEval->mlmAvg_err[nPDFnow].resize(nMLMs,0);
-    aRegEval->mlmAvg_wgt[nPDFnow].resize(nMLMs,0);
+  thr->resetWrapperOut((int)aRegEval->wrapperOutNameV.size());
 
-    aRegEval->pdfWgtValV[nPDFnow][0] = aRegEval->pdfWgtValV[nPDFnow][1] = 0;
-    aRegEval->pdfWgtNumV[nPDFnow][0] = aRegEval->pdfWgtNumV[nPDFnow][1] = 0;
+  // reseed the random number generators, based on the inputs of the current object
+  setWrapperSeed(var,thr);
+
+  for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+    // reset the per-object averages, so that the results do not depend on the previous object
+    // which was evaluated by the same wrapper slot
+    thr->hisPDF_w  [nPDFnow]->Reset();
+    thr->mlmAvg_val[nPDFnow].assign(nMLMs,0);
+    thr->mlmAvg_err[nPDFnow].assign(nMLMs,0);
+    thr->mlmAvg_wgt[nPDFnow].assign(nMLMs,0);
+
+    thr->pdfWgtValV[nPDFnow][0] = thr->pdfWgtValV[nPDFnow][1] = 0;
+    thr->pdfWgtNumV[nPDFnow][0] = thr->pdfWgtNumV[nPDFnow][1] = 0;
   }
 
   // -----------------------------------------------------------------------------------------------------------
@@ -1368,7 +1715,7 @@ TString ANNZ::evalRegWrapperLoop() {
   // -----------------------------------------------------------------------------------------------------------
   if(aRegEval->hasErrKNN) {
     for(map < TMVA::kNN::ModulekNN*,vector<int> >::iterator Itr=aRegEval->getErrKNN.begin(); Itr!=aRegEval->getErrKNN.end(); ++Itr) {
-      getRegClsErrKNN(var,Itr->first,aRegEval->trgIndexV,Itr->second,!isBinCls,aRegEval->regErrV);
+      getRegClsErrKNN(var,Itr->first,aRegEval->trgIndexV,Itr->second,!isBinCls,thr->regErrV,thr);
     }
   }
   if(aRegEval->hasErrs) {
@@ -1376,7 +1723,7 @@ TString ANNZ::evalRegWrapperLoop() {
       TString MLMname = getTagName(nMLMnow);
       if(!aRegEval->isErrINPv[nMLMnow] || aRegEval->mlmSkip[MLMname]) continue;
 
-      getRegClsErrINP(var,true,nMLMnow,&(aRegEval->seed),&(aRegEval->regErrV[nMLMnow]));
+      getRegClsErrINP(var,true,nMLMnow,&(thr->seedINP),&(thr->regErrV[nMLMnow]),thr);
     }
   }
 
@@ -1391,9 +1738,9 @@ TString ANNZ::evalRegWrapperLoop() {
       TString MLMname   = getTagName(nMLMnow);  if(aRegEval->mlmSkip[MLMname]) continue;
       TString MLMname_e = getTagError(nMLMnow); TString MLMname_w = getTagWeight(nMLMnow);
 
-      binClsVal[nMLMnow] = getReader(var,ANNZ_readType::PRB,true,nMLMnow);
+      binClsVal[nMLMnow] = getWrapperReader(var,ANNZ_readType::PRB,true,nMLMnow,thr);
       binClsWgt[nMLMnow] = var->GetForm(MLMname_w);
-      binClsErr[nMLMnow] = aRegEval->regErrV[nMLMnow][1];
+      binClsErr[nMLMnow] = thr->regErrV[nMLMnow][1];
 
       // cout << MLMname<<CT<< binClsVal[nMLMnow]<<CT<<binClsWgt[nMLMnow]<<CT<<binClsErr[nMLMnow]<<endl;
     }
@@ -1413,10 +1760,10 @@ TString ANNZ::evalRegWrapperLoop() {
           double  clsWgt    = binClsWgt[clsIndex];
           double  totWgt    = binVal * binWgt * clsWgt;
 
-          aRegEval->hisPDF_w[nPDFnow]->Fill(zPDF_binC[nPdfBinNow],totWgt);
+          utilsNow->fillHisBin(thr->hisPDF_w[nPDFnow],nPdfBinNow+1,totWgt);
          
-          aRegEval->pdfWgtValV[nPDFnow][1] += totWgt;
-          aRegEval->pdfWgtNumV[nPDFnow][1] += binVal * binWgt;
+          thr->pdfWgtValV[nPDFnow][1] += totWgt;
+          thr->pdfWgtNumV[nPDFnow][1] += binVal * binWgt;
 
           // generate random smearing factors for one of the PDFs
           // -----------------------------------------------------------------------------------------------------------
@@ -1429,10 +1776,10 @@ TString ANNZ::evalRegWrapperLoop() {
                 double binSmr    = max(min((binVal + sfNow),1.),0.);
                 double totWgtSmr = binSmr * binWgt * clsWgt;
 
-                aRegEval->hisPDF_w[nPDFnow]->Fill(zPDF_binC[nPdfBinNow],totWgtSmr);
+                utilsNow->fillHisBin(thr->hisPDF_w[nPDFnow],nPdfBinNow+1,totWgtSmr);
                 
-                aRegEval->pdfWgtValV[nPDFnow][1] += totWgtSmr;
-                aRegEval->pdfWgtNumV[nPDFnow][1] += binSmr * binWgt;
+                thr->pdfWgtValV[nPDFnow][1] += totWgtSmr;
+                thr->pdfWgtNumV[nPDFnow][1] += binSmr * binWgt;
               }
             }
           }
@@ -1449,12 +1796,11 @@ TString ANNZ::evalRegWrapperLoop() {
     // -----------------------------------------------------------------------------------------------------------
     for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
       TString MLMname    = getTagName(nMLMnow);      if(aRegEval->mlmSkip[MLMname]) continue;
-      TString MLMname_e  = getTagError(nMLMnow,"");  TString MLMname_w  = getTagWeight(nMLMnow);
-      TString MLMname_eN = getTagError(nMLMnow,"N"); TString MLMname_eP = getTagError(nMLMnow,"P");
+      TString MLMname_w  = getTagWeight(nMLMnow);
 
       double regVal(0), regErr(0), regErrN(0), regErrP(0), regWgt(0);
 
-      regVal = getReader(var,ANNZ_readType::REG,true,nMLMnow);
+      regVal = getWrapperReader(var,ANNZ_readType::REG,true,nMLMnow,thr);
       regWgt = var->GetForm(MLMname_w);
 
       // sanity check that weights are properly defined
@@ -1463,40 +1809,36 @@ TString ANNZ::evalRegWrapperLoop() {
         VERIFY(LOCATION,(TString)"Weights("+MLMname_w+") can only be >= 0 ... Something is horribly wrong ?!?",false);
       }
 
-      regErrN = aRegEval->regErrV[nMLMnow][0];
-      regErr  = aRegEval->regErrV[nMLMnow][1];
-      regErrP = aRegEval->regErrV[nMLMnow][2];
+      regErrN = thr->regErrV[nMLMnow][0];
+      regErr  = thr->regErrV[nMLMnow][1];
+      regErrP = thr->regErrV[nMLMnow][2];
 
-      output += (TString)"\""+MLMname   +"\":"+utils->floatToStr(regVal) +",";
-      output += (TString)"\""+MLMname_w +"\":"+utils->floatToStr(regWgt) +",";
-      output += (TString)"\""+MLMname_eN+"\":"+utils->floatToStr(regErrN)+",";
-      output += (TString)"\""+MLMname_e +"\":"+utils->floatToStr(regErr) +",";
-      output += (TString)"\""+MLMname_eP+"\":"+utils->floatToStr(regErrP)+",";
+      // the MLM solution, followed by the "best" MLM solution (see evalRegWrapperSetup())
+      int nOutMlmV = (nMLMnow == aRegEval->bestANNZindex) ? 2 : 1;
+      for(int nOutMlmNow=0; nOutMlmNow<nOutMlmV; nOutMlmNow++) {
+        int outIndex = aRegEval->wrapperMlmOutIndexV[nMLMnow] + 5*nOutMlmNow;
 
-
-      // the "best" MLM solution
-      if(nMLMnow == aRegEval->bestANNZindex) {
-        output += (TString)"\""+regBestNameVal +"\":"+utils->floatToStr(regVal) +",";
-        output += (TString)"\""+regBestNameWgt +"\":"+utils->floatToStr(regWgt) +",";
-        output += (TString)"\""+regBestNameErrN+"\":"+utils->floatToStr(regErrN)+",";
-        output += (TString)"\""+regBestNameErr +"\":"+utils->floatToStr(regErr) +",";
-        output += (TString)"\""+regBestNameErrP+"\":"+utils->floatToStr(regErrP)+",";
+        thr->setWrapperOut(outIndex  ,regVal );
+        thr->setWrapperOut(outIndex+1,regWgt );
+        thr->setWrapperOut(outIndex+2,regErrN);
+        thr->setWrapperOut(outIndex+3,regErr );
+        thr->setWrapperOut(outIndex+4,regErrP);
       }
 
       for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
         double pdfWgt = aRegEval->pdfWeightV[nPDFnow][nMLMnow] * regWgt;  if(pdfWgt < EPS) continue;
 
-        aRegEval->pdfWgtValV[nPDFnow][0] += regWgt;
-        aRegEval->pdfWgtValV[nPDFnow][1] += pdfWgt;
-        aRegEval->pdfWgtNumV[nPDFnow][0] += 1;
-        aRegEval->pdfWgtNumV[nPDFnow][1] += aRegEval->pdfWeightV[nPDFnow][nMLMnow];
+        thr->pdfWgtValV[nPDFnow][0] += regWgt;
+        thr->pdfWgtValV[nPDFnow][1] += pdfWgt;
+        thr->pdfWgtNumV[nPDFnow][0] += 1;
+        thr->pdfWgtNumV[nPDFnow][1] += aRegEval->pdfWeightV[nPDFnow][nMLMnow];
 
         // input original value into the pdf before smearing
-        aRegEval->hisPDF_w[nPDFnow]->Fill(regVal,pdfWgt);
+        utilsNow->fillHisBin(thr->hisPDF_w[nPDFnow],zPDF_binL.GetHisBin(regVal),pdfWgt);
 
-        aRegEval->mlmAvg_val[nPDFnow][nMLMnow] = regVal;
-        aRegEval->mlmAvg_err[nPDFnow][nMLMnow] = regErr;
-        aRegEval->mlmAvg_wgt[nPDFnow][nMLMnow] = regWgt;
+        thr->mlmAvg_val[nPDFnow][nMLMnow] = regVal;
+        thr->mlmAvg_err[nPDFnow][nMLMnow] = regErr;
+        thr->mlmAvg_wgt[nPDFnow][nMLMnow] = regWgt;
 
         // generate random smearing factors for this MLM
         for(int nSmearRndNow=0; nSmearRndNow<nSmearsRnd; nSmearRndNow++) {
@@ -1506,7 +1848,7 @@ TString ANNZ::evalRegWrapperLoop() {
 
           double sfNow  = signNow * fabs(rnd->Gaus(0,errNow));
           double regSmr = regVal + sfNow;
-          aRegEval->hisPDF_w[nPDFnow]->Fill(regSmr,pdfWgt);
+          utilsNow->fillHisBin(thr->hisPDF_w[nPDFnow],zPDF_binL.GetHisBin(regSmr),pdfWgt);
         }
       }
     }
@@ -1516,17 +1858,17 @@ TString ANNZ::evalRegWrapperLoop() {
   // calculate the pdf
   // -----------------------------------------------------------------------------------------------------------
   for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
-    double intgrPDF_w = aRegEval->hisPDF_w[nPDFnow]->Integral();
+    double intgrPDF_w = thr->hisPDF_w[nPDFnow]->Integral();
 
     if(intgrPDF_w > EPS) {
       // rescale the weighted probability distribution
-      aRegEval->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
+      thr->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
 
       // apply the bias-correction to the pdf
       // -----------------------------------------------------------------------------------------------------------
       if(doBiasCorPDF) {
-        TString clnName        = (TString)aRegEval->hisPDF_w[nPDFnow]->GetName()+"_TMP";
-        TH1     * hisPDF_w_TMP = (TH1*)aRegEval->hisPDF_w[nPDFnow]->Clone(clnName);
+        TString clnName        = (TString)thr->hisPDF_w[nPDFnow]->GetName()+"_TMP";
+        TH1     * hisPDF_w_TMP = (TH1*)thr->hisPDF_w[nPDFnow]->Clone(clnName);
 
         for(int nBinXnow=1; nBinXnow<nPDFbins+1; nBinXnow++) {
           double val = hisPDF_w_TMP->GetBinContent(nBinXnow);
@@ -1537,13 +1879,13 @@ TString ANNZ::evalRegWrapperLoop() {
 
           val /= nSmearUnf;
           for(int nSmearUnfNow=0; nSmearUnfNow<nSmearUnf; nSmearUnfNow++) {
-            double rndVal = aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1]->GetRandom();
-            aRegEval->hisPDF_w[nPDFnow]->Fill(rndVal,val);
+            double rndVal = utilsNow->getRndFromHis(aRegEval->hisBiasCorV[nPDFnow][nBinXnow-1],rnd);
+            utilsNow->fillHisBin(thr->hisPDF_w[nPDFnow],zPDF_binL.GetHisBin(rndVal),val);
           }
         }
 
-        intgrPDF_w = aRegEval->hisPDF_w[nPDFnow]->Integral();
-        if(intgrPDF_w > EPS) aRegEval->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
+        intgrPDF_w = thr->hisPDF_w[nPDFnow]->Integral();
+        if(intgrPDF_w > EPS) thr->hisPDF_w[nPDFnow]->Scale(1/intgrPDF_w);
 
         DELNULL(hisPDF_w_TMP);
       }
@@ -1552,22 +1894,19 @@ TString ANNZ::evalRegWrapperLoop() {
     // if the objects was skipped (zero weight), the average value will have the
     // default (std::numeric_limits<float>::max()), but to avoid very big meaningless output, set the pdf-bins to zero
     // -----------------------------------------------------------------------------------------------------------
+    vector <int> & pdfOutIndexV = aRegEval->wrapperPdfOutIndexV[nPDFnow];
+
     if(intgrPDF_w < EPS) {
       if(doStorePdfBins) {
         for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-          TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
-
-          output += (TString)"\""+pdfBinName+"\": 0,";
+          thr->setWrapperOut(pdfOutIndexV[nPdfBinNow],0);
         }
       }
       for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
         if((isBinCls && nPdfTypeNow == 0) || nPdfTypeNow == 2) continue;
 
-        TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
-        TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
-
-        output += (TString)"\""+pdfAvgErrName+"\": -1,";
-        output += (TString)"\""+pdfAvgWgtName+"\": 0,";
+        thr->setWrapperOut(pdfOutIndexV[nPDFbins + 3*nPdfTypeNow + 1],-1);
+        thr->setWrapperOut(pdfOutIndexV[nPDFbins + 3*nPdfTypeNow + 2], 0);
       }
       continue;
     }
@@ -1576,10 +1915,9 @@ TString ANNZ::evalRegWrapperLoop() {
     // -----------------------------------------------------------------------------------------------------------
     if(doStorePdfBins) {
       for(int nPdfBinNow=0; nPdfBinNow<nPDFbins; nPdfBinNow++) {
-        TString pdfBinName = getTagPdfBinName(nPDFnow,nPdfBinNow);
-        double  pdfValNow  = aRegEval->hisPDF_w[nPDFnow]->GetBinContent(nPdfBinNow+1);
+        double pdfValNow = thr->hisPDF_w[nPDFnow]->GetBinContent(nPdfBinNow+1);
 
-        output += (TString)"\""+pdfBinName+"\":"+utils->floatToStr(pdfValNow) +",";
+        thr->setWrapperOut(pdfOutIndexV[nPdfBinNow],pdfValNow);
       }
     }
 
@@ -1587,61 +1925,292 @@ TString ANNZ::evalRegWrapperLoop() {
     for(int nPdfTypeNow=0; nPdfTypeNow<aRegEval->nPdfTypes; nPdfTypeNow++) {
       if(isBinCls && nPdfTypeNow == 0) continue;
 
-      TString pdfAvgName    = getTagPdfAvgName(nPDFnow,(TString)baseTag_v+aRegEval->tagNameV[nPdfTypeNow]);
-      TString pdfAvgErrName = getTagPdfAvgName(nPDFnow,(TString)baseTag_e+aRegEval->tagNameV[nPdfTypeNow]);
-      TString pdfAvgWgtName = getTagPdfAvgName(nPDFnow,(TString)baseTag_w+aRegEval->tagNameV[nPdfTypeNow]);
+      int outIndex = nPDFbins + 3*nPdfTypeNow;
 
       if(nPdfTypeNow == 0) {
         double avg_val(0), avg_err(0), sum_wgt(0);
         for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
-          double regWgt = aRegEval->mlmAvg_wgt[nPDFnow][nMLMnow];  if(regWgt < EPS) continue;
-          double regVal = aRegEval->mlmAvg_val[nPDFnow][nMLMnow];
-          double regErr = aRegEval->mlmAvg_err[nPDFnow][nMLMnow];
+          double regWgt = thr->mlmAvg_wgt[nPDFnow][nMLMnow];  if(regWgt < EPS) continue;
+          double regVal = thr->mlmAvg_val[nPDFnow][nMLMnow];
+          double regErr = thr->mlmAvg_err[nPDFnow][nMLMnow];
 
           sum_wgt += regWgt; avg_val += regWgt*regVal; avg_err += regWgt*regErr;
         }
         if(sum_wgt > EPS) {
-          output += (TString)"\""+pdfAvgName   +"\":"+utils->floatToStr(avg_val/sum_wgt) +",";
-          output += (TString)"\""+pdfAvgErrName+"\":"+utils->floatToStr(avg_err/sum_wgt) +",";
+          thr->setWrapperOut(pdfOutIndexV[outIndex  ],avg_val/sum_wgt);
+          thr->setWrapperOut(pdfOutIndexV[outIndex+1],avg_err/sum_wgt);
         }
       }
       else if(nPdfTypeNow == 1) {
-        utils->param->clearAll();
-        utils->param->NewOptF("meanWithoutOutliers",5);
-        if(utils->getInterQuantileStats(aRegEval->hisPDF_w[nPDFnow])) {
-          double  regAvgPdfVal  = utils->param->GetOptF("quant_mean_Nsig68");
-          double  regAvgPdfErr  = defErrBySigma68 ? utils->param->GetOptF("quant_sigma_68") : utils->param->GetOptF("quant_sigma");
-
-          output += (TString)"\""+pdfAvgName   +"\":"+utils->floatToStr(regAvgPdfVal) +",";
-          output += (TString)"\""+pdfAvgErrName+"\":"+utils->floatToStr(regAvgPdfErr) +",";
+        utilsNow->param->clearAll();
+        utilsNow->param->NewOptF("meanWithoutOutliers",5);
+        if(utilsNow->getInterQuantileStats(thr->hisPDF_w[nPDFnow])) {
+          double  regAvgPdfVal  = utilsNow->param->GetOptF("quant_mean_Nsig68");
+          double  regAvgPdfErr  = defErrBySigma68 ? utilsNow->param->GetOptF("quant_sigma_68") : utilsNow->param->GetOptF("quant_sigma");
+
+          thr->setWrapperOut(pdfOutIndexV[outIndex  ],regAvgPdfVal);
+          thr->setWrapperOut(pdfOutIndexV[outIndex+1],regAvgPdfErr);
           // cout << "xx "<<nPDFnow<<CT<<pdfAvgName<<CT<<regAvgPdfVal<<endl;
         }
       }
       else if(nPdfTypeNow == 2) {
-        int maxBin = aRegEval->hisPDF_w[nPDFnow]->GetMaximumBin() - 1; // histogram bins start at 1, not at 0
+        int maxBin = thr->hisPDF_w[nPDFnow]->GetMaximumBin() - 1; // histogram bins start at 1, not at 0
 
-        output += (TString)"\""+pdfAvgName+"\":"+utils->floatToStr(zPDF_binC[maxBin]) +",";
+        thr->setWrapperOut(pdfOutIndexV[outIndex],zPDF_binC[maxBin]);
       }
 
       if(nPdfTypeNow < 2) {
         VERIFY(LOCATION,(TString)"If intgrPDF_w>0 then there is no way that pdfWgtNumV==0 ... "
-                                +"something is horribly wrong ?!?!",(aRegEval->pdfWgtNumV[nPDFnow][nPdfTypeNow] > 0));
+                                +"something is horribly wrong ?!?!",(thr->pdfWgtNumV[nPDFnow][nPdfTypeNow] > 0));
 
-        aRegEval->pdfWgtValV[nPDFnow][nPdfTypeNow] /= aRegEval->pdfWgtNumV[nPDFnow][nPdfTypeNow];
+        thr->pdfWgtValV[nPDFnow][nPdfTypeNow] /= thr->pdfWgtNumV[nPDFnow][nPdfTypeNow];
         
-        output += (TString)"\""+pdfAvgWgtName+"\":"+utils->floatToStr(aRegEval->pdfWgtValV[nPDFnow][nPdfTypeNow]) +",";
+        thr->setWrapperOut(pdfOutIndexV[outIndex+2],thr->pdfWgtValV[nPDFnow][nPdfTypeNow]);
       }
     }
   }
 
   binClsVal.clear();  binClsErr.clear();  binClsWgt.clear();
 
-  output = (TString)"{"+output+"}";
+  if(!getStr) return "";
+
+  TString output = aRegEval->getWrapperOutStr(thr);
   // aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutGreen<<" - output: "<<coutBlue<<output<<coutDef<<endl;
 
   return output;
 }
 
+// ===========================================================================================================
+/**
+ * @brief               - Setup of one evaluation thread of the wrapper interface (for regression and classification).
+ *
+ * @details             - The readers, native evaluators, kd-trees and bias-correction histograms are loaded once
+ *                      (see evalRegWrapperSetup() and evalClsWrapperSetup()), and are shared by all threads. Each
+ *                      thread only holds its own input and output buffers - the first thread uses the readers
+ *                      of the main thread, while additional threads get copies of the TMVA::Reader objects
+ *                      of MLMs which can not be evaluated natively (see cloneReaders()). The vars of the
+ *                      thread have a copy of the formulae of aRegEval->varWrapper, and should be connected to
+ *                      the input tree of the thread with connectTreeBranchesForm(). This must be called
+ *                      from the main thread.
+ *
+ * @param nThreadNow    - The index of the thread.
+ * @param utilsNow      - The utils of the thread (owned by the caller).
+ *
+ * @return              - The new thread object (owned by the caller).
+ */
+// ===========================================================================================================
+RegEvalThread * ANNZ::evalWrapperThreadSetup(int nThreadNow, Utils * utilsNow) {
+// ===========================================================================================================
+  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::evalWrapperThreadSetup("<<nThreadNow<<") ... "<<coutDef<<endl;
+
+  int  nMLMs        = glob->GetOptI("nMLMs");
+  int  nPDFs        = glob->GetOptI("nPDFs");
+  bool isMainThread = (nThreadNow == 0);
+
+  RegEvalThread * thr = new RegEvalThread((TString)"wrapperThread_"+utils->intToStr(nThreadNow),utilsNow,glob,outputs);
+
+  // make sure that all MLMs have an entry in the acceptance map, so that it is only read within the threads
+  for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) aRegEval->mlmSkip[getTagName(nMLMnow)];
+
+  // random number generator, pdf histograms and intermediate containers for each object
+  // -----------------------------------------------------------------------------------------------------------
+  thr->seedINP = aRegEval->seed;
+  thr->rnd     = new TRandom(aRegEval->seed);
+
+  thr->hisPDF_w.resize(nPDFs,NULL);
+  for(int nPDFnow=0; nPDFnow<nPDFs; nPDFnow++) {
+    TString hisName = (TString)aRegEval->hisPDF_w[nPDFnow]->GetName()+"_"+thr->name;
+
+    thr->hisPDF_w[nPDFnow] = (TH1*)aRegEval->hisPDF_w[nPDFnow]->Clone(hisName);
+    thr->hisPDF_w[nPDFnow]->SetDirectory(0);
+  }
+
+  thr->mlmAvg_val.resize(nPDFs,vector<double>(nMLMs,0));
+  thr->mlmAvg_err.resize(nPDFs,vector<double>(nMLMs,0));
+  thr->mlmAvg_wgt.resize(nPDFs,vector<double>(nMLMs,0));
+  thr->pdfWgtValV.resize(nPDFs,vector<double>(2,0));
+  thr->pdfWgtNumV.resize(nPDFs,vector<double>(2,0));
+  thr->regErrV   .resize(nMLMs,vector<double>(3,0));
+
+  thr->resetWrapperOut((int)aRegEval->wrapperOutNameV.size());
+
+  // readers and vars (with the MLM-weight and input-variable error formulae)
+  // -----------------------------------------------------------------------------------------------------------
+  if(!isMainThread) cloneReaders(thr);
+
+  thr->var_0 = new VarMaps(glob,utilsNow,(TString)"varWrapper_"+utils->intToStr(nThreadNow));
+  thr->var_0->varStruct(aRegEval->varWrapper);
+
+  return thr;
+}
+
+// ===========================================================================================================
+/**
+ * @brief               - Get the output of an MLM for the wrapper interface - either the result of
+ *                      evalWrapperBatch() for the current object of a batch, or that of getReader().
+ *
+ * @param var           - The vars of the thread (see getReader()).
+ * @param readType      - The type of MLM used (regression, or one of two classification estimators).
+ * @param forceUpdate   - Whether to update the input-variables of the reader from var (see getReader()).
+ * @param nMLMnow       - The index of the current MLM.
+ * @param thr           - The evaluation thread of the wrapper.
+ */
+// ===========================================================================================================
+double ANNZ::getWrapperReader(VarMaps * var, ANNZ_readType readType, bool forceUpdate, int nMLMnow, RegEvalThread * thr) {
+// ===========================================================================================================
+  if(thr->nBatchObj >= 0) return thr->batchMlmValV[readType][nMLMnow][thr->nBatchObj];
+
+  return getReader(var,readType,forceUpdate,nMLMnow,thr);
+}
+
+// ===========================================================================================================
+/**
+ * @brief               - Reseed the random number generators of a wrapper thread for the current object.
+ *
+ * @details             - The seed is derived from the global seed and from a hash of the values of the
+ *                      input-variables of the readers for the current object. The random components of
+ *                      the errors and pdfs of an object therefore only depend on its inputs - not on the
+ *                      evaluation slot which serves the call, on previous calls, or on whether the object
+ *                      is evaluated by Wrapper::Eval() or by Wrapper::EvalBatch(). A zero global seed keeps
+ *                      the (non-reproducible) convention of TRandom::SetSeed(0).
+ *
+ * @param var           - The vars of the thread, which hold the inputs of the current object.
+ * @param thr           - The evaluation thread of the wrapper.
+ */
+// ===========================================================================================================
+void ANNZ::setWrapperSeed(VarMaps * var, RegEvalThread * thr) {
+// ===========================================================================================================
+  UInt_t seed = aRegEval->seed;
+  if(seed == 0) return;
+
+  vector < pair<TString,Float_t> > & readerInptNow = thr->hasReaders ? thr->readerInptV : readerInptV;
+
+  var->updateReaderFormulae(readerInptNow,true);
+
+  // FNV-1a hash of the bit patterns of the input-variables
+  ULong64_t inptHash = 0xCBF29CE484222325ULL;
+  for(int nInptNow=0; nInptNow<(int)readerInptNow.size(); nInptNow++) {
+    UInt_t inptBits(0);
+    memcpy(&inptBits,&(readerInptNow[nInptNow].second),sizeof(inptBits));
+
+    inptHash ^= inptBits;
+    inptHash *= 0x100000001B3ULL;
+  }
+
+  thr->seedINP = thr->utils->getSeedForIndex(seed,inptHash);
+  thr->rnd->SetSeed(thr->seedINP);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief               - Evaluation of a batch of objects with the wrapper interface.
+ *
+ * @details             - The objects are processed in chunks. For each chunk, the input-variables of the readers
+ *                      of all objects are first collected into one buffer per MLM, and each MLM is evaluated
+ *                      for all objects together with getReaderBatch() (in a single call of the native evaluator,
+ *                      if available). The errors, weights and pdfs are then derived for each object
+ *                      by evalRegWrapperLoop() or evalClsWrapperLoop(), using the stored MLM outputs.
+ *
+ * @param thr           - The evaluation thread of the wrapper (see evalWrapperThreadSetup()).
+ * @param nObjs         - The number of objects.
+ * @param setObjVars    - A function which sets the input variables of thr->var_0 to the values of a given object.
+ * @param outVals       - Preallocated output array, with (nObjs x number of outputs) elements, ordered
+ *                      by object (see RegEval::wrapperOutNameV).
+ */
+// ===========================================================================================================
+void ANNZ::evalWrapperBatch(RegEvalThread * thr, int nObjs, std::function<void(int)> setObjVars, double * outVals) {
+// ===========================================================================================================
+  aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting ANNZ::evalWrapperBatch() ... "<<coutDef<<endl;
+
+  VarMaps * var        = thr->var_0;
+  int       nMLMs      = glob->GetOptI("nMLMs");
+  bool      isReg      = glob->GetOptB("doRegression");
+  bool      isBinCls   = glob->GetOptB("doBinnedCls");
+  int       nOuts      = (int)aRegEval->wrapperOutNameV.size();
+  int       nObjsChunk = 100 * NativeMLM::nBlockRows;
+
+  vector < pair<TString,Float_t> > & readerInptNow = thr->hasReaders ? thr->readerInptV : readerInptV;
+
+  // the MLMs and the types of outputs which are used by evalRegWrapperLoop() or by evalClsWrapperLoop()
+  // -----------------------------------------------------------------------------------------------------------
+  vector <int>                       mlmInV;
+  vector < pair<int,ANNZ_readType> > mlmReadV;
+  if(isReg) {
+    for(int nMLMnow=0; nMLMnow<nMLMs; nMLMnow++) {
+      if(aRegEval->mlmSkip[getTagName(nMLMnow)]) continue;
+
+      mlmInV.push_back(nMLMnow);
+      mlmReadV.push_back(pair<int,ANNZ_readType>(nMLMnow,(isBinCls ? ANNZ_readType::PRB : ANNZ_readType::REG)));
+    }
+  }
+  else {
+    for(int nMLMsInNow=0; nMLMsInNow<(int)aRegEval->mlmInV.size(); nMLMsInNow++) {
+      TString MLMname = aRegEval->mlmInV[nMLMsInNow];  if(aRegEval->mlmSkip[MLMname]) continue;
+      int     nMLMnow = getTagNow(MLMname);
+
+      mlmInV.push_back(nMLMnow);
+      mlmReadV.push_back(pair<int,ANNZ_readType>(nMLMnow,ANNZ_readType::PRB));
+      mlmReadV.push_back(pair<int,ANNZ_readType>(nMLMnow,ANNZ_readType::CLS));
+    }
+  }
+
+  thr->batchMlmValV.resize((int)ANNZ_readType::NUN,vector< vector<double> >(nMLMs));
+  thr->batchInptV  .resize(nMLMs);
+
+  for(int nObjMin=0; nObjMin<nObjs; nObjMin+=nObjsChunk) {
+    int nObjsNow = min(nObjsChunk,nObjs-nObjMin);
+
+    // collect the input-variables of the readers for all objects of the chunk
+    // -----------------------------------------------------------------------------------------------------------
+    for(int nMLMinNow=0; nMLMinNow<(int)mlmInV.size(); nMLMinNow++) {
+      int nMLMnow = mlmInV[nMLMinNow];
+      thr->batchInptV[nMLMnow].resize(nObjsNow * (int)readerInptIndexV[nMLMnow].size());
+    }
+
+    for(int nObjNow=0; nObjNow<nObjsNow; nObjNow++) {
+      setObjVars(nObjMin + nObjNow);
+      var->updateReaderFormulae(readerInptNow,true);
+
+      for(int nMLMinNow=0; nMLMinNow<(int)mlmInV.size(); nMLMinNow++) {
+        int            nMLMnow    = mlmInV[nMLMinNow];
+        vector <int> & inptIndexV = readerInptIndexV[nMLMnow];
+        int            nInVar     = (int)inptIndexV.size();
+        Float_t      * rowNow     = thr->batchInptV[nMLMnow].data() + nObjNow * nInVar;
+
+        for(int nInVarNow=0; nInVarNow<nInVar; nInVarNow++) rowNow[nInVarNow] = readerInptNow[inptIndexV[nInVarNow]].second;
+      }
+    }
+
+    // evaluate each MLM for all objects of the chunk
+    // -----------------------------------------------------------------------------------------------------------
+    for(int nMLMreadNow=0; nMLMreadNow<(int)mlmReadV.size(); nMLMreadNow++) {
+      int           nMLMnow  = mlmReadV[nMLMreadNow].first;
+      ANNZ_readType readType = mlmReadV[nMLMreadNow].second;
+
+      getReaderBatch(var,readType,nMLMnow,nObjsNow,thr->batchInptV[nMLMnow],thr->batchMlmValV[readType][nMLMnow],thr);
+    }
+
+    // derive the errors, weights and pdfs of each object, and copy the results to the output array
+    // -----------------------------------------------------------------------------------------------------------
+    for(int nObjNow=0; nObjNow<nObjsNow; nObjNow++) {
+      setObjVars(nObjMin + nObjNow);
+
+      thr->nBatchObj = nObjNow;
+      if(isReg) evalRegWrapperLoop(thr,false);
+      else      evalClsWrapperLoop(thr,false);
+
+      std::copy(thr->wrapperOutV.begin(), thr->wrapperOutV.end(), outVals + (nObjMin + nObjNow) * nOuts);
+    }
+    thr->nBatchObj = -1;
+  }
+
+  mlmInV.clear(); mlmReadV.clear();
+
+  return;
+}
+
 // ===========================================================================================================
 /**
  * @brief    - cleanup of evaluate regression - wrapper interface.
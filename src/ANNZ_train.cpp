@@ -16,6 +16,11 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // ===========================================================================================================
 
+#include <cerrno>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
 // ===========================================================================================================
 /**
  * @brief  - Interface for training methods.
@@ -121,8 +126,50 @@ void ANNZ::Train_singleCls() {
 
   DELNULL(var);
 
-  // crate new chains with unique signal or background objects
-  splitToSigBckTrees(chainM,cutM,optMap);
+  // the trees for the factory - if the training cache is used, create in-memory trees which only
+  // hold the signal or background objects, and the branches which are needed for training
+  map < TString,TTree* > treeM;
+
+  if(glob->GetOptB("trainCache")) {
+    int              maxNobj = glob->GetOptI("maxNobj");
+    vector <TString> exprV(inNamesVar[nMLMnow]);
+    exprV.push_back(wgtTrain);
+
+    TrainCache * trainCache = new TrainCache("trainCache",utils,glob,outputs);
+
+    bool hasAllTrees(true);
+    for(int trainValidType=0; trainValidType<2 && hasAllTrees; trainValidType++) {
+      TString trainValidName = (TString)((trainValidType == 0) ? "_train" : "_valid");
+
+      for(int sigBckType=0; sigBckType<2 && hasAllTrees; sigBckType++) {
+        TString sigBckName = (TString)((sigBckType == 0) ? "_sig" : "_bck");
+        TString treeName   = (TString)trainValidName+sigBckName;
+
+        treeM[treeName] = trainCache->getTree(chainM[trainValidName],exprV,cutM["_comn"]+cutM[trainValidName]+cutM[sigBckName]);
+        if(!treeM[treeName]) { hasAllTrees = false; break; }
+
+        // store the final number of signal/background objects, as in splitToSigBckTrees()
+        int nObjNow = (int)treeM[treeName]->GetEntries();
+        optMap->NewOptI((TString)"n"+treeName,nObjNow);
+        optMap->NewOptI((TString)"ANNZ_n"+(trainValidType == 0 ? "Train" : "Valid")+sigBckName,(maxNobj > 0) ? min(maxNobj,nObjNow) : nObjNow);
+      }
+    }
+    DELNULL(trainCache); exprV.clear();
+
+    if(!hasAllTrees) {
+      for(map <TString,TTree*>::iterator itr = treeM.begin(); itr!=treeM.end(); ++itr) DELNULL(itr->second);
+      treeM.clear();
+    }
+  }
+
+  bool useTrainCache = (treeM.size() > 0);
+  if(!useTrainCache) {
+    // crate new chains with unique signal or background objects
+    splitToSigBckTrees(chainM,cutM,optMap);
+
+    treeM["_train_sig"] = chainM["_train_sig"]; treeM["_train_bck"] = chainM["_train_bck"];
+    treeM["_valid_sig"] = chainM["_valid_sig"]; treeM["_valid_bck"] = chainM["_valid_bck"];
+  }
  
   int nTrain_sig = optMap->GetOptI("ANNZ_nTrain_sig");
   int nTrain_bck = optMap->GetOptI("ANNZ_nTrain_bck");
@@ -137,10 +184,10 @@ void ANNZ::Train_singleCls() {
                                                                      && nTrain_sig >= minObjTrainTest && nValid_sig >= minObjTrainTest ));
 
   double  clsWeight(1.0); // weight for the entire sample
-  dataLdr->AddSignalTree    (chainM["_train_sig"],clsWeight,TMVA::Types::kTraining);
-  dataLdr->AddSignalTree    (chainM["_valid_sig"],clsWeight,TMVA::Types::kTesting );
-  dataLdr->AddBackgroundTree(chainM["_train_bck"],clsWeight,TMVA::Types::kTraining);
-  dataLdr->AddBackgroundTree(chainM["_valid_bck"],clsWeight,TMVA::Types::kTesting );
+  dataLdr->AddSignalTree    (treeM["_train_sig"],clsWeight,TMVA::Types::kTraining);
+  dataLdr->AddSignalTree    (treeM["_valid_sig"],clsWeight,TMVA::Types::kTesting );
+  dataLdr->AddBackgroundTree(treeM["_train_bck"],clsWeight,TMVA::Types::kTraining);
+  dataLdr->AddBackgroundTree(treeM["_valid_bck"],clsWeight,TMVA::Types::kTesting );
 
   // set the sample-weights
   dataLdr->SetWeightExpression(wgtTrain,"Signal");
@@ -160,7 +207,7 @@ void ANNZ::Train_singleCls() {
 
   aLOG(Log::INFO) <<coutCyan<<LINE_FILL('-',100)<<coutDef<<endl;
 
-  // cuts have already been applied during splitToSigBckTrees(), so leave empty here
+  // cuts have already been applied during splitToSigBckTrees() or by the training cache, so leave empty here
   dataLdr->PrepareTrainingAndTestTree((TCut)"",trainValidStr);
 
   TMVA::Types::EMVA typeNow = getTypeMLMbyName(mlmType);
@@ -226,7 +273,10 @@ void ANNZ::Train_singleCls() {
 
     DELNULL(itr->second);
   }
-  chainM.clear(); cutM.clear();
+  if(useTrainCache) {
+    for(map <TString,TTree*>::iterator itr = treeM.begin(); itr!=treeM.end(); ++itr) DELNULL(itr->second);
+  }
+  chainM.clear(); treeM.clear(); cutM.clear();
 
   DELNULL(optMap);
 
@@ -330,31 +380,56 @@ void ANNZ::Train_singleReg() {
 
   DELNULL(var);
 
-  // if the cuts for training and validation are different, create new trees
-  // for each of these with the corresponding cuts.
-  TString cutTrain((TString)cutM["_train"]); cutTrain.ReplaceAll(" ","");
-  TString cutValid((TString)cutM["_valid"]); cutValid.ReplaceAll(" ","");
-  if(cutTrain != cutValid) {
-    createCutTrainTrees(chainM,cutM,optMap);
-    cutM["_combined"] = "";
+  // the trees for the factory - if the training cache is used, create in-memory trees which
+  // only hold the objects which pass the cuts, and the branches which are needed for training
+  map < TString,TTree* > treeM;
+
+  if(glob->GetOptB("trainCache")) {
+    vector <TString> exprV(inNamesVar[nMLMnow]);
+    exprV.push_back(zTrgName); exprV.push_back(wgtTrain);
+
+    TrainCache * trainCache = new TrainCache("trainCache",utils,glob,outputs);
+
+    for(int trainValidType=0; trainValidType<2; trainValidType++) {
+      TString trainValidName = (TString)((trainValidType == 0) ? "_train" : "_valid");
+
+      treeM[trainValidName+"_cut"] = trainCache->getTree(chainM[trainValidName],exprV,cutM["_comn"]+cutM[trainValidName]);
+    }
+    DELNULL(trainCache); exprV.clear();
+
+    if(treeM["_train_cut"] && treeM["_valid_cut"]) cutM["_combined"] = "";
+    else { DELNULL(treeM["_train_cut"]); DELNULL(treeM["_valid_cut"]); treeM.clear(); }
   }
-  else {
-    cutM  ["_combined"]  = cutM["_comn"] + cutM["_train"];
-    chainM["_train_cut"] = chainM["_train"]; chainM.erase("_train");
-    chainM["_valid_cut"] = chainM["_valid"]; chainM.erase("_valid");
+
+  if(treeM.size() == 0) {
+    // if the cuts for training and validation are different, create new trees
+    // for each of these with the corresponding cuts.
+    TString cutTrain((TString)cutM["_train"]); cutTrain.ReplaceAll(" ","");
+    TString cutValid((TString)cutM["_valid"]); cutValid.ReplaceAll(" ","");
+    if(cutTrain != cutValid) {
+      createCutTrainTrees(chainM,cutM,optMap);
+      cutM["_combined"] = "";
+    }
+    else {
+      cutM  ["_combined"]  = cutM["_comn"] + cutM["_train"];
+      chainM["_train_cut"] = chainM["_train"]; chainM.erase("_train");
+      chainM["_valid_cut"] = chainM["_valid"]; chainM.erase("_valid");
+    }
   }
+  bool useTrainCache = (treeM.size() > 0);
+  if(!useTrainCache) { treeM["_train_cut"] = chainM["_train_cut"]; treeM["_valid_cut"] = chainM["_valid_cut"]; }
 
   double regWeight(1.0); // weight for the entire sample
-  dataLdr->AddRegressionTree(chainM["_train_cut"], regWeight, TMVA::Types::kTraining);
-  dataLdr->AddRegressionTree(chainM["_valid_cut"], regWeight, TMVA::Types::kTesting );
+  dataLdr->AddRegressionTree(treeM["_train_cut"], regWeight, TMVA::Types::kTraining);
+  dataLdr->AddRegressionTree(treeM["_valid_cut"], regWeight, TMVA::Types::kTesting );
 
   // set the sample-weights  
   dataLdr->SetWeightExpression(wgtTrain,"Regression");
 
   // deprecated
   TCanvas * tmpCnvs = new TCanvas("tmpCnvs","tmpCnvs");
-  int nTrain = chainM["_train_cut"]->Draw(zTrgName,cutM["_combined"]); // if(maxNobj > 0 && maxNobj < nTrain) nTrain = maxNobj;
-  int nValid = chainM["_valid_cut"]->Draw(zTrgName,cutM["_combined"]); // if(maxNobj > 0 && maxNobj < nValid) nValid = maxNobj;
+  int nTrain = treeM["_train_cut"]->Draw(zTrgName,cutM["_combined"]); // if(maxNobj > 0 && maxNobj < nTrain) nTrain = maxNobj;
+  int nValid = treeM["_valid_cut"]->Draw(zTrgName,cutM["_combined"]); // if(maxNobj > 0 && maxNobj < nValid) nValid = maxNobj;
   DELNULL(tmpCnvs);
 
   VERIFY(LOCATION,(TString)"Got the following [nTrain, nValid = "+TString::Format("%d, %d",nTrain,nValid)
@@ -436,7 +511,10 @@ void ANNZ::Train_singleReg() {
 
     DELNULL(itr->second);
   }
-  chainM.clear(); cutM.clear();
+  if(useTrainCache) {
+    for(map <TString,TTree*>::iterator itr = treeM.begin(); itr!=treeM.end(); ++itr) DELNULL(itr->second);
+  }
+  chainM.clear(); treeM.clear(); cutM.clear();
 
   DELNULL(optMap);
 
@@ -909,6 +987,13 @@ void ANNZ::Train_singleRegBiasCor() {
  *           or larger than the lower and upper edges of the signal region respectively.
  *           Out of the collection of MLMs, only the "best" solution is kept. The latter is defined
  *           as the one for which the separation between signal and background is the best (highest).
+ *           - If binCls_nTryWorkers is larger than one, the candidate MLMs (tries) are trained concurrently. The signal
+ *           and background trees are derived once, and then a worker process is forked for each try, where up to
+ *           binCls_nTryWorkers workers run at the same time. Each worker trains in its own directory (tryDirNameV),
+ *           and the random numbers for the background cuts of all tries are drawn in advance, in the same order as for
+ *           consecutive training, so that the results do not depend on the number of workers. The best separation is
+ *           chosen after all of the workers are done.
+ *           - Worker processes are used rather than threads, since TMVA keeps global state (see Manager::trainWorkers()).
  */
 // ===========================================================================================================
 void ANNZ::Train_binnedCls() {
@@ -929,6 +1014,7 @@ void ANNZ::Train_binnedCls() {
   double   bckShiftMax           = glob->GetOptF("binCls_bckShiftMax");
   bool     useBckShift           = ((fabs(bckShiftMax - bckShiftMin) < EPS || bckShiftMax > bckShiftMin) && (bckShiftMax > 0 && bckShiftMin > 0));
   bool     doMultiCls            = glob->GetOptB("doMultiCls");
+  int      nTryWorkers           = glob->GetOptI("binCls_nTryWorkers");
 
   TString  MLMname               = getTagName(nMLMnow);
   TString  saveFileName          = getKeyWord(MLMname,"trainXML","configSaveFileName");
@@ -1002,17 +1088,163 @@ void ANNZ::Train_binnedCls() {
   VERIFY(LOCATION,(TString)"If using inputVarErrors_, must specify \"inputVarErrors_XXX\" corresponding to every \"inputVariables_XXX\""
                           ,(nRndInpVar == nRndInpErr || nRndInpErr == 0));
 
+  // draw the random numbers for the background cuts of all tries in advance (in the same order as for consecutive
+  // training), so that the cuts of a given try do not depend on which tries are trained concurrently
+  vector <double> bckShiftRndV(nTries,0), bckSubsetRndV(2*nTries,0);
+  for(int nTryNow=0; nTryNow<nTries; nTryNow++) {
+    if(doMultiCls) continue;
+
+    if(useBckShift)          { bckShiftRndV [nTryNow]   = rnd0->Rndm();                                           }
+    if(bckSubsetRange != "") { bckSubsetRndV[2*nTryNow] = rnd1->Rndm(); bckSubsetRndV[2*nTryNow+1] = rnd1->Rndm(); }
+  }
+
+  if(nTryWorkers <= 0) nTryWorkers = static_cast<int>(std::thread::hardware_concurrency());
+  nTryWorkers = max(min(nTryWorkers,nTries),1);
+
+  // -----------------------------------------------------------------------------------------------------------
+  // create the chains once (they are re-used as-is for each nTryNow)
+  // -----------------------------------------------------------------------------------------------------------
+  TString wgtTrain("");
+  int     nTrain_sig(0), nTrain_bck(0), nValid_sig(0), nValid_bck(0);
+
+  optMap = new OptMaps("localOptMap");
+
+  // input root files for training
+  // -----------------------------------------------------------------------------------------------------------
+  for(int trainValidType=0; trainValidType<2; trainValidType++) {
+    TString trainValidName  = (TString)((trainValidType == 0) ? "_train" : "_valid");
+
+    inTreeName  = (TString)glob->GetOptC("treeName")+trainValidName;
+    inFileName  = (TString)glob->GetOptC("inputTreeDirName")+inTreeName+"*.root";
+    chainM[trainValidName] = new TChain(inTreeName,inTreeName);
+    chainM[trainValidName]->SetDirectory(0);  chainM[trainValidName]->Add(inFileName);
+    aLOG(Log::DEBUG) <<coutRed<<" - added chain  "<<coutGreen<<inTreeName<<" from "<<coutBlue<<inFileName<<coutDef<<endl;
+  }
+  verifTarget(chainM["_train"]); verifTarget(chainM["_valid"]);
+
+  // set input variables and cuts and connect them to the factory
+  // -----------------------------------------------------------------------------------------------------------
+  VarMaps * var = new VarMaps(glob,utils,"mainTrainVar");
+
+  var->connectTreeBranches(chainM["_train"]);  // connect the tree so as to allocate memory for cut variables
+
+  setMethodCuts(var,nMLMnow);
+
+  // deprecated
+  // // replace the training/validation cut definition in var, so that cutM["_valid"] will get the testing objects  
+  // if(glob->GetOptB("separateTestValid")) {
+  //   int nFoundCuts = var->replaceTreeCut(glob->GetOptC("testValidType_valid"),glob->GetOptC("testValidType_train"));
+  //   VERIFY(LOCATION,(TString)"Did not find cut \""+glob->GetOptC("testValidType_valid")+"\". Something is horribly wrong... ?!?",(nFoundCuts != 0));
+  // }
+
+  wgtTrain       = getRegularStrForm(userWgtsM[MLMname+"_train"],var);
+
+  cutM["_comn"]  = var->getTreeCuts("_comn");
+  cutM["_train"] = var->getTreeCuts(MLMname+"_train");
+  cutM["_valid"] = var->getTreeCuts(MLMname+"_valid");
+  // cutM["_train"] = var->getTreeCuts("_train") + var->getTreeCuts(MLMname+"_train"); // deprecated
+  // cutM["_valid"] = var->getTreeCuts("_valid") + var->getTreeCuts(MLMname+"_valid"); // deprecated
+
+  DELNULL(var);
+
+  // derive the bins and store them in cutM["_sig"], cutM["_bck"] and in userCutsM["_sig"], userCutsM["_bck"]
+  // (userCutsM is used in makeTreeRegClsOneMLM() later on, so that var_0->hasFailedTreeCuts("_sig") is well defined)
+  clsBins = deriveBinClsBins(chainM,cutM);
+
+  // crate new chains with unique signal or background objects
+  splitToSigBckTrees(chainM,cutM,optMap);
+
+  nTrain_sig = optMap->GetOptI("ANNZ_nTrain_sig");
+  nTrain_bck = optMap->GetOptI("ANNZ_nTrain_bck");
+  nValid_sig = optMap->GetOptI("ANNZ_nValid_sig");
+  nValid_bck = optMap->GetOptI("ANNZ_nValid_bck");
+
+  TString sigBckStr = TString::Format("nTrain_Signal=%d:nTrain_Background=%d:nTest_Signal=%d:nTest_Background=%d",0,0,0,0);
+
+  VERIFY(LOCATION,(TString)"Got the following ["+sigBckStr+"] , where all should be larger than "+utils->intToStr(minObjTrainTest)+", and the "
+                          +"background samples are expected to be larger than the corresponding  signal samples... Something is horribly wrong ?!?!"
+                          ,(nTrain_bck >= nTrain_sig && nValid_bck >= nValid_sig && nTrain_sig >= minObjTrainTest && nValid_sig >= minObjTrainTest));
+
+  DELNULL(optMap);
+
   // -----------------------------------------------------------------------------------------------------------
   // generate an MLM classifier for each candidate-configuration, produce MLM output trees
   // with makeTreeRegClsOneMLM(), and compute the corresponding value of the separation between signal
   // and background.
   // -----------------------------------------------------------------------------------------------------------
-  TString wgtTrain("");
-  int     nTrain_sig(0), nTrain_bck(0), nValid_sig(0), nValid_bck(0);
+  map <pid_t,int> tryWorkerM;
+  vector <int>    failedTryV;
+
+  // wait for any of the workers to finish, and keep track of failed tries
+  auto waitTryWorker = [&]() {
+    int   status(0);
+    pid_t pid = waitpid(-1,&status,0);
+
+    if(pid < 0) {
+      VERIFY(LOCATION,(TString)"Failed while waiting for worker processes ("+strerror(errno)+") ...",(errno == EINTR));
+      return;
+    }
+
+    map <pid_t,int>::iterator itr = tryWorkerM.find(pid);
+    if(itr == tryWorkerM.end()) return;
+
+    bool isGood = (WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    if(!isGood) failedTryV.push_back(itr->second);
+
+    aLOG(Log::INFO) <<(isGood ? coutGreen : coutRed)<<" - worker ("<<coutYellow<<pid<<(isGood ? coutGreen : coutRed)<<") for try "
+                    <<coutYellow<<itr->second<<(isGood ? coutGreen : coutRed)<<(isGood ? " is done ..." : " failed !!!")<<coutDef<<endl;
+
+    tryWorkerM.erase(itr);
+    return;
+  };
 
   for(int nTryNow=0; nTryNow<nTries; nTryNow++) {
     TString nTryName = TString::Format("nTry_%d",nTryNow);
 
+    // for concurrent tries, fork a worker process, which trains in its own directory (the parent process continues to the next try)
+    // -----------------------------------------------------------------------------------------------------------
+    bool    isTryWorker(false);
+    TString workDirName("");
+
+    if(nTryWorkers > 1) {
+      while((int)tryWorkerM.size() >= nTryWorkers) waitTryWorker();
+
+      // flush the outputs, so that buffered messages are not duplicated in the worker
+      cout.flush(); fflush(stdout);
+
+      pid_t pid = fork();
+      VERIFY(LOCATION,(TString)"Could not fork a worker process for try "+utils->intToStr(nTryNow)+" ("+strerror(errno)+") ...",(pid >= 0));
+
+      if(pid > 0) {
+        aLOG(Log::INFO) <<coutGreen<<" - started worker ("<<coutYellow<<pid<<coutGreen<<") for try "<<coutYellow<<nTryNow<<coutGreen<<" ..."<<coutDef<<endl;
+        tryWorkerM[pid] = nTryNow;
+        continue;
+      }
+
+      // the training directory of the worker must end with the name of the MLM (see getKeyWord())
+      isTryWorker = true;
+      workDirName = (TString)tryDirNameV[nTryNow]+MLMname+"/";
+
+      utils->safeRM(tryDirNameV[nTryNow],inLOG(Log::DEBUG_1));
+      glob->SetOptC("trainDirNameFull",workDirName);
+      glob->SetOptC("outDirNameFull",  workDirName);
+      outputs->SetOutDirName(workDirName);
+
+      saveFileName     = getKeyWord(MLMname,"trainXML","configSaveFileName");
+      outFileDirTrain  = getKeyWord(MLMname,"trainXML","outFileDirTrain");
+      postTrainDirName = getKeyWord(MLMname,"postTrain","postTrainDirName");
+
+      // new chains with the same files, so that the input files are not read through file descriptors which
+      // are shared with the other processes (the original chains are not deleted, as their files belong to the parent)
+      for(map <TString,TChain*>::iterator itr = chainM.begin(); itr!=chainM.end(); ++itr) {
+        if(!itr->second) continue;
+
+        TChain * chainNow = new TChain(itr->second->GetName(),itr->second->GetTitle());
+        chainNow->SetDirectory(0); chainNow->Add(itr->second);
+        itr->second = chainNow;
+      }
+    }
+
     // the input parameters cycle through the list of configurations provided by the user
     if(nRndInpVar > 0)       inputVariables = binClsInpVarV[ nTryNow % nRndInpVar ];
     if(nRndInpErr > 0)       inputVarErrors = binClsInpErrV[ nTryNow % nRndInpErr ];
@@ -1052,65 +1284,6 @@ void ANNZ::Train_binnedCls() {
     TString mlmType     = optMap->GetOptC("type");
     TString mlmOpt      = optMap->GetOptC("opt");
 
-    // create the chains once (they can be re-used as-is for each nTryNow)
-    if(nTryNow == 0) {
-      // input root files for training
-      // -----------------------------------------------------------------------------------------------------------
-      for(int trainValidType=0; trainValidType<2; trainValidType++) {
-        TString trainValidName  = (TString)((trainValidType == 0) ? "_train" : "_valid");
-
-        inTreeName  = (TString)glob->GetOptC("treeName")+trainValidName;
-        inFileName  = (TString)glob->GetOptC("inputTreeDirName")+inTreeName+"*.root";
-        chainM[trainValidName] = new TChain(inTreeName,inTreeName);
-        chainM[trainValidName]->SetDirectory(0);  chainM[trainValidName]->Add(inFileName);
-        aLOG(Log::DEBUG) <<coutRed<<" - added chain  "<<coutGreen<<inTreeName<<" from "<<coutBlue<<inFileName<<coutDef<<endl;
-      }
-      verifTarget(chainM["_train"]); verifTarget(chainM["_valid"]);
-
-      // set input variables and cuts and connect them to the factory
-      // -----------------------------------------------------------------------------------------------------------
-      VarMaps * var = new VarMaps(glob,utils,"mainTrainVar");
-
-      var->connectTreeBranches(chainM["_train"]);  // connect the tree so as to allocate memory for cut variables
-
-      setMethodCuts(var,nMLMnow);
-
-      // deprecated
-      // // replace the training/validation cut definition in var, so that cutM["_valid"] will get the testing objects  
-      // if(glob->GetOptB("separateTestValid")) {
-      //   int nFoundCuts = var->replaceTreeCut(glob->GetOptC("testValidType_valid"),glob->GetOptC("testValidType_train"));
-      //   VERIFY(LOCATION,(TString)"Did not find cut \""+glob->GetOptC("testValidType_valid")+"\". Something is horribly wrong... ?!?",(nFoundCuts != 0));
-      // }
-
-      wgtTrain       = getRegularStrForm(userWgtsM[MLMname+"_train"],var);
-
-      cutM["_comn"]  = var->getTreeCuts("_comn");
-      cutM["_train"] = var->getTreeCuts(MLMname+"_train");
-      cutM["_valid"] = var->getTreeCuts(MLMname+"_valid");
-      // cutM["_train"] = var->getTreeCuts("_train") + var->getTreeCuts(MLMname+"_train"); // deprecated
-      // cutM["_valid"] = var->getTreeCuts("_valid") + var->getTreeCuts(MLMname+"_valid"); // deprecated
-
-      DELNULL(var);
-
-      // derive the bins and store them in cutM["_sig"], cutM["_bck"] and in userCutsM["_sig"], userCutsM["_bck"]
-      // (userCutsM is used in makeTreeRegClsOneMLM() later on, so that var_0->hasFailedTreeCuts("_sig") is well defined)
-      clsBins = deriveBinClsBins(chainM,cutM);
-
-      // crate new chains with unique signal or background objects
-      splitToSigBckTrees(chainM,cutM,optMap);
-
-      nTrain_sig = optMap->GetOptI("ANNZ_nTrain_sig");
-      nTrain_bck = optMap->GetOptI("ANNZ_nTrain_bck");
-      nValid_sig = optMap->GetOptI("ANNZ_nValid_sig");
-      nValid_bck = optMap->GetOptI("ANNZ_nValid_bck");
-
-      TString sigBckStr = TString::Format("nTrain_Signal=%d:nTrain_Background=%d:nTest_Signal=%d:nTest_Background=%d",0,0,0,0);
-
-      VERIFY(LOCATION,(TString)"Got the following ["+sigBckStr+"] , where all should be larger than "+utils->intToStr(minObjTrainTest)+", and the "
-                              +"background samples are expected to be larger than the corresponding  signal samples... Something is horribly wrong ?!?!"
-                              ,(nTrain_bck >= nTrain_sig && nValid_bck >= nValid_sig && nTrain_sig >= minObjTrainTest && nValid_sig >= minObjTrainTest));
-    }
-
     // for nTryNow>0 this is needed for chain->Draw(), as the factory turnes off branches from the chain during training
     chainM["_train_sig"]->SetBranchStatus("*",1); chainM["_valid_sig"]->SetBranchStatus("*",1);
     chainM["_train_bck"]->SetBranchStatus("*",1); chainM["_train_bck"]->SetBranchStatus("*",1);
@@ -1131,7 +1304,7 @@ void ANNZ::Train_binnedCls() {
       // -----------------------------------------------------------------------------------------------------------
       // use bckShiftMax to define cuts (zero weights) for a region of background just around the signal region
       if(useBckShift) {
-        double bckShiftVal = bckShiftMin + rnd0->Rndm() * (bckShiftMax - bckShiftMin);
+        double bckShiftVal = bckShiftMin + bckShiftRndV[nTryNow] * (bckShiftMax - bckShiftMin);
         bckShiftCut = TString::Format( (TString)"("+zTrgName+" <= %f || "+zTrgName+"  > %f)",
                                        zBinCls_binE[nMLMnow]-bckShiftVal, zBinCls_binE[nMLMnow+1]+bckShiftVal );
       
@@ -1153,10 +1326,10 @@ void ANNZ::Train_binnedCls() {
                                  ,(bckSubsetMin <= bckSubsetMax && bckSubsetMin > 0 && objRatioV[2] > 0 && objRatioV[2] <= 100));
 
         // generate a random ratio within the requested limits (bckSubsetVal) and the baseine ratio for the sample (bckSubsetRatio)
-        int  bckSubsetVal   = static_cast<int>(floor(0.500001 + rnd1->Rndm() * (bckSubsetMax - bckSubsetMin))) + bckSubsetMin;
+        int  bckSubsetVal   = static_cast<int>(floor(0.500001 + bckSubsetRndV[2*nTryNow] * (bckSubsetMax - bckSubsetMin))) + bckSubsetMin;
         int  bckSubsetRatio = static_cast<int>(ceil(nTrain_bck/double(nTrain_sig)));
 
-        if(useProb/100. > rnd1->Rndm()) {
+        if(useProb/100. > bckSubsetRndV[2*nTryNow+1]) {
           if(bckSubsetVal < bckSubsetRatio) {
             bckSubsetCut = getTrainTestCuts("split",0,bckSubsetVal,bckSubsetRatio);
 
@@ -1331,23 +1504,6 @@ void ANNZ::Train_binnedCls() {
 
     if(!glob->GetOptB("keepTrainingTrees_factory")) utils->safeRM(outFileNameTrain,inLOG(Log::DEBUG));
 
-    if(nTryNow == nTries-1) {
-      for(map <TString,TChain*>::iterator itr = chainM.begin(); itr!=chainM.end(); ++itr) {
-        if(!itr->second) continue;
-
-        TString chainName = itr->second->GetName();
-        aLOG(Log::DEBUG)<<coutYellow<<" - delete "<<chainName<<"      " <<itr->second<<coutDef<<endl;
-
-        if((chainName.Contains("_sig") || chainName.Contains("_bck")) && !glob->GetOptB("keepTrainingTrees_sigBckCut")) {
-          sysCmnd = (TString)trainDirNameFull+chainName+"*.root";
-          utils->safeRM(sysCmnd,inLOG(Log::DEBUG));
-        }
-
-        DELNULL(itr->second);
-      }
-      chainM.clear(); cutM.clear();
-    }
-
     DELNULL(optMap);
 
     // -----------------------------------------------------------------------------------------------------------
@@ -1359,7 +1515,42 @@ void ANNZ::Train_binnedCls() {
     // -----------------------------------------------------------------------------------------------------------
     sysCmnd = (TString)"mkdir -p "+tryDirNameV[nTryNow]+" ; mv "+outFileDirTrain+" "+postTrainDirName+" "+tryDirNameV[nTryNow];
     utils->exeShellCmndOutput(sysCmnd,inLOG(Log::DEBUG));
+
+    // the worker is done - remove the rest of its training directory, and exit without the cleanup of objects
+    // which are shared with the parent process
+    if(isTryWorker) {
+      utils->safeRM(workDirName,inLOG(Log::DEBUG_1));
+
+      cout.flush(); fflush(stdout);
+      _exit(0);
+    }
+  }
+
+  // wait for all of the workers to finish
+  while(tryWorkerM.size() > 0) waitTryWorker();
+
+  if(failedTryV.size() > 0) {
+    TString failedStr("");
+    for(int nFailNow=0; nFailNow<(int)failedTryV.size(); nFailNow++) failedStr += (TString)(nFailNow > 0 ? ", " : "")+utils->intToStr(failedTryV[nFailNow]);
+
+    VERIFY(LOCATION,(TString)"Training failed for tries ["+failedStr+"] of "+MLMname+" ...",false);
+  }
+
+  // cleanup the chains and the signal/background trees
+  for(map <TString,TChain*>::iterator itr = chainM.begin(); itr!=chainM.end(); ++itr) {
+    if(!itr->second) continue;
+
+    TString chainName = itr->second->GetName();
+    aLOG(Log::DEBUG)<<coutYellow<<" - delete "<<chainName<<"      " <<itr->second<<coutDef<<endl;
+
+    if((chainName.Contains("_sig") || chainName.Contains("_bck")) && !glob->GetOptB("keepTrainingTrees_sigBckCut")) {
+      sysCmnd = (TString)trainDirNameFull+chainName+"*.root";
+      utils->safeRM(sysCmnd,inLOG(Log::DEBUG));
+    }
+
+    DELNULL(itr->second);
   }
+  chainM.clear(); cutM.clear();
 
   // -----------------------------------------------------------------------------------------------------------
   // get the separation parameters from file, choose the nTryNow with the highest separation, store
@@ -0,0 +1,412 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// ===========================================================================================================
+// helper functions for the training cache
+// ===========================================================================================================
+namespace trainCacheFuncs {
+  // the number of bytes of a leaf type (as in the title of a branch, e.g., "x/F"), or 0 if not supported
+  int getTypeBytes(TString type) {
+    if(type == "F" || type == "I" || type == "i") return 4;
+    if(type == "D" || type == "L" || type == "l") return 8;
+    if(type == "S" || type == "s")                return 2;
+    if(type == "O")                               return 1;
+    return 0;
+  }
+
+  // the index of a column with a given name, or -1 if not found
+  template <class T> int getColIndex(vector <T> & colV, const TString & name) {
+    for(int nColNow=0; nColNow<(int)colV.size(); nColNow++) { if(colV[nColNow].name == name) return nColNow; }
+    return -1;
+  }
+
+  inline bool isNameChar(char val) { return (isalnum(static_cast<unsigned char>(val)) || val == '_'); }
+
+  // check if a name appears in an expression as a whole word (not as part of a longer name)
+  bool hasName(const TString & expr, const TString & name) {
+    int nameLen = name.Length();
+    for(Ssiz_t pos = expr.Index(name); pos != kNPOS; pos = expr.Index(name,pos+1)) {
+      bool goodBefore = (pos == 0)                     || !isNameChar(expr[pos-1]);
+      bool goodAfter  = (pos+nameLen >= expr.Length()) || !isNameChar(expr[pos+nameLen]);
+      if(goodBefore && goodAfter) return true;
+    }
+    return false;
+  }
+}
+
+// ===========================================================================================================
+TrainCache::TrainCache(TString aName, Utils * aUtils, OptMaps * aMaps, OutMngr * anOutMngr)
+           :BaseClass(       aName,         aUtils,           aMaps,       anOutMngr) {
+// ===========================================================================================================
+  return;
+}
+
+// ===========================================================================================================
+TrainCache::~TrainCache() {
+// ========================
+  aLOG(Log::DEBUG_1) <<coutBlue<<" - starting TrainCache::~TrainCache() ... "<<coutDef<<endl;
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Create an in-memory tree from the cached columns of a chain.
+ *
+ * @details        - The branches of the chain which are used by any of the expressions (or by the cut) are
+ *                 stored in the cache if needed (see writeColumns()), and are then mapped. The new tree holds
+ *                 only these branches, with their original names and types, so that the expressions and the
+ *                 cut may be evaluated on it in the same way as on the chain.
+ *
+ * @param aChain   - The input chain (without friends).
+ * @param exprV    - The expressions (input variables, targets and weights) which are later evaluated on the tree.
+ * @param cut      - The cut for selecting the objects of the tree.
+ *
+ * @return         - The new tree (owned by the caller), or NULL if the cache may not be used for these expressions.
+ */
+// ===========================================================================================================
+TTree * TrainCache::getTree(TChain * aChain, vector <TString> & exprV, TCut cut) {
+// ===========================================================================================================
+  TString treeName = aChain->GetName();
+  TString cutStr   = (TString)cut;
+
+  vector <TString> exprCutV(exprV);
+  if(cutStr != "") exprCutV.push_back(cutStr);
+
+  // get the columns used by the expressions, and store those which are not yet cached
+  // -----------------------------------------------------------------------------------------------------------
+  vector <Column> colV;
+  if(!getColumns(aChain,exprCutV,colV)) return NULL;
+
+  writeColumns(aChain,colV);
+
+  Long64_t nRows = aChain->GetEntries();
+  for(int nColNow=0; nColNow<(int)colV.size(); nColNow++) {
+    if(!mapColumn(colV[nColNow],nRows)) { unmapColumns(colV); return NULL; }
+  }
+
+  // fill an in-memory tree with the mapped columns
+  // -----------------------------------------------------------------------------------------------------------
+  TStopwatch fillTimer;
+
+  TTree * fullTree = new TTree(treeName,treeName); fullTree->SetDirectory(0);
+
+  vector <ULong64_t> slotV(colV.size(),0);
+  for(int nColNow=0; nColNow<(int)colV.size(); nColNow++) {
+    fullTree->Branch(colV[nColNow].name,&slotV[nColNow],(TString)colV[nColNow].name+"/"+colV[nColNow].type);
+  }
+
+  // if possible, the cut is compiled and evaluated directly on the mapped columns (see getCutExpr()), so
+  // that only the selected objects are filled. otherwise, the cut is applied with CopyTree() on the full tree
+  FormExpr * cutExpr = (cutStr != "") ? getCutExpr(cutStr,colV) : NULL;
+
+  const Long64_t    nRowsCut = 65536;
+  vector <Double_t> cutValV;
+
+  for(Long64_t nRowNow=0; nRowNow<nRows; nRowNow++) {
+    if(cutExpr) {
+      Long64_t nRowCut = nRowNow % nRowsCut;
+      if(nRowCut == 0) {
+        Long64_t nRowsNow = min(nRowsCut,nRows-nRowNow);
+        for(int nVarNow=0; nVarNow<cutExpr->GetNvars(); nVarNow++) {
+          Column & col = colV[trainCacheFuncs::getColIndex(colV,cutExpr->GetVarName(nVarNow))];
+          cutExpr->BindVar(nVarNow,col.type[0],col.data + nRowNow * col.nBytes,col.nBytes);
+        }
+        cutValV.resize(nRowsNow);
+        cutExpr->EvalBatch(nRowsNow,&cutValV[0]);
+      }
+      // as in CopyTree(), an object is selected if the cut is not zero
+      if(cutValV[nRowCut] == 0) continue;
+    }
+
+    for(int nColNow=0; nColNow<(int)colV.size(); nColNow++) {
+      memcpy(&slotV[nColNow],colV[nColNow].data + nRowNow * colV[nColNow].nBytes,colV[nColNow].nBytes);
+    }
+    fullTree->Fill();
+  }
+  unmapColumns(colV);
+
+  // select the objects which pass the cut
+  TTree * outTree(fullTree);
+  if(cutStr != "" && !cutExpr) {
+    outTree = fullTree->CopyTree(cutStr); outTree->SetDirectory(0);
+    DELNULL(fullTree);
+  }
+  DELNULL(cutExpr); cutValV.clear();
+  // the addresses of the branches point to slotV, so let the tree allocate its own memory from now on
+  outTree->ResetBranchAddresses();
+
+  fillTimer.Stop();
+  aLOG(Log::INFO) <<coutGreen<<" - created "<<coutBlue<<treeName<<coutGreen<<" ("<<coutYellow<<outTree->GetEntries()<<coutGreen<<"/"
+                  <<coutYellow<<nRows<<coutGreen<<" objects, "<<coutYellow<<colV.size()<<coutGreen<<" columns) from the training cache in "
+                  <<coutYellow<<TString::Format("%3.3g",fillTimer.RealTime())<<coutGreen<<" sec ..."<<coutDef<<endl;
+
+  colV.clear(); slotV.clear(); exprCutV.clear();
+
+  return outTree;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Compile a cut, such that it may be evaluated on the mapped columns.
+ *
+ * @param cutStr   - The cut.
+ * @param colV     - The columns.
+ *
+ * @return         - The compiled cut (owned by the caller), or NULL if the cut may only be evaluated with a
+ *                 TTreeFormula (or if useCompiledForms is false).
+ */
+// ===========================================================================================================
+FormExpr * TrainCache::getCutExpr(TString cutStr, vector <Column> & colV) {
+// ===========================================================================================================
+  if(!glob->OptOrNullB("useCompiledForms")) return NULL;
+
+  FormExpr * cutExpr = new FormExpr();
+  bool     isGood    = cutExpr->Compile(cutStr);
+
+  // all variables of the cut must be columns (which is usually the case, since the columns
+  // are selected by the names of the branches in the expressions)
+  for(int nVarNow=0; nVarNow<cutExpr->GetNvars(); nVarNow++) {
+    if(!isGood) break;
+    int nCol = trainCacheFuncs::getColIndex(colV,cutExpr->GetVarName(nVarNow));
+    isGood   = (nCol >= 0 && FormExpr::isTypeSupported(colV[nCol].type[0]));
+  }
+
+  if(!isGood) DELNULL(cutExpr);
+
+  aLOG(Log::DEBUG) <<coutBlue<<" - the cut "<<coutYellow<<cutStr<<coutBlue<<(isGood ? " is compiled" : " can not be compiled")
+                   <<" for the training cache ..."<<coutDef<<endl;
+
+  return cutExpr;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Find the branches of a chain which are used by a set of expressions.
+ *
+ * @param aChain   - The input chain.
+ * @param exprV    - The expressions.
+ * @param colV     - The columns which are found (with the name of the file of each column in the cache).
+ *
+ * @return         - false if an expression uses a branch which can not be cached.
+ */
+// ===========================================================================================================
+bool TrainCache::getColumns(TChain * aChain, vector <TString> & exprV, vector <Column> & colV) {
+// ===========================================================================================================
+  // the columns of a chain are stored in a directory, which is derived from the files of the chain
+  TString cacheDirName = (TString)glob->GetOptC("inputTreeDirName")+"trainCache/"+aChain->GetName()+"_"
+                        +TString::Format("%016llx",utils->getStrHash(utils->getChainFileStamp(aChain)))+"/";
+
+  TObjArray * brnchList = aChain->GetListOfBranches();
+  if(!dynamic_cast<TObjArray*>(brnchList)) return false;
+
+  for(int nBrnchNow=0; nBrnchNow<=brnchList->GetLast(); nBrnchNow++) {
+    TBranch * aBranch = (TBranch*)(brnchList->At(nBrnchNow));
+    TString brnchName = aBranch->GetName();
+
+    bool isUsed(false);
+    for(int nExprNow=0; nExprNow<(int)exprV.size(); nExprNow++) {
+      if(trainCacheFuncs::hasName(exprV[nExprNow],brnchName)) { isUsed = true; break; }
+    }
+    if(!isUsed) continue;
+
+    // only single-valued numerical branches (e.g., with a title "x/F") are supported
+    TString brnchTitle = aBranch->GetTitle();
+    TString brnchType  = (brnchTitle.Length() > 2 && brnchTitle[brnchTitle.Length()-2] == '/')
+                         ? (TString)brnchTitle(brnchTitle.Length()-1,1) : (TString)"";
+    int     nBytes     = trainCacheFuncs::getTypeBytes(brnchType);
+
+    if(nBytes == 0 || brnchTitle.Contains("[") || aBranch->GetListOfLeaves()->GetEntries() != 1) {
+      aLOG(Log::INFO) <<coutRed<<" - branch "<<coutYellow<<brnchName<<coutRed<<" ("<<brnchTitle<<") of "<<coutBlue<<aChain->GetName()
+                      <<coutRed<<" can not be cached ... will not use the training cache"<<coutDef<<endl;
+      colV.clear();
+      return false;
+    }
+
+    Column col;
+    col.name     = brnchName;  col.type    = brnchType;  col.nBytes = nBytes;
+    col.fileName = (TString)cacheDirName+brnchName+".col";
+    col.isCached = !gSystem->AccessPathName(col.fileName);
+    col.mapPtr   = NULL;       col.mapSize = 0;          col.data   = NULL;
+
+    colV.push_back(col);
+  }
+
+  return (colV.size() > 0);
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Store the columns which are not yet in the cache, using a single pass over the chain,
+ *                 where only the relevant branches are read.
+ *
+ * @details        - The format of a column file is (all numbers are little-endian): the 8 character magic
+ *                 string "ANNZCOL1", the leaf type (8 characters, padded with zeros), the number of rows (uint64),
+ *                 and then the values of all rows, in the native size of the leaf type.
+ *                 Each file is first written under a temporary name, and then renamed, so that concurrent
+ *                 trainings (e.g., with nMLMnowRange) never read a partially written column.
+ *
+ * @param aChain   - The input chain.
+ * @param colV     - The columns.
+ */
+// ===========================================================================================================
+void TrainCache::writeColumns(TChain * aChain, vector <Column> & colV) {
+// ===========================================================================================================
+  vector <int> writeColV;
+  for(int nColNow=0; nColNow<(int)colV.size(); nColNow++) {
+    if(!colV[nColNow].isCached) writeColV.push_back(nColNow);
+  }
+  if(writeColV.size() == 0) return;
+
+  TStopwatch writeTimer;
+
+  int      nWriteCols = (int)writeColV.size();
+  Long64_t nRows      = aChain->GetEntries();
+
+  gSystem->mkdir(gSystem->DirName(colV[writeColV[0]].fileName),true);
+
+  // open the output files, and write the headers
+  vector <std::ofstream*> outFileV(nWriteCols,NULL);
+  vector <TString>        tmpFileNameV(nWriteCols,"");
+  vector <ULong64_t>      slotV(nWriteCols,0);
+
+  aChain->SetBranchStatus("*",0);
+
+  for(int nWriteNow=0; nWriteNow<nWriteCols; nWriteNow++) {
+    Column & col = colV[writeColV[nWriteNow]];
+
+    tmpFileNameV[nWriteNow] = (TString)col.fileName+TString::Format(".tmp%d",gSystem->GetPid());
+    outFileV    [nWriteNow] = new std::ofstream(tmpFileNameV[nWriteNow].Data(),std::ios::out | std::ios::binary);
+
+    char      header[24];
+    ULong64_t nRowsOut(nRows);
+    memset(header,0,24);
+    memcpy(header,"ANNZCOL1",8); memcpy(header+8,col.type.Data(),col.type.Length()); memcpy(header+16,&nRowsOut,8);
+    outFileV[nWriteNow]->write(header,24);
+
+    aChain->SetBranchStatus(col.name,1);
+    aChain->SetBranchAddress(col.name,&slotV[nWriteNow]);
+  }
+
+  // read the chain and write the values
+  for(Long64_t nRowNow=0; nRowNow<nRows; nRowNow++) {
+    aChain->GetEntry(nRowNow);
+
+    for(int nWriteNow=0; nWriteNow<nWriteCols; nWriteNow++) {
+      outFileV[nWriteNow]->write(reinterpret_cast<const char*>(&slotV[nWriteNow]),colV[writeColV[nWriteNow]].nBytes);
+    }
+  }
+
+  aChain->ResetBranchAddresses();
+  aChain->SetBranchStatus("*",1);
+
+  // close the files, and move them to their final names
+  for(int nWriteNow=0; nWriteNow<nWriteCols; nWriteNow++) {
+    Column & col = colV[writeColV[nWriteNow]];
+
+    bool writeOk = outFileV[nWriteNow]->good();
+    outFileV[nWriteNow]->close(); DELNULL(outFileV[nWriteNow]);
+
+    if(writeOk && rename(tmpFileNameV[nWriteNow].Data(),col.fileName.Data()) == 0) {
+      col.isCached = true;
+    }
+    else {
+      aLOG(Log::WARNING) <<coutRed<<" - could not write column to training cache: "<<coutBlue<<col.fileName<<coutDef<<endl;
+      gSystem->Unlink(tmpFileNameV[nWriteNow]);
+    }
+  }
+
+  writeTimer.Stop();
+  aLOG(Log::INFO) <<coutGreen<<" - stored "<<coutYellow<<nWriteCols<<coutGreen<<" columns of "<<coutBlue<<aChain->GetName()
+                  <<coutGreen<<" ("<<coutYellow<<nRows<<coutGreen<<" objects) in the training cache in "<<coutYellow
+                  <<TString::Format("%3.3g",writeTimer.RealTime())<<coutGreen<<" sec ..."<<coutDef<<endl;
+
+  outFileV.clear(); tmpFileNameV.clear(); slotV.clear(); writeColV.clear();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Memory-map a column of the cache, and validate its header.
+ *
+ * @param col      - The column.
+ * @param nRows    - The expected number of rows.
+ *
+ * @return         - true if the column was mapped.
+ */
+// ===========================================================================================================
+bool TrainCache::mapColumn(Column & col, Long64_t nRows) {
+// ===========================================================================================================
+  if(!col.isCached) return false;
+
+  int fileDesc = ::open(col.fileName.Data(),O_RDONLY);
+  if(fileDesc < 0) return false;
+
+  struct stat fileStat;
+  if(fstat(fileDesc,&fileStat) == 0 && fileStat.st_size > 0) {
+    col.mapSize = static_cast<size_t>(fileStat.st_size);
+    col.mapPtr  = mmap(NULL,col.mapSize,PROT_READ,MAP_PRIVATE,fileDesc,0);
+    if(col.mapPtr == MAP_FAILED) col.mapPtr = NULL;
+    else                         madvise(col.mapPtr,col.mapSize,MADV_SEQUENTIAL);
+  }
+  ::close(fileDesc);
+
+  if(!col.mapPtr) return false;
+
+  const char * mapBegin = static_cast<const char*>(col.mapPtr);
+  ULong64_t    nRowsIn(0);
+  char         typeIn[9];
+  memset(typeIn,0,9);
+
+  bool isGood = (col.mapSize >= 24 && memcmp(mapBegin,"ANNZCOL1",8) == 0);
+  if(isGood) {
+    memcpy(typeIn,mapBegin+8,8); memcpy(&nRowsIn,mapBegin+16,8);
+
+    isGood = (   col.type == (TString)typeIn && nRowsIn == static_cast<ULong64_t>(nRows)
+              && col.mapSize == 24 + nRowsIn * col.nBytes );
+  }
+
+  if(!isGood) {
+    aLOG(Log::WARNING) <<coutRed<<" - found inconsistent column in training cache: "<<coutBlue<<col.fileName
+                       <<coutRed<<" ... will not use the training cache"<<coutDef<<endl;
+
+    munmap(col.mapPtr,col.mapSize); col.mapPtr = NULL; col.mapSize = 0;
+    return false;
+  }
+
+  col.data = mapBegin + 24;
+
+  return true;
+}
+
+// ===========================================================================================================
+void TrainCache::unmapColumns(vector <Column> & colV) {
+// ====================================================
+  for(int nColNow=0; nColNow<(int)colV.size(); nColNow++) {
+    if(colV[nColNow].mapPtr) munmap(colV[nColNow].mapPtr,colV[nColNow].mapSize);
+
+    colV[nColNow].mapPtr = NULL; colV[nColNow].mapSize = 0; colV[nColNow].data = NULL;
+  }
+  return;
+}
@@ -717,72 +717,78 @@ TString ANNZ::getBaseTagName(TString MLMname) {
   return mlmBaseTag[MLMname];
 }
 // ===========================================================================================================
-TString ANNZ::getTagName(int nMLMnow) {
+// the following accessors are used in per-object loops - the names are only built in setTags(), and are
+// returned by reference, while the range checks use the sizes of the tag containers, rather than glob options
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < glob->GetOptI("nMLMs")));
+const TString & ANNZ::getTagName(int nMLMnow) {
+// ===========================================================================================================
+  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < (int)mlmTagName.size()));
   return mlmTagName[nMLMnow];
 }
 // ===========================================================================================================
-TString ANNZ::getTagError(int nMLMnow, TString errType) {
+const TString & ANNZ::getTagError(int nMLMnow, const TString & errType) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < glob->GetOptI("nMLMs")));
-  VERIFY(LOCATION,(TString)"(Unknown error-type requested (\"errType\" = "+errType+")",(mlmTagErr[nMLMnow].find(errType) != mlmTagErr[nMLMnow].end()));
-  return mlmTagErr[nMLMnow][errType];
+  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < (int)mlmTagErr.size()));
+
+  map <TString,TString>::iterator itr = mlmTagErr[nMLMnow].find(errType);
+  VERIFY(LOCATION,(TString)"(Unknown error-type requested (\"errType\" = "+errType+")",(itr != mlmTagErr[nMLMnow].end()));
+  return itr->second;
 }
 // ===========================================================================================================
-TString ANNZ::getTagWeight(int nMLMnow) {
+const TString & ANNZ::getTagWeight(int nMLMnow) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < glob->GetOptI("nMLMs")));
+  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < (int)mlmTagWeight.size()));
   return mlmTagWeight[nMLMnow];
 }
 // ===========================================================================================================
-TString ANNZ::getTagBias(int nMLMnow) {
+const TString & ANNZ::getTagBias(int nMLMnow) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < glob->GetOptI("nMLMs")));
+  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < (int)mlmTagBias.size()));
   return mlmTagBias[nMLMnow];
 }
 // ===========================================================================================================
-TString ANNZ::getTagClsVal(int nMLMnow) {
+const TString & ANNZ::getTagClsVal(int nMLMnow) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < glob->GetOptI("nMLMs")));
+  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < (int)mlmTagClsVal.size()));
   return mlmTagClsVal[nMLMnow];
 }
 // ===========================================================================================================
-TString ANNZ::getTagIndex(int nMLMnow) {
+const TString & ANNZ::getTagIndex(int nMLMnow) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < glob->GetOptI("nMLMs")));
+  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < (int)mlmTagIndex.size()));
   return mlmTagIndex[nMLMnow];
 }
 // ===========================================================================================================
-TString ANNZ::getTagInVarErr(int nMLMnow, int nInErrNow) {
+const TString & ANNZ::getTagInVarErr(int nMLMnow, int nInErrNow) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "  +utils->intToStr(nMLMnow)  +") out of range ?!?",(nMLMnow >= 0   && nMLMnow < glob->GetOptI("nMLMs")));
+  VERIFY(LOCATION,(TString)"(nMLMnow = "  +utils->intToStr(nMLMnow)  +") out of range ?!?",(nMLMnow >= 0   && nMLMnow < (int)inErrTag.size()));
   VERIFY(LOCATION,(TString)"(nInErrNow = "+utils->intToStr(nInErrNow)+") out of range ?!?",(nInErrNow >= 0 && nInErrNow < (int)inErrTag[nMLMnow].size()));
 
   return inErrTag[nMLMnow][nInErrNow];
 }
 // ===========================================================================================================
-TString ANNZ::getTagPdfBinName(int nPdfNow, int nBinNow) {
+const TString & ANNZ::getTagPdfBinName(int nPdfNow, int nBinNow) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nPdfNow = "+utils->intToStr(nPdfNow)+") out of range ?!?",(nPdfNow >= 0 && nPdfNow < glob->GetOptI("nPDFs")));
-  VERIFY(LOCATION,(TString)"(nBinNow = "+utils->intToStr(nBinNow)+") out of range ?!?",(nBinNow >= 0 && nBinNow < glob->GetOptI("nPDFbins")));
+  VERIFY(LOCATION,(TString)"(nPdfNow = "+utils->intToStr(nPdfNow)+") out of range ?!?",(nPdfNow >= 0 && nPdfNow < (int)pdfBinNames.size()));
+  VERIFY(LOCATION,(TString)"(nBinNow = "+utils->intToStr(nBinNow)+") out of range ?!?",(nBinNow >= 0 && nBinNow < (int)pdfBinNames[nPdfNow].size()));
 
   return pdfBinNames[nPdfNow][nBinNow];
 }
 // ===========================================================================================================
-TString ANNZ::getTagPdfAvgName(int nPdfNow, TString type) {
+const TString & ANNZ::getTagPdfAvgName(int nPdfNow, const TString & type) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nPdfNow = "+utils->intToStr(nPdfNow)+") out of range ?!?",(nPdfNow >= 0 && nPdfNow < glob->GetOptI("nPDFs")));
-  VERIFY(LOCATION,(TString)"(type = \""+type+"\") has unsupported format",(pdfAvgNames[nPdfNow].find(type) != pdfAvgNames[nPdfNow].end()));
+  VERIFY(LOCATION,(TString)"(nPdfNow = "+utils->intToStr(nPdfNow)+") out of range ?!?",(nPdfNow >= 0 && nPdfNow < (int)pdfAvgNames.size()));
 
-  return pdfAvgNames[nPdfNow][type];
+  map <TString,TString>::iterator itr = pdfAvgNames[nPdfNow].find(type);
+  VERIFY(LOCATION,(TString)"(type = \""+type+"\") has unsupported format",(itr != pdfAvgNames[nPdfNow].end()));
+  return itr->second;
 }
 // ===========================================================================================================
-TString ANNZ::getTagBestMLMname(TString type) {
+const TString & ANNZ::getTagBestMLMname(const TString & type) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(type = \""+type+"\") has unsupported format",(bestMLMname.find(type) != bestMLMname.end()));
-
-  return bestMLMname[type];
+  map <TString,TString>::iterator itr = bestMLMname.find(type);
+  VERIFY(LOCATION,(TString)"(type = \""+type+"\") has unsupported format",(itr != bestMLMname.end()));
+  return itr->second;
 }
 // ===========================================================================================================
 int ANNZ::getTagNow(TString MLMname) {
@@ -796,9 +802,9 @@ int ANNZ::getTagNow(TString MLMname) {
   return nMLMnow;
 }
 // ===========================================================================================================
-TString ANNZ::getErrKNNname(int nMLMnow) {
+const TString & ANNZ::getErrKNNname(int nMLMnow) {
 // ===========================================================================================================
-  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < glob->GetOptI("nMLMs")));
+  VERIFY(LOCATION,(TString)"(nMLMnow = "+utils->intToStr(nMLMnow)+") out of range ?!?",(nMLMnow >= 0 && nMLMnow < (int)mlmTagErrKNN.size()));
   return mlmTagErrKNN[nMLMnow];
 }
 // ===========================================================================================================
@@ -1674,6 +1680,18 @@ void ANNZ::setInfoBinsZ() {
                             +utils->floatToStr(maxValZ)+"]... ",(zPDF_binE[nBinsZ] <= maxValZ));
   }
 
+  // lookup objects for the bins, which are used instead of searching over the bin-edges (constant-time
+  // for bins of equal width, and a binary search otherwise)
+  zClos_binL.Clear(); zPlot_binL.Clear(); zPDF_binL.Clear(); zTrgPlot_binL.Clear();
+
+  if(zClos_binE   .size() > 1) zClos_binL   .Set(zClos_binE);
+  if(zPlot_binE   .size() > 1) zPlot_binL   .Set(zPlot_binE);
+  if(zPDF_binE    .size() > 1) zPDF_binL    .Set(zPDF_binE);
+  if(zTrgPlot_binE.size() > 1) zTrgPlot_binL.Set(zTrgPlot_binE);
+
+  aLOG(Log::DEBUG) <<coutWhiteOnBlack<<coutGreen<<" - setInfoBinsZ() - uniform bins for closure/plotting/PDF/"<<zTrgName<<": "<<coutPurple
+                   <<zClos_binL.IsUniform()<<"/"<<zPlot_binL.IsUniform()<<"/"<<zPDF_binL.IsUniform()<<"/"<<zTrgPlot_binL.IsUniform()<<coutDef<<endl;
+
   bool isGoodSetup = (doTrain && doBinnedCls) || (nPDFs == 0) || (nPDFbins > 0);
   VERIFY(LOCATION,(TString)"Must either use userPdfBins, or set the number of PDF bins (\"nPDFbins\" > 0)",isGoodSetup);
 
@@ -1707,10 +1725,33 @@ int ANNZ::getBinZ(double valZ, vector <double> & binEdgesV, bool forceCheck) {
                             +" larger than high bin-edge ("+utils->floatToStr(binEdgesV[nBinsZ])+")",!forceCheck);
     return -1;
   }
-  for(int nBinZnow=0; nBinZnow<nBinsZ; nBinZnow++) {
-    if(valZ <= binEdgesV[nBinZnow+1]) return nBinZnow;
+  return BinLookup::FindBin(valZ,nBinsZ,&(binEdgesV[0]));
+}
+
+// ===========================================================================================================
+/**
+ * @brief            - Get the bin bumber for a given floating-point value, using a BinLookup which was set
+ *                   in setInfoBinsZ() (e.g., zPDF_binL for the bin-edges, zPDF_binE).
+ *                   
+ * @param valZ       - The floatin-point position for which we look for a bin-number.
+ * @param binLookup  - The lookup object of the bin-edges.
+ * @param forceCheck - option to constrain value to be within the predefined range.
+ * 
+ * @return           - The requested bin-number
+ */
+// ===========================================================================================================
+int ANNZ::getBinZ(double valZ, BinLookup & binLookup, bool forceCheck) {
+// ===========================================================================================================
+  VERIFY(LOCATION,(TString)"Trying to getBinZ() with a BinLookup which has not been set",binLookup.IsSet());
+
+  int nBinZ = binLookup.GetBin(valZ);
+  if(nBinZ < 0) {
+    const vector <double> & binEdgesV = binLookup.GetEdges();
+    VERIFY(LOCATION,(TString)"Trying to getBinRegZ() with valZ = "+utils->floatToStr(valZ)+" outside the range of the bin-edges ["
+                            +utils->floatToStr(binEdgesV.front())+","+utils->floatToStr(binEdgesV.back())+"]",!forceCheck);
   }
-  return -1;
+
+  return nBinZ;
 }
 
 // ===========================================================================================================
@@ -19,6 +19,7 @@
 #include "CatFormat.hpp"
 #include "CatFormat_asciiToTree.cpp"
 #include "CatFormat_wgtKNN.cpp"
+#include "CatFormat_fastInput.cpp"
 
 // ===========================================================================================================
 CatFormat::CatFormat(TString aName, Utils * aUtils, OptMaps * aMaps, OutMngr * anOutMngr)
@@ -31,5 +32,31 @@ CatFormat::~CatFormat() {
 // ======================
   return;
 }
+
+// ===========================================================================================================
+InputSplitThread::InputSplitThread(TString aName, Utils * aUtils, OptMaps * aMaps, OutMngr * anOutMngr)
+                 :BaseClass(       aName,         aUtils,           aMaps,       anOutMngr) {
+// ===========================================================================================================
+  nObj = 0; rnd = NULL; var = NULL;
+  return;
+}
+
+// ===========================================================================================================
+InputSplitThread::~InputSplitThread() {
+// ====================================
+  aLOG(Log::DEBUG_1) <<coutBlue<<" - starting InputSplitThread::~InputSplitThread() ... "<<coutDef<<endl;
+
+  for(int nTreeNow=0; nTreeNow<(int)treeOut.size(); nTreeNow++) {
+    outputs->TreeMap.erase(treeOut[nTreeNow]->GetName()); DELNULL(treeOut[nTreeNow]);
+  }
+  treeOut.clear(); inVarNames.clear(); inVarTypes.clear(); inVarHdls.clear(); intMap.clear();
+
+  DELNULL(var); DELNULL(rnd);
+
+  // the utils and output manager are always owned by the thread
+  DELNULL(outputs); DELNULL(utils);
+
+  return;
+}
 // ===========================================================================================================
 
@@ -64,6 +64,7 @@ void CatFormat::inputToFullTree(TString inAsciiFiles, TString inAsciiVars, TStri
   TString indexName         = glob->GetOptC("indexName");
   TString weightName        = glob->GetOptC("baseName_wgtKNN");
   bool    storeOrigFileName = glob->GetOptB("storeOrigFileName");
+  bool    useFastInput      = glob->GetOptB("fastInput");
   
   TString sigBckInpName     = glob->GetOptC("sigBckInpName");
   TString inpFiles_sig      = glob->GetOptC("inpFiles_sig");
@@ -103,7 +104,7 @@ void CatFormat::inputToFullTree(TString inAsciiFiles, TString inAsciiVars, TStri
     }
   }
   else {
-    int nLinesTot = utils->getNlinesAsciiFile(inFileNameV,true,&nLineV);
+    int nLinesTot = getNinputLines(inFileNameV,true,&nLineV);
     VERIFY(LOCATION,(TString)"found no content in \"inAsciiFiles\"...",(nLinesTot > 0));
   }
 
@@ -117,6 +118,10 @@ void CatFormat::inputToFullTree(TString inAsciiFiles, TString inAsciiVars, TStri
   // -----------------------------------------------------------------------------------------------------------
   parseInputVars(var,inAsciiVars,inVarNames,inVarTypes);
 
+  // resolve the input variables once, to avoid name lookups for each input line
+  vector <VarMaps::VarHandle> inVarHdls;
+  var->GetVarHandles(inVarNames,inVarHdls);
+
   // create the output tree(s) now thah all the variables are defined
   // -----------------------------------------------------------------------------------------------------------
   TTree * treeOut = new TTree(treeName,treeName);treeOut->SetDirectory(0);
@@ -136,25 +141,7 @@ void CatFormat::inputToFullTree(TString inAsciiFiles, TString inAsciiVars, TStri
 
     // optional parameter to mark if an object is of type signal (1), background (0) or undefined (-1), based on the name of the input file
     int sigBckInp(-1);
-    if(addSigBckInp) {
-      int nSigBckFound(0);
-
-      if(find(inpFiles_bckV.begin(),inpFiles_bckV.end(),reducedFileName) != inpFiles_bckV.end()) { nSigBckFound++; sigBckInp = 0; }
-      if(find(inpFiles_sigV.begin(),inpFiles_sigV.end(),reducedFileName) != inpFiles_sigV.end()) { nSigBckFound++; sigBckInp = 1; }
-
-      if(nSigBckFound == 0) {
-        aLOG(Log::WARNING)<<coutBlue<<" - Skipping "<<coutRed<<inFileNameNow<<coutBlue
-                          <<" \"inpFiles_bck\" and \"inpFiles_sig\" are defined, but do not include it ... "<<coutDef<<endl;
-        continue;
-      }
-      else if(nSigBckFound == 1) {
-        aLOG(Log::INFO)<<coutBlue<<" - Will add \"sigBckInpName\" = "<<coutYellow<<sigBckInp<<" ("<<(TString)((sigBckInp == 0)?"background":"signal")
-                       <<")"<<coutBlue<<" for all objects from "<<coutGreen<<reducedFileName<<coutDef<<endl;
-      }
-      else {
-        VERIFY(LOCATION,(TString)"Input file \""+reducedFileName+"\" found in both \"inpFiles_bck\" and \"inpFiles_sig\".",false);
-      }
-    }
+    if(!getInputSigBck(inFileNameNow,inpFiles_sigV,inpFiles_bckV,sigBckInp)) continue;
 
     // skip input files with no content
     if(!isRootInput) {
@@ -224,13 +211,30 @@ void CatFormat::inputToFullTree(TString inAsciiFiles, TString inAsciiVars, TStri
       DELNULL(var_0); DELNULL(inChain); varTypeNameV.clear();
     }
     else {
-      std::ifstream inputFile(inFileNameNow,std::ios::in);
-      std::string   line;
+      // ascii inputs are either read line by line, or (for fastInput or for binary inputs) using a memory-mapped InputFileReader
+      bool            useReader = (useFastInput || InputFileReader::getFileType(inFileNameNow) != InputFileReader::ASCII);
+      InputFileReader inReader;
+      std::ifstream   inputFile;
+      std::string     line;
+      TStopwatch      readTimer;
+
+      if(useReader) {
+        TString failMsg("");
+        VERIFY(LOCATION,(TString)"Could not read input file ("+inFileNameNow+"): "+failMsg,inReader.open(inFileNameNow,failMsg));
+      }
+      else inputFile.open(inFileNameNow,std::ios::in);
 
-      while(!inputFile.eof()) {
+      while(true) {
         // get an object
         // -----------------------------------------------------------------------------------------------------------
-        getline(inputFile, line);  if(!inputLineToVars((TString)line,var,inVarNames,inVarTypes)) continue;
+        if(useReader) {
+          if(!inReader.nextRow()) break;
+          inputRowToVars(&inReader,var,inVarNames,inVarTypes,inVarHdls);
+        }
+        else {
+          if(inputFile.eof()) break;
+          getline(inputFile, line);  if(!inputLineToVars((TString)line,var,inVarNames,inVarTypes,&inVarHdls)) continue;
+        }
 
         if((mayWriteObjects && var->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
           mayWriteObjects = false;
@@ -265,6 +269,12 @@ void CatFormat::inputToFullTree(TString inAsciiFiles, TString inAsciiVars, TStri
         // update counters
         var->IncCntr("nObj"); var->IncCntr("nLine"); mayWriteObjects = true; if(var->GetCntr("nObj") == maxNobj) breakLoop = true;
       }
+
+      readTimer.Stop();
+      double readTime = readTimer.RealTime(), nObjRead = var->GetCntr("nLine");
+      aLOG(Log::INFO) <<coutGreen<<" - Read "<<coutYellow<<nObjRead<<coutGreen<<" objects in "<<coutYellow<<TString::Format("%3.3g",readTime)
+                      <<coutGreen<<" sec ("<<coutYellow<<TString::Format("%3.3g",(readTime > 0) ? nObjRead/readTime : 0.)
+                      <<coutGreen<<" objects/sec, "<<coutPurple<<(TString)(useReader ? "memory-mapped" : "line by line")<<coutGreen<<") ..."<<coutDef<<endl;
     }
 
   }
@@ -319,6 +329,7 @@ void CatFormat::inputToSplitTree(TString inAsciiFiles, TString inAsciiVars) {
   TString inTreeName        = glob->GetOptC("inTreeName");
   TString inTreeNameTrain   = glob->GetOptC("inTreeNameTrain");
   TString inTreeNameTest    = glob->GetOptC("inTreeNameTest");
+  bool    useFastInput      = glob->GetOptB("fastInput");
 
   TString sigBckInpName     = glob->GetOptC("sigBckInpName");
   TString inpFiles_sig      = glob->GetOptC("inpFiles_sig");
@@ -328,9 +339,13 @@ void CatFormat::inputToSplitTree(TString inAsciiFiles, TString inAsciiVars) {
   VERIFY(LOCATION,(TString)"found unsupported number of splittings ("+utils->intToStr(nSplit)+"). Allowed values are: 1 or 2"
                   ,(nSplit == 1 || nSplit == 2));
 
-  // random number generator for the (splitType == "random") option
-  TRandom * rnd = new TRandom3(glob->GetOptI("splitSeed"));
-  VERIFY(LOCATION,(TString)"Random seed must be >= 0",(glob->GetOptI("splitSeed") >= 0));
+  // random number generator for the (splitType == "random") option, which is reseeded for each object (see
+  // getSplitIndex()). a zero seed is replaced by a random one, which is then common to all objects
+  int splitSeed = glob->GetOptI("splitSeed");
+  VERIFY(LOCATION,(TString)"Random seed must be >= 0",(splitSeed >= 0));
+
+  if(splitSeed == 0) { TRandom3 rndSeed(0); splitSeed = 1 + static_cast<int>(rndSeed.Integer(kMaxInt - 1)); }
+  TRandom * rnd = new TRandom(splitSeed);
 
   bool              isRootInput(false);
   int               nInFiles(0), inFileTypeChange(0);
@@ -370,7 +385,7 @@ void CatFormat::inputToSplitTree(TString inAsciiFiles, TString inAsciiVars) {
 
       isRootInput = inFileNameV[0].EndsWith(".root");
       if(!isRootInput) {
-        utils->getNlinesAsciiFile(inFileNameV_now,true); // make sure the files are not all empty
+        getNinputLines(inFileNameV_now,true); // make sure the files are not all empty
       }
       
       inFileNameV_now.clear();
@@ -421,7 +436,7 @@ void CatFormat::inputToSplitTree(TString inAsciiFiles, TString inAsciiVars) {
       }
     }
     else {
-      nLinesTot = utils->getNlinesAsciiFile(inFileNameV,true);
+      nLinesTot = getNinputLines(inFileNameV,true);
     }
     if(maxNobj > 0) nLinesTot = min(nLinesTot,maxNobj);
     
@@ -440,6 +455,10 @@ void CatFormat::inputToSplitTree(TString inAsciiFiles, TString inAsciiVars) {
   // -----------------------------------------------------------------------------------------------------------
   parseInputVars(var,inAsciiVars,inVarNames,inVarTypes);
 
+  // resolve the input variables once, to avoid name lookups for each input line
+  vector <VarMaps::VarHandle> inVarHdls;
+  var->GetVarHandles(inVarNames,inVarHdls);
+
   // create the output tree(s) now thah all the variables are defined
   // -----------------------------------------------------------------------------------------------------------
   vector <TTree *> treeOut  (nSplit); 
@@ -473,175 +492,190 @@ void CatFormat::inputToSplitTree(TString inAsciiFiles, TString inAsciiVars) {
                                          "Allowed values are: \"serial\",\"blocks\",\"random\",\"byInFiles\"",false);
   }
   intMap["nSplitType"] = nSplitType;
+  intMap["splitSeed"]  = splitSeed;
 
-  // -----------------------------------------------------------------------------------------------------------
-  // loop on all the input files
-  // -----------------------------------------------------------------------------------------------------------
-  for(int nInFileNow=0; nInFileNow<nInFiles; nInFileNow++) {
-    TString  inFileNameNow   = inFileNameV[nInFileNow];
-    unsigned posSlash        = ((std::string)inFileNameNow).find_last_of("/");
-    TString  reducedFileName = (TString)(((std::string)inFileNameNow).substr(posSlash+1));
-
-    // optional parameter to mark if an object is of type signal (1), background (0) or undefined (-1), based on the name of the input file
-    int sigBckInp(-1);
-    if(addSigBckInp) {
-      int nSigBckFound(0);
-
-      if(find(inpFiles_bckV.begin(),inpFiles_bckV.end(),reducedFileName) != inpFiles_bckV.end()) { nSigBckFound++; sigBckInp = 0; }
-      if(find(inpFiles_sigV.begin(),inpFiles_sigV.end(),reducedFileName) != inpFiles_sigV.end()) { nSigBckFound++; sigBckInp = 1; }
-
-      if(nSigBckFound == 0) {
-        aLOG(Log::WARNING)<<coutBlue<<" - Skipping "<<coutRed<<inFileNameNow<<coutBlue
-                          <<" \"inpFiles_bck\" and \"inpFiles_sig\" are defined, but do not include it ... "<<coutDef<<endl;
-        continue;
-      }
-      else if(nSigBckFound == 1) {
-        aLOG(Log::INFO)<<coutBlue<<" - Will add \"sigBckInpName\" = "<<coutYellow<<sigBckInp<<" ("<<(TString)((sigBckInp == 0)?"background":"signal")
-                       <<")"<<coutBlue<<" for all objects from "<<coutGreen<<reducedFileName<<coutDef<<endl;
-      }
-      else {
-        VERIFY(LOCATION,(TString)"Input file \""+reducedFileName+"\" found in both \"inpFiles_bck\" and \"inpFiles_sig\".",false);
-      }
-    }
-
-    // skip input files with no content
-    if(!isRootInput) {
-      if(utils->getNlinesAsciiFile(inFileNameNow,false) == 0) {
-        aLOG(Log::WARNING)<<coutBlue<<" - Skipping "<<coutRed<<inFileNameNow<<coutBlue<<" (no content in file) ... "<<coutDef<<endl;
-        continue;
-      }
-    }
-
-    // write out trees and initialize counters if moving from one type to another (e.g., from train to test)
-    // switch to the correct inTreeNameNow if seperate tree names are specified for train/test
-    TString inTreeNameNow(inTreeName);
-    if(nSplitType == 3) {
-      int nSplitNow = inFileTypeV[nInFileNow];
-
-      if     (nSplitNow == 0 && inTreeNameTrain != "") inTreeNameNow = inTreeNameTrain;
-      else if(nSplitNow == 1 && inTreeNameTest  != "") inTreeNameNow = inTreeNameTest;
-      else                                             inTreeNameNow = inTreeName;
-
-      intMap["inFileSplitIndex"] = nSplitNow;
-
-      if(inFileTypeChange != inFileTypeV[nInFileNow]) {
-        inFileTypeChange = inFileTypeV[nInFileNow];
-
-        var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
-        
-        var->NewCntr("nObj",0);
-        breakLoop = mayWriteObjects = false;
-      }
-    }
-
-    aLOG(Log::INFO)<<coutGreen<<" - Now reading-in "<<coutYellow<<inFileNameNow<<coutGreen<<" ... "<<coutDef<<endl;
+  // ascii and binary inputs are divided into chunks, which are converted in parallel (root inputs are
+  // always converted by a single thread)
+  int nThreads = isRootInput ? 1 : ThreadPool::getNumThreads(glob->GetOptI("nThreads"));
 
+  if(nThreads > 1) {
+    inputToSplitTreeChunks(inFileNameV,inFileTypeV,inpFiles_sigV,inpFiles_bckV,inAsciiVars,treeNames,intMap,nThreads);
+  }
+  else {
     // -----------------------------------------------------------------------------------------------------------
-    // the loop
+    // loop on all the input files
     // -----------------------------------------------------------------------------------------------------------
-    var->NewCntr("nLineFile",0);
-
-    if(isRootInput) {
-      TChain  * inChain = new TChain(inTreeNameNow,inTreeNameNow); inChain->SetDirectory(0); inChain->Add(inFileNameNow);
-      aLOG(Log::DEBUG) <<coutRed<<" - added chain "<<coutGreen<<inTreeNameNow<<"("<<inChain->GetEntries()<<")"<<" from "<<coutBlue<<inFileNameNow<<coutDef<<endl;
-
-      VarMaps * var_0   = new VarMaps(glob,utils,(TString)"inputTree_"+inTreeNameNow);
-      var_0->connectTreeBranches(inChain);
-
-      // get the full list of variables common to both var and var_0
-      vector < pair<TString,TString> > varTypeNameV;
-      var->varStruct(var_0,NULL,NULL,&varTypeNameV,false);
+    for(int nInFileNow=0; nInFileNow<nInFiles; nInFileNow++) {
+      TString  inFileNameNow   = inFileNameV[nInFileNow];
+      unsigned posSlash        = ((std::string)inFileNameNow).find_last_of("/");
+      TString  reducedFileName = (TString)(((std::string)inFileNameNow).substr(posSlash+1));
 
-      bool breakLoopTree(false);
-      for(Long64_t loopEntry=0; true; loopEntry++) {
-        if(!var_0->getTreeEntry(loopEntry)) breakLoopTree = true;
+      // optional parameter to mark if an object is of type signal (1), background (0) or undefined (-1), based on the name of the input file
+      int sigBckInp(-1);
+      if(!getInputSigBck(inFileNameNow,inpFiles_sigV,inpFiles_bckV,sigBckInp)) continue;
 
-        if((mayWriteObjects && var->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop || breakLoopTree) {
-          mayWriteObjects = false;
-          var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); 
+      // skip input files with no content
+      if(!isRootInput) {
+        if(getNinputLines(inFileNameNow,false) == 0) {
+          aLOG(Log::WARNING)<<coutBlue<<" - Skipping "<<coutRed<<inFileNameNow<<coutBlue<<" (no content in file) ... "<<coutDef<<endl;
+          continue;
         }
-        if(breakLoop || breakLoopTree) break;
+      }
 
-        if(var->GetCntr("nLine") % nObjectsToPrint == 0) {
-          aLOG(Log::DEBUG) <<coutGreen<<" - "<<coutBlue<<glob->GetOptC("outDirName")<<coutGreen<<" - "<<coutBlue<<glob->GetOptC("baseName")<<coutGreen<<" - "
-          <<coutGreen<<" Objects in current file = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nLineFile"))
-          <<coutRed<<" Total = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nObj"))<<coutDef<<endl;
-        }
+      // write out trees and initialize counters if moving from one type to another (e.g., from train to test)
+      // switch to the correct inTreeNameNow if seperate tree names are specified for train/test
+      TString inTreeNameNow(inTreeName);
+      if(nSplitType == 3) {
+        int nSplitNow = inFileTypeV[nInFileNow];
 
-        var->copyVarData(var_0,&varTypeNameV);
+        if     (nSplitNow == 0 && inTreeNameTrain != "") inTreeNameNow = inTreeNameTrain;
+        else if(nSplitNow == 1 && inTreeNameTest  != "") inTreeNameNow = inTreeNameTest;
+        else                                             inTreeNameNow = inTreeName;
 
-        // update variable with input file name
-        if(storeOrigFileName) var->SetVarC(origFileName,reducedFileName);
-        // sig/bck tag based on the name of the input file
-        if(addSigBckInp) var->SetVarI(sigBckInpName, sigBckInp);
-        // update the placeholder to KNN weights
-        var->SetVarF(weightName,1);
-
-        // set the indexing variables, and get the corresponding intMap["nSplitTree"]
-        setSplitVars(var,rnd,intMap);
+        intMap["inFileSplitIndex"] = nSplitNow;
 
-        // fill the tree with the current variables
-        treeOut[intMap["nSplitTree"]]->Fill();
+        if(inFileTypeChange != inFileTypeV[nInFileNow]) {
+          inFileTypeChange = inFileTypeV[nInFileNow];
 
-        if(inLOG(Log::DEBUG_3)) {
-          int nPrintRow(4), width(14);
-          cout <<coutYellow<<"Line # "<<var->GetCntr("nObj")<<endl<<coutYellow<<std::setw(100)<<std::setfill('.')<<" "<<std::setfill(' ')<<coutDef;
-          var->printVars(nPrintRow,width);
+          var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
+          
+          var->NewCntr("nObj",0);
+          breakLoop = mayWriteObjects = false;
         }
-        
-        // update counters
-        var->IncCntr("nObj"); var->IncCntr("nLineFile"); mayWriteObjects = true; if(var->GetCntr("nObj") == maxNobj) breakLoop = true;
       }
 
-      DELNULL(var_0); DELNULL(inChain); varTypeNameV.clear();
-    }
-    else {
-      std::ifstream inputFile(inFileNameNow,std::ios::in);
-      std::string   line;
+      aLOG(Log::INFO)<<coutGreen<<" - Now reading-in "<<coutYellow<<inFileNameNow<<coutGreen<<" ... "<<coutDef<<endl;
 
-      while(!inputFile.eof()) {
-        // get an object
-        // -----------------------------------------------------------------------------------------------------------
-        getline(inputFile, line);  if(!inputLineToVars((TString)line,var,inVarNames,inVarTypes)) continue;
-
-        if((mayWriteObjects && var->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
-          mayWriteObjects = false;
-          var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); 
+      // -----------------------------------------------------------------------------------------------------------
+      // the loop
+      // -----------------------------------------------------------------------------------------------------------
+      var->NewCntr("nLineFile",0);
+
+      if(isRootInput) {
+        TChain  * inChain = new TChain(inTreeNameNow,inTreeNameNow); inChain->SetDirectory(0); inChain->Add(inFileNameNow);
+        aLOG(Log::DEBUG) <<coutRed<<" - added chain "<<coutGreen<<inTreeNameNow<<"("<<inChain->GetEntries()<<")"<<" from "<<coutBlue<<inFileNameNow<<coutDef<<endl;
+
+        VarMaps * var_0   = new VarMaps(glob,utils,(TString)"inputTree_"+inTreeNameNow);
+        var_0->connectTreeBranches(inChain);
+
+        // get the full list of variables common to both var and var_0
+        vector < pair<TString,TString> > varTypeNameV;
+        var->varStruct(var_0,NULL,NULL,&varTypeNameV,false);
+
+        bool breakLoopTree(false);
+        for(Long64_t loopEntry=0; true; loopEntry++) {
+          if(!var_0->getTreeEntry(loopEntry)) breakLoopTree = true;
+
+          if((mayWriteObjects && var->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop || breakLoopTree) {
+            mayWriteObjects = false;
+            var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); 
+          }
+          if(breakLoop || breakLoopTree) break;
+
+          if(var->GetCntr("nLine") % nObjectsToPrint == 0) {
+            aLOG(Log::DEBUG) <<coutGreen<<" - "<<coutBlue<<glob->GetOptC("outDirName")<<coutGreen<<" - "<<coutBlue<<glob->GetOptC("baseName")<<coutGreen<<" - "
+            <<coutGreen<<" Objects in current file = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nLineFile"))
+            <<coutRed<<" Total = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nObj"))<<coutDef<<endl;
+          }
+
+          var->copyVarData(var_0,&varTypeNameV);
+
+          // update variable with input file name
+          if(storeOrigFileName) var->SetVarC(origFileName,reducedFileName);
+          // sig/bck tag based on the name of the input file
+          if(addSigBckInp) var->SetVarI(sigBckInpName, sigBckInp);
+          // update the placeholder to KNN weights
+          var->SetVarF(weightName,1);
+
+          // set the indexing variables, and get the corresponding intMap["nSplitTree"]
+          setSplitVars(var,rnd,intMap);
+
+          // fill the tree with the current variables
+          treeOut[intMap["nSplitTree"]]->Fill();
+
+          if(inLOG(Log::DEBUG_3)) {
+            int nPrintRow(4), width(14);
+            cout <<coutYellow<<"Line # "<<var->GetCntr("nObj")<<endl<<coutYellow<<std::setw(100)<<std::setfill('.')<<" "<<std::setfill(' ')<<coutDef;
+            var->printVars(nPrintRow,width);
+          }
+          
+          // update counters
+          var->IncCntr("nObj"); var->IncCntr("nLineFile"); mayWriteObjects = true; if(var->GetCntr("nObj") == maxNobj) breakLoop = true;
         }
-        if(breakLoop) break;
 
-        if(var->GetCntr("nLine") % nObjectsToPrint == 0) {
-          aLOG(Log::DEBUG) <<coutGreen<<" - "<<coutBlue<<glob->GetOptC("outDirName")<<coutGreen<<" - "<<coutBlue<<glob->GetOptC("baseName")<<coutGreen<<" - "
-          <<coutGreen<<" Objects in current file = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nLineFile"))
-          <<coutRed<<" Total = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nObj"))<<coutDef<<endl;
+        DELNULL(var_0); DELNULL(inChain); varTypeNameV.clear();
+      }
+      else {
+        // ascii inputs are either read line by line, or (for fastInput or for binary inputs) using a memory-mapped InputFileReader
+        bool            useReader = (useFastInput || InputFileReader::getFileType(inFileNameNow) != InputFileReader::ASCII);
+        InputFileReader inReader;
+        std::ifstream   inputFile;
+        std::string     line;
+        TStopwatch      readTimer;
+
+        if(useReader) {
+          TString failMsg("");
+          VERIFY(LOCATION,(TString)"Could not read input file ("+inFileNameNow+"): "+failMsg,inReader.open(inFileNameNow,failMsg));
         }
-
-        // update variable with input file name
-        if(storeOrigFileName) var->SetVarC(origFileName,reducedFileName);
-        // sig/bck tag based on the name of the input file
-        if(addSigBckInp) var->SetVarI(sigBckInpName, sigBckInp);
-        // update the placeholder to KNN weights
-        var->SetVarF(weightName,1);
-
-        // set the indexing variables, and get the corresponding intMap["nSplitTree"]
-        setSplitVars(var,rnd,intMap);
-
-        // fill the tree with the current variables
-        treeOut[intMap["nSplitTree"]]->Fill();
-
-        if(inLOG(Log::DEBUG_3)) {
-          int nPrintRow(4), width(14);
-          cout <<coutYellow<<"Line # "<<var->GetCntr("nObj")<<endl<<coutYellow<<std::setw(100)<<std::setfill('.')<<" "<<std::setfill(' ')<<coutDef;
-          var->printVars(nPrintRow,width);
+        else inputFile.open(inFileNameNow,std::ios::in);
+
+        while(true) {
+          // get an object
+          // -----------------------------------------------------------------------------------------------------------
+          if(useReader) {
+            if(!inReader.nextRow()) break;
+            inputRowToVars(&inReader,var,inVarNames,inVarTypes,inVarHdls);
+          }
+          else {
+            if(inputFile.eof()) break;
+            getline(inputFile, line);  if(!inputLineToVars((TString)line,var,inVarNames,inVarTypes,&inVarHdls)) continue;
+          }
+
+          if((mayWriteObjects && var->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
+            mayWriteObjects = false;
+            var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); 
+          }
+          if(breakLoop) break;
+
+          if(var->GetCntr("nLine") % nObjectsToPrint == 0) {
+            aLOG(Log::DEBUG) <<coutGreen<<" - "<<coutBlue<<glob->GetOptC("outDirName")<<coutGreen<<" - "<<coutBlue<<glob->GetOptC("baseName")<<coutGreen<<" - "
+            <<coutGreen<<" Objects in current file = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nLineFile"))
+            <<coutRed<<" Total = "<<coutYellow<<TString::Format("%3.3g \t",(double)var->GetCntr("nObj"))<<coutDef<<endl;
+          }
+
+          // update variable with input file name
+          if(storeOrigFileName) var->SetVarC(origFileName,reducedFileName);
+          // sig/bck tag based on the name of the input file
+          if(addSigBckInp) var->SetVarI(sigBckInpName, sigBckInp);
+          // update the placeholder to KNN weights
+          var->SetVarF(weightName,1);
+
+          // set the indexing variables, and get the corresponding intMap["nSplitTree"]
+          setSplitVars(var,rnd,intMap);
+
+          // fill the tree with the current variables
+          treeOut[intMap["nSplitTree"]]->Fill();
+
+          if(inLOG(Log::DEBUG_3)) {
+            int nPrintRow(4), width(14);
+            cout <<coutYellow<<"Line # "<<var->GetCntr("nObj")<<endl<<coutYellow<<std::setw(100)<<std::setfill('.')<<" "<<std::setfill(' ')<<coutDef;
+            var->printVars(nPrintRow,width);
+          }
+          
+          // update counters
+          var->IncCntr("nObj"); var->IncCntr("nLineFile"); mayWriteObjects = true; if(var->GetCntr("nObj") == maxNobj) breakLoop = true;
         }
-        
-        // update counters
-        var->IncCntr("nObj"); var->IncCntr("nLineFile"); mayWriteObjects = true; if(var->GetCntr("nObj") == maxNobj) breakLoop = true;
+
+        readTimer.Stop();
+        double readTime = readTimer.RealTime(), nObjRead = var->GetCntr("nLineFile");
+        aLOG(Log::INFO) <<coutGreen<<" - Read "<<coutYellow<<nObjRead<<coutGreen<<" objects in "<<coutYellow<<TString::Format("%3.3g",readTime)
+                        <<coutGreen<<" sec ("<<coutYellow<<TString::Format("%3.3g",(readTime > 0) ? nObjRead/readTime : 0.)
+                        <<coutGreen<<" objects/sec, "<<coutPurple<<(TString)(useReader ? "memory-mapped" : "line by line")<<coutGreen<<") ..."<<coutDef<<endl;
       }
-    }
 
+    }
+    if(!breakLoop) { var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
   }
-  if(!breakLoop) { var->printCntr(treeName,Log::INFO); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
 
   // -----------------------------------------------------------------------------------------------------------
   // some histograms of the input branches
@@ -736,6 +770,305 @@ void CatFormat::inputToSplitTree(TString inAsciiFiles, TString inAsciiVars) {
 }
 
 
+// ===========================================================================================================
+/**
+ * @brief                - Convert ascii or binary input files into split trees (see inputToSplitTree()),
+ *                       using multiple threads.
+ *
+ * @details              - The input files are divided into chunks of rows (see InputFileReader::getRangeBounds()),
+ *                       which are converted independently, where each thread takes the next available chunk.
+ *                       The conversion is done in three stages:
+ *                         - the rows of each chunk are counted, and the maxNobj limit is applied to the chunks
+ *                         in their original order. The first line number of each chunk is then given by the
+ *                         cumulative number of rows of the preceding chunks.
+ *                         - the number of training and testing objects of each chunk is derived using
+ *                         getSplitIndex(), which gives the first index of each sub-sample in each chunk.
+ *                         - the chunks are converted, where each chunk is written to its own output files,
+ *                         tagged by the index of the chunk (see OutMngr::treeFileTag).
+ *                       The content of the output trees (including the order of objects within the chained
+ *                       output files) therefore does not depend on the number of threads.
+ *
+ * @param inFileNameV    - The list of input files (including the path)
+ * @param inFileTypeV    - The sub-sample of each input file, for the "byInFiles" split
+ * @param inpFiles_sigV  - The list of signal input files (may be empty)
+ * @param inpFiles_bckV  - The list of background input files (may be empty)
+ * @param inAsciiVars    - semicolon-separated list of input parameter names, corresponding to columns in the input files
+ * @param treeNames      - The names of the output trees
+ * @param intMap         - input options (see setSplitVars())
+ * @param nThreads       - The number of threads
+ */
+// ===========================================================================================================
+void CatFormat::inputToSplitTreeChunks(vector <TString> & inFileNameV, vector <int> & inFileTypeV, vector <TString> & inpFiles_sigV,
+                                       vector <TString> & inpFiles_bckV, TString inAsciiVars, vector <TString> & treeNames,
+                                       map <TString,int> & intMap, int nThreads) {
+// ===================================================================================================================================
+  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - starting CatFormat::inputToSplitTreeChunks() ... "<<coutDef<<endl;
+
+  int     maxNobj           = glob->GetOptI("maxNobj");
+  int     nSplit            = glob->GetOptI("nSplit");
+  TString indexName         = glob->GetOptC("indexName");
+  TString weightName        = glob->GetOptC("baseName_wgtKNN");
+  TString origFileName      = glob->GetOptC("origFileName");
+  bool    storeOrigFileName = glob->GetOptB("storeOrigFileName");
+  TString sigBckInpName     = glob->GetOptC("sigBckInpName");
+  bool    addSigBckInp      = (inpFiles_sigV.size() > 0 || inpFiles_bckV.size() > 0);
+  int     nSplitType        = intMap["nSplitType"];
+  int     nInFiles          = (int)inFileNameV.size();
+
+  // the number of chunks per thread (for load-balancing) and the minimal size of a chunk in bytes
+  int      nChunksPerThread = 4;
+  Long64_t minChunkBytes    = 1 << 20;
+
+  TStopwatch convTimer;
+
+  // -----------------------------------------------------------------------------------------------------------
+  // divide the input files into chunks
+  // -----------------------------------------------------------------------------------------------------------
+  vector <InputChunk> chunkV;
+
+  for(int nInFileNow=0; nInFileNow<nInFiles; nInFileNow++) {
+    TString inFileNameNow = inFileNameV[nInFileNow];
+
+    int sigBckInp(-1);
+    if(!getInputSigBck(inFileNameNow,inpFiles_sigV,inpFiles_bckV,sigBckInp)) continue;
+
+    if(getNinputLines(inFileNameNow,false) == 0) {
+      aLOG(Log::WARNING)<<coutBlue<<" - Skipping "<<coutRed<<inFileNameNow<<coutBlue<<" (no content in file) ... "<<coutDef<<endl;
+      continue;
+    }
+
+    InputFileReader inReader;
+    TString         failMsg("");
+    VERIFY(LOCATION,(TString)"Could not read input file ("+inFileNameNow+"): "+failMsg,inReader.open(inFileNameNow,failMsg));
+
+    Long64_t nRangesFile = min((Long64_t)(nThreads * nChunksPerThread),inReader.getNbytes() / minChunkBytes);
+    vector <Long64_t> boundV;
+    inReader.getRangeBounds(static_cast<int>(max(nRangesFile,(Long64_t)1)),boundV);
+
+    for(int nRangeNow=0; nRangeNow<(int)boundV.size()-1; nRangeNow++) {
+      InputChunk chunk;
+      chunk.nChunk     = (int)chunkV.size();
+      chunk.nInFile    = nInFileNow;
+      chunk.inFileType = (nSplitType == 3) ? inFileTypeV[nInFileNow] : 0;
+      chunk.sigBckInp  = sigBckInp;
+      chunk.rangeBegin = boundV[nRangeNow];
+      chunk.rangeEnd   = boundV[nRangeNow+1];
+
+      chunkV.push_back(chunk);
+    }
+    inReader.close(); boundV.clear();
+  }
+
+  int nChunks     = (int)chunkV.size();
+  int nThreadsNow = max(min(nThreads,nChunks),1);
+
+  aLOG(Log::INFO) <<coutBlue<<" - will convert "<<coutYellow<<nChunks<<coutBlue<<" input chunks using "
+                  <<coutYellow<<nThreadsNow<<coutBlue<<" threads ..."<<coutDef<<endl;
+
+  ThreadPool * threadPool = new ThreadPool(nThreadsNow);
+
+  // -----------------------------------------------------------------------------------------------------------
+  // count the rows of each chunk, and derive the number of rows to use from each chunk and the line number
+  // of the first row of each chunk. the maxNobj limit is applied to each sub-sample separately for the
+  // "byInFiles" split, and to all objects otherwise (as in the single-thread loop of inputToSplitTree())
+  // -----------------------------------------------------------------------------------------------------------
+  for(int nChunkNow=0; nChunkNow<nChunks; nChunkNow++) {
+    InputChunk * chunk = &(chunkV[nChunkNow]);
+    TString inFileNameNow = inFileNameV[chunk->nInFile];
+
+    threadPool->push([chunk,inFileNameNow]() {
+      InputFileReader inReader;
+      TString         failMsg("");
+      VERIFY(LOCATION,(TString)"Could not read input file ("+inFileNameNow+"): "+failMsg,inReader.open(inFileNameNow,failMsg));
+
+      inReader.setRange(chunk->rangeBegin,chunk->rangeEnd);
+      chunk->nRows = inReader.countRows();
+      inReader.close();
+    });
+  }
+  threadPool->wait();
+
+  map <int,Long64_t> nObjSplit;
+  Long64_t           nLineNow(0);
+  for(int nChunkNow=0; nChunkNow<nChunks; nChunkNow++) {
+    InputChunk & chunk = chunkV[nChunkNow];
+    
+    Long64_t nObjLeft = (maxNobj > 0) ? max(maxNobj - nObjSplit[chunk.inFileType],(Long64_t)0) : chunk.nRows;
+
+    chunk.nRowsUse    = min(chunk.nRows,nObjLeft);
+    chunk.nLineBegin  = nLineNow;
+
+    nObjSplit[chunk.inFileType] += chunk.nRowsUse;
+    nLineNow                    += chunk.nRowsUse;
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // count the number of objects in each sub-sample of each chunk, and derive the first index of each sub-sample
+  // -----------------------------------------------------------------------------------------------------------
+  if(nSplit == 2) {
+    for(int nChunkNow=0; nChunkNow<nChunks; nChunkNow++) {
+      InputChunk * chunk = &(chunkV[nChunkNow]);
+
+      threadPool->push([this,chunk,intMap]() mutable {
+        TRandom rnd(intMap["splitSeed"]);
+        intMap["inFileSplitIndex"] = chunk->inFileType;
+
+        for(Long64_t nLine=chunk->nLineBegin; nLine<chunk->nLineBegin+chunk->nRowsUse; nLine++) {
+          if(getSplitIndex(static_cast<int>(nLine),&rnd,intMap) == 0) chunk->nTrain++;
+          else                                                         chunk->nTest++;
+        }
+      });
+    }
+    threadPool->wait();
+  }
+
+  Long64_t nTrainNow(0), nTestNow(0);
+  for(int nChunkNow=0; nChunkNow<nChunks; nChunkNow++) {
+    chunkV[nChunkNow].nTrainBegin = nTrainNow; nTrainNow += chunkV[nChunkNow].nTrain;
+    chunkV[nChunkNow].nTestBegin  = nTestNow;  nTestNow  += chunkV[nChunkNow].nTest;
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // setup the containers of each thread - each thread has its own vars, output trees and output manager
+  // -----------------------------------------------------------------------------------------------------------
+  vector <InputSplitThread*> inputSplitThreadV(nThreadsNow,NULL);
+  for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+    Utils   * utilsNow   = new Utils(glob);
+    OutMngr * outputsNow = new OutMngr((TString)"outputs_"+utils->intToStr(nThreadNow),utilsNow,glob);
+
+    outputsNow->SetOutDirName(outputs->GetOutDirName());
+    outputsNow->OutputRootFileIndex = outputsNow->OutputTreeFileIndex = -1;
+
+    InputSplitThread * thr = new InputSplitThread((TString)"inputSplitThread_"+utils->intToStr(nThreadNow),utilsNow,glob,outputsNow);
+    inputSplitThreadV[nThreadNow] = thr;
+
+    thr->var = new VarMaps(glob,utilsNow,(TString)"treeVars_"+utils->intToStr(nThreadNow));
+    thr->var->NewVarI(indexName); thr->var->NewVarF(weightName);
+    if(storeOrigFileName) thr->var->NewVarC(origFileName);
+    if(addSigBckInp)      thr->var->NewVarI(sigBckInpName);
+
+    parseInputVars(thr->var,inAsciiVars,thr->inVarNames,thr->inVarTypes);
+    thr->var->GetVarHandles(thr->inVarNames,thr->inVarHdls);
+
+    thr->var->NewCntr("nLine",0); thr->var->NewCntr("nTrain",0); thr->var->NewCntr("nTest",0);
+
+    thr->treeOut.resize(nSplit,NULL);
+    for(int nTreeNow=0; nTreeNow<nSplit; nTreeNow++) {
+      TString treeNameNow    = treeNames[nTreeNow];
+      thr->treeOut[nTreeNow] = new TTree(treeNameNow,treeNameNow);
+      thr->treeOut[nTreeNow]->SetDirectory(0); outputsNow->TreeMap[treeNameNow] = thr->treeOut[nTreeNow];
+
+      thr->var->createTreeBranches(thr->treeOut[nTreeNow]);
+    }
+
+    thr->rnd    = new TRandom(intMap["splitSeed"]);
+    thr->intMap = intMap;
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // convert the chunks, where each thread takes the next available chunk
+  // -----------------------------------------------------------------------------------------------------------
+  std::atomic<int> nChunkNext(0);
+
+  for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) {
+    InputSplitThread * thr = inputSplitThreadV[nThreadNow];
+
+    threadPool->push([this,thr,&chunkV,&inFileNameV,&nChunkNext,nChunks]() {
+      for(int nChunkNow=nChunkNext++; nChunkNow<nChunks; nChunkNow=nChunkNext++) {
+        inputChunkToSplitTree(thr,chunkV[nChunkNow],inFileNameV[chunkV[nChunkNow].nInFile]);
+      }
+    });
+  }
+  threadPool->wait();
+  DELNULL(threadPool);
+
+  Long64_t nObjTot(0);
+  for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) nObjTot += inputSplitThreadV[nThreadNow]->nObj;
+
+  convTimer.Stop();
+  double convTime = convTimer.RealTime();
+  aLOG(Log::INFO) <<coutGreen<<" - Converted "<<coutYellow<<nObjTot<<coutGreen<<" objects ("<<coutYellow<<nTrainNow<<coutGreen<<" / "
+                  <<coutYellow<<nTestNow<<coutGreen<<" in the two sub-samples) in "<<coutYellow<<TString::Format("%3.3g",convTime)
+                  <<coutGreen<<" sec ("<<coutYellow<<TString::Format("%3.3g",(convTime > 0) ? nObjTot/convTime : 0.)
+                  <<coutGreen<<" objects/sec) ..."<<coutDef<<endl;
+
+  // cleanup
+  for(int nThreadNow=0; nThreadNow<nThreadsNow; nThreadNow++) DELNULL(inputSplitThreadV[nThreadNow]);
+  inputSplitThreadV.clear(); chunkV.clear(); nObjSplit.clear();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief              - Convert one chunk of an input file within one thread of inputToSplitTreeChunks().
+ *
+ * @param thr          - The containers of the current thread
+ * @param chunk        - The chunk to convert
+ * @param inFileName   - The name of the input file of the chunk
+ */
+// ===========================================================================================================
+void CatFormat::inputChunkToSplitTree(InputSplitThread * thr, InputChunk & chunk, TString inFileName) {
+// ====================================================================================================
+  if(chunk.nRowsUse == 0) return;
+
+  int     nObjectsToWrite   = glob->GetOptI("nObjectsToWrite");
+  TString weightName        = glob->GetOptC("baseName_wgtKNN");
+  TString origFileName      = glob->GetOptC("origFileName");
+  bool    storeOrigFileName = glob->GetOptB("storeOrigFileName");
+  TString sigBckInpName     = glob->GetOptC("sigBckInpName");
+
+  unsigned posSlash        = ((std::string)inFileName).find_last_of("/");
+  TString  reducedFileName = (TString)(((std::string)inFileName).substr(posSlash+1));
+
+  VarMaps * var = thr->var;
+
+  InputFileReader inReader;
+  TString         failMsg("");
+  VERIFY(LOCATION,(TString)"Could not read input file ("+inFileName+"): "+failMsg,inReader.open(inFileName,failMsg));
+  inReader.setRange(chunk.rangeBegin,chunk.rangeEnd);
+
+  // each chunk is written to its own output files, and the counters are set to the values at the beginning of the chunk
+  thr->outputs->treeFileTag         = TString::Format("_c%05d",chunk.nChunk);
+  thr->outputs->OutputTreeFileIndex = -1;
+
+  var->NewCntr("nLine" ,static_cast<int>(chunk.nLineBegin));
+  var->NewCntr("nTrain",static_cast<int>(chunk.nTrainBegin));
+  var->NewCntr("nTest" ,static_cast<int>(chunk.nTestBegin));
+
+  thr->intMap["inFileSplitIndex"] = chunk.inFileType;
+
+  for(Long64_t nRowNow=0; nRowNow<chunk.nRowsUse; nRowNow++) {
+    VERIFY(LOCATION,(TString)"Unexpected end of input chunk in file ("+inFileName+") ...",inReader.nextRow());
+
+    inputRowToVars(&inReader,var,thr->inVarNames,thr->inVarTypes,thr->inVarHdls);
+
+    // update variable with input file name
+    if(storeOrigFileName)    var->SetVarC(origFileName,reducedFileName);
+    // sig/bck tag based on the name of the input file
+    if(chunk.sigBckInp >= 0) var->SetVarI(sigBckInpName,chunk.sigBckInp);
+    // update the placeholder to KNN weights
+    var->SetVarF(weightName,1);
+
+    // set the indexing variables, and get the corresponding intMap["nSplitTree"]
+    setSplitVars(var,thr->rnd,thr->intMap);
+
+    // fill the tree with the current variables
+    thr->treeOut[thr->intMap["nSplitTree"]]->Fill();
+
+    if((nRowNow+1) % nObjectsToWrite == 0) { thr->outputs->WriteOutObjects(false,true); thr->outputs->ResetObjects(); }
+  }
+  thr->outputs->WriteOutObjects(false,true); thr->outputs->ResetObjects();
+
+  thr->nObj += chunk.nRowsUse;
+  inReader.close();
+
+  aLOG(Log::DEBUG) <<coutPurple<<" - "<<thr->name<<" converted "<<coutGreen<<chunk.nRowsUse<<coutPurple<<" objects of chunk "
+                   <<coutGreen<<chunk.nChunk<<coutPurple<<" from "<<coutBlue<<reducedFileName<<coutDef<<endl;
+
+  return;
+}
+
 // ===========================================================================================================
 /**
  * @brief               - Parse the input variable list into pairs of variable names/types.
@@ -804,10 +1137,13 @@ void CatFormat::parseInputVars(VarMaps * var, TString inAsciiVars, vector <TStri
  * @param var          - The VarMaps() object in which the variables are filled
  * @param inVarNames   - vector which is contains the list of input parameter names
  * @param inVarTypes   - vector which is contains the list of input parameter types
+ * @param inVarHdls    - (optional) vector of handles of the input parameters in var (see VarMaps::GetVarHandles()),
+ *                     which are used instead of name lookups if given
  */
 // ===========================================================================================================
-bool CatFormat::inputLineToVars(TString line, VarMaps * var, vector <TString> & inVarNames, vector <TString> & inVarTypes) {
-// =========================================================================================================================
+bool CatFormat::inputLineToVars(TString line, VarMaps * var, vector <TString> & inVarNames, vector <TString> & inVarTypes,
+                                vector <VarMaps::VarHandle> * inVarHdls) {
+// =======================================================================================================================
   aLOG(Log::DEBUG_3) <<coutGreen<<" - CatFormat::inputLineToVars(): "<<coutYellow<<line<<coutDef<<endl;
 
   TString lineTest(line); lineTest.ReplaceAll(" ","");
@@ -835,6 +1171,7 @@ bool CatFormat::inputLineToVars(TString line, VarMaps * var, vector <TString> &
   // -----------------------------------------------------------------------------------------------------------
   // go over the variable list extracted from the line and fill the var
   // -----------------------------------------------------------------------------------------------------------
+  bool hasHdls = (inVarHdls && ((int)inVarHdls->size() == nVars));
   for(int nWordNow=0; nWordNow<nVars; nWordNow++) {
     TString wordNow = words[nWordNow];
     TString nameNow = inVarNames[nWordNow];
@@ -842,6 +1179,15 @@ bool CatFormat::inputLineToVars(TString line, VarMaps * var, vector <TString> &
 
     VERIFY(LOCATION,(TString)" - got empty input for "+nameNow+" of type "+typeNow+" from input-line = "+line,(wordNow != ""));
 
+    if(hasHdls) {
+      VarMaps::VarHandle & hdl = inVarHdls->at(nWordNow);
+      VarMaps::VarHandle::HandleType hdlType = hdl.getType();
+
+      if     (hdlType == VarMaps::VarHandle::kF  || hdlType == VarMaps::VarHandle::kD                                      ) { var->SetVarF(hdl,wordNow); continue; }
+      else if(hdlType == VarMaps::VarHandle::kS  || hdlType == VarMaps::VarHandle::kI  || hdlType == VarMaps::VarHandle::kL ) { var->SetVarI(hdl,wordNow); continue; }
+      else if(hdlType == VarMaps::VarHandle::kUS || hdlType == VarMaps::VarHandle::kUI || hdlType == VarMaps::VarHandle::kUL) { var->SetVarU(hdl,wordNow); continue; }
+    }
+
     if     (typeNow == "F"  || typeNow == "D"                    ) { var->SetVarF(nameNow,(TString)wordNow); }
     else if(typeNow == "S"  || typeNow == "I"  || typeNow == "L" ) { var->SetVarI(nameNow,(TString)wordNow); }
     else if(typeNow == "B"                                       ) { var->SetVarB(nameNow,(TString)wordNow); }
@@ -874,9 +1220,6 @@ bool CatFormat::inputLineToVars(TString line, VarMaps * var, vector <TString> &
 void CatFormat::setSplitVars(VarMaps * var, TRandom * rnd, map <TString,int> & intMap) {
 // =====================================================================================
   int     nSplit            = glob->GetOptI("nSplit");
-  int     nSplitType        = intMap["nSplitType"];
-  int     nLine_splitBlocks = (nSplitType == 1) ? intMap["nLine_splitBlocks"] : 0;
-  int     inFileSplitIndex  = (nSplitType == 3) ? intMap["inFileSplitIndex"]  : 0;
   TString indexName         = glob->GetOptC("indexName");
   // TString splitName         = glob->GetOptC("splitName");     // deprecated
   // TString testValidType     = glob->GetOptC("testValidType"); // deprecated
@@ -898,12 +1241,8 @@ void CatFormat::setSplitVars(VarMaps * var, TRandom * rnd, map <TString,int> & i
     // "serial" - 
     // -----------------------------------------------------------------------------------------------------------
     if(nSplit == 2) {
-      int resid2(0);
+      int resid2 = getSplitIndex(var->GetCntr("nLine"),rnd,intMap);
 
-      if     (nSplitType == 0) { resid2 = var->GetCntr("nLine") % 2;                           }// "serial" -
-      else if(nSplitType == 1) { resid2 = (var->GetCntr("nLine") < nLine_splitBlocks) ? 0 : 1; } // "blocks"
-      else if(nSplitType == 2) { resid2 = static_cast<int>(floor(rnd->Rndm() * 2));            } // "random"
-      else if(nSplitType == 3) { resid2 = inFileSplitIndex;                                    } // "byInFiles"
       // -----------------------------------------------------------------------------------------------------------
       // now set the variables
       // -----------------------------------------------------------------------------------------------------------
@@ -970,6 +1309,76 @@ void CatFormat::setSplitVars(VarMaps * var, TRandom * rnd, map <TString,int> & i
   return;
 }
 
+// ===========================================================================================================
+/**
+ * @brief          - The index of the sub-sample (0 for training and 1 for testing) of the object with a
+ *                 given line number, for a split into two sub-samples.
+ *
+ * @details        - For the "random" split, the random number generator is reseeded for each object, using a
+ *                 seed which only depends on the global seed and on the line number. The split therefore does
+ *                 not depend on the order in which objects are processed (see inputToSplitTreeChunks()).
+ * 
+ * @param nLine    - The line number of the object (counted over all input files)
+ * @param rnd      - a random number generator
+ * @param intMap   - input options
+ */
+// ===========================================================================================================
+int CatFormat::getSplitIndex(int nLine, TRandom * rnd, map <TString,int> & intMap) {
+// =================================================================================
+  int nSplitType = intMap["nSplitType"];
+
+  if     (nSplitType == 0) { return (nLine % 2);                                      } // "serial"
+  else if(nSplitType == 1) { return ((nLine < intMap["nLine_splitBlocks"]) ? 0 : 1); } // "blocks"
+  else if(nSplitType == 3) { return intMap["inFileSplitIndex"];                        } // "byInFiles"
+  else if(nSplitType == 2) {                                                            // "random"
+    rnd->SetSeed(utils->getSeedForIndex(static_cast<UInt_t>(intMap["splitSeed"]),static_cast<ULong64_t>(nLine)));
+    return static_cast<int>(floor(rnd->Rndm() * 2));
+  }
+
+  return 0;
+}
+
+// ===========================================================================================================
+/**
+ * @brief                - Derive the signal/background tag of an input file from its name, if either of the
+ *                       "inpFiles_sig" or "inpFiles_bck" options are set.
+ * 
+ * @param inFileName     - The name of the input file (including the path)
+ * @param inpFiles_sigV  - The list of signal input files (may be empty)
+ * @param inpFiles_bckV  - The list of background input files (may be empty)
+ * @param sigBckInp      - The derived tag - signal (1), background (0) or undefined (-1)
+ * 
+ * @return               - false if the file is not included in either list (and should therefore be skipped)
+ */
+// ===========================================================================================================
+bool CatFormat::getInputSigBck(TString inFileName, vector <TString> & inpFiles_sigV, vector <TString> & inpFiles_bckV, int & sigBckInp) {
+// =====================================================================================================================================
+  sigBckInp = -1;
+  if(inpFiles_sigV.size() == 0 && inpFiles_bckV.size() == 0) return true;
+
+  unsigned posSlash        = ((std::string)inFileName).find_last_of("/");
+  TString  reducedFileName = (TString)(((std::string)inFileName).substr(posSlash+1));
+  int      nSigBckFound(0);
+
+  if(find(inpFiles_bckV.begin(),inpFiles_bckV.end(),reducedFileName) != inpFiles_bckV.end()) { nSigBckFound++; sigBckInp = 0; }
+  if(find(inpFiles_sigV.begin(),inpFiles_sigV.end(),reducedFileName) != inpFiles_sigV.end()) { nSigBckFound++; sigBckInp = 1; }
+
+  if(nSigBckFound == 0) {
+    aLOG(Log::WARNING)<<coutBlue<<" - Skipping "<<coutRed<<inFileName<<coutBlue
+                      <<" \"inpFiles_bck\" and \"inpFiles_sig\" are defined, but do not include it ... "<<coutDef<<endl;
+    return false;
+  }
+  else if(nSigBckFound == 1) {
+    aLOG(Log::INFO)<<coutBlue<<" - Will add \"sigBckInpName\" = "<<coutYellow<<sigBckInp<<" ("<<(TString)((sigBckInp == 0)?"background":"signal")
+                   <<")"<<coutBlue<<" for all objects from "<<coutGreen<<reducedFileName<<coutDef<<endl;
+  }
+  else {
+    VERIFY(LOCATION,(TString)"Input file \""+reducedFileName+"\" found in both \"inpFiles_bck\" and \"inpFiles_sig\".",false);
+  }
+
+  return true;
+}
+
 // -----------------------------------------------------------------------------------------------------------
 // general way to read in a csv file and split each line into local ariables
 // -----------------------------------------------------------------------------------------------------------
@@ -0,0 +1,742 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+#include <cerrno>
+#include <cfloat>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// ===========================================================================================================
+// helper functions for the conversion of tokens of ascii input files into numbers
+// ===========================================================================================================
+namespace fastInputFuncs {
+  // maximal length of a token which is converted using a buffer on the stack
+  const int nMaxTokLen = 128;
+
+  // powers of ten which are exactly representable as float/double
+  const float  pow10F[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+  const double pow10D[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  inline bool isDigit(char c) { return (c >= '0' && c <= '9'); }
+
+  // ---------------------------------------------------------------------------------------------------------
+  // fast conversion of decimal numbers, of the form [+-]digits[.digits][(e|E)[+-]digits]. If the mantissa
+  // and the power of ten are both exactly representable in the target type, the result of a single
+  // multiplication/division is correctly rounded, and so is identical to that of strtof()/strtod().
+  // for any other input, false is returned, and the conversion is done by strToNumSlow() instead
+  // ---------------------------------------------------------------------------------------------------------
+  template <class T> inline bool strToFloatFast(const char * tok, int len, ULong64_t maxMant, int maxPow,
+                                                const T * pow10, T & val) {
+    // with extended precision for intermediate results (e.g., x87), the single operation may be rounded twice
+    if(FLT_EVAL_METHOD != 0) return false;
+
+    const char * pos(tok), * end(tok+len);
+    bool         isNeg(false), hasDigit(false);
+    int          nDigits(0), exp10(0);
+    ULong64_t    mant(0);
+
+    if(pos < end && (*pos == '+' || *pos == '-')) { isNeg = (*pos == '-'); pos++; }
+
+    for(; pos < end && isDigit(*pos); pos++) {
+      hasDigit = true;
+      if(nDigits > 0 || *pos != '0') { if(++nDigits > 19) return false; }
+      mant = mant*10 + (*pos - '0');
+    }
+    if(pos < end && *pos == '.') {
+      for(pos++; pos < end && isDigit(*pos); pos++) {
+        hasDigit = true;
+        if(nDigits > 0 || *pos != '0') { if(++nDigits > 19) return false; }
+        mant = mant*10 + (*pos - '0'); exp10--;
+      }
+    }
+    if(!hasDigit) return false;
+
+    if(pos < end && (*pos == 'e' || *pos == 'E')) {
+      bool isNegExp(false);
+      int  expNow(0);
+
+      pos++;
+      if(pos < end && (*pos == '+' || *pos == '-')) { isNegExp = (*pos == '-'); pos++; }
+      if(pos == end || !isDigit(*pos)) return false;
+
+      for(; pos < end && isDigit(*pos); pos++) { expNow = expNow*10 + (*pos - '0'); if(expNow > 1000) return false; }
+      exp10 += (isNegExp ? -expNow : expNow);
+    }
+    if(pos != end || mant > maxMant) return false;
+
+    T valNow = static_cast<T>(mant);
+    if     (exp10 < 0) { if(-exp10 > maxPow) return false; valNow /= pow10[-exp10]; }
+    else if(exp10 > 0) { if( exp10 > maxPow) return false; valNow *= pow10[ exp10]; }
+
+    val = (isNeg ? -valNow : valNow);
+    return true;
+  }
+
+  // fast conversion of integers of the form [+-]digits (up to 18 digits, so that there is no overflow)
+  inline bool strToIntFast(const char * tok, int len, bool allowNeg, Long64_t & val) {
+    const char * pos(tok), * end(tok+len);
+    bool         isNeg(false);
+
+    if(pos < end && (*pos == '+' || *pos == '-')) { isNeg = (*pos == '-'); pos++; }
+    if(isNeg && !allowNeg)             return false;
+    if(pos == end || end - pos > 18)   return false;
+
+    Long64_t valNow(0);
+    for(; pos < end; pos++) {
+      if(!isDigit(*pos)) return false;
+      valNow = valNow*10 + (*pos - '0');
+    }
+
+    val = (isNeg ? -valNow : valNow);
+    return true;
+  }
+
+  // ---------------------------------------------------------------------------------------------------------
+  // conversion with the functions of the standard library, with the same error conditions as the
+  // stof(), stod(), stoi(), stoll(), stoul() and stoull() functions, which are used by Utils
+  // ---------------------------------------------------------------------------------------------------------
+  inline void strToNumStd(const char * str, char ** endPtr, float              & val) { val = strtof  (str,endPtr);    }
+  inline void strToNumStd(const char * str, char ** endPtr, double             & val) { val = strtod  (str,endPtr);    }
+  inline void strToNumStd(const char * str, char ** endPtr, long               & val) { val = strtol  (str,endPtr,10); }
+  inline void strToNumStd(const char * str, char ** endPtr, long long          & val) { val = strtoll (str,endPtr,10); }
+  inline void strToNumStd(const char * str, char ** endPtr, unsigned long      & val) { val = strtoul (str,endPtr,10); }
+  inline void strToNumStd(const char * str, char ** endPtr, unsigned long long & val) { val = strtoull(str,endPtr,10); }
+
+  template <class T> bool strToNumSlow(const char * tok, int len, T & val) {
+    char        buf[nMaxTokLen];
+    std::string longStr;
+    const char  * str(buf);
+
+    if(len < nMaxTokLen) { memcpy(buf,tok,len); buf[len] = '\0';       }
+    else                 { longStr.assign(tok,len); str = longStr.c_str(); }
+
+    char * endPtr(NULL);
+    errno = 0; strToNumStd(str,&endPtr,val);
+
+    return (endPtr != str && errno != ERANGE);
+  }
+
+  // ---------------------------------------------------------------------------------------------------------
+  // conversion for each type of variable
+  // ---------------------------------------------------------------------------------------------------------
+  inline bool strToFloat(const char * tok, int len, float & val) {
+    if(strToFloatFast<float>(tok,len,(1ULL<<24),10,pow10F,val)) return true;
+    return strToNumSlow(tok,len,val);
+  }
+  inline bool strToDouble(const char * tok, int len, double & val) {
+    if(strToFloatFast<double>(tok,len,(1ULL<<53),22,pow10D,val)) return true;
+    return strToNumSlow(tok,len,val);
+  }
+  inline bool strToInt(const char * tok, int len, Long64_t & val) {
+    if(!strToIntFast(tok,len,true,val)) {
+      long valL(0);
+      if(!strToNumSlow(tok,len,valL)) return false;
+      val = valL;
+    }
+    return (val >= std::numeric_limits<int>::min() && val <= std::numeric_limits<int>::max());
+  }
+  inline bool strToLong(const char * tok, int len, Long64_t & val) {
+    if(strToIntFast(tok,len,true,val)) return true;
+
+    long long valL(0);
+    if(!strToNumSlow(tok,len,valL)) return false;
+    val = valL;
+    return true;
+  }
+  inline bool strToUint(const char * tok, int len, ULong64_t & val) {
+    Long64_t valI(0);
+    if(strToIntFast(tok,len,false,valI)) { val = static_cast<UInt_t>(valI); return true; }
+
+    unsigned long valU(0);
+    if(!strToNumSlow(tok,len,valU)) return false;
+    val = static_cast<UInt_t>(valU);
+    return true;
+  }
+  inline bool strToUlong(const char * tok, int len, ULong64_t & val) {
+    Long64_t valI(0);
+    if(strToIntFast(tok,len,false,valI)) { val = valI; return true; }
+
+    unsigned long long valU(0);
+    if(!strToNumSlow(tok,len,valU)) return false;
+    val = valU;
+    return true;
+  }
+}
+
+
+// ===========================================================================================================
+InputFileReader::InputFileReader() {
+// =================================
+  fileType  = NON;   fileDesc = -1;    nCols    = 0;    nRows   = 0;    nRowNow    = -1;   nRowEnd = 0;
+  mapSize   = 0;     mapBegin = NULL;  mapEnd   = NULL; readPos = NULL; readEnd    = NULL; rowBegin = NULL;
+  rowEnd    = NULL;  dataBegin = NULL; isColMajor = false; rowStride = 0;
+  return;
+}
+InputFileReader::~InputFileReader() {
+// ==================================
+  close();
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief           - Get the type of an input file from the extension of its name.
+ */
+// ===========================================================================================================
+InputFileReader::FileType InputFileReader::getFileType(const TString & fileName) {
+// ===============================================================================
+  if(fileName.EndsWith(".npy")) return NPY;
+  if(fileName.EndsWith(".bin")) return BIN;
+  return ASCII;
+}
+
+// ===========================================================================================================
+/**
+ * @brief           - Map an input file into memory, and parse the header of binary inputs.
+ *
+ * @param fileName  - The name of the input file
+ * @param failMsg   - Description of the problem, in case the file can not be used
+ *
+ * @return          - Whether the file may be used
+ */
+// ===========================================================================================================
+bool InputFileReader::open(TString fileName, TString & failMsg) {
+// ==============================================================
+  close();
+
+  fileType = getFileType(fileName);
+
+  // binary data are read as little-endian
+  if(isBinary()) {
+    UShort_t testEndian(1);
+    if(*reinterpret_cast<char*>(&testEndian) != 1) { failMsg = "binary inputs are only supported on little-endian machines"; return false; }
+  }
+
+  fileDesc = ::open(fileName.Data(),O_RDONLY);
+  if(fileDesc < 0) { failMsg = (TString)"could not open file ("+strerror(errno)+")"; return false; }
+
+  struct stat fileStat;
+  if(fstat(fileDesc,&fileStat) != 0) { failMsg = (TString)"could not get file size ("+strerror(errno)+")"; return false; }
+
+  // an empty file (which can not be mapped) has no rows
+  mapSize = static_cast<size_t>(fileStat.st_size);
+
+  if(mapSize > 0) {
+    void * mapPtr = mmap(NULL,mapSize,PROT_READ,MAP_PRIVATE,fileDesc,0);
+    if(mapPtr == MAP_FAILED) { mapSize = 0; failMsg = (TString)"could not map file ("+strerror(errno)+")"; return false; }
+
+    madvise(mapPtr,mapSize,MADV_SEQUENTIAL);
+
+    mapBegin = static_cast<const char*>(mapPtr);
+    mapEnd   = mapBegin + mapSize;
+  }
+  readPos = mapBegin; readEnd = mapEnd;
+
+  if     (fileType == NPY) { if(!parseHeaderNPY(failMsg)) return false; }
+  else if(fileType == BIN) { if(!parseHeaderBIN(failMsg)) return false; }
+
+  nRowEnd = nRows;
+
+  return true;
+}
+
+// ===========================================================================================================
+void InputFileReader::close() {
+// ============================
+  if(mapBegin)      munmap(const_cast<char*>(mapBegin),mapSize);
+  if(fileDesc >= 0) ::close(fileDesc);
+
+  fileType = NON;  fileDesc = -1;   nCols   = 0;    nRows    = 0;    nRowNow = -1;   nRowEnd  = 0;
+  mapSize  = 0;    mapBegin = NULL; mapEnd  = NULL; readPos  = NULL; readEnd = NULL; rowBegin = NULL;
+  rowEnd   = NULL; dataBegin = NULL;
+
+  colTypeV.clear(); colSizeV.clear(); colOffsetV.clear();
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - Set the type and the size in bytes of a column, from a NumPy-style type code (e.g., "f4").
+ */
+// ===========================================================================================================
+bool InputFileReader::setDataType(TString typeCode, DataType & dataType, int & dataSize) {
+// ======================================================================================
+  if     (typeCode == "f4") { dataType = kF4; dataSize = 4; }
+  else if(typeCode == "f8") { dataType = kF8; dataSize = 8; }
+  else if(typeCode == "i1") { dataType = kI1; dataSize = 1; }
+  else if(typeCode == "i2") { dataType = kI2; dataSize = 2; }
+  else if(typeCode == "i4") { dataType = kI4; dataSize = 4; }
+  else if(typeCode == "i8") { dataType = kI8; dataSize = 8; }
+  else if(typeCode == "u1") { dataType = kU1; dataSize = 1; }
+  else if(typeCode == "u2") { dataType = kU2; dataSize = 2; }
+  else if(typeCode == "u4") { dataType = kU4; dataSize = 4; }
+  else if(typeCode == "u8") { dataType = kU8; dataSize = 8; }
+  else if(typeCode == "b1") { dataType = kB1; dataSize = 1; }
+  else return false;
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - Parse the header of a ".npy" file (see numpy.lib.format), which is a python dictionary literal of
+ *         the form: {'descr': '<f4', 'fortran_order': False, 'shape': (nRows, nCols), }
+ */
+// ===========================================================================================================
+bool InputFileReader::parseHeaderNPY(TString & failMsg) {
+// ======================================================
+  const char magic[] = "\x93NUMPY";
+
+  if(mapSize < 10 || memcmp(mapBegin,magic,6) != 0) { failMsg = "not a valid npy file"; return false; }
+
+  int      majorVer = static_cast<unsigned char>(mapBegin[6]);
+  Long64_t headLen(0), headPos(0);
+
+  if(majorVer == 1) {
+    UShort_t len16(0); memcpy(&len16,mapBegin+8,2);
+    headLen = len16; headPos = 10;
+  }
+  else if(majorVer == 2 || majorVer == 3) {
+    if(mapSize < 12) { failMsg = "not a valid npy file"; return false; }
+
+    UInt_t len32(0); memcpy(&len32,mapBegin+8,4);
+    headLen = len32; headPos = 12;
+  }
+  else { failMsg = TString::Format("unsupported npy format version (%d)",majorVer); return false; }
+
+  if(headPos + headLen > (Long64_t)mapSize) { failMsg = "truncated npy header"; return false; }
+
+  std::string head(mapBegin+headPos,headLen);
+
+  // the data type - structured arrays (where descr is a list) are not supported
+  size_t pos = head.find("'descr'");
+  if(pos != std::string::npos) pos = head.find_first_not_of(" :",pos+7);
+  if(pos == std::string::npos || head[pos] != '\'') { failMsg = "only simple numerical npy arrays are supported (no structured arrays)"; return false; }
+
+  size_t  posEnd = head.find('\'',pos+1);
+  TString descr  = (posEnd == std::string::npos) ? "" : (TString)head.substr(pos+1,posEnd-pos-1);
+  if(descr.Length() != 3) { failMsg = (TString)"unsupported npy data type ("+descr+")"; return false; }
+
+  DataType dataType(kF4);
+  int      dataSize(0);
+  if(!setDataType(descr(1,2),dataType,dataSize)) { failMsg = (TString)"unsupported npy data type ("+descr+")"; return false; }
+  if(descr[0] == '>' && dataSize > 1)            { failMsg = (TString)"big-endian npy data are not supported ("+descr+")"; return false; }
+
+  // the storage order
+  pos = head.find("'fortran_order'");
+  if(pos == std::string::npos) { failMsg = "missing fortran_order in npy header"; return false; }
+  pos = head.find_first_not_of(" :",pos+15);
+  isColMajor = (pos != std::string::npos && head.compare(pos,4,"True") == 0);
+
+  // the shape of the array - one row per object, and one column per input variable
+  pos    = head.find("'shape'");
+  if(pos != std::string::npos) pos = head.find('(',pos);
+  posEnd = (pos == std::string::npos) ? pos : head.find(')',pos);
+  if(posEnd == std::string::npos) { failMsg = "missing shape in npy header"; return false; }
+
+  vector <Long64_t> shapeV;
+  std::stringstream shapeSS(head.substr(pos+1,posEnd-pos-1));
+  std::string       dimStr;
+  while(getline(shapeSS,dimStr,',')) {
+    if(dimStr.find_first_not_of(" ") == std::string::npos) continue;
+    shapeV.push_back(strtoll(dimStr.c_str(),NULL,10));
+  }
+
+  if     (shapeV.size() == 1) { nRows = shapeV[0]; nCols = 1;                        }
+  else if(shapeV.size() == 2) { nRows = shapeV[0]; nCols = static_cast<int>(shapeV[1]); }
+  else { failMsg = TString::Format("only one or two dimensional npy arrays are supported (found %d dimensions)",(int)shapeV.size()); return false; }
+
+  dataBegin = mapBegin + headPos + headLen;
+  if(nRows < 0 || nCols <= 0 || (dataBegin - mapBegin) + nRows * nCols * dataSize > (Long64_t)mapSize) {
+    failMsg = "npy file is smaller than expected from its header"; return false;
+  }
+
+  colTypeV.assign(nCols,dataType); colSizeV.assign(nCols,dataSize); colOffsetV.resize(nCols);
+  for(int nColNow=0; nColNow<nCols; nColNow++) colOffsetV[nColNow] = (isColMajor ? nRows : 1) * nColNow * dataSize;
+  rowStride = nCols * dataSize;
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - Parse the header of a ".bin" file, with the format described in the documentation of the class.
+ */
+// ===========================================================================================================
+bool InputFileReader::parseHeaderBIN(TString & failMsg) {
+// ======================================================
+  const Long64_t headLen(20);
+
+  if(mapSize < headLen || memcmp(mapBegin,"ANNZBIN1",8) != 0) { failMsg = "not a valid ANNZ binary file (wrong magic string)"; return false; }
+
+  UInt_t    nColsIn(0);
+  ULong64_t nRowsIn(0);
+  memcpy(&nColsIn,mapBegin+8 ,4);
+  memcpy(&nRowsIn,mapBegin+12,8);
+
+  nCols = static_cast<int>(nColsIn); nRows = static_cast<Long64_t>(nRowsIn);
+  if(nCols <= 0 || nRows < 0 || headLen + 2*nCols > (Long64_t)mapSize) { failMsg = "not a valid ANNZ binary file (wrong header)"; return false; }
+
+  colTypeV.resize(nCols); colSizeV.resize(nCols); colOffsetV.resize(nCols);
+
+  Long64_t offset(0);
+  for(int nColNow=0; nColNow<nCols; nColNow++) {
+    TString typeCode(mapBegin+headLen+2*nColNow,2);
+    if(!setDataType(typeCode,colTypeV[nColNow],colSizeV[nColNow])) {
+      failMsg = TString::Format("unsupported data type (\"%s\") for column %d",typeCode.Data(),nColNow); return false;
+    }
+    colOffsetV[nColNow] = offset;
+    offset             += nRows * colSizeV[nColNow];
+  }
+
+  isColMajor = true;
+  dataBegin  = mapBegin + headLen + 2*nCols;
+
+  if((dataBegin - mapBegin) + offset > (Long64_t)mapSize) { failMsg = "ANNZ binary file is smaller than expected from its header"; return false; }
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - Move to the next row of the input. For ascii inputs, empty lines and comment lines are skipped,
+ *         and the tokens of the row are set, where columns are separated by any combination of spaces,
+ *         commas and tabs.
+ *
+ * @return - Whether a new row is available
+ */
+// ===========================================================================================================
+bool InputFileReader::nextRow() {
+// ==============================
+  if(isBinary()) {
+    if(nRowNow + 1 >= nRowEnd) return false;
+
+    nRowNow++;
+    return true;
+  }
+
+  while(readPos < readEnd) {
+    const char * lineEnd = static_cast<const char*>(memchr(readPos,'\n',readEnd-readPos));
+    if(!lineEnd) lineEnd = readEnd;
+
+    rowBegin = readPos; rowEnd = lineEnd;
+    readPos  = (lineEnd < readEnd) ? lineEnd + 1 : readEnd;
+
+    tokBeginV.clear(); tokLenV.clear();
+
+    const char * pos = rowBegin;
+    while(pos < rowEnd) {
+      while(pos < rowEnd && (*pos == ' ' || *pos == ',' || *pos == '\t' || *pos == '\r')) pos++;
+      if(pos == rowEnd) break;
+
+      const char * tokBegin = pos;
+      while(pos < rowEnd && !(*pos == ' ' || *pos == ',' || *pos == '\t' || *pos == '\r')) pos++;
+
+      tokBeginV.push_back(tokBegin); tokLenV.push_back(static_cast<int>(pos - tokBegin));
+    }
+
+    // skip empty lines and comment lines
+    if(tokBeginV.size() == 0 || *tokBeginV[0] == '#') continue;
+
+    nCols = static_cast<int>(tokBeginV.size());
+    nRowNow++;
+    return true;
+  }
+
+  return false;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Divide the input into (approximately) equal ranges, which may be read independently.
+ *
+ * @details       - For ascii inputs, the bounds are byte offsets, which are moved to the beginning of the
+ *                following line, so that each line belongs to exactly one range. For binary inputs, the
+ *                bounds are row indices. The bounds only depend on the content of the file and on nRanges.
+ *
+ * @param nRanges - The requested number of ranges (fewer may be given for small inputs)
+ * @param boundV  - The bounds of the ranges, where range i is [boundV[i],boundV[i+1])
+ */
+// ===========================================================================================================
+void InputFileReader::getRangeBounds(int nRanges, vector <Long64_t> & boundV) const {
+// ==================================================================================
+  Long64_t nTot = isBinary() ? nRows : (Long64_t)mapSize;
+  nRanges       = static_cast<int>(max(min((Long64_t)nRanges,nTot),(Long64_t)1));
+
+  boundV.clear(); boundV.push_back(0);
+
+  for(int nRangeNow=1; nRangeNow<nRanges; nRangeNow++) {
+    Long64_t boundNow = (nTot * nRangeNow) / nRanges;
+
+    if(!isBinary()) {
+      const char * lineEnd = static_cast<const char*>(memchr(mapBegin+boundNow,'\n',mapSize-boundNow));
+      boundNow = lineEnd ? (Long64_t)(lineEnd - mapBegin) + 1 : nTot;
+    }
+    if(boundNow > boundV.back() && boundNow < nTot) boundV.push_back(boundNow);
+  }
+  boundV.push_back(nTot);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief            - Restrict the following calls to nextRow() to a range of the input (see getRangeBounds()).
+ */
+// ===========================================================================================================
+void InputFileReader::setRange(Long64_t rangeBegin, Long64_t rangeEnd) {
+// =====================================================================
+  if(isBinary()) {
+    nRowNow = min(rangeBegin,nRows) - 1;
+    nRowEnd = min(rangeEnd  ,nRows);
+  }
+  else {
+    readPos = mapBegin + min(rangeBegin,(Long64_t)mapSize);
+    readEnd = mapBegin + min(rangeEnd  ,(Long64_t)mapSize);
+    nRowNow = -1;
+  }
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - The number of rows between the current position and the end of the range, without parsing
+ *         the rows of ascii inputs (empty lines and comment lines are not counted).
+ */
+// ===========================================================================================================
+Long64_t InputFileReader::countRows() const {
+// ==========================================
+  if(isBinary()) return (nRowEnd - nRowNow - 1);
+
+  Long64_t     nRowsRange(0);
+  const char * pos(readPos);
+
+  while(pos < readEnd) {
+    const char * lineEnd = static_cast<const char*>(memchr(pos,'\n',readEnd-pos));
+    if(!lineEnd) lineEnd = readEnd;
+
+    while(pos < lineEnd && (*pos == ' ' || *pos == ',' || *pos == '\t' || *pos == '\r')) pos++;
+    if(pos < lineEnd && *pos != '#') nRowsRange++;
+
+    pos = lineEnd + 1;
+  }
+
+  return nRowsRange;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - The current line of an ascii input (used for error messages)
+ */
+// ===========================================================================================================
+TString InputFileReader::getLine() const {
+// =======================================
+  if(isBinary() || !rowBegin) return TString::Format("row %lld",nRowNow);
+  return TString(rowBegin,static_cast<Ssiz_t>(rowEnd - rowBegin));
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - Get the values of the current row of binary inputs, converted to a floating-point, a signed
+ *         or an unsigned number
+ */
+// ===========================================================================================================
+const char * InputFileReader::getValPtr(int nColNow) const {
+// =========================================================
+  if(isColMajor) return dataBegin + colOffsetV[nColNow] + nRowNow * colSizeV[nColNow];
+  else           return dataBegin + colOffsetV[nColNow] + nRowNow * rowStride;
+}
+
+// ===========================================================================================================
+double InputFileReader::getValF(int nColNow) const {
+// =================================================
+  const char * valPtr = getValPtr(nColNow);
+
+  switch(colTypeV[nColNow]) {
+    case kF4: { Float_t   val; memcpy(&val,valPtr,4); return val; }
+    case kF8: { Double_t  val; memcpy(&val,valPtr,8); return val; }
+    case kI1: { Char_t    val; memcpy(&val,valPtr,1); return val; }
+    case kI2: { Short_t   val; memcpy(&val,valPtr,2); return val; }
+    case kI4: { Int_t     val; memcpy(&val,valPtr,4); return val; }
+    case kI8: { Long64_t  val; memcpy(&val,valPtr,8); return static_cast<double>(val); }
+    case kU1: { UChar_t   val; memcpy(&val,valPtr,1); return val; }
+    case kU2: { UShort_t  val; memcpy(&val,valPtr,2); return val; }
+    case kU4: { UInt_t    val; memcpy(&val,valPtr,4); return val; }
+    case kU8: { ULong64_t val; memcpy(&val,valPtr,8); return static_cast<double>(val); }
+    case kB1: { UChar_t   val; memcpy(&val,valPtr,1); return (val != 0); }
+  }
+  return 0;
+}
+// ===========================================================================================================
+Long64_t InputFileReader::getValI(int nColNow) const {
+// ===================================================
+  const char * valPtr = getValPtr(nColNow);
+
+  switch(colTypeV[nColNow]) {
+    case kI8: { Long64_t  val; memcpy(&val,valPtr,8); return val;                        }
+    case kU8: { ULong64_t val; memcpy(&val,valPtr,8); return static_cast<Long64_t>(val); }
+    default:                                          return static_cast<Long64_t>(getValF(nColNow));
+  }
+}
+// ===========================================================================================================
+ULong64_t InputFileReader::getValU(int nColNow) const {
+// ====================================================
+  const char * valPtr = getValPtr(nColNow);
+
+  switch(colTypeV[nColNow]) {
+    case kU8: { ULong64_t val; memcpy(&val,valPtr,8); return val;                         }
+    case kI8: { Long64_t  val; memcpy(&val,valPtr,8); return static_cast<ULong64_t>(val); }
+    default:                                          return static_cast<ULong64_t>(getValI(nColNow));
+  }
+}
+
+
+// ===========================================================================================================
+/**
+ * @brief              - Fill the current row of an InputFileReader into a VarMaps() object.
+ *
+ * @details            - Equivalent to inputLineToVars(), where the tokens of ascii inputs are converted in place,
+ *                     without creating strings (see fastInputFuncs). The numerical conversion follows the
+ *                     conventions of the stof(), stod(), stoi() etc. functions, which are used by Utils.
+ *
+ * @param inReader     - The reader of the input file, after a call to InputFileReader::nextRow()
+ * @param var          - The VarMaps() object in which the variables are filled
+ * @param inVarNames   - vector which is contains the list of input parameter names
+ * @param inVarTypes   - vector which is contains the list of input parameter types
+ * @param inVarHdls    - vector of handles of the input parameters in var (see VarMaps::GetVarHandles())
+ */
+// ===========================================================================================================
+bool CatFormat::inputRowToVars(InputFileReader * inReader, VarMaps * var, vector <TString> & inVarNames, vector <TString> & inVarTypes,
+                               vector <VarMaps::VarHandle> & inVarHdls) {
+// =====================================================================================================================================
+  int nCols(inReader->getNcols()), nVars((int)inVarNames.size());
+
+  // verify that the row has the correct number of input variables
+  if(nCols != nVars || (int)inVarHdls.size() != nVars) {
+    aLOG(Log::ERROR) <<endl<< "line: " << inReader->getLine() <<endl;
+    for(int nVarNow=0; nVarNow<nVars; nVarNow++) aLOG(Log::ERROR) <<"vars:  "<<nVars<<CT<<nVarNow<<CT<<inVarNames[nVarNow]<<endl;
+    VERIFY(LOCATION,(TString)"Input line has wrong number of variables ("+utils->intToStr(nCols)+") !!!",false);
+  }
+
+  var->setDefaultVals();
+
+  // -----------------------------------------------------------------------------------------------------------
+  // binary inputs - the values are converted to the type of each variable
+  // -----------------------------------------------------------------------------------------------------------
+  if(inReader->isBinary()) {
+    for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
+      VarMaps::VarHandle & hdl = inVarHdls[nVarNow];
+
+      switch(hdl.getType()) {
+        case VarMaps::VarHandle::kF:  case VarMaps::VarHandle::kD:  { var->SetVarF(hdl,inReader->getValF(nVarNow));        break; }
+        case VarMaps::VarHandle::kS:  case VarMaps::VarHandle::kI:
+        case VarMaps::VarHandle::kL:                                { var->SetVarI(hdl,inReader->getValI(nVarNow));        break; }
+        case VarMaps::VarHandle::kUS: case VarMaps::VarHandle::kUI:
+        case VarMaps::VarHandle::kUL:                               { var->SetVarU(hdl,inReader->getValU(nVarNow));        break; }
+        case VarMaps::VarHandle::kB:                                { var->SetVarB(hdl,(inReader->getValI(nVarNow) != 0)); break; }
+        default: VERIFY(LOCATION,(TString)"found unsupported variable-type ("+inVarTypes[nVarNow]+") for "+inVarNames[nVarNow]
+                                         +" (string variables are not supported for binary inputs)",false);
+      }
+    }
+    return true;
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // ascii inputs - the tokens are converted in place
+  // -----------------------------------------------------------------------------------------------------------
+  for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
+    VarMaps::VarHandle & hdl = inVarHdls[nVarNow];
+    const char         * tok(NULL);
+    int                tokLen(0);
+    bool               isGood(true);
+
+    inReader->getToken(nVarNow,tok,tokLen);
+
+    switch(hdl.getType()) {
+      case VarMaps::VarHandle::kF:  { float     val(0); isGood = fastInputFuncs::strToFloat (tok,tokLen,val); if(isGood) var->SetVarF(hdl,val); break; }
+      case VarMaps::VarHandle::kD:  { double    val(0); isGood = fastInputFuncs::strToDouble(tok,tokLen,val); if(isGood) var->SetVarF(hdl,val); break; }
+      case VarMaps::VarHandle::kS:
+      case VarMaps::VarHandle::kI:  { Long64_t  val(0); isGood = fastInputFuncs::strToInt   (tok,tokLen,val); if(isGood) var->SetVarI(hdl,val); break; }
+      case VarMaps::VarHandle::kL:  { Long64_t  val(0); isGood = fastInputFuncs::strToLong  (tok,tokLen,val); if(isGood) var->SetVarI(hdl,val); break; }
+      case VarMaps::VarHandle::kUS:
+      case VarMaps::VarHandle::kUI: { ULong64_t val(0); isGood = fastInputFuncs::strToUint  (tok,tokLen,val); if(isGood) var->SetVarU(hdl,val); break; }
+      case VarMaps::VarHandle::kUL: { ULong64_t val(0); isGood = fastInputFuncs::strToUlong (tok,tokLen,val); if(isGood) var->SetVarU(hdl,val); break; }
+      case VarMaps::VarHandle::kB:  { var->SetVarB(hdl,utils->strToBool(TString(tok,tokLen)));                                                  break; }
+      case VarMaps::VarHandle::kC:  {
+        // remove enclosing quotation marks from strings
+        if(tokLen >= 2 && ((tok[0] == '\"' && tok[tokLen-1] == '\"') || (tok[0] == '\'' && tok[tokLen-1] == '\''))) { tok++; tokLen -= 2; }
+        var->SetVarC(hdl,TString(tok,tokLen));
+        break;
+      }
+      default: VERIFY(LOCATION,(TString)"found unsupported variable-type ("+inVarTypes[nVarNow]+")",false);
+    }
+
+    VERIFY(LOCATION,(TString)" - Could not perform conversion from string ("+TString(tok,tokLen)+") for "+inVarNames[nVarNow]
+                            +" of type "+inVarTypes[nVarNow]+" from input-line = "+inReader->getLine(),isGood);
+  }
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief                - Get the number of objects in input files. For binary inputs (see InputFileReader),
+ *                       this is given by the header of the file, and for ascii inputs by Utils::getNlinesAsciiFile().
+ *
+ * @param inFileName     - The name of the input file
+ * @param checkNonEmpty  - Whether to fail if there are no objects in the file
+ */
+// ===========================================================================================================
+int CatFormat::getNinputLines(TString inFileName, bool checkNonEmpty) {
+// ====================================================================
+  if(InputFileReader::getFileType(inFileName) == InputFileReader::ASCII) return utils->getNlinesAsciiFile(inFileName,checkNonEmpty);
+
+  InputFileReader inReader;
+  TString         failMsg("");
+
+  VERIFY(LOCATION,(TString)"Could not read input file ("+inFileName+"): "+failMsg,inReader.open(inFileName,failMsg));
+
+  int nLines = static_cast<int>(inReader.getNrows());
+  if(checkNonEmpty) VERIFY(LOCATION,(TString)"found empty input file ("+inFileName+") ...",(nLines > 0));
+
+  return nLines;
+}
+// ===========================================================================================================
+int CatFormat::getNinputLines(vector <TString> & inFileNameV, bool checkNonEmpty, vector <int> * nLineV) {
+// =======================================================================================================
+  TString inFileNames("");
+  int     nLinesTot(0), nInFiles((int)inFileNameV.size());
+
+  for(int nInFileNow=0; nInFileNow<nInFiles; nInFileNow++) {
+    int nLines   = getNinputLines(inFileNameV[nInFileNow],checkNonEmpty);
+    nLinesTot   += nLines;
+    inFileNames += (TString)inFileNameV[nInFileNow]+" , ";
+
+    if(nLineV) nLineV->push_back(nLines);
+
+    aLOG(Log::INFO)<<coutGreen<<" - Found "<<coutYellow<<nLines<<coutGreen<<" lines in file "<<coutRed<<inFileNameV[nInFileNow]
+                                   <<coutGreen<<coutGreen<<" -> total so far = "<<coutYellow<<nLinesTot<<" ... "<<coutDef<<endl;
+  }
+
+  if(checkNonEmpty) VERIFY(LOCATION,(TString)"found no files, or only empty input files ("+inFileNames+") ...",(nLinesTot > 0));
+
+  return nLinesTot;
+}
@@ -268,6 +268,7 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
   TString outAsciiVars     = glob->GetOptC((TString)"outAsciiVars"  +typePostfix); // e.g., "outAsciiVars_wgtKNN"
   TString weightVarNames   = glob->GetOptC((TString)"weightVarNames"+typePostfix); // e.g., "weightVarNames_wgtKNN"
   int     minNobjInVol     = glob->GetOptI((TString)"minNobjInVol"  +typePostfix); // e.g., "minNobjInVol_wgtKNN"
+  double  recallTarget     = glob->GetOptF("approxRecallKNN");
   double  sampleFracInp    = glob->GetOptF((TString)"sampleFracInp" +typePostfix); // e.g., "sampleFracInp_wgtKNN"
   double  sampleFracRef    = glob->GetOptF((TString)"sampleFracRef" +typePostfix); // e.g., "sampleFracRef_wgtKNN"
   bool    doWidthRescale   = glob->GetOptB((TString)"doWidthRescale"+typePostfix);
@@ -356,6 +357,7 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
   vector < vector <TMVA::Factory *> >        knnErrFactory    (2, vector<TMVA::Factory *>       (nKnnFracs,NULL));
   vector < vector <TMVA::MethodKNN *> >      knnErrMethod     (2, vector<TMVA::MethodKNN *>     (nKnnFracs,NULL));
   vector < vector <TMVA::kNN::ModulekNN *> > knnErrModule     (2, vector<TMVA::kNN::ModulekNN *>(nKnnFracs,NULL));
+  vector < vector <KdTreeKNN *> >            knnKdTree        (2, vector<KdTreeKNN *>(nKnnFracs,NULL));
   vector < vector <TString> >                outFileNameKnnErr(2, vector<TString>               (nKnnFracs,"")  );
 
   #if ROOT_TMVA_V0
@@ -591,6 +593,25 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
       
       knnErrModule[nChainNow][nFracNow] = knnErrMethod[nChainNow][nFracNow]->fModule;
 
+      // sanity check - the events of the module must not be rescaled for the distances of the flat kd-tree
+      VERIFY(LOCATION,(TString)"Somehow the kd-tree rescales variables ... Something is horribly wrong ?!?!?"
+                               ,(knnErrModule[nChainNow][nFracNow]->fTree && knnErrModule[nChainNow][nFracNow]->fVarScale.empty()));
+
+      // the near neighbours are found using a flat kd-tree, built from the events of the module
+      knnKdTree[nChainNow][nFracNow] = new KdTreeKNN();
+      knnKdTree[nChainNow][nFracNow]->Build(knnErrModule[nChainNow][nFracNow]);
+
+      // if requested, use an approximate search, with the recall measured on a held-out sample
+      if(recallTarget < 1) {
+        double speedUp(1);
+        double recall = knnKdTree[nChainNow][nFracNow]->TuneMaxChecks(minNobjInVol,recallTarget,1000,&speedUp);
+
+        aLOG(Log::INFO) <<coutGreen<<" - "<<coutBlue<<aChainV[nChainNow]->GetName()<<coutGreen<<" - approximate kd-tree search: recall = "
+                        <<coutYellow<<TString::Format("%.4f",recall)<<coutGreen<<" (target "<<coutYellow<<recallTarget<<coutGreen
+                        <<"), checked objects = "<<coutYellow<<knnKdTree[nChainNow][nFracNow]->GetMaxChecks()<<coutGreen
+                        <<" (0 -> exact search), speed-up = "<<coutYellow<<TString::Format("%.3g",speedUp)<<coutDef<<endl;
+      }
+
       aLOG(Log::INFO)  <<coutGreen<<" - "<<coutBlue<<aChainV[nChainNow]->GetName()<<coutGreen<<" - kd-tree (effective entries = "
                        <<nEffObj<<")"<<coutYellow<<" , opts = "<<coutRed<<optKNN<<coutYellow<<" , "<<coutRed
                        <<trainValidStr<<coutYellow<<" , cuts = "<<coutRed<<finalCut<<coutYellow<<" , weight expression: "<<coutRed
@@ -634,198 +655,288 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
   TTree * outTree = new TTree(outTreeName,outTreeName); outTree->SetDirectory(0); outputs->TreeMap[outTreeName] = outTree;
   var_1->createTreeBranches(outTree); 
 
+  outputs->BeginTreeLoop();
+
   aLOG(Log::INFO) <<coutBlue<<" - Will write weights to "<<coutYellow<<(TString)outDirNameFull+outTreeName<<coutBlue<<" ... "<<coutDef<<endl;
 
   // -----------------------------------------------------------------------------------------------------------
-  // loop on the tree
+  // derive the weight of a single object - this only reads the kd-trees, and may therefore be called concurrently
+  // by several threads, where each thread uses its own buffers (of size nFindMax) for the near neighbours, and
+  // for the queue of an approximate search
   // -----------------------------------------------------------------------------------------------------------
-  double            weightSum(0);
-  vector <int>      distIndexV(2,0);
-  vector <double>   distV(2,0), weightSumV(2,0);
-  TMVA::kNN::VarVec objNowV(nVars,0);
+  int nFindMax = max(minNobjInVol,1);
 
-  int  nObjectsToPrint = min(static_cast<int>(aChainInpEvl->GetEntries()/10.) , glob->GetOptI("nObjectsToPrint"));
-  bool breakLoop(false), mayWriteObjects(false);
-  var_0->clearCntr();
-  for(Long64_t loopEntry=0; true; loopEntry++) {
-    if(!var_0->getTreeEntry(loopEntry)) breakLoop = true;
+  auto getWeightKNN = [&](const TMVA::kNN::VarVec & objNowV, int * knnIndex, Float_t * knnDist,
+                          vector < pair<Float_t,int> > * knnQueue, bool & foundDist) -> double {
+    int nFound(0);
 
-    if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
-      var_0->printCntr(outTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
-      mayWriteObjects = false;
-    }
-    else if(var_0->GetCntr("nObj") % nObjectsToPrint == 0) { var_0->printCntr(outTreeName); }
+    double weightKNN(0);
+    foundDist = false;
 
-    if(breakLoop) break;
+    // -----------------------------------------------------------------------------------------------------------
+    // derive the weights as the ratio between input and reference samples, if needed
+    // -----------------------------------------------------------------------------------------------------------
+    if(doRelWgts) {
+      int    distIndexV[2] = {0,0};
+      double distV[2]      = {0,0}, weightSumV[2] = {0,0};
 
-    var_1->copyVarData(var_0,&varTypeNameV);
+      // find the same number of near neighbours for each chain, and derive the distance this requires
+      int    nObjKNN(minNobjInVol);
+      for(int nChainNow=0; nChainNow<2; nChainNow++) {
+        nFound = knnKdTree[nChainNow][0]->Find(&(objNowV[0]),nObjKNN,knnIndex,knnDist,knnQueue);
 
-    // fill the current object vector and use it later in order to create a TMVA::kNN::Event object
-    // if any of the variables is beyond the limits derived from the reference sample, the weight is
-    // automatically set to zero, with no other computation is needed
-    // -----------------------------------------------------------------------------------------------------------
-    bool isInsideRef(true);
-    for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
-      objNowV[nVarNow] = var_0->GetForm(varFormNames[nVarNow]);
+        // must make a sanity check before using the distance to the last neighbour
+        VERIFY(LOCATION,(TString)"could not find any near neighbours for objects ... Something is horribly wrong ?!?",(nFound > 0));
 
-      if(objNowV[nVarNow] < minMaxVarVals[0][nVarNow] || objNowV[nVarNow] > minMaxVarVals[1][nVarNow]) {
-        isInsideRef = false;
-        var_0->IncCntr(wgtKNNname+" = 0 (outside input parameter range)");
-        break;
+        weightSumV[nChainNow] = 0;
+        for(int nKnnNow=0; nKnnNow<nFound; nKnnNow++) {
+          double wgtNow = knnKdTree[nChainNow][0]->GetEvent(knnIndex[nKnnNow]).GetWeight();
+
+          VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(wgtNow > 0));
+
+          weightSumV[nChainNow] += wgtNow;
+        }
+
+        distV[nChainNow] = knnDist[nFound-1];
       }
-    }
 
-    double weightKNN(0);
-    
-    if(isInsideRef) {
-      const TMVA::kNN::Event evtNow(objNowV,1,0);
+      // the index of the chain with the shorter distance
+      if(distV[0] < distV[1]) { distIndexV[0] = 0; distIndexV[1] = 1; }
+      else                    { distIndexV[0] = 1; distIndexV[1] = 0; }
 
-      // -----------------------------------------------------------------------------------------------------------
-      // derive the weights as the ratio between input and reference samples, if needed
-      // -----------------------------------------------------------------------------------------------------------
-      if(doRelWgts) {
-        // find the same number of near neighbours for each chain, and derive the distance this requires
-        int    nObjKNN(minNobjInVol);
-        for(int nChainNow=0; nChainNow<2; nChainNow++) {
-          knnErrModule[nChainNow][0]->Find(evtNow,nObjKNN);
-          const TMVA::kNN::List & knnList = knnErrModule[nChainNow][0]->GetkNNList();
+      for(int nFracNow=1; nFracNow<nKnnFracs; nFracNow++) {
+        if(!knnKdTree[distIndexV[0]][nFracNow]) break;
 
-          weightSumV[nChainNow] = 0;
-          for(TMVA::kNN::List::const_iterator lit=knnList.begin(); lit!=knnList.end(); ++lit) {
-            double wgtNow = (lit->first->GetEvent()).GetWeight();
+        nFound = knnKdTree[distIndexV[0]][nFracNow]->Find(&(objNowV[0]),nObjKNN,knnIndex,knnDist,knnQueue);
 
-            VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(wgtNow > 0));
+        weightSumV[distIndexV[0]] = 0;
+        for(int nKnnNow=0; nKnnNow<nFound; nKnnNow++) {
+          double knnDistNow = knnDist[nKnnNow];
+          double weightObj  = knnKdTree[distIndexV[0]][nFracNow]->GetEvent(knnIndex[nKnnNow]).GetWeight();
 
-            weightSumV[nChainNow] += wgtNow;
-          }
+          VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(weightObj > 0));
 
-          distV[nChainNow] = evtNow.GetDist(knnList.back().first->GetEvent());
+          if(knnDistNow < distV[distIndexV[1]]) { weightSumV[distIndexV[0]] += weightObj;        }
+          else                                  { foundDist                  = true;      break; }
+        }
+        if(foundDist) {
+          if(weightSumV[0] > EPS && weightSumV[1] > EPS) {
+            // use effEntRatio, a constant normalization - this does not change the result, but may help
+            // to prevent numerical errors if the sizes of the input/reference samples is very different
+            weightSumV[1] *= effEntRatio;
+
+            // correct for the hierarchical search-level
+            weightSumV[distIndexV[0]] *= pow(knnFracFact,nFracNow);
+            
+            // finally, calculate the weight for this object
+            weightKNN = weightSumV[1]/weightSumV[0];
+            
+            break;
+          }
         }
+      }
+    }
+    // -----------------------------------------------------------------------------------------------------------
+    // derive the weight from the approximated density estimation of near objects
+    // from the reference sample, if needed
+    // -----------------------------------------------------------------------------------------------------------
+    else {
+      // find the closest object in the reference chain
+      nFound = knnKdTree[1][0]->Find(&(objNowV[0]),1,knnIndex,knnDist,knnQueue);
 
-        // the index of the chain with the shorter distance
-        if(distV[0] < distV[1]) { distIndexV[0] = 0; distIndexV[1] = 1; }
-        else                    { distIndexV[0] = 1; distIndexV[1] = 0; }
+      // must make a sanity check before using the pointer to GetEvent()
+      VERIFY(LOCATION,(TString)"could not find any near neighbours for objects ... Something is horribly wrong ?!?",(nFound > 0));
 
-        bool   foundDist(false);
-        for(int nFracNow=1; nFracNow<nKnnFracs; nFracNow++) {
-          if(!knnErrModule[distIndexV[0]][nFracNow]) break;
+      const TMVA::kNN::Event & evtRef = knnKdTree[1][0]->GetEvent(knnIndex[0]);
+      
+      // find the distnace to the reference object we just found
+      double dist_Ref_Inp = knnDist[0];
+      double wgt_Ref_Inp  = evtRef.GetWeight();
 
-          knnErrModule[distIndexV[0]][nFracNow]->Find(evtNow,nObjKNN);
-          const TMVA::kNN::List & knnList = knnErrModule[distIndexV[0]][nFracNow]->GetkNNList();
+      VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(wgt_Ref_Inp > 0));
 
-          weightSumV[distIndexV[0]] = 0;
-          for(TMVA::kNN::List::const_iterator lit=knnList.begin(); lit!=knnList.end(); ++lit) {
-            const TMVA::kNN::Event & evtLst = lit->first->GetEvent();
+      // find the minNobjInVol near objects in the reference chain, compared to the initial reference object. The number
+      // of objects is estimated as the sum of their weights, scaled by the weight of the original refrence object. If weighs
+      // are not defined, then the sum of weights will be exactly minNobjInVol. Otherwise, several searches may be needed...
+      // -----------------------------------------------------------------------------------------------------------
+      double dist_Ref0_RefNear(0);
+      for(int nFracNow=0; nFracNow<nKnnFracs; nFracNow++) {
+        if(!knnKdTree[1][nFracNow]) break;
 
-            double knnDistNow = evtNow.GetDist(evtLst);
-            double weightObj  = evtLst.GetWeight();
+        double wgtSum_Ref0_RefNear = 0;
+        double minNobjInVolWgt     = minNobjInVol * wgt_Ref_Inp / pow(knnFracFact,nFracNow);
 
-            VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(weightObj > 0));
+        nFound = knnKdTree[1][nFracNow]->Find(&(evtRef.GetVars()[0]),minNobjInVol,knnIndex,knnDist,knnQueue);
 
-            if(knnDistNow < distV[distIndexV[1]]) { weightSumV[distIndexV[0]] += weightObj;        }
-            else                                  { foundDist                  = true;      break; }
-          }
-          if(foundDist) {
-            if(weightSumV[0] > EPS && weightSumV[1] > EPS) {
-              // use effEntRatio, a constant normalization - this does not change the result, but may help
-              // to prevent numerical errors if the sizes of the input/reference samples is very different
-              weightSumV[1] *= effEntRatio;
-
-              // correct for the hierarchical search-level
-              weightSumV[distIndexV[0]] *= pow(knnFracFact,nFracNow);
-              
-              // finally, calculate the weight for this object
-              weightKNN = weightSumV[1]/weightSumV[0];
-              
-              break;
-            }
-          }
+        for(int nKnnNow=0; nKnnNow<nFound; nKnnNow++) {
+          double distNow = knnDist[nKnnNow]; if(distNow < EPS) continue; // the first element is the initial object (-> zero distance)
+          double wgtNow  = knnKdTree[1][nFracNow]->GetEvent(knnIndex[nKnnNow]).GetWeight();
+
+          VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(wgtNow > 0));
+
+          dist_Ref0_RefNear    = distNow;
+          wgtSum_Ref0_RefNear += wgtNow;
+
+          if(wgtSum_Ref0_RefNear >= minNobjInVolWgt) { foundDist = true; break; }
         }
+        if(foundDist) break;
+      }
 
-        if(foundDist) { var_0->IncCntr("Found good weight");        weightSum += weightKNN; }
-        else          { var_0->IncCntr("Did not find good weight");                         }
+      if(foundDist) {
+        // -----------------------------------------------------------------------------------------------------------
+        // finally, compute the weight as the relative difference beween the distance between the distance
+        // measures then compute a binary decision, based on the minimal threshold set by maxRelRatioInRef
+        // -----------------------------------------------------------------------------------------------------------
+        weightKNN = max( ((dist_Ref0_RefNear - dist_Ref_Inp) / dist_Ref0_RefNear) , 0.);
+        if(maxRelRatioInRef > 0) weightKNN = (weightKNN > maxRelRatioInRef) ? 1 : 0;
+        weightKNN = max(min(weightKNN,1.),0.);
       }
-      // -----------------------------------------------------------------------------------------------------------
-      // derive the weight from the approximated density estimation of near objects
-      // from the reference sample, if needed
-      // -----------------------------------------------------------------------------------------------------------
       else {
-        // find the closest object in the reference chain
-        knnErrModule[1][0]->Find(evtNow,1);
-        const TMVA::kNN::List & knnListInp = knnErrModule[1][0]->GetkNNList();
-
-        // must make a sanity check before using the pointer to GetEvent()
-        VERIFY(LOCATION,(TString)"could not find any near neighbours for objects ... Something is horribly wrong ?!?",(knnListInp.size() > 0));
+        // assign zero weight if could not complete the calculation
+        weightKNN = 0;
+      }
+    }
 
-        const TMVA::kNN::Event evtRef(knnListInp.back().first->GetEvent());
-        
-        // find the distnace to the reference object we just found
-        double dist_Ref_Inp = evtNow.GetDist(evtRef);
-        double wgt_Ref_Inp  = evtRef.GetWeight();
+    return weightKNN;
+  };
 
-        VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(wgt_Ref_Inp > 0));
+  // -----------------------------------------------------------------------------------------------------------
+  // loop on the tree - the objects are processed in batches of nObjBatch. for each batch, (1) the (scaled) input
+  // variables of all objects are read; (2) the weights are derived in parallel by nThreads threads, where each
+  // thread processes a contiguous range of objects; (3) the objects are read again, and the output tree is filled
+  // in the original order, so that the output (and the counters and sum of weights) do not depend on nThreads
+  // -----------------------------------------------------------------------------------------------------------
+  int          nThreads   = ThreadPool::getNumThreads(glob->GetOptI("nThreads"));
+  int          nObjBatch  = nThreads * 5000;
+  ThreadPool * threadPool = (nThreads > 1) ? new ThreadPool(nThreads) : NULL;
 
-        // find the minNobjInVol near objects in the reference chain, compared to the initial reference object. The number
-        // of objects is estimated as the sum of their weights, scaled by the weight of the original refrence object. If weighs
-        // are not defined, then the sum of weights will be exactly minNobjInVol. Otherwise, several searches may be needed...
-        // -----------------------------------------------------------------------------------------------------------
-        bool   foundDist(false);
-        double dist_Ref0_RefNear(0);
-        for(int nFracNow=0; nFracNow<nKnnFracs; nFracNow++) {
-          if(!knnErrModule[1][nFracNow]) break;
+  aLOG(Log::INFO) <<coutBlue<<" - will derive the weights in batches of "<<coutYellow<<nObjBatch<<coutBlue<<" objects, using "
+                  <<coutYellow<<nThreads<<coutBlue<<" threads ..."<<coutDef<<endl;
 
-          double wgtSum_Ref0_RefNear = 0;
-          double minNobjInVolWgt     = minNobjInVol * wgt_Ref_Inp / pow(knnFracFact,nFracNow);
+  vector <VarMaps::VarHandle> varFormHdlV;
+  var_0->GetVarHandles(varFormNames,varFormHdlV);
+  VarMaps::VarHandle wgtKNNhdl = var_1->GetVarHandle(wgtKNNname);
 
-          knnErrModule[1][nFracNow]->Find(evtRef,minNobjInVol);
-          const TMVA::kNN::List & knnListRef = knnErrModule[1][nFracNow]->GetkNNList();
+  // the status of an object: 0 - outside the input parameter range, 1 - found good weight, 2 - did not find good weight
+  vector <TMVA::kNN::VarType> objBatchV   (nObjBatch*nVars,0);
+  vector <double>             wgtBatchV   (nObjBatch,0);
+  vector <int>                statusBatchV(nObjBatch,0);
+  vector < vector <int> >     knnIndexV   (nThreads, vector<int>    (nFindMax,0));
+  vector < vector <Float_t> > knnDistV    (nThreads, vector<Float_t>(nFindMax,0));
+  vector < vector < pair<Float_t,int> > > knnQueueV(nThreads);
 
-          for(TMVA::kNN::List::const_iterator lit=knnListRef.begin(); lit!=knnListRef.end(); ++lit) {
-            const TMVA::kNN::Event & evtLst = lit->first->GetEvent();
+  double     weightSum(0);
+  TStopwatch wgtTimer;
 
-            double distNow = evtRef.GetDist(evtLst); if(distNow < EPS) continue; // the first element is the initial object (-> zero distance)
-            double wgtNow  = evtLst.GetWeight();
+  int  nObjectsToPrint = min(static_cast<int>(aChainInpEvl->GetEntries()/10.) , glob->GetOptI("nObjectsToPrint"));
+  bool breakLoop(false), mayWriteObjects(false);
+  var_0->clearCntr();
+  for(Long64_t batchEntry=0; !breakLoop; batchEntry+=nObjBatch) {
+    // -----------------------------------------------------------------------------------------------------------
+    // fill the input variables of the objects, which are later used to create TMVA::kNN::Event objects. if any of
+    // the variables is beyond the limits derived from the reference sample, the weight is automatically set to zero,
+    // with no other computation is needed
+    // -----------------------------------------------------------------------------------------------------------
+    int nObjInBatch(0);
+    for(; nObjInBatch<nObjBatch; nObjInBatch++) {
+      if(!var_0->getTreeEntry(batchEntry+nObjInBatch)) { breakLoop = true; break; }
 
-            VERIFY(LOCATION,(TString)"Found negative weight in reference sample ... Something is horribly wrong ?!?",(wgtNow > 0));
+      TMVA::kNN::VarType * objNow = &(objBatchV[nObjInBatch*nVars]);
 
-            dist_Ref0_RefNear    = distNow;
-            wgtSum_Ref0_RefNear += wgtNow;
+      statusBatchV[nObjInBatch] = 1;
+      for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
+        objNow[nVarNow] = var_0->GetForm(varFormHdlV[nVarNow]);
 
-            if(wgtSum_Ref0_RefNear >= minNobjInVolWgt) { foundDist = true; break; }
-          }
-          if(foundDist) break;
+        if(objNow[nVarNow] < minMaxVarVals[0][nVarNow] || objNow[nVarNow] > minMaxVarVals[1][nVarNow]) {
+          statusBatchV[nObjInBatch] = 0;
+          break;
         }
+      }
+    }
 
-        if(foundDist) {
-          // -----------------------------------------------------------------------------------------------------------
-          // finally, compute the weight as the relative difference beween the distance between the distance
-          // measures then compute a binary decision, based on the minimal threshold set by maxRelRatioInRef
-          // -----------------------------------------------------------------------------------------------------------
-          weightKNN = max( ((dist_Ref0_RefNear - dist_Ref_Inp) / dist_Ref0_RefNear) , 0.);
-          if(maxRelRatioInRef > 0) weightKNN = (weightKNN > maxRelRatioInRef) ? 1 : 0;
-          weightKNN = max(min(weightKNN,1.),0.);
-
-          var_0->IncCntr("Found good weight");
-          if(maxRelRatioInRef > 0) {
-            if(weightKNN > maxRelRatioInRef) var_0->IncCntr(wgtKNNname+" = 1"); else var_0->IncCntr(wgtKNNname+" = 0");
-          }
-        }
-        else {
-          // assign zero weight if could not complete the calculation
-          weightKNN = 0;
+    // -----------------------------------------------------------------------------------------------------------
+    // derive the weights of the objects in the range [nObjBegin,nObjEnd) of the batch
+    // -----------------------------------------------------------------------------------------------------------
+    auto getBatchWeights = [&](int nThreadNow, int nObjBegin, int nObjEnd) {
+      TMVA::kNN::VarVec objNowV(nVars,0);
 
-          var_0->IncCntr("Did not find good weight");
-        }
+      for(int nObjNow=nObjBegin; nObjNow<nObjEnd; nObjNow++) {
+        wgtBatchV[nObjNow] = 0;
+        if(statusBatchV[nObjNow] == 0) continue;
+
+        for(int nVarNow=0; nVarNow<nVars; nVarNow++) objNowV[nVarNow] = objBatchV[nObjNow*nVars+nVarNow];
+
+        bool foundDist(false);
+        wgtBatchV   [nObjNow] = getWeightKNN(objNowV,&(knnIndexV[nThreadNow][0]),&(knnDistV[nThreadNow][0]),&(knnQueueV[nThreadNow]),foundDist);
+        statusBatchV[nObjNow] = foundDist ? 1 : 2;
+      }
+    };
+
+    if(threadPool) {
+      int nObjThread = (nObjInBatch + nThreads - 1) / nThreads;
+      for(int nThreadNow=0; nThreadNow<nThreads; nThreadNow++) {
+        int nObjBegin = min(nThreadNow * nObjThread, nObjInBatch);
+        int nObjEnd   = min(nObjBegin  + nObjThread, nObjInBatch);
+        if(nObjBegin == nObjEnd) continue;
+
+        threadPool->push([&getBatchWeights,nThreadNow,nObjBegin,nObjEnd]() { getBatchWeights(nThreadNow,nObjBegin,nObjEnd); });
       }
+      threadPool->wait();
     }
+    else getBatchWeights(0,0,nObjInBatch);
 
-    var_1->SetVarF(wgtKNNname,weightKNN);
+    // -----------------------------------------------------------------------------------------------------------
+    // fill the output tree with the objects of the batch
+    // -----------------------------------------------------------------------------------------------------------
+    for(int nObjNow=0; nObjNow<nObjInBatch; nObjNow++) {
+      bool hasEntry = var_0->getTreeEntry(batchEntry+nObjNow);
+      VERIFY(LOCATION,(TString)"Could not re-read entry of "+aChainInpEvl->GetName()+" ... Something is horribly wrong ?!?",hasEntry);
+
+      if(mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) {
+        var_0->printCntr(outTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
+        var_1->setTreeWrite(outputs->TreeMap[outTreeName]);
+        mayWriteObjects = false;
+      }
+      else if(var_0->GetCntr("nObj") % nObjectsToPrint == 0) { var_0->printCntr(outTreeName); }
+
+      var_1->copyVarData(var_0,&varTypeNameV);
+
+      double weightKNN = wgtBatchV[nObjNow];
+
+      if(statusBatchV[nObjNow] == 0) {
+        var_0->IncCntr(wgtKNNname+" = 0 (outside input parameter range)");
+      }
+      else if(statusBatchV[nObjNow] == 1) {
+        var_0->IncCntr("Found good weight");
+
+        if(doRelWgts) weightSum += weightKNN;
+        else if(maxRelRatioInRef > 0) {
+          if(weightKNN > maxRelRatioInRef) var_0->IncCntr(wgtKNNname+" = 1"); else var_0->IncCntr(wgtKNNname+" = 0");
+        }
+      }
+      else {
+        var_0->IncCntr("Did not find good weight");
+      }
+
+      var_1->SetVarF(wgtKNNhdl,weightKNN);
 
-    var_1->fillTree();
+      var_1->fillTree();
 
-    mayWriteObjects = true; var_0->IncCntr("nObj"); /// Cant use this here !!! if(var_0->GetCntr("nObj") == maxNobj) breakLoop = true;
+      mayWriteObjects = true; var_0->IncCntr("nObj"); /// Cant use this here !!! if(var_0->GetCntr("nObj") == maxNobj) breakLoop = true;
+    }
   }
-  if(!breakLoop) { var_0->printCntr(outTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
+  var_0->printCntr(outTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
+
+  // write the remaining output (and restore the original output tree) before using the output files
+  outputs->EndTreeLoop(); var_1->setTreeWrite(outTree);
+
+  wgtTimer.Stop();
+  aLOG(Log::INFO) <<coutGreen<<" - derived the weights of "<<coutYellow<<var_0->GetCntr("nObj")<<coutGreen<<" objects in "
+                  <<coutYellow<<TString::Format("%3.3g",wgtTimer.RealTime())<<coutGreen<<" sec ("<<coutYellow
+                  <<TString::Format("%3.3g",var_0->GetCntr("nObj")/max(wgtTimer.RealTime(),EPS))<<coutGreen<<" objects/sec) ..."<<coutDef<<endl;
+
+  DELNULL(threadPool);
+  objBatchV.clear(); wgtBatchV.clear(); statusBatchV.clear(); knnIndexV.clear(); knnDistV.clear(); knnQueueV.clear();
   
   DELNULL(var_0); DELNULL(var_1); DELNULL(outTree); outputs->TreeMap.erase(outTreeName);
   varTypeNameV.clear();
@@ -872,6 +983,8 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
     outTree = new TTree(outTreeName,outTreeName); outTree->SetDirectory(0); outputs->TreeMap[outTreeName] = outTree;
     var_1->createTreeBranches(outTree); 
 
+    outputs->BeginTreeLoop();
+
     // -----------------------------------------------------------------------------------------------------------
     // loop on the tree
     // -----------------------------------------------------------------------------------------------------------
@@ -882,6 +995,7 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
 
       if((mayWriteObjects && var_0->GetCntr("nObj") % nObjectsToWrite == 0) || breakLoop) {
         var_0->printCntr(outTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects();
+        var_1->setTreeWrite(outputs->TreeMap[outTreeName]);
         mayWriteObjects = false;
       }
       if(breakLoop) break;
@@ -897,6 +1011,8 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
     }
     if(!breakLoop) { var_0->printCntr(outTreeName); outputs->WriteOutObjects(false,true); outputs->ResetObjects(); }
 
+    outputs->EndTreeLoop(); var_1->setTreeWrite(outTree);
+
     DELNULL(var_1); DELNULL(outTree); outputs->TreeMap.erase(outTreeName);
     varTypeNameV.clear();
 
@@ -1068,6 +1184,8 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
 
   for(int nChainNow=0; nChainNow<2; nChainNow++) {
     for(int nFracNow=0; nFracNow<nKnnFracs; nFracNow++) {
+      // the kd-tree refers to the events of the module, which is owned by the factory
+      DELNULL(knnKdTree[nChainNow][nFracNow]);
       DELNULL(knnErrFactory[nChainNow][nFracNow]);
       DELNULL(knnErrOutFile[nChainNow][nFracNow]);
 
@@ -1081,9 +1199,9 @@ void CatFormat::addWgtKNNtoTree(TChain * aChainInp, TChain * aChainRef, TChain *
   }
   utils->safeRM(outFileDirKnnErrV,inLOG(Log::DEBUG));
 
-  knnErrOutFile.clear(); knnErrFactory.clear(); knnErrDataLdr.clear(); knnErrMethod.clear(); knnErrModule.clear(); aChainV.clear();
+  knnErrOutFile.clear(); knnErrFactory.clear(); knnErrDataLdr.clear(); knnErrMethod.clear(); knnErrModule.clear(); knnKdTree.clear(); aChainV.clear();
   minMaxVarVals.clear(); outFileNameKnnErr.clear(); varNames.clear(); chainWgtV.clear(); chainCutV.clear();
-  varFormNames.clear(); objNowV.clear(); distV.clear(); weightSumV.clear(); distIndexV.clear();
+  varFormNames.clear();
   chainEntV.clear(); varNamesScaled.clear();
 
   for(int nChainNow=0; nChainNow<2; nChainNow++) { for(int nVarNow=0; nVarNow<nVars; nVarNow++) { DELNULL(hisVarV[nChainNow][nVarNow]); } }
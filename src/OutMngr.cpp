@@ -45,6 +45,17 @@ OutMngr::OutMngr(TString aName, Utils * aUtils, OptMaps * aMaps) {
   utils = aUtils;
   draw  = new OptMaps("draw");
 
+  // optional tag added to the names of tree files (e.g., to distinguish between the outputs of different threads)
+  treeFileTag = "";
+
+  // the format of the output trees, and the writing of trees in loops (see BeginTreeLoop())
+  treeFormat.Set(glob->OptOrNullC("treeCompress"),glob->OptOrNullI("treeBasketKB"),glob->OptOrNullI("treeFileMB"),
+                 glob->OptOrNullI("nObjectsToWrite"));
+
+  isTreeLoop  = mayMergeFiles = false;
+  treeWriter  = NULL;
+  writeBytes  = writeDiskBytes = 0; writeSec = 0;
+
 	SetMyStyle();
   TH1::SetDefaultSumw2(true); 
 	BaseDir = gDirectory->CurrentDirectory();
@@ -55,6 +66,7 @@ OutMngr::OutMngr(TString aName, Utils * aUtils, OptMaps * aMaps) {
 // ===========================================================================================================
 OutMngr::~OutMngr() {
 // ==============================
+  EndTreeLoop();
   DELNULL(draw);
   titleV.clear(); nameMap.clear(); titleMap.clear(); fitParMap.clear();
 }
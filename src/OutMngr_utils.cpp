@@ -81,15 +81,10 @@ void OutMngr::WriteOutObjects(bool writePdfScripts, bool dontWriteHis) {
     if(!dynamic_cast<TTree*>(TreeMap[hisName])) continue;
     if(TreeMap[hisName]->GetEntries() < 1)      continue;
 
-    OutputTreeFileIndex++;
-    outputRootFileName = (TString)outDirName+hisName+"_"+TString::Format("%1.5d",OutputTreeFileIndex)+".root";
-    OutputRootFile = new TFile(outputRootFileName,"RECREATE");
+    // within BeginTreeLoop(), successive batches may be kept in memory until the target file size is reached
+    if(holdTree(hisName)) continue;
 
-    if(dynamic_cast<TChain*>(TreeMap[hisName])) ((TChain*)TreeMap[hisName])->Merge(outputRootFileName);
-    else                                                  TreeMap[hisName] ->Write();
-    
-    OutputRootFile->Close();  DELNULL(OutputRootFile);
-    aLOG(Log::DEBUG) << coutCyan<<" - Wrote tree to: "<<coutPurple<<outputRootFileName<<coutDef<<endl;
+    writeTree(hisName);
   }
 
   if(writePdfScripts) {
@@ -292,6 +287,7 @@ void OutMngr::ResetObjects() {
   for(int hisNow = 0; hisNow < numHis; hisNow++ , ++TreeMapItr) {
     TString hisName = (TString)(*TreeMapItr).first;
     if(glob->OptOrNullB((TString)"NoReset_"+hisName)) continue;
+    if(heldTreeS.find(hisName) != heldTreeS.end())    continue;
     if((*TreeMapItr).second != NULL) TreeMap[hisName]->Reset();
   }  
   
@@ -299,6 +295,282 @@ void OutMngr::ResetObjects() {
   return;
 }
 
+// ===========================================================================================================
+/**
+ * @brief                 - Start a loop which writes trees in batches (of nObjectsToWrite objects), using
+ *                        WriteOutObjects() and ResetObjects(). EndTreeLoop() must be called after the last
+ *                        batch has been passed to WriteOutObjects(), and before the output files are used.
+ * 
+ * @details               - The compression of the output files is set by treeCompressFinal (for the final
+ *                        output of the evaluation) or by treeCompress (otherwise), see TreeFormat.
+ *                        - If treeFileMB is positive (and mayMergeFilesIn is set), WriteOutObjects() keeps a
+ *                        tree in memory (and ResetObjects() does not reset it) until its uncompressed size
+ *                        reaches treeFileMB. Successive batches are thus written to the same file, in order.
+ *                        - If asyncTreeWrite is set (and ROOT supports multi-threading), each tree which is
+ *                        written by WriteOutObjects() is passed to a background thread, which writes it to the
+ *                        same file as would otherwise have been used, and then resets it. The tree in TreeMap is
+ *                        replaced by a second buffer, which is created once (by cloning the original tree,
+ *                        including the branch addresses), so that the loop may continue to fill the next batch.
+ *                        The two buffers are then alternated; if the previous batch has not been written yet,
+ *                        WriteOutObjects() waits for it, so that at most one batch per tree is pending at any time.
+ *                        Since the tree in TreeMap changes after each call to WriteOutObjects(), a VarMaps which
+ *                        fills the tree must be updated with the new pointer (see VarMaps::setTreeWrite()).
+ * 
+ * @param isFinal         - Whether the trees are the final output of the evaluation.
+ * @param mayMergeFilesIn - Whether batches may be merged into one file (should be false if the caller sets
+ *                        OutputTreeFileIndex for each batch).
+ */
+// ===========================================================================================================
+void OutMngr::BeginTreeLoop(bool isFinal, bool mayMergeFilesIn) {
+// ==============================================================
+  EndTreeLoop();
+
+  isTreeLoop    = true;
+  mayMergeFiles = mayMergeFilesIn;
+  writeBytes    = writeDiskBytes = 0; writeSec = 0;
+  heldTreeS.clear(); writeFileV.clear();
+
+  treeFormat.SetCompress(glob->OptOrNullC(isFinal ? "treeCompressFinal" : "treeCompress"));
+
+  if(glob->OptOrNullB("asyncTreeWrite") && ThreadPool::enableThreadSafety()) {
+    treeWriter = new ThreadPool(1);
+    aLOG(Log::DEBUG_1) <<coutBlue<<" - started the background tree-writer of OutMngr ... "<<coutDef<<endl;
+  }
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - End a loop started by BeginTreeLoop(): write the trees which were held back for the target file size,
+ *         wait for all of the pending writes, restore the original trees in TreeMap, delete the second buffers,
+ *         and write the statistics of the output files to the log.
+ *
+ * @details - The trees in TreeMap which were not held back must be empty at this point (i.e., the last batch must
+ *          have been passed to WriteOutObjects() and to ResetObjects()).
+ */
+// ===========================================================================================================
+void OutMngr::EndTreeLoop() {
+// ==========================
+  if(!isTreeLoop) return;
+
+  mayMergeFiles = false;
+
+  vector <TString> heldTreeV(heldTreeS.begin(),heldTreeS.end());
+  for(int nTreeNow=0; nTreeNow<(int)heldTreeV.size(); nTreeNow++) {
+    TString treeName = heldTreeV[nTreeNow];
+    if(TreeMap.find(treeName) == TreeMap.end() || !dynamic_cast<TTree*>(TreeMap[treeName])) continue;
+    if(TreeMap[treeName]->GetEntries() < 1) continue;
+
+    TTree * tree = TreeMap[treeName];
+    bool    isAsync(treeWriter);
+
+    writeTree(treeName);
+    if(!isAsync) tree->Reset();
+  }
+  heldTreeS.clear(); heldTreeV.clear();
+
+  if(treeWriter) {
+    treeWriter->wait(); DELNULL(treeWriter);
+
+    for(map < TString , TTree * >::iterator itr = treeOrigM.begin(); itr != treeOrigM.end(); ++itr) {
+      TString treeName = itr->first;
+
+      if(TreeMap.find(treeName) != TreeMap.end() && TreeMap[treeName] == treeCloneM[treeName]) {
+        VERIFY(LOCATION,(TString)"Stopping the background tree-writer with entries which were not written for tree \""
+                                +treeName+"\" ... Something is horribly wrong ?!?",(TreeMap[treeName]->GetEntries() == 0));
+
+        TreeMap[treeName] = treeOrigM[treeName];
+      }
+      DELNULL(treeCloneM[treeName]);
+    }
+    treeOrigM.clear(); treeCloneM.clear(); treeFreeM.clear();
+
+    aLOG(Log::DEBUG_1) <<coutBlue<<" - stopped the background tree-writer of OutMngr ... "<<coutDef<<endl;
+  }
+
+  printWriteStats();
+
+  isTreeLoop = false; writeFileV.clear();
+  treeFormat.SetCompress(glob->OptOrNullC("treeCompress"));
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief            - Check if a tree should be kept in memory by WriteOutObjects() (see BeginTreeLoop()).
+ * 
+ * @param treeName   - The name of the tree in TreeMap.
+ *
+ * @return           - Whether the tree is held back.
+ */
+// ===========================================================================================================
+bool OutMngr::holdTree(TString treeName) {
+// =======================================
+  bool mayHold = (  isTreeLoop && mayMergeFiles && treeFormat.GetFileBytes() > 0
+                 && !dynamic_cast<TChain*>(TreeMap[treeName]) && !glob->OptOrNullB((TString)"NoReset_"+treeName));
+
+  if(mayHold && TreeFormat::GetTreeBytes(TreeMap[treeName]) < treeFormat.GetFileBytes()) {
+    heldTreeS.insert(treeName);
+    return true;
+  }
+
+  heldTreeS.erase(treeName);
+  return false;
+}
+
+// ===========================================================================================================
+/**
+ * @brief            - Write a tree from TreeMap to the next output file (directly, or by the background writer).
+ * 
+ * @param treeName   - The name of the tree in TreeMap.
+ */
+// ===========================================================================================================
+void OutMngr::writeTree(TString treeName) {
+// ========================================
+  OutputTreeFileIndex++;
+  outputRootFileName = (TString)outDirName+treeName+treeFileTag+"_"+TString::Format("%1.5d",OutputTreeFileIndex)+".root";
+
+  // with BeginTreeLoop(), the tree is written on the background thread, while the next batch is filled
+  if(treeWriter && !dynamic_cast<TChain*>(TreeMap[treeName]) && !glob->OptOrNullB((TString)"NoReset_"+treeName)) {
+    writeTreeAsync(treeName,outputRootFileName);
+    return;
+  }
+
+  writeTreeFile(TreeMap[treeName],outputRootFileName,treeFormat.GetCompress());
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief            - Pass a tree from TreeMap to the background writer, and replace it with the second buffer.
+ * 
+ * @param treeName   - The name of the tree in TreeMap.
+ * @param fileName   - The name of the output file.
+ */
+// ===========================================================================================================
+void OutMngr::writeTreeAsync(TString treeName, TString fileName) {
+// ===============================================================
+  TTree * treeFull = TreeMap[treeName];
+  TTree * treeNext = NULL;
+  {
+    std::unique_lock<std::mutex> lock(treeBufMutex);
+
+    // the first time this tree is written, create the second buffer, which shares the branch addresses
+    if(treeOrigM.find(treeName) == treeOrigM.end()) {
+      treeOrigM [treeName] = treeFull;
+      treeCloneM[treeName] = treeFull->CloneTree(0);
+      treeCloneM[treeName]->SetDirectory(treeFull->GetDirectory());
+      treeFreeM [treeName] = true;
+    }
+
+    // wait until the previous batch of this tree has been written
+    treeBufCond.wait(lock,[&]{ return treeFreeM[treeName]; });
+    treeFreeM[treeName] = false;
+
+    treeNext = (treeFull == treeOrigM[treeName]) ? treeCloneM[treeName] : treeOrigM[treeName];
+  }
+  TreeMap[treeName] = treeNext;
+
+  int compress = treeFormat.GetCompress();
+  treeWriter->push([this,treeName,treeFull,fileName,compress]() {
+    writeTreeFile(treeFull,fileName,compress);
+    treeFull->Reset();
+
+    {
+      std::unique_lock<std::mutex> lock(treeBufMutex);
+      treeFreeM[treeName] = true;
+    }
+    treeBufCond.notify_all();
+  });
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief            - Write a tree (or merge a chain) into a new file, and add to the statistics of the
+ *                   written files.
+ * 
+ * @param tree       - The tree.
+ * @param fileName   - The name of the output file.
+ * @param compress   - The compression settings (see TreeFormat), or -1 for the default of ROOT.
+ */
+// ===========================================================================================================
+void OutMngr::writeTreeFile(TTree * tree, TString fileName, int compress) {
+// ========================================================================
+  TStopwatch writeTimer;
+  Long64_t   treeBytes = TreeFormat::GetTreeBytes(tree);
+
+  TFile * outFile = new TFile(fileName,"RECREATE");
+  if(compress >= 0) outFile->SetCompressionSettings(compress);
+
+  if(dynamic_cast<TChain*>(tree)) ((TChain*)tree)->Merge(fileName);
+  else                                      tree ->Write();
+
+  outFile->Close();
+  Long64_t diskBytes = outFile->GetBytesWritten();
+  DELNULL(outFile);
+
+  writeTimer.Stop();
+
+  if(isTreeLoop) {
+    std::unique_lock<std::mutex> lock(treeBufMutex);
+    writeBytes += treeBytes; writeDiskBytes += diskBytes; writeSec += writeTimer.RealTime();
+    writeFileV.push_back(pair<TString,TString>(tree->GetName(),fileName));
+  }
+
+  aLOG(Log::DEBUG) << coutCyan<<" - Wrote tree to: "<<coutPurple<<fileName<<coutDef<<endl;
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - Write to the log the statistics of the files written in a loop started by BeginTreeLoop(). If
+ *         benchTreeIO is set, all of the entries of the files are also read back, and the read rate is logged.
+ */
+// ===========================================================================================================
+void OutMngr::printWriteStats() {
+// ==============================
+  int nFiles = (int)writeFileV.size();
+  if(nFiles == 0) return;
+
+  bool          doBench  = glob->OptOrNullB("benchTreeIO");
+  Log::LOGtypes logLevel = doBench ? Log::INFO : Log::DEBUG;
+  double        MB       = 1024. * 1024.;
+
+  aLOG(logLevel) <<coutCyan<<" - Wrote "<<coutYellow<<nFiles<<coutCyan<<" files of "<<coutGreen<<writeFileV[0].first<<coutCyan<<" ("
+                 <<coutYellow<<TString::Format("%.1f",writeBytes/MB)<<coutCyan<<" MB uncompressed, "<<coutYellow
+                 <<TString::Format("%.1f",writeDiskBytes/MB)<<coutCyan<<" MB on disk) at "<<coutYellow
+                 <<TString::Format("%.1f",writeBytes/MB/max(writeSec,EPS))<<coutCyan<<" MB/s ..."<<coutDef<<endl;
+
+  if(!doBench) return;
+
+  // read back all of the entries, as would be done by a later loop over a chain of the output files
+  TStopwatch readTimer;
+  Long64_t   readBytes(0), readDiskBytes(0);
+  for(int nFileNow=0; nFileNow<nFiles; nFileNow++) {
+    TFile * inFile = TFile::Open(writeFileV[nFileNow].second,"READ");
+    if(!inFile || inFile->IsZombie()) { DELNULL(inFile); continue; }
+
+    TTree * inTree = dynamic_cast<TTree*>(inFile->Get(writeFileV[nFileNow].first));
+    if(inTree) {
+      for(Long64_t entryNow=0; entryNow<inTree->GetEntries(); entryNow++) readBytes += inTree->GetEntry(entryNow);
+    }
+    readDiskBytes += inFile->GetBytesRead();
+
+    inFile->Close(); DELNULL(inFile);
+  }
+  readTimer.Stop();
+
+  aLOG(logLevel) <<coutCyan<<" - Read back "<<coutYellow<<TString::Format("%.1f",readBytes/MB)<<coutCyan<<" MB uncompressed ("
+                 <<coutYellow<<TString::Format("%.1f",readDiskBytes/MB)<<coutCyan<<" MB from disk) at "<<coutYellow
+                 <<TString::Format("%.1f",readBytes/MB/max(readTimer.RealTime(),EPS))<<coutCyan<<" MB/s ..."<<coutDef<<endl;
+
+  return;
+}
+
 // ===========================================================================================================
 void OutMngr::optClear() {
 // =======================
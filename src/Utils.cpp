@@ -17,6 +17,10 @@
 // ===========================================================================================================
 
 #include "Utils.hpp"
+#include "Utils_quantSketch.cpp"
+#include "Utils_kdTree.cpp"
+#include "Utils_binLookup.cpp"
+#include "Utils_treeFormat.cpp"
 
 // ===========================================================================================================
 // namespace for fitting functions
@@ -799,6 +803,45 @@ vector <TTree*> Utils::getTreeFriends(TTree * tree) {
   return chainFriendV;
 };
 
+// ===========================================================================================================
+/**
+ * @brief             - Create a new chain with the same name and files as the input chain, which may be
+ *                    used independently of the original (e.g., by a different thread).
+ *
+ * @param chain       - The original chain.
+ * @param addFriends  - Whether to (recursively) clone and add the friends of the original chain, using
+ *                    the same friend-names.
+ *
+ * @return            - The new chain (owned by the caller, including any friends).
+ */
+// ===========================================================================================================
+TChain * Utils::cloneChain(TChain * chain, bool addFriends) {
+// =========================================================
+  VERIFY(LOCATION,(TString)"Trying to use cloneChain() with invalid chain",dynamic_cast<TChain*>(chain));
+
+  TChain * chainOut = new TChain(chain->GetName(),chain->GetTitle());
+  chainOut->SetDirectory(0);
+
+  TObjArray * fileElements = chain->GetListOfFiles();
+  for(int nFileNow=0; nFileNow<fileElements->GetEntries(); nFileNow++) {
+    TChainElement * chainEle = (TChainElement*)fileElements->At(nFileNow);
+    chainOut->Add(chainEle->GetTitle(),chainEle->GetEntries());
+  }
+
+  if(addFriends && dynamic_cast<TList*>(chain->GetListOfFriends())) {
+    TIter friendItr(chain->GetListOfFriends());
+    while(TFriendElement * friendEle = (TFriendElement*)friendItr()) {
+      TChain * chainFriend = dynamic_cast<TChain*>(friendEle->GetTree());
+      VERIFY(LOCATION,(TString)"cloneChain() only supports friends which are chains (found "
+                              +friendEle->GetName()+") ...",chainFriend);
+
+      chainOut->AddFriend(cloneChain(chainFriend,true),friendEle->GetName());
+    }
+  }
+
+  return chainOut;
+}
+
 // ===========================================================================================================
 void Utils::getSetActiveTreeBranches(TTree * tree, vector < pair<TString,bool> > & branchNameStatusV, TString getSet, bool verbose) {
 // ==================================================================================================================================
@@ -917,6 +960,30 @@ void Utils::getTreeBranchNames(TTree * tree, vector <TString> & branchNameV) {
   return;
 }
 
+// ===========================================================================================================
+// a string which identifies the files of a chain, using the name, the size and the modification time of each
+// file, so that it changes whenever any of the files is replaced (used as part of the keys of cache files)
+// ===========================================================================================================
+TString Utils::getChainFileStamp(TChain * chain) {
+// ===============================================
+  VERIFY(LOCATION,(TString)"Trying to use getChainFileStamp() with invalid chain" , dynamic_cast<TChain*>(chain));
+
+  TString stamp = (TString)"[__CHAIN__]"+chain->GetName();
+
+  TObjArray * fileElements = chain->GetListOfFiles();
+  for(int nFileNow=0; nFileNow<fileElements->GetEntries(); nFileNow++) {
+    TString    fileName = ((TChainElement*)fileElements->At(nFileNow))->GetTitle();
+    FileStat_t fileStat;
+
+    stamp += (TString)"[__FILE__]"+fileName;
+    if(gSystem->GetPathInfo(fileName,fileStat) == 0) {
+      stamp += (TString)";"+lIntToStr(fileStat.fSize)+";"+lIntToStr(fileStat.fMtime);
+    }
+  }
+
+  return stamp;
+}
+
 // ===========================================================================================================
 void Utils::copyTreeUserInfo(TTree * inTree, TTree * outTree, bool debug) {
 // ========================================================================
@@ -1076,6 +1143,31 @@ void Utils::flushHisBufferBinsZ(TH1 * his, int nBinsZ) {
   return;
 }
 
+// ===========================================================================================================
+/**
+ * @brief      - Fill a histogram bin which is already known (e.g., from a BinLookup), without the bin search of TH1::Fill().
+ *
+ * @details    - The content, the sum of squared weights (if Sumw2 is active) and the number of entries are updated as
+ *             in TH1::Fill(). The other statistics (sums of weight times the value, etc.) are not updated, and are
+ *             therefore recomputed by ROOT from the bin contents, if requested.
+ *
+ * @param his  - The histogram.
+ * @param nBin - The global bin number (e.g., his->GetBin(nBinX,nBinY) for a 2D histogram).
+ * @param wgt  - The weight to add.
+ */
+// ===========================================================================================================
+void Utils::fillHisBin(TH1 * his, int nBin, double wgt) {
+// ======================================================
+  // values which are kept in the buffer of the histogram are only binned on BufferEmpty()
+  if(his->GetBuffer()) his->BufferEmpty(1);
+
+  his->AddBinContent(nBin,wgt);
+  if(his->GetSumw2N() > 0) his->GetSumw2()->fArray[nBin] += wgt * wgt;
+  his->SetEntries(his->GetEntries() + 1);
+
+  return;
+}
+
 // ===========================================================================================================
 void Utils::doPolyFit(TNamed * inputObject, map < TString , double > * fitParMap, TString theFunc) {
 // ===================================================================================================
@@ -1479,6 +1571,13 @@ int Utils::getQuantileV(vector <double> & fracV, vector <double> & quantV, doubl
 int Utils::getQuantileV(vector <double> & fracV, vector <double> & quantV, TH1    * dataHis) {
   return getQuantileV(fracV,quantV,NULL,dataHis);
 }
+int Utils::getQuantileV(vector <double> & fracV, vector <double> & quantV, QuantSketch * dataSketch) {
+  int nQuant = (int)fracV.size();
+  if(nQuant == 0 || !dataSketch || dataSketch->GetSumW() < EPS) return 0;
+
+  quantV.resize(nQuant);
+  return dataSketch->GetQuantiles(nQuant,&(quantV[0]),&(fracV[0]));
+}
 // -----------------------------------------------------------------------------------------------------------
 int Utils::getQuantileV(vector <double> & fracV, vector <double> & quantV, vector <double> & dataArrV) {
 // =====================================================================================================
@@ -1519,8 +1618,149 @@ int Utils::getQuantileV(vector <double> & fracV, vector <double> & quantV, doubl
   return 1;
 }
 // ===========================================================================================================
-int Utils::getInterQuantileStats(double * dataArr) { return getInterQuantileStats(dataArr,NULL); }
-int Utils::getInterQuantileStats(TH1    * dataHis) { return getInterQuantileStats(NULL,dataHis); }
+
+// ===========================================================================================================
+/**
+ * @brief         - Compute quantiles of an array using partial sorting (std::nth_element), instead of
+ *                a full sort or histogram binning.
+ *
+ * @details       - The result is identical to that of TMath::Quantiles() with type 7 (linear interpolation
+ *                between the two nearest order statistics). Quantiles are found in increasing order of
+ *                fracV, so that each partial sort only covers the part of the array above the previous one.
+ *                The input array is reordered in place.
+ *
+ * @param fracV   - The (cumulative) fractions for which to compute quantiles.
+ * @param quantV  - The derived quantiles, in the same order as fracV.
+ * @param dataV   - The data array (modified).
+ *
+ * @return        - 1 on success, 0 if the array (or fracV) is empty.
+ */
+// ===========================================================================================================
+int Utils::getQuantileNth(vector <double> & fracV, vector <double> & quantV, vector <double> & dataV) {
+// ====================================================================================================
+  int nQuant = (int)fracV.size();
+  int nData  = (int)dataV.size();
+  if(nQuant == 0 || nData == 0) return 0;
+
+  vector <int> fracOrderV(nQuant);
+  for(int nQuantNow=0; nQuantNow<nQuant; nQuantNow++) fracOrderV[nQuantNow] = nQuantNow;
+  std::sort(fracOrderV.begin(),fracOrderV.end(),[&fracV](int a, int b){ return (fracV[a] < fracV[b]); });
+
+  quantV.resize(nQuant);
+
+  int nSortedMin(0);
+  for(int nOrderNow=0; nOrderNow<nQuant; nOrderNow++) {
+    int    nQuantNow = fracOrderV[nOrderNow];
+    double posNow    = min(max(fracV[nQuantNow],0.),1.) * (nData - 1);
+    int    indexLow  = static_cast<int>(floor(posNow));
+    double fracHigh  = posNow - indexLow;
+
+    // after nth_element, all elements above indexLow are not smaller than dataV[indexLow], so that
+    // the next order statistic is the minimal element of the upper part of the array
+    std::nth_element(dataV.begin() + nSortedMin, dataV.begin() + indexLow, dataV.end());
+
+    double valLow(dataV[indexLow]), valHigh(valLow);
+    if(fracHigh > 0 && indexLow + 1 < nData) valHigh = *std::min_element(dataV.begin() + indexLow + 1, dataV.end());
+
+    quantV[nQuantNow] = valLow + fracHigh * (valHigh - valLow);
+    nSortedMin        = indexLow;
+  }
+
+  fracOrderV.clear();
+  return 1;
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Compute exact quantiles of a weighted array.
+ *
+ * @details       - Each entry is placed at the cumulative weight of its centre, and quantiles are derived by
+ *                linear interpolation between the two nearest entries, where the fractions span the range between
+ *                the centres of the first and last entries. For equal weights, this is identical to getQuantileNth()
+ *                (and to TMath::Quantiles() with type 7). Entries with non-positive weights are ignored.
+ *
+ * @param fracV   - The (cumulative) fractions for which to compute quantiles.
+ * @param quantV  - The derived quantiles, in the same order as fracV.
+ * @param dataV   - The data array, as pairs of (value, weight) (sorted in place).
+ *
+ * @return        - 1 on success, 0 if the array (or fracV) is empty, or if the sum of weights vanishes.
+ */
+// ===========================================================================================================
+int Utils::getQuantileWgt(vector <double> & fracV, vector <double> & quantV, vector < pair<double,double> > & dataV) {
+// ==================================================================================================================
+  int nQuant = (int)fracV.size();
+  if(nQuant == 0) return 0;
+
+  std::sort(dataV.begin(),dataV.end());
+
+  // the cumulative weight at the centre of each entry
+  vector <double> valV, wgtMidV;
+  double          wgtSoFar(0);
+  for(int nEleNow=0; nEleNow<(int)dataV.size(); nEleNow++) {
+    double valNow(dataV[nEleNow].first), wgtNow(dataV[nEleNow].second);
+    if(!(wgtNow > 0) || valNow != valNow) continue;
+
+    valV   .push_back(valNow);
+    wgtMidV.push_back(wgtSoFar + 0.5 * wgtNow);
+    wgtSoFar += wgtNow;
+  }
+
+  int nData = (int)valV.size();
+  if(nData == 0 || wgtSoFar < EPS) return 0;
+
+  quantV.resize(nQuant);
+  for(int nQuantNow=0; nQuantNow<nQuant; nQuantNow++) {
+    double probNow = min(max(fracV[nQuantNow],0.),1.);
+    double wgtNow  = wgtMidV[0] + probNow * (wgtMidV[nData-1] - wgtMidV[0]);
+
+    int nEleHigh = (int)(std::upper_bound(wgtMidV.begin(),wgtMidV.end(),wgtNow) - wgtMidV.begin());
+    if     (nEleHigh <= 0    ) { quantV[nQuantNow] = valV[0];       continue; }
+    else if(nEleHigh >= nData) { quantV[nQuantNow] = valV[nData-1]; continue; }
+
+    int    nEleLow  = nEleHigh - 1;
+    double fracHigh = (wgtNow - wgtMidV[nEleLow]) / (wgtMidV[nEleHigh] - wgtMidV[nEleLow]);
+
+    quantV[nQuantNow] = valV[nEleLow] + fracHigh * (valV[nEleHigh] - valV[nEleLow]);
+  }
+
+  valV.clear(); wgtMidV.clear();
+  return 1;
+}
+// ===========================================================================================================
+/**
+ * @brief        - Get a random number distributed according to the content of a histogram, using a given
+ *               random number generator. This follows TH1::GetRandom(), which always uses gRandom, and so
+ *               is not reproducible if several threads sample at the same time.
+ *
+ * @details      - The cumulative integral of the histogram (TH1::ComputeIntegral()) is computed on the first
+ *               call. If the histogram is to be shared between threads, ComputeIntegral() should therefore
+ *               be called once in advance, and the histogram should not be modified afterwards.
+ *
+ * @param his    - The input histogram.
+ * @param rndIn  - The random number generator.
+ */
+// ===========================================================================================================
+double Utils::getRndFromHis(TH1 * his, TRandom * rndIn) {
+// ======================================================
+  int      nBinsX   = his->GetNbinsX();
+  double * integral = his->GetIntegral();
+  if(!integral || integral[nBinsX] < EPS) return 0;
+
+  double rndNow = rndIn->Rndm();
+  int    binNow = TMath::BinarySearch(nBinsX,integral,rndNow);
+  double valOut = his->GetBinLowEdge(binNow+1);
+
+  if(rndNow > integral[binNow]) {
+    valOut += his->GetBinWidth(binNow+1) * (rndNow - integral[binNow]) / (integral[binNow+1] - integral[binNow]);
+  }
+
+  return valOut;
+}
+
+// ===========================================================================================================
+int Utils::getInterQuantileStats(double      * dataArr)    { return getInterQuantileStats(dataArr,NULL);      }
+int Utils::getInterQuantileStats(TH1         * dataHis)    { return getInterQuantileStats(NULL,dataHis);      }
+int Utils::getInterQuantileStats(QuantSketch * dataSketch) { return getInterQuantileStats(NULL,NULL,dataSketch); }
 // -----------------------------------------------------------------------------------------------------------
 int Utils::getInterQuantileStats(vector <double> & dataArrV) {
 // ===========================================================
@@ -1528,8 +1768,8 @@ int Utils::getInterQuantileStats(vector <double> & dataArrV) {
   return getInterQuantileStats(dataArrV.data(),NULL);
 }
 // -----------------------------------------------------------------------------------------------------------
-int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis) {
-// ================================================================
+int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis, QuantSketch * dataSketch) {
+// ===========================================================================================
   if(!param->HasOptI("nArrEntries")) param->NewOptI("nArrEntries" , 0);
 
   bool hasArr = (dataArr != NULL);
@@ -1539,7 +1779,13 @@ int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis) {
     dataHis->BufferEmpty();
     hasHis = (dataHis->GetEntries() > EPS && dataHis->Integral() > EPS);
   }
-  if(!hasArr && !hasHis) return 0;
+  bool hasSketch = (dataSketch != NULL);
+  if(hasSketch) { hasSketch = (dataSketch->GetEntries() > EPS && dataSketch->GetSumW() > EPS); }
+  if(!hasArr && !hasHis && !hasSketch) return 0;
+
+  // for a sketch, the centroids are used in place of the bins of a histogram
+  vector < pair<double,double> > cntrV;
+  if(hasSketch) dataSketch->GetCentroids(cntrV);
   
   if(param->OptOrNullB("doFracLargerSigma"))  param->NewOptB("doNotComputeNominalParams" , false);
 
@@ -1557,8 +1803,9 @@ int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis) {
   probQuant[3] = 0.49; probQuant[4] = 0.50; probQuant[5] = 0.51;
   probQuant[6] = 0.83; probQuant[7] = 0.84; probQuant[8] = 0.85;
 
-  if(hasHis) dataHis->GetQuantiles(nQuant,quantiles,probQuant);
-  else       TMath::Quantiles(param->GetOptI("nArrEntries"),nQuant,dataArr,quantiles,probQuant,false,sortIndices,7);
+  if     (hasHis)    dataHis   ->GetQuantiles(nQuant,quantiles,probQuant);
+  else if(hasSketch) dataSketch->GetQuantiles(nQuant,quantiles,probQuant);
+  else               TMath::Quantiles(param->GetOptI("nArrEntries"),nQuant,dataArr,quantiles,probQuant,false,sortIndices,7);
 
   double quantile_16  = quantiles[1];
   double quantile_84  = quantiles[7];
@@ -1585,6 +1832,12 @@ int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis) {
       meanErr   = dataHis->GetMeanError();
       sigmaErr  = dataHis->GetRMSError();
     }
+    else if(hasSketch) {
+      mean      = dataSketch->GetMean();
+      sigma     = dataSketch->GetRMS();
+      meanErr   = dataSketch->GetMeanError();
+      sigmaErr  = dataSketch->GetRMSError();
+    }
     else {
       mean      = TMath::Mean(param->GetOptI("nArrEntries"),dataArr,NULL);
       sigma     = TMath::RMS (param->GetOptI("nArrEntries"),dataArr);
@@ -1615,6 +1868,25 @@ int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis) {
 
       dataHis->GetXaxis()->SetRangeUser(origMinX,origMaxX);
     }
+    else if(hasSketch) {
+      double outlierDist = param->GetOptF("meanWithoutOutliers")*sig68;
+      double sumWin(0), sumWXin(0), sumWX2in(0);
+
+      for(int nCntrNow=0; nCntrNow<(int)cntrV.size(); nCntrNow++) {
+        if(fabs(cntrV[nCntrNow].first - median) > outlierDist) continue;
+
+        sumWin   += cntrV[nCntrNow].second;
+        sumWXin  += cntrV[nCntrNow].second * cntrV[nCntrNow].first;
+        sumWX2in += cntrV[nCntrNow].second * pow(cntrV[nCntrNow].first,2);
+      }
+      if(sumWin > 0) {
+        // the effective number of entries within the range is estimated from the fraction of the weights
+        double neffIn = dataSketch->GetNeff() * sumWin / dataSketch->GetSumW();
+
+        mean_Nsig68    = sumWXin / sumWin;
+        meanErr_Nsig68 = sqrt(max(sumWX2in/sumWin - pow(mean_Nsig68,2), 0.)) / sqrt(max(neffIn,1.));
+      }
+    }
     else {
       double  outlierDist   = param->GetOptF("meanWithoutOutliers")*sig68;
       double  sigma_Nsig68  = 0;
@@ -1660,6 +1932,11 @@ int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis) {
         madH->Fill(fabs(binCenter - median),binContent);
       }
     }
+    else if(hasSketch) {
+      for(int nCntrNow=0; nCntrNow<(int)cntrV.size(); nCntrNow++) {
+        madH->Fill(fabs(cntrV[nCntrNow].first - median),cntrV[nCntrNow].second);
+      }
+    }
     else {
       for(int nEleNow=0; nEleNow<param->GetOptI("nArrEntries"); nEleNow++) {
         madH->Fill(fabs(dataArr[nEleNow] - median));
@@ -1702,6 +1979,18 @@ int Utils::getInterQuantileStats(double * dataArr, TH1 * dataHis) {
         nArrEntriesF += binContent;
       }
     }
+    else if(hasSketch) {
+      nArrEntriesF = 0;
+      for(int nCntrNow=0; nCntrNow<(int)cntrV.size(); nCntrNow++) {
+        double  cntrWgt    = cntrV[nCntrNow].second;
+        double  distMedian = fabs(median - cntrV[nCntrNow].first);
+
+        if(distMedian > sig68_2) nLargerSig68_2 += cntrWgt; if(distMedian > sig68_3) nLargerSig68_3 += cntrWgt;
+        if(distMedian > sigma_2) nLargerSigma_2 += cntrWgt; if(distMedian > sigma_3) nLargerSigma_3 += cntrWgt;
+        
+        nArrEntriesF += cntrWgt;
+      }
+    }
     else {
       for(int nEleNow=0; nEleNow<param->GetOptI("nArrEntries"); nEleNow++) {
         double  distMedian = fabs(dataArr[nEleNow]-median);
@@ -0,0 +1,163 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+// ===========================================================================================================
+void BinLookup::Clear() {
+// ======================
+  nBins     = 0;
+  isUniform = false;
+  lowEdge   = highEdge = invWidth = 0;
+  edgesV.clear();
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief           - Set the bin edges (see the description in Utils.hpp).
+ *
+ * @param binEdgesV - Vector of bin-edges, in ascending order.
+ */
+// ===========================================================================================================
+void BinLookup::Set(const vector <double> & binEdgesV) {
+// =====================================================
+  Clear();
+
+  VERIFY(LOCATION,(TString)"Trying to BinLookup::Set() with less than two bin-edges",((int)binEdgesV.size() > 1));
+
+  edgesV   = binEdgesV;
+  nBins    = (int)edgesV.size() - 1;
+  lowEdge  = edgesV[0];
+  highEdge = edgesV[nBins];
+
+  for(int nBinNow=0; nBinNow<nBins; nBinNow++) {
+    VERIFY(LOCATION,(TString)"Trying to BinLookup::Set() with bin-edges which are not in ascending order",(edgesV[nBinNow+1] > edgesV[nBinNow]));
+  }
+
+  // the bins are considered uniform if all edges are within a small fraction of the width from the
+  // arithmetic ones - the guessed bin is anyway corrected by comparing with the actual edges
+  double binWidth = (highEdge - lowEdge) / double(nBins);
+
+  isUniform = true;
+  for(int nBinNow=1; nBinNow<nBins; nBinNow++) {
+    if(fabs(edgesV[nBinNow] - (lowEdge + binWidth * nBinNow)) > 1e-6 * binWidth) { isUniform = false; break; }
+  }
+  invWidth = 1 / binWidth;
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief        - Binary search for a bin, following the convention of ANNZ::getBinZ() (see the description in Utils.hpp).
+ *
+ * @param val    - The value for which to find the bin.
+ * @param aNbins - The number of bins.
+ * @param edges  - Array of (aNbins+1) bin-edges, in ascending order.
+ *
+ * @return       - The bin number, or -1 if the value is outside the range of the bins.
+ */
+// ===========================================================================================================
+int BinLookup::FindBin(double val, int aNbins, const double * edges) {
+// ===================================================================
+  if(!(val >= edges[0] && val <= edges[aNbins])) return -1;
+
+  // find the first upper bin-edge which is not smaller than the value (which exists, as the value
+  // is in range). The loop has no branches, and always makes ceil(log2(aNbins)) steps
+  const double * base = edges + 1;
+  int nLeft = aNbins;
+  while(nLeft > 1) {
+    int nHalf = nLeft / 2;
+    base   = (base[nHalf - 1] < val) ? base + nHalf : base;
+    nLeft -= nHalf;
+  }
+  return (int)(base - (edges + 1));
+}
+
+// ===========================================================================================================
+/**
+ * @brief     - Get the bin of a value, following the convention of ANNZ::getBinZ().
+ *
+ * @param val - The value for which to find the bin.
+ *
+ * @return    - The bin number (starting at 0), or -1 if the value is outside the range of the bins.
+ */
+// ===========================================================================================================
+int BinLookup::GetBin(double val) const {
+// ======================================
+  if(!(val >= lowEdge && val <= highEdge)) return -1;
+
+  if(!isUniform) return FindBin(val, nBins, &(edgesV[0]));
+
+  int nBin = min(max(static_cast<int>((val - lowEdge) * invWidth), 0), nBins - 1);
+  while(nBin > 0         && val <= edgesV[nBin])     nBin--;
+  while(nBin < nBins - 1 && val >  edgesV[nBin + 1]) nBin++;
+
+  return nBin;
+}
+
+// ===========================================================================================================
+/**
+ * @brief     - Get the bin of a value, following the convention of TH1::FindBin().
+ *
+ * @param val - The value for which to find the bin.
+ *
+ * @return    - The histogram bin number (starting at 1), with 0 for the underflow and nBins+1 for the overflow.
+ */
+// ===========================================================================================================
+int BinLookup::GetHisBin(double val) const {
+// =========================================
+  if(val < lowEdge)     return 0;
+  if(!(val < highEdge)) return nBins + 1;
+
+  if(isUniform) {
+    int nBin = min(max(static_cast<int>((val - lowEdge) * invWidth), 0), nBins - 1);
+    while(nBin > 0         && val <  edgesV[nBin])     nBin--;
+    while(nBin < nBins - 1 && val >= edgesV[nBin + 1]) nBin++;
+
+    return nBin + 1;
+  }
+
+  // find the first upper bin-edge which is larger than the value (as for FindBin(), without branches)
+  const double * edges = &(edgesV[0]);
+  const double * base  = edges + 1;
+  int nLeft = nBins;
+  while(nLeft > 1) {
+    int nHalf = nLeft / 2;
+    base   = (base[nHalf - 1] <= val) ? base + nHalf : base;
+    nLeft -= nHalf;
+  }
+  return (int)(base - edges);
+}
+
+// ===========================================================================================================
+/**
+ * @brief         - Get the bins of an array of values.
+ *
+ * @param nVals   - The number of values.
+ * @param vals    - Array of values.
+ * @param binsOut - Array (of size nVals) into which the bins are written.
+ * @param hisBins - Whether to follow the convention of GetHisBin() or that of GetBin().
+ */
+// ===========================================================================================================
+void BinLookup::GetBins(int nVals, const double * vals, int * binsOut, bool hisBins) const {
+// =========================================================================================
+  if(hisBins) { for(int nValNow=0; nValNow<nVals; nValNow++) binsOut[nValNow] = GetHisBin(vals[nValNow]); }
+  else        { for(int nValNow=0; nValNow<nVals; nValNow++) binsOut[nValNow] = GetBin   (vals[nValNow]); }
+
+  return;
+}
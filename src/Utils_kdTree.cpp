@@ -0,0 +1,454 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+namespace kdTreeFuncs {
+  // the maximal number of points in a leaf, and the maximal depth of the search stack
+  const int maxLeafSize  = 64;
+  const int maxStackSize = 128;
+}
+
+// ===========================================================================================================
+/**
+ * @brief           - A flat kd-tree for k-nearest-neighbour searches (see the description in Utils.hpp).
+ *
+ * @param aLeafSize - The maximal number of points in a leaf of the tree (at most kdTreeFuncs::maxLeafSize).
+ */
+// ===========================================================================================================
+KdTreeKNN::KdTreeKNN(int aLeafSize) {
+// ==================================
+  leafSize = max(min(aLeafSize, kdTreeFuncs::maxLeafSize), 1);
+
+  Clear();
+  return;
+}
+
+// ===========================================================================================================
+void KdTreeKNN::Clear() {
+// ======================
+  nDim = nPnts = maxChecks = 0;
+  nodeV.clear(); boxV.clear(); crdV.clear(); pntIndexV.clear(); evtV.clear();
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Build the tree from a set of points.
+ *
+ * @param aNdim    - The number of dimensions.
+ * @param aNpoints - The number of points.
+ * @param points   - The coordinates of the points (row-major, ie aNdim consecutive values for each point). The
+ *                 index of a point in this array is the index returned by Find().
+ */
+// ===========================================================================================================
+void KdTreeKNN::Build(int aNdim, int aNpoints, const Float_t * points) {
+// =====================================================================
+  Clear();
+  if(aNdim < 1 || aNpoints < 1) return;
+
+  nDim  = aNdim;
+  nPnts = aNpoints;
+
+  vector <int> orderV(nPnts);
+  for(int nPntNow=0; nPntNow<nPnts; nPntNow++) orderV[nPntNow] = nPntNow;
+
+  nodeV.reserve(4 * (nPnts / leafSize + 1));
+  buildNode(0,nPnts,orderV,points);
+
+  // store the coordinates in the order of the leaves, with the values of each dimension in a contiguous block
+  crdV.resize(static_cast<size_t>(nDim) * nPnts);
+  for(int nDimNow=0; nDimNow<nDim; nDimNow++) {
+    Float_t * crd = &(crdV[static_cast<size_t>(nDimNow) * nPnts]);
+    for(int nPntNow=0; nPntNow<nPnts; nPntNow++) crd[nPntNow] = points[static_cast<size_t>(orderV[nPntNow]) * nDim + nDimNow];
+  }
+  pntIndexV.swap(orderV);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Build the tree from the events of a TMVA::kNN::ModulekNN, after ModulekNN::Fill() has been
+ *                 called. As in ModulekNN::Find(), events with non-positive weights are excluded. The index returned
+ *                 by Find() may be used with GetEvent() to access the events, which are owned by the module (the
+ *                 module must therefore not be modified or deleted while the tree is in use).
+ *
+ * @param module   - The module.
+ */
+// ===========================================================================================================
+void KdTreeKNN::Build(TMVA::kNN::ModulekNN * module) {
+// ===================================================
+  Clear();
+  if(!module) return;
+
+  // collect the events from the binary tree of the module (depth first, in a fixed order)
+  vector <const TMVA::kNN::Event *>                 evtInV;
+  vector <const TMVA::kNN::Node<TMVA::kNN::Event> *> nodeStackV(1,module->fTree);
+
+  while(!nodeStackV.empty()) {
+    const TMVA::kNN::Node<TMVA::kNN::Event> * node = nodeStackV.back();
+    nodeStackV.pop_back();
+    if(!node) continue;
+
+    if(node->GetWeight() > 0) evtInV.push_back(&(node->GetEvent()));
+
+    nodeStackV.push_back(node->GetNodeR());
+    nodeStackV.push_back(node->GetNodeL());
+  }
+  if(evtInV.empty()) return;
+
+  int             nDimIn  = (int)evtInV[0]->GetNVar();
+  int             nPntsIn = (int)evtInV.size();
+  vector <Float_t> pointsV(static_cast<size_t>(nDimIn) * nPntsIn);
+
+  for(int nPntNow=0; nPntNow<nPntsIn; nPntNow++) {
+    assert((int)evtInV[nPntNow]->GetNVar() == nDimIn);
+    for(int nDimNow=0; nDimNow<nDimIn; nDimNow++) {
+      pointsV[static_cast<size_t>(nPntNow) * nDimIn + nDimNow] = evtInV[nPntNow]->GetVar(nDimNow);
+    }
+  }
+
+  Build(nDimIn,nPntsIn,&(pointsV[0]));
+  evtV.swap(evtInV);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Recursively create the nodes for the range of points [nBegin,nEnd) of orderV. The range is split
+ *                 at the median of the dimension with the largest extent (with ties broken by the index of the
+ *                 points), until the number of points is no larger than leafSize.
+ *
+ * @return         - The index of the node in nodeV.
+ */
+// ===========================================================================================================
+int KdTreeKNN::buildNode(int nBegin, int nEnd, vector <int> & orderV, const Float_t * points) {
+// ============================================================================================
+  int  nodeNow = (int)nodeV.size();
+  Node node    = {nBegin, nEnd, -1, -1};
+  nodeV.push_back(node);
+
+  // the bounding box of the points
+  boxV.resize(boxV.size() + 2 * nDim);
+  Float_t * boxLow  = &(boxV[static_cast<size_t>(2 * nDim) * nodeNow]);
+  Float_t * boxHigh = boxLow + nDim;
+
+  for(int nDimNow=0; nDimNow<nDim; nDimNow++) {
+    boxLow[nDimNow] = boxHigh[nDimNow] = points[static_cast<size_t>(orderV[nBegin]) * nDim + nDimNow];
+  }
+  for(int nPntNow=nBegin+1; nPntNow<nEnd; nPntNow++) {
+    const Float_t * pnt = points + static_cast<size_t>(orderV[nPntNow]) * nDim;
+    for(int nDimNow=0; nDimNow<nDim; nDimNow++) {
+      boxLow [nDimNow] = min(boxLow [nDimNow], pnt[nDimNow]);
+      boxHigh[nDimNow] = max(boxHigh[nDimNow], pnt[nDimNow]);
+    }
+  }
+
+  if(nEnd - nBegin <= leafSize) return nodeNow;
+
+  int splitDim(0);
+  for(int nDimNow=1; nDimNow<nDim; nDimNow++) {
+    if(boxHigh[nDimNow] - boxLow[nDimNow] > boxHigh[splitDim] - boxLow[splitDim]) splitDim = nDimNow;
+  }
+
+  int nMid = nBegin + (nEnd - nBegin) / 2;
+  std::nth_element(orderV.begin()+nBegin, orderV.begin()+nMid, orderV.begin()+nEnd,
+    [points,splitDim,this](int index0, int index1) {
+      Float_t val0 = points[static_cast<size_t>(index0) * nDim + splitDim];
+      Float_t val1 = points[static_cast<size_t>(index1) * nDim + splitDim];
+      return ((val0 < val1) || (val0 == val1 && index0 < index1));
+    }
+  );
+
+  // boxLow/boxHigh and references to nodeV are invalidated by the recursion
+  int nodeLeft  = buildNode(nBegin,nMid,orderV,points);
+  int nodeRight = buildNode(nMid  ,nEnd,orderV,points);
+
+  nodeV[nodeNow].left  = nodeLeft;
+  nodeV[nodeNow].right = nodeRight;
+
+  return nodeNow;
+}
+
+// ===========================================================================================================
+/**
+ * @brief             - Find the nearest neighbours of a point.
+ *
+ * @details           - For an exact search (if GetMaxChecks() is zero), the tree is traversed depth first, always
+ *                    descending first into the closer of the two children of a node. A node is skipped if the
+ *                    distance from the point to its bounding box is larger than the distance to the farthest
+ *                    neighbour found so far. Since the distance to the box is accumulated in the same way as the
+ *                    distance to a point, it is never larger than the distance to any point in the box, so that
+ *                    the search is exact. Otherwise, the search is approximate (see findApprox()).
+ *
+ * @param pnt         - The coordinates of the point (GetNdim() values).
+ * @param nFind       - The number of neighbours to find.
+ * @param indexOut    - Buffer (of at least nFind elements) for the indices of the neighbours.
+ * @param distOut     - Buffer (of at least nFind elements) for the (squared) distances to the neighbours.
+ * @param searchQueue - Optional buffer for the priority queue of an approximate search, which may be reused between
+ *                    calls (a temporary buffer is used if not provided).
+ *
+ * @return            - The number of neighbours found (min(nFind,GetNpoints())), sorted by increasing distance.
+ */
+// ===========================================================================================================
+int KdTreeKNN::Find(const Float_t * pnt, int nFind, int * indexOut, Float_t * distOut,
+                    vector < pair<Float_t,int> > * searchQueue) const {
+// ======================================================================
+  if(nPnts == 0 || nFind < 1) return 0;
+  nFind = min(nFind, nPnts);
+
+  if(maxChecks > 0) {
+    if(searchQueue) return findApprox(pnt,nFind,indexOut,distOut,*searchQueue);
+
+    vector < pair<Float_t,int> > queueV;
+    return findApprox(pnt,nFind,indexOut,distOut,queueV);
+  }
+
+  int     stackNode[kdTreeFuncs::maxStackSize];
+  Float_t stackDist[kdTreeFuncs::maxStackSize];
+  int     nStack(0), nFound(0);
+
+  stackNode[nStack] = 0; stackDist[nStack] = 0; nStack++;
+
+  while(nStack > 0) {
+    nStack--;
+    if(nFound == nFind && stackDist[nStack] > distOut[nFound-1]) continue;
+
+    const Node & node = nodeV[stackNode[nStack]];
+
+    if(node.left < 0) {
+      searchLeaf(pnt,stackNode[nStack],nFind,indexOut,distOut,nFound);
+      continue;
+    }
+
+    // add both children to the stack, such that the closer one is searched first
+    Float_t distLeft  = getBoxDist(pnt,node.left);
+    Float_t distRight = getBoxDist(pnt,node.right);
+    bool    isLeftNear(distLeft <= distRight);
+
+    assert(nStack + 2 <= kdTreeFuncs::maxStackSize);
+    stackNode[nStack] = isLeftNear ? node.right : node.left;  stackDist[nStack] = isLeftNear ? distRight : distLeft;  nStack++;
+    stackNode[nStack] = isLeftNear ? node.left  : node.right; stackDist[nStack] = isLeftNear ? distLeft  : distRight; nStack++;
+  }
+
+  return nFound;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Approximate search for the nearest neighbours of a point (best-bin-first).
+ *
+ * @details        - Starting from the root, the tree is descended to the leaf which is closest to the point, while
+ *                 the other child of each node along the way is added to a priority queue, ordered by the distance
+ *                 from the point to the bounding box of the node. The closest node in the queue is then taken as the
+ *                 next starting point. The search ends once the distances to at least GetMaxChecks() points have been
+ *                 computed (and nFind neighbours have been found), or if no node in the queue may hold a closer
+ *                 neighbour, in which case the result is exact.
+ */
+// ===========================================================================================================
+int KdTreeKNN::findApprox(const Float_t * pnt, int nFind, int * indexOut, Float_t * distOut,
+                          vector < pair<Float_t,int> > & queueV) const {
+// ===================================================================
+  std::greater < pair<Float_t,int> > queueOrder;
+  int                                nFound(0), nChecks(0);
+
+  queueV.clear();
+  queueV.push_back(pair<Float_t,int>(0,0));
+
+  while(!queueV.empty()) {
+    std::pop_heap(queueV.begin(),queueV.end(),queueOrder);
+    pair<Float_t,int> queueNow = queueV.back();
+    queueV.pop_back();
+
+    if(nFound == nFind && (queueNow.first > distOut[nFound-1] || nChecks >= maxChecks)) break;
+
+    // descend to the closest leaf, and add the farther child of each node to the queue
+    int nodeNow = queueNow.second;
+    while(nodeV[nodeNow].left >= 0) {
+      const Node & node = nodeV[nodeNow];
+
+      Float_t distLeft  = getBoxDist(pnt,node.left);
+      Float_t distRight = getBoxDist(pnt,node.right);
+      bool    isLeftNear(distLeft <= distRight);
+
+      queueV.push_back(isLeftNear ? pair<Float_t,int>(distRight,node.right) : pair<Float_t,int>(distLeft,node.left));
+      std::push_heap(queueV.begin(),queueV.end(),queueOrder);
+
+      nodeNow = isLeftNear ? node.left : node.right;
+    }
+
+    searchLeaf(pnt,nodeNow,nFind,indexOut,distOut,nFound);
+    nChecks += nodeV[nodeNow].end - nodeV[nodeNow].begin;
+  }
+
+  return nFound;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Compute the distances from a point to all of the points of a leaf, and insert the closer ones
+ *                 into the (sorted) output of Find(), which holds nFound neighbours.
+ */
+// ===========================================================================================================
+void KdTreeKNN::searchLeaf(const Float_t * pnt, int nodeIndex, int nFind, int * indexOut, Float_t * distOut, int & nFound) const {
+// ==============================================================================================================================
+  const Node & node      = nodeV[nodeIndex];
+  int          nLeafPnts = node.end - node.begin;
+  Float_t      leafDist[kdTreeFuncs::maxLeafSize];
+
+  for(int nPntNow=0; nPntNow<nLeafPnts; nPntNow++) leafDist[nPntNow] = 0;
+
+  for(int nDimNow=0; nDimNow<nDim; nDimNow++) {
+    const Float_t * crd   = &(crdV[static_cast<size_t>(nDimNow) * nPnts + node.begin]);
+    const Float_t   valIn = pnt[nDimNow];
+
+    for(int nPntNow=0; nPntNow<nLeafPnts; nPntNow++) {
+      Float_t diff = crd[nPntNow] - valIn;
+      leafDist[nPntNow] += diff * diff;
+    }
+  }
+
+  for(int nPntNow=0; nPntNow<nLeafPnts; nPntNow++) {
+    Float_t distNow  = leafDist[nPntNow];
+    int     indexNow = pntIndexV[node.begin + nPntNow];
+
+    if(nFound == nFind) {
+      if(distNow > distOut[nFound-1] || (distNow == distOut[nFound-1] && indexNow > indexOut[nFound-1])) continue;
+      nFound--;
+    }
+
+    int nPos(nFound);
+    while(nPos > 0 && (distOut[nPos-1] > distNow || (distOut[nPos-1] == distNow && indexOut[nPos-1] > indexNow))) {
+      distOut[nPos] = distOut[nPos-1]; indexOut[nPos] = indexOut[nPos-1]; nPos--;
+    }
+    distOut[nPos] = distNow; indexOut[nPos] = indexNow; nFound++;
+  }
+
+  return;
+}
+
+// ===========================================================================================================
+Float_t KdTreeKNN::getBoxDist(const Float_t * pnt, int nodeIndex) const {
+// ======================================================================
+  const Float_t * boxLow  = &(boxV[static_cast<size_t>(2 * nDim) * nodeIndex]);
+  const Float_t * boxHigh = boxLow + nDim;
+
+  Float_t dist(0);
+  for(int nDimNow=0; nDimNow<nDim; nDimNow++) {
+    Float_t diff(0);
+    if     (pnt[nDimNow] < boxLow [nDimNow]) diff = boxLow[nDimNow] - pnt[nDimNow];
+    else if(pnt[nDimNow] > boxHigh[nDimNow]) diff = pnt[nDimNow] - boxHigh[nDimNow];
+
+    dist += diff * diff;
+  }
+
+  return dist;
+}
+
+// ===========================================================================================================
+/**
+ * @brief              - Set the number of points checked in an approximate search (see SetMaxChecks()), such that
+ *                     the recall of the search is at least recallTarget.
+ *
+ * @details            - The recall is measured on a held-out sample of nQuery points of the tree (spread evenly
+ *                     over the tree). For each of these, the nFind near-neighbours (excluding the point itself)
+ *                     are found with an exact search and with an approximate one, and the recall is the fraction of
+ *                     the exact neighbours which are also found by the approximate search, averaged over all points.
+ *                     Starting from 2*max(nFind,leafSize), the number of checked points is increased by 50% at a
+ *                     time, until the target is reached. If this requires checking a large fraction of the points of the tree, the search
+ *                     is left exact.
+ *
+ * @param nFind        - The number of neighbours searched for.
+ * @param recallTarget - The target recall (the search is exact for recallTarget >= 1).
+ * @param nQuery       - The number of points in the held-out sample.
+ * @param speedUp      - Optional pointer to the ratio between the time of the exact and of the approximate searches
+ *                     of the held-out sample.
+ *
+ * @return             - The measured recall (1 for an exact search).
+ */
+// ===========================================================================================================
+double KdTreeKNN::TuneMaxChecks(int nFind, double recallTarget, int nQuery, double * speedUp) {
+// =============================================================================================
+  maxChecks = 0;
+  if(speedUp) *speedUp = 1;
+
+  nQuery = min(nQuery, nPnts);
+  if(recallTarget >= 1 || nFind < 1 || nQuery < 1 || nFind + 1 >= nPnts) return 1;
+
+  // the held-out points, and their exact near-neighbours
+  int              nFindIn = nFind + 1;
+  vector <Float_t> queryV(static_cast<size_t>(nQuery) * nDim), distV(nFindIn);
+  vector <int>     queryIndexV(nQuery), indexV(nFindIn), exactV(static_cast<size_t>(nQuery) * nFind);
+
+  for(int nQueryNow=0; nQueryNow<nQuery; nQueryNow++) {
+    int nPntNow = static_cast<int>(static_cast<Long64_t>(nQueryNow) * nPnts / nQuery);
+
+    queryIndexV[nQueryNow] = pntIndexV[nPntNow];
+    for(int nDimNow=0; nDimNow<nDim; nDimNow++) {
+      queryV[static_cast<size_t>(nQueryNow) * nDim + nDimNow] = crdV[static_cast<size_t>(nDimNow) * nPnts + nPntNow];
+    }
+  }
+
+  // get the neighbours of a held-out point (excluding the point itself), sorted by index
+  vector < pair<Float_t,int> > queueV;
+  auto getNeighbours = [&](int nQueryNow, int * neighbourV) {
+    int nFound = Find(&(queryV[static_cast<size_t>(nQueryNow) * nDim]),nFindIn,&(indexV[0]),&(distV[0]),&queueV);
+
+    int nNeighbours(0);
+    for(int nKnnNow=0; nKnnNow<nFound && nNeighbours<nFind; nKnnNow++) {
+      if(indexV[nKnnNow] != queryIndexV[nQueryNow]) neighbourV[nNeighbours++] = indexV[nKnnNow];
+    }
+    for(; nNeighbours<nFind; nNeighbours++) neighbourV[nNeighbours] = -1;
+
+    std::sort(neighbourV,neighbourV+nFind);
+    return;
+  };
+
+  TStopwatch tuneTimer;
+  for(int nQueryNow=0; nQueryNow<nQuery; nQueryNow++) getNeighbours(nQueryNow,&(exactV[static_cast<size_t>(nQueryNow) * nFind]));
+  tuneTimer.Stop();
+  double timeExact = tuneTimer.RealTime();
+
+  // increase the number of checked points until the recall is high enough
+  vector <int> approxV(nFind), commonV(nFind);
+  double       recall(1);
+
+  for(int maxChecksNow=2*max(nFind,leafSize); maxChecksNow<nPnts/4; maxChecksNow+=maxChecksNow/2) {
+    maxChecks = maxChecksNow;
+
+    double nCommon(0);
+    tuneTimer.Start(true);
+    for(int nQueryNow=0; nQueryNow<nQuery; nQueryNow++) {
+      getNeighbours(nQueryNow,&(approxV[0]));
+
+      const int * exactNow = &(exactV[static_cast<size_t>(nQueryNow) * nFind]);
+      vector <int>::iterator itrEnd = std::set_intersection(exactNow,exactNow+nFind,approxV.begin(),approxV.end(),commonV.begin());
+      nCommon += itrEnd - commonV.begin();
+    }
+    tuneTimer.Stop();
+
+    recall = nCommon / (static_cast<double>(nQuery) * nFind);
+    if(recall >= recallTarget) {
+      if(speedUp) *speedUp = timeExact / max(tuneTimer.RealTime(),EPS);
+      return recall;
+    }
+  }
+
+  maxChecks = 0;
+  return 1;
+}
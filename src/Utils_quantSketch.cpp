@@ -0,0 +1,192 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+// 
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+// ===========================================================================================================
+/**
+ * @brief              - A mergeable streaming quantile sketch for weighted data (see the description in Utils.hpp).
+ * 
+ * @param aCompression - Compression parameter (larger values give a smaller error and more centroids).
+ * @param aBufSize     - Number of values which are buffered before a compression (default of 5*aCompression).
+ */
+// ===========================================================================================================
+QuantSketch::QuantSketch(double aCompression, int aBufSize) {
+// ==========================================================
+  compression = max(aCompression, 10.);
+  bufSize     = (aBufSize > 0) ? aBufSize : static_cast<int>(5 * compression);
+
+  Reset();
+  return;
+}
+
+// ===========================================================================================================
+void QuantSketch::Reset() {
+// ========================
+  nEntries = sumW = sumW2 = sumWX = sumWX2 = 0;
+  cntrV.clear(); bufV.clear();
+  return;
+}
+
+// ===========================================================================================================
+void QuantSketch::Fill(double val, double wgt) {
+// =============================================
+  if(!(wgt > 0) || val != val) return;
+
+  nEntries += 1;
+  sumW     += wgt;
+  sumW2    += wgt * wgt;
+  sumWX    += wgt * val;
+  sumWX2   += wgt * val * val;
+
+  bufV.push_back(pair<double,double>(val,wgt));
+  if((int)bufV.size() >= bufSize) compress();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Add the content of another sketch to this one (sketchIn is not modified, other than being
+ *                 compressed). The order of merging several sketches should be fixed, for reproducible results.
+ */
+// ===========================================================================================================
+void QuantSketch::Merge(QuantSketch & sketchIn) {
+// ==============================================
+  sketchIn.compress();
+
+  nEntries += sketchIn.nEntries;
+  sumW     += sketchIn.sumW;
+  sumW2    += sketchIn.sumW2;
+  sumWX    += sketchIn.sumWX;
+  sumWX2   += sketchIn.sumWX2;
+
+  bufV.insert(bufV.end(),sketchIn.cntrV.begin(),sketchIn.cntrV.end());
+  compress();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Merge the buffered values with the current centroids. Adjacent centroids are combined
+ *                 as long as the merged weight is below 4*W*q*(1-q)/compression, for the quantiles, q, of both
+ *                 edges of the merged centroid. The first and last centroids therefore always hold the minimal
+ *                 and maximal values.
+ */
+// ===========================================================================================================
+void QuantSketch::compress() {
+// ===========================
+  if(bufV.size() == 0) return;
+
+  bufV.insert(bufV.end(),cntrV.begin(),cntrV.end());
+  std::sort(bufV.begin(),bufV.end());
+
+  double sumWgt(0);
+  for(int nEleNow=0; nEleNow<(int)bufV.size(); nEleNow++) sumWgt += bufV[nEleNow].second;
+
+  vector < pair<double,double> > cntrOutV;
+  pair<double,double>            cntrNow(bufV[0]);
+  double                         wgtSoFar(0);
+
+  for(int nEleNow=1; nEleNow<(int)bufV.size(); nEleNow++) {
+    double wgtMerged = cntrNow.second + bufV[nEleNow].second;
+    double quantL    = wgtSoFar / sumWgt;
+    double quantR    = (wgtSoFar + wgtMerged) / sumWgt;
+    double maxWgt    = 4 * sumWgt * min(quantL * (1 - quantL), quantR * (1 - quantR)) / compression;
+
+    if(wgtMerged <= maxWgt) {
+      cntrNow.first  = (cntrNow.first * cntrNow.second + bufV[nEleNow].first * bufV[nEleNow].second) / wgtMerged;
+      cntrNow.second = wgtMerged;
+    }
+    else {
+      cntrOutV.push_back(cntrNow);
+      wgtSoFar += cntrNow.second;
+      cntrNow   = bufV[nEleNow];
+    }
+  }
+  cntrOutV.push_back(cntrNow);
+
+  cntrV.swap(cntrOutV);
+  bufV.clear();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Derive quantiles, interpolating linearly between the centres of the centroids. For
+ *                 unit weights and no compression, this is the same as TMath::Quantiles() with type=7.
+ * 
+ * @param nQuant    - Number of quantiles.
+ * @param quantiles - Array of size nQuant, which is filled with the derived quantiles.
+ * @param probQuant - Array of size nQuant, with the probabilities for which to derive quantiles.
+ */
+// ===========================================================================================================
+int QuantSketch::GetQuantiles(int nQuant, double * quantiles, double * probQuant) {
+// ================================================================================
+  compress();
+
+  int nCntrs = (int)cntrV.size();
+  if(nCntrs == 0 || nQuant <= 0) return 0;
+
+  // the cumulative weight at the centre of each centroid
+  vector <double> wgtMidV(nCntrs);
+  double          wgtSoFar(0);
+  for(int nCntrNow=0; nCntrNow<nCntrs; nCntrNow++) {
+    wgtMidV[nCntrNow]  = wgtSoFar + 0.5 * cntrV[nCntrNow].second;
+    wgtSoFar          += cntrV[nCntrNow].second;
+  }
+
+  for(int nQuantNow=0; nQuantNow<nQuant; nQuantNow++) {
+    double probNow = min(max(probQuant[nQuantNow],0.),1.);
+    double wgtNow  = wgtMidV[0] + probNow * (wgtMidV[nCntrs-1] - wgtMidV[0]);
+
+    int nCntrHigh = (int)(std::upper_bound(wgtMidV.begin(),wgtMidV.end(),wgtNow) - wgtMidV.begin());
+    if     (nCntrHigh <= 0     ) { quantiles[nQuantNow] = cntrV[0].first;        continue; }
+    else if(nCntrHigh >= nCntrs) { quantiles[nQuantNow] = cntrV[nCntrs-1].first; continue; }
+
+    int    nCntrLow = nCntrHigh - 1;
+    double fracHigh = (wgtNow - wgtMidV[nCntrLow]) / (wgtMidV[nCntrHigh] - wgtMidV[nCntrLow]);
+
+    quantiles[nQuantNow] = cntrV[nCntrLow].first + fracHigh * (cntrV[nCntrHigh].first - cntrV[nCntrLow].first);
+  }
+
+  wgtMidV.clear();
+  return 1;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - The bound on the error of the rank (as a fraction of the total weight) of a given quantile.
+ */
+// ===========================================================================================================
+double QuantSketch::GetRankErrorBound(double probQuant) {
+// ======================================================
+  // no values have been merged into centroids
+  if(GetNcentroids() >= nEntries) return 0;
+
+  probQuant = min(max(probQuant,0.),1.);
+  return (2 * probQuant * (1 - probQuant) / compression);
+}
+
+// ===========================================================================================================
+void QuantSketch::GetCentroids(vector < pair<double,double> > & cntrOutV) {
+// ========================================================================
+  compress();
+  cntrOutV = cntrV;
+  return;
+}
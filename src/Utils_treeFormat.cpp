@@ -0,0 +1,170 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+// ===========================================================================================================
+void TreeFormat::Clear() {
+// =======================
+  compress       = -1;
+  maxBasketBytes = nEntriesFlush = 0;
+  fileBytes      = 0;
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief                 - Set the format (see the description in Utils.hpp).
+ *
+ * @param compressOpt     - The compression, as "ALGO:LEVEL" (or an empty string for the default of ROOT).
+ * @param maxBasketKB     - The maximal size of a basket in KB (no change of the basket sizes if not positive).
+ * @param fileMB          - The target size of an output file in MB (one file per output batch if not positive).
+ * @param nEntriesFlushIn - The number of entries in one output batch (nObjectsToWrite).
+ */
+// ===========================================================================================================
+void TreeFormat::Set(TString compressOpt, int maxBasketKB, int fileMB, int nEntriesFlushIn) {
+// ==========================================================================================
+  Clear();
+
+  SetCompress(compressOpt);
+
+  maxBasketBytes = max(maxBasketKB,0) * 1024;
+  nEntriesFlush  = max(nEntriesFlushIn,0);
+  fileBytes      = (Long64_t)max(fileMB,0) * 1024 * 1024;
+
+  return;
+}
+
+// ===========================================================================================================
+void TreeFormat::SetCompress(TString compressOpt) {
+// ================================================
+  compress = ParseCompress(compressOpt);
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief             - Translate a compression option into the compression settings of ROOT (100 times the
+ *                    index of the algorithm plus the level, as in ROOT::CompressionSettings()).
+ *
+ * @param compressOpt - The compression, as "ALGO:LEVEL" (e.g., "LZ4:4"), where ALGO is one of ZLIB, LZMA,
+ *                    LZ4 or ZSTD, and LEVEL is between 1 and 9.
+ *
+ * @return            - The compression settings, or -1 for an empty option (the default of ROOT).
+ */
+// ===========================================================================================================
+int TreeFormat::ParseCompress(TString compressOpt) {
+// =================================================
+  compressOpt.ReplaceAll(" ","").ToUpper();
+  if(compressOpt == "") return -1;
+
+  TString algoName(compressOpt), levelName("");
+  if(compressOpt.Contains(":")) {
+    algoName  = compressOpt(0,compressOpt.First(':'));
+    levelName = compressOpt(compressOpt.First(':')+1,compressOpt.Length());
+  }
+
+  VERIFY(LOCATION,(TString)"Compression level in \""+compressOpt+"\" must be an integer between 1 and 9 ...",
+                           (levelName == "" || (levelName.IsDigit() && levelName.Atoi() >= 1 && levelName.Atoi() <= 9)));
+
+  int algo(0), level(levelName == "" ? 1 : levelName.Atoi());
+  if     (algoName == "ZLIB") algo = 1;
+  else if(algoName == "LZMA") algo = 2;
+  else if(algoName == "LZ4" ) algo = 4;
+  else if(algoName == "ZSTD") algo = 5;
+
+  VERIFY(LOCATION,(TString)"Unknown compression algorithm in \""+compressOpt+"\" (allowed are ZLIB, LZMA, LZ4 or ZSTD) ...",(algo > 0));
+
+#if ROOT_VERSION_CODE < ROOT_VERSION(6,20,0)
+  VERIFY(LOCATION,(TString)"ZSTD compression is only supported from ROOT v6.20 onwards ...",(algo != 5));
+#endif
+
+  return (algo * 100 + level);
+}
+
+// ===========================================================================================================
+/**
+ * @brief      - Set the basket size of each branch of a tree, such that one basket holds the entries of one
+ *             output batch (between the default size of ROOT and maxBasketBytes). Branches of objects (which
+ *             do not have a fixed size per entry) are not changed.
+ *
+ * @param tree - The tree (should be called after the branches are created, and before the tree is filled).
+ */
+// ===========================================================================================================
+void TreeFormat::SetBaskets(TTree * tree) const {
+// ==============================================
+  if(!dynamic_cast<TTree*>(tree) || maxBasketBytes <= 0 || nEntriesFlush <= 0) return;
+
+  int         minBasketBytes = 32000;
+  TObjArray * branches       = tree->GetListOfBranches();
+
+  for(int nBrnchNow=0; nBrnchNow<branches->GetEntriesFast(); nBrnchNow++) {
+    TBranch * branch     = dynamic_cast<TBranch*>(branches->At(nBrnchNow));
+    Long64_t  entryBytes = GetEntryBytes(branch);
+    if(entryBytes <= 0) continue;
+
+    Long64_t basketBytes = min(max(entryBytes * nEntriesFlush,(Long64_t)minBasketBytes),(Long64_t)max(maxBasketBytes,minBasketBytes));
+    branch->SetBasketSize((Int_t)basketBytes);
+  }
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief        - The size of one entry of a branch of a basic type (zero for branches of objects).
+ *
+ * @param branch - The branch.
+ *
+ * @return       - The size in bytes.
+ */
+// ===========================================================================================================
+Long64_t TreeFormat::GetEntryBytes(TBranch * branch) {
+// ===================================================
+  if(!dynamic_cast<TBranch*>(branch) || branch->IsA() != TBranch::Class()) return 0;
+
+  Long64_t    entryBytes(0);
+  TObjArray * leaves = branch->GetListOfLeaves();
+  for(int nLeafNow=0; nLeafNow<leaves->GetEntriesFast(); nLeafNow++) {
+    TLeaf * leaf = dynamic_cast<TLeaf*>(leaves->At(nLeafNow));
+    if(leaf) entryBytes += (Long64_t)leaf->GetLenType() * max(leaf->GetLenStatic(),1);
+  }
+
+  return entryBytes;
+}
+
+// ===========================================================================================================
+/**
+ * @brief      - The uncompressed size of the data in a tree, estimated from the number of entries and the size of
+ *             one entry of each branch of a basic type (branches of objects are not counted).
+ *
+ * @param tree - The tree.
+ *
+ * @return     - The size in bytes.
+ */
+// ===========================================================================================================
+Long64_t TreeFormat::GetTreeBytes(TTree * tree) {
+// ==============================================
+  if(!dynamic_cast<TTree*>(tree) || dynamic_cast<TChain*>(tree)) return 0;
+
+  Long64_t    entryBytes(0);
+  TObjArray * branches = tree->GetListOfBranches();
+  for(int nBrnchNow=0; nBrnchNow<branches->GetEntriesFast(); nBrnchNow++) {
+    entryBytes += GetEntryBytes(dynamic_cast<TBranch*>(branches->At(nBrnchNow)));
+  }
+
+  return (entryBytes * tree->GetEntries());
+}
@@ -17,6 +17,7 @@
 // ===========================================================================================================
 
 #include "VarMaps.hpp"
+#include "VarMaps_formExpr.cpp"
 
 // ===========================================================================================================
 VarMaps::VarMaps(OptMaps * aOptMaps, Utils * aUtils, TString aName) {
@@ -35,6 +36,8 @@ VarMaps::VarMaps(OptMaps * aOptMaps, Utils * aUtils, TString aName) {
   needReaderUpdate  = true;
   readerFormNameKey = "ANNZ_readerFormulae_";
   failedCutType     = "";
+  isBranchSel       = false;
+  nBytesRead        = 0;
 
   cntrMap           = new CntrMap(glob,utils,(TString)name+"_cntrMap");
 
@@ -53,8 +56,9 @@ VarMaps::~VarMaps() {
 void VarMaps::clearVar() {
 // =======================  
   eraseTreeCutsPattern("");
-  for(Map <TString,TTreeFormula*>::iterator itr=treeCutsFormM.begin(); itr!=treeCutsFormM.end(); ++itr) DELNULL(itr->second);
+  for(Map <TString,TreeForm>::iterator itr=treeCutsFormM.begin(); itr!=treeCutsFormM.end(); ++itr) itr->second.clear();
   treeCutsFormM.clear();
+  readerFormM.clear();
       
   vector <TString> varNames;
   GetAllVarNames(varNames,"B");  for(int nVarNow=0; nVarNow<(int)varNames.size(); nVarNow++) DelVarB_ (varNames[nVarNow]);
@@ -76,6 +80,7 @@ void VarMaps::clearVar() {
   hasFM.clear();
 
   treeCutsM.clear(); nTreeInChain = -1; chainFriendV.clear(); nTreeFriendInChainV.clear();
+  handleVarM.clear();
   
   return;
 }
@@ -93,6 +98,8 @@ void VarMaps::clearTrees() {
     treeWrite = NULL;
   }
   if(dynamic_cast<TTree*>(treeRead )) {
+    printReadStats();
+
     if(treeReadName != "") {
       aLOG(Log::DEBUG_2) <<coutYellow<<" - for VarMaps("<<coutGreen<<name<<coutYellow
                          <<") - clear treeRead("<<coutGreen<<treeWriteName<<coutYellow<<")"<<coutDef<<endl;
@@ -104,6 +111,8 @@ void VarMaps::clearTrees() {
 
   nTreeInChain = -1; chainFriendV.clear(); nTreeFriendInChainV.clear();
 
+  isBranchSel = false; nBytesRead = 0; treeOfBranchM.clear(); inactiveBranchM.clear();
+
   return;
 }
 
@@ -181,20 +190,23 @@ void VarMaps::NewForm(TString aName, TString input) {
   return;
 }
 // ===========================================================================================================
-void VarMaps::SetVarB(TString aName, Bool_t    input) { SetVarB_(aName,input); return; }
-void VarMaps::SetVarC(TString aName, TString   input) { SetVarC_(aName,input); return; }
+void VarMaps::SetVarB(TString aName, Bool_t    input) { touchBranch(aName); SetVarB_(aName,input); return; }
+void VarMaps::SetVarC(TString aName, TString   input) { touchBranch(aName); SetVarC_(aName,input); return; }
 // ===========================================================================================================
 void VarMaps::SetVarI(TString aName, Long64_t  input) {
+  touchBranch(aName);
   if     (HasVarI_ (aName)) varI [aName] = input; else if(HasVarS_ (aName)) varS [aName] = input;
   else if(HasVarL_ (aName)) varL [aName] = input; else AsrtVar(false,aName+" (SetVarI)"); return;
 }
 // ===========================================================================================================
 void VarMaps::SetVarU(TString aName, ULong64_t input) {
+  touchBranch(aName);
   if     (HasVarUI_(aName)) varUI[aName] = input; else if(HasVarUS_(aName)) varUS[aName] = input;
   else if(HasVarUL_(aName)) varUL[aName] = input; else AsrtVar(false,aName+" (SetVarU)"); return;
 }
 // ===========================================================================================================
 void VarMaps::SetVarF(TString aName, Double_t  input) {
+  touchBranch(aName);
   if     (HasVarF_ (aName)) varF [aName] = input;
   else if(HasVarD_ (aName)) varD [aName] = input; else AsrtVar(false,aName+" (SetVarF)"); return;
 }
@@ -202,6 +214,7 @@ void VarMaps::SetVarF(TString aName, Double_t  input) {
 void VarMaps::SetVarB(TString aName, TString input) {
 // ==================================================
   bool failed(false);
+  touchBranch(aName);
 
   if     (input.EqualTo("true" ,TString::kIgnoreCase))  SetVarB_(aName,true ); // format is "true"  or "TRUE"
   else if(input.EqualTo("false",TString::kIgnoreCase))  SetVarB_(aName,false); // format is "false" or "FALSE"
@@ -222,18 +235,21 @@ void VarMaps::SetVarB(TString aName, TString input) {
 // ===========================================================================================================
 void VarMaps::SetVarI(TString aName, TString input) {
 // ==================================================
+  touchBranch(aName);
   if     (HasVarI_ (aName)) varI [aName] = utils->strToInt(input);  else if(HasVarS_ (aName)) varS [aName] = utils->strToInt (input);
   else if(HasVarL_ (aName)) varL [aName] = utils->strToLong(input); else AsrtVar(false,aName+" (SetVarI)"); return;
 }
 // ===========================================================================================================
 void VarMaps::SetVarU(TString aName, TString input) {
 // ==================================================
+  touchBranch(aName);
   if     (HasVarUI_(aName)) varUI[aName] = utils->strToUint(input);  else if(HasVarUS_(aName)) varUS[aName] = utils->strToUint (input);
   else if(HasVarUL_(aName)) varUL[aName] = utils->strToUlong(input); else AsrtVar(false,aName+" (SetVarU)"); return;
 }
 // ===========================================================================================================
 void VarMaps::SetVarF(TString aName, TString input) {
 // ==================================================
+  touchBranch(aName);
   if     (HasVarF_ (aName)) varF [aName] = utils->strToFloat(input);
   else if(HasVarD_ (aName)) varD [aName] = utils->strToDouble(input); else AsrtVar(false,aName+" (SetVarF)"); return;
 }
@@ -284,11 +300,73 @@ void VarMaps::SetForm(TString aName, TString input) {
 // ===========================================================================================================
 Double_t VarMaps::GetForm(TString aName) {
 // =======================================
-  bool        hasForm = (varFormM.find(aName) != varFormM.end());
-  if(hasForm) hasForm = dynamic_cast<TTreeFormula*>(varFormM[aName]);
-  VERIFY(LOCATION,(TString)" - VarMaps("+name+") - has not setup varFormM (\""+aName+"\") ...",hasForm);
+  Map <TString,TreeForm>::iterator itr = varFormM.find(aName);
+  VERIFY(LOCATION,(TString)" - VarMaps("+name+") - has not setup varFormM (\""+aName+"\") ...",(itr != varFormM.end() && itr->second.isValid()));
 
-  return varFormM[aName]->EvalInstance();
+  return itr->second.Eval();
+}
+
+// ===========================================================================================================
+VarMaps::VarHandle VarMaps::GetVarHandle(TString aName) {
+// ======================================================
+  VarHandle hdl;
+  TString   type = GetVarType(aName);
+
+  // variables accessed by handles are always read from the tree (see selectTreeBranches())
+  handleVarM[aName] = true; touchBranch(aName);
+
+  // the elements of the (unordered) maps are never moved, so pointers to the values remain valid until
+  // the variable is deleted (the same pointers are used as branch addresses in createTreeBranches() etc.)
+  if     (type == "B" ) { hdl.type = VarHandle::kB;  hdl.ptr = &(varB [aName]); }
+  else if(type == "C" ) { hdl.type = VarHandle::kC;  hdl.ptr = &(varC [aName]); }
+  else if(type == "S" ) { hdl.type = VarHandle::kS;  hdl.ptr = &(varS [aName]); }
+  else if(type == "I" ) { hdl.type = VarHandle::kI;  hdl.ptr = &(varI [aName]); }
+  else if(type == "L" ) { hdl.type = VarHandle::kL;  hdl.ptr = &(varL [aName]); }
+  else if(type == "US") { hdl.type = VarHandle::kUS; hdl.ptr = &(varUS[aName]); }
+  else if(type == "UI") { hdl.type = VarHandle::kUI; hdl.ptr = &(varUI[aName]); }
+  else if(type == "UL") { hdl.type = VarHandle::kUL; hdl.ptr = &(varUL[aName]); }
+  else if(type == "F" ) { hdl.type = VarHandle::kF;  hdl.ptr = &(varF [aName]); }
+  else if(type == "D" ) { hdl.type = VarHandle::kD;  hdl.ptr = &(varD [aName]); }
+  else if(type == "FM") {
+    // the slot is created here if needed, and filled by setTreeForms() once the tree is connected
+    hdl.type = VarHandle::kFM; hdl.ptr = &(varFormM[aName]);
+  }
+  else VERIFY(LOCATION,(TString)" - VarMaps("+name+") can not create a handle for variable of type \""+type+"\" ("+aName+")",false);
+
+  return hdl;
+}
+// ===========================================================================================================
+void VarMaps::GetVarHandles(vector <TString> & nameV, vector <VarHandle> & handleV) {
+// ==================================================================================
+  handleV.resize(nameV.size());
+  for(int nVarNow=0; nVarNow<(int)nameV.size(); nVarNow++) handleV[nVarNow] = GetVarHandle(nameV[nVarNow]);
+  return;
+}
+// ===========================================================================================================
+void VarMaps::SetVarI(const VarHandle & hdl, TString input) {
+// ==========================================================
+  if     (hdl.type == VarHandle::kI) *static_cast<Int_t   *>(hdl.ptr) = utils->strToInt (input);
+  else if(hdl.type == VarHandle::kS) *static_cast<Short_t *>(hdl.ptr) = utils->strToInt (input);
+  else if(hdl.type == VarHandle::kL) *static_cast<Long64_t*>(hdl.ptr) = utils->strToLong(input);
+  else                              AsrtVar(false,"(SetVarI) from handle");
+  return;
+}
+// ===========================================================================================================
+void VarMaps::SetVarU(const VarHandle & hdl, TString input) {
+// ==========================================================
+  if     (hdl.type == VarHandle::kUI) *static_cast<UInt_t   *>(hdl.ptr) = utils->strToUint (input);
+  else if(hdl.type == VarHandle::kUS) *static_cast<UShort_t *>(hdl.ptr) = utils->strToUint (input);
+  else if(hdl.type == VarHandle::kUL) *static_cast<ULong64_t*>(hdl.ptr) = utils->strToUlong(input);
+  else                               AsrtVar(false,"(SetVarU) from handle");
+  return;
+}
+// ===========================================================================================================
+void VarMaps::SetVarF(const VarHandle & hdl, TString input) {
+// ==========================================================
+  if     (hdl.type == VarHandle::kF) *static_cast<Float_t *>(hdl.ptr) = utils->strToFloat (input);
+  else if(hdl.type == VarHandle::kD) *static_cast<Double_t*>(hdl.ptr) = utils->strToDouble(input);
+  else                              AsrtVar(false,"(SetVarF) from handle");
+  return;
 }
 
 // ===========================================================================================================
@@ -402,6 +480,9 @@ void VarMaps::copyVarData(VarMaps * inObj, vector < pair<TString,TString> > * va
     }
   }
   else {
+    // all of the variables are copied directly, so all of the branches of the input must be read
+    inObj->activateAllBranches();
+
     for(Map <TString,Bool_t>     ::iterator itr=inObj->varB .begin(); itr!=inObj->varB .end(); ++itr) { if(HasVarB_ (itr->first)) SetVarB_ (itr->first,itr->second,false); }
     for(Map <TString,TObjString*>::iterator itr=inObj->varC .begin(); itr!=inObj->varC .end(); ++itr) { if(HasVarC_ (itr->first)) SetVarC_ (itr->first,itr->second->String(),false); }
     for(Map <TString,Short_t>    ::iterator itr=inObj->varS .begin(); itr!=inObj->varS .end(); ++itr) { if(HasVarS_ (itr->first)) SetVarS_ (itr->first,itr->second,false); }
@@ -439,16 +520,17 @@ void VarMaps::setDefaultVals(vector < pair<TString,TString> > * varTypeNameV) {
     }
   }
   else {
-    for(Map <TString,Bool_t>     ::iterator itr=varB .begin(); itr!=varB .end(); ++itr) { SetVarB_ (itr->first , DefOpts::DefB ); }
-    for(Map <TString,TObjString*>::iterator itr=varC .begin(); itr!=varC .end(); ++itr) { SetVarC_ (itr->first , DefOpts::DefC ); }
-    for(Map <TString,Short_t>    ::iterator itr=varS .begin(); itr!=varS .end(); ++itr) { SetVarS_ (itr->first , DefOpts::DefS ); }
-    for(Map <TString,Int_t>      ::iterator itr=varI .begin(); itr!=varI .end(); ++itr) { SetVarI_ (itr->first , DefOpts::DefI ); }
-    for(Map <TString,Long64_t>   ::iterator itr=varL .begin(); itr!=varL .end(); ++itr) { SetVarL_ (itr->first , DefOpts::DefL ); }
-    for(Map <TString,UShort_t>   ::iterator itr=varUS.begin(); itr!=varUS.end(); ++itr) { SetVarUS_(itr->first , DefOpts::DefUS); }
-    for(Map <TString,UInt_t>     ::iterator itr=varUI.begin(); itr!=varUI.end(); ++itr) { SetVarUI_(itr->first , DefOpts::DefUI); }
-    for(Map <TString,ULong64_t>  ::iterator itr=varUL.begin(); itr!=varUL.end(); ++itr) { SetVarUL_(itr->first , DefOpts::DefUL); }
-    for(Map <TString,Float_t>    ::iterator itr=varF .begin(); itr!=varF .end(); ++itr) { SetVarF_ (itr->first , DefOpts::DefF ); }
-    for(Map <TString,Double_t>   ::iterator itr=varD .begin(); itr!=varD .end(); ++itr) { SetVarD_ (itr->first , DefOpts::DefD ); }
+    // set the values in place, as there is no need to look up variables which are being iterated over
+    for(Map <TString,Bool_t>     ::iterator itr=varB .begin(); itr!=varB .end(); ++itr) { itr->second = DefOpts::DefB;             }
+    for(Map <TString,TObjString*>::iterator itr=varC .begin(); itr!=varC .end(); ++itr) { itr->second->SetString(DefOpts::DefC); }
+    for(Map <TString,Short_t>    ::iterator itr=varS .begin(); itr!=varS .end(); ++itr) { itr->second = DefOpts::DefS;             }
+    for(Map <TString,Int_t>      ::iterator itr=varI .begin(); itr!=varI .end(); ++itr) { itr->second = DefOpts::DefI;             }
+    for(Map <TString,Long64_t>   ::iterator itr=varL .begin(); itr!=varL .end(); ++itr) { itr->second = DefOpts::DefL;             }
+    for(Map <TString,UShort_t>   ::iterator itr=varUS.begin(); itr!=varUS.end(); ++itr) { itr->second = DefOpts::DefUS;            }
+    for(Map <TString,UInt_t>     ::iterator itr=varUI.begin(); itr!=varUI.end(); ++itr) { itr->second = DefOpts::DefUI;            }
+    for(Map <TString,ULong64_t>  ::iterator itr=varUL.begin(); itr!=varUL.end(); ++itr) { itr->second = DefOpts::DefUL;            }
+    for(Map <TString,Float_t>    ::iterator itr=varF .begin(); itr!=varF .end(); ++itr) { itr->second = DefOpts::DefF;             }
+    for(Map <TString,Double_t>   ::iterator itr=varD .begin(); itr!=varD .end(); ++itr) { itr->second = DefOpts::DefD;             }
   }
 
   return;
@@ -779,11 +861,10 @@ bool VarMaps::hasFailedTreeCuts(vector<TString> & cutTypeV) {
   for(int nCutTypeNow=0; nCutTypeNow<(int)cutTypeV.size(); nCutTypeNow++) {
     TString cutType = cutTypeV[nCutTypeNow];
 
-    bool        hasForm = (treeCutsFormM.find(cutType) != treeCutsFormM.end());
-    if(hasForm) hasForm = dynamic_cast<TTreeFormula*>(treeCutsFormM[cutType]);
-    VERIFY(LOCATION,(TString)" - VarMaps("+name+") has not setup treeCutsFormM (\""+cutType+"\") ...",hasForm);
+    Map <TString,TreeForm>::iterator itr = treeCutsFormM.find(cutType);
+    VERIFY(LOCATION,(TString)" - VarMaps("+name+") has not setup treeCutsFormM (\""+cutType+"\") ...",(itr != treeCutsFormM.end() && itr->second.isValid()));
 
-    if(treeCutsFormM[cutType]->EvalInstance() < 0.5)  { 
+    if(itr->second.Eval() < 0.5)  { 
       failedCutType = (TString)cutType+" [ "+treeCutsM[cutType]+" ]";
       IncCntr((TString)"failedCut: "+failedCutType);
       return true;
@@ -805,11 +886,10 @@ bool VarMaps::hasFailedTreeCuts(TString cutType) {
   for(int nCutTypeNow=0; nCutTypeNow<(int)cutsV.size(); nCutTypeNow++) {
     TString cutTypeNow = cutsV[nCutTypeNow];
 
-    bool        hasForm = (treeCutsFormM.find(cutTypeNow) != treeCutsFormM.end());
-    if(hasForm) hasForm = dynamic_cast<TTreeFormula*>(treeCutsFormM[cutTypeNow]);
-    VERIFY(LOCATION,(TString)" - VarMaps("+name+") has not setup treeCutsFormM (\""+cutTypeNow+"\") ...",hasForm);
+    Map <TString,TreeForm>::iterator itr = treeCutsFormM.find(cutTypeNow);
+    VERIFY(LOCATION,(TString)" - VarMaps("+name+") has not setup treeCutsFormM (\""+cutTypeNow+"\") ...",(itr != treeCutsFormM.end() && itr->second.isValid()));
 
-    if(treeCutsFormM[cutTypeNow]->EvalInstance() < 0.5)  { 
+    if(itr->second.Eval() < 0.5)  { 
       failedCutType = (TString)cutTypeNow+" [ "+treeCutsM[cutTypeNow]+" ]";
       IncCntr((TString)"failedCut: "+failedCutType);
       return true;
@@ -1003,6 +1083,11 @@ void VarMaps::createTreeBranches(TTree * tree, TString prefix, TString postfix,
     }
   }
 
+  // size the baskets of the output tree for one batch of nObjectsToWrite objects (see TreeFormat)
+  TreeFormat treeFormat;
+  treeFormat.Set("",glob->OptOrNullI("treeBasketKB"),0,glob->OptOrNullI("nObjectsToWrite"));
+  treeFormat.SetBaskets(treeWrite);
+
   return;
 }
 
@@ -1198,6 +1283,8 @@ void VarMaps::connectTreeBranches(TTree * tree, vector <TString> * excludedBranc
       else if(GetVarType(brnchName) == "UI") { AsrtVar(HasVarUI_(brnchName),brnchName); treeNow->SetBranchAddress(brnchName, &(varUI[brnchName])); }
       else if(GetVarType(brnchName) == "UL") { AsrtVar(HasVarUL_(brnchName),brnchName); treeNow->SetBranchAddress(brnchName, &(varUL[brnchName])); }
       else assert(false);
+
+      treeOfBranchM[brnchName] = treeNow;
     }
   }
 
@@ -1240,6 +1327,157 @@ void VarMaps::resetTreeBrancheAddresses(TTree * tree) {
   return ;
 }
 
+// ===========================================================================================================
+// connect a list of branches of a tree to existing variables, and deactivate all other branches of the tree.
+// unlike connectTreeBranches(), no variables are created and the tree is not registered as treeRead, so that
+// several (non-friend) trees may each set a different subset of the variables, which may also be written
+// to treeWrite in the same loop
+// ===========================================================================================================
+void VarMaps::connectTreeBranchesList(TTree * tree, vector <TString> & branchNameV) {
+// ==================================================================================
+  VERIFY(LOCATION,(TString)" - VarMaps("+name+") trying to use connectTreeBranchesList() with no input tree defined ...",(dynamic_cast<TTree*>(tree)));
+
+  tree->SetBranchStatus("*",0);
+
+  for(int nBrnchNow=0; nBrnchNow<(int)branchNameV.size(); nBrnchNow++) {
+    TString brnchName = branchNameV[nBrnchNow];
+    TString brnchType = GetVarType(brnchName);
+
+    tree->SetBranchStatus(brnchName,1);
+
+    if     (brnchType == "I" ) tree->SetBranchAddress(brnchName, &(varI [brnchName]));
+    else if(brnchType == "F" ) tree->SetBranchAddress(brnchName, &(varF [brnchName]));
+    else if(brnchType == "B" ) tree->SetBranchAddress(brnchName, &(varB [brnchName]));
+    else if(brnchType == "C" ) tree->SetBranchAddress(brnchName, &(varC [brnchName]));
+    else if(brnchType == "D" ) tree->SetBranchAddress(brnchName, &(varD [brnchName]));
+    else if(brnchType == "S" ) tree->SetBranchAddress(brnchName, &(varS [brnchName]));
+    else if(brnchType == "L" ) tree->SetBranchAddress(brnchName, &(varL [brnchName]));
+    else if(brnchType == "US") tree->SetBranchAddress(brnchName, &(varUS[brnchName]));
+    else if(brnchType == "UI") tree->SetBranchAddress(brnchName, &(varUI[brnchName]));
+    else if(brnchType == "UL") tree->SetBranchAddress(brnchName, &(varUL[brnchName]));
+    else AsrtVar(false,(TString)"(connectTreeBranchesList) "+brnchName);
+  }
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief   - Read only the branches of treeRead which are used, and set up a read-cache for these branches.
+ *
+ * @details - Should be called after connectTreeBranches(), before the first entry is read. All branches of treeRead
+ *          (and of its friends) are deactivated, except for those of variables which already have handles. A connected
+ *          branch is re-activated when the variable is first used - by a GetVar/SetVar method, by a handle, or by a
+ *          formula or cut - and is then also read for the current entry. A read-cache of treeCacheMB (shared between
+ *          treeRead and its friends) is set for the active branches. If selectTreeBranches is false, all branches stay
+ *          active, and only the read-cache is set. The number of bytes which were read is logged by clearTrees().
+ */
+// ===========================================================================================================
+void VarMaps::selectTreeBranches() {
+// =================================
+  VERIFY(LOCATION,(TString)" - VarMaps("+name+") trying to use selectTreeBranches() with no treeRead defined ...",(dynamic_cast<TTree*>(treeRead)));
+  VERIFY(LOCATION,(TString)" - VarMaps("+name+") trying to use selectTreeBranches() after reading from the tree ...",(nTreeInChain == -1));
+
+  vector <TTree*> treeV   = utils->getTreeFriends(treeRead);
+  treeV.insert(treeV.begin(),treeRead);
+
+  Long64_t cacheBytes     = (Long64_t)glob->OptOrNullI("treeCacheMB") * 1024 * 1024;
+  Long64_t cacheBytesTree = (cacheBytes > 0) ? max(cacheBytes / (Long64_t)treeV.size(),(Long64_t)(1024 * 1024)) : 0;
+
+  isBranchSel = glob->OptOrNullB("selectTreeBranches");
+
+  if(isBranchSel) {
+    for(int nTreeNow=0; nTreeNow<(int)treeV.size(); nTreeNow++) treeV[nTreeNow]->SetBranchStatus("*",0);
+
+    inactiveBranchM = treeOfBranchM;
+    for(Map <TString,bool>::iterator itr=handleVarM.begin(); itr!=handleVarM.end(); ++itr) touchBranch(itr->first);
+  }
+
+  if(cacheBytesTree > 0) {
+    for(int nTreeNow=0; nTreeNow<(int)treeV.size(); nTreeNow++) {
+      TTree * treeNow = treeV[nTreeNow];
+      treeNow->SetCacheSize(cacheBytesTree);
+
+      // if only the used branches are read, they are added to the cache explicitly (here or by activateBranch()),
+      // and otherwise the cache is filled with the branches which are read during the learning phase
+      if(!isBranchSel || !dynamic_cast<TFile*>(treeNow->GetCurrentFile())) continue;
+
+      for(Map <TString,TTree*>::iterator itr=treeOfBranchM.begin(); itr!=treeOfBranchM.end(); ++itr) {
+        if(itr->second != treeNow || inactiveBranchM.find(itr->first) != inactiveBranchM.end()) continue;
+        treeNow->AddBranchToCache(itr->first,true);
+      }
+      treeNow->StopCacheLearningPhase();
+    }
+  }
+
+  aLOG(Log::DEBUG) <<coutBlue<<" - VarMaps("<<coutYellow<<name<<coutBlue<<") - selectTreeBranches: "<<coutYellow<<isBranchSel
+                   <<coutBlue<<" , read-cache of "<<coutYellow<<treeV.size()<<coutBlue<<" trees: "
+                   <<coutYellow<<cacheBytesTree/(1024 * 1024)<<coutBlue<<" MB each ..."<<coutDef<<endl;
+
+  treeV.clear();
+  return;
+}
+
+// ===========================================================================================================
+// activate a deactivated branch of treeRead (or of one of its friends), and read the current entry of the branch
+// ===========================================================================================================
+void VarMaps::activateBranch(TString aName) {
+// ==========================================
+  Map <TString,TTree*>::iterator itr = inactiveBranchM.find(aName);
+  if(itr == inactiveBranchM.end()) return;
+
+  TTree * treeNow = itr->second;
+  inactiveBranchM.erase(itr);
+
+  treeNow->SetBranchStatus(aName,1);
+  if(treeNow->GetCacheSize() > 0 && dynamic_cast<TFile*>(treeNow->GetCurrentFile())) treeNow->AddBranchToCache(aName,true);
+
+  // the current tree of a chain, for which the entry has already been loaded
+  TTree * treeCur = treeNow->GetTree();
+  if(dynamic_cast<TTree*>(treeCur) && treeCur->GetReadEntry() >= 0) {
+    TBranch * brnch = treeCur->GetBranch(aName);
+    if(dynamic_cast<TBranch*>(brnch)) {
+      Int_t nBytes = brnch->GetEntry(treeCur->GetReadEntry());
+      if(nBytes > 0) nBytesRead += nBytes;
+    }
+  }
+
+  aLOG(Log::DEBUG_2) <<coutBlue<<" - VarMaps("<<coutYellow<<name<<coutBlue<<") - activated branch "<<coutGreen<<aName<<coutDef<<endl;
+  return;
+}
+
+// ===========================================================================================================
+void VarMaps::activateAllBranches() {
+// ==================================
+  if(!isBranchSel) return;
+
+  vector <TString> branchNameV;
+  for(Map <TString,TTree*>::iterator itr=inactiveBranchM.begin(); itr!=inactiveBranchM.end(); ++itr) branchNameV.push_back(itr->first);
+
+  for(int nBrnchNow=0; nBrnchNow<(int)branchNameV.size(); nBrnchNow++) activateBranch(branchNameV[nBrnchNow]);
+
+  branchNameV.clear();
+  return;
+}
+
+// ===========================================================================================================
+// log the number of (uncompressed) bytes which were read from treeRead and its friends, and the number of
+// branches which were read, out of the connected branches
+// ===========================================================================================================
+void VarMaps::printReadStats() {
+// =============================
+  if(nBytesRead <= 0) return;
+
+  int           nBranchesAll  = (int)treeOfBranchM.size();
+  int           nBranchesRead = nBranchesAll - (int)inactiveBranchM.size();
+  Log::LOGtypes logLevel      = isBranchSel ? Log::INFO : Log::DEBUG;
+
+  aLOG(logLevel) <<coutBlue<<" - VarMaps("<<coutYellow<<name<<coutBlue<<") read "<<coutYellow<<TString::Format("%.4g",nBytesRead/(1024. * 1024.))
+                 <<coutBlue<<" MB (uncompressed) from "<<coutYellow<<nBranchesRead<<coutBlue<<" of "<<coutYellow<<nBranchesAll<<coutBlue
+                 <<" connected branches of "<<coutGreen<<treeReadName<<coutBlue<<" ..."<<coutDef<<endl;
+  return;
+}
+
 // ===========================================================================================================
 void VarMaps::addReaderFormulae(vector < pair<TString,Float_t> > & readerInptV) {
 // ==============================================================================
@@ -1259,12 +1497,39 @@ void VarMaps::addReaderFormulae(vector < pair<TString,Float_t> > & readerInptV)
 void VarMaps::updateReaderFormulae(vector < pair<TString,Float_t> > & readerInptV, bool forceUpdate) {
 // ===================================================================================================
   if(!forceUpdate && !needReaderUpdate) return;
-  
-  for(int nReaderInputNow=0; nReaderInputNow<(int)readerInptV.size(); nReaderInputNow++) {
-    TString inputName = readerInptV[nReaderInputNow].first;
-    TString formName  = readerFormNameKey+inputName;
 
-    readerInptV[nReaderInputNow].second = GetForm(formName);
+  int nReaderInputs = (int)readerInptV.size();
+
+  // the formulae of the inputs are looked up by name only once for each input vector (the elements of
+  // varFormM are not moved, so the pointers remain valid, and are only (re)set in setTreeForms())
+  // -----------------------------------------------------------------------------------------------------------
+  pair < vector<TString>,vector<TreeForm*> > & readerForms = readerFormM[&readerInptV];
+
+  bool needLookup = ((int)readerForms.first.size() != nReaderInputs);
+  for(int nReaderInputNow=0; nReaderInputNow<nReaderInputs; nReaderInputNow++) {
+    if(needLookup) break;
+    needLookup = (readerForms.first[nReaderInputNow] != readerInptV[nReaderInputNow].first);
+  }
+
+  if(needLookup) {
+    readerForms.first.resize(nReaderInputs); readerForms.second.resize(nReaderInputs);
+
+    for(int nReaderInputNow=0; nReaderInputNow<nReaderInputs; nReaderInputNow++) {
+      TString inputName = readerInptV[nReaderInputNow].first;
+      TString formName  = readerFormNameKey+inputName;
+
+      Map <TString,TreeForm>::iterator itr = varFormM.find(formName);
+      VERIFY(LOCATION,(TString)" - VarMaps("+name+") - has not setup varFormM (\""+formName+"\") ...",(itr != varFormM.end()));
+
+      readerForms.first[nReaderInputNow] = inputName; readerForms.second[nReaderInputNow] = &(itr->second);
+    }
+  }
+
+  for(int nReaderInputNow=0; nReaderInputNow<nReaderInputs; nReaderInputNow++) {
+    TreeForm * treeForm = readerForms.second[nReaderInputNow];
+    VERIFY(LOCATION,(TString)" - VarMaps("+name+") - has not setup varFormM (\""+readerForms.first[nReaderInputNow]+"\") ...",treeForm->isValid());
+
+    readerInptV[nReaderInputNow].second = treeForm->Eval();
   }
   needReaderUpdate = false;
 
@@ -1285,7 +1550,17 @@ bool VarMaps::getTreeEntry(int nEntry, bool getEntryIndex) {
   if(!getEntryIndex) loopTreeEntryTest = treeRead->GetEntry(nEntry);
   else               loopTreeEntryTest = treeRead->GetEntryWithIndex(nEntry);
 
-  if(loopTreeEntryTest == 0 || loopTreeEntryTest == -1) return false;  //{ setDefaultVals(); return false; }
+  // with selectTreeBranches, all of the branches may be inactive (until the variables are first used), in which
+  // case no bytes are read, even for a valid entry
+  bool isEmptyRead(false);
+  if(loopTreeEntryTest == 0 && isBranchSel) {
+    Long64_t nEntrySerial = getEntryIndex ? treeRead->GetEntryNumberWithIndex(nEntry) : (Long64_t)nEntry;
+    isEmptyRead = (nEntrySerial >= 0 && treeRead->LoadTree(nEntrySerial) >= 0);
+  }
+
+  if(!isEmptyRead && (loopTreeEntryTest == 0 || loopTreeEntryTest == -1)) return false;  //{ setDefaultVals(); return false; }
+
+  nBytesRead += loopTreeEntryTest;
 
   // -----------------------------------------------------------------------------------------------------------
   // check if need to reset formulae for cuts and for varForm due to change in number of tree file in the chain
@@ -1360,9 +1635,12 @@ void VarMaps::setTreeForms(bool isFirstEntry) {
 // ============================================
   VERIFY(LOCATION,(TString)" - VarMaps("+name+") trying to use setTreeForms() with no treeRead defined ...",(dynamic_cast<TTree*>(treeRead)));
   
+  bool useCompiledForms = glob->OptOrNullB("useCompiledForms");
+  int  nFormsCompiled(0), nFormsTree(0);
+
   for(int nFormType=0; nFormType<2; nFormType++) {
-    Map <TString,TString>       * nameMap;
-    Map <TString,TTreeFormula*> * formMap;
+    Map <TString,TString>  * nameMap;
+    Map <TString,TreeForm> * formMap;
     // cuts
     if(nFormType == 0) {
       nameMap = & treeCutsM;
@@ -1386,20 +1664,101 @@ void VarMaps::setTreeForms(bool isFirstEntry) {
 
         // cout <<"setTreeForms  "<<treeForm<<CT<<treeFormName<<CT<<(TString)aCut<<endl;
         
-        if(formMap->find(itr->first) != formMap->end()) DELNULL((*formMap)[itr->first]);
-        (*formMap)[itr->first] = new TTreeFormula(treeFormName,(TCut)aCut,treeRead);
-       
-        VERIFY(LOCATION,(TString)" - VarMaps("+name+") TTreeFormula is not valid (\""+(TString)aCut+"\") ...",((*formMap)[itr->first]->GetNdim() != 0));
+        TreeForm & formNow = (*formMap)[itr->first];
+        formNow.clear();
+
+        // use a compiled expression if possible, and otherwise fall back to a TTreeFormula
+        if(useCompiledForms) {
+          formNow.expr = compileFormExpr(aCut);
+
+          if(!formNow.expr) {
+            aLOG(Log::DEBUG_1) <<coutPurple<<" - VarMaps("<<coutYellow<<name<<coutPurple<<") - can not compile \""
+                               <<coutYellow<<aCut<<coutPurple<<"\" - will use TTreeFormula ..."<<coutDef<<endl;
+          }
+        }
+
+        if(formNow.expr) nFormsCompiled++;
+        else {
+          formNow.form = new TTreeFormula(treeFormName,(TCut)aCut,treeRead);
+          VERIFY(LOCATION,(TString)" - VarMaps("+name+") TTreeFormula is not valid (\""+(TString)aCut+"\") ...",(formNow.form->GetNdim() != 0));
+
+          // make sure that all of the branches used by the formula are read
+          if(isBranchSel) {
+            for(int nCodeNow=0; nCodeNow<formNow.form->GetNcodes(); nCodeNow++) {
+              TLeaf * leaf = formNow.form->GetLeaf(nCodeNow);
+              if(dynamic_cast<TLeaf*>(leaf)) touchBranch(leaf->GetBranch()->GetName());
+            }
+          }
+
+          nFormsTree++;
+        }
       }
     }
     else {
-      for(Map <TString,TTreeFormula*>::iterator itr=formMap->begin(); itr!=formMap->end(); ++itr) itr->second->UpdateFormulaLeaves();
+      // compiled expressions are bound to the variables of the VarMaps, and so do not need to be updated
+      for(Map <TString,TreeForm>::iterator itr=formMap->begin(); itr!=formMap->end(); ++itr) {
+        if(itr->second.form) itr->second.form->UpdateFormulaLeaves();
+      }
     }
   }
 
+  if(isFirstEntry && (nFormsCompiled + nFormsTree > 0)) {
+    aLOG(Log::DEBUG_1) <<coutPurple<<" - VarMaps("<<coutYellow<<name<<coutPurple<<") - compiled "<<coutYellow<<nFormsCompiled
+                       <<coutPurple<<" formulae, and using TTreeFormula for "<<coutYellow<<nFormsTree<<coutPurple<<" ..."<<coutDef<<endl;
+  }
+
   return;
 }
 
+// ===========================================================================================================
+/**
+ * @brief          - Compile an expression of the variables of treeRead.
+ *
+ * @details        - All variables of the expression must be numerical branches of treeRead, which are active, and
+ *                 are read directly into the variables of this VarMaps (i.e., the tree was connected with
+ *                 connectTreeBranches()). The compiled expression is then bound to the addresses of the variables.
+ *
+ * @param exprIn   - The expression.
+ *
+ * @return         - The compiled expression (owned by the caller), or NULL if the expression is not supported.
+ */
+// ===========================================================================================================
+FormExpr * VarMaps::compileFormExpr(TString exprIn) {
+// ===========================================================================================================
+  FormExpr * formExpr = new FormExpr();
+  bool     isGood     = formExpr->Compile(exprIn);
+
+  for(int nVarNow=0; nVarNow<formExpr->GetNvars(); nVarNow++) {
+    if(!isGood) break;
+
+    TString varName = formExpr->GetVarName(nVarNow);
+    TString varType = HasVar(varName) ? GetVarType(varName) : (TString)"";
+    
+    // formulae and strings are not supported (nb, GetVarHandle() may not be used for formulae here, as it
+    // might add elements to varFormM)
+    char typeNow(0);
+    if     (varType == "F" ) typeNow = 'F'; else if(varType == "D" ) typeNow = 'D';
+    else if(varType == "I" ) typeNow = 'I'; else if(varType == "S" ) typeNow = 'S'; else if(varType == "L" ) typeNow = 'L';
+    else if(varType == "UI") typeNow = 'i'; else if(varType == "US") typeNow = 's'; else if(varType == "UL") typeNow = 'l';
+    else if(varType == "B" ) typeNow = 'O';
+
+    isGood = (typeNow != 0);
+    if(!isGood) break;
+
+    VarHandle hdl    = GetVarHandle(varName);
+    TBranch   * brnch = treeRead->GetBranch(varName);
+
+    isGood = (dynamic_cast<TBranch*>(brnch) && treeRead->GetBranchStatus(varName) && (brnch->GetAddress() == static_cast<char*>(hdl.ptr)));
+    if(!isGood) break;
+
+    formExpr->BindVar(nVarNow,typeNow,hdl.ptr);
+  }
+
+  if(!isGood) DELNULL(formExpr);
+
+  return formExpr;
+}
+
 // ===========================================================================================================
 void VarMaps::storeTreeToAscii(TString outFilePrefix, TString outFileDir, int maxNobj, int nLinesFile,
                                TString treeCuts, vector <TString> * acceptV, vector <TString> * rejectV) {
@@ -0,0 +1,518 @@
+// ===========================================================================================================
+// Copyright (C) 2015, Iftach Sadeh
+//
+// This file is part of ANNZ.
+// ANNZ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ===========================================================================================================
+
+// ===========================================================================================================
+// helper functions for FormExpr
+// ===========================================================================================================
+namespace formExprFuncs {
+  // the number of entries which are evaluated together by FormExpr::EvalBatch()
+  const int nBlock = 256;
+
+  // the special cases of the functions follow TFormula (as used by TTreeFormula), so that the results of a
+  // compiled expression and of the equivalent TTreeFormula are the same
+  inline Double_t safeDiv  (Double_t a, Double_t b) { return (b == 0) ? 0 : a/b;                                }
+  inline Double_t safeSqrt (Double_t a)             { return sqrt(fabs(a));                                     }
+  inline Double_t safeLog  (Double_t a)             { return (a > 0) ? log(a)   : 0;                            }
+  inline Double_t safeLog10(Double_t a)             { return (a > 0) ? log10(a) : 0;                            }
+  inline Double_t safeExp  (Double_t a)             { return (a < -700) ? 0 : ((a > 709) ? exp(709) : exp(a)); }
+
+  // load the values of a variable into a block
+  template <typename T> inline void loadBlock(const char * ptr, Long64_t stride, int nEntries, Double_t * outV) {
+    for(int nEntryNow=0; nEntryNow<nEntries; nEntryNow++) {
+      outV[nEntryNow] = static_cast<Double_t>(*reinterpret_cast<const T*>(ptr + nEntryNow * stride));
+    }
+    return;
+  }
+
+  // the functions which are supported, with the corresponding number of arguments
+  struct FuncDef { const char * name; int op, nArgs; };
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Check if a leaf type may be used for a variable of a FormExpr.
+ */
+// ===========================================================================================================
+bool FormExpr::isTypeSupported(char type) {
+// ===========================================================================================================
+  return (type == 'F' || type == 'D' || type == 'I' || type == 'S' || type == 'L' ||
+          type == 'i' || type == 's' || type == 'l' || type == 'O');
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Parse an expression into the bytecode of the FormExpr.
+ *
+ * @details        - After a successful compilation, the variables of the expression (GetNvars(), GetVarName())
+ *                 must all be bound by BindVar() before the expression is evaluated.
+ *
+ * @param expr     - The expression.
+ *
+ * @return         - false if the expression is not supported.
+ */
+// ===========================================================================================================
+bool FormExpr::Compile(TString expr) {
+// ===========================================================================================================
+  exprIn = expr;
+  opV.clear(); opVarV.clear(); opValV.clear(); maxDepth = 0;
+  varNameV.clear(); varTypeV.clear(); varPtrV.clear(); varStrideV.clear();
+
+  Parser parser(this,expr);
+  if(!parser.parse()) return false;
+
+  int nVars = (int)varNameV.size();
+  varTypeV.resize(nVars,0); varPtrV.resize(nVars,NULL); varStrideV.resize(nVars,0);
+
+  stackV.resize(max(maxDepth,1));
+
+  return true;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Bind a variable of the expression to the memory of its value.
+ *
+ * @param nVar     - The index of the variable (see GetVarName()).
+ * @param type     - The leaf type of the variable (see isTypeSupported()).
+ * @param ptr      - The address of the value (of the first entry for EvalBatch()).
+ * @param stride   - The distance in bytes between consecutive entries for EvalBatch().
+ */
+// ===========================================================================================================
+void FormExpr::BindVar(int nVar, char type, const void * ptr, Long64_t stride) {
+// ===========================================================================================================
+  VERIFY(LOCATION,(TString)" - FormExpr(\""+exprIn+"\") - bad variable index or type in BindVar() ...",
+                           (nVar >= 0 && nVar < GetNvars() && isTypeSupported(type) && ptr));
+
+  varTypeV[nVar] = type; varPtrV[nVar] = static_cast<const char*>(ptr); varStrideV[nVar] = stride;
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Evaluate the expression for the current values of the variables.
+ */
+// ===========================================================================================================
+Double_t FormExpr::Eval() {
+// ===========================================================================================================
+  using namespace formExprFuncs;
+
+  Double_t * stk   = &(stackV[0]);
+  int      nStk    = -1;
+  int      nOps    = (int)opV.size();
+
+  for(int nOpNow=0; nOpNow<nOps; nOpNow++) {
+    switch(opV[nOpNow]) {
+      case kConst: nStk++; stk[nStk] = opValV[nOpNow];            break;
+      case kVar:   nStk++; stk[nStk] = getVal(opVarV[nOpNow],0);  break;
+      case kNeg:   stk[nStk] = -stk[nStk];                        break;
+      case kNot:   stk[nStk] = (stk[nStk] == 0) ? 1 : 0;          break;
+      case kAbs:   stk[nStk] = fabs(stk[nStk]);                   break;
+      case kSqrt:  stk[nStk] = safeSqrt(stk[nStk]);               break;
+      case kExp:   stk[nStk] = safeExp(stk[nStk]);                break;
+      case kLog:   stk[nStk] = safeLog(stk[nStk]);                break;
+      case kLog10: stk[nStk] = safeLog10(stk[nStk]);              break;
+      case kSin:   stk[nStk] = sin(stk[nStk]);                    break;
+      case kCos:   stk[nStk] = cos(stk[nStk]);                    break;
+      case kTan:   stk[nStk] = tan(stk[nStk]);                    break;
+      case kAdd:   nStk--; stk[nStk] = stk[nStk] +  stk[nStk+1];                       break;
+      case kSub:   nStk--; stk[nStk] = stk[nStk] -  stk[nStk+1];                       break;
+      case kMul:   nStk--; stk[nStk] = stk[nStk] *  stk[nStk+1];                       break;
+      case kDiv:   nStk--; stk[nStk] = safeDiv(stk[nStk],stk[nStk+1]);                 break;
+      case kLT:    nStk--; stk[nStk] = (stk[nStk] <  stk[nStk+1]) ? 1 : 0;             break;
+      case kLE:    nStk--; stk[nStk] = (stk[nStk] <= stk[nStk+1]) ? 1 : 0;             break;
+      case kGT:    nStk--; stk[nStk] = (stk[nStk] >  stk[nStk+1]) ? 1 : 0;             break;
+      case kGE:    nStk--; stk[nStk] = (stk[nStk] >= stk[nStk+1]) ? 1 : 0;             break;
+      case kEQ:    nStk--; stk[nStk] = (stk[nStk] == stk[nStk+1]) ? 1 : 0;             break;
+      case kNE:    nStk--; stk[nStk] = (stk[nStk] != stk[nStk+1]) ? 1 : 0;             break;
+      case kAnd:   nStk--; stk[nStk] = (stk[nStk] != 0 && stk[nStk+1] != 0) ? 1 : 0;   break;
+      case kOr:    nStk--; stk[nStk] = (stk[nStk] != 0 || stk[nStk+1] != 0) ? 1 : 0;   break;
+      case kPow:   nStk--; stk[nStk] = pow(stk[nStk],stk[nStk+1]);                     break;
+      case kMin:   nStk--; stk[nStk] = min(stk[nStk],stk[nStk+1]);                     break;
+      case kMax:   nStk--; stk[nStk] = max(stk[nStk],stk[nStk+1]);                     break;
+    }
+  }
+
+  return stk[0];
+}
+
+// ===========================================================================================================
+/**
+ * @brief          - Evaluate the expression for consecutive entries of the variables.
+ *
+ * @details        - The entries are processed in blocks of formExprFuncs::nBlock, where each operation of the
+ *                 bytecode is applied to the full block at once (the stack holds a block of values per level),
+ *                 so that the loops over the entries may be vectorised by the compiler.
+ *
+ * @param nEntries - The number of entries (the values of entry n of a variable are at ptr+n*stride).
+ * @param outV     - The output array (of size nEntries).
+ */
+// ===========================================================================================================
+void FormExpr::EvalBatch(Long64_t nEntries, Double_t * outV) {
+// ===========================================================================================================
+  using namespace formExprFuncs;
+
+  for(int nVarNow=0; nVarNow<GetNvars(); nVarNow++) {
+    VERIFY(LOCATION,(TString)" - FormExpr(\""+exprIn+"\") - variable "+varNameV[nVarNow]+" is not bound ...",(varPtrV[nVarNow] != NULL));
+  }
+
+  blockV.resize(max(maxDepth,1) * nBlock);
+
+  int nOps = (int)opV.size();
+
+  for(Long64_t nEntryStart=0; nEntryStart<nEntries; nEntryStart+=nBlock) {
+    int nEnt = static_cast<int>(min(static_cast<Long64_t>(nBlock),nEntries-nEntryStart));
+    int nStk = -1;
+
+    for(int nOpNow=0; nOpNow<nOps; nOpNow++) {
+      int op = opV[nOpNow];
+
+      // operations which add a level to the stack
+      // -----------------------------------------------------------------------------------------------------------
+      if(op == kConst || op == kVar) {
+        nStk++;
+        Double_t * a = &(blockV[nStk*nBlock]);
+
+        if(op == kConst) {
+          Double_t val = opValV[nOpNow];
+          for(int n=0; n<nEnt; n++) a[n] = val;
+        }
+        else {
+          int          nVar   = opVarV[nOpNow];
+          Long64_t     stride = varStrideV[nVar];
+          const char * ptr    = varPtrV[nVar] + nEntryStart * stride;
+
+          switch(varTypeV[nVar]) {
+            case 'F': loadBlock<Float_t>  (ptr,stride,nEnt,a); break;
+            case 'D': loadBlock<Double_t> (ptr,stride,nEnt,a); break;
+            case 'I': loadBlock<Int_t>    (ptr,stride,nEnt,a); break;
+            case 'S': loadBlock<Short_t>  (ptr,stride,nEnt,a); break;
+            case 'L': loadBlock<Long64_t> (ptr,stride,nEnt,a); break;
+            case 'i': loadBlock<UInt_t>   (ptr,stride,nEnt,a); break;
+            case 's': loadBlock<UShort_t> (ptr,stride,nEnt,a); break;
+            case 'l': loadBlock<ULong64_t>(ptr,stride,nEnt,a); break;
+            case 'O': loadBlock<Bool_t>   (ptr,stride,nEnt,a); break;
+          }
+        }
+        continue;
+      }
+
+      // unary operations
+      // -----------------------------------------------------------------------------------------------------------
+      Double_t * a = &(blockV[nStk*nBlock]);
+      switch(op) {
+        case kNeg:   for(int n=0; n<nEnt; n++) a[n] = -a[n];                  continue;
+        case kNot:   for(int n=0; n<nEnt; n++) a[n] = (a[n] == 0) ? 1 : 0;    continue;
+        case kAbs:   for(int n=0; n<nEnt; n++) a[n] = fabs(a[n]);             continue;
+        case kSqrt:  for(int n=0; n<nEnt; n++) a[n] = safeSqrt(a[n]);         continue;
+        case kExp:   for(int n=0; n<nEnt; n++) a[n] = safeExp(a[n]);          continue;
+        case kLog:   for(int n=0; n<nEnt; n++) a[n] = safeLog(a[n]);          continue;
+        case kLog10: for(int n=0; n<nEnt; n++) a[n] = safeLog10(a[n]);        continue;
+        case kSin:   for(int n=0; n<nEnt; n++) a[n] = sin(a[n]);              continue;
+        case kCos:   for(int n=0; n<nEnt; n++) a[n] = cos(a[n]);              continue;
+        case kTan:   for(int n=0; n<nEnt; n++) a[n] = tan(a[n]);              continue;
+      }
+
+      // binary operations
+      // -----------------------------------------------------------------------------------------------------------
+      nStk--;
+      a = &(blockV[nStk*nBlock]);
+      const Double_t * b = &(blockV[(nStk+1)*nBlock]);
+
+      switch(op) {
+        case kAdd: for(int n=0; n<nEnt; n++) a[n] = a[n] +  b[n];                       break;
+        case kSub: for(int n=0; n<nEnt; n++) a[n] = a[n] -  b[n];                       break;
+        case kMul: for(int n=0; n<nEnt; n++) a[n] = a[n] *  b[n];                       break;
+        case kDiv: for(int n=0; n<nEnt; n++) a[n] = safeDiv(a[n],b[n]);                 break;
+        case kLT:  for(int n=0; n<nEnt; n++) a[n] = (a[n] <  b[n]) ? 1 : 0;             break;
+        case kLE:  for(int n=0; n<nEnt; n++) a[n] = (a[n] <= b[n]) ? 1 : 0;             break;
+        case kGT:  for(int n=0; n<nEnt; n++) a[n] = (a[n] >  b[n]) ? 1 : 0;             break;
+        case kGE:  for(int n=0; n<nEnt; n++) a[n] = (a[n] >= b[n]) ? 1 : 0;             break;
+        case kEQ:  for(int n=0; n<nEnt; n++) a[n] = (a[n] == b[n]) ? 1 : 0;             break;
+        case kNE:  for(int n=0; n<nEnt; n++) a[n] = (a[n] != b[n]) ? 1 : 0;             break;
+        case kAnd: for(int n=0; n<nEnt; n++) a[n] = (a[n] != 0 && b[n] != 0) ? 1 : 0;   break;
+        case kOr:  for(int n=0; n<nEnt; n++) a[n] = (a[n] != 0 || b[n] != 0) ? 1 : 0;   break;
+        case kPow: for(int n=0; n<nEnt; n++) a[n] = pow(a[n],b[n]);                     break;
+        case kMin: for(int n=0; n<nEnt; n++) a[n] = min(a[n],b[n]);                     break;
+        case kMax: for(int n=0; n<nEnt; n++) a[n] = max(a[n],b[n]);                     break;
+      }
+    }
+
+    memcpy(outV + nEntryStart, &(blockV[0]), nEnt * sizeof(Double_t));
+  }
+
+  return;
+}
+
+// ===========================================================================================================
+// the parser - a recursive descent over the operators, ordered by increasing precedence (as in C++):
+//   [||] , [&&] , [==,!=] , [<,<=,>,>=] , [+,-] , [*,/] , unary [-,+,!] , and then constants, variables,
+//   functions and parentheses. the bytecode is added in reverse-polish order, such that a stack machine may
+//   evaluate it directly.
+// ===========================================================================================================
+bool FormExpr::Parser::parse() {
+// ===========================================================================================================
+  parseOr();
+
+  while(pos < expr.Length() && isspace(static_cast<unsigned char>(expr[pos]))) pos++;
+
+  return (isGood && pos == expr.Length() && (int)formExpr->opV.size() > 0);
+}
+
+// ===========================================================================================================
+bool FormExpr::Parser::accept(const char * token) {
+// ===========================================================================================================
+  while(pos < expr.Length() && isspace(static_cast<unsigned char>(expr[pos]))) pos++;
+
+  int tokenLen = (int)strlen(token);
+  if(pos + tokenLen > expr.Length())                 return false;
+  if(strncmp(expr.Data() + pos,token,tokenLen) != 0) return false;
+
+  // make sure that e.g., "<" is not accepted as the beginning of "<<" or "<=", and "!" not as the beginning of "!="
+  if(tokenLen == 1 && pos + 1 < expr.Length()) {
+    char nextChar = expr[pos+1];
+    if((token[0] == '<' || token[0] == '>') && (nextChar == token[0] || nextChar == '=')) return false;
+    if((token[0] == '!' || token[0] == '=') &&  nextChar == '=')                          return false;
+    if((token[0] == '&' || token[0] == '|') &&  nextChar == token[0])                     return false;
+  }
+
+  pos += tokenLen;
+  return true;
+}
+
+// ===========================================================================================================
+void FormExpr::Parser::parseOr() {
+// ===========================================================================================================
+  parseAnd();
+  while(isGood && accept("||")) { parseAnd(); addOp(kOr,2); }
+  return;
+}
+// ===========================================================================================================
+void FormExpr::Parser::parseAnd() {
+// ===========================================================================================================
+  parseEquality();
+  while(isGood && accept("&&")) { parseEquality(); addOp(kAnd,2); }
+  return;
+}
+// ===========================================================================================================
+void FormExpr::Parser::parseEquality() {
+// ===========================================================================================================
+  parseRelation();
+  while(isGood) {
+    if     (accept("==")) { parseRelation(); addOp(kEQ,2); }
+    else if(accept("!=")) { parseRelation(); addOp(kNE,2); }
+    else break;
+  }
+  return;
+}
+// ===========================================================================================================
+void FormExpr::Parser::parseRelation() {
+// ===========================================================================================================
+  parseSum();
+  while(isGood) {
+    if     (accept("<=")) { parseSum(); addOp(kLE,2); }
+    else if(accept(">=")) { parseSum(); addOp(kGE,2); }
+    else if(accept("<" )) { parseSum(); addOp(kLT,2); }
+    else if(accept(">" )) { parseSum(); addOp(kGT,2); }
+    else break;
+  }
+  return;
+}
+// ===========================================================================================================
+void FormExpr::Parser::parseSum() {
+// ===========================================================================================================
+  parseProduct();
+  while(isGood) {
+    if     (accept("+")) { parseProduct(); addOp(kAdd,2); }
+    else if(accept("-")) { parseProduct(); addOp(kSub,2); }
+    else break;
+  }
+  return;
+}
+// ===========================================================================================================
+void FormExpr::Parser::parseProduct() {
+// ===========================================================================================================
+  parseUnary();
+  while(isGood) {
+    if     (accept("*")) { parseUnary(); addOp(kMul,2); }
+    else if(accept("/")) { parseUnary(); addOp(kDiv,2); }
+    else break;
+  }
+  return;
+}
+// ===========================================================================================================
+void FormExpr::Parser::parseUnary() {
+// ===========================================================================================================
+  if     (accept("-")) { parseUnary(); addOp(kNeg,1); }
+  else if(accept("+")) { parseUnary();                }
+  else if(accept("!")) { parseUnary(); addOp(kNot,1); }
+  else                   parsePrimary();
+  return;
+}
+// ===========================================================================================================
+void FormExpr::Parser::parsePrimary() {
+// ===========================================================================================================
+  using namespace formExprFuncs;
+
+  if(!isGood) return;
+
+  if(accept("(")) {
+    parseOr();
+    if(!accept(")")) isGood = false;
+    return;
+  }
+
+  if(parseNumber()) return;
+
+  TString nameNow("");
+  if(!parseName(nameNow)) { isGood = false; return; }
+
+  // a function call
+  // -----------------------------------------------------------------------------------------------------------
+  if(accept("(")) {
+    static const FuncDef funcDefs[] = {
+      {"abs",   kAbs,  1}, {"fabs",  kAbs,  1}, {"TMath::Abs",  kAbs,  1},
+      {"sqrt",  kSqrt, 1}, {"TMath::Sqrt",  kSqrt,  1},
+      {"exp",   kExp,  1}, {"TMath::Exp",   kExp,   1},
+      {"log",   kLog,  1}, {"TMath::Log",   kLog,   1},
+      {"log10", kLog10,1}, {"TMath::Log10", kLog10, 1},
+      {"sin",   kSin,  1}, {"TMath::Sin",   kSin,   1},
+      {"cos",   kCos,  1}, {"TMath::Cos",   kCos,   1},
+      {"tan",   kTan,  1}, {"TMath::Tan",   kTan,   1},
+      {"pow",   kPow,  2}, {"TMath::Power", kPow,   2},
+      {"min",   kMin,  2}, {"TMath::Min",   kMin,   2},
+      {"max",   kMax,  2}, {"TMath::Max",   kMax,   2}
+    };
+    int nFuncDefs = (int)(sizeof(funcDefs)/sizeof(funcDefs[0]));
+
+    int nFunc(-1);
+    for(int nFuncNow=0; nFuncNow<nFuncDefs; nFuncNow++) {
+      if(nameNow == funcDefs[nFuncNow].name) { nFunc = nFuncNow; break; }
+    }
+    if(nFunc < 0) { isGood = false; return; }
+
+    for(int nArgNow=0; nArgNow<funcDefs[nFunc].nArgs; nArgNow++) {
+      if(nArgNow > 0 && !accept(",")) { isGood = false; return; }
+      parseOr();
+      if(!isGood) return;
+    }
+    if(!accept(")")) { isGood = false; return; }
+
+    addOp(static_cast<OpCode>(funcDefs[nFunc].op),funcDefs[nFunc].nArgs);
+    return;
+  }
+
+  // a variable - names with a namespace (e.g., TMath::Pi) are not supported
+  // -----------------------------------------------------------------------------------------------------------
+  if(nameNow.Contains("::")) { isGood = false; return; }
+
+  vector <TString> & varNameV = formExpr->varNameV;
+
+  int nVar = (int)(find(varNameV.begin(),varNameV.end(),nameNow) - varNameV.begin());
+  if(nVar == (int)varNameV.size()) varNameV.push_back(nameNow);
+
+  addOp(kVar,0,0,nVar);
+  return;
+}
+// ===========================================================================================================
+bool FormExpr::Parser::parseNumber() {
+// ===========================================================================================================
+  while(pos < expr.Length() && isspace(static_cast<unsigned char>(expr[pos]))) pos++;
+  if(pos >= expr.Length()) return false;
+
+  char charNow  = expr[pos];
+  char charNext = (pos + 1 < expr.Length()) ? expr[pos+1] : 0;
+
+  bool isNumber = (isdigit(static_cast<unsigned char>(charNow)) || (charNow == '.' && isdigit(static_cast<unsigned char>(charNext))));
+  if(!isNumber) return false;
+
+  // hexadecimal numbers are not supported
+  if(charNow == '0' && (charNext == 'x' || charNext == 'X')) { isGood = false; return true; }
+
+  const char * start = expr.Data() + pos;
+  char       * end(NULL);
+  Double_t   val = strtod(start,&end);
+
+  if(end == start) { isGood = false; return true; }
+  pos += (int)(end - start);
+
+  // e.g., "2x" is not a valid expression
+  if(pos < expr.Length() && (isalpha(static_cast<unsigned char>(expr[pos])) || expr[pos] == '_')) { isGood = false; return true; }
+
+  addOp(kConst,0,val);
+  return true;
+}
+// ===========================================================================================================
+bool FormExpr::Parser::parseName(TString & nameOut) {
+// ===========================================================================================================
+  while(pos < expr.Length() && isspace(static_cast<unsigned char>(expr[pos]))) pos++;
+
+  int posStart(pos);
+  while(pos < expr.Length()) {
+    char charNow = expr[pos];
+    if(isalnum(static_cast<unsigned char>(charNow)) || charNow == '_') { pos++; continue; }
+
+    // the scope operator (e.g., for TMath::Abs)
+    if(charNow == ':' && pos + 2 < expr.Length() && expr[pos+1] == ':' && pos > posStart) { pos += 2; continue; }
+    break;
+  }
+
+  if(pos == posStart || isdigit(static_cast<unsigned char>(expr[posStart]))) return false;
+
+  nameOut = expr(posStart,pos-posStart);
+  return true;
+}
+// ===========================================================================================================
+void FormExpr::Parser::addOp(OpCode op, int nPop, Double_t val, int nVar) {
+// ===========================================================================================================
+  if(!isGood) return;
+
+  vector <int>      & opV    = formExpr->opV;
+  vector <int>      & opVarV = formExpr->opVarV;
+  vector <Double_t> & opValV = formExpr->opValV;
+
+  // fold operations on constants (the operand of an operation is a single constant only if the
+  // last bytecode of the operand is a constant)
+  // -----------------------------------------------------------------------------------------------------------
+  int nOps = (int)opV.size();
+  if(nPop > 0 && nOps >= nPop) {
+    bool isConst(true);
+    for(int nPopNow=0; nPopNow<nPop; nPopNow++) { if(opV[nOps-1-nPopNow] != kConst) isConst = false; }
+
+    if(isConst) {
+      FormExpr constExpr;
+      constExpr.opV   .assign(opV   .end()-nPop, opV   .end()); constExpr.opV.push_back(op);
+      constExpr.opVarV.assign(opVarV.end()-nPop, opVarV.end()); constExpr.opVarV.push_back(nVar);
+      constExpr.opValV.assign(opValV.end()-nPop, opValV.end()); constExpr.opValV.push_back(val);
+      constExpr.stackV.resize(nPop);
+
+      Double_t valFold = constExpr.Eval();
+
+      opV.resize(nOps-nPop); opVarV.resize(nOps-nPop); opValV.resize(nOps-nPop);
+      depth -= nPop;
+
+      op = kConst; nPop = 0; val = valFold; nVar = -1;
+    }
+  }
+
+  opV.push_back(op); opVarV.push_back(nVar); opValV.push_back(val);
+
+  depth += 1 - nPop;
+  formExpr->maxDepth = max(formExpr->maxDepth,depth);
+
+  return;
+}
@@ -24,18 +24,39 @@
 #include "ANNZ.hpp"
 #include "myANNZ.hpp"
 #include "CatFormat.hpp"
+#include "ThreadPool.hpp"
 
 // ===========================================================================================================
 /**
  * @brief  - map to keep track of instances of the Wrapper class, which are
- *         managed by eg python external calls
+ *         managed by eg python external calls, and the corresponding locks
  */
 // ===========================================================================================================
-map <TString, Wrapper*> WrapperRegistry::wrapper;
+map <TString, WrapperPool*> WrapperRegistry::wrapper;
+std::mutex                  WrapperRegistry::registryMutex;
+std::mutex                  WrapperRegistry::initMutex;
+std::mutex                  WrapperRegistry::evalMutex;
+bool                        WrapperRegistry::isThreadSafe = false;
 
 // ===========================================================================================================
 /**
- * @brief  - external C resources, used to access class functionality from eg python
+ * @brief  - access an existing WrapperPool in the registry
+ */
+// ===========================================================================================================
+WrapperPool * WrapperRegistry::getPool(TString name) {
+// ===================================================
+  std::lock_guard<std::mutex> lock(registryMutex);
+
+  map <TString, WrapperPool*>::iterator itr = wrapper.find(name);
+  VERIFY(LOCATION,(TString)"trying to use Wrapper with name = "+name+" which does not exist ... Something is horribly wrong !!!",
+                           (itr != wrapper.end()));
+  return itr->second;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - external C resources, used to access class functionality from eg python. all functions
+ *         may be called concurrently from multiple threads
  */
 // ===========================================================================================================
 extern "C" {
@@ -43,28 +64,46 @@ extern "C" {
   // interface to check if a Wrapper with a given name already exists
   // -----------------------------------------------------------------------------------------------------------
   bool wrapperExists(char * name) {
+    std::lock_guard<std::mutex> lock(WrapperRegistry::registryMutex);
     return (WrapperRegistry::wrapper.find(name) != WrapperRegistry::wrapper.end());
   }
 
   // -----------------------------------------------------------------------------------------------------------
-  // interface to initialize an instance of a new Wrapper with a given set of user-options
+  // interface to initialize an instance of a new Wrapper with a given set of user-options. the setup
+  // of the instance is done before it is added to the registry, so that it is never used half-initialized
   // -----------------------------------------------------------------------------------------------------------
   bool wrapperNew(char * name, int argc, char ** argv) {
+    std::lock_guard<std::mutex> initLock(WrapperRegistry::initMutex);
     if(wrapperExists(name)) return false;
 
-    WrapperRegistry::wrapper[name] = new Wrapper(name);
-    WrapperRegistry::wrapper[name]->Init(argc, argv);
+    WrapperRegistry::isThreadSafe = ThreadPool::enableThreadSafety();
+
+    WrapperPool * aWrapperPool = new WrapperPool(name);
+    aWrapperPool->Init(argc, argv);
+
+    std::lock_guard<std::mutex> lock(WrapperRegistry::registryMutex);
+    WrapperRegistry::wrapper[name] = aWrapperPool;
     return true;    
   }
 
   // -----------------------------------------------------------------------------------------------------------
-  // interface to delete an instance of a Wrapper
+  // interface to delete an instance of a Wrapper (should not be called while evaluation calls
+  // for the same instance are still running)
   // -----------------------------------------------------------------------------------------------------------
   void wrapperDel(char * name) {
-    if(!wrapperExists(name)) return;
+    std::lock_guard<std::mutex> initLock(WrapperRegistry::initMutex);
 
-    DELNULL(WrapperRegistry::wrapper[name]);
-    WrapperRegistry::wrapper.erase(name);
+    WrapperPool * aWrapperPool(NULL);
+    {
+      std::lock_guard<std::mutex> lock(WrapperRegistry::registryMutex);
+      
+      map <TString, WrapperPool*>::iterator itr = WrapperRegistry::wrapper.find(name);
+      if(itr == WrapperRegistry::wrapper.end()) return;
+
+      aWrapperPool = itr->second;
+      WrapperRegistry::wrapper.erase(itr);
+    }
+    DELNULL(aWrapperPool);
 
     return;
   }
@@ -74,7 +113,42 @@ extern "C" {
   // be called once, or from a python loop over multiple events)
   // -----------------------------------------------------------------------------------------------------------
   char * wrapperEval(char * name, char * evalId, char * nObjsVars, char ** varNames, char ** varVals) {
-    return WrapperRegistry::wrapper[name]->Eval(evalId, nObjsVars, varNames, varVals);
+    std::unique_lock<std::mutex> evalLock(WrapperRegistry::evalMutex,std::defer_lock);
+    if(!WrapperRegistry::isThreadSafe) evalLock.lock();
+
+    WrapperPool * aWrapperPool = WrapperRegistry::getPool(name);
+    WrapperSlot * aSlot        = aWrapperPool->Acquire();
+    char        * output       = aSlot->Eval(evalId, nObjsVars, varNames, varVals);
+    aWrapperPool->Release(aSlot);
+
+    return output;
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // interface to perform evaluation for a batch of objects, where the input values are given as a
+  // contiguous array of (nObjs x nVars) numbers, and the results are written into a preallocated
+  // array of (nObjs x wrapperGetNumOut()) numbers, in the order given by wrapperGetOutNames()
+  // -----------------------------------------------------------------------------------------------------------
+  int wrapperEvalBatch(char * name, int nObjs, int nVars, char ** varNames, double * varVals, double * outVals) {
+    std::unique_lock<std::mutex> evalLock(WrapperRegistry::evalMutex,std::defer_lock);
+    if(!WrapperRegistry::isThreadSafe) evalLock.lock();
+
+    WrapperPool * aWrapperPool = WrapperRegistry::getPool(name);
+    WrapperSlot * aSlot        = aWrapperPool->Acquire();
+    int         nOuts          = aSlot->EvalBatch(nObjs, nVars, varNames, varVals, outVals);
+    aWrapperPool->Release(aSlot);
+
+    return nOuts;
+  }
+
+  // -----------------------------------------------------------------------------------------------------------
+  // interfaces to get the number and the names (separated by ';') of the outputs of wrapperEvalBatch()
+  // -----------------------------------------------------------------------------------------------------------
+  int wrapperGetNumOut(char * name) {
+    return WrapperRegistry::getPool(name)->model->GetNumOut();
+  }
+  char * wrapperGetOutNames(char * name) {
+    return WrapperRegistry::getPool(name)->model->GetOutNames();
   }
 
   // -----------------------------------------------------------------------------------------------------------
@@ -83,11 +157,108 @@ extern "C" {
   // output has been proccessed by eg an external python call
   // -----------------------------------------------------------------------------------------------------------
   void wrapperRelease(char * name, char * evalId) {
-    WrapperRegistry::wrapper[name]->Release(evalId);
+    WrapperRegistry::getPool(name)->Release(evalId);
     return;
   }
 }
 
+// ===========================================================================================================
+/**
+ * @brief  - a Wrapper with a set of evaluation slots, for concurrent evaluation calls
+ */
+// ===========================================================================================================
+WrapperPool::WrapperPool(std::string nameIn) {
+// ===========================================
+  aLOG(Log::DEBUG_1)<<coutWhiteOnBlack<<coutBlue<<" - starting WrapperPool::WrapperPool("<<nameIn<<") ... "<<coutDef<<endl;
+  
+  name  = nameIn;
+  model = NULL;
+  return;
+}
+WrapperPool::~WrapperPool() {
+// ==========================
+  aLOG(Log::DEBUG_1)<<coutWhiteOnBlack<<coutYellow<<" - starting WrapperPool::~WrapperPool("<<name<<") ... "<<coutDef<<endl;
+
+  // the slots use the readers of the model, and are deleted first
+  for(int nSlotNow=0; nSlotNow<(int)slotV.size(); nSlotNow++) DELNULL(slotV[nSlotNow]);
+  slotV.clear(); freeSlotV.clear();
+
+  DELNULL(model);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief    - initialization of the model and of the evaluation slots.
+ * 
+ * @details  - the model (the readers, native evaluators, kd-trees etc.) is loaded once. the number of
+ *           slots is then given by the nThreads user-option. each slot only holds its own input and output
+ *           buffers, and copies of the TMVA::Reader objects of MLMs which can not be evaluated natively
+ *           (TMVA::Reader instances are not reentrant). the native evaluators are shared by all slots.
+ */
+// ===========================================================================================================
+void WrapperPool::Init(int argc, char ** argv) {
+// =============================================
+  model = new Wrapper((std::string)name);
+  model->Init(argc, argv);
+
+  int nSlots = WrapperRegistry::isThreadSafe ? ThreadPool::getNumThreads(model->glob->GetOptI("nThreads")) : 1;
+  
+  for(int nSlotNow=0; nSlotNow<nSlots; nSlotNow++) {
+    slotV.push_back(new WrapperSlot(model,nSlotNow));
+    slotV[nSlotNow]->Init();
+  }
+  freeSlotV = slotV;
+
+  aLOG(Log::INFO)<<coutBlue<<" - initialized Wrapper("<<coutYellow<<name<<coutBlue<<") with "
+                 <<coutYellow<<nSlots<<coutBlue<<" evaluation slots ..."<<coutDef<<endl;
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - get a free evaluation slot, waiting until one is available if needed
+ */
+// ===========================================================================================================
+WrapperSlot * WrapperPool::Acquire() {
+// ===================================
+  std::unique_lock<std::mutex> lock(poolMutex);
+  poolCond.wait(lock,[this]{ return !freeSlotV.empty(); });
+
+  WrapperSlot * aSlot = freeSlotV.back();
+  freeSlotV.pop_back();
+
+  return aSlot;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - return an evaluation slot to the pool
+ */
+// ===========================================================================================================
+void WrapperPool::Release(WrapperSlot * aSlot) {
+// =============================================
+  {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    freeSlotV.push_back(aSlot);
+  }
+  poolCond.notify_one();
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - release the TString output of a given call to WrapperSlot::Eval(), from whichever slot produced it
+ */
+// ===========================================================================================================
+void WrapperPool::Release(char * evalId) {
+// =======================================
+  for(int nSlotNow=0; nSlotNow<(int)slotV.size(); nSlotNow++) slotV[nSlotNow]->Release(evalId);
+  return;
+}
+
 // ===========================================================================================================
 /**
  * @brief  - interface class for evaluation for external calls made with eg python
@@ -97,13 +268,17 @@ Wrapper::Wrapper(std::string nameIn) {
 // ===================================
   aLOG(Log::INFO)<<coutWhiteOnBlack<<coutBlue<<" - starting Wrapper::Wrapper("<<nameIn<<") ... "<<coutDef<<endl;
   
-  bool isNewWrapper = (WrapperRegistry::wrapper.find(nameIn) == WrapperRegistry::wrapper.end());
+  bool isNewWrapper(true);
+  {
+    std::lock_guard<std::mutex> lock(WrapperRegistry::registryMutex);
+    isNewWrapper = (WrapperRegistry::wrapper.find(nameIn) == WrapperRegistry::wrapper.end());
+  }
   VERIFY(LOCATION,(TString)"trying to instantiate multiple instances of Wrapper with name = "
                            +nameIn+" ... Something is horribly wrong !!!",isNewWrapper);
   name     = nameIn;
   aManager = NULL;
   aANNZ    = NULL;
-  loopTree = NULL;
+  outNames = "";
  
   return;
 }
@@ -116,14 +291,7 @@ Wrapper::~Wrapper() {
     else                              aANNZ->evalClsWrapperCleanup();
   }
 
-  // release all remainig dynamic memory allocated to TString outputs
-  for(map <TString,TString*>::iterator itr=registry.begin(); itr!=registry.end(); ++itr) {
-    DELNULL(itr->second);
-  }
-  registry.clear();
-
   DELNULL(aANNZ);
-  DELNULL(loopTree);
   DELNULL(aManager);
 
   return;
@@ -153,14 +321,97 @@ void Wrapper::Init(int argc, char ** argv) {
   aANNZ->aRegEval = new RegEval("aRegEval"+name,utils,glob,outputs);
 
   // -----------------------------------------------------------------------------------------------------------
-  // setup the resources needed for event-by-event evaluation, using Wrapper::Eval()
+  // setup the resources needed for event-by-event evaluation, which are shared by all evaluation slots
   // -----------------------------------------------------------------------------------------------------------
   VERIFY(LOCATION,(TString)"found \"doEval\" = false ... Something is horribly wrong !?!?",glob->GetOptB("doEval"));
   
   if(glob->GetOptB("doRegression")) aANNZ->evalRegWrapperSetup();
   else                              aANNZ->evalClsWrapperSetup();
 
-  // aANNZ->aRegEval->varWrapper->printVars();
+  VERIFY(LOCATION,(TString)" - \"inVars\" is not set ... Something is horribly wrong !?!?",(glob->GetOptC("inVars") != ""));
+
+  // the names of the outputs, as used by EvalBatch()
+  for(int nOutNow=0; nOutNow<(int)aANNZ->aRegEval->wrapperOutNameV.size(); nOutNow++) {
+    outNames += (TString)((nOutNow == 0) ? "" : ";")+aANNZ->aRegEval->wrapperOutNameV[nOutNow];
+  }
+
+  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - finished Wrapper::Init() ... ready to evaluate! "<<coutDef<<endl;
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - the number of outputs per object of WrapperSlot::EvalBatch()
+ */
+// ===========================================================================================================
+int Wrapper::GetNumOut() {
+// =======================
+  return (int)aANNZ->aRegEval->wrapperOutNameV.size();
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - the names of the outputs of WrapperSlot::EvalBatch(), separated by ';'
+ */
+// ===========================================================================================================
+char * Wrapper::GetOutNames() {
+// ============================
+  return (char*)(outNames.Data());
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - an evaluation slot of a given (initialized) Wrapper
+ */
+// ===========================================================================================================
+WrapperSlot::WrapperSlot(Wrapper * aWrapper, int nSlotIn) {
+// ========================================================
+  model    = aWrapper;
+  nSlot    = nSlotIn;
+  name     = (TString)model->name+((nSlot == 0) ? "" : TString::Format("_slot%d",nSlot));
+  utils    = NULL;
+  thr      = NULL;
+  loopTree = NULL;
+
+  return;
+}
+WrapperSlot::~WrapperSlot() {
+// ==========================
+  aLOG(Log::DEBUG_1)<<coutWhiteOnBlack<<coutYellow<<" - starting WrapperSlot::~WrapperSlot("<<name<<") ... "<<coutDef<<endl;
+
+  // release all remainig dynamic memory allocated to TString outputs
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(map <TString,TString*>::iterator itr=registry.begin(); itr!=registry.end(); ++itr) {
+      DELNULL(itr->second);
+    }
+    registry.clear();
+  }
+
+  DELNULL(thr);
+  DELNULL(loopTree);
+  DELNULL(utils);
+
+  return;
+}
+
+// ===========================================================================================================
+/**
+ * @brief  - initialization of the slot - setup of the containers of the evaluation thread, and of the
+ *         input tree which is connected to the vars of the thread
+ */
+// ===========================================================================================================
+void WrapperSlot::Init() {
+// =======================
+  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - starting WrapperSlot::Init("<<name<<") ... "<<coutDef<<endl;
+
+  OptMaps * glob    = model->glob;
+  ANNZ    * aANNZ   = model->aANNZ;
+
+  utils = new Utils(glob);
+  thr   = aANNZ->evalWrapperThreadSetup(nSlot,utils);
+
   TString treeName   = (TString)glob->GetOptC("treeName")+name;
   TString inTreeName = (TString)treeName+glob->GetOptC("evalTreeWrapperPostfix");
   loopTree = new TTree(inTreeName,inTreeName);  loopTree->SetDirectory(0);
@@ -169,13 +420,14 @@ void Wrapper::Init(int argc, char ** argv) {
   // parse the input variable list and create the corresponding tree structure
   // -----------------------------------------------------------------------------------------------------------
   TString inVars = glob->GetOptC("inVars");
-  VERIFY(LOCATION,(TString)" - \"inVars\" is not set ... Something is horribly wrong !?!?",(inVars != ""));
-  
-  aLOG(Log::INFO) <<coutBlue<<" - will derive evaluation variables from \"inVars\" = "
-                  <<coutPurple<<inVars<<coutDef<<endl;
+
+  if(nSlot == 0) {
+    aLOG(Log::INFO) <<coutBlue<<" - will derive evaluation variables from \"inVars\" = "
+                    <<coutPurple<<inVars<<coutDef<<endl;
+  }
 
   VarMaps   * var        = new VarMaps(glob,utils,"varCatFormat"+name);
-  CatFormat * aCatFormat = new CatFormat("aCatFormat"+name,utils,glob,outputs);
+  CatFormat * aCatFormat = new CatFormat("aCatFormat"+name,utils,glob,model->outputs);
 
   vector <TString> inVarNames, inVarTypes;
   aCatFormat->parseInputVars(var, inVars, inVarNames, inVarTypes);
@@ -185,19 +437,20 @@ void Wrapper::Init(int argc, char ** argv) {
 
   // -----------------------------------------------------------------------------------------------------------
   // fill one entry of the tree with default values, so as to allow to getTreeEntry(0) as part of
-  // connectTreeBranchesForm. connect the tree to aANNZ->aRegEval->varWrapper , with corresponding formulae
+  // connectTreeBranchesForm. connect the tree to the vars of the thread, with corresponding formulae
   // -----------------------------------------------------------------------------------------------------------
   loopTree->Fill();
 
-  aANNZ->aRegEval->varWrapper->connectTreeBranchesForm(loopTree,&(aANNZ->readerInptV));
+  thr->var_0->connectTreeBranchesForm(loopTree,(thr->hasReaders ? &(thr->readerInptV) : &(aANNZ->readerInptV)));
+
+  // initialize the formulae, which are evaluated directly from the variables by EvalBatch()
+  thr->var_0->getTreeEntry(0);
 
   // after filling an entry in the tree, the var and CatFormat can be cleanuped up
-  // (the loopTree is now connected to aANNZ->aRegEval->varWrapper ...)
+  // (the loopTree is now connected to thr->var_0 ...)
   DELNULL(var);       DELNULL(aCatFormat);
   inVarNames.clear(); inVarTypes.clear();
 
-  aLOG(Log::DEBUG_1) <<coutWhiteOnBlack<<coutPurple<<" - finished Wrapper::Init() ... ready to evaluate! "<<coutDef<<endl;
-
   return;
 }
 
@@ -206,9 +459,13 @@ void Wrapper::Init(int argc, char ** argv) {
  * @brief  - event-by-event evaluation, callable eg by python using the external wrapperEval function
  */
 // ===========================================================================================================
-char * Wrapper::Eval(char * evalId, char * nObjsVars, char ** varNames, char ** varVals) {
-// =======================================================================================
-  aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting Wrapper::Eval() ... "<<coutDef<<endl;
+char * WrapperSlot::Eval(char * evalId, char * nObjsVars, char ** varNames, char ** varVals) {
+// ===========================================================================================
+  aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting WrapperSlot::Eval() ... "<<coutDef<<endl;
+
+  VarMaps * var   = thr->var_0;
+  ANNZ    * aANNZ = model->aANNZ;
+  bool    isReg   = model->glob->GetOptB("doRegression");
 
   vector <TString> nObjsVarsV = utils->splitStringByChar((TString)nObjsVars,';');
 
@@ -221,32 +478,113 @@ char * Wrapper::Eval(char * evalId, char * nObjsVars, char ** varNames, char **
   for(int nObjNow=0; nObjNow<nObjs; nObjNow++) {
     // reset possible previous entries in the tree
     loopTree->Reset();
-    aANNZ->aRegEval->varWrapper->setDefaultVals();
+    var->setDefaultVals();
 
     // fill in the variables connected to the tree with the current values
     for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
       int nObjVarNow = nVarNow + nObjNow * nVars;
       // cout <<nObjVarNow<<CT<<nObjNow <<CT<<nVarNow<<CT<<(TString)varNames[nVarNow]<<CT<< (TString)varVals[nObjVarNow] <<endl;
-      aANNZ->aRegEval->varWrapper->SetVarAuto((TString)varNames[nVarNow], (TString)varVals[nObjVarNow]);
+      var->SetVarAuto((TString)varNames[nVarNow], (TString)varVals[nObjVarNow]);
     }
 
     loopTree->Fill();
 
     // force a calculation of the TTreeFormula (not really needed, but just in case...)
-    aANNZ->aRegEval->varWrapper->getTreeEntry(0);
+    var->getTreeEntry(0);
     
     // proceed to evaluate the object
-    if(glob->GetOptB("doRegression")) output += aANNZ->evalRegWrapperLoop();
-    else                              output += aANNZ->evalClsWrapperLoop();
+    if(isReg) output += aANNZ->evalRegWrapperLoop(thr);
+    else      output += aANNZ->evalClsWrapperLoop(thr);
 
     output += ",";
   }
   output = ((TString)"["+output+"]").ReplaceAll(" ","").ReplaceAll(",}","}").ReplaceAll(",]","]");
 
   TString evalIdStr(evalId);
-  registry[evalIdStr] = new TString(output);
+  TString * outputPtr = new TString(output);
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry[evalIdStr] = outputPtr;
+  }
+
+  return (char*)(outputPtr->Data());
+}
+
+// ===========================================================================================================
+/**
+ * @brief    - batch evaluation with numerical inputs and outputs, callable eg by python using
+ *           the external wrapperEvalBatch function
+ * 
+ * @details  - the handles of the input variables are resolved once for the entire batch, and the input
+ *           values are set directly through them. the loopTree is kept empty, so that the formulae of the
+ *           vars are evaluated from the current values of the variables, without filling and reading back
+ *           the tree for each object. each MLM is evaluated for all of the objects together (see
+ *           ANNZ::evalWrapperBatch()). the results are copied into outVals, with a fixed number of
+ *           outputs per object (see Wrapper::GetNumOut() and Wrapper::GetOutNames()); outputs which are
+ *           not defined for a given object are set to std::numeric_limits<float>::max().
+ * 
+ * @param nObjs     - number of objects.
+ * @param nVars     - number of input variables per object.
+ * @param varNames  - names of the input variables.
+ * @param varVals   - input values, with (nObjs x nVars) elements, ordered by object.
+ * @param outVals   - preallocated output array, with (nObjs x GetNumOut()) elements.
+ * 
+ * @return          - the number of outputs per object.
+ */
+// ===========================================================================================================
+int WrapperSlot::EvalBatch(int nObjs, int nVars, char ** varNames, double * varVals, double * outVals) {
+// ======================================================================================================
+  aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting WrapperSlot::EvalBatch() ... "<<coutDef<<endl;
+
+  VarMaps * var   = thr->var_0;
+  int     nOuts   = model->GetNumOut();
+
+  // resolve the handles of the variables once for the entire batch
+  // -----------------------------------------------------------------------------------------------------------
+  vector <VarMaps::VarHandle> hdlV(nVars);
+  for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
+    TString varName = (TString)varNames[nVarNow];
+    VERIFY(LOCATION,(TString)" - unknown input variable \""+varName+"\" in WrapperSlot::EvalBatch() ...",var->HasVar(varName));
 
-  return (char*)(registry[evalIdStr]->Data());
+    hdlV[nVarNow] = var->GetVarHandle(varName);
+
+    VarMaps::VarHandle::HandleType typeNow = hdlV[nVarNow].getType();
+    VERIFY(LOCATION,(TString)" - can not set variable \""+varName+"\" from numerical input in "
+                            +"WrapperSlot::EvalBatch() ... use WrapperSlot::Eval() instead",
+                            (typeNow != VarMaps::VarHandle::kC && typeNow != VarMaps::VarHandle::kFM));
+  }
+
+  loopTree->Reset();
+
+  // set the input variables of a given object
+  // -----------------------------------------------------------------------------------------------------------
+  auto setObjVars = [var,nVars,varVals,&hdlV](int nObjNow) {
+    double * varValsNow = varVals + nObjNow * nVars;
+
+    var->setDefaultVals();
+    for(int nVarNow=0; nVarNow<nVars; nVarNow++) {
+      const VarMaps::VarHandle & hdl = hdlV[nVarNow];
+
+      switch(hdl.getType()) {
+        case VarMaps::VarHandle::kF:  case VarMaps::VarHandle::kD:
+          var->SetVarF(hdl,varValsNow[nVarNow]);                                    break;
+        case VarMaps::VarHandle::kS:  case VarMaps::VarHandle::kI:  case VarMaps::VarHandle::kL:
+          var->SetVarI(hdl,static_cast<Long64_t> (varValsNow[nVarNow]));            break;
+        case VarMaps::VarHandle::kUS: case VarMaps::VarHandle::kUI: case VarMaps::VarHandle::kUL:
+          var->SetVarU(hdl,static_cast<ULong64_t>(varValsNow[nVarNow]));            break;
+        default:
+          var->SetVarB(hdl,static_cast<Bool_t>   (varValsNow[nVarNow] != 0));       break;
+      }
+    }
+    var->setReaderUpdate();
+    return;
+  };
+
+  model->aANNZ->evalWrapperBatch(thr,nObjs,setObjVars,outVals);
+
+  hdlV.clear();
+
+  return nOuts;
 }
 
 // ===========================================================================================================
@@ -254,11 +592,12 @@ char * Wrapper::Eval(char * evalId, char * nObjsVars, char ** varNames, char **
  * @brief  - release dynamic memory allocated to TString outputs
  */
 // ===========================================================================================================
-void Wrapper::Release(char * evalId) {
-// ===================================
-  aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting Wrapper::Release("+(TString)evalId+") ... "<<coutDef<<endl;
+void WrapperSlot::Release(char * evalId) {
+// =======================================
+  aLOG(Log::DEBUG_2) <<coutWhiteOnBlack<<coutPurple<<" - starting WrapperSlot::Release("+(TString)evalId+") ... "<<coutDef<<endl;
 
   TString evalIdStr(evalId);
+  std::lock_guard<std::mutex> lock(registryMutex);
   if(registry.find(evalIdStr) != registry.end()) {
     DELNULL(registry[evalIdStr]);
     registry.erase(evalIdStr);
@@ -266,4 +605,3 @@ void Wrapper::Release(char * evalId) {
 
   return;
 }
-
@@ -23,6 +23,11 @@
 #include "ANNZ.hpp"
 #include "CatFormat.hpp"
 
+#include <cerrno>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
 
 // ===========================================================================================================
 /**
@@ -112,6 +117,11 @@ Manager::Manager() {
   glob->NewOptC("inAsciiVars"  ,"");        // list of input variables and variable-types as they appear in inAsciiFiles
   glob->NewOptC("addOutputVars","");        // list of input variables which will be added to the ascii output
   glob->NewOptB("storeOrigFileName",false); // whether to store the name of the original file for each object
+  // fastInput -
+  //   read ascii input files using memory-mapping and in-place conversion of the columns, instead of line by
+  //   line. input files with the extensions ".npy" (NumPy arrays) or ".bin" (ANNZ columnar binary format, see
+  //   InputFileReader in include/CatFormat.hpp) are always read this way
+  glob->NewOptB("fastInput",false);
   // inpFiles_sig, inpFiles_bck -
   //   optional lists of input files defining if an object is of type signal or background
   glob->NewOptC("inpFiles_sig","");
@@ -259,6 +269,9 @@ Manager::Manager() {
   // generate binCls_nTries different randomized MLMs for each bin, and use only the one which has the highest separation parameter
   // -----------------------------------------------------------------------------------------------------------
   glob->NewOptI("binCls_nTries",-1);
+  // number of tries which are trained at the same time, each in a separate worker process (if set to zero, the number of
+  // available cores is used). The results do not depend on this number. See ANNZ::Train_binnedCls()
+  glob->NewOptI("binCls_nTryWorkers",1);
 
   // binCls_bckShiftMin,binCls_bckShiftMax (optional training setting) -
   //   setting binCls_bckShiftMin,binCls_bckShiftMax to some values with (binCls_bckShiftMax > binCls_bckShiftMin)
@@ -315,7 +328,15 @@ Manager::Manager() {
   // -----------------------------------------------------------------------------------------------------------
   glob->NewOptI("nMLMnow"    ,-1); // current index of MLM for training randomized regression/classification
   glob->NewOptI("nBinNow"    ,-1); // place-holder for the bin-index in binned classification (content copied to nMLMnow in ANNZ::Init())
+  // range of MLM (or bin) indices to train in one run, given as "first:last" (inclusive). Each MLM is trained in a separate
+  // worker process, forked after the options have been parsed, where up to nThreads workers run at the same time.
+  // All MLMs in the range share the same options, except for nMLMnow (or nBinNow). See Manager::trainWorkers()
+  glob->NewOptC("nMLMnowRange","");
   glob->NewOptC("userMLMopts",""); // user-defined options, used instead of general randomization of MLM-options
+  // use a columnar cache of the training/validation trees for single/randomized regression and classification. Each
+  // branch is stored once under [inputTreeDirName/trainCache/], and the data for each MLM are then taken from
+  // memory-mapped columns, instead of re-reading the input trees and writing cut trees. See TrainCache
+  glob->NewOptB("trainCache" ,false);
 
   // factory normalization (IT IS RECOMMENDED TO ALWAYS NORMALIZE!) -
   //   by default, if (alwaysUseNormalization==true), we use (NormMode=EqualNumEvents)
@@ -423,6 +444,12 @@ Manager::Manager() {
   glob->NewOptI("nOptimLoops"             ,1e4);   // maximal number of tries to improve the PDF weights
   glob->NewOptB("addOldStylePDFs"         ,false); // whether to use the old-style PDFs (defined since v2.2.3)
   glob->NewOptI("max_staticOptimTries_PDF",250);   // maximal number of steps for the optimization random walk
+
+  // nOptimWalkersPDF - number of independent walkers of the random walk alg for the PDF weights. The walkers
+  //                    run in parallel (using up to nThreads threads), and periodically share their best solution.
+  //                    If not positive, the number of threads is used. The result depends on nOptimWalkersPDF,
+  //                    but not on the number of threads, so this should be set explicitly for reproducible results
+  glob->NewOptI("nOptimWalkersPDF"        ,0);
   
   // bias-correction procedure on MLMs and/or PDFs
   //   doBiasCorPDF      - whether or not to perform the correction for PDFs (during optimization)
@@ -460,6 +487,36 @@ Manager::Manager() {
   glob->NewOptC("evalDirPostfix"  ,"");        // add this to the name of the evaluation directory
   glob->NewOptI("nObjectsToWrite" ,(int)5e5);  // maximal number of objects in a tree/output ascii file
   glob->NewOptI("nObjectsToPrint" ,(int)1e4);  // frequency for printing loop counter status
+  // number of threads for the evaluation loop, for the conversion of ascii/binary input files in genInputTrees and for the
+  // KNN weights (useWgtKNN, addInTrainFlag), and the number of concurrent worker processes for training with nMLMnowRange
+  // (if non-positive -> use all available cores)
+  glob->NewOptI("nThreads"        ,1);
+  // MLM types (e.g., "ANN;BDT") which are evaluated natively from the XML weight files instead of by TMVA. Each native
+  // estimator is compared with TMVA for nNativeMLMcheck random inputs when it is loaded, and TMVA is used instead
+  // if the outputs differ by more than a relative tolerance, nativeMLMtol
+  glob->NewOptC("nativeMLMs"      ,"");
+  glob->NewOptI("nNativeMLMcheck" ,100);
+  glob->NewOptF("nativeMLMtol"    ,1e-5);
+  // in the loops over the postTrain and evaluation trees, only read the branches of the variables, formulae and cuts
+  // which are actually used (selectTreeBranches), and use a read-cache of treeCacheMB (in MB) for these branches, which
+  // is shared between a tree and its friends (non-positive to disable). the number of bytes read is written to the log
+  glob->NewOptB("selectTreeBranches",false);
+  glob->NewOptI("treeCacheMB"       ,0);
+  // in the loops which write the evaluation, merged and KNN-weight trees, compress and write each batch of nObjectsToWrite
+  // objects on a background thread (asyncTreeWrite), while the next batch is filled in a second in-memory tree. at most
+  // one batch is waiting to be written at any time, and the names and content of the output files are not changed
+  glob->NewOptB("asyncTreeWrite"    ,false);
+  // format of the output trees: the compression of intermediate trees (treeCompress) and of the final output of the
+  // evaluation (treeCompressFinal), given as "ALGO:LEVEL" for ALGO in (ZLIB,LZMA,LZ4,ZSTD) - e.g., "LZ4:4" or "LZMA:8"
+  // (empty for the default of ROOT); the maximal size in KB of a basket, sized to hold nObjectsToWrite objects (treeBasketKB,
+  // non-positive to keep the default of ROOT); and the target size in MB of an output file (treeFileMB), up to which successive
+  // batches of nObjectsToWrite objects are written to the same file (non-positive for one file per batch). if benchTreeIO is
+  // set, the output files of each loop are read back, and the write and read rates (in MB/s) are written to the log
+  glob->NewOptC("treeCompress"      ,"");
+  glob->NewOptC("treeCompressFinal" ,"");
+  glob->NewOptI("treeBasketKB"      ,0);
+  glob->NewOptI("treeFileMB"        ,0);
+  glob->NewOptB("benchTreeIO"       ,false);
   glob->NewOptB("doPlots"         ,true);      // whether or not to generate performance and control plots
   glob->NewOptC("zTrgTitle"       ,"Z_{trg}"); // title of regression target   (for plots)
   glob->NewOptC("zRegTitle"       ,"Z_{reg}"); // title of regression variable (for plots)
@@ -507,6 +564,18 @@ Manager::Manager() {
   glob->NewOptB("doWidthRescale_errKNN",true);
   // fraction of the input sample to use for the kd-tree uncertainty calculation. takes values within [0,1]
   glob->NewOptF("sampleFrac_errKNN",1);
+  // directory for index files of the kd-trees of the KNN error estimation - if set, the kd-tree of each combination
+  // of input variables, cuts, weights and reference files is stored once, and is then reloaded by later jobs
+  // instead of being rebuilt from the reference chain (see setupKdTreeKNN()). An empty string disables the index
+  glob->NewOptC("knnErrIndexDir","");
+  // benchmark the search for near-neighbours in the kd-trees of the KNN error estimation: the rate of searches and the
+  // agreement of the flat kd-tree (KdTreeKNN) with the TMVA module are compared, and written to the log (see benchKdTreeKNN())
+  glob->NewOptB("benchKdTreeKNN",false);
+  // target recall of the search for near-neighbours for the KNN errors and weights (nErrKNN, minNobjInVol_wgtKNN,
+  // minNobjInVol_inTrain). For values smaller than 1, the search is approximate - the number of objects checked in each
+  // search is set such that the average fraction of the true near-neighbours which are found is at least approxRecallKNN,
+  // as measured on a held-out sample (see KdTreeKNN::TuneMaxChecks()). The measured recall is written to the log
+  glob->NewOptF("approxRecallKNN",1);
 
   // if propagating input-errors - nErrINP is the number of randomly generated MLM values used to propagate
   // the uncertainty on the input parameters to the MLM-estimator. See getRegClsErrINP()
@@ -526,6 +595,11 @@ Manager::Manager() {
   glob->NewOptF("closHisH"  ,-1);
   glob->NewOptI("closHisN"  ,50000); // # of bins in histograms used for quantile calculations (needs to be large number)
   glob->NewOptI("hisBufSize",50000); // # of objects to include in histograms of variable bins before setting final binning
+
+  // compression parameter of the quantile sketches (see QuantSketch in Utils.hpp), which are used for the bias, scatter and
+  // outlier-fraction metrics (in fillColosureV() and doMetricPlots()) and for the KNN errors. The error on the rank of a
+  // quantile q is bounded by 2*q*(1-q)/quantSketchCompression (e.g., 0.1% for the 16th percentile, with the default of 200)
+  glob->NewOptF("quantSketchCompression",200);
   
   // keep or delete temporary trees generated during trainin
   glob->NewOptB("keepTrainingTrees_factory"  ,false); // TMVA tree - generated during training (small and can be kept for cross-checks)
@@ -543,6 +617,9 @@ Manager::Manager() {
   glob->NewOptC("defVarSIL"           ,"I");  // short (S), int (I) or long (L)
   glob->NewOptC("defVarUSUIUL"        ,"UI"); // unsigned short (US), unsigned int (UI) or unsigned long (UL)
   glob->NewOptC("defVarFD"            ,"F");  // float (F) or double (D)
+  // evaluate cuts, weights and reader inputs with compiled expressions, which are bound directly to the variables of
+  // the input trees (see FormExpr in VarMaps.hpp). expressions which are not supported always use TTreeFormula
+  glob->NewOptB("useCompiledForms"    ,false);
   glob->NewOptI("clsResponseHisN"     ,100);  // number of initial bins for classification response histograms
   glob->NewOptI("clsResponseHisR"     ,4);    // rebin factor           for classification response histograms
   glob->NewOptB("getSeparationWithPDF",true); // calculate separation parameters with PDF-spline fits (==true) or with histogramed data (==false)
@@ -564,6 +641,21 @@ Manager::Manager() {
   // -----------------------------------------------------------------------------------------------------------
   glob->NewOptI("maxTreesMerge",50);
 
+  // merge tree-friends (without cuts or added formulae) by reading only the accepted branches of each input chain
+  // directly into the output tree, instead of loading every entry of all friends. the output files (of up to
+  // nObjectsToWrite objects each) are written in parallel by up to nThreads threads, where each thread uses a read-cache
+  // of treeCacheMB, which is shared between the input chains
+  // -----------------------------------------------------------------------------------------------------------
+  glob->NewOptB("fusedMergeFriends",false);
+
+  // create the postTrain trees of all MLMs together for the optimization (fused mode) - instead of looping over the
+  // _train and _valid trees separately for each MLM and then merging the results, all MLMs (and their error estimates)
+  // are evaluated for each object in a single loop (split between nThreads threads), and one combined tree is written.
+  // all MLM readers (and the kd-trees for the KNN errors) are kept in memory at once, so the memory usage is higher.
+  // not supported for binned classification
+  // -----------------------------------------------------------------------------------------------------------
+  glob->NewOptB("fusedPostTrain",false);
+
   return;
 }
 
@@ -759,6 +851,9 @@ void Manager::Init(int argc, char ** argv) {
   glob->SetOptC("evalDirName",       (TString)analysisPrefix+"/"           +glob->GetOptC("evalDirName"));
 
   if(glob->GetOptB("doTrain")) {
+    // for a range of MLMs, only returns in the worker processes, after nMLMnow (or nBinNow) has been set
+    if(glob->GetOptC("nMLMnowRange") != "") trainWorkers();
+
     int nMLMnow = glob->GetOptB("doBinnedCls") ? glob->GetOptI("nBinNow") : glob->GetOptI("nMLMnow");
     glob->SetOptC("trainDirName",(TString)glob->GetOptC("trainDirName")+glob->GetOptC("basePrefix")+TString::Format("%d",nMLMnow)+"/");
   }
@@ -930,6 +1025,105 @@ void Manager::Init(int argc, char ** argv) {
   return;
 }
 
+// ===========================================================================================================
+/**
+ * @brief    - Train a range of MLMs (given by nMLMnowRange) using concurrent worker processes.
+ * 
+ * @details  - Called from Init(), after all of the user options have been parsed, but before any of the directories
+ *           which depend on the index of the MLM are defined. A worker process is forked for each MLM, where up to
+ *           nThreads workers run at the same time. A new worker is started as soon as any previous one is done,
+ *           so that MLMs with different training times are balanced between the available cores.
+ *           - In each worker, nMLMnow (or nBinNow for binned classification) is set, and the function returns, so that
+ *           Init() and the training proceed exactly as for a single MLM. Each MLM therefore has its own factory and
+ *           training directory. The workers share the parsed options, and the memory pages of the parent process.
+ *           - The parent process does not return. After all workers are done, it exits with status 0 if all of the
+ *           MLMs were trained successfully, and with status 1 otherwise.
+ */
+// ===========================================================================================================
+void Manager::trainWorkers() {
+// ===========================================================================================================
+  TString nMLMnowRange = glob->GetOptC("nMLMnowRange");
+  TString indexName    = (TString)(glob->GetOptB("doBinnedCls") ? "nBinNow" : "nMLMnow");
+  int     nWorkers     = glob->GetOptI("nThreads");
+  int     nMLMbegin(-1), nMLMend(-1);
+
+  int nRead = sscanf(nMLMnowRange.Data(),"%d:%d",&nMLMbegin,&nMLMend);
+  if(nRead == 1) nMLMend = nMLMbegin;
+
+  VERIFY(LOCATION,(TString)"Could not parse [\"nMLMnowRange\" = "+nMLMnowRange+"] - must be of the form \"first:last\" ...",
+                           (nRead >= 1 && nMLMbegin >= 0 && nMLMend >= nMLMbegin));
+
+  if(nWorkers <= 0) nWorkers = static_cast<int>(std::thread::hardware_concurrency());
+  nWorkers = max(min(nWorkers,nMLMend-nMLMbegin+1),1);
+
+  aLOG(Log::INFO) <<coutWhiteOnBlack<<coutBlue<<" - will train "<<coutYellow<<indexName<<coutBlue<<" = ["<<coutYellow<<nMLMbegin
+                  <<coutBlue<<","<<coutYellow<<nMLMend<<coutBlue<<"] with "<<coutYellow<<nWorkers<<coutBlue<<" worker processes ..."<<coutDef<<endl;
+
+  map <pid_t,int> workerM;
+  vector <int>    failedV;
+  int             nMLMnext(nMLMbegin);
+
+  while(nMLMnext <= nMLMend || workerM.size() > 0) {
+    // start new workers, as long as there are free slots
+    // -----------------------------------------------------------------------------------------------------------
+    while(nMLMnext <= nMLMend && (int)workerM.size() < nWorkers) {
+      // flush the outputs, so that buffered messages are not duplicated in the worker
+      cout.flush(); fflush(stdout);
+
+      pid_t pid = fork();
+      VERIFY(LOCATION,(TString)"Could not fork a worker process for "+indexName+" = "+TString::Format("%d",nMLMnext)
+                              +" ("+strerror(errno)+") ...",(pid >= 0));
+
+      if(pid == 0) {
+        glob->SetOptI(indexName,nMLMnext);
+        glob->SetOptC("nMLMnowRange","");
+        return;
+      }
+
+      aLOG(Log::INFO) <<coutGreen<<" - started worker ("<<coutYellow<<pid<<coutGreen<<") for "<<coutYellow<<indexName
+                      <<coutGreen<<" = "<<coutYellow<<nMLMnext<<coutGreen<<" ..."<<coutDef<<endl;
+
+      workerM[pid] = nMLMnext; nMLMnext++;
+    }
+
+    // wait for any of the workers to finish
+    // -----------------------------------------------------------------------------------------------------------
+    int   status(0);
+    pid_t pid = waitpid(-1,&status,0);
+
+    if(pid < 0) {
+      if(errno == EINTR) continue;
+      VERIFY(LOCATION,(TString)"Failed while waiting for worker processes ("+strerror(errno)+") ...",false);
+    }
+
+    map <pid_t,int>::iterator itr = workerM.find(pid);
+    if(itr == workerM.end()) continue;
+
+    bool    isGood = (WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    TString colNow = (isGood ? coutGreen : coutRed);
+    if(!isGood) failedV.push_back(itr->second);
+
+    aLOG(Log::INFO) <<colNow<<" - worker ("<<coutYellow<<pid<<colNow<<") for "<<coutYellow<<indexName<<colNow<<" = "
+                    <<coutYellow<<itr->second<<colNow<<(isGood ? " is done ..." : " failed !!!")<<coutDef<<endl;
+
+    workerM.erase(itr);
+  }
+
+  if(failedV.size() > 0) {
+    TString failedStr("");
+    for(int nFailNow=0; nFailNow<(int)failedV.size(); nFailNow++) failedStr += TString::Format("%s%d",(nFailNow > 0 ? ", " : ""),failedV[nFailNow]);
+
+    aLOG(Log::ERROR) <<coutRed<<" - training failed for "<<coutYellow<<indexName<<coutRed<<" = ["<<coutYellow<<failedStr<<coutRed<<"] !!!"<<coutDef<<endl;
+  }
+  else {
+    aLOG(Log::INFO) <<coutWhiteOnBlack<<coutBlue<<" - finished training all of the MLMs in ["<<coutYellow<<nMLMbegin
+                    <<coutBlue<<","<<coutYellow<<nMLMend<<coutBlue<<"] ..."<<coutDef<<endl;
+  }
+
+  cout<<endl;
+  exit(failedV.size() > 0 ? 1 : 0);
+}
+
 // ===========================================================================================================
 /**
  * @brief    - Parse input dataset into ROOT trees for internal use by ANNZ.